@@ -236,7 +236,13 @@ const GimpStringActionEntry dialogs_dockable_actions[] =
     NC_("dialogs-action", "Error Co_nsole"), NULL,
     NC_("dialogs-action", "Open the error console"),
     "gimp-error-console",
-    GIMP_HELP_ERRORS_DIALOG }
+    GIMP_HELP_ERRORS_DIALOG },
+
+  { "dialogs-tile-dashboard", GTK_STOCK_HARDDISK,
+    NC_("dialogs-action", "T_ile Dashboard"), NULL,
+    NC_("dialogs-action", "Open the tile system dashboard"),
+    "gimp-tile-dashboard",
+    GIMP_HELP_TILE_DASHBOARD_DIALOG }
 };
 
 gint n_dialogs_dockable_actions = G_N_ELEMENTS (dialogs_dockable_actions);
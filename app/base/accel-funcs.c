@@ -0,0 +1,47 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "accel-funcs.h"
+
+
+void
+accel_funcs_init (gpointer          funcs,
+                  gconstpointer     generic,
+                  gsize             size,
+                  guint             accel,
+                  AccelInstallFunc  sse2_install,
+                  AccelInstallFunc  avx2_install)
+{
+  g_return_if_fail (funcs != NULL);
+  g_return_if_fail (generic != NULL);
+
+  memcpy (funcs, generic, size);
+
+  if (sse2_install && (accel & GIMP_CPU_ACCEL_X86_SSE2))
+    sse2_install (funcs);
+
+  if (avx2_install && (accel & GIMP_CPU_ACCEL_X86_AVX2))
+    avx2_install (funcs);
+}
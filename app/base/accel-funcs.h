@@ -0,0 +1,75 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ACCEL_FUNCS_H__
+#define __ACCEL_FUNCS_H__
+
+
+/*  Code with SSE2 or AVX2 variants, foo.c say, calls its kernels
+ *  through a table of function pointers:
+ *
+ *    FooFuncs                 the table
+ *    foo_funcs                the implementations in use
+ *    foo_generic_funcs        the portable implementations, complete
+ *    foo_sse2_install()       overwrite the members they accelerate,
+ *    foo_avx2_install()       in foo-sse2.c and foo-avx2.c
+ *    foo_init (accel)         installs the generic implementations,
+ *                             then those @accel, a mask of
+ *                             GimpCpuAccelFlags, allows
+ *
+ *  foo_init() calls accel_funcs_init().  base_init() calls every
+ *  foo_init() with what gimp_cpu_accel_get_support() reports, or 0
+ *  for --no-cpu-accel.  foo_init() can be called again, the tests do
+ *  so to compare the implementations, see gimp-accel-test-utils.h.
+ *
+ *  The accelerated files use intrinsics with function target
+ *  attributes, so they need no extra CFLAGS; they are compiled when
+ *  configure finds the intrinsics.  The generic implementations
+ *  define the results, the accelerated ones match them bit for bit
+ *  unless foo.h says otherwise.
+ */
+
+typedef void (* AccelInstallFunc) (gpointer funcs);
+
+
+#ifdef HAVE_SSE2_INTRINSICS
+#define ACCEL_SSE2(install)  ((AccelInstallFunc) (install))
+#else
+#define ACCEL_SSE2(install)  NULL
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+#define ACCEL_AVX2(install)  ((AccelInstallFunc) (install))
+#else
+#define ACCEL_AVX2(install)  NULL
+#endif
+
+
+/*  Copies @generic to @funcs, then calls @sse2_install and
+ *  @avx2_install on @funcs if @accel allows.  Wrap the install
+ *  functions in ACCEL_SSE2() and ACCEL_AVX2(), which drop them from
+ *  builds without the intrinsics.
+ */
+void   accel_funcs_init (gpointer          funcs,
+                         gconstpointer     generic,
+                         gsize             size,
+                         guint             accel,
+                         AccelInstallFunc  sse2_install,
+                         AccelInstallFunc  avx2_install);
+
+
+#endif  /*  __ACCEL_FUNCS_H__  */
@@ -72,6 +72,7 @@ typedef struct _TempBuf             TempBuf;
 typedef struct _Tile                Tile;
 typedef struct _TileManager         TileManager;
 typedef struct _TilePyramid         TilePyramid;
+typedef struct _TileStats           TileStats;
 
 
 /*  functions  */
@@ -24,6 +24,7 @@
 #include <glib-object.h>
 #include <glib/gstdio.h>
 
+#include "libgimpbase/gimpbase.h"
 #ifdef G_OS_WIN32
 #include "libgimpbase/gimpwin32-io.h"
 #endif
@@ -34,13 +35,21 @@
 
 #include "config/gimpbaseconfig.h"
 
+#include "paint-funcs/combine-pixels.h"
+#include "paint-funcs/gaussian-blur-region.h"
+#include "paint-funcs/mypaint-blend.h"
 #include "paint-funcs/paint-funcs.h"
+#include "paint-funcs/sample-weighted.h"
+#include "paint-funcs/scale-region.h"
 #include "composite/gimp-composite.h"
 
 #include "base.h"
+#include "box-filter.h"
 #include "pixel-processor.h"
 #include "tile-cache.h"
+#include "tile-compress.h"
 #include "tile-manager.h"
+#include "tile-stats.h"
 #include "tile-swap.h"
 
 
@@ -49,12 +58,17 @@ static void   base_toast_old_swap_files   (const gchar *swap_path);
 static void   base_tile_cache_size_notify (GObject     *config,
                                            GParamSpec  *param_spec,
                                            gpointer     data);
+static void   base_tile_compression_size_notify
+                                          (GObject     *config,
+                                           GParamSpec  *param_spec,
+                                           gpointer     data);
 static void   base_num_processors_notify  (GObject     *config,
                                            GParamSpec  *param_spec,
                                            gpointer     data);
 
 
-static GimpBaseConfig *base_config = NULL;
+static GimpBaseConfig *base_config  = NULL;
+static gboolean        base_verbose = FALSE;
 
 
 /*  public functions  */
@@ -70,13 +84,21 @@ base_init (GimpBaseConfig *config,
   g_return_val_if_fail (GIMP_IS_BASE_CONFIG (config), FALSE);
   g_return_val_if_fail (base_config == NULL, FALSE);
 
-  base_config = g_object_ref (config);
+  base_config  = g_object_ref (config);
+  base_verbose = be_verbose;
+
+  tile_stats_init ();
 
   tile_cache_init (config->tile_cache_size);
   g_signal_connect (config, "notify::tile-cache-size",
                     G_CALLBACK (base_tile_cache_size_notify),
                     NULL);
 
+  tile_compress_init (config->tile_compression_size);
+  g_signal_connect (config, "notify::tile-compression-size",
+                    G_CALLBACK (base_tile_compression_size_notify),
+                    NULL);
+
   if (! config->swap_path || ! *config->swap_path)
     gimp_config_reset_property (G_OBJECT (config), "swap-path");
 
@@ -86,6 +108,8 @@ base_init (GimpBaseConfig *config,
 
   swap_is_ok = tile_swap_test ();
 
+  tile_swap_set_async (config->swap_async);
+
   /*  create the temp directory if it doesn't exist  */
   if (! config->temp_path || ! *config->temp_path)
     gimp_config_reset_property (G_OBJECT (config), "temp-path");
@@ -106,6 +130,12 @@ base_init (GimpBaseConfig *config,
                     NULL);
 
   gimp_composite_init (be_verbose, use_cpu_accel);
+  box_filter_init (use_cpu_accel ? gimp_cpu_accel_get_support () : 0);
+  combine_pixels_init (use_cpu_accel ? gimp_cpu_accel_get_support () : 0);
+  gaussian_blur_init (use_cpu_accel ? gimp_cpu_accel_get_support () : 0);
+  mypaint_blend_init (use_cpu_accel ? gimp_cpu_accel_get_support () : 0);
+  sample_weighted_init (use_cpu_accel ? gimp_cpu_accel_get_support () : 0);
+  scale_region_init (use_cpu_accel ? gimp_cpu_accel_get_support () : 0);
 
   paint_funcs_setup ();
 
@@ -124,11 +154,30 @@ base_exit (void)
   pixel_processor_exit ();
   paint_funcs_free ();
   tile_cache_exit ();
+
+  if (base_verbose)
+    {
+      TileCompressStats stats;
+
+      tile_compress_get_stats (&stats);
+
+      g_print ("Compressed tile tier: %"G_GUINT64_FORMAT" hits, "
+               "%"G_GUINT64_FORMAT" misses, "
+               "%"G_GUINT64_FORMAT" tiles rejected, "
+               "%"G_GUINT64_FORMAT" tiles evicted to swap\n",
+               stats.hits, stats.misses, stats.rejected, stats.evicted);
+    }
+
+  tile_compress_exit ();
   tile_swap_exit ();
+  tile_stats_exit ();
 
   g_signal_handlers_disconnect_by_func (base_config,
                                         base_tile_cache_size_notify,
                                         NULL);
+  g_signal_handlers_disconnect_by_func (base_config,
+                                        base_tile_compression_size_notify,
+                                        NULL);
 
   g_object_unref (base_config);
   base_config = NULL;
@@ -199,6 +248,14 @@ base_tile_cache_size_notify (GObject    *config,
   tile_cache_set_size (GIMP_BASE_CONFIG (config)->tile_cache_size);
 }
 
+static void
+base_tile_compression_size_notify (GObject    *config,
+                                   GParamSpec *param_spec,
+                                   gpointer    data)
+{
+  tile_compress_set_size (GIMP_BASE_CONFIG (config)->tile_compression_size);
+}
+
 static void
 base_num_processors_notify (GObject    *config,
                             GParamSpec *param_spec,
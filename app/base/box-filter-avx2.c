@@ -0,0 +1,497 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base-types.h"
+
+#include "box-filter.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#include <immintrin.h>
+
+
+#define AVX2_FUNC  __attribute__ ((target ("avx2")))
+
+
+/*  These work like the SSE2 versions on both 128 bit lanes at once,
+ *  every lane produces 8 bytes of output in its low half, which are
+ *  moved together before storing.
+ */
+#define HALVE_PAIRS_1(s) \
+  _mm256_add_epi32 (_mm256_and_si256 ((s), _mm256_set1_epi32 (0xffff)), \
+                    _mm256_srli_epi32 ((s), 16))
+#define HALVE_PAIRS_2(s) \
+  _mm256_shuffle_epi32 (_mm256_add_epi16 ((s), _mm256_srli_epi64 ((s), 32)), \
+                        _MM_SHUFFLE (3, 1, 2, 0))
+#define HALVE_PAIRS_4(s) \
+  _mm256_add_epi16 ((s), _mm256_srli_si256 ((s), 8))
+
+#define STORE_HALVES(dest, r) \
+  _mm_storeu_si128 ((__m128i *) (dest), \
+                    _mm256_castsi256_si128 ( \
+                      _mm256_permute4x64_epi64 (_mm256_packus_epi16 ((r), (r)), \
+                                                _MM_SHUFFLE (3, 1, 2, 0))))
+
+
+static AVX2_FUNC void
+box_filter_halve_1_avx2 (const guchar *src0,
+                         const guchar *src1,
+                         guchar       *dest,
+                         gint          width)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i two  = _mm256_set1_epi16 (2);
+
+  for (; width >= 16; width -= 16)
+    {
+      const __m256i a = _mm256_loadu_si256 ((const __m256i *) src0);
+      const __m256i b = _mm256_loadu_si256 ((const __m256i *) src1);
+      __m256i       lo;
+      __m256i       hi;
+      __m256i       r;
+
+      lo = _mm256_add_epi16 (_mm256_unpacklo_epi8 (a, zero),
+                             _mm256_unpacklo_epi8 (b, zero));
+      hi = _mm256_add_epi16 (_mm256_unpackhi_epi8 (a, zero),
+                             _mm256_unpackhi_epi8 (b, zero));
+
+      r = _mm256_packs_epi32 (HALVE_PAIRS_1 (lo), HALVE_PAIRS_1 (hi));
+      r = _mm256_srli_epi16 (_mm256_add_epi16 (r, two), 2);
+
+      STORE_HALVES (dest, r);
+
+      src0 += 32;
+      src1 += 32;
+      dest += 16;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve[0] (src0, src1, dest, width);
+}
+
+static AVX2_FUNC void
+box_filter_halve_2_avx2 (const guchar *src0,
+                         const guchar *src1,
+                         guchar       *dest,
+                         gint          width)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i two  = _mm256_set1_epi16 (2);
+
+  for (; width >= 8; width -= 8)
+    {
+      const __m256i a = _mm256_loadu_si256 ((const __m256i *) src0);
+      const __m256i b = _mm256_loadu_si256 ((const __m256i *) src1);
+      __m256i       lo;
+      __m256i       hi;
+      __m256i       r;
+
+      lo = _mm256_add_epi16 (_mm256_unpacklo_epi8 (a, zero),
+                             _mm256_unpacklo_epi8 (b, zero));
+      hi = _mm256_add_epi16 (_mm256_unpackhi_epi8 (a, zero),
+                             _mm256_unpackhi_epi8 (b, zero));
+
+      r = _mm256_unpacklo_epi64 (HALVE_PAIRS_2 (lo), HALVE_PAIRS_2 (hi));
+      r = _mm256_srli_epi16 (_mm256_add_epi16 (r, two), 2);
+
+      STORE_HALVES (dest, r);
+
+      src0 += 32;
+      src1 += 32;
+      dest += 16;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve[1] (src0, src1, dest, width);
+}
+
+static AVX2_FUNC void
+box_filter_halve_4_avx2 (const guchar *src0,
+                         const guchar *src1,
+                         guchar       *dest,
+                         gint          width)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i two  = _mm256_set1_epi16 (2);
+
+  for (; width >= 4; width -= 4)
+    {
+      const __m256i a = _mm256_loadu_si256 ((const __m256i *) src0);
+      const __m256i b = _mm256_loadu_si256 ((const __m256i *) src1);
+      __m256i       lo;
+      __m256i       hi;
+      __m256i       r;
+
+      lo = _mm256_add_epi16 (_mm256_unpacklo_epi8 (a, zero),
+                             _mm256_unpacklo_epi8 (b, zero));
+      hi = _mm256_add_epi16 (_mm256_unpackhi_epi8 (a, zero),
+                             _mm256_unpackhi_epi8 (b, zero));
+
+      r = _mm256_unpacklo_epi64 (HALVE_PAIRS_4 (lo), HALVE_PAIRS_4 (hi));
+      r = _mm256_srli_epi16 (_mm256_add_epi16 (r, two), 2);
+
+      STORE_HALVES (dest, r);
+
+      src0 += 32;
+      src1 += 32;
+      dest += 16;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve[3] (src0, src1, dest, width);
+}
+
+/*  See box_filter_premult_select() in box-filter-sse2.c.  */
+static inline AVX2_FUNC __m256i
+box_filter_premult_select (__m256i plain,
+                           __m256i weighted,
+                           __m256i alpha_sums,
+                           __m256i alpha_lanes)
+{
+  const __m256i average = _mm256_srli_epi32 (_mm256_add_epi32 (plain,
+                                                               _mm256_set1_epi32 (2)),
+                                             2);
+  const __m256i mask    = _mm256_or_si256 (_mm256_cmpeq_epi32 (alpha_sums,
+                                                               _mm256_set1_epi32 (1020)),
+                                           alpha_lanes);
+
+  return _mm256_blendv_epi8 (_mm256_srli_epi32 (weighted, 10), average, mask);
+}
+
+static inline AVX2_FUNC __m256i
+box_filter_halve_premult_2_pairs (__m256i ab)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i one  = _mm256_set1_epi16 (1);
+  const __m256i t0   = _mm256_unpacklo_epi8 (ab, zero);
+  const __m256i t1   = _mm256_unpackhi_epi8 (ab, zero);
+  const __m256i w0   = _mm256_add_epi16 (_mm256_shuffle_epi32 (t0, _MM_SHUFFLE (3, 3, 1, 1)),
+                                         one);
+  const __m256i w1   = _mm256_add_epi16 (_mm256_shuffle_epi32 (t1, _MM_SHUFFLE (3, 3, 1, 1)),
+                                         one);
+  __m256i       p0, p1;
+  __m256i       plain;
+  __m256i       weighted;
+
+  p0 = _mm256_madd_epi16 (t0, one);
+  p1 = _mm256_madd_epi16 (t1, one);
+  plain = _mm256_add_epi32 (_mm256_unpacklo_epi64 (p0, p1),
+                            _mm256_unpackhi_epi64 (p0, p1));
+
+  p0 = _mm256_madd_epi16 (t0, w0);
+  p1 = _mm256_madd_epi16 (t1, w1);
+  weighted = _mm256_add_epi32 (_mm256_unpacklo_epi64 (p0, p1),
+                               _mm256_unpackhi_epi64 (p0, p1));
+
+  return box_filter_premult_select (plain, weighted,
+                                    _mm256_shuffle_epi32 (plain,
+                                                          _MM_SHUFFLE (3, 3, 1, 1)),
+                                    _mm256_set_epi32 (-1, 0, -1, 0,
+                                                      -1, 0, -1, 0));
+}
+
+static AVX2_FUNC void
+box_filter_halve_premult_2_avx2 (const guchar *src0,
+                                 const guchar *src1,
+                                 guchar       *dest,
+                                 gint          width)
+{
+  for (; width >= 8; width -= 8)
+    {
+      const __m256i a = _mm256_loadu_si256 ((const __m256i *) src0);
+      const __m256i b = _mm256_loadu_si256 ((const __m256i *) src1);
+      __m256i       r;
+
+      r = _mm256_packs_epi32 (box_filter_halve_premult_2_pairs (_mm256_unpacklo_epi8 (a, b)),
+                              box_filter_halve_premult_2_pairs (_mm256_unpackhi_epi8 (a, b)));
+
+      STORE_HALVES (dest, r);
+
+      src0 += 32;
+      src1 += 32;
+      dest += 16;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve_premult[1] (src0, src1, dest, width);
+}
+
+static inline AVX2_FUNC __m256i
+box_filter_halve_premult_4_pixels (__m256i ab)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i one  = _mm256_set1_epi16 (1);
+  const __m256i t0   = _mm256_unpacklo_epi8 (ab, zero);
+  const __m256i t1   = _mm256_unpackhi_epi8 (ab, zero);
+  const __m256i w0   = _mm256_add_epi16 (_mm256_shuffle_epi32 (t0, _MM_SHUFFLE (3, 3, 3, 3)),
+                                         one);
+  const __m256i w1   = _mm256_add_epi16 (_mm256_shuffle_epi32 (t1, _MM_SHUFFLE (3, 3, 3, 3)),
+                                         one);
+  __m256i       plain;
+  __m256i       weighted;
+
+  plain    = _mm256_add_epi32 (_mm256_madd_epi16 (t0, one),
+                               _mm256_madd_epi16 (t1, one));
+  weighted = _mm256_add_epi32 (_mm256_madd_epi16 (t0, w0),
+                               _mm256_madd_epi16 (t1, w1));
+
+  return box_filter_premult_select (plain, weighted,
+                                    _mm256_shuffle_epi32 (plain,
+                                                          _MM_SHUFFLE (3, 3, 3, 3)),
+                                    _mm256_set_epi32 (-1, 0, 0, 0,
+                                                      -1, 0, 0, 0));
+}
+
+static AVX2_FUNC void
+box_filter_halve_premult_4_avx2 (const guchar *src0,
+                                 const guchar *src1,
+                                 guchar       *dest,
+                                 gint          width)
+{
+  for (; width >= 4; width -= 4)
+    {
+      const __m256i a = _mm256_loadu_si256 ((const __m256i *) src0);
+      const __m256i b = _mm256_loadu_si256 ((const __m256i *) src1);
+      __m256i       r;
+
+      r = _mm256_packs_epi32 (box_filter_halve_premult_4_pixels (_mm256_unpacklo_epi8 (a, b)),
+                              box_filter_halve_premult_4_pixels (_mm256_unpackhi_epi8 (a, b)));
+
+      STORE_HALVES (dest, r);
+
+      src0 += 32;
+      src1 += 32;
+      dest += 16;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve_premult[3] (src0, src1, dest, width);
+}
+
+/*  The channels of a pixel in the 32 bit lanes.  */
+static inline AVX2_FUNC __m128i
+box_filter_load_pixel (const guchar *src,
+                       gint          bpp)
+{
+  guint32 pixel = 0;
+
+  /*  constant sizes, so the copies are inlined  */
+  switch (bpp)
+    {
+    case 1: memcpy (&pixel, src, 1); break;
+    case 2: memcpy (&pixel, src, 2); break;
+    case 3: memcpy (&pixel, src, 3); break;
+    case 4: memcpy (&pixel, src, 4); break;
+    }
+
+  return _mm_cvtepu8_epi32 (_mm_cvtsi32_si128 (pixel));
+}
+
+/*  Sums the weighted pixels of a column.  */
+static inline AVX2_FUNC __m128i
+box_filter_column (__m128i p0,
+                   __m128i p1,
+                   __m128i p2,
+                   guint   w0,
+                   guint   w1,
+                   guint   w2)
+{
+  return _mm_add_epi32 (_mm_add_epi32 (_mm_mullo_epi32 (p0, _mm_set1_epi32 (w0)),
+                                       _mm_mullo_epi32 (p1, _mm_set1_epi32 (w1))),
+                        _mm_mullo_epi32 (p2, _mm_set1_epi32 (w2)));
+}
+
+/*  Weights the column sums and divides by @divisor, adding @bias,
+ *  which is exact in double precision.
+ */
+static inline AVX2_FUNC __m128i
+box_filter_combine (__m128i  left,
+                    __m128i  center,
+                    __m128i  right,
+                    guint    left_weight,
+                    guint    center_weight,
+                    guint    right_weight,
+                    __m256d  bias,
+                    __m256d  divisor)
+{
+  __m256d sum;
+
+  sum = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (_mm256_cvtepi32_pd (left),
+                                                     _mm256_set1_pd (left_weight)),
+                                      _mm256_mul_pd (_mm256_cvtepi32_pd (center),
+                                                     _mm256_set1_pd (center_weight))),
+                       _mm256_mul_pd (_mm256_cvtepi32_pd (right),
+                                      _mm256_set1_pd (right_weight)));
+
+  return _mm256_cvttpd_epi32 (_mm256_div_pd (_mm256_add_pd (sum, bias),
+                                             divisor));
+}
+
+static inline AVX2_FUNC void
+box_filter_store_pixel (__m128i  r,
+                        guchar  *dest,
+                        gint     bpp)
+{
+  guint32 pixel;
+
+  r = _mm_packs_epi32 (r, r);
+  pixel = _mm_cvtsi128_si32 (_mm_packus_epi16 (r, r));
+
+  switch (bpp)
+    {
+    case 1: memcpy (dest, &pixel, 1); break;
+    case 2: memcpy (dest, &pixel, 2); break;
+    case 3: memcpy (dest, &pixel, 3); break;
+    case 4: memcpy (dest, &pixel, 4); break;
+    }
+}
+
+static AVX2_FUNC void
+box_filter_avx2 (const guint    left_weight,
+                 const guint    center_weight,
+                 const guint    right_weight,
+                 const guint    top_weight,
+                 const guint    middle_weight,
+                 const guint    bottom_weight,
+                 const guchar **src,
+                 guchar        *dest,
+                 const gint     bpp)
+{
+  __m128i columns[3];
+  gint    i;
+
+  for (i = 0; i < 3; i++)
+    columns[i] = box_filter_column (box_filter_load_pixel (src[i],     bpp),
+                                    box_filter_load_pixel (src[i + 3], bpp),
+                                    box_filter_load_pixel (src[i + 6], bpp),
+                                    top_weight, middle_weight, bottom_weight);
+
+  box_filter_store_pixel (box_filter_combine (columns[0],
+                                              columns[1],
+                                              columns[2],
+                                              left_weight,
+                                              center_weight,
+                                              right_weight,
+                                              _mm256_setzero_pd (),
+                                              _mm256_set1_pd ((left_weight +
+                                                               center_weight +
+                                                               right_weight) *
+                                                              (top_weight +
+                                                               middle_weight +
+                                                               bottom_weight))),
+                          dest, bpp);
+}
+
+static AVX2_FUNC void
+box_filter_premult_avx2 (const guint    left_weight,
+                         const guint    center_weight,
+                         const guint    right_weight,
+                         const guint    top_weight,
+                         const guint    middle_weight,
+                         const guint    bottom_weight,
+                         const guchar **src,
+                         guchar        *dest,
+                         const gint     bpp)
+{
+  const gint    alpha = bpp - 1;
+  const guint   sum   = ((left_weight + center_weight + right_weight) *
+                         (top_weight + middle_weight + bottom_weight)) >> 4;
+  __m128i       alpha_lane;
+  __m256d       bias;
+  __m256d       divisor;
+  __m128i       columns[3];
+  gint          i;
+
+  if (bpp != 2 && bpp != 4)
+    {
+      box_filter_generic_funcs.filter_premult (left_weight,
+                                               center_weight,
+                                               right_weight,
+                                               top_weight,
+                                               middle_weight,
+                                               bottom_weight,
+                                               src, dest, bpp);
+      return;
+    }
+
+  /*  the alpha channel is divided by sum, the others by 255 * sum  */
+  if (bpp == 2)
+    {
+      alpha_lane = _mm_set_epi32 (0, 0, -1, 0);
+      bias       = _mm256_set_pd (0, 0, sum >> 1, (255 * sum) >> 1);
+      divisor    = _mm256_set_pd (1, 1, sum, 255 * sum);
+    }
+  else
+    {
+      alpha_lane = _mm_set_epi32 (-1, 0, 0, 0);
+      bias       = _mm256_set_pd (sum >> 1, (255 * sum) >> 1,
+                                  (255 * sum) >> 1, (255 * sum) >> 1);
+      divisor    = _mm256_set_pd (sum, 255 * sum, 255 * sum, 255 * sum);
+    }
+
+  for (i = 0; i < 3; i++)
+    {
+      const guint f0 = (src[i][alpha]     * top_weight)    >> 4;
+      const guint f1 = (src[i + 3][alpha] * middle_weight) >> 4;
+      const guint f2 = (src[i + 6][alpha] * bottom_weight) >> 4;
+
+      /*  with the alpha channel replaced by 1, its column sum is the
+       *  sum of the factors
+       */
+      columns[i] =
+        box_filter_column (_mm_blendv_epi8 (box_filter_load_pixel (src[i], bpp),
+                                            _mm_set1_epi32 (1), alpha_lane),
+                           _mm_blendv_epi8 (box_filter_load_pixel (src[i + 3], bpp),
+                                            _mm_set1_epi32 (1), alpha_lane),
+                           _mm_blendv_epi8 (box_filter_load_pixel (src[i + 6], bpp),
+                                            _mm_set1_epi32 (1), alpha_lane),
+                           f0, f1, f2);
+    }
+
+  box_filter_store_pixel (box_filter_combine (columns[0],
+                                              columns[1],
+                                              columns[2],
+                                              left_weight,
+                                              center_weight,
+                                              right_weight,
+                                              bias, divisor),
+                          dest, bpp);
+}
+
+
+void
+box_filter_avx2_install (BoxFilterFuncs *funcs)
+{
+  funcs->halve[0]         = box_filter_halve_1_avx2;
+  funcs->halve[1]         = box_filter_halve_2_avx2;
+  funcs->halve[3]         = box_filter_halve_4_avx2;
+
+  funcs->halve_premult[0] = box_filter_halve_1_avx2;
+  funcs->halve_premult[1] = box_filter_halve_premult_2_avx2;
+  funcs->halve_premult[3] = box_filter_halve_premult_4_avx2;
+
+  funcs->filter           = box_filter_avx2;
+  funcs->filter_premult   = box_filter_premult_avx2;
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
@@ -0,0 +1,529 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base-types.h"
+
+#include "box-filter.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+
+#include <emmintrin.h>
+
+
+#define SSE2_FUNC  __attribute__ ((target ("sse2")))
+
+
+/*  Sums the pixel pairs of a row of 16 bit column sums, leaving the
+ *  four pair sums of @s in the low half of the result, except for
+ *  1 bpp, where they are left in the 32 bit lanes.
+ */
+#define HALVE_PAIRS_1(s) \
+  _mm_add_epi32 (_mm_and_si128 ((s), _mm_set1_epi32 (0xffff)), \
+                 _mm_srli_epi32 ((s), 16))
+#define HALVE_PAIRS_2(s) \
+  _mm_shuffle_epi32 (_mm_add_epi16 ((s), _mm_srli_epi64 ((s), 32)), \
+                     _MM_SHUFFLE (3, 1, 2, 0))
+#define HALVE_PAIRS_4(s) \
+  _mm_add_epi16 ((s), _mm_srli_si128 ((s), 8))
+
+
+static SSE2_FUNC void
+box_filter_halve_1_sse2 (const guchar *src0,
+                         const guchar *src1,
+                         guchar       *dest,
+                         gint          width)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i two  = _mm_set1_epi16 (2);
+
+  for (; width >= 8; width -= 8)
+    {
+      const __m128i a = _mm_loadu_si128 ((const __m128i *) src0);
+      const __m128i b = _mm_loadu_si128 ((const __m128i *) src1);
+      __m128i       lo;
+      __m128i       hi;
+      __m128i       r;
+
+      lo = _mm_add_epi16 (_mm_unpacklo_epi8 (a, zero),
+                          _mm_unpacklo_epi8 (b, zero));
+      hi = _mm_add_epi16 (_mm_unpackhi_epi8 (a, zero),
+                          _mm_unpackhi_epi8 (b, zero));
+
+      r = _mm_packs_epi32 (HALVE_PAIRS_1 (lo), HALVE_PAIRS_1 (hi));
+      r = _mm_srli_epi16 (_mm_add_epi16 (r, two), 2);
+
+      _mm_storel_epi64 ((__m128i *) dest, _mm_packus_epi16 (r, r));
+
+      src0 += 16;
+      src1 += 16;
+      dest += 8;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve[0] (src0, src1, dest, width);
+}
+
+static SSE2_FUNC void
+box_filter_halve_2_sse2 (const guchar *src0,
+                         const guchar *src1,
+                         guchar       *dest,
+                         gint          width)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i two  = _mm_set1_epi16 (2);
+
+  for (; width >= 4; width -= 4)
+    {
+      const __m128i a = _mm_loadu_si128 ((const __m128i *) src0);
+      const __m128i b = _mm_loadu_si128 ((const __m128i *) src1);
+      __m128i       lo;
+      __m128i       hi;
+      __m128i       r;
+
+      lo = _mm_add_epi16 (_mm_unpacklo_epi8 (a, zero),
+                          _mm_unpacklo_epi8 (b, zero));
+      hi = _mm_add_epi16 (_mm_unpackhi_epi8 (a, zero),
+                          _mm_unpackhi_epi8 (b, zero));
+
+      r = _mm_unpacklo_epi64 (HALVE_PAIRS_2 (lo), HALVE_PAIRS_2 (hi));
+      r = _mm_srli_epi16 (_mm_add_epi16 (r, two), 2);
+
+      _mm_storel_epi64 ((__m128i *) dest, _mm_packus_epi16 (r, r));
+
+      src0 += 16;
+      src1 += 16;
+      dest += 8;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve[1] (src0, src1, dest, width);
+}
+
+static SSE2_FUNC void
+box_filter_halve_4_sse2 (const guchar *src0,
+                         const guchar *src1,
+                         guchar       *dest,
+                         gint          width)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i two  = _mm_set1_epi16 (2);
+
+  for (; width >= 2; width -= 2)
+    {
+      const __m128i a = _mm_loadu_si128 ((const __m128i *) src0);
+      const __m128i b = _mm_loadu_si128 ((const __m128i *) src1);
+      __m128i       lo;
+      __m128i       hi;
+      __m128i       r;
+
+      lo = _mm_add_epi16 (_mm_unpacklo_epi8 (a, zero),
+                          _mm_unpacklo_epi8 (b, zero));
+      hi = _mm_add_epi16 (_mm_unpackhi_epi8 (a, zero),
+                          _mm_unpackhi_epi8 (b, zero));
+
+      r = _mm_unpacklo_epi64 (HALVE_PAIRS_4 (lo), HALVE_PAIRS_4 (hi));
+      r = _mm_srli_epi16 (_mm_add_epi16 (r, two), 2);
+
+      _mm_storel_epi64 ((__m128i *) dest, _mm_packus_epi16 (r, r));
+
+      src0 += 16;
+      src1 += 16;
+      dest += 8;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve[3] (src0, src1, dest, width);
+}
+
+/*  Returns the pre-multiplied sums of the channels, or their plain
+ *  average where all four source pixels are opaque, and the average
+ *  alpha.  @plain holds the sums of the channels, @weighted their sums
+ *  weighted by alpha + 1, @alpha_sums the alpha sum in every lane of a
+ *  pixel and @alpha_lanes selects the alpha channels.
+ */
+static inline SSE2_FUNC __m128i
+box_filter_premult_select (__m128i plain,
+                           __m128i weighted,
+                           __m128i alpha_sums,
+                           __m128i alpha_lanes)
+{
+  const __m128i average = _mm_srli_epi32 (_mm_add_epi32 (plain,
+                                                         _mm_set1_epi32 (2)),
+                                          2);
+  const __m128i mask    = _mm_or_si128 (_mm_cmpeq_epi32 (alpha_sums,
+                                                         _mm_set1_epi32 (1020)),
+                                        alpha_lanes);
+
+  return _mm_or_si128 (_mm_and_si128 (mask, average),
+                       _mm_andnot_si128 (mask, _mm_srli_epi32 (weighted, 10)));
+}
+
+/*  Two output pixels from the interleaved rows @ab, one pixel pair of
+ *  both rows in each half.
+ */
+static inline SSE2_FUNC __m128i
+box_filter_halve_premult_2_pair (__m128i ab)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i one  = _mm_set1_epi16 (1);
+  const __m128i t0   = _mm_unpacklo_epi8 (ab, zero);
+  const __m128i t1   = _mm_unpackhi_epi8 (ab, zero);
+  const __m128i w0   = _mm_add_epi16 (_mm_shuffle_epi32 (t0, _MM_SHUFFLE (3, 3, 1, 1)),
+                                      one);
+  const __m128i w1   = _mm_add_epi16 (_mm_shuffle_epi32 (t1, _MM_SHUFFLE (3, 3, 1, 1)),
+                                      one);
+  __m128i       p0, p1;
+  __m128i       plain;
+  __m128i       weighted;
+
+  p0 = _mm_madd_epi16 (t0, one);
+  p1 = _mm_madd_epi16 (t1, one);
+  plain = _mm_add_epi32 (_mm_unpacklo_epi64 (p0, p1),
+                         _mm_unpackhi_epi64 (p0, p1));
+
+  p0 = _mm_madd_epi16 (t0, w0);
+  p1 = _mm_madd_epi16 (t1, w1);
+  weighted = _mm_add_epi32 (_mm_unpacklo_epi64 (p0, p1),
+                            _mm_unpackhi_epi64 (p0, p1));
+
+  return box_filter_premult_select (plain, weighted,
+                                    _mm_shuffle_epi32 (plain,
+                                                       _MM_SHUFFLE (3, 3, 1, 1)),
+                                    _mm_set_epi32 (-1, 0, -1, 0));
+}
+
+static SSE2_FUNC void
+box_filter_halve_premult_2_sse2 (const guchar *src0,
+                                 const guchar *src1,
+                                 guchar       *dest,
+                                 gint          width)
+{
+  for (; width >= 4; width -= 4)
+    {
+      const __m128i a = _mm_loadu_si128 ((const __m128i *) src0);
+      const __m128i b = _mm_loadu_si128 ((const __m128i *) src1);
+      __m128i       r;
+
+      r = _mm_packs_epi32 (box_filter_halve_premult_2_pair (_mm_unpacklo_epi8 (a, b)),
+                           box_filter_halve_premult_2_pair (_mm_unpackhi_epi8 (a, b)));
+
+      _mm_storel_epi64 ((__m128i *) dest, _mm_packus_epi16 (r, r));
+
+      src0 += 16;
+      src1 += 16;
+      dest += 8;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve_premult[1] (src0, src1, dest, width);
+}
+
+/*  One output pixel from the interleaved rows @ab.  */
+static inline SSE2_FUNC __m128i
+box_filter_halve_premult_4_pixel (__m128i ab)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i one  = _mm_set1_epi16 (1);
+  const __m128i t0   = _mm_unpacklo_epi8 (ab, zero);
+  const __m128i t1   = _mm_unpackhi_epi8 (ab, zero);
+  const __m128i w0   = _mm_add_epi16 (_mm_shuffle_epi32 (t0, _MM_SHUFFLE (3, 3, 3, 3)),
+                                      one);
+  const __m128i w1   = _mm_add_epi16 (_mm_shuffle_epi32 (t1, _MM_SHUFFLE (3, 3, 3, 3)),
+                                      one);
+  __m128i       plain;
+  __m128i       weighted;
+
+  plain    = _mm_add_epi32 (_mm_madd_epi16 (t0, one),
+                            _mm_madd_epi16 (t1, one));
+  weighted = _mm_add_epi32 (_mm_madd_epi16 (t0, w0),
+                            _mm_madd_epi16 (t1, w1));
+
+  return box_filter_premult_select (plain, weighted,
+                                    _mm_shuffle_epi32 (plain,
+                                                       _MM_SHUFFLE (3, 3, 3, 3)),
+                                    _mm_set_epi32 (-1, 0, 0, 0));
+}
+
+static SSE2_FUNC void
+box_filter_halve_premult_4_sse2 (const guchar *src0,
+                                 const guchar *src1,
+                                 guchar       *dest,
+                                 gint          width)
+{
+  for (; width >= 2; width -= 2)
+    {
+      const __m128i a = _mm_loadu_si128 ((const __m128i *) src0);
+      const __m128i b = _mm_loadu_si128 ((const __m128i *) src1);
+      __m128i       r;
+
+      r = _mm_packs_epi32 (box_filter_halve_premult_4_pixel (_mm_unpacklo_epi8 (a, b)),
+                           box_filter_halve_premult_4_pixel (_mm_unpackhi_epi8 (a, b)));
+
+      _mm_storel_epi64 ((__m128i *) dest, _mm_packus_epi16 (r, r));
+
+      src0 += 16;
+      src1 += 16;
+      dest += 8;
+    }
+
+  if (width)
+    box_filter_generic_funcs.halve_premult[3] (src0, src1, dest, width);
+}
+
+/*  The channels of a pixel in the low four 16 bit lanes.  */
+static inline SSE2_FUNC __m128i
+box_filter_load_pixel (const guchar *src,
+                       gint          bpp)
+{
+  guint32 pixel = 0;
+
+  /*  constant sizes, so the copies are inlined  */
+  switch (bpp)
+    {
+    case 1: memcpy (&pixel, src, 1); break;
+    case 2: memcpy (&pixel, src, 2); break;
+    case 3: memcpy (&pixel, src, 3); break;
+    case 4: memcpy (&pixel, src, 4); break;
+    }
+
+  return _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (pixel), _mm_setzero_si128 ());
+}
+
+/*  Like box_filter_load_pixel(), with the alpha channel replaced by
+ *  1, so its column sum becomes the sum of the alpha factors.
+ */
+static inline SSE2_FUNC __m128i
+box_filter_load_premult (const guchar *src,
+                         gint          bpp,
+                         __m128i       alpha_lane)
+{
+  return _mm_or_si128 (_mm_andnot_si128 (alpha_lane,
+                                         box_filter_load_pixel (src, bpp)),
+                       _mm_and_si128 (alpha_lane, _mm_set1_epi16 (1)));
+}
+
+/*  Sums the three pixels of a column, weighted by @w01 (the top and
+ *  middle weight in every 32 bit lane) and @w2 (the bottom weight).
+ */
+static inline SSE2_FUNC __m128i
+box_filter_column (__m128i p0,
+                   __m128i p1,
+                   __m128i p2,
+                   __m128i w01,
+                   __m128i w2)
+{
+  return _mm_add_epi32 (_mm_madd_epi16 (_mm_unpacklo_epi16 (p0, p1), w01),
+                        _mm_madd_epi16 (_mm_unpacklo_epi16 (p2,
+                                                            _mm_setzero_si128 ()),
+                                        w2));
+}
+
+/*  Weights the column sums and divides by @divisor, adding @bias,
+ *  which is exact in double precision.
+ */
+static inline SSE2_FUNC __m128i
+box_filter_combine (__m128i  left,
+                    __m128i  center,
+                    __m128i  right,
+                    guint    left_weight,
+                    guint    center_weight,
+                    guint    right_weight,
+                    __m128d  bias_lo,
+                    __m128d  bias_hi,
+                    __m128d  divisor_lo,
+                    __m128d  divisor_hi)
+{
+  const __m128d lw = _mm_set1_pd (left_weight);
+  const __m128d cw = _mm_set1_pd (center_weight);
+  const __m128d rw = _mm_set1_pd (right_weight);
+  __m128d       lo;
+  __m128d       hi;
+
+  lo = _mm_add_pd (_mm_add_pd (_mm_mul_pd (_mm_cvtepi32_pd (left), lw),
+                               _mm_mul_pd (_mm_cvtepi32_pd (center), cw)),
+                   _mm_mul_pd (_mm_cvtepi32_pd (right), rw));
+
+  left   = _mm_srli_si128 (left,   8);
+  center = _mm_srli_si128 (center, 8);
+  right  = _mm_srli_si128 (right,  8);
+
+  hi = _mm_add_pd (_mm_add_pd (_mm_mul_pd (_mm_cvtepi32_pd (left), lw),
+                               _mm_mul_pd (_mm_cvtepi32_pd (center), cw)),
+                   _mm_mul_pd (_mm_cvtepi32_pd (right), rw));
+
+  lo = _mm_div_pd (_mm_add_pd (lo, bias_lo), divisor_lo);
+  hi = _mm_div_pd (_mm_add_pd (hi, bias_hi), divisor_hi);
+
+  return _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (lo), _mm_cvttpd_epi32 (hi));
+}
+
+static inline SSE2_FUNC void
+box_filter_store_pixel (__m128i  r,
+                        guchar  *dest,
+                        gint     bpp)
+{
+  guint32 pixel;
+
+  r = _mm_packs_epi32 (r, r);
+  pixel = _mm_cvtsi128_si32 (_mm_packus_epi16 (r, r));
+
+  switch (bpp)
+    {
+    case 1: memcpy (dest, &pixel, 1); break;
+    case 2: memcpy (dest, &pixel, 2); break;
+    case 3: memcpy (dest, &pixel, 3); break;
+    case 4: memcpy (dest, &pixel, 4); break;
+    }
+}
+
+static SSE2_FUNC void
+box_filter_sse2 (const guint    left_weight,
+                 const guint    center_weight,
+                 const guint    right_weight,
+                 const guint    top_weight,
+                 const guint    middle_weight,
+                 const guint    bottom_weight,
+                 const guchar **src,
+                 guchar        *dest,
+                 const gint     bpp)
+{
+  const __m128i w01     = _mm_set1_epi32 (top_weight | (middle_weight << 16));
+  const __m128i w2      = _mm_set1_epi32 (bottom_weight);
+  const __m128d divisor = _mm_set1_pd ((left_weight + center_weight +
+                                        right_weight) *
+                                       (top_weight + middle_weight +
+                                        bottom_weight));
+  const __m128d bias    = _mm_setzero_pd ();
+  __m128i       columns[3];
+  gint          i;
+
+  for (i = 0; i < 3; i++)
+    columns[i] = box_filter_column (box_filter_load_pixel (src[i],     bpp),
+                                    box_filter_load_pixel (src[i + 3], bpp),
+                                    box_filter_load_pixel (src[i + 6], bpp),
+                                    w01, w2);
+
+  box_filter_store_pixel (box_filter_combine (columns[0],
+                                              columns[1],
+                                              columns[2],
+                                              left_weight,
+                                              center_weight,
+                                              right_weight,
+                                              bias, bias,
+                                              divisor, divisor),
+                          dest, bpp);
+}
+
+static SSE2_FUNC void
+box_filter_premult_sse2 (const guint    left_weight,
+                         const guint    center_weight,
+                         const guint    right_weight,
+                         const guint    top_weight,
+                         const guint    middle_weight,
+                         const guint    bottom_weight,
+                         const guchar **src,
+                         guchar        *dest,
+                         const gint     bpp)
+{
+  const gint    alpha = bpp - 1;
+  const guint   sum   = ((left_weight + center_weight + right_weight) *
+                         (top_weight + middle_weight + bottom_weight)) >> 4;
+  __m128i       alpha_lane;
+  __m128d       bias_lo, bias_hi;
+  __m128d       divisor_lo, divisor_hi;
+  __m128i       columns[3];
+  gint          i;
+
+  if (bpp != 2 && bpp != 4)
+    {
+      box_filter_generic_funcs.filter_premult (left_weight,
+                                               center_weight,
+                                               right_weight,
+                                               top_weight,
+                                               middle_weight,
+                                               bottom_weight,
+                                               src, dest, bpp);
+      return;
+    }
+
+  /*  the alpha channel is divided by sum, the others by 255 * sum  */
+  if (bpp == 2)
+    {
+      alpha_lane = _mm_set_epi16 (0, 0, 0, 0, 0, 0, -1, 0);
+      bias_lo    = _mm_set_pd (sum >> 1, (255 * sum) >> 1);
+      divisor_lo = _mm_set_pd (sum, 255 * sum);
+      bias_hi    = bias_lo;
+      divisor_hi = divisor_lo;
+    }
+  else
+    {
+      alpha_lane = _mm_set_epi16 (0, 0, 0, 0, -1, 0, 0, 0);
+      bias_lo    = _mm_set1_pd ((255 * sum) >> 1);
+      divisor_lo = _mm_set1_pd (255 * sum);
+      bias_hi    = _mm_set_pd (sum >> 1, (255 * sum) >> 1);
+      divisor_hi = _mm_set_pd (sum, 255 * sum);
+    }
+
+  for (i = 0; i < 3; i++)
+    {
+      const guint f0 = (src[i][alpha]     * top_weight)    >> 4;
+      const guint f1 = (src[i + 3][alpha] * middle_weight) >> 4;
+      const guint f2 = (src[i + 6][alpha] * bottom_weight) >> 4;
+
+      columns[i] =
+        box_filter_column (box_filter_load_premult (src[i],     bpp, alpha_lane),
+                           box_filter_load_premult (src[i + 3], bpp, alpha_lane),
+                           box_filter_load_premult (src[i + 6], bpp, alpha_lane),
+                           _mm_set1_epi32 (f0 | (f1 << 16)),
+                           _mm_set1_epi32 (f2));
+    }
+
+  box_filter_store_pixel (box_filter_combine (columns[0],
+                                              columns[1],
+                                              columns[2],
+                                              left_weight,
+                                              center_weight,
+                                              right_weight,
+                                              bias_lo, bias_hi,
+                                              divisor_lo, divisor_hi),
+                          dest, bpp);
+}
+
+
+void
+box_filter_sse2_install (BoxFilterFuncs *funcs)
+{
+  /*  3 bpp rows don't split into vectors nicely, they stay generic  */
+  funcs->halve[0]         = box_filter_halve_1_sse2;
+  funcs->halve[1]         = box_filter_halve_2_sse2;
+  funcs->halve[3]         = box_filter_halve_4_sse2;
+
+  funcs->halve_premult[0] = box_filter_halve_1_sse2;
+  funcs->halve_premult[1] = box_filter_halve_premult_2_sse2;
+  funcs->halve_premult[3] = box_filter_halve_premult_4_sse2;
+
+  funcs->filter           = box_filter_sse2;
+  funcs->filter_premult   = box_filter_premult_sse2;
+}
+
+#endif /* HAVE_SSE2_INTRINSICS */
@@ -0,0 +1,384 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  The downsampling kernels of the tile pyramid and of the display
+ *  renderer.  The generic implementations define the results, the
+ *  accelerated ones in box-filter-sse2.c and box-filter-avx2.c have to
+ *  match them bit for bit; app/tests/test-box-filter.c checks that.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "base-types.h"
+
+#include "accel-funcs.h"
+#include "box-filter.h"
+
+
+static void  box_filter_halve_1              (const guchar  *src0,
+                                              const guchar  *src1,
+                                              guchar        *dest,
+                                              gint           width);
+static void  box_filter_halve_2              (const guchar  *src0,
+                                              const guchar  *src1,
+                                              guchar        *dest,
+                                              gint           width);
+static void  box_filter_halve_3              (const guchar  *src0,
+                                              const guchar  *src1,
+                                              guchar        *dest,
+                                              gint           width);
+static void  box_filter_halve_4              (const guchar  *src0,
+                                              const guchar  *src1,
+                                              guchar        *dest,
+                                              gint           width);
+static void  box_filter_halve_premult_2      (const guchar  *src0,
+                                              const guchar  *src1,
+                                              guchar        *dest,
+                                              gint           width);
+static void  box_filter_halve_premult_4      (const guchar  *src0,
+                                              const guchar  *src1,
+                                              guchar        *dest,
+                                              gint           width);
+
+static void  box_filter_generic              (guint          left_weight,
+                                              guint          center_weight,
+                                              guint          right_weight,
+                                              guint          top_weight,
+                                              guint          middle_weight,
+                                              guint          bottom_weight,
+                                              const guchar **src,
+                                              guchar        *dest,
+                                              gint           bpp);
+static void  box_filter_premult_generic      (guint          left_weight,
+                                              guint          center_weight,
+                                              guint          right_weight,
+                                              guint          top_weight,
+                                              guint          middle_weight,
+                                              guint          bottom_weight,
+                                              const guchar **src,
+                                              guchar        *dest,
+                                              gint           bpp);
+
+
+const BoxFilterFuncs box_filter_generic_funcs =
+{
+  {
+    box_filter_halve_1,
+    box_filter_halve_2,
+    box_filter_halve_3,
+    box_filter_halve_4
+  },
+  {
+    /*  without alpha, there is nothing to pre-multiply  */
+    box_filter_halve_1,
+    box_filter_halve_premult_2,
+    box_filter_halve_3,
+    box_filter_halve_premult_4
+  },
+  box_filter_generic,
+  box_filter_premult_generic
+};
+
+BoxFilterFuncs box_filter_funcs =
+{
+  {
+    box_filter_halve_1,
+    box_filter_halve_2,
+    box_filter_halve_3,
+    box_filter_halve_4
+  },
+  {
+    box_filter_halve_1,
+    box_filter_halve_premult_2,
+    box_filter_halve_3,
+    box_filter_halve_premult_4
+  },
+  box_filter_generic,
+  box_filter_premult_generic
+};
+
+
+void
+box_filter_init (guint accel)
+{
+  accel_funcs_init (&box_filter_funcs, &box_filter_generic_funcs,
+                    sizeof (BoxFilterFuncs), accel,
+                    ACCEL_SSE2 (box_filter_sse2_install),
+                    ACCEL_AVX2 (box_filter_avx2_install));
+}
+
+
+/*  private functions  */
+
+static void
+box_filter_halve_1 (const guchar *src0,
+                    const guchar *src1,
+                    guchar       *dest,
+                    gint          width)
+{
+  while (width--)
+    {
+      dest[0] = (src0[0] + src0[1] + src1[0] + src1[1] + 2) >> 2;
+
+      dest += 1;
+      src0 += 2;
+      src1 += 2;
+    }
+}
+
+static void
+box_filter_halve_2 (const guchar *src0,
+                    const guchar *src1,
+                    guchar       *dest,
+                    gint          width)
+{
+  while (width--)
+    {
+      dest[0] = (src0[0] + src0[2] + src1[0] + src1[2] + 2) >> 2;
+      dest[1] = (src0[1] + src0[3] + src1[1] + src1[3] + 2) >> 2;
+
+      dest += 2;
+      src0 += 4;
+      src1 += 4;
+    }
+}
+
+static void
+box_filter_halve_3 (const guchar *src0,
+                    const guchar *src1,
+                    guchar       *dest,
+                    gint          width)
+{
+  while (width--)
+    {
+      dest[0] = (src0[0] + src0[3] + src1[0] + src1[3] + 2) >> 2;
+      dest[1] = (src0[1] + src0[4] + src1[1] + src1[4] + 2) >> 2;
+      dest[2] = (src0[2] + src0[5] + src1[2] + src1[5] + 2) >> 2;
+
+      dest += 3;
+      src0 += 6;
+      src1 += 6;
+    }
+}
+
+static void
+box_filter_halve_4 (const guchar *src0,
+                    const guchar *src1,
+                    guchar       *dest,
+                    gint          width)
+{
+  while (width--)
+    {
+      dest[0] = (src0[0] + src0[4] + src1[0] + src1[4] + 2) >> 2;
+      dest[1] = (src0[1] + src0[5] + src1[1] + src1[5] + 2) >> 2;
+      dest[2] = (src0[2] + src0[6] + src1[2] + src1[6] + 2) >> 2;
+      dest[3] = (src0[3] + src0[7] + src1[3] + src1[7] + 2) >> 2;
+
+      dest += 4;
+      src0 += 8;
+      src1 += 8;
+    }
+}
+
+static void
+box_filter_halve_premult_2 (const guchar *src0,
+                            const guchar *src1,
+                            guchar       *dest,
+                            gint          width)
+{
+  while (width--)
+    {
+      const guint a = src0[1] + src0[3] + src1[1] + src1[3];
+
+      switch (a)
+        {
+        case 0:    /* all transparent */
+          dest[0] = dest[1] = 0;
+          break;
+
+        case 1020: /* all opaque */
+          dest[0] = (src0[0] + src0[2] + src1[0] + src1[2] + 2) >> 2;
+          dest[1] = 255;
+          break;
+
+        default:
+          dest[0] = ((src0[0] * (src0[1] + 1) +
+                      src0[2] * (src0[3] + 1) +
+                      src1[0] * (src1[1] + 1) +
+                      src1[2] * (src1[3] + 1)) >> 10);
+          dest[1] = (a + 2) >> 2;
+          break;
+        }
+
+      dest += 2;
+      src0 += 4;
+      src1 += 4;
+    }
+}
+
+static void
+box_filter_halve_premult_4 (const guchar *src0,
+                            const guchar *src1,
+                            guchar       *dest,
+                            gint          width)
+{
+  while (width--)
+    {
+      const guint a = src0[3] + src0[7] + src1[3] + src1[7];
+
+      switch (a)
+        {
+        case 0:    /* all transparent */
+          dest[0] = dest[1] = dest[2] = dest[3] = 0;
+          break;
+
+        case 1020: /* all opaque */
+          dest[0] = (src0[0] + src0[4] + src1[0] + src1[4] + 2) >> 2;
+          dest[1] = (src0[1] + src0[5] + src1[1] + src1[5] + 2) >> 2;
+          dest[2] = (src0[2] + src0[6] + src1[2] + src1[6] + 2) >> 2;
+          dest[3] = 255;
+          break;
+
+        default:
+          {
+            const guint a0 = src0[3] + 1;
+            const guint a1 = src0[7] + 1;
+            const guint a2 = src1[3] + 1;
+            const guint a3 = src1[7] + 1;
+
+            dest[0] = (src0[0] * a0 +
+                       src0[4] * a1 +
+                       src1[0] * a2 +
+                       src1[4] * a3) >> 10;
+            dest[1] = (src0[1] * a0 +
+                       src0[5] * a1 +
+                       src1[1] * a2 +
+                       src1[5] * a3) >> 10;
+            dest[2] = (src0[2] * a0 +
+                       src0[6] * a1 +
+                       src1[2] * a2 +
+                       src1[6] * a3) >> 10;
+            dest[3] = (a + 2) >> 2;
+          }
+          break;
+        }
+
+      dest += 4;
+      src0 += 8;
+      src1 += 8;
+    }
+}
+
+/* This version assumes that the src data is already pre-multiplied. */
+static void
+box_filter_generic (const guint    left_weight,
+                    const guint    center_weight,
+                    const guint    right_weight,
+                    const guint    top_weight,
+                    const guint    middle_weight,
+                    const guint    bottom_weight,
+                    const guchar **src,
+                    guchar        *dest,
+                    const gint     bpp)
+{
+  const guint sum = ((left_weight + center_weight + right_weight) *
+                     (top_weight + middle_weight + bottom_weight));
+  gint i;
+
+  for (i = 0; i < bpp; i++)
+    {
+      dest[i] = ( left_weight   * ((src[0][i] * top_weight) +
+                                   (src[3][i] * middle_weight) +
+                                   (src[6][i] * bottom_weight))
+                + center_weight * ((src[1][i] * top_weight) +
+                                   (src[4][i] * middle_weight) +
+                                   (src[7][i] * bottom_weight))
+                + right_weight  * ((src[2][i] * top_weight) +
+                                   (src[5][i] * middle_weight) +
+                                   (src[8][i] * bottom_weight))) / sum;
+    }
+}
+
+/* This version assumes that the src data is not pre-multipled.
+ * It creates pre-multiplied output though.  The alpha channel is
+ * the last one.
+ */
+static void
+box_filter_premult_generic (const guint    left_weight,
+                            const guint    center_weight,
+                            const guint    right_weight,
+                            const guint    top_weight,
+                            const guint    middle_weight,
+                            const guint    bottom_weight,
+                            const guchar **src,
+                            guchar        *dest,
+                            const gint     bpp)
+{
+  const gint  alpha = bpp - 1;
+  const guint sum   = ((left_weight + center_weight + right_weight) *
+                       (top_weight + middle_weight + bottom_weight)) >> 4;
+
+  if (bpp != 2 && bpp != 4)
+    {
+      g_warning ("bpp=%i not implemented as box filter", bpp);
+      return;
+    }
+
+  {
+    const guint factors[9] =
+      {
+        (src[1][alpha] * top_weight)    >> 4,
+        (src[4][alpha] * middle_weight) >> 4,
+        (src[7][alpha] * bottom_weight) >> 4,
+        (src[2][alpha] * top_weight)    >> 4,
+        (src[5][alpha] * middle_weight) >> 4,
+        (src[8][alpha] * bottom_weight) >> 4,
+        (src[0][alpha] * top_weight)    >> 4,
+        (src[3][alpha] * middle_weight) >> 4,
+        (src[6][alpha] * bottom_weight) >> 4
+      };
+
+    const guint a =
+      (center_weight * (factors[0] + factors[1] + factors[2]) +
+       right_weight  * (factors[3] + factors[4] + factors[5]) +
+       left_weight   * (factors[6] + factors[7] + factors[8]));
+
+    gint i;
+
+    for (i = 0; i < alpha; i++)
+      {
+        dest[i] = (center_weight * (factors[0] * src[1][i] +
+                                    factors[1] * src[4][i] +
+                                    factors[2] * src[7][i]) +
+
+                   right_weight  * (factors[3] * src[2][i] +
+                                    factors[4] * src[5][i] +
+                                    factors[5] * src[8][i]) +
+
+                   left_weight   * (factors[6] * src[0][i] +
+                                    factors[7] * src[3][i] +
+                                    factors[8] * src[6][i]) +
+                   ((255 * sum) >> 1)) / (255 * sum);
+      }
+
+    dest[alpha] = (a + (sum >> 1)) / sum;
+  }
+}
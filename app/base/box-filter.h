@@ -0,0 +1,82 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BOX_FILTER_H__
+#define __BOX_FILTER_H__
+
+
+/*  Averages the 2x2 blocks of two source rows into @width pixels.  */
+typedef void (* BoxFilterHalveFunc)  (const guchar  *src0,
+                                      const guchar  *src1,
+                                      guchar        *dest,
+                                      gint           width);
+
+/*  Filters one pixel from its 3x3 neighbourhood, numbered
+ *
+ *    012
+ *    345
+ *    678
+ *
+ *  with the weights of the columns and rows.
+ */
+typedef void (* BoxFilterFunc)       (guint          left_weight,
+                                      guint          center_weight,
+                                      guint          right_weight,
+                                      guint          top_weight,
+                                      guint          middle_weight,
+                                      guint          bottom_weight,
+                                      const guchar **src,
+                                      guchar        *dest,
+                                      gint           bpp);
+
+
+typedef struct _BoxFilterFuncs BoxFilterFuncs;
+
+struct _BoxFilterFuncs
+{
+  /*  by bpp - 1, all channels are averaged alike, so these are used
+   *  for data without alpha and for pre-multiplied data
+   */
+  BoxFilterHalveFunc  halve[4];
+
+  /*  for 2 and 4 bpp, non-premultiplied source, pre-multiplied result  */
+  BoxFilterHalveFunc  halve_premult[4];
+
+  /*  pre-multiplied source, any bpp  */
+  BoxFilterFunc       filter;
+
+  /*  non-premultiplied source, pre-multiplied result, 2 and 4 bpp  */
+  BoxFilterFunc       filter_premult;
+};
+
+
+/*  the implementations in use, see base/accel-funcs.h  */
+extern BoxFilterFuncs box_filter_funcs;
+
+
+void   box_filter_init (guint accel);
+
+
+/*  for the box filter implementations only  */
+
+extern const BoxFilterFuncs box_filter_generic_funcs;
+
+void   box_filter_sse2_install (BoxFilterFuncs *funcs);
+void   box_filter_avx2_install (BoxFilterFuncs *funcs);
+
+
+#endif  /*  __BOX_FILTER_H__  */
@@ -19,9 +19,7 @@
 
 #include "config.h"
 
-#ifdef ENABLE_MP
-#include <string.h>
-#endif
+#undef G_DISABLE_DEPRECATED /* GStaticMutex */
 
 #include <glib-object.h>
 
@@ -36,12 +34,19 @@
 
 
 #define TILES_PER_THREAD  8
+#define CHUNKS_PER_THREAD 4
 #define PROGRESS_TIMEOUT  64
 
 
-static GThreadPool *pool       = NULL;
-static GMutex      *pool_mutex = NULL;
-static GCond       *pool_cond  = NULL;
+#ifdef ENABLE_MP
+static GThreadPool  *pool       = NULL;
+
+/*  Tile locking isn't thread-safe, and parallel calls running at the
+ *  same time (nested ones, for example) may well share tile managers,
+ *  so one mutex serializes it for all of them.
+ */
+static GStaticMutex  tile_mutex = G_STATIC_MUTEX_INIT;
+#endif
 
 
 typedef void  (* p1_func) (gpointer      data,
@@ -66,299 +71,514 @@ typedef void  (* p5_func) (gpointer      data,
                            PixelRegion  *region5);
 
 
-typedef struct _PixelProcessor PixelProcessor;
+/*  The multi-threaded processor splits the area into chunks of whole
+ *  tile rows (or, for areas which are only a few tiles high, blocks of
+ *  tiles within a row), numbered top to bottom.  Each thread starts
+ *  out with a contiguous range of chunks and works through it in
+ *  order; when its range is exhausted it steals the upper half of the
+ *  largest range left.  The calling thread takes part in the work, so
+ *  a parallel call made from within a parallel call can't deadlock on
+ *  a thread pool which is busy with the outer call: whatever the pool
+ *  doesn't get to is done by the caller, and pool tasks which start
+ *  after all chunks are taken simply return.
+ *
+ *  pixel_processor_process_items() uses the same scheduling with one
+ *  chunk per item and no regions at all.
+ */
+
+typedef struct _PixelProcessor      PixelProcessor;
+typedef struct _PixelProcessorRange PixelProcessorRange;
+
+struct _PixelProcessorRange
+{
+  gint  begin;
+  gint  end;
+};
 
 struct _PixelProcessor
 {
-  PixelProcessorFunc   func;
-  gpointer             data;
+  PixelProcessorFunc      func;
+  PixelProcessorItemFunc  item_func;
+  gpointer                data;
+
+  gint                    num_regions;
+  PixelRegion            *regions[5];
+
+  /*  the region which defines the chunk grid  */
+  gint                    x;
+  gint                    y;
+  gint                    width;
+  gint                    height;
 
 #ifdef ENABLE_MP
-  GMutex              *mutex;
-  gint                 threads;
-  gboolean             first;
+  gint                    grid_x;      /*  origin of the tile grid            */
+  gint                    grid_y;
+  gint                    cols_per_chunk;
+  gint                    chunks_per_row;
+  gint                    n_chunks;
+  gint                    n_slots;
+
+  gint                    ref_count;
+  gint                    next_slot;
+
+  GMutex                 *mutex;       /*  protects the slots, the remaining  *
+                                        *  chunk count and the progress       */
+  GCond                  *cond;
+  PixelProcessorRange     slots[GIMP_MAX_NUM_THREADS];
+  gint                    remaining;
 #endif
 
-  PixelRegionIterator *PRI;
-  gint                 num_regions;
-  PixelRegion         *regions[5];
-
-  gulong               progress;
+  gulong                  progress;
 };
 
 
-#ifdef ENABLE_MP
 static void
-do_parallel_regions (PixelProcessor *processor)
+pixel_processor_call (PixelProcessor  *processor,
+                      PixelRegion    **regions)
 {
-  PixelRegion tr[5];
-  gint        i;
+  switch (processor->num_regions)
+    {
+    case 1:
+      ((p1_func) processor->func) (processor->data,
+                                   regions[0]);
+      break;
 
-  g_mutex_lock (processor->mutex);
+    case 2:
+      ((p2_func) processor->func) (processor->data,
+                                   regions[0],
+                                   regions[1]);
+      break;
 
-  /*  the first thread getting here must not call pixel_regions_process()  */
-  if (! processor->first && processor->PRI)
-    processor->PRI = pixel_regions_process (processor->PRI);
-  else
-    processor->first = FALSE;
+    case 3:
+      ((p3_func) processor->func) (processor->data,
+                                   regions[0],
+                                   regions[1],
+                                   regions[2]);
+      break;
+
+    case 4:
+      ((p4_func) processor->func) (processor->data,
+                                   regions[0],
+                                   regions[1],
+                                   regions[2],
+                                   regions[3]);
+      break;
 
-  while (processor->PRI)
+    case 5:
+      ((p5_func) processor->func) (processor->data,
+                                   regions[0],
+                                   regions[1],
+                                   regions[2],
+                                   regions[3],
+                                   regions[4]);
+      break;
+
+    default:
+      g_warning ("pixel_processor_call: Bad number of regions %d\n",
+                 processor->num_regions);
+      break;
+    }
+}
+
+static gboolean
+pixel_processor_progress_timeout (GTimeVal *last_time)
+{
+  GTimeVal now;
+
+  g_get_current_time (&now);
+
+  if (((now.tv_sec - last_time->tv_sec) * 1024 +
+       (now.tv_usec - last_time->tv_usec) / 1024) > PROGRESS_TIMEOUT)
     {
-      const guint pixels = (processor->PRI->portion_width *
-                            processor->PRI->portion_height);
+      *last_time = now;
 
-      for (i = 0; i < processor->num_regions; i++)
-        {
-          if (processor->regions[i])
-            {
-              memcpy (&tr[i], processor->regions[i], sizeof (PixelRegion));
+      return TRUE;
+    }
 
-              if (tr[i].tiles)
-                tile_lock (tr[i].curtile);
-            }
-        }
+  return FALSE;
+}
 
-      g_mutex_unlock (processor->mutex);
 
-      switch (processor->num_regions)
+#ifdef ENABLE_MP
+
+static void
+pixel_processor_unref (PixelProcessor *processor)
+{
+  if (g_atomic_int_dec_and_test (&processor->ref_count))
+    {
+      g_cond_free (processor->cond);
+      g_mutex_free (processor->mutex);
+
+      g_slice_free (PixelProcessor, processor);
+    }
+}
+
+/*  Called with processor->mutex locked.  Returns the next chunk for
+ *  @slot, stealing one if the slot ran dry, or -1 if all chunks are
+ *  taken.
+ */
+static gint
+pixel_processor_next_chunk (PixelProcessor *processor,
+                            gint            slot)
+{
+  PixelProcessorRange *range  = &processor->slots[slot];
+  PixelProcessorRange *victim = NULL;
+  gint                 chunk;
+  gint                 i;
+
+  if (range->begin < range->end)
+    return range->begin++;
+
+  for (i = 0; i < processor->n_slots; i++)
+    {
+      PixelProcessorRange *other = &processor->slots[i];
+
+      if (other->end - other->begin > 0 &&
+          (! victim ||
+           other->end - other->begin > victim->end - victim->begin))
         {
-        case 1:
-          ((p1_func) processor->func) (processor->data,
-                                       processor->regions[0] ? &tr[0] : NULL);
-          break;
-
-        case 2:
-          ((p2_func) processor->func) (processor->data,
-                                       processor->regions[0] ? &tr[0] : NULL,
-                                       processor->regions[1] ? &tr[1] : NULL);
-          break;
-
-        case 3:
-          ((p3_func) processor->func) (processor->data,
-                                       processor->regions[0] ? &tr[0] : NULL,
-                                       processor->regions[1] ? &tr[1] : NULL,
-                                       processor->regions[2] ? &tr[2] : NULL);
-          break;
-
-        case 4:
-          ((p4_func) processor->func) (processor->data,
-                                       processor->regions[0] ? &tr[0] : NULL,
-                                       processor->regions[1] ? &tr[1] : NULL,
-                                       processor->regions[2] ? &tr[2] : NULL,
-                                       processor->regions[3] ? &tr[3] : NULL);
-          break;
-        case 5:
-          ((p5_func) processor->func) (processor->data,
-                                       processor->regions[0] ? &tr[0] : NULL,
-                                       processor->regions[1] ? &tr[1] : NULL,
-                                       processor->regions[2] ? &tr[2] : NULL,
-                                       processor->regions[3] ? &tr[3] : NULL,
-                                       processor->regions[4] ? &tr[4] : NULL);
-          break;
-
-        default:
-          g_warning ("do_parallel_regions: Bad number of regions %d\n",
-                     processor->num_regions);
-          break;
+          victim = other;
         }
+    }
 
-      g_mutex_lock (processor->mutex);
+  if (! victim)
+    return -1;
+
+  chunk = victim->begin + (victim->end - victim->begin) / 2;
 
-      for (i = 0; i < processor->num_regions; i++)
+  range->begin = chunk + 1;
+  range->end   = victim->end;
+  victim->end  = chunk;
+
+  return chunk;
+}
+
+/*  Processes one chunk with private copies of the regions, moved and
+ *  cropped to it.  Only the locking and releasing of tiles is done
+ *  with tile_mutex held.
+ */
+static gulong
+pixel_processor_do_chunk (PixelProcessor *processor,
+                          gint            chunk)
+{
+  PixelRegion          regions[5];
+  PixelRegion         *PR[5] = { NULL, };
+  PixelRegionIterator *PRI;
+  const gint           row   = chunk / processor->chunks_per_row;
+  const gint           col   = ((chunk % processor->chunks_per_row) *
+                                processor->cols_per_chunk);
+  gint                 x1, y1, x2, y2;
+  gint                 i;
+
+  x1 = processor->grid_x + col * TILE_WIDTH;
+  x2 = x1 + processor->cols_per_chunk * TILE_WIDTH;
+  y1 = processor->grid_y + row * TILE_HEIGHT;
+  y2 = y1 + TILE_HEIGHT;
+
+  x1 = MAX (x1, processor->x);
+  y1 = MAX (y1, processor->y);
+  x2 = MIN (x2, processor->x + processor->width);
+  y2 = MIN (y2, processor->y + processor->height);
+
+  for (i = 0; i < processor->num_regions; i++)
+    {
+      if (processor->regions[i])
         {
-          if (processor->regions[i])
+          regions[i] = *processor->regions[i];
+
+          regions[i].x += x1 - processor->x;
+          regions[i].y += y1 - processor->y;
+
+          /*  the size of a closed loop is its loop size  */
+          if (! regions[i].closed_loop)
             {
-              if (tr[i].tiles)
-                tile_release (tr[i].curtile, tr[i].dirty);
+              regions[i].w = x2 - x1;
+              regions[i].h = y2 - y1;
             }
+
+          PR[i] = &regions[i];
         }
+    }
 
-      processor->progress += pixels;
+  g_static_mutex_lock (&tile_mutex);
 
-      if (processor->PRI)
-        processor->PRI = pixel_regions_process (processor->PRI);
-    }
+  PRI = pixel_regions_register (processor->num_regions,
+                                PR[0], PR[1], PR[2], PR[3], PR[4]);
 
-  processor->threads--;
+  g_static_mutex_unlock (&tile_mutex);
 
-  if (processor->threads == 0)
+  while (PRI)
     {
-      g_mutex_unlock (processor->mutex);
+      pixel_processor_call (processor, PR);
 
-      g_mutex_lock (pool_mutex);
-      g_cond_signal  (pool_cond);
-      g_mutex_unlock (pool_mutex);
-    }
-  else
-    {
-      g_mutex_unlock (processor->mutex);
+      g_static_mutex_lock (&tile_mutex);
+
+      PRI = pixel_regions_process (PRI);
+
+      g_static_mutex_unlock (&tile_mutex);
     }
-}
-#endif
 
-/*  do_parallel_regions_single is just like do_parallel_regions
- *   except that all the mutex and tile locks have been removed
- *
- * If we are processing with only a single thread we don't need to do
- * the mutex locks etc. and aditional tile locks even if we were
- * configured --with-mp
- */
+  return (gulong) (x2 - x1) * (y2 - y1);
+}
 
-static gpointer
-do_parallel_regions_single (PixelProcessor             *processor,
-                            PixelProcessorProgressFunc  progress_func,
-                            gpointer                    progress_data,
-                            gulong                      total)
+static void
+pixel_processor_work (PixelProcessor             *processor,
+                      gint                        slot,
+                      PixelProcessorProgressFunc  progress_func,
+                      gpointer                    progress_data)
 {
-  GTimeVal  last_time;
+  GTimeVal last_time;
+  gint     chunk;
 
   if (progress_func)
     g_get_current_time (&last_time);
 
-  do
+  g_mutex_lock (processor->mutex);
+
+  while ((chunk = pixel_processor_next_chunk (processor, slot)) >= 0)
     {
-      switch (processor->num_regions)
+      gulong pixels;
+
+      g_mutex_unlock (processor->mutex);
+
+      if (processor->item_func)
         {
-        case 1:
-          ((p1_func) processor->func) (processor->data,
-                                       processor->regions[0]);
-          break;
-
-        case 2:
-          ((p2_func) processor->func) (processor->data,
-                                       processor->regions[0],
-                                       processor->regions[1]);
-          break;
-
-        case 3:
-          ((p3_func) processor->func) (processor->data,
-                                       processor->regions[0],
-                                       processor->regions[1],
-                                       processor->regions[2]);
-          break;
-
-        case 4:
-          ((p4_func) processor->func) (processor->data,
-                                       processor->regions[0],
-                                       processor->regions[1],
-                                       processor->regions[2],
-                                       processor->regions[3]);
-          break;
-
-        case 5:
-          ((p5_func) processor->func) (processor->data,
-                                       processor->regions[0],
-                                       processor->regions[1],
-                                       processor->regions[2],
-                                       processor->regions[3],
-                                       processor->regions[4]);
-          break;
-
-        default:
-          g_warning ("do_parallel_regions_single: Bad number of regions %d\n",
-                     processor->num_regions);
-          break;
+          processor->item_func (processor->data, chunk);
+          pixels = 1;
         }
-
-      if (progress_func)
+      else
         {
-          GTimeVal  now;
+          pixels = pixel_processor_do_chunk (processor, chunk);
+        }
 
-          processor->progress += (processor->PRI->portion_width *
-                                  processor->PRI->portion_height);
+      g_mutex_lock (processor->mutex);
 
-          g_get_current_time (&now);
+      processor->progress += pixels;
 
-          if (((now.tv_sec - last_time.tv_sec) * 1024 +
-               (now.tv_usec - last_time.tv_usec) / 1024) > PROGRESS_TIMEOUT)
-            {
-              progress_func (progress_data,
-                             (gdouble) processor->progress / (gdouble) total);
+      if (--processor->remaining == 0)
+        g_cond_broadcast (processor->cond);
 
-              last_time = now;
-            }
+      if (progress_func && pixel_processor_progress_timeout (&last_time))
+        {
+          gulong progress = processor->progress;
+
+          g_mutex_unlock (processor->mutex);
+
+          progress_func (progress_data,
+                         (gdouble) progress /
+                         (gdouble) processor->width / processor->height);
+
+          g_mutex_lock (processor->mutex);
         }
     }
-  while (processor->PRI &&
-         (processor->PRI = pixel_regions_process (processor->PRI)));
 
-  return NULL;
+  g_mutex_unlock (processor->mutex);
 }
 
+/*  the thread pool function  */
 static void
-pixel_regions_do_parallel (PixelProcessor             *processor,
-                           PixelProcessorProgressFunc  progress_func,
-                           gpointer                    progress_data)
+do_parallel_regions (PixelProcessor *processor)
 {
-  gulong pixels = (processor->PRI->region_width *
-                   processor->PRI->region_height);
-  gulong tiles  = pixels / (TILE_WIDTH * TILE_HEIGHT);
+  gint slot = g_atomic_int_add (&processor->next_slot, 1);
 
-#ifdef ENABLE_MP
-  if (pool && tiles > TILES_PER_THREAD)
+  if (slot < processor->n_slots)
+    pixel_processor_work (processor, slot, NULL, NULL);
+
+  pixel_processor_unref (processor);
+}
+
+/*  Distributes processor->n_chunks chunks over @n_slots threads, the
+ *  calling one included, and waits for all of them to be done.
+ */
+static void
+pixel_processor_run_threaded (PixelProcessor             *processor,
+                              gint                        n_slots,
+                              PixelProcessorProgressFunc  progress_func,
+                              gpointer                    progress_data)
+{
+  gint i;
+
+  processor->remaining = processor->n_chunks;
+
+  n_slots = MIN (n_slots, processor->n_chunks);
+
+  processor->n_slots   = n_slots;
+  processor->next_slot = 1;       /*  slot 0 is the calling thread's  */
+
+  for (i = 0; i < n_slots; i++)
     {
-      GError *error = NULL;
-      gint    tasks = MIN (tiles / TILES_PER_THREAD,
-                           g_thread_pool_get_max_threads (pool));
+      processor->slots[i].begin = processor->n_chunks * i / n_slots;
+      processor->slots[i].end   = processor->n_chunks * (i + 1) / n_slots;
+    }
 
-      /*
-       * g_printerr ("pushing %d tasks into the thread pool (for %lu tiles)\n",
-       *             tasks, tiles);
-       */
+  processor->ref_count = 1;
+  processor->mutex     = g_mutex_new ();
+  processor->cond      = g_cond_new ();
 
-      processor->first   = TRUE;
-      processor->threads = tasks;
-      processor->mutex   = g_mutex_new();
+  for (i = 1; i < n_slots; i++)
+    {
+      GError *error = NULL;
 
-      g_mutex_lock (pool_mutex);
+      g_atomic_int_inc (&processor->ref_count);
 
-      while (tasks--)
+      g_thread_pool_push (pool, processor, &error);
+
+      if (G_UNLIKELY (error))
         {
-          g_thread_pool_push (pool, processor, &error);
+          /*  the slot's chunks will be stolen  */
+          g_warning ("thread creation failed: %s", error->message);
+          g_clear_error (&error);
 
-          if (G_UNLIKELY (error))
-            {
-              g_warning ("thread creation failed: %s", error->message);
-              g_clear_error (&error);
-              processor->threads--;
-            }
+          pixel_processor_unref (processor);
         }
+    }
 
+  pixel_processor_work (processor, 0, progress_func, progress_data);
+
+  g_mutex_lock (processor->mutex);
+
+  while (processor->remaining > 0)
+    {
       if (progress_func)
         {
-          while (processor->threads != 0)
-            {
-              GTimeVal timeout;
-              gulong   progress;
+          GTimeVal timeout;
+          gulong   progress;
 
-              g_get_current_time (&timeout);
-              g_time_val_add (&timeout, PROGRESS_TIMEOUT * 1024);
+          g_get_current_time (&timeout);
+          g_time_val_add (&timeout, PROGRESS_TIMEOUT * 1024);
 
-              g_cond_timed_wait (pool_cond, pool_mutex, &timeout);
+          g_cond_timed_wait (processor->cond, processor->mutex, &timeout);
 
-              g_mutex_lock (processor->mutex);
-              progress = processor->progress;
-              g_mutex_unlock (processor->mutex);
+          progress = processor->progress;
 
-              progress_func (progress_data,
-                             (gdouble) progress / (gdouble) pixels);
-            }
+          g_mutex_unlock (processor->mutex);
+
+          progress_func (progress_data,
+                         (gdouble) progress /
+                         (gdouble) processor->width / processor->height);
+
+          g_mutex_lock (processor->mutex);
         }
       else
         {
-          while (processor->threads != 0)
-            g_cond_wait (pool_cond, pool_mutex);
+          g_cond_wait (processor->cond, processor->mutex);
         }
+    }
 
-      g_mutex_unlock (pool_mutex);
+  g_mutex_unlock (processor->mutex);
 
-      g_mutex_free (processor->mutex);
+  pixel_processor_unref (processor);
+}
+
+static void
+do_parallel_regions_threaded (PixelProcessor             *processor,
+                              gint                        n_slots,
+                              PixelProcessorProgressFunc  progress_func,
+                              gpointer                    progress_data)
+{
+  const gint x0     = processor->x;
+  const gint y0     = processor->y;
+  gint       n_rows;
+  gint       n_cols;
+  gint       chunks_per_row;
+
+  /*  align the chunks to the tile grid of the defining region, note
+   *  that its origin may be negative if it's not a tile manager
+   */
+  processor->grid_x = x0 - (((x0 % TILE_WIDTH)  + TILE_WIDTH)  % TILE_WIDTH);
+  processor->grid_y = y0 - (((y0 % TILE_HEIGHT) + TILE_HEIGHT) % TILE_HEIGHT);
+
+  n_rows = ((y0 + processor->height - processor->grid_y +
+             TILE_HEIGHT - 1) / TILE_HEIGHT);
+  n_cols = ((x0 + processor->width - processor->grid_x +
+             TILE_WIDTH - 1) / TILE_WIDTH);
+
+  /*  split rows into blocks only if there are too few of them  */
+  chunks_per_row = ((n_slots * CHUNKS_PER_THREAD + n_rows - 1) / n_rows);
+  chunks_per_row = CLAMP (chunks_per_row, 1, n_cols);
+
+  processor->cols_per_chunk = (n_cols + chunks_per_row - 1) / chunks_per_row;
+  processor->chunks_per_row = ((n_cols + processor->cols_per_chunk - 1) /
+                               processor->cols_per_chunk);
+  processor->n_chunks       = n_rows * processor->chunks_per_row;
+
+  pixel_processor_run_threaded (processor, n_slots,
+                                progress_func, progress_data);
+}
+
+#endif /* ENABLE_MP */
+
+/*  do_parallel_regions_single iterates over the whole area in the
+ *  calling thread, without any of the locking of the threaded case.
+ *
+ * If we are processing with only a single thread we don't need to do
+ * the mutex locks etc. and aditional tile locks even if we were
+ * configured --with-mp
+ */
+
+static void
+do_parallel_regions_single (PixelProcessor             *processor,
+                            PixelProcessorProgressFunc  progress_func,
+                            gpointer                    progress_data)
+{
+  PixelRegionIterator *PRI;
+  GTimeVal             last_time;
+  const gulong         total = (gulong) processor->width * processor->height;
+
+  PRI = pixel_regions_register (processor->num_regions,
+                                processor->regions[0],
+                                processor->regions[1],
+                                processor->regions[2],
+                                processor->regions[3],
+                                processor->regions[4]);
+
+  if (progress_func)
+    g_get_current_time (&last_time);
+
+  while (PRI)
+    {
+      pixel_processor_call (processor, processor->regions);
+
+      if (progress_func)
+        {
+          processor->progress += (PRI->portion_width *
+                                  PRI->portion_height);
+
+          if (pixel_processor_progress_timeout (&last_time))
+            progress_func (progress_data,
+                           (gdouble) processor->progress / (gdouble) total);
+        }
+
+      PRI = pixel_regions_process (PRI);
+    }
+}
+
+static void
+pixel_regions_do_parallel (PixelProcessor             *processor,
+                           PixelProcessorProgressFunc  progress_func,
+                           gpointer                    progress_data)
+{
+#ifdef ENABLE_MP
+  gulong tiles   = ((gulong) processor->width * processor->height /
+                    (TILE_WIDTH * TILE_HEIGHT));
+  gint   n_slots = 0;
+
+  if (pool && tiles > TILES_PER_THREAD)
+    n_slots = MIN (tiles / TILES_PER_THREAD,
+                   g_thread_pool_get_max_threads (pool));
+
+  if (n_slots > 1)
+    {
+      /*  the pool threads may outlive this call  */
+      PixelProcessor *shared = g_slice_dup (PixelProcessor, processor);
+
+      do_parallel_regions_threaded (shared, n_slots,
+                                    progress_func, progress_data);
     }
   else
 #endif
     {
-      do_parallel_regions_single (processor,
-                                  progress_func, progress_data, pixels);
+      do_parallel_regions_single (processor, progress_func, progress_data);
     }
 
   if (progress_func)
@@ -374,64 +594,39 @@ pixel_regions_process_parallel_valist (PixelProcessorFunc         func,
                                        va_list                    ap)
 {
   PixelProcessor  processor = { NULL, };
+  PixelRegion    *region    = NULL;
   gint            i;
 
+  if (num_regions < 1 || num_regions > 5)
+    {
+      g_warning ("pixel_regions_process_parallel: "
+                 "bad number of regions (%d)", num_regions);
+      return;
+    }
+
   for (i = 0; i < num_regions; i++)
     processor.regions[i] = va_arg (ap, PixelRegion *);
 
-  switch (num_regions)
+  /*  like pixel_regions_register(), the first region which isn't a
+   *  closed loop defines the size of the area
+   */
+  for (i = 0; i < num_regions && ! region; i++)
     {
-    case 1:
-      processor.PRI = pixel_regions_register (num_regions,
-                                              processor.regions[0]);
-      break;
-
-    case 2:
-      processor.PRI = pixel_regions_register (num_regions,
-                                              processor.regions[0],
-                                              processor.regions[1]);
-      break;
-
-    case 3:
-      processor.PRI = pixel_regions_register (num_regions,
-                                              processor.regions[0],
-                                              processor.regions[1],
-                                              processor.regions[2]);
-      break;
-
-    case 4:
-      processor.PRI = pixel_regions_register (num_regions,
-                                              processor.regions[0],
-                                              processor.regions[1],
-                                              processor.regions[2],
-                                              processor.regions[3]);
-      break;
-
-    case 5:
-      processor.PRI = pixel_regions_register (num_regions,
-                                              processor.regions[0],
-                                              processor.regions[1],
-                                              processor.regions[2],
-                                              processor.regions[3],
-                                              processor.regions[4]);
-      break;
-
-    default:
-      g_warning ("pixel_regions_process_parallel: "
-                 "bad number of regions (%d)", processor.num_regions);
-      break;
+      if (processor.regions[i] && ! processor.regions[i]->closed_loop)
+        region = processor.regions[i];
     }
 
-  if (! processor.PRI)
+  if (! region || region->w <= 0 || region->h <= 0)
     return;
 
   processor.func        = func;
   processor.data        = data;
   processor.num_regions = num_regions;
 
-#ifdef ENABLE_MP
-  processor.threads     = 0;
-#endif
+  processor.x           = region->x;
+  processor.y           = region->y;
+  processor.width       = region->w;
+  processor.height      = region->h;
 
   processor.progress    = 0;
 
@@ -455,14 +650,11 @@ pixel_processor_set_num_threads (gint num_threads)
     {
       if (pool)
         {
-          g_thread_pool_free (pool, TRUE, TRUE);
+          /*  let queued tasks run, they hold a reference on their
+           *  processor and return right away
+           */
+          g_thread_pool_free (pool, FALSE, TRUE);
           pool = NULL;
-
-          g_cond_free (pool_cond);
-          pool_cond = NULL;
-
-          g_mutex_free (pool_mutex);
-          pool_mutex = NULL;
         }
     }
   else
@@ -477,9 +669,6 @@ pixel_processor_set_num_threads (gint num_threads)
         {
           pool = g_thread_pool_new ((GFunc) do_parallel_regions, NULL,
                                     num_threads, TRUE, &error);
-
-          pool_mutex = g_mutex_new ();
-          pool_cond  = g_cond_new ();
         }
 
       if (G_UNLIKELY (error))
@@ -533,3 +722,52 @@ pixel_regions_process_parallel_progress (PixelProcessorFunc          func,
 
   va_end (va);
 }
+
+void
+pixel_processor_process_items (PixelProcessorItemFunc  func,
+                               gpointer                data,
+                               gint                    n_items)
+{
+  gint i;
+
+  g_return_if_fail (func != NULL);
+
+#ifdef ENABLE_MP
+  if (pool && n_items > 1)
+    {
+      PixelProcessor *processor = g_slice_new0 (PixelProcessor);
+      gint            n_slots;
+
+      processor->item_func = func;
+      processor->data      = data;
+      processor->width     = n_items;
+      processor->height    = 1;
+      processor->n_chunks  = n_items;
+
+      n_slots = MIN (n_items, g_thread_pool_get_max_threads (pool));
+
+      pixel_processor_run_threaded (processor, n_slots, NULL, NULL);
+
+      return;
+    }
+#endif
+
+  for (i = 0; i < n_items; i++)
+    func (data, i);
+}
+
+void
+pixel_processor_lock_tiles (void)
+{
+#ifdef ENABLE_MP
+  g_static_mutex_lock (&tile_mutex);
+#endif
+}
+
+void
+pixel_processor_unlock_tiles (void)
+{
+#ifdef ENABLE_MP
+  g_static_mutex_unlock (&tile_mutex);
+#endif
+}
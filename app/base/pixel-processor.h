@@ -26,6 +26,8 @@
 
 typedef void (* PixelProcessorProgressFunc) (gpointer  progress_data,
                                              gdouble   fraction);
+typedef void (* PixelProcessorItemFunc)     (gpointer  data,
+                                             gint      item);
 
 
 void  pixel_processor_init            (gint num_threads);
@@ -45,5 +47,21 @@ void  pixel_regions_process_parallel_progress
                                        gint                        num_regions,
                                        ...);
 
+/*  Calls @func for items 0 to @n_items - 1, in parallel if possible,
+ *  and returns when all of them are done.  @func must not lock tiles,
+ *  tile locking isn't thread-safe; lock them before and release them
+ *  after, or lock and release them between the two calls below.
+ */
+void  pixel_processor_process_items   (PixelProcessorItemFunc  func,
+                                       gpointer                data,
+                                       gint                    n_items);
+
+/*  Serialize locking and releasing tiles with the other threads of the
+ *  pixel processor.  The tiles must be valid already, validating them
+ *  may run the pixel processor again, which would deadlock.
+ */
+void  pixel_processor_lock_tiles      (void);
+void  pixel_processor_unlock_tiles    (void);
+
 
 #endif /* __PIXEL_PROCESSOR_H__ */
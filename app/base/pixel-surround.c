@@ -23,12 +23,29 @@
 
 #include "base-types.h"
 
+#include "pixel-processor.h"
 #include "pixel-region.h"
 #include "pixel-surround.h"
 #include "tile-manager.h"
 #include "tile.h"
 
 
+/*  the number of tiles a surround keeps locked, enough for an area
+ *  across a tile corner
+ */
+#define PIXEL_SURROUND_CACHE  4
+
+
+typedef struct
+{
+  Tile  *tile;                   /*  locked tile (may be NULL)            */
+  gint   x;                      /*  origin of locked tile                */
+  gint   y;                      /*  origin of locked tile                */
+  gint   w;                      /*  width of locked tile                 */
+  gint   h;                      /*  height of locked tile                */
+  guint  used;                   /*  when the tile was last used          */
+} PixelSurroundTile;
+
 struct _PixelSurround
 {
   TileManager       *mgr;        /*  tile manager to access tiles from    */
@@ -37,15 +54,16 @@ struct _PixelSurround
   gint               bpp;        /*  bytes per pixel in tile manager      */
   gint               w;          /*  width of pixel surround area         */
   gint               h;          /*  height of pixel surround area        */
-  Tile              *tile;       /*  locked tile (may be NULL)            */
-  gint               tile_x;     /*  origin of locked tile                */
-  gint               tile_y;     /*  origin of locked tile                */
-  gint               tile_w;     /*  width of locked tile                 */
-  gint               tile_h;     /*  height of locked tile                */
+  PixelSurroundTile  tiles[PIXEL_SURROUND_CACHE];
+  PixelSurroundTile *last;       /*  the tile used last (may be NULL)     */
+  guint              clock;      /*  counts the uses of tiles             */
+  gint               miss_col;   /*  tile column of the last tile locked  */
+  gint               miss_row;   /*  tile row of the last tile locked     */
   gint               rowstride;  /*  rowstride of buffers                 */
   guchar            *bg;         /*  buffer filled with background color  */
   guchar            *buf;        /*  buffer used for combining tile data  */
   PixelSurroundMode  mode;
+  gboolean           parallel;   /*  lock tiles with the pixel processor  */
 };
 
 static const guchar * pixel_surround_get_data (PixelSurround *surround,
@@ -54,6 +72,15 @@ static const guchar * pixel_surround_get_data (PixelSurround *surround,
                                                gint          *w,
                                                gint          *h,
                                                gint          *rowstride);
+static PixelSurroundTile *
+                      pixel_surround_find_tile (PixelSurround *surround,
+                                                gint           x,
+                                                gint           y);
+static PixelSurroundTile *
+                      pixel_surround_load_tile (PixelSurround     *surround,
+                                                gint               x,
+                                                gint               y,
+                                                PixelSurroundTile *keep);
 
 
 /**
@@ -67,6 +94,11 @@ static const guchar * pixel_surround_get_data (PixelSurround *surround,
  * surrounding a pixel. It is an efficient pixel access strategy for
  * interpolation algorithms.
  *
+ * The surround keeps the last few tiles it used locked, so areas
+ * across tile boundaries don't lock the same tiles over and over.
+ * When it has to lock a tile next to the one it locked before, it
+ * locks the one after it in the same direction as well.
+ *
  * Return value: a new #PixelSurround.
  */
 PixelSurround *
@@ -93,6 +125,8 @@ pixel_surround_new (TileManager       *tiles,
   surround->bg        = g_new0 (guchar, surround->rowstride * height);
   surround->buf       = g_new (guchar, surround->rowstride * height);
   surround->mode      = mode;
+  surround->miss_col  = -2;        /*  next to no tile  */
+  surround->miss_row  = -2;
 
   return surround;
 }
@@ -122,6 +156,26 @@ pixel_surround_set_bg (PixelSurround *surround,
     }
 }
 
+/**
+ * pixel_surround_set_parallel:
+ * @surround: a #PixelSurround
+ * @parallel: whether @surround is used on the pixel processor
+ *
+ * Makes @surround lock and release its tiles between
+ * pixel_processor_lock_tiles() and pixel_processor_unlock_tiles(), so
+ * that functions running on the pixel processor can each use a
+ * #PixelSurround of their own on the same tile manager.  The tiles
+ * must be valid already.
+ */
+void
+pixel_surround_set_parallel (PixelSurround *surround,
+                             gboolean       parallel)
+{
+  g_return_if_fail (surround != NULL);
+
+  surround->parallel = parallel ? TRUE : FALSE;
+}
+
 /**
  * pixel_surround_lock:
  * @surround:  a #PixelSurround
@@ -212,6 +266,54 @@ pixel_surround_lock (PixelSurround *surround,
   return surround->buf;
 }
 
+/**
+ * pixel_surround_get_pixels:
+ * @surround: a #PixelSurround
+ * @x:        X coordinates of the pixels
+ * @y:        Y coordinates of the pixels
+ * @n_pixels: number of pixels
+ * @dest:     return location for @n_pixels pixels
+ *
+ * Copies the pixels at @x and @y to @dest, one after the other.
+ * Pixels that are not covered by the tile manager are the ones
+ * pixel_surround_lock() would give for them.  This saves a call per
+ * pixel when sampling without interpolation.
+ */
+void
+pixel_surround_get_pixels (PixelSurround *surround,
+                           const gint    *x,
+                           const gint    *y,
+                           gint           n_pixels,
+                           guchar        *dest)
+{
+  const gint bpp = surround->bpp;
+  gint       i;
+
+  for (i = 0; i < n_pixels; i++, dest += bpp)
+    {
+      PixelSurroundTile *tile = surround->last;
+      const guchar      *src;
+      gint               b;
+
+      if (tile &&
+          x[i] >= tile->x && x[i] < tile->x + tile->w &&
+          y[i] >= tile->y && y[i] < tile->y + tile->h)
+        {
+          src = tile_data_pointer (tile->tile, x[i], y[i]);
+        }
+      else
+        {
+          gint w, h, rowstride;
+
+          src = pixel_surround_get_data (surround, x[i], y[i],
+                                         &w, &h, &rowstride);
+        }
+
+      for (b = 0; b < bpp; b++)
+        dest[b] = src[b];
+    }
+}
+
 /**
  * pixel_surround_release:
  * @surround: #PixelSurround
@@ -221,11 +323,29 @@ pixel_surround_lock (PixelSurround *surround,
 void
 pixel_surround_release (PixelSurround *surround)
 {
-  if (surround->tile)
+  gint i;
+
+  for (i = 0; i < PIXEL_SURROUND_CACHE; i++)
     {
-      tile_release (surround->tile, FALSE);
-      surround->tile = NULL;
+      PixelSurroundTile *tile = &surround->tiles[i];
+
+      if (tile->tile)
+        {
+          if (surround->parallel)
+            pixel_processor_lock_tiles ();
+
+          tile_release (tile->tile, FALSE);
+
+          if (surround->parallel)
+            pixel_processor_unlock_tiles ();
+
+          tile->tile = NULL;
+        }
     }
+
+  surround->last     = NULL;
+  surround->miss_col = -2;
+  surround->miss_row = -2;
 }
 
 /**
@@ -309,40 +429,27 @@ pixel_surround_get_data (PixelSurround *surround,
                          gint          *h,
                          gint          *rowstride)
 {
-  /*  do we still have a tile lock that we can use?  */
-  if (surround->tile)
-    {
-      if (x < surround->tile_x || x >= surround->tile_x + surround->tile_w ||
-          y < surround->tile_y || y >= surround->tile_y + surround->tile_h)
-        {
-          tile_release (surround->tile, FALSE);
-          surround->tile = NULL;
-        }
-    }
+  PixelSurroundTile *tile = surround->last;
 
-  /*  if not, try to get one for the target pixel  */
-  if (! surround->tile)
+  /*  is the pixel on the tile we used last, or on another locked one?  */
+  if (! tile ||
+      x < tile->x || x >= tile->x + tile->w ||
+      y < tile->y || y >= tile->y + tile->h)
     {
-      surround->tile = tile_manager_get_tile (surround->mgr, x, y, TRUE, FALSE);
-
-      if (surround->tile)
-        {
-          /*  store offset and size of the locked tile  */
-          surround->tile_x = x & ~(TILE_WIDTH - 1);
-          surround->tile_y = y & ~(TILE_HEIGHT - 1);
-          surround->tile_w = tile_ewidth (surround->tile);
-          surround->tile_h = tile_eheight (surround->tile);
-        }
+      tile = pixel_surround_find_tile (surround, x, y);
     }
 
-  if (surround->tile)
+  if (tile)
     {
-      *w = surround->tile_x + surround->tile_w - x;
-      *h = surround->tile_y + surround->tile_h - y;
+      tile->used     = ++surround->clock;
+      surround->last = tile;
+
+      *w = tile->x + tile->w - x;
+      *h = tile->y + tile->h - y;
 
-      *rowstride = surround->tile_w * surround->bpp;
+      *rowstride = tile->w * surround->bpp;
 
-      return tile_data_pointer (surround->tile, x, y);
+      return tile_data_pointer (tile->tile, x, y);
     }
 
   if (x < 0)
@@ -418,3 +525,112 @@ pixel_surround_get_data (PixelSurround *surround,
   /*   return a pointer to the virtual background tile  */
   return surround->bg;
 }
+
+static PixelSurroundTile *
+pixel_surround_find_tile (PixelSurround *surround,
+                          gint           x,
+                          gint           y)
+{
+  PixelSurroundTile *tile;
+  gint               col, row;
+  gint               dx, dy;
+  gint               i;
+
+  for (i = 0; i < PIXEL_SURROUND_CACHE; i++)
+    {
+      tile = &surround->tiles[i];
+
+      if (tile->tile &&
+          x >= tile->x && x < tile->x + tile->w &&
+          y >= tile->y && y < tile->y + tile->h)
+        return tile;
+    }
+
+  if (x < 0 || x > surround->xmax || y < 0 || y > surround->ymax)
+    return NULL;
+
+  /*  if we moved on to a neighbouring tile, we will likely move on
+   *  to the one after it as well
+   */
+  col = x / TILE_WIDTH;
+  row = y / TILE_HEIGHT;
+
+  dx = col - surround->miss_col;
+  dy = row - surround->miss_row;
+
+  surround->miss_col = col;
+  surround->miss_row = row;
+
+  if (surround->parallel)
+    pixel_processor_lock_tiles ();
+
+  tile = pixel_surround_load_tile (surround, x, y, NULL);
+
+  if (tile && ABS (dx) <= 1 && ABS (dy) <= 1)
+    {
+      gint next_x = x + dx * TILE_WIDTH;
+      gint next_y = y + dy * TILE_HEIGHT;
+
+      if (next_x >= 0 && next_x <= surround->xmax &&
+          next_y >= 0 && next_y <= surround->ymax)
+        {
+          pixel_surround_load_tile (surround, next_x, next_y, tile);
+        }
+    }
+
+  if (surround->parallel)
+    pixel_processor_unlock_tiles ();
+
+  return tile;
+}
+
+/*  locks the tile at @x, @y in place of the one used longest ago,
+ *  which is never @keep
+ */
+static PixelSurroundTile *
+pixel_surround_load_tile (PixelSurround     *surround,
+                          gint               x,
+                          gint               y,
+                          PixelSurroundTile *keep)
+{
+  PixelSurroundTile *tile = NULL;
+  gint               i;
+
+  for (i = 0; i < PIXEL_SURROUND_CACHE; i++)
+    {
+      PixelSurroundTile *t = &surround->tiles[i];
+
+      if (t == keep)
+        continue;
+
+      if (t->tile &&
+          x >= t->x && x < t->x + t->w &&
+          y >= t->y && y < t->y + t->h)
+        return t;
+
+      if (! tile || ! t->tile || (tile->tile && t->used < tile->used))
+        tile = t;
+    }
+
+  if (tile->tile)
+    {
+      if (surround->last == tile)
+        surround->last = NULL;
+
+      tile_release (tile->tile, FALSE);
+    }
+
+  tile->tile = tile_manager_get_tile (surround->mgr, x, y, TRUE, FALSE);
+
+  if (! tile->tile)
+    return NULL;
+
+  /*  store offset and size of the locked tile  */
+  tile->x    = x & ~(TILE_WIDTH - 1);
+  tile->y    = y & ~(TILE_HEIGHT - 1);
+  tile->w    = tile_ewidth (tile->tile);
+  tile->h    = tile_eheight (tile->tile);
+  tile->used = surround->clock;
+
+  return tile;
+}
@@ -36,6 +36,9 @@ PixelSurround * pixel_surround_new      (TileManager       *tiles,
                                          PixelSurroundMode  mode);
 void            pixel_surround_set_bg   (PixelSurround     *surround,
                                          const guchar      *bg);
+void            pixel_surround_set_parallel
+                                        (PixelSurround     *surround,
+                                         gboolean           parallel);
 
 /* return a pointer to a buffer which contains all the surrounding pixels
  * strategy: if we are in the middle of a tile, use the tile storage
@@ -46,6 +49,13 @@ const guchar  * pixel_surround_lock     (PixelSurround     *surround,
                                          gint               y,
                                          gint              *rowstride);
 
+void            pixel_surround_get_pixels
+                                        (PixelSurround     *surround,
+                                         const gint        *x,
+                                         const gint        *y,
+                                         gint               n_pixels,
+                                         guchar            *dest);
+
 void            pixel_surround_release  (PixelSurround     *surround);
 void            pixel_surround_destroy  (PixelSurround     *surround);
 
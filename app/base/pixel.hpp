@@ -355,4 +355,75 @@ inline Pixel::real r2f(const result_t v) {
 }
 
 #endif
+
+// Pixel traits: the arithmetic of the brush modes in
+// paint-funcs/mypaint-brushmodes.hpp for one precision, so that each
+// of them is compiled into a kernel of its own.  value_t holds a
+// channel or an alpha, one() is 1.0.  Like in single precision an
+// opacity may exceed 1.0 until its product with the dab is clamped by
+// clamp(); the fixed point traits take values up to 2.0.
+
+// Single precision, the arithmetic of REAL_CALC above, operation for
+// operation.
+struct PixelTraitsReal {
+  typedef float value_t;
+
+  static value_t one() { return 1.0f; }
+  static value_t pix(const guchar v) { return (float)v / 255.0f; }
+  static value_t pix(const float v) { return v; }
+  static value_t mul(const value_t a, const value_t b) { return a * b; }
+  static value_t div(const value_t a, const value_t b) { return a / b; }
+  static value_t clamp(const value_t v) {
+    return (v < 0.0f)? 0.0f: (v > 1.0f)? 1.0f: v;
+  }
+  static guchar to_data(const value_t v) {
+    const float d = 255.0f * v + 0.5f;
+    return (guchar)((d < 0.0f)? 0.0f: (d > 255.0f)? 255.0f: d);
+  }
+};
+
+// 8 bit fixed point, 1.0 is 255 and the products are rounded like
+// INT_MULT() does.  The fastest, but the rounding shows in the colors
+// of nearly transparent pixels, which are divided by their alpha.
+struct PixelTraits8 {
+  typedef guint32 value_t;
+
+  static value_t one() { return 255; }
+  static value_t pix(const guchar v) { return v; }
+  static value_t pix(const float v) {
+    return (value_t)((v < 0.0f)? 0.0f: v * 255.0f + 0.5f);
+  }
+  static value_t mul(const value_t a, const value_t b) {
+    const value_t t = a * b + 0x80;
+    return ((t >> 8) + t) >> 8;
+  }
+  static value_t div(const value_t a, const value_t b) {
+    return b? (a * 255 + b / 2) / b: 0;
+  }
+  static value_t clamp(const value_t v) { return (v > 255)? 255: v; }
+  static guchar to_data(const value_t v) { return (guchar)v; }
+};
+
+// 15 bit fixed point, 1.0 is 1 << 15, like the fix15 arithmetic of
+// MyPaint itself.  The faint dabs of a slow soft stroke keep their
+// weight instead of being rounded to the same 8 bit step.
+struct PixelTraits15 {
+  typedef guint32 value_t;
+
+  static value_t one() { return 1 << 15; }
+  static value_t pix(const guchar v) { return (v * (1 << 15) + 127) / 255; }
+  static value_t pix(const float v) {
+    return (value_t)((v < 0.0f)? 0.0f: v * 32768.0f + 0.5f);
+  }
+  static value_t mul(const value_t a, const value_t b) { return (a * b) >> 15; }
+  // a is at most 2.0, a << 15 fits 32 bits
+  static value_t div(const value_t a, const value_t b) {
+    return b? (a << 15) / b: 0;
+  }
+  static value_t clamp(const value_t v) { return (v > (1 << 15))? (1 << 15): v; }
+  static guchar to_data(const value_t v) {
+    return (guchar)((v * 255 + (1 << 14)) >> 15);
+  }
+};
+
 #endif
@@ -23,8 +23,11 @@
 
 #include "tile.h"
 #include "tile-cache.h"
+#include "tile-compress.h"
+#include "tile-manager-mapped.h"
 #include "tile-swap.h"
 #include "tile-rowhints.h"
+#include "tile-stats.h"
 #include "tile-private.h"
 
 
@@ -32,6 +35,25 @@
 #define IDLE_SWAPPER_INTERVAL_MS        20
 #define IDLE_SWAPPER_TILES_PER_INTERVAL 10
 
+/*  with the asynchronous swap backend, swapping out only queues a copy
+ *  of the tile, so the idle swapper can afford to do more per run
+ */
+#define IDLE_SWAPPER_TILES_PER_INTERVAL_ASYNC 64
+
+/*  The cache is split into a number of shards, each with its own LRU
+ *  list, size accounting and (with ENABLE_MP) its own mutex.  A tile
+ *  always lives in the shard selected by hashing its address, so
+ *  worker threads locking and releasing different tiles rarely touch
+ *  the same lock.  The size budget is divided evenly between the
+ *  shards, but it is the total size that is kept below the budget:
+ *  a shard may grow past its share by taking tiles from the others.
+ */
+#ifdef ENABLE_MP
+#define TILE_CACHE_N_SHARDS             16
+#else
+#define TILE_CACHE_N_SHARDS             1
+#endif
+
 
 typedef struct _TileList
 {
@@ -39,14 +61,26 @@ typedef struct _TileList
   Tile *last;
 } TileList;
 
+typedef struct _TileCacheShard
+{
+  TileList  tile_list;
+  guint64   cur_cache_size;
+  guint64   cur_cache_dirty;
+  Tile     *idle_scan_last;
+
+#ifdef ENABLE_MP
+  GMutex   *mutex;
+#endif
+} TileCacheShard;
+
 
-static guint64       cur_cache_size   = 0;
-static guint64       max_cache_size   = 0;
-static guint64       cur_cache_dirty  = 0;
-static TileList      tile_list        = { NULL, NULL };
-static guint         idle_swapper     = 0;
-static guint         idle_delay       = 0;
-static Tile         *idle_scan_last   = NULL;
+static guint64        max_cache_size   = 0;
+static guint64        max_shard_size   = 0;
+static volatile gsize total_size       = 0;  /*  the shards' sizes summed  */
+static TileCacheShard shards[TILE_CACHE_N_SHARDS];
+static guint          idle_swapper     = 0;
+static guint          idle_delay       = 0;
+static gint           idle_shard       = 0;
 
 #ifdef TILE_PROFILING
 extern gulong        tile_idle_swapout;
@@ -54,58 +88,88 @@ extern gulong        tile_total_zorched;
 extern gulong        tile_total_zorched_swapout;
 extern glong         tile_total_interactive_sec;
 extern glong         tile_total_interactive_usec;
-extern gint          tile_exist_count;
 #endif
 
 #ifdef ENABLE_MP
 
-static GMutex       *tile_cache_mutex = NULL;
-
-#define TILE_CACHE_LOCK    g_mutex_lock (tile_cache_mutex)
-#define TILE_CACHE_UNLOCK  g_mutex_unlock (tile_cache_mutex)
+#define TILE_CACHE_LOCK(shard)     g_mutex_lock ((shard)->mutex)
+#define TILE_CACHE_TRYLOCK(shard)  g_mutex_trylock ((shard)->mutex)
+#define TILE_CACHE_UNLOCK(shard)   g_mutex_unlock ((shard)->mutex)
 
 #else
 
-#define TILE_CACHE_LOCK   /* nothing */
-#define TILE_CACHE_UNLOCK /* nothing */
+#define TILE_CACHE_LOCK(shard)     /* nothing */
+#define TILE_CACHE_TRYLOCK(shard)  TRUE
+#define TILE_CACHE_UNLOCK(shard)   /* nothing */
 
 #endif
 
-#define PENDING_WRITE(t) ((t)->dirty || (t)->swap_offset == -1)
+/*  mapped tiles are never written, their data is in the mapped file,
+ *  and neither are uniform ones, they are filled in from their pixel
+ */
+#define PENDING_WRITE(t) (! (t)->mapped                          && \
+                          ! ((t)->summary & TILE_SUMMARY_UNIFORM) && \
+                          ((t)->dirty || (t)->swap_offset == -1))
+
+/*  whether @size more bytes fit into the budget of the whole cache  */
+#define CACHE_FITS(size) ((gsize) g_atomic_pointer_get (&total_size) + (size) <= \
+                          max_cache_size)
 
 
-static gboolean  tile_cache_zorch_next     (void);
-static void      tile_cache_flush_internal (Tile     *tile);
-static gboolean  tile_idle_preswap         (gpointer  data);
+static inline TileCacheShard * tile_cache_get_shard (const Tile *tile);
+
+static gboolean  tile_cache_make_room      (TileCacheShard *shard,
+                                            gint            size);
+static gboolean  tile_cache_zorch_next     (TileCacheShard *shard);
+static void      tile_cache_flush_internal (TileCacheShard *shard,
+                                            Tile           *tile);
+static gboolean  tile_idle_preswap         (gpointer        data);
 #ifdef TILE_PROFILING
-static void      tile_verify               (void);
+static void      tile_verify               (TileCacheShard *shard);
 #endif
 
 
 void
 tile_cache_init (guint64 tile_cache_size)
 {
+  gint i;
+
+  for (i = 0; i < TILE_CACHE_N_SHARDS; i++)
+    {
+      TileCacheShard *shard = &shards[i];
+
 #ifdef ENABLE_MP
-  g_return_if_fail (tile_cache_mutex == NULL);
+      g_return_if_fail (shard->mutex == NULL);
 
-  tile_cache_mutex = g_mutex_new ();
+      shard->mutex = g_mutex_new ();
 #endif
 
-  tile_list.first = tile_list.last = NULL;
-  idle_scan_last = NULL;
+      shard->tile_list.first = shard->tile_list.last = NULL;
+      shard->cur_cache_size  = 0;
+      shard->cur_cache_dirty = 0;
+      shard->idle_scan_last  = NULL;
+    }
+
+  total_size = 0;
+  idle_shard = 0;
 
   max_cache_size = tile_cache_size;
+  max_shard_size = tile_cache_size / TILE_CACHE_N_SHARDS;
 }
 
 void
 tile_cache_exit (void)
 {
+  guint64 cur_cache_size;
+
   if (idle_swapper)
     {
       g_source_remove (idle_swapper);
       idle_swapper = 0;
     }
 
+  cur_cache_size = tile_cache_get_cur_size ();
+
   if (cur_cache_size > 0)
     g_warning ("tile cache not empty (%"G_GUINT64_FORMAT" bytes left)",
                cur_cache_size);
@@ -113,8 +177,15 @@ tile_cache_exit (void)
   tile_cache_set_size (0);
 
 #ifdef ENABLE_MP
-  g_mutex_free (tile_cache_mutex);
-  tile_cache_mutex = NULL;
+  {
+    gint i;
+
+    for (i = 0; i < TILE_CACHE_N_SHARDS; i++)
+      {
+        g_mutex_free (shards[i].mutex);
+        shards[i].mutex = NULL;
+      }
+  }
 #endif
 }
 
@@ -127,8 +198,9 @@ tile_cache_suspend_idle_swapper(void)
 void
 tile_cache_insert (Tile *tile)
 {
+  TileCacheShard *shard = tile_cache_get_shard (tile);
 
-  TILE_CACHE_LOCK;
+  TILE_CACHE_LOCK (shard);
 
   if (! tile->data)
     goto out;
@@ -146,19 +218,19 @@ tile_cache_insert (Tile *tile)
       if (tile->next)
         tile->next->prev = tile->prev;
       else
-        tile_list.last = tile->prev;
+        shard->tile_list.last = tile->prev;
 
       if(tile->prev){
 	tile->prev->next = tile->next;
       }else{
-	tile_list.first = tile->next;
+	shard->tile_list.first = tile->next;
       }
 
       if (PENDING_WRITE(tile))
-	cur_cache_dirty -= tile->size;
+	shard->cur_cache_dirty -= tile->size;
 
-      if(tile == idle_scan_last)
-	idle_scan_last = tile->next;
+      if(tile == shard->idle_scan_last)
+	shard->idle_scan_last = tile->next;
 //      g_print("E:");
 
     }
@@ -172,20 +244,18 @@ tile_cache_insert (Tile *tile)
        */
 
 #ifdef TILE_PROFILING
-      if ((cur_cache_size + tile->size) > max_cache_size)
+      if ((shard->cur_cache_size + tile->size) > max_shard_size ||
+          ! CACHE_FITS (tile->size))
         {
           GTimeVal now;
           GTimeVal later;
 
           g_get_current_time(&now);
 #endif
-          while ((cur_cache_size + tile->size) > max_cache_size)
+          if (! tile_cache_make_room (shard, tile->size))
             {
-              if (! tile_cache_zorch_next ())
-                {
-                  g_warning ("cache: unable to find room for a tile");
-                  goto out;
-                }
+              g_warning ("cache: unable to find room for a tile");
+              goto out;
             }
 
 #ifdef TILE_PROFILING
@@ -207,31 +277,37 @@ tile_cache_insert (Tile *tile)
         }
 #endif
 
-      cur_cache_size += tile->size;
-//      g_print("I(%d) ", cur_cache_size);
+      shard->cur_cache_size += tile->size;
+      g_atomic_pointer_add (&total_size, tile->size);
+//      g_print("I(%d) ", shard->cur_cache_size);
     }
 
   /* Put the tile at the end of the proper list */
 
   tile->next = NULL;
-  tile->prev = tile_list.last;
+  tile->prev = shard->tile_list.last;
 
-  if (tile_list.last)
-    tile_list.last->next = tile;
+  if (shard->tile_list.last)
+    shard->tile_list.last->next = tile;
   else
-    tile_list.first = tile;
+    shard->tile_list.first = tile;
 
-  tile_list.last = tile;
+  shard->tile_list.last = tile;
   tile->cached = TRUE;
   idle_delay = 1;
 
   if (PENDING_WRITE(tile))
     {
-      cur_cache_dirty += tile->size;
+      shard->cur_cache_dirty += tile->size;
 
-      if (! idle_scan_last)
-	idle_scan_last=tile;
+      if (! shard->idle_scan_last)
+	shard->idle_scan_last=tile;
 
+      /*  the idle swapper lives in the main loop; g_timeout_add_full()
+       *  is thread-safe, and a second start from a racing thread is
+       *  harmless since tile_idle_preswap() only ever reschedules
+       *  itself through this variable.
+       */
       if (! idle_swapper)
         {
 #ifdef TILE_PROFILING
@@ -247,68 +323,163 @@ tile_cache_insert (Tile *tile)
     }
 
 out:
-  TILE_CACHE_UNLOCK;
+  TILE_CACHE_UNLOCK (shard);
 }
 
 void
 tile_cache_flush (Tile *tile)
 {
-  TILE_CACHE_LOCK;
+  TileCacheShard *shard = tile_cache_get_shard (tile);
+
+  TILE_CACHE_LOCK (shard);
 
   if (tile->cached)
-    tile_cache_flush_internal (tile);
+    tile_cache_flush_internal (shard, tile);
 
-  TILE_CACHE_UNLOCK;
+  TILE_CACHE_UNLOCK (shard);
 }
 
 void
 tile_cache_set_size (guint64 cache_size)
 {
-  TILE_CACHE_LOCK;
+  gint i;
 
   idle_delay = 1;
   max_cache_size = cache_size;
+  max_shard_size = cache_size / TILE_CACHE_N_SHARDS;
+
+  for (i = 0; i < TILE_CACHE_N_SHARDS; i++)
+    {
+      TileCacheShard *shard = &shards[i];
+
+      TILE_CACHE_LOCK (shard);
+
+      while (shard->cur_cache_size > max_shard_size)
+        {
+          if (! tile_cache_zorch_next (shard))
+            break;
+        }
+
+      TILE_CACHE_UNLOCK (shard);
+    }
+}
+
+static inline TileCacheShard *
+tile_cache_get_shard (const Tile *tile)
+{
+#if TILE_CACHE_N_SHARDS > 1
+  /*  Tile structs are slice allocated, so the low bits of the address
+   *  carry no information; fold some higher bits in.
+   */
+  gsize hash = (gsize) tile;
+
+  hash = (hash >> 6) ^ (hash >> 12) ^ (hash >> 18);
+
+  return &shards[hash & (TILE_CACHE_N_SHARDS - 1)];
+#else
+  return &shards[0];
+#endif
+}
+
+guint64
+tile_cache_get_cur_size (void)
+{
+  return (gsize) g_atomic_pointer_get (&total_size);
+}
+
+/*  Called with @shard locked.  Evicts tiles from @shard until @size
+ *  more bytes fit into its share of the budget.  If the cache as a
+ *  whole still doesn't fit (the shard's share is smaller than a tile,
+ *  all its tiles are in use, or other shards have grown past their
+ *  share), tiles are taken from all shards in turn, one each round so
+ *  that none of them is emptied first, until it does.  The other
+ *  shards are only ever try-locked so that two threads making room
+ *  at the same time can't deadlock.
+ */
+static gboolean
+tile_cache_make_room (TileCacheShard *shard,
+                      gint            size)
+{
+  gboolean progress;
 
-  while (cur_cache_size > max_cache_size)
+  while ((shard->cur_cache_size + size) > max_shard_size)
     {
-      if (! tile_cache_zorch_next ())
+      if (! tile_cache_zorch_next (shard))
         break;
     }
 
-  TILE_CACHE_UNLOCK;
+  if (size > max_cache_size)
+    return FALSE;
+
+  do
+    {
+      gint i;
+
+      progress = FALSE;
+
+      for (i = 0; i < TILE_CACHE_N_SHARDS; i++)
+        {
+          TileCacheShard *other = &shards[i];
+
+          if (CACHE_FITS (size))
+            return TRUE;
+
+          if (other != shard && ! TILE_CACHE_TRYLOCK (other))
+            continue;
+
+          /*  a tile that can't be swapped out leaves the cache all
+           *  the same, so any tile taken is progress
+           */
+          if (other->tile_list.first)
+            {
+              tile_cache_zorch_next (other);
+              progress = TRUE;
+            }
+
+          if (other != shard)
+            {
+              TILE_CACHE_UNLOCK (other);
+            }
+        }
+    }
+  while (progress);
+
+  return CACHE_FITS (size);
 }
 
 static void
-tile_cache_flush_internal (Tile *tile)
+tile_cache_flush_internal (TileCacheShard *shard,
+                           Tile           *tile)
 {
   tile->cached = FALSE;
 
   if (PENDING_WRITE(tile))
-    cur_cache_dirty -= tile->size;
+    shard->cur_cache_dirty -= tile->size;
 
-  cur_cache_size -= tile->size;
+  shard->cur_cache_size -= tile->size;
+  g_atomic_pointer_add (&total_size, - (gssize) tile->size);
 
   if (tile->next)
     tile->next->prev = tile->prev;
   else
-    tile_list.last = tile->prev;
+    shard->tile_list.last = tile->prev;
 
   if (tile->prev)
     tile->prev->next = tile->next;
   else
-    tile_list.first = tile->next;
+    shard->tile_list.first = tile->next;
 
-  if (tile == idle_scan_last)
-    idle_scan_last = tile->next;
+  if (tile == shard->idle_scan_last)
+    shard->idle_scan_last = tile->next;
 
   tile->next = tile->prev = NULL;
 }
 
 static gboolean
-tile_cache_zorch_next (void)
+tile_cache_zorch_next (TileCacheShard *shard)
 {
 
-  Tile *tile = tile_list.first;
+  Tile *tile = shard->tile_list.first;
 
   if (! tile)
     return FALSE;
@@ -324,7 +495,35 @@ tile_cache_zorch_next (void)
     }
 #endif
 
-  tile_cache_flush_internal (tile);
+  tile_cache_flush_internal (shard, tile);
+
+  if (tile->mapped)
+    {
+      tile_mapped_evict (tile);
+      return TRUE;
+    }
+
+  /*  drop uniform tiles, tile_swap_in() fills them in again  */
+  if (tile_is_uniform (tile, NULL))
+    {
+      if (tile->compressed)
+        tile_compress_drop (tile);
+
+      if (tile->dirty && tile->swap_offset != -1)
+        tile_swap_delete (tile);
+
+      if (G_UNLIKELY (tile_stats_active))
+        tile_stats_record_uniform_skip (tile);
+
+      tile->dirty = FALSE;
+      tile_free (tile);
+
+      return TRUE;
+    }
+
+  /*  keep the tile in memory if it compresses well  */
+  if (tile_compress_store (tile))
+    return TRUE;
 
   if (PENDING_WRITE (tile))
     {
@@ -335,12 +534,8 @@ tile_cache_zorch_next (void)
   if (! tile->dirty)
     {
 //      g_print("Z:");
-      g_free (tile->data);
-      tile->data = NULL;
+      tile_free (tile);
 
-#ifdef TILE_PROFILING
-      tile_exist_count--;
-#endif
       return TRUE;
     }
 
@@ -351,8 +546,11 @@ tile_cache_zorch_next (void)
 static gboolean
 tile_idle_preswap_run (gpointer data)
 {
-  Tile *tile;
-  int count = 0;
+  gint count     = 0;
+  gint max_count = (tile_swap_is_async () ?
+                    IDLE_SWAPPER_TILES_PER_INTERVAL_ASYNC :
+                    IDLE_SWAPPER_TILES_PER_INTERVAL);
+  gint n;
 
   if (idle_delay)
     {
@@ -368,51 +566,63 @@ tile_idle_preswap_run (gpointer data)
       return FALSE;
     }
 
-  TILE_CACHE_LOCK;
-
 #ifdef TILE_PROFILING
   g_printerr(".");
 #endif
 
-  tile = idle_scan_last;
-
-  while (tile)
+  /*  visit the shards round-robin, continuing where the last run
+   *  stopped, so all of them get drained at the same pace
+   */
+  for (n = 0; n < TILE_CACHE_N_SHARDS; n++)
     {
-      if (PENDING_WRITE (tile))
+      TileCacheShard *shard = &shards[idle_shard];
+      Tile           *tile;
+
+      TILE_CACHE_LOCK (shard);
+
+      tile = shard->idle_scan_last;
+
+      while (tile)
         {
-          idle_scan_last = tile->next;
+          if (PENDING_WRITE (tile))
+            {
+              shard->idle_scan_last = tile->next;
 
 #ifdef TILE_PROFILING
-          tile_idle_swapout++;
+              tile_idle_swapout++;
 #endif
-          tile_swap_out (tile);
+              tile_swap_out (tile);
 
-          if (! PENDING_WRITE(tile))
-            cur_cache_dirty -= tile->size;
+              if (! PENDING_WRITE(tile))
+                shard->cur_cache_dirty -= tile->size;
 
-          count++;
-          if (count >= IDLE_SWAPPER_TILES_PER_INTERVAL)
-            {
-              TILE_CACHE_UNLOCK;
-              return TRUE;
+              count++;
+              if (count >= max_count)
+                {
+                  TILE_CACHE_UNLOCK (shard);
+                  return TRUE;
+                }
             }
+
+          tile = tile->next;
         }
 
-      tile = tile->next;
-    }
+      shard->idle_scan_last = NULL;
 
 #ifdef TILE_PROFILING
-  g_printerr ("\nidle swapper -> stopped\n");
+      tile_verify (shard);
 #endif
 
-  idle_scan_last = NULL;
-  idle_swapper = 0;
+      TILE_CACHE_UNLOCK (shard);
+
+      idle_shard = (idle_shard + 1) % TILE_CACHE_N_SHARDS;
+    }
 
 #ifdef TILE_PROFILING
-  tile_verify ();
+  g_printerr ("\nidle swapper -> stopped\n");
 #endif
 
-  TILE_CACHE_UNLOCK;
+  idle_swapper = 0;
 
   return FALSE;
 }
@@ -430,7 +640,16 @@ tile_idle_preswap (gpointer data)
   }
 
 #ifdef TILE_PROFILING
-  tile_verify ();
+  {
+    gint i;
+
+    for (i = 0; i < TILE_CACHE_N_SHARDS; i++)
+      {
+        TILE_CACHE_LOCK (&shards[i]);
+        tile_verify (&shards[i]);
+        TILE_CACHE_UNLOCK (&shards[i]);
+      }
+  }
   g_printerr("\nidle swapper -> running");
 #endif
 
@@ -442,8 +661,9 @@ tile_idle_preswap (gpointer data)
 }
 
 #ifdef TILE_PROFILING
+/*  Called with @shard locked.  */
 static void
-tile_verify (void)
+tile_verify (TileCacheShard *shard)
 {
   /* scan list linearly, count metrics, compare to running totals */
   const Tile *t;
@@ -451,7 +671,7 @@ tile_verify (void)
   guint64     local_dirty = 0;
   guint64     acc         = 0;
 
-  for (t = tile_list.first; t; t = t->next)
+  for (t = shard->tile_list.first; t; t = t->next)
     {
       local_size += t->size;
 
@@ -459,18 +679,18 @@ tile_verify (void)
         local_dirty += t->size;
     }
 
-  if (local_size != cur_cache_size)
+  if (local_size != shard->cur_cache_size)
     g_printerr ("\nCache size mismatch: running=%"G_GUINT64_FORMAT
                 ", tested=%"G_GUINT64_FORMAT"\n",
-                cur_cache_size,local_size);
+                shard->cur_cache_size,local_size);
 
-  if (local_dirty != cur_cache_dirty)
+  if (local_dirty != shard->cur_cache_dirty)
     g_printerr ("\nCache dirty mismatch: running=%"G_GUINT64_FORMAT
                 ", tested=%"G_GUINT64_FORMAT"\n",
-                cur_cache_dirty,local_dirty);
+                shard->cur_cache_dirty,local_dirty);
 
   /* scan forward from scan list */
-  for (t = idle_scan_last; t; t = t->next)
+  for (t = shard->idle_scan_last; t; t = t->next)
     {
       if (PENDING_WRITE (t))
         acc += t->size;
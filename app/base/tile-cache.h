@@ -19,13 +19,15 @@
 #define __TILE_CACHE_H__
 
 
-void   tile_cache_init                 (guint64 cache_size);
-void   tile_cache_exit                 (void);
+void    tile_cache_init                 (guint64 cache_size);
+void    tile_cache_exit                 (void);
 
-void   tile_cache_set_size             (guint64 cache_size);
-void   tile_cache_suspend_idle_swapper (void);
+void    tile_cache_set_size             (guint64 cache_size);
+void    tile_cache_suspend_idle_swapper (void);
 
-void   tile_cache_insert               (Tile   *tile);
-void   tile_cache_flush                (Tile   *tile);
+void    tile_cache_insert               (Tile   *tile);
+void    tile_cache_flush                (Tile   *tile);
+
+guint64 tile_cache_get_cur_size         (void);
 
 #endif /* __TILE_CACHE_H__ */
@@ -0,0 +1,490 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  A compressed in-memory tier between the tile cache and the swap
+ *  file.  Tiles evicted from the cache are run-length encoded (using
+ *  the same per-channel encoding as XCF tiles) and kept in memory as
+ *  long as the tier has room; the least recently stored tiles are
+ *  pushed on to the swap file when it fills up.  Tiles which don't
+ *  compress at least TILE_COMPRESS_MIN_RATIO times are not kept.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base-types.h"
+
+#include "tile.h"
+#include "tile-compress.h"
+#include "tile-rowhints.h"
+#include "tile-swap.h"
+#include "tile-private.h"
+
+
+#define TILE_COMPRESS_MIN_RATIO  2
+
+#define PENDING_WRITE(t) ((t)->dirty || (t)->swap_offset == -1)
+
+
+struct _TileCompressed
+{
+  Tile           *tile;
+  guchar         *data;
+  gint            size;
+
+  TileCompressed *next;  /*  least recently stored first  */
+  TileCompressed *prev;
+};
+
+
+static void      tile_compress_unlink (TileCompressed *entry);
+static gboolean  tile_compress_evict  (TileCompressed *entry);
+
+
+static TileCompressed    *first = NULL;
+static TileCompressed    *last  = NULL;
+static TileCompressStats  stats = { 0, };
+
+#ifdef ENABLE_MP
+
+static GMutex            *tile_compress_mutex = NULL;
+
+#define TILE_COMPRESS_LOCK    g_mutex_lock (tile_compress_mutex)
+#define TILE_COMPRESS_UNLOCK  g_mutex_unlock (tile_compress_mutex)
+
+#else
+
+#define TILE_COMPRESS_LOCK    /* nothing */
+#define TILE_COMPRESS_UNLOCK  /* nothing */
+
+#endif
+
+
+void
+tile_compress_init (guint64 tier_size)
+{
+#ifdef ENABLE_MP
+  g_return_if_fail (tile_compress_mutex == NULL);
+
+  tile_compress_mutex = g_mutex_new ();
+#endif
+
+  memset (&stats, 0, sizeof (stats));
+
+  stats.max_size = tier_size;
+}
+
+void
+tile_compress_exit (void)
+{
+  if (stats.n_tiles > 0)
+    g_warning ("compressed tile tier not empty (%d tiles left)",
+               stats.n_tiles);
+
+  while (first)
+    {
+      TileCompressed *entry = first;
+
+      tile_compress_unlink (entry);
+
+      entry->tile->compressed = NULL;
+
+      g_free (entry->data);
+      g_slice_free (TileCompressed, entry);
+    }
+
+#ifdef ENABLE_MP
+  g_mutex_free (tile_compress_mutex);
+  tile_compress_mutex = NULL;
+#endif
+}
+
+void
+tile_compress_set_size (guint64 tier_size)
+{
+  TILE_COMPRESS_LOCK;
+
+  stats.max_size = tier_size;
+
+  while (first && stats.cur_size > stats.max_size)
+    {
+      if (! tile_compress_evict (first))
+        break;
+    }
+
+  TILE_COMPRESS_UNLOCK;
+}
+
+gboolean
+tile_compress_store (Tile *tile)
+{
+  TileCompressed *entry;
+  guchar         *buf;
+  gint            size;
+
+  if (stats.max_size == 0 || ! tile->data)
+    return FALSE;
+
+  buf  = g_malloc (TILE_COMPRESS_MAX_SIZE (tile->ewidth * tile->eheight,
+                                          tile->bpp));
+  size = tile_compress_encode (tile->data,
+                               tile->ewidth * tile->eheight, tile->bpp,
+                               buf);
+
+  TILE_COMPRESS_LOCK;
+
+  if (size * TILE_COMPRESS_MIN_RATIO > tile->size)
+    {
+      stats.rejected++;
+
+      TILE_COMPRESS_UNLOCK;
+
+      g_free (buf);
+      return FALSE;
+    }
+
+  while (stats.cur_size + size > stats.max_size)
+    {
+      if (! first || ! tile_compress_evict (first))
+        {
+          TILE_COMPRESS_UNLOCK;
+
+          g_free (buf);
+          return FALSE;
+        }
+    }
+
+  entry = g_slice_new (TileCompressed);
+
+  entry->tile = tile;
+  entry->data = g_realloc (buf, size);
+  entry->size = size;
+  entry->next = NULL;
+  entry->prev = last;
+
+  if (last)
+    last->next = entry;
+  else
+    first = entry;
+
+  last = entry;
+
+  stats.cur_size += size;
+  stats.raw_size += tile->size;
+  stats.n_tiles++;
+
+  tile->compressed = entry;
+
+  TILE_COMPRESS_UNLOCK;
+
+  tile_free (tile);
+
+  return TRUE;
+}
+
+gboolean
+tile_compress_restore (Tile *tile)
+{
+  TileCompressed *entry;
+
+  /*  the tier is disabled (or not even initialized)  */
+  if (! tile->compressed && stats.max_size == 0)
+    return FALSE;
+
+  TILE_COMPRESS_LOCK;
+
+  entry = tile->compressed;
+
+  if (! entry)
+    {
+      if (stats.max_size > 0 && tile->swap_offset != -1)
+        stats.misses++;
+
+      TILE_COMPRESS_UNLOCK;
+
+      return FALSE;
+    }
+
+  tile_compress_unlink (entry);
+  tile->compressed = NULL;
+
+  stats.hits++;
+
+  TILE_COMPRESS_UNLOCK;
+
+  tile_alloc (tile);
+
+  tile_compress_decode (entry->data,
+                        tile->ewidth * tile->eheight, tile->bpp,
+                        tile->data);
+
+  g_free (entry->data);
+  g_slice_free (TileCompressed, entry);
+
+  return TRUE;
+}
+
+void
+tile_compress_drop (Tile *tile)
+{
+  TileCompressed *entry;
+
+  TILE_COMPRESS_LOCK;
+
+  entry = tile->compressed;
+
+  if (entry)
+    {
+      tile_compress_unlink (entry);
+      tile->compressed = NULL;
+    }
+
+  TILE_COMPRESS_UNLOCK;
+
+  if (entry)
+    {
+      g_free (entry->data);
+      g_slice_free (TileCompressed, entry);
+    }
+}
+
+void
+tile_compress_get_stats (TileCompressStats *tier_stats)
+{
+  g_return_if_fail (tier_stats != NULL);
+
+  TILE_COMPRESS_LOCK;
+
+  *tier_stats = stats;
+
+  TILE_COMPRESS_UNLOCK;
+}
+
+/*  The channels are encoded one after another, each as a sequence of
+ *  runs as in XCF tiles: a byte n < 128 is followed by a value which
+ *  repeats n + 1 times (n == 127: the count follows as 16 bit big
+ *  endian), a byte n >= 128 is followed by 256 - n literal values
+ *  (n == 128: 16 bit count).  Literal runs only end where a run of
+ *  three equal values starts, so the worst case is alternating long
+ *  literals and short runs, which costs two extra bytes per 131
+ *  pixels, plus 3 bytes per channel.
+ */
+gint
+tile_compress_encode (const guchar *src,
+                      gint          n_pixels,
+                      gint          bpp,
+                      guchar       *dest)
+{
+  guchar *d = dest;
+  gint    c;
+
+  for (c = 0; c < bpp; c++)
+    {
+      const guchar *s = src + c;
+      gint          i = 0;
+
+      while (i < n_pixels)
+        {
+          const guchar value = s[i * bpp];
+          gint         run   = 1;
+
+          while (i + run < n_pixels && run < 32768 &&
+                 s[(i + run) * bpp] == value)
+            run++;
+
+          if (run >= 3)
+            {
+              if (run >= 128)
+                {
+                  *d++ = 127;
+                  *d++ = run >> 8;
+                  *d++ = run & 0xff;
+                }
+              else
+                {
+                  *d++ = run - 1;
+                }
+
+              *d++ = value;
+
+              i += run;
+            }
+          else
+            {
+              const gint start = i;
+              gint       length;
+              gint       j;
+
+              while (i < n_pixels && i - start < 32768)
+                {
+                  if (i + 2 < n_pixels &&
+                      s[i * bpp] == s[(i + 1) * bpp] &&
+                      s[i * bpp] == s[(i + 2) * bpp])
+                    break;
+
+                  i++;
+                }
+
+              length = i - start;
+
+              if (length >= 128)
+                {
+                  *d++ = 128;
+                  *d++ = length >> 8;
+                  *d++ = length & 0xff;
+                }
+              else
+                {
+                  *d++ = 256 - length;
+                }
+
+              for (j = start; j < i; j++)
+                *d++ = s[j * bpp];
+            }
+        }
+    }
+
+  return d - dest;
+}
+
+void
+tile_compress_decode (const guchar *src,
+                      gint          n_pixels,
+                      gint          bpp,
+                      guchar       *dest)
+{
+  gint c;
+
+  for (c = 0; c < bpp; c++)
+    {
+      guchar *d    = dest + c;
+      gint    left = n_pixels;
+
+      while (left > 0)
+        {
+          gint n = *src++;
+          gint length;
+
+          if (n >= 128)
+            {
+              if (n == 128)
+                {
+                  length = (src[0] << 8) | src[1];
+                  src += 2;
+                }
+              else
+                {
+                  length = 256 - n;
+                }
+
+              left -= length;
+
+              while (length--)
+                {
+                  *d = *src++;
+                  d += bpp;
+                }
+            }
+          else
+            {
+              guchar value;
+
+              if (n == 127)
+                {
+                  length = (src[0] << 8) | src[1];
+                  src += 2;
+                }
+              else
+                {
+                  length = n + 1;
+                }
+
+              value = *src++;
+
+              left -= length;
+
+              while (length--)
+                {
+                  *d = value;
+                  d += bpp;
+                }
+            }
+        }
+    }
+}
+
+/*  private functions  */
+
+/*  Called with the tier locked.  */
+static void
+tile_compress_unlink (TileCompressed *entry)
+{
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    last = entry->prev;
+
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    first = entry->next;
+
+  entry->next = entry->prev = NULL;
+
+  stats.cur_size -= entry->size;
+  stats.raw_size -= entry->tile->size;
+  stats.n_tiles--;
+}
+
+/*  Called with the tier locked.  Writes the tile to the swap file
+ *  unless an up-to-date copy is already there, and forgets it.
+ */
+static gboolean
+tile_compress_evict (TileCompressed *entry)
+{
+  Tile *tile = entry->tile;
+
+  if (PENDING_WRITE (tile))
+    {
+      guchar *data = g_malloc (tile->size);
+
+      tile_compress_decode (entry->data,
+                            tile->ewidth * tile->eheight, tile->bpp,
+                            data);
+
+      tile_swap_out_data (tile, data);
+
+      g_free (data);
+
+      /* unable to swap out tile for some reason */
+      if (tile->dirty)
+        return FALSE;
+    }
+
+  tile_compress_unlink (entry);
+  tile->compressed = NULL;
+
+  stats.evicted++;
+
+  g_free (entry->data);
+  g_slice_free (TileCompressed, entry);
+
+  return TRUE;
+}
@@ -0,0 +1,71 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_COMPRESS_H__
+#define __TILE_COMPRESS_H__
+
+
+typedef struct _TileCompressStats TileCompressStats;
+
+struct _TileCompressStats
+{
+  guint64  max_size;      /*  the configured size of the tier            */
+  guint64  cur_size;      /*  bytes of compressed data held              */
+  guint64  raw_size;      /*  uncompressed size of the tiles held        */
+  gint     n_tiles;       /*  number of tiles held                       */
+
+  guint64  hits;          /*  swap-ins served from the tier              */
+  guint64  misses;        /*  swap-ins that had to go to the swap file   */
+  guint64  rejected;      /*  tiles that didn't compress well enough     */
+  guint64  evicted;       /*  tiles pushed on to the swap file           */
+};
+
+
+void      tile_compress_init      (guint64            tier_size);
+void      tile_compress_exit      (void);
+
+void      tile_compress_set_size  (guint64            tier_size);
+
+/*  tile_compress_store() is called by the tile cache for a tile it is
+ *  about to evict.  On success the tile's data is freed and kept
+ *  compressed until tile_compress_restore() is called for it from
+ *  tile_swap_in().
+ */
+gboolean  tile_compress_store     (Tile              *tile);
+gboolean  tile_compress_restore   (Tile              *tile);
+void      tile_compress_drop      (Tile              *tile);
+
+void      tile_compress_get_stats (TileCompressStats *stats);
+
+/*  The run-length encoding of the tier, see tile-compress.c.  The
+ *  encoding of @n_pixels pixels of @bpp bytes never takes more than
+ *  TILE_COMPRESS_MAX_SIZE() bytes.
+ */
+#define TILE_COMPRESS_MAX_SIZE(n_pixels, bpp) \
+  ((n_pixels) * (bpp) + (n_pixels) * (bpp) / 32 + 3 * (bpp))
+
+gint      tile_compress_encode    (const guchar      *src,
+                                   gint               n_pixels,
+                                   gint               bpp,
+                                   guchar            *dest);
+void      tile_compress_decode    (const guchar      *src,
+                                   gint               n_pixels,
+                                   gint               bpp,
+                                   guchar            *dest);
+
+
+#endif /* __TILE_COMPRESS_H__ */
@@ -0,0 +1,250 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Tile managers whose tiles are views into a read-only mapping of a
+ *  tile file.  Creating one doesn't read any pixel data, the pages of
+ *  a tile are faulted in by the kernel when the tile is first used.
+ *  Mapped tiles take part in the tile cache like any other tile, but
+ *  evicting one only tells the kernel to drop its pages, they are
+ *  never written to the swap file.  A tile that is locked for writing
+ *  is copied to the heap and detached from the mapping first; shared
+ *  tiles go through the normal copy-on-write path, which does the
+ *  same.  Each mapped tile holds a reference on the mapping, so it
+ *  stays around as long as any duplicate of the tile manager uses it.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "base-types.h"
+
+#include "tile.h"
+#include "tile-manager.h"
+#include "tile-manager-mapped.h"
+#include "tile-manager-private.h"
+#include "tile-rowhints.h"
+#include "tile-private.h"
+
+#include "gimp-intl.h"
+
+
+TileManager *
+tile_manager_new_mapped (const gchar *filename,
+                         goffset      offset,
+                         gint         width,
+                         gint         height,
+                         gint         bpp,
+                         GError     **error)
+{
+  TileManager *tm;
+  GMappedFile *file;
+  gint         n_tiles;
+  gint         i;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (offset >= 0, NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+  g_return_val_if_fail (bpp > 0 && bpp <= 4, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  file = g_mapped_file_new (filename, FALSE, error);
+
+  if (! file)
+    return NULL;
+
+  if (g_mapped_file_get_length (file) <
+      offset + (guint64) width * height * bpp)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("Tile file '%s' is too short for a %d x %d image"),
+                   gimp_filename_to_utf8 (filename), width, height);
+
+      g_mapped_file_unref (file);
+
+      return NULL;
+    }
+
+  tm = tile_manager_new (width, height, bpp);
+
+  n_tiles = tm->ntile_rows * tm->ntile_cols;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      /*  doesn't lock the tile  */
+      Tile *tile = tile_manager_get (tm, i, FALSE, FALSE);
+
+      tile_manager_map_file (tm, i, file, offset);
+
+      offset += tile->size;
+    }
+
+  g_mapped_file_unref (file);
+
+  return tm;
+}
+
+gboolean
+tile_manager_map_file (TileManager *tm,
+                       gint         tile_num,
+                       GMappedFile *file,
+                       goffset      offset)
+{
+  Tile *tile;
+
+  g_return_val_if_fail (tm != NULL, FALSE);
+  g_return_val_if_fail (file != NULL, FALSE);
+  g_return_val_if_fail (offset >= 0, FALSE);
+
+  /*  doesn't lock the tile  */
+  tile = tile_manager_get (tm, tile_num, FALSE, FALSE);
+
+  g_return_val_if_fail (tile != NULL, FALSE);
+  g_return_val_if_fail (tile->data == NULL && ! tile->valid, FALSE);
+
+  if (g_mapped_file_get_length (file) < offset + tile->size)
+    return FALSE;
+
+  tile->data   = (guchar *) g_mapped_file_get_contents (file) + offset;
+  tile->mapped = g_mapped_file_ref (file);
+  tile->valid  = TRUE;
+
+  return TRUE;
+}
+
+gboolean
+tile_manager_save_mapped (TileManager *tm,
+                          const gchar *filename,
+                          GError     **error)
+{
+  FILE *fp;
+  gint  n_tiles;
+  gint  i;
+
+  g_return_val_if_fail (tm != NULL, FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  fp = g_fopen (filename, "wb");
+
+  if (! fp)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   _("Could not open '%s' for writing: %s"),
+                   gimp_filename_to_utf8 (filename), g_strerror (errno));
+      return FALSE;
+    }
+
+  n_tiles = tm->ntile_rows * tm->ntile_cols;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      Tile   *tile = tile_manager_get (tm, i, TRUE, FALSE);
+      size_t  n    = fwrite (tile->data, tile->size, 1, fp);
+
+      tile_release (tile, FALSE);
+
+      if (n != 1)
+        break;
+    }
+
+  if (i < n_tiles || fclose (fp) != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errno),
+                   _("Error writing '%s': %s"),
+                   gimp_filename_to_utf8 (filename), g_strerror (errno));
+
+      if (i < n_tiles)
+        fclose (fp);
+
+      g_unlink (filename);
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*  Replaces the view with a private copy of the data.  */
+void
+tile_mapped_detach (Tile *tile)
+{
+  GMappedFile  *file = tile->mapped;
+  const guchar *view = tile->data;
+
+  g_return_if_fail (file != NULL);
+
+  tile->data   = NULL;
+  tile->mapped = NULL;
+
+  tile_alloc (tile);
+  memcpy (tile->data, view, tile->size);
+
+  g_mapped_file_unref (file);
+}
+
+/*  Drops the view without copying, for tiles which are destroyed or
+ *  invalidated.
+ */
+void
+tile_mapped_release (Tile *tile)
+{
+  g_return_if_fail (tile->mapped != NULL);
+
+  g_mapped_file_unref (tile->mapped);
+
+  tile->data   = NULL;
+  tile->mapped = NULL;
+}
+
+/*  Called by the tile cache instead of swapping the tile out.  The
+ *  view stays valid, its pages are read back from the file when the
+ *  tile is used again.
+ */
+void
+tile_mapped_evict (Tile *tile)
+{
+#if defined (HAVE_MMAP) && defined (MADV_DONTNEED)
+  static gsize page_size = 0;
+  gsize        start;
+  gsize        end;
+
+  if (! page_size)
+    page_size = sysconf (_SC_PAGESIZE);
+
+  /*  only the pages which belong to this tile alone  */
+  start = ((gsize) tile->data + page_size - 1) & ~(page_size - 1);
+  end   = ((gsize) tile->data + tile->size) & ~(page_size - 1);
+
+  if (end > start)
+    madvise ((gpointer) start, end - start, MADV_DONTNEED);
+#endif
+}
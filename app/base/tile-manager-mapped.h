@@ -0,0 +1,56 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_MANAGER_MAPPED_H__
+#define __TILE_MANAGER_MAPPED_H__
+
+
+/*  A tile file holds the tiles of an image in row-major tile order,
+ *  each one as ewidth * eheight * bpp bytes of uncompressed pixel
+ *  data, starting at @offset.  tile_manager_new_mapped() maps such a
+ *  file read-only and makes the tiles views into it; they are turned
+ *  into ordinary tiles when they are written to.
+ */
+TileManager * tile_manager_new_mapped  (const gchar *filename,
+                                        goffset      offset,
+                                        gint         width,
+                                        gint         height,
+                                        gint         bpp,
+                                        GError     **error);
+
+gboolean      tile_manager_save_mapped (TileManager *tm,
+                                        const gchar *filename,
+                                        GError     **error);
+
+/*  Makes tile @tile_num of @tm, which must not have been used yet, a
+ *  view into @file at @offset.  For file loaders which find a tile
+ *  stored uncompressed; returns FALSE if @file is too short.
+ */
+gboolean      tile_manager_map_file    (TileManager *tm,
+                                        gint         tile_num,
+                                        GMappedFile *file,
+                                        goffset      offset);
+
+
+/*  for the tile code only  */
+
+void          tile_mapped_detach       (Tile        *tile);
+void          tile_mapped_release      (Tile        *tile);
+void          tile_mapped_evict        (Tile        *tile);
+
+
+#endif /* __TILE_MANAGER_MAPPED_H__ */
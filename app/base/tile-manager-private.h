@@ -37,6 +37,9 @@ struct _TileManager
 
   gint               cached_num;    /*  number of cached tile                */
   Tile              *cached_tile;   /*  the actual cached tile               */
+
+  TileStats         *stats;         /*  see tile-stats.c, NULL until the     *
+                                     *  first event is recorded              */
 };
 
 
@@ -25,20 +25,18 @@
 
 #include "tile.h"
 #include "tile-cache.h"
+#include "tile-compress.h"
 #include "tile-manager.h"
+#include "tile-manager-mapped.h"
 #include "tile-manager-private.h"
 #include "tile-rowhints.h"
+#include "tile-stats.h"
 #include "tile-swap.h"
 #include "tile-private.h"
 
 
 static void  tile_manager_allocate_tiles (TileManager *tm);
 
-#ifdef TILE_PROFILING
-extern gint tile_exist_peak;
-extern gint tile_exist_count;
-#endif
-
 #ifdef GIMP_UNSTABLE
 GList *tile_managers = NULL;
 #endif
@@ -122,8 +120,12 @@ tile_manager_ref (TileManager *tm)
 {
   g_return_val_if_fail (tm != NULL, NULL);
 
+  TILE_ACCESS_LOCK;
+
   tm->ref_count++;
 
+  TILE_ACCESS_UNLOCK;
+
   return tm;
 }
 
@@ -132,6 +134,8 @@ tile_manager_unref (TileManager *tm)
 {
   g_return_if_fail (tm != NULL);
 
+  TILE_ACCESS_LOCK;
+
   tm->ref_count--;
 
 //  g_print("tile_manager_unref<");
@@ -155,9 +159,13 @@ tile_manager_unref (TileManager *tm)
           g_free (tm->tiles);
         }
 
+      tile_stats_free (tm);
+
       g_slice_free (TileManager, tm);
     }
 //  g_print(">tile_manager_unref\n");
+
+  TILE_ACCESS_UNLOCK;
 }
 
 TileManager *
@@ -228,6 +236,8 @@ tile_manager_get (TileManager *tm,
   if ((tile_num < 0) || (tile_num >= ntiles))
     return NULL;
 
+  TILE_ACCESS_LOCK;
+
 //  g_print("  g<");
   if (! tm->tiles)
     tile_manager_allocate_tiles (tm);
@@ -259,18 +269,19 @@ tile_manager_get (TileManager *tm,
               /* Copy-on-write required */
               Tile *new = tile_new (tile->bpp);
 
+              if (G_UNLIKELY (tile_stats_active))
+                tile_stats_record_cow_split (tm);
+
               new->ewidth  = tile->ewidth;
               new->eheight = tile->eheight;
               new->valid   = tile->valid;
 
               new->size    = new->ewidth * new->eheight * new->bpp;
-              new->data    = g_new (guchar, new->size);
 
-#ifdef TILE_PROFILING
-              tile_exist_count++;
-              if (tile_exist_count > tile_exist_peak)
-                tile_exist_peak = tile_exist_count;
-#endif
+              new->summary = tile->summary;
+              memcpy (new->pixel, tile->pixel, sizeof (new->pixel));
+
+              tile_alloc (new);
 
               if (tile->rowhint)
                 {
@@ -300,6 +311,11 @@ tile_manager_get (TileManager *tm,
 
 	  /* must lock before marking dirty */
 	  tile_lock (tile);
+
+          /* the mapping is read-only, write to a private copy */
+          if (tile->mapped)
+            tile_mapped_detach (tile);
+
           tile->write_count++;
           tile->dirty = TRUE;
         }
@@ -314,6 +330,8 @@ tile_manager_get (TileManager *tm,
     }
 //  g_print(">  ");
 
+  TILE_ACCESS_UNLOCK;
+
   return tile;
 }
 
@@ -344,6 +362,9 @@ tile_manager_validate_tile (TileManager *tm,
 
   tile->valid = TRUE;
 
+  if (G_UNLIKELY (tile_stats_active))
+    tile_stats_record_fault (tm);
+
   if (tm->validate_proc)
     {
       (* tm->validate_proc) (tm, tile, tm->user_data);
@@ -352,6 +373,12 @@ tile_manager_validate_tile (TileManager *tm,
     {
       /*  Set the contents of the tile to empty  */
       memset (tile->data, 0, tile_size (tile));
+
+      tile->summary = TILE_SUMMARY_VALID | TILE_SUMMARY_UNIFORM;
+      memset (tile->pixel, 0, sizeof (tile->pixel));
+
+      if (tile->bpp == 2 || tile->bpp == 4)
+        tile->summary |= TILE_SUMMARY_TRANSPARENT;
     }
 
 #ifdef DEBUG_TILE_MANAGER
@@ -432,17 +459,29 @@ tile_manager_invalidate_tile (TileManager  *tm,
       tm->tiles[tile_num] = tile;
     }
 
-  tile->valid = FALSE;
+  tile->valid   = FALSE;
+  tile->summary = 0;
 
-  if (tile->data)
+  if (tile->rowhint)
     {
-      g_free (tile->data);
-      tile->data = NULL;
-#ifdef TILE_PROFILING
-      tile_exist_count--;
-#endif
+      gint y;
+
+      for (y = 0; y < tile->eheight; y++)
+        tile->rowhint[y] = TILEROWHINT_UNKNOWN;
     }
 
+  if (tile->mapped)
+    {
+      tile_mapped_release (tile);
+    }
+  else
+    {
+      tile_free (tile);
+    }
+
+  if (tile->compressed)
+    tile_compress_drop (tile);
+
   if (tile->swap_offset != -1)
     {
       /* If the tile is on disk, then delete its
@@ -491,6 +530,8 @@ tile_manager_map (TileManager *tm,
   g_return_if_fail (tile_num >= 0);
   g_return_if_fail (tile_num < tm->ntile_rows * tm->ntile_cols);
 
+  TILE_ACCESS_LOCK;
+
 //  g_print("tile_manager_map<");
   if (G_UNLIKELY (! tm->tiles))
     {
@@ -534,6 +575,8 @@ tile_manager_map (TileManager *tm,
 #ifdef DEBUG_TILE_MANAGER
   g_printerr ("}\n");
 #endif
+
+  TILE_ACCESS_UNLOCK;
 }
 
 void
@@ -550,11 +593,15 @@ tile_manager_invalidate_area (TileManager *tm,
   if (! tm->tiles)
     return;
 
+  TILE_ACCESS_LOCK;
+
   for (i = y; i < (y + h); i += (TILE_HEIGHT - (i % TILE_HEIGHT)))
     for (j = x; j < (x + w); j += (TILE_WIDTH - (j % TILE_WIDTH)))
       {
         tile_manager_invalidate_pixel (tm, j, i);
       }
+
+  TILE_ACCESS_UNLOCK;
 }
 
 gint
@@ -653,8 +700,12 @@ tile_manager_get_tile_col_row (TileManager *tm,
   g_return_if_fail (tile != NULL);
   g_return_if_fail (tile_col != NULL && tile_row != NULL);
 
+  TILE_ACCESS_LOCK;
+
   tile_num = tile_manager_locate_tile (tm, tile);
 
+  TILE_ACCESS_UNLOCK;
+
   *tile_col = tile_num % tm->ntile_cols;
   *tile_row = tile_num / tm->ntile_cols;
 }
@@ -689,6 +740,8 @@ tile_manager_map_over_tile (TileManager *tm,
   g_return_if_fail (tile != NULL);
   g_return_if_fail (srctile != NULL);
 
+  TILE_ACCESS_LOCK;
+
   for (tl = tile->tlink; tl; tl = tl->next)
     {
       if (tl->tm == tm)
@@ -696,12 +749,11 @@ tile_manager_map_over_tile (TileManager *tm,
     }
 
   if (G_UNLIKELY (tl == NULL))
-    {
-      g_warning ("%s: tile not attached to manager", G_STRLOC);
-      return;
-    }
+    g_warning ("%s: tile not attached to manager", G_STRLOC);
+  else
+    tile_manager_map (tm, tl->tile_num, srctile);
 
-  tile_manager_map (tm, tl->tile_num, srctile);
+  TILE_ACCESS_UNLOCK;
 }
 
 void
@@ -799,6 +851,8 @@ tile_manager_read_pixel_data_1 (TileManager *tm,
   if (num < 0)
     return;
 
+  TILE_ACCESS_LOCK;
+
   if (num != tm->cached_num)    /* must fetch a new tile */
     {
       Tile *tile;
@@ -818,6 +872,12 @@ tile_manager_read_pixel_data_1 (TileManager *tm,
        */
       tile = tile_manager_get (tm, num, TRUE, FALSE);
 
+      /*  the tile access lock is released while the tile is
+       *  validated, another thread may have cached a tile meanwhile
+       */
+      if (tm->cached_tile)
+        tile_release (tm->cached_tile, FALSE);
+
       tm->cached_num  = num;
       tm->cached_tile = tile;
     }
@@ -837,6 +897,8 @@ tile_manager_read_pixel_data_1 (TileManager *tm,
         *buffer++ = *src++;
       }
   }
+
+  TILE_ACCESS_UNLOCK;
 }
 
 void
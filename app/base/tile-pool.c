@@ -0,0 +1,409 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  A slab allocator for tile data.  Full tiles of each number of bytes
+ *  per pixel have a size class of their own.  Edge tiles are smaller,
+ *  their classes go in steps of 1 KiB, and of 256 and 512 bytes below
+ *  that, so an edge tile wastes less than 1 KiB and the tile cache,
+ *  which charges tiles their size, stays close to the memory really
+ *  used.  Blocks are carved out of slabs which are mapped from the
+ *  system directly where possible, so the memory of a slab goes back
+ *  to the system as soon as all of its blocks are freed instead of
+ *  fragmenting the heap.  One completely free slab per class is kept
+ *  around to avoid mapping and unmapping slabs all the time.
+ *
+ *  With ENABLE_MP, every thread has a small magazine of blocks per
+ *  class in front of the slabs, which is refilled or flushed half at
+ *  a time, so most allocations don't need the pool lock.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#undef G_DISABLE_DEPRECATED /* GStaticMutex, GStaticPrivate */
+
+#include <glib-object.h>
+
+#include "base-types.h"
+
+#include "tile.h"
+#include "tile-pool.h"
+
+
+#define TILE_POOL_MAX_SIZE       (TILE_WIDTH * TILE_HEIGHT * 4)
+#define TILE_POOL_N_CLASSES      (2 + TILE_POOL_MAX_SIZE / 1024)
+#define TILE_POOL_SLAB_BYTES     (256 * 1024)
+#define TILE_POOL_MAGAZINE_SIZE  16
+
+/*  in front of every block, keeps the data 16 byte aligned  */
+#define TILE_POOL_HEADER_SIZE    16
+
+/*  256 and 512 bytes, then 1 KiB steps up to a full 4 bpp tile  */
+#define TILE_POOL_CLASS(size)    ((size) <= 256 ? 0 :                   \
+                                  (size) <= 512 ? 1 :                   \
+                                  1 + ((size) + 1023) / 1024)
+#define TILE_POOL_BLOCK_SIZE(c)  ((c) < 2 ? 256 << (c) : ((c) - 1) * 1024)
+
+#define TILE_POOL_SLAB_BLOCKS(c) MAX (8, TILE_POOL_SLAB_BYTES /        \
+                                      (TILE_POOL_HEADER_SIZE +         \
+                                       TILE_POOL_BLOCK_SIZE (c)))
+#define TILE_POOL_SLAB_SIZE(c)   (TILE_POOL_SLAB_BLOCKS (c) *           \
+                                  (TILE_POOL_HEADER_SIZE +              \
+                                   TILE_POOL_BLOCK_SIZE (c)))
+
+#if defined (HAVE_MMAP) && ! defined (MAP_ANONYMOUS) && defined (MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+
+typedef struct _TilePoolSlab     TilePoolSlab;
+typedef struct _TilePoolClass    TilePoolClass;
+typedef struct _TilePoolMagazine TilePoolMagazine;
+
+struct _TilePoolSlab
+{
+  gint          klass;
+  guchar       *memory;
+  gpointer      free_blocks;  /*  linked through the blocks' data  */
+  gint          n_free;
+
+  TilePoolSlab *prev;         /*  in the list of slabs with free blocks  */
+  TilePoolSlab *next;
+};
+
+struct _TilePoolClass
+{
+  TilePoolSlab *partial;      /*  slabs with free blocks                 */
+  TilePoolSlab *spare;        /*  a completely free slab kept around     */
+  gint          n_slabs;      /*  including the spare one                */
+  gint          n_used;       /*  blocks not on any slab's free list     */
+};
+
+struct _TilePoolMagazine
+{
+  gint          n_blocks;
+  gpointer      blocks[TILE_POOL_MAGAZINE_SIZE];
+};
+
+
+static gpointer        tile_pool_class_alloc    (gint          klass);
+static void            tile_pool_class_free     (gpointer      block);
+
+static TilePoolSlab  * tile_pool_slab_new       (gint          klass);
+static void            tile_pool_slab_free      (TilePoolSlab *slab);
+static void            tile_pool_slab_unlink    (TilePoolSlab *slab);
+
+#ifdef ENABLE_MP
+static TilePoolMagazine * tile_pool_get_magazines  (void);
+static void               tile_pool_magazines_free (TilePoolMagazine *magazines);
+#endif
+
+
+static TilePoolClass  classes[TILE_POOL_N_CLASSES] = { { NULL, }, };
+
+#ifdef ENABLE_MP
+
+static GStaticMutex   pool_mutex    = G_STATIC_MUTEX_INIT;
+static GStaticPrivate magazines_key = G_STATIC_PRIVATE_INIT;
+
+#define TILE_POOL_LOCK    g_static_mutex_lock (&pool_mutex)
+#define TILE_POOL_UNLOCK  g_static_mutex_unlock (&pool_mutex)
+
+#else
+
+#define TILE_POOL_LOCK    /* nothing */
+#define TILE_POOL_UNLOCK  /* nothing */
+
+#endif
+
+
+gpointer
+tile_pool_alloc (gint size)
+{
+  const gint  klass = TILE_POOL_CLASS (size);
+  guchar     *block;
+
+  g_return_val_if_fail (size > 0, NULL);
+  g_return_val_if_fail (size <= TILE_POOL_MAX_SIZE, NULL);
+
+#ifdef ENABLE_MP
+  {
+    TilePoolMagazine *magazine = &tile_pool_get_magazines ()[klass];
+
+    if (magazine->n_blocks == 0)
+      {
+        TILE_POOL_LOCK;
+
+        while (magazine->n_blocks < TILE_POOL_MAGAZINE_SIZE / 2)
+          magazine->blocks[magazine->n_blocks++] =
+            tile_pool_class_alloc (klass);
+
+        TILE_POOL_UNLOCK;
+      }
+
+    block = magazine->blocks[--magazine->n_blocks];
+  }
+#else
+  block = tile_pool_class_alloc (klass);
+#endif
+
+  return block + TILE_POOL_HEADER_SIZE;
+}
+
+void
+tile_pool_free (gpointer data)
+{
+  guchar *block;
+
+  if (! data)
+    return;
+
+  block = (guchar *) data - TILE_POOL_HEADER_SIZE;
+
+#ifdef ENABLE_MP
+  {
+    TilePoolSlab     *slab     = *(TilePoolSlab **) block;
+    TilePoolMagazine *magazine = &tile_pool_get_magazines ()[slab->klass];
+
+    if (magazine->n_blocks == TILE_POOL_MAGAZINE_SIZE)
+      {
+        TILE_POOL_LOCK;
+
+        while (magazine->n_blocks > TILE_POOL_MAGAZINE_SIZE / 2)
+          tile_pool_class_free (magazine->blocks[--magazine->n_blocks]);
+
+        TILE_POOL_UNLOCK;
+      }
+
+    magazine->blocks[magazine->n_blocks++] = block;
+  }
+#else
+  tile_pool_class_free (block);
+#endif
+}
+
+void
+tile_pool_get_stats (TilePoolStats *stats)
+{
+  gint i;
+
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof (TilePoolStats));
+
+  TILE_POOL_LOCK;
+
+  for (i = 0; i < TILE_POOL_N_CLASSES; i++)
+    {
+      stats->size    += (guint64) classes[i].n_slabs * TILE_POOL_SLAB_SIZE (i);
+      stats->used    += (guint64) classes[i].n_used * TILE_POOL_BLOCK_SIZE (i);
+      stats->n_slabs += classes[i].n_slabs;
+    }
+
+  TILE_POOL_UNLOCK;
+}
+
+
+/*  private functions  */
+
+/*  Called with the pool locked.  */
+static gpointer
+tile_pool_class_alloc (gint klass)
+{
+  TilePoolClass *pool_class = &classes[klass];
+  TilePoolSlab  *slab       = pool_class->partial;
+  gpointer       block;
+
+  if (! slab)
+    {
+      if (pool_class->spare)
+        {
+          slab = pool_class->spare;
+          pool_class->spare = NULL;
+        }
+      else
+        {
+          slab = tile_pool_slab_new (klass);
+        }
+
+      pool_class->partial = slab;
+    }
+
+  block = slab->free_blocks;
+
+  slab->free_blocks = *(gpointer *) ((guchar *) block + TILE_POOL_HEADER_SIZE);
+  slab->n_free--;
+
+  if (slab->n_free == 0)
+    tile_pool_slab_unlink (slab);
+
+  pool_class->n_used++;
+
+  return block;
+}
+
+/*  Called with the pool locked.  */
+static void
+tile_pool_class_free (gpointer block)
+{
+  TilePoolSlab  *slab       = *(TilePoolSlab **) block;
+  TilePoolClass *pool_class = &classes[slab->klass];
+
+  *(gpointer *) ((guchar *) block + TILE_POOL_HEADER_SIZE) = slab->free_blocks;
+
+  slab->free_blocks = block;
+  slab->n_free++;
+
+  pool_class->n_used--;
+
+  if (slab->n_free == 1)
+    {
+      /*  the slab was full, it has a free block again  */
+      slab->prev = NULL;
+      slab->next = pool_class->partial;
+
+      if (slab->next)
+        slab->next->prev = slab;
+
+      pool_class->partial = slab;
+    }
+  else if (slab->n_free == TILE_POOL_SLAB_BLOCKS (slab->klass))
+    {
+      tile_pool_slab_unlink (slab);
+
+      if (pool_class->spare)
+        tile_pool_slab_free (slab);
+      else
+        pool_class->spare = slab;
+    }
+}
+
+static TilePoolSlab *
+tile_pool_slab_new (gint klass)
+{
+  TilePoolSlab *slab       = g_slice_new0 (TilePoolSlab);
+  const gsize   block_size = TILE_POOL_HEADER_SIZE + TILE_POOL_BLOCK_SIZE (klass);
+  gint          i;
+
+  slab->klass = klass;
+
+#if defined (HAVE_MMAP) && defined (MAP_ANONYMOUS)
+  slab->memory = mmap (NULL, TILE_POOL_SLAB_SIZE (klass),
+                       PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1, 0);
+
+  if (slab->memory == MAP_FAILED)
+    g_error ("%s: failed to map %d bytes",
+             G_STRLOC, TILE_POOL_SLAB_SIZE (klass));
+#else
+  slab->memory = g_malloc (TILE_POOL_SLAB_SIZE (klass));
+#endif
+
+  /*  link the blocks in order, so they are handed out front to back  */
+  for (i = TILE_POOL_SLAB_BLOCKS (klass) - 1; i >= 0; i--)
+    {
+      guchar *block = slab->memory + i * block_size;
+
+      *(TilePoolSlab **) block = slab;
+      *(gpointer *) (block + TILE_POOL_HEADER_SIZE) = slab->free_blocks;
+
+      slab->free_blocks = block;
+    }
+
+  slab->n_free = TILE_POOL_SLAB_BLOCKS (klass);
+
+  classes[klass].n_slabs++;
+
+  return slab;
+}
+
+static void
+tile_pool_slab_free (TilePoolSlab *slab)
+{
+  classes[slab->klass].n_slabs--;
+
+#if defined (HAVE_MMAP) && defined (MAP_ANONYMOUS)
+  munmap (slab->memory, TILE_POOL_SLAB_SIZE (slab->klass));
+#else
+  g_free (slab->memory);
+#endif
+
+  g_slice_free (TilePoolSlab, slab);
+}
+
+/*  Removes @slab from the list of slabs with free blocks.  */
+static void
+tile_pool_slab_unlink (TilePoolSlab *slab)
+{
+  TilePoolClass *pool_class = &classes[slab->klass];
+
+  if (slab->prev)
+    slab->prev->next = slab->next;
+  else
+    pool_class->partial = slab->next;
+
+  if (slab->next)
+    slab->next->prev = slab->prev;
+
+  slab->prev = slab->next = NULL;
+}
+
+#ifdef ENABLE_MP
+
+static TilePoolMagazine *
+tile_pool_get_magazines (void)
+{
+  TilePoolMagazine *magazines = g_static_private_get (&magazines_key);
+
+  if (G_UNLIKELY (! magazines))
+    {
+      magazines = g_new0 (TilePoolMagazine, TILE_POOL_N_CLASSES);
+
+      g_static_private_set (&magazines_key, magazines,
+                            (GDestroyNotify) tile_pool_magazines_free);
+    }
+
+  return magazines;
+}
+
+/*  Returns the blocks cached by an exiting thread.  */
+static void
+tile_pool_magazines_free (TilePoolMagazine *magazines)
+{
+  gint i;
+
+  TILE_POOL_LOCK;
+
+  for (i = 0; i < TILE_POOL_N_CLASSES; i++)
+    {
+      TilePoolMagazine *magazine = &magazines[i];
+
+      while (magazine->n_blocks > 0)
+        tile_pool_class_free (magazine->blocks[--magazine->n_blocks]);
+    }
+
+  TILE_POOL_UNLOCK;
+
+  g_free (magazines);
+}
+
+#endif /* ENABLE_MP */
@@ -0,0 +1,42 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_POOL_H__
+#define __TILE_POOL_H__
+
+
+typedef struct _TilePoolStats TilePoolStats;
+
+struct _TilePoolStats
+{
+  guint64  size;          /*  memory held in slabs                       */
+  guint64  used;          /*  memory in blocks handed out, including     *
+                           *  the ones cached per thread                 */
+  gint     n_slabs;
+};
+
+
+/*  The pool allocates the pixel data of tiles, @size must not be
+ *  larger than that of a full 4 bpp tile.
+ */
+gpointer  tile_pool_alloc     (gint           size);
+void      tile_pool_free      (gpointer       data);
+
+void      tile_pool_get_stats (TilePoolStats *stats);
+
+
+#endif /* __TILE_POOL_H__ */
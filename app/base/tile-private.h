@@ -23,7 +23,35 @@
 /*  #define TILE_PROFILING */
 
 
-typedef struct _TileLink TileLink;
+/*  Flags of the summary of a tile's data, see tile_is_uniform()  */
+#define TILE_SUMMARY_VALID        (1 << 0)
+#define TILE_SUMMARY_UNIFORM      (1 << 1)
+#define TILE_SUMMARY_TRANSPARENT  (1 << 2)
+
+
+/*  The tile access lock serializes the bookkeeping of all tiles and
+ *  tile managers: reference, write and share counts, tile links, the
+ *  tiles of a manager and its cached tile.  It makes locking tiles
+ *  safe from any thread.  It is recursive, and it is not held while a
+ *  tile is validated, see tile_validate().
+ */
+#ifdef ENABLE_MP
+
+extern GStaticRecMutex tile_access_mutex;
+
+#define TILE_ACCESS_LOCK    g_static_rec_mutex_lock (&tile_access_mutex)
+#define TILE_ACCESS_UNLOCK  g_static_rec_mutex_unlock (&tile_access_mutex)
+
+#else
+
+#define TILE_ACCESS_LOCK    /* nothing */
+#define TILE_ACCESS_UNLOCK  /* nothing */
+
+#endif
+
+
+typedef struct _TileLink       TileLink;
+typedef struct _TileCompressed TileCompressed;
 
 struct _TileLink
 {
@@ -75,6 +103,11 @@ struct _Tile
 
   TileRowHint *rowhint; /* An array of hints for rendering purposes */
 
+  guchar  summary;      /* TILE_SUMMARY flags, updated when the last
+                         *  writer releases the tile
+                         */
+  guchar  pixel[4];     /* the pixel all pixels of a uniform tile are */
+
   guchar *data;         /* the data for the tile. this may be NULL in which
                          *  case the tile data is on disk.
                          */
@@ -84,6 +117,15 @@ struct _Tile
                          * to -1.
                          */
 
+  TileCompressed *compressed; /* the compressed tile data if the tile was
+                               * evicted to the compressed tier, see
+                               * tile-compress.c
+                               */
+
+  GMappedFile    *mapped;     /* the file "data" is a read-only view into,
+                               * see tile-manager-mapped.c
+                               */
+
   TileLink *tlink;
 
   Tile     *next;       /* List pointers for the tile cache lists */
@@ -17,13 +17,19 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "base-types.h"
 
+#include "box-filter.h"
+#include "pixel-processor.h"
 #include "tile.h"
 #include "tile-manager.h"
+#include "tile-manager-private.h"
 #include "tile-pyramid.h"
+#include "tile-stats.h"
 
 
 #define PYRAMID_MAX_LEVELS  10
@@ -37,17 +43,40 @@ struct _TilePyramid
   gint           bytes;
   TileManager   *tiles[PYRAMID_MAX_LEVELS];
   gint           top_level;
+
+  /*  Upper level tiles are not invalidated when the area below them
+   *  changes, they keep their old contents and are marked dirty
+   *  instead, until tile_pyramid_update() gets to them.
+   */
+  guchar        *dirty[PYRAMID_MAX_LEVELS];    /*  one flag per tile      */
+  gint           n_dirty[PYRAMID_MAX_LEVELS];
+};
+
+typedef struct _TilePyramidUpdate TilePyramidUpdate;
+
+struct _TilePyramidUpdate
+{
+  gint  level;
+  Tile *dest;
+  Tile *src[4];     /*  left to right, top to bottom  */
 };
 
 
 static gint  tile_pyramid_alloc_levels        (TilePyramid *pyramid,
                                                gint         top_level);
+static gint  tile_pyramid_find_level         (TilePyramid *pyramid,
+                                               TileManager *tm);
+static void  tile_pyramid_set_dirty           (TilePyramid *pyramid,
+                                               gint         level,
+                                               gint         tile_num);
 static void  tile_pyramid_validate_tile       (TileManager *tm,
                                                Tile        *tile,
-                                               TileManager *tm_below);
+                                               TilePyramid *pyramid);
 static void  tile_pyramid_validate_upper_tile (TileManager *tm,
                                                Tile        *tile,
-                                               TileManager *tm_below);
+                                               TilePyramid *pyramid);
+static void  tile_pyramid_update_tile         (TilePyramidUpdate *updates,
+                                               gint               item);
 
 static void  tile_pyramid_write_quarter       (Tile        *dest,
                                                Tile        *src,
@@ -57,6 +86,12 @@ static void  tile_pyramid_write_upper_quarter (Tile        *dest,
                                                Tile        *src,
                                                const gint   i,
                                                const gint   j);
+static gboolean tile_pyramid_write_uniform_quarter
+                                              (Tile               *dest,
+                                               Tile               *src,
+                                               const gint          i,
+                                               const gint          j,
+                                               BoxFilterHalveFunc  halve);
 
 /**
  * tile_pyramid_new:
@@ -137,7 +172,10 @@ tile_pyramid_destroy (TilePyramid *pyramid)
   g_return_if_fail (pyramid != NULL);
 
   for (level = 0; level <= pyramid->top_level; level++)
-    tile_manager_unref (pyramid->tiles[level]);
+    {
+      tile_manager_unref (pyramid->tiles[level]);
+      g_free (pyramid->dirty[level]);
+    }
 
   g_slice_free (TilePyramid, pyramid);
 }
@@ -219,7 +257,10 @@ tile_pyramid_get_tiles (TilePyramid *pyramid,
  * @width:
  * @height:
  *
- * Invalidates the tiles in the given area on all levels.
+ * Invalidates the tiles in the given area on the bottom level.  The
+ * valid tiles above it on the upper levels keep their contents and
+ * are marked dirty, they are brought up to date by
+ * tile_pyramid_update().
  **/
 void
 tile_pyramid_invalidate_area (TilePyramid *pyramid,
@@ -237,21 +278,164 @@ tile_pyramid_invalidate_area (TilePyramid *pyramid,
   if (width == 0 || height == 0)
     return;
 
-  for (level = 0; level <= pyramid->top_level; level++)
+  tile_manager_invalidate_area (pyramid->tiles[0], x, y, width, height);
+
+  for (level = 1; level <= pyramid->top_level; level++)
     {
-      /* Tile invalidation must propagate all the way up in the pyramid,
-       * so keep width and height > 0.
+      TileManager *tm = pyramid->tiles[level];
+      gint         col1, col2;
+      gint         row1, row2;
+      gint         col, row;
+
+      /*  tiles which were never validated are left alone, they will be
+       *  validated from the level below when they are needed
        */
-      tile_manager_invalidate_area (pyramid->tiles[level],
-                                    x, y, MAX (width, 1), MAX (height, 1));
+      if (! tm->tiles)
+        continue;
+
+      col1 = (x >> level) / TILE_WIDTH;
+      row1 = (y >> level) / TILE_HEIGHT;
+      col2 = MIN (((x + width  - 1) >> level) / TILE_WIDTH,  tm->ntile_cols - 1);
+      row2 = MIN (((y + height - 1) >> level) / TILE_HEIGHT, tm->ntile_rows - 1);
+
+      for (row = row1; row <= row2; row++)
+        for (col = col1; col <= col2; col++)
+          {
+            const gint tile_num = row * tm->ntile_cols + col;
 
-      x      >>= 1;
-      y      >>= 1;
-      width  >>= 1;
-      height >>= 1;
+            if (tile_is_valid (tm->tiles[tile_num]))
+              tile_pyramid_set_dirty (pyramid, level, tile_num);
+          }
     }
 }
 
+/**
+ * tile_pyramid_update:
+ * @pyramid:   a #TilePyramid
+ * @max_tiles: the maximum number of tiles to update
+ * @x:         return location for the updated area, or %NULL
+ * @y:
+ * @width:
+ * @height:
+ *
+ * Brings up to @max_tiles dirty tiles up to date, starting with the
+ * lowest level which has any, so the levels above it are updated
+ * from current data later.  The tiles are locked and the bottom level
+ * tiles they are made from are validated in the calling thread, the
+ * downsampling is spread over the pixel processor's threads.
+ *
+ * Return value: %TRUE if any tiles were updated, in which case the
+ *               area they cover on the bottom level is returned
+ **/
+gboolean
+tile_pyramid_update (TilePyramid *pyramid,
+                     gint         max_tiles,
+                     gint        *x,
+                     gint        *y,
+                     gint        *width,
+                     gint        *height)
+{
+  TilePyramidUpdate *updates;
+  TileManager       *tm;
+  TileManager       *tm_below;
+  gint               n_updates = 0;
+  gint               n_tiles;
+  gint               x1 = G_MAXINT;
+  gint               y1 = G_MAXINT;
+  gint               x2 = 0;
+  gint               y2 = 0;
+  gint               level;
+  gint               i, k;
+
+  g_return_val_if_fail (pyramid != NULL, FALSE);
+  g_return_val_if_fail (max_tiles > 0, FALSE);
+
+  for (level = 1; level <= pyramid->top_level; level++)
+    if (pyramid->n_dirty[level] > 0)
+      break;
+
+  if (level > pyramid->top_level)
+    return FALSE;
+
+  tm       = pyramid->tiles[level];
+  tm_below = pyramid->tiles[level - 1];
+  n_tiles  = tm->ntile_rows * tm->ntile_cols;
+
+  updates = g_new (TilePyramidUpdate,
+                   MIN (max_tiles, pyramid->n_dirty[level]));
+
+  for (i = 0; i < n_tiles && n_updates < max_tiles; i++)
+    {
+      TilePyramidUpdate *update;
+      const gint         col = i % tm->ntile_cols;
+      const gint         row = i / tm->ntile_cols;
+
+      if (! pyramid->dirty[level][i])
+        continue;
+
+      pyramid->dirty[level][i] = FALSE;
+      pyramid->n_dirty[level]--;
+
+      update = &updates[n_updates++];
+
+      update->level = level;
+      update->dest  = tile_manager_get (tm, i, TRUE, TRUE);
+
+      for (k = 0; k < 4; k++)
+        update->src[k] = tile_manager_get_at (tm_below,
+                                              col * 2 + k % 2,
+                                              row * 2 + k / 2,
+                                              TRUE, FALSE);
+
+      x1 = MIN (x1, (col * TILE_WIDTH)        << level);
+      y1 = MIN (y1, (row * TILE_HEIGHT)       << level);
+      x2 = MAX (x2, ((col + 1) * TILE_WIDTH)  << level);
+      y2 = MAX (y2, ((row + 1) * TILE_HEIGHT) << level);
+    }
+
+  pixel_processor_process_items ((PixelProcessorItemFunc)
+                                 tile_pyramid_update_tile,
+                                 updates, n_updates);
+
+  for (i = 0; i < n_updates; i++)
+    {
+      tile_release (updates[i].dest, TRUE);
+
+      for (k = 0; k < 4; k++)
+        if (updates[i].src[k])
+          tile_release (updates[i].src[k], FALSE);
+    }
+
+  g_free (updates);
+
+  if (x)      *x      = x1;
+  if (y)      *y      = y1;
+  if (width)  *width  = MIN (x2, pyramid->width)  - x1;
+  if (height) *height = MIN (y2, pyramid->height) - y1;
+
+  return TRUE;
+}
+
+/**
+ * tile_pyramid_is_dirty:
+ * @pyramid: a #TilePyramid
+ *
+ * Return value: %TRUE if any tiles wait for tile_pyramid_update()
+ **/
+gboolean
+tile_pyramid_is_dirty (const TilePyramid *pyramid)
+{
+  gint level;
+
+  g_return_val_if_fail (pyramid != NULL, FALSE);
+
+  for (level = 1; level <= pyramid->top_level; level++)
+    if (pyramid->n_dirty[level] > 0)
+      return TRUE;
+
+  return FALSE;
+}
+
 /**
  * tile_pyramid_set_validate_proc:
  * @pyramid:   a #TilePyramid
@@ -327,7 +511,14 @@ tile_pyramid_get_memsize (const TilePyramid *pyramid)
   g_return_val_if_fail (pyramid != NULL, 0);
 
   for (level = 0; level <= pyramid->top_level; level++)
-    memsize += tile_manager_get_memsize (pyramid->tiles[level], TRUE);
+    {
+      TileManager *tm = pyramid->tiles[level];
+
+      memsize += tile_manager_get_memsize (tm, TRUE);
+
+      if (pyramid->dirty[level])
+        memsize += tm->ntile_rows * tm->ntile_cols;
+    }
 
   return memsize;
 }
@@ -366,20 +557,47 @@ tile_pyramid_alloc_levels (TilePyramid *pyramid,
       pyramid->top_level    = level;
       pyramid->tiles[level] = tile_manager_new (width, height, pyramid->bytes);
 
+      pyramid->dirty[level] = g_new0 (guchar,
+                                      pyramid->tiles[level]->ntile_rows *
+                                      pyramid->tiles[level]->ntile_cols);
+
       /* Use the level below to validate tiles. */
       if (level == 1)
         proc = (TileValidateProc) tile_pyramid_validate_tile;
       else
         proc = (TileValidateProc) tile_pyramid_validate_upper_tile;
 
-      tile_manager_set_validate_proc (pyramid->tiles[level],
-                                      proc,
-                                      pyramid->tiles[level - 1]);
+      tile_manager_set_validate_proc (pyramid->tiles[level], proc, pyramid);
     }
 
   return pyramid->top_level;
 }
 
+static gint
+tile_pyramid_find_level (TilePyramid *pyramid,
+                         TileManager *tm)
+{
+  gint level;
+
+  for (level = 1; level < pyramid->top_level; level++)
+    if (pyramid->tiles[level] == tm)
+      break;
+
+  return level;
+}
+
+static void
+tile_pyramid_set_dirty (TilePyramid *pyramid,
+                        gint         level,
+                        gint         tile_num)
+{
+  if (! pyramid->dirty[level][tile_num])
+    {
+      pyramid->dirty[level][tile_num] = TRUE;
+      pyramid->n_dirty[level]++;
+    }
+}
+
 /* This method is used to validate a pyramid tile from four tiles on
  * the base level.  It needs to pre-multiply the alpha channel because
  * upper levels are pre-multiplied.
@@ -387,11 +605,12 @@ tile_pyramid_alloc_levels (TilePyramid *pyramid,
 static void
 tile_pyramid_validate_tile (TileManager *tm,
                             Tile        *tile,
-                            TileManager *tm_below)
+                            TilePyramid *pyramid)
 {
-  gint  tile_col;
-  gint  tile_row;
-  gint  i, j;
+  TileManager *tm_below = pyramid->tiles[0];
+  gint         tile_col;
+  gint         tile_row;
+  gint         i, j;
 
   tile_manager_get_tile_col_row (tm, tile, &tile_col, &tile_row);
 
@@ -411,16 +630,20 @@ tile_pyramid_validate_tile (TileManager *tm,
 }
 
 /* This method is used to validate tiles in the upper pyramid levels.
- * Here all data has the alpha channel pre-multiplied.
+ * Here all data has the alpha channel pre-multiplied.  A tile made
+ * from dirty tiles is dirty itself.
  */
 static void
 tile_pyramid_validate_upper_tile (TileManager *tm,
                                   Tile        *tile,
-                                  TileManager *tm_below)
+                                  TilePyramid *pyramid)
 {
-  gint  tile_col;
-  gint  tile_row;
-  gint  i, j;
+  const gint   level    = tile_pyramid_find_level (pyramid, tm);
+  TileManager *tm_below = pyramid->tiles[level - 1];
+  gboolean     dirty    = FALSE;
+  gint         tile_col;
+  gint         tile_row;
+  gint         i, j;
 
   tile_manager_get_tile_col_row (tm, tile, &tile_col, &tile_row);
 
@@ -435,8 +658,85 @@ tile_pyramid_validate_upper_tile (TileManager *tm,
           {
             tile_pyramid_write_upper_quarter (tile, source, i, j);
             tile_release (source, FALSE);
+
+            if (pyramid->dirty[level - 1][(tile_row * 2 + j) *
+                                          tm_below->ntile_cols +
+                                          tile_col * 2 + i])
+              dirty = TRUE;
           }
       }
+
+  if (dirty)
+    tile_pyramid_set_dirty (pyramid, level,
+                            tile_row * tm->ntile_cols + tile_col);
+}
+
+/*  Called from the pixel processor's threads, for tiles which are
+ *  locked already.
+ */
+static void
+tile_pyramid_update_tile (TilePyramidUpdate *updates,
+                          gint               item)
+{
+  TilePyramidUpdate *update = &updates[item];
+  gint               k;
+
+  for (k = 0; k < 4; k++)
+    {
+      if (! update->src[k])
+        continue;
+
+      if (update->level == 1)
+        tile_pyramid_write_quarter (update->dest, update->src[k],
+                                    k % 2, k / 2);
+      else
+        tile_pyramid_write_upper_quarter (update->dest, update->src[k],
+                                          k % 2, k / 2);
+    }
+}
+
+/* Fill one quarter of the destination tile with the average of a
+ * uniform src tile, which is its pixel averaged with itself by @halve.
+ */
+static gboolean
+tile_pyramid_write_uniform_quarter (Tile               *dest,
+                                    Tile               *src,
+                                    const gint          i,
+                                    const gint          j,
+                                    BoxFilterHalveFunc  halve)
+{
+  guchar       pixels[2 * MAX_CHANNELS];
+  guchar       pixel[MAX_CHANNELS];
+  guchar      *dest_data   = tile_data_pointer (dest,
+                                                i * TILE_WIDTH / 2,
+                                                j * TILE_WIDTH / 2);
+  const gint   dest_ewidth = tile_ewidth (dest);
+  const gint   bpp         = tile_bpp    (dest);
+  gint         x, y;
+
+  if (! tile_is_uniform (src, pixels))
+    return FALSE;
+
+  memcpy (pixels + bpp, pixels, bpp);
+  halve (pixels, pixels, pixel, 1);
+
+  for (y = 0; y < tile_eheight (src) / 2; y++)
+    {
+      guchar *d = dest_data;
+
+      for (x = 0; x < tile_ewidth (src) / 2; x++)
+        {
+          memcpy (d, pixel, bpp);
+          d += bpp;
+        }
+
+      dest_data += dest_ewidth * bpp;
+    }
+
+  if (G_UNLIKELY (tile_stats_active))
+    tile_stats_record_uniform_skip (src);
+
+  return TRUE;
 }
 
 /* Average the src tile to one quarter of the destination tile.  The
@@ -449,142 +749,24 @@ tile_pyramid_write_quarter (Tile       *dest,
                             const gint  i,
                             const gint  j)
 {
-  const guchar *src_data    = tile_data_pointer (src, 0, 0);
-  guchar       *dest_data   = tile_data_pointer (dest,
-                                                 i * TILE_WIDTH / 2,
-                                                 j * TILE_WIDTH / 2);
-  const gint    src_ewidth  = tile_ewidth  (src);
-  const gint    src_eheight = tile_eheight (src);
-  const gint    dest_ewidth = tile_ewidth  (dest);
-  const gint    bpp         = tile_bpp     (dest);
-  gint          y;
+  const guchar       *src_data    = tile_data_pointer (src, 0, 0);
+  guchar             *dest_data   = tile_data_pointer (dest,
+                                                       i * TILE_WIDTH / 2,
+                                                       j * TILE_WIDTH / 2);
+  const gint          src_ewidth  = tile_ewidth  (src);
+  const gint          src_eheight = tile_eheight (src);
+  const gint          dest_ewidth = tile_ewidth  (dest);
+  const gint          bpp         = tile_bpp     (dest);
+  BoxFilterHalveFunc  halve       = box_filter_funcs.halve_premult[bpp - 1];
+  gint                y;
+
+  if (tile_pyramid_write_uniform_quarter (dest, src, i, j, halve))
+    return;
 
   for (y = 0; y < src_eheight / 2; y++)
     {
-      const guchar *src0 = src_data;
-      const guchar *src1 = src_data + bpp;
-      const guchar *src2 = src0 + bpp * src_ewidth;
-      const guchar *src3 = src1 + bpp * src_ewidth;
-      guchar       *dst  = dest_data;
-      gint          x;
-
-      switch (bpp)
-        {
-        case 1:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              dst[0] = (src0[0] + src1[0] + src2[0] + src3[0] + 2) >> 2;
-
-              dst += 1;
-
-              src0 += 2;
-              src1 += 2;
-              src2 += 2;
-              src3 += 2;
-            }
-          break;
-
-        case 2:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              const guint a = src0[1] + src1[1] + src2[1] + src3[1];
-
-              switch (a)
-                {
-                case 0:    /* all transparent */
-                  dst[0] = dst[1] = 0;
-                  break;
-
-                case 1020: /* all opaque */
-                  dst[0] = (src0[0]  + src1[0] + src2[0] + src3[0] + 2) >> 2;
-                  dst[1] = 255;
-                  break;
-
-                default:
-                  dst[0] = ((src0[0] * (src0[1] + 1) +
-                             src1[0] * (src1[1] + 1) +
-                             src2[0] * (src2[1] + 1) +
-                             src3[0] * (src3[1] + 1)) >> 10);
-                  dst[1] = (a + 2) >> 2;
-                  break;
-                }
-
-              dst += 2;
-
-              src0 += 4;
-              src1 += 4;
-              src2 += 4;
-              src3 += 4;
-            }
-          break;
-
-        case 3:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              dst[0] = (src0[0] + src1[0] + src2[0] + src3[0] + 2) >> 2;
-              dst[1] = (src0[1] + src1[1] + src2[1] + src3[1] + 2) >> 2;
-              dst[2] = (src0[2] + src1[2] + src2[2] + src3[2] + 2) >> 2;
-
-              dst += 3;
-
-              src0 += 6;
-              src1 += 6;
-              src2 += 6;
-              src3 += 6;
-            }
-          break;
-
-        case 4:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              const guint a = src0[3] + src1[3] + src2[3] + src3[3];
-
-              switch (a)
-                {
-                case 0:    /* all transparent */
-                  dst[0] = dst[1] = dst[2] = dst[3] = 0;
-                  break;
-
-                case 1020: /* all opaque */
-                  dst[0] = (src0[0] + src1[0] + src2[0] + src3[0] + 2) >> 2;
-                  dst[1] = (src0[1] + src1[1] + src2[1] + src3[1] + 2) >> 2;
-                  dst[2] = (src0[2] + src1[2] + src2[2] + src3[2] + 2) >> 2;
-                  dst[3] = 255;
-                  break;
-
-                default:
-                  {
-                    const guint a0 = src0[3] + 1;
-                    const guint a1 = src1[3] + 1;
-                    const guint a2 = src2[3] + 1;
-                    const guint a3 = src3[3] + 1;
-
-                    dst[0] = (src0[0] * a0 +
-                              src1[0] * a1 +
-                              src2[0] * a2 +
-                              src3[0] * a3) >> 10;
-                    dst[1] = (src0[1] * a0 +
-                              src1[1] * a1 +
-                              src2[1] * a2 +
-                              src3[1] * a3) >> 10;
-                    dst[2] = (src0[2] * a0 +
-                              src1[2] * a1 +
-                              src2[2] * a2 +
-                              src3[2] * a3) >> 10;
-                    dst[3] = (a + 2) >> 2;
-                  }
-                  break;
-                }
-
-              dst += 4;
-
-              src0 += 8;
-              src1 += 8;
-              src2 += 8;
-              src3 += 8;
-            }
-          break;
-        }
+      halve (src_data, src_data + src_ewidth * bpp,
+             dest_data, src_ewidth / 2);
 
       dest_data += dest_ewidth * bpp;
       src_data += src_ewidth * bpp * 2;
@@ -600,89 +782,24 @@ tile_pyramid_write_upper_quarter (Tile       *dest,
                                   const gint  i,
                                   const gint  j)
 {
-  const guchar *src_data    = tile_data_pointer (src, 0, 0);
-  guchar       *dest_data   = tile_data_pointer (dest,
-                                                 i * TILE_WIDTH / 2,
-                                                 j * TILE_WIDTH / 2);
-  const gint    src_ewidth  = tile_ewidth  (src);
-  const gint    src_eheight = tile_eheight (src);
-  const gint    dest_ewidth = tile_ewidth  (dest);
-  const gint    bpp         = tile_bpp     (dest);
-  gint          y;
+  const guchar       *src_data    = tile_data_pointer (src, 0, 0);
+  guchar             *dest_data   = tile_data_pointer (dest,
+                                                       i * TILE_WIDTH / 2,
+                                                       j * TILE_WIDTH / 2);
+  const gint          src_ewidth  = tile_ewidth  (src);
+  const gint          src_eheight = tile_eheight (src);
+  const gint          dest_ewidth = tile_ewidth  (dest);
+  const gint          bpp         = tile_bpp     (dest);
+  BoxFilterHalveFunc  halve       = box_filter_funcs.halve[bpp - 1];
+  gint                y;
+
+  if (tile_pyramid_write_uniform_quarter (dest, src, i, j, halve))
+    return;
 
   for (y = 0; y < src_eheight / 2; y++)
     {
-      const guchar *src0 = src_data;
-      const guchar *src1 = src_data + bpp;
-      const guchar *src2 = src0 + bpp * src_ewidth;
-      const guchar *src3 = src1 + bpp * src_ewidth;
-      guchar       *dst  = dest_data;
-      gint          x;
-
-      switch (bpp)
-        {
-        case 1:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              dst[0] = (src0[0] + src1[0] + src2[0] + src3[0] + 2) >> 2;
-
-              dst += 1;
-
-              src0 += 2;
-              src1 += 2;
-              src2 += 2;
-              src3 += 2;
-            }
-          break;
-
-        case 2:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              dst[0] = (src0[0] + src1[0] + src2[0] + src3[0] + 2) >> 2;
-              dst[1] = (src0[1] + src1[1] + src2[1] + src3[1] + 2) >> 2;
-
-              dst += 2;
-
-              src0 += 4;
-              src1 += 4;
-              src2 += 4;
-              src3 += 4;
-            }
-          break;
-
-        case 3:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              dst[0] = (src0[0] + src1[0] + src2[0] + src3[0] + 2) >> 2;
-              dst[1] = (src0[1] + src1[1] + src2[1] + src3[1] + 2) >> 2;
-              dst[2] = (src0[2] + src1[2] + src2[2] + src3[2] + 2) >> 2;
-
-              dst += 3;
-
-              src0 += 6;
-              src1 += 6;
-              src2 += 6;
-              src3 += 6;
-            }
-          break;
-
-        case 4:
-          for (x = 0; x < src_ewidth / 2; x++)
-            {
-              dst[0] = (src0[0] + src1[0] + src2[0] + src3[0] + 2) >> 2;
-              dst[1] = (src0[1] + src1[1] + src2[1] + src3[1] + 2) >> 2;
-              dst[2] = (src0[2] + src1[2] + src2[2] + src3[2] + 2) >> 2;
-              dst[3] = (src0[3] + src1[3] + src2[3] + src3[3] + 2) >> 2;
-
-              dst += 4;
-
-              src0 += 8;
-              src1 += 8;
-              src2 += 8;
-              src3 += 8;
-            }
-          break;
-        }
+      halve (src_data, src_data + src_ewidth * bpp,
+             dest_data, src_ewidth / 2);
 
       dest_data += dest_ewidth * bpp;
       src_data += src_ewidth * bpp * 2;
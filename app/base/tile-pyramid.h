@@ -47,6 +47,14 @@ void          tile_pyramid_invalidate_area   (TilePyramid       *pyramid,
                                               gint               width,
                                               gint               height);
 
+gboolean      tile_pyramid_update            (TilePyramid       *pyramid,
+                                              gint               max_tiles,
+                                              gint              *x,
+                                              gint              *y,
+                                              gint              *width,
+                                              gint              *height);
+gboolean      tile_pyramid_is_dirty          (const TilePyramid *pyramid);
+
 void          tile_pyramid_set_validate_proc (TilePyramid       *pyramid,
                                               TileValidateProc   proc,
                                               gpointer           user_data);
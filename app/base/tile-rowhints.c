@@ -261,3 +261,22 @@ tile_update_rowhints (Tile *tile,
       break;
     }
 }
+
+/*  Whether all pixels of the locked @tile are opaque.  The hints of
+ *  the rows written since they were last checked are updated first.
+ */
+gboolean
+tile_is_opaque (Tile *tile)
+{
+  gint y;
+
+  tile_update_rowhints (tile, 0, tile->eheight);
+
+  for (y = 0; y < tile->eheight; y++)
+    {
+      if (tile->rowhint[y] != TILEROWHINT_OPAQUE)
+        return FALSE;
+    }
+
+  return TRUE;
+}
@@ -43,6 +43,7 @@ void          tile_allocate_rowhints (Tile        *tile);
 void          tile_update_rowhints   (Tile        *tile,
                                       gint         start,
                                       gint         rows);
+gboolean      tile_is_opaque         (Tile        *tile);
 
 
 #endif /* __TILE_ROWHINTS_H__ */
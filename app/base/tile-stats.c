@@ -0,0 +1,317 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Runtime statistics of the tile system.  Unlike the TILE_PROFILING
+ *  counters these can be switched on and off in a running GIMP; while
+ *  they are off the only cost is a check of tile_stats_active at each
+ *  place that records something.  Events are accounted both globally
+ *  and to the tile manager which owns the tile (the first one, if the
+ *  tile is shared).
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base-types.h"
+
+#include "tile.h"
+#include "tile-manager.h"
+#include "tile-manager-private.h"
+#include "tile-rowhints.h"
+#include "tile-stats.h"
+#include "tile-private.h"
+
+
+typedef enum
+{
+  TILE_STATS_EVENT_LOCK,
+  TILE_STATS_EVENT_FAULT,
+  TILE_STATS_EVENT_COW_SPLIT,
+  TILE_STATS_EVENT_UNIFORM_SKIP,
+  TILE_STATS_EVENT_SWAP_IN,
+  TILE_STATS_EVENT_SWAP_OUT
+} TileStatsEvent;
+
+
+static void  tile_stats_record (TileManager    *tm,
+                                TileStatsEvent  event,
+                                gint            bytes,
+                                gint64          usecs);
+static void  tile_stats_add    (TileStats      *stats,
+                                TileStatsEvent  event,
+                                gint            bytes,
+                                gint            bucket);
+
+
+gboolean          tile_stats_active = FALSE;
+
+static TileStats  totals            = { 0, };
+static guint      generation        = 1;
+
+#ifdef ENABLE_MP
+
+static GMutex    *tile_stats_mutex  = NULL;
+
+#define TILE_STATS_LOCK    g_mutex_lock (tile_stats_mutex)
+#define TILE_STATS_UNLOCK  g_mutex_unlock (tile_stats_mutex)
+
+#else
+
+#define TILE_STATS_LOCK    /* nothing */
+#define TILE_STATS_UNLOCK  /* nothing */
+
+#endif
+
+
+void
+tile_stats_init (void)
+{
+#ifdef ENABLE_MP
+  g_return_if_fail (tile_stats_mutex == NULL);
+
+  tile_stats_mutex = g_mutex_new ();
+#endif
+
+  memset (&totals, 0, sizeof (totals));
+
+  totals.generation = generation;
+}
+
+void
+tile_stats_exit (void)
+{
+  tile_stats_active = FALSE;
+
+#ifdef ENABLE_MP
+  g_mutex_free (tile_stats_mutex);
+  tile_stats_mutex = NULL;
+#endif
+}
+
+void
+tile_stats_set_enabled (gboolean enabled)
+{
+  tile_stats_active = enabled ? TRUE : FALSE;
+}
+
+gboolean
+tile_stats_get_enabled (void)
+{
+  return tile_stats_active;
+}
+
+/*  Tile managers' statistics are reset lazily, when they are next
+ *  recorded to or looked at, by bumping the generation.
+ */
+void
+tile_stats_reset (void)
+{
+  TILE_STATS_LOCK;
+
+  generation++;
+
+  memset (&totals, 0, sizeof (totals));
+  totals.generation = generation;
+
+  TILE_STATS_UNLOCK;
+}
+
+void
+tile_stats_get_totals (TileStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  TILE_STATS_LOCK;
+
+  *stats = totals;
+
+  TILE_STATS_UNLOCK;
+}
+
+void
+tile_stats_get (TileManager *tm,
+                TileStats   *stats)
+{
+  g_return_if_fail (tm != NULL);
+  g_return_if_fail (stats != NULL);
+
+  TILE_STATS_LOCK;
+
+  if (tm->stats && tm->stats->generation == generation)
+    *stats = *tm->stats;
+  else
+    memset (stats, 0, sizeof (TileStats));
+
+  TILE_STATS_UNLOCK;
+}
+
+/*  Called by tile_manager_unref() when the tile manager goes away.
+ *  Its tiles are detached already, so nothing can record to it.
+ */
+void
+tile_stats_free (TileManager *tm)
+{
+  if (! tm->stats)
+    return;
+
+  TILE_STATS_LOCK;
+
+  g_slice_free (TileStats, tm->stats);
+  tm->stats = NULL;
+
+  TILE_STATS_UNLOCK;
+}
+
+/*  Returns the upper bound in microseconds of @bucket of the latency
+ *  histograms, or -1 for the last, unbounded, one.
+ */
+gint64
+tile_stats_bucket_limit (gint bucket)
+{
+  g_return_val_if_fail (bucket >= 0 && bucket < TILE_STATS_N_BUCKETS, -1);
+
+  if (bucket == TILE_STATS_N_BUCKETS - 1)
+    return -1;
+
+  return G_GINT64_CONSTANT (1) << bucket;
+}
+
+void
+tile_stats_record_lock (Tile *tile)
+{
+  tile_stats_record (tile->tlink ? tile->tlink->tm : NULL,
+                     TILE_STATS_EVENT_LOCK, 0, -1);
+}
+
+void
+tile_stats_record_fault (TileManager *tm)
+{
+  tile_stats_record (tm, TILE_STATS_EVENT_FAULT, 0, -1);
+}
+
+void
+tile_stats_record_cow_split (TileManager *tm)
+{
+  tile_stats_record (tm, TILE_STATS_EVENT_COW_SPLIT, 0, -1);
+}
+
+void
+tile_stats_record_uniform_skip (Tile *tile)
+{
+  tile_stats_record (tile->tlink ? tile->tlink->tm : NULL,
+                     TILE_STATS_EVENT_UNIFORM_SKIP, tile->size, -1);
+}
+
+void
+tile_stats_record_swap_in (Tile   *tile,
+                           gint64  usecs)
+{
+  tile_stats_record (tile->tlink ? tile->tlink->tm : NULL,
+                     TILE_STATS_EVENT_SWAP_IN, tile->size, usecs);
+}
+
+void
+tile_stats_record_swap_out (Tile   *tile,
+                            gint64  usecs)
+{
+  tile_stats_record (tile->tlink ? tile->tlink->tm : NULL,
+                     TILE_STATS_EVENT_SWAP_OUT, tile->size, usecs);
+}
+
+
+/*  private functions  */
+
+static void
+tile_stats_record (TileManager    *tm,
+                   TileStatsEvent  event,
+                   gint            bytes,
+                   gint64          usecs)
+{
+  gint bucket = -1;
+
+  if (usecs >= 0)
+    {
+      for (bucket = 0;
+           bucket < TILE_STATS_N_BUCKETS - 1 &&
+           usecs >= (G_GINT64_CONSTANT (1) << bucket);
+           bucket++);
+    }
+
+  TILE_STATS_LOCK;
+
+  tile_stats_add (&totals, event, bytes, bucket);
+
+  if (tm)
+    {
+      if (! tm->stats)
+        tm->stats = g_slice_new0 (TileStats);
+
+      if (tm->stats->generation != generation)
+        {
+          memset (tm->stats, 0, sizeof (TileStats));
+          tm->stats->generation = generation;
+        }
+
+      tile_stats_add (tm->stats, event, bytes, bucket);
+    }
+
+  TILE_STATS_UNLOCK;
+}
+
+static void
+tile_stats_add (TileStats      *stats,
+                TileStatsEvent  event,
+                gint            bytes,
+                gint            bucket)
+{
+  switch (event)
+    {
+    case TILE_STATS_EVENT_LOCK:
+      stats->locks++;
+      break;
+
+    case TILE_STATS_EVENT_FAULT:
+      stats->faults++;
+      break;
+
+    case TILE_STATS_EVENT_COW_SPLIT:
+      stats->cow_splits++;
+      break;
+
+    case TILE_STATS_EVENT_UNIFORM_SKIP:
+      stats->uniform_skips++;
+      stats->bytes_skipped += bytes;
+      break;
+
+    case TILE_STATS_EVENT_SWAP_IN:
+      stats->swap_ins++;
+      stats->bytes_in += bytes;
+      if (bucket >= 0)
+        stats->swap_in_latency[bucket]++;
+      break;
+
+    case TILE_STATS_EVENT_SWAP_OUT:
+      stats->swap_outs++;
+      stats->bytes_out += bytes;
+      if (bucket >= 0)
+        stats->swap_out_latency[bucket]++;
+      break;
+    }
+}
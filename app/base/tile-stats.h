@@ -0,0 +1,81 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_STATS_H__
+#define __TILE_STATS_H__
+
+
+/*  latencies are sorted into power-of-two buckets of microseconds,
+ *  bucket i counts latencies below (1 << i) us, the last one the rest
+ */
+#define TILE_STATS_N_BUCKETS  16
+
+
+struct _TileStats
+{
+  guint    generation;     /*  private, see tile_stats_reset()            */
+
+  guint64  locks;          /*  tile_lock() calls                          */
+  guint64  faults;         /*  invalid tiles that had to be validated     */
+  guint64  cow_splits;     /*  shared tiles copied for writing            */
+  guint64  uniform_skips;  /*  uniform or transparent tiles whose data
+                            *  wasn't processed, saved or swapped
+                            */
+  guint64  bytes_skipped;
+
+  guint64  swap_ins;       /*  tiles brought back into memory             */
+  guint64  swap_outs;      /*  tiles written to the swap file             */
+  guint64  bytes_in;
+  guint64  bytes_out;
+
+  guint64  swap_in_latency[TILE_STATS_N_BUCKETS];
+  guint64  swap_out_latency[TILE_STATS_N_BUCKETS];
+};
+
+
+/*  checked by the tile system before calling any of the recording
+ *  functions below, don't set it directly
+ */
+extern gboolean tile_stats_active;
+
+
+void      tile_stats_init              (void);
+void      tile_stats_exit              (void);
+
+void      tile_stats_set_enabled       (gboolean     enabled);
+gboolean  tile_stats_get_enabled       (void);
+void      tile_stats_reset             (void);
+
+void      tile_stats_get_totals        (TileStats   *stats);
+void      tile_stats_get               (TileManager *tm,
+                                        TileStats   *stats);
+void      tile_stats_free              (TileManager *tm);
+
+gint64    tile_stats_bucket_limit      (gint         bucket);
+
+void      tile_stats_record_lock       (Tile        *tile);
+void      tile_stats_record_fault      (TileManager *tm);
+void      tile_stats_record_cow_split  (TileManager *tm);
+void      tile_stats_record_uniform_skip
+                                       (Tile        *tile);
+void      tile_stats_record_swap_in    (Tile        *tile,
+                                        gint64       usecs);
+void      tile_stats_record_swap_out   (Tile        *tile,
+                                        gint64       usecs);
+
+
+#endif /* __TILE_STATS_H__ */
@@ -19,12 +19,17 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <string.h>
 #include <sys/types.h>
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_PWRITEV
+#include <sys/uio.h>
+#endif
+
 #include <glib-object.h>
 #include <glib/gstdio.h>
 
@@ -47,7 +52,9 @@
 
 #include "base-utils.h"
 #include "tile.h"
+#include "tile-compress.h"
 #include "tile-rowhints.h"
+#include "tile-stats.h"
 #include "tile-swap.h"
 #include "tile-private.h"
 #include "tile-cache.h"
@@ -69,6 +76,22 @@ typedef gint (* SwapFunc) (gint         fd,
 
 #define MAX_OPEN_SWAP_FILES  16
 
+/*  The asynchronous backend needs threads and positional I/O  */
+#if defined (ENABLE_MP) && defined (HAVE_PWRITE)
+#define TILE_SWAP_ASYNC
+
+/*  bytes of tile data the writer thread may lag behind before
+ *  tile_swap_out() blocks
+ */
+#define SWAP_ASYNC_MAX_PENDING  (64 * 1024 * 1024)
+
+/*  maximum number of tiles coalesced into a single write  */
+#define SWAP_ASYNC_MAX_IOV      64
+
+/*  number of tile slots read at once on swap-in  */
+#define SWAP_READAHEAD_TILES    16
+#endif
+
 
 typedef struct _SwapFile     SwapFile;
 typedef struct _SwapFileGap  SwapFileGap;
@@ -88,30 +111,91 @@ struct _SwapFileGap
   gint64 end;
 };
 
+#ifdef TILE_SWAP_ASYNC
 
-static void          tile_swap_command        (Tile        *tile,
-                                               gint         command);
-static void          tile_swap_default_in     (SwapFile    *swap_file,
-                                               Tile        *tile);
-static void          tile_swap_default_out    (SwapFile    *swap_file,
-                                               Tile        *tile);
-static void          tile_swap_default_delete (SwapFile    *swap_file,
-                                               Tile        *tile);
+typedef struct _SwapWrite    SwapWrite;
 
-static gint64        tile_swap_find_offset    (SwapFile    *swap_file,
-                                               gint64       bytes);
-static void          tile_swap_open           (SwapFile    *swap_file);
-static void          tile_swap_resize         (SwapFile    *swap_file,
-                                               gint64       new_size);
-static SwapFileGap * tile_swap_gap_new        (gint64       start,
-                                               gint64       end);
-static void          tile_swap_gap_destroy    (SwapFileGap *gap);
+/*  A tile write queued for the writer thread.  The tile data is
+ *  copied, the tile itself may be freed before the write lands.
+ */
+struct _SwapWrite
+{
+  gint64    offset;
+  gint      size;
+  guchar   *data;
+  gboolean  cancelled;  /* superseded or deleted, don't write */
+};
+
+#endif
+
+
+static void          tile_swap_command        (Tile         *tile,
+                                               gint          command,
+                                               const guchar *data);
+static void          tile_swap_default_in     (SwapFile     *swap_file,
+                                               Tile         *tile);
+static void          tile_swap_default_out    (SwapFile     *swap_file,
+                                               Tile         *tile,
+                                               const guchar *data);
+static void          tile_swap_default_delete (SwapFile     *swap_file,
+                                               Tile         *tile);
+
+static gint64        tile_swap_find_offset    (SwapFile     *swap_file,
+                                               gint64        bytes);
+static void          tile_swap_open           (SwapFile     *swap_file);
+static void          tile_swap_resize         (SwapFile     *swap_file,
+                                               gint64        new_size);
+static SwapFileGap * tile_swap_gap_new        (gint64        start,
+                                               gint64        end);
+static void          tile_swap_gap_destroy    (SwapFileGap  *gap);
+
+#ifdef TILE_SWAP_ASYNC
+static void          tile_swap_async_in       (SwapFile     *swap_file,
+                                               Tile         *tile);
+static void          tile_swap_async_out      (SwapFile     *swap_file,
+                                               Tile         *tile,
+                                               const guchar *data);
+static void          tile_swap_async_cancel   (Tile         *tile);
+static gpointer      tile_swap_writer         (gpointer      data);
+static void          tile_swap_write_free     (SwapWrite    *write);
+#endif
 
 
 static SwapFile     * gimp_swap_file   = NULL;
 
 static const guint64  swap_file_grow   = 1024 * TILE_WIDTH * TILE_HEIGHT * 4;
 
+#ifdef ENABLE_MP
+/*  the tile cache is sharded and no longer serializes swapping, so
+ *  the swap file (its gap list and file position) has its own lock
+ */
+static GMutex       * swap_mutex       = NULL;
+
+#define TILE_SWAP_LOCK    g_mutex_lock (swap_mutex)
+#define TILE_SWAP_UNLOCK  g_mutex_unlock (swap_mutex)
+
+#else
+
+#define TILE_SWAP_LOCK    /* nothing */
+#define TILE_SWAP_UNLOCK  /* nothing */
+
+#endif
+
+#ifdef TILE_SWAP_ASYNC
+static GThread      * swap_writer          = NULL;
+static GCond        * swap_writer_cond     = NULL;
+static GCond        * swap_drained_cond    = NULL;
+static GQueue         swap_write_queue     = G_QUEUE_INIT;
+static GHashTable   * swap_pending         = NULL;
+static gint64         swap_pending_bytes   = 0;
+static gboolean       swap_writer_quit     = FALSE;
+static gint           swap_writer_errno    = 0;
+
+static guchar       * swap_readahead       = NULL;
+static gint64         swap_readahead_start = -1;
+static gint64         swap_readahead_end   = -1;
+#endif
+
 static gboolean       seek_err_msg     = TRUE;
 static gboolean       read_err_msg     = TRUE;
 static gboolean       write_err_msg    = TRUE;
@@ -217,6 +301,10 @@ tile_swap_init (const gchar *path)
   gimp_swap_file->cur_position  = 0;
   gimp_swap_file->fd            = -1;
 
+#ifdef ENABLE_MP
+  swap_mutex = g_mutex_new ();
+#endif
+
   g_free (basename);
   g_free (dirname);
 }
@@ -258,6 +346,8 @@ tile_swap_exit (void)
 
   g_return_if_fail (gimp_swap_file != NULL);
 
+  tile_swap_set_async (FALSE);
+
 #ifdef GIMP_UNSTABLE
   if (gimp_swap_file->swap_file_end != 0)
     {
@@ -282,6 +372,11 @@ tile_swap_exit (void)
   g_slice_free (SwapFile, gimp_swap_file);
 
   gimp_swap_file = NULL;
+
+#ifdef ENABLE_MP
+  g_mutex_free (swap_mutex);
+  swap_mutex = NULL;
+#endif
 }
 
 /* check if we can open a swap file */
@@ -307,54 +402,206 @@ tile_swap_test (void)
   return FALSE;
 }
 
+/*  Switch between writing tiles synchronously and the write-behind
+ *  queue served by a dedicated thread.  Switching back waits for all
+ *  queued writes to land.
+ */
+void
+tile_swap_set_async (gboolean async)
+{
+#ifdef TILE_SWAP_ASYNC
+  g_return_if_fail (gimp_swap_file != NULL);
+
+  if (async && ! swap_writer)
+    {
+      GError *error = NULL;
+
+      swap_writer_cond  = g_cond_new ();
+      swap_drained_cond = g_cond_new ();
+      swap_pending      = g_hash_table_new (g_int64_hash, g_int64_equal);
+      swap_readahead    = g_malloc (SWAP_READAHEAD_TILES *
+                                    TILE_WIDTH * TILE_HEIGHT * 4);
+      swap_writer_quit  = FALSE;
+
+      swap_writer = g_thread_create (tile_swap_writer, gimp_swap_file,
+                                     TRUE, &error);
+
+      if (G_UNLIKELY (! swap_writer))
+        {
+          g_warning ("unable to start the swap writer thread: %s",
+                     error->message);
+          g_clear_error (&error);
+
+          tile_swap_set_async (FALSE);
+        }
+    }
+  else if (! async && swap_writer_cond)
+    {
+      if (swap_writer)
+        {
+          TILE_SWAP_LOCK;
+          swap_writer_quit = TRUE;
+          g_cond_signal (swap_writer_cond);
+          TILE_SWAP_UNLOCK;
+
+          g_thread_join (swap_writer);
+          swap_writer = NULL;
+        }
+
+      g_cond_free (swap_writer_cond);
+      swap_writer_cond = NULL;
+
+      g_cond_free (swap_drained_cond);
+      swap_drained_cond = NULL;
+
+      g_hash_table_destroy (swap_pending);
+      swap_pending = NULL;
+
+      g_free (swap_readahead);
+      swap_readahead       = NULL;
+      swap_readahead_start = -1;
+      swap_readahead_end   = -1;
+
+      /*  the synchronous code tracks the file position itself  */
+      gimp_swap_file->cur_position = -1;
+    }
+#endif
+}
+
+gboolean
+tile_swap_is_async (void)
+{
+#ifdef TILE_SWAP_ASYNC
+  return swap_writer != NULL;
+#else
+  return FALSE;
+#endif
+}
+
 void
 tile_swap_in (Tile *tile)
 {
-  if (tile->swap_offset == -1)
+  gint64 start = 0;
+
+  /*  uniform tiles are dropped instead, see tile_cache_zorch_next()  */
+  if (tile_is_uniform (tile, NULL))
     {
+      gint i;
+
+      if (tile->compressed)
+        tile_compress_drop (tile);
+
       tile_alloc (tile);
+
+      for (i = 0; i < tile->size; i += tile->bpp)
+        memcpy (tile->data + i, tile->pixel, tile->bpp);
+
       return;
     }
 
-  tile_swap_command (tile, SWAP_IN);
+  if (G_UNLIKELY (tile_stats_active))
+    start = g_get_monotonic_time ();
+
+  /*  this also counts the compressed tier's misses  */
+  if (! tile_compress_restore (tile))
+    {
+      if (tile->swap_offset == -1)
+        {
+          tile_alloc (tile);
+          return;
+        }
+
+      tile_swap_command (tile, SWAP_IN, NULL);
+    }
+
+  if (start)
+    tile_stats_record_swap_in (tile, g_get_monotonic_time () - start);
 }
 
 void
 tile_swap_out (Tile *tile)
 {
-  tile_swap_command (tile, SWAP_OUT);
+  tile_swap_out_data (tile, tile->data);
+}
+
+/*  Like tile_swap_out(), but writes @data instead of the tile's own
+ *  data, which may not be there.  Used by the compressed tier.
+ */
+void
+tile_swap_out_data (Tile         *tile,
+                    const guchar *data)
+{
+  gint64 start = 0;
+
+  if (G_UNLIKELY (tile_stats_active))
+    start = g_get_monotonic_time ();
+
+  tile_swap_command (tile, SWAP_OUT, data);
+
+  if (start)
+    tile_stats_record_swap_out (tile, g_get_monotonic_time () - start);
 }
 
 void
 tile_swap_delete (Tile *tile)
 {
-  tile_swap_command (tile, SWAP_DELETE);
+  tile_swap_command (tile, SWAP_DELETE, NULL);
 }
 
 static void
-tile_swap_command (Tile *tile,
-                   gint  command)
+tile_swap_command (Tile         *tile,
+                   gint          command,
+                   const guchar *data)
 {
+  TILE_SWAP_LOCK;
+
   if (gimp_swap_file->fd == -1)
     {
       tile_swap_open (gimp_swap_file);
 
       if (G_UNLIKELY (gimp_swap_file->fd == -1))
-        return;
+        {
+          TILE_SWAP_UNLOCK;
+          return;
+        }
     }
 
+#ifdef TILE_SWAP_ASYNC
+  if (swap_writer)
+    {
+      switch (command)
+        {
+        case SWAP_IN:
+          tile_swap_async_in (gimp_swap_file, tile);
+          break;
+        case SWAP_OUT:
+          tile_swap_async_out (gimp_swap_file, tile, data);
+          break;
+        case SWAP_DELETE:
+          tile_swap_async_cancel (tile);
+          tile_swap_default_delete (gimp_swap_file, tile);
+          break;
+        }
+
+      TILE_SWAP_UNLOCK;
+      return;
+    }
+#endif
+
   switch (command)
     {
     case SWAP_IN:
       tile_swap_default_in (gimp_swap_file, tile);
       break;
     case SWAP_OUT:
-      tile_swap_default_out (gimp_swap_file, tile);
+      tile_swap_default_out (gimp_swap_file, tile, data);
       break;
     case SWAP_DELETE:
       tile_swap_default_delete (gimp_swap_file, tile);
       break;
     }
+
+  TILE_SWAP_UNLOCK;
 }
 
 /* The actual swap file code. The swap file consists of tiles
@@ -485,8 +732,9 @@ tile_swap_default_in (SwapFile *swap_file,
 }
 
 static void
-tile_swap_default_out (SwapFile *swap_file,
-                       Tile     *tile)
+tile_swap_default_out (SwapFile     *swap_file,
+                       Tile         *tile,
+                       const guchar *data)
 {
   gint   bytes;
   gint   nleft;
@@ -536,7 +784,7 @@ tile_swap_default_out (SwapFile *swap_file,
   nleft = tile->size;
   while (nleft > 0)
     {
-      gint err = write (swap_file->fd, tile->data + tile->size - nleft, nleft);
+      gint err = write (swap_file->fd, data + tile->size - nleft, nleft);
 
       if (err <= 0)
         {
@@ -696,6 +944,383 @@ tile_swap_default_delete (SwapFile *swap_file,
     }
 }
 
+#ifdef TILE_SWAP_ASYNC
+
+/* The asynchronous swap backend.  tile_swap_async_out() only copies
+ *  the tile data into a SwapWrite, assigns the swap offset using the
+ *  same gap allocator as the synchronous code and queues the write.
+ *  The writer thread takes everything queued so far, sorts it by
+ *  offset and writes runs of adjacent tiles with a single call.
+ *
+ * Until a write has landed, the SwapWrite stays in the swap_pending
+ *  table, so that swapping the tile back in is served from memory.
+ *  Swap-ins that do go to disk read a window of neighbouring tile
+ *  slots, which are likely to be requested next since tiles that
+ *  were swapped out together were allocated next to each other.
+ *
+ * All of the state is protected by swap_mutex; the writer drops it
+ *  while doing the actual I/O.
+ */
+
+static void
+tile_swap_readahead_invalidate (gint64 start,
+                                gint64 end)
+{
+  if (start < swap_readahead_end && end > swap_readahead_start)
+    {
+      swap_readahead_start = -1;
+      swap_readahead_end   = -1;
+    }
+}
+
+static void
+tile_swap_async_in (SwapFile *swap_file,
+                    Tile     *tile)
+{
+  SwapWrite *write;
+  gint64     offset = tile->swap_offset;
+
+  if (tile->data)
+    return;
+
+  tile_cache_suspend_idle_swapper ();
+
+#ifdef TILE_PROFILING
+  tile_total_swapin++;
+
+  if (tile->zorched)
+    tile_total_zorched_swapin++;
+
+  if (!tile->inonce)
+    tile_unique_swapin++;
+
+  tile->inonce = TRUE;
+  tile->zorched = FALSE;
+  tile->zorchout = FALSE;
+#endif
+
+  write = g_hash_table_lookup (swap_pending, &offset);
+
+  if (write)
+    {
+      tile_alloc (tile);
+      memcpy (tile->data, write->data, tile->size);
+      return;
+    }
+
+  if (offset < swap_readahead_start ||
+      offset + tile->size > swap_readahead_end)
+    {
+      gint64 length = MIN (SWAP_READAHEAD_TILES * TILE_WIDTH * TILE_HEIGHT *
+                           tile->bpp,
+                           swap_file->swap_file_end - offset);
+      gint64 nread  = 0;
+
+      swap_readahead_start = -1;
+      swap_readahead_end   = -1;
+
+      while (nread < length)
+        {
+          gssize err;
+
+          do
+            {
+              err = pread (swap_file->fd,
+                           swap_readahead + nread, length - nread,
+                           offset + nread);
+            }
+          while ((err == -1) && ((errno == EAGAIN) || (errno == EINTR)));
+
+          if (err <= 0)
+            break;
+
+          nread += err;
+        }
+
+      if (nread < tile->size)
+        {
+          if (read_err_msg)
+            g_message ("unable to read tile data from disk: "
+                       "%s (%"G_GINT64_FORMAT"/%d bytes read)",
+                       g_strerror (errno), nread, tile->size);
+          read_err_msg = FALSE;
+          return;
+        }
+
+      swap_readahead_start = offset;
+      swap_readahead_end   = offset + nread;
+    }
+
+  tile_alloc (tile);
+  memcpy (tile->data,
+          swap_readahead + (offset - swap_readahead_start), tile->size);
+
+  read_err_msg = TRUE;
+}
+
+static void
+tile_swap_async_out (SwapFile     *swap_file,
+                     Tile         *tile,
+                     const guchar *data)
+{
+  SwapWrite *write;
+  SwapWrite *old;
+  gint64     newpos;
+
+#ifdef TILE_PROFILING
+  tile_total_swapout++;
+
+  if (!tile->outonce)
+    tile_unique_swapout++;
+
+  tile->outonce = TRUE;
+#endif
+
+  if (G_UNLIKELY (swap_writer_errno))
+    {
+      if (write_err_msg)
+        g_message ("unable to write tile data to disk: %s",
+                   g_strerror (swap_writer_errno));
+      write_err_msg = FALSE;
+      swap_writer_errno = 0;
+    }
+
+  /*  If there is already a valid swap_offset, use it  */
+  if (tile->swap_offset == -1)
+    newpos = tile_swap_find_offset (swap_file,
+                                    TILE_WIDTH * TILE_HEIGHT * tile->bpp);
+  else
+    newpos = tile->swap_offset;
+
+  write = g_slice_new (SwapWrite);
+
+  write->offset    = newpos;
+  write->size      = tile->size;
+  write->data      = g_memdup (data, tile->size);
+  write->cancelled = FALSE;
+
+  /*  an older write to the same slot which didn't land yet is obsolete  */
+  old = g_hash_table_lookup (swap_pending, &newpos);
+  if (old)
+    old->cancelled = TRUE;
+
+  g_hash_table_replace (swap_pending, &write->offset, write);
+
+  g_queue_push_tail (&swap_write_queue, write);
+  swap_pending_bytes += write->size;
+
+  g_cond_signal (swap_writer_cond);
+
+  /* Do NOT free tile->data because we may be pre-swapping.
+   * tile->data is freed in tile_cache_zorch_next
+   */
+  tile->dirty = FALSE;
+  tile->swap_offset = newpos;
+
+  while (swap_pending_bytes > SWAP_ASYNC_MAX_PENDING)
+    g_cond_wait (swap_drained_cond, swap_mutex);
+}
+
+static void
+tile_swap_async_cancel (Tile *tile)
+{
+  SwapWrite *write;
+
+  if (tile->swap_offset == -1)
+    return;
+
+  write = g_hash_table_lookup (swap_pending, &tile->swap_offset);
+
+  if (write)
+    {
+      write->cancelled = TRUE;
+      g_hash_table_remove (swap_pending, &tile->swap_offset);
+    }
+}
+
+static gint
+tile_swap_write_compare (gconstpointer a,
+                         gconstpointer b)
+{
+  const SwapWrite *write_a = *(const SwapWrite **) a;
+  const SwapWrite *write_b = *(const SwapWrite **) b;
+
+  if (write_a->offset < write_b->offset)
+    return -1;
+
+  return write_a->offset > write_b->offset;
+}
+
+/*  Writes @n_writes tiles which are adjacent in the swap file.
+ *  Returns 0 on success or an errno value.
+ */
+static gint
+tile_swap_write_run (gint        fd,
+                     SwapWrite **writes,
+                     gint        n_writes)
+{
+  gint64 offset = writes[0]->offset;
+  gint64 total  = 0;
+  gint64 done   = 0;
+  gint   i;
+
+  for (i = 0; i < n_writes; i++)
+    total += writes[i]->size;
+
+  while (done < total)
+    {
+      gssize err;
+
+#ifdef HAVE_PWRITEV
+      struct iovec iov[SWAP_ASYNC_MAX_IOV];
+      gint64       skip   = done;
+      gint         n_iov  = 0;
+
+      for (i = 0; i < n_writes; i++)
+        {
+          if (skip >= writes[i]->size)
+            {
+              skip -= writes[i]->size;
+              continue;
+            }
+
+          iov[n_iov].iov_base = writes[i]->data + skip;
+          iov[n_iov].iov_len  = writes[i]->size - skip;
+          n_iov++;
+
+          skip = 0;
+        }
+
+      do
+        {
+          err = pwritev (fd, iov, n_iov, offset + done);
+        }
+      while ((err == -1) && ((errno == EAGAIN) || (errno == EINTR)));
+#else
+      gint64 skip = done;
+
+      for (i = 0; skip >= writes[i]->size; i++)
+        skip -= writes[i]->size;
+
+      do
+        {
+          err = pwrite (fd, writes[i]->data + skip, writes[i]->size - skip,
+                        offset + done);
+        }
+      while ((err == -1) && ((errno == EAGAIN) || (errno == EINTR)));
+#endif
+
+      if (err <= 0)
+        return err == 0 ? ENOSPC : errno;
+
+      done += err;
+    }
+
+  return 0;
+}
+
+static gpointer
+tile_swap_writer (gpointer data)
+{
+  SwapFile  *swap_file = data;
+  GPtrArray *batch     = g_ptr_array_new ();
+
+  TILE_SWAP_LOCK;
+
+  while (TRUE)
+    {
+      SwapWrite *write;
+      gint       fd;
+      gint       err = 0;
+      gint       start;
+      guint      i;
+
+      while (g_queue_is_empty (&swap_write_queue) && ! swap_writer_quit)
+        g_cond_wait (swap_writer_cond, swap_mutex);
+
+      if (g_queue_is_empty (&swap_write_queue))
+        break;
+
+      while ((write = g_queue_pop_head (&swap_write_queue)))
+        {
+          if (write->cancelled)
+            {
+              swap_pending_bytes -= write->size;
+              tile_swap_write_free (write);
+            }
+          else
+            {
+              g_ptr_array_add (batch, write);
+            }
+        }
+
+      fd = swap_file->fd;
+
+      TILE_SWAP_UNLOCK;
+
+      g_ptr_array_sort (batch, tile_swap_write_compare);
+
+      for (start = 0, i = 1; i <= batch->len; i++)
+        {
+          SwapWrite *prev = g_ptr_array_index (batch, i - 1);
+
+          if (i == batch->len                             ||
+              i - start == SWAP_ASYNC_MAX_IOV             ||
+              prev->offset + prev->size !=
+              ((SwapWrite *) g_ptr_array_index (batch, i))->offset)
+            {
+              gint run_err;
+
+              run_err = tile_swap_write_run (fd,
+                                             (SwapWrite **) batch->pdata + start,
+                                             i - start);
+              if (run_err)
+                err = run_err;
+
+              start = i;
+            }
+        }
+
+      TILE_SWAP_LOCK;
+
+      for (i = 0; i < batch->len; i++)
+        {
+          write = g_ptr_array_index (batch, i);
+
+          if (g_hash_table_lookup (swap_pending, &write->offset) == write)
+            g_hash_table_remove (swap_pending, &write->offset);
+
+          tile_swap_readahead_invalidate (write->offset,
+                                          write->offset + write->size);
+
+          swap_pending_bytes -= write->size;
+          tile_swap_write_free (write);
+        }
+
+      g_ptr_array_set_size (batch, 0);
+
+      if (err)
+        swap_writer_errno = err;
+
+      g_cond_broadcast (swap_drained_cond);
+    }
+
+  TILE_SWAP_UNLOCK;
+
+  g_ptr_array_free (batch, TRUE);
+
+  return NULL;
+}
+
+static void
+tile_swap_write_free (SwapWrite *write)
+{
+  g_free (write->data);
+  g_slice_free (SwapWrite, write);
+}
+
+#endif /* TILE_SWAP_ASYNC */
+
 static void
 tile_swap_open (SwapFile *swap_file)
 {
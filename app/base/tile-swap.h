@@ -19,14 +19,19 @@
 #define __TILE_SWAP_H__
 
 
-void     tile_swap_init     (const gchar *path);
-void     tile_swap_exit     (void);
+void     tile_swap_init      (const gchar  *path);
+void     tile_swap_exit      (void);
 
-gboolean tile_swap_test     (void);
+gboolean tile_swap_test      (void);
 
-void     tile_swap_in       (Tile        *tile);
-void     tile_swap_out      (Tile        *tile);
-void     tile_swap_delete   (Tile        *tile);
+void     tile_swap_set_async (gboolean      async);
+gboolean tile_swap_is_async  (void);
+
+void     tile_swap_in        (Tile         *tile);
+void     tile_swap_out       (Tile         *tile);
+void     tile_swap_out_data  (Tile         *tile,
+                              const guchar *data);
+void     tile_swap_delete    (Tile         *tile);
 
 
 #endif /* __TILE_SWAP_H__ */
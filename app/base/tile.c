@@ -17,14 +17,20 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib-object.h>
 
 #include "base-types.h"
 
 #include "tile.h"
 #include "tile-cache.h"
+#include "tile-compress.h"
 #include "tile-manager.h"
+#include "tile-manager-mapped.h"
+#include "tile-pool.h"
 #include "tile-rowhints.h"
+#include "tile-stats.h"
 #include "tile-swap.h"
 #include "tile-private.h"
 
@@ -35,6 +41,10 @@
 /*  This is being used from tile-swap, but just for debugging purposes.  */
 static gint tile_ref_count    = 0;
 
+#ifdef ENABLE_MP
+GStaticRecMutex tile_access_mutex = G_STATIC_REC_MUTEX_INIT;
+#endif
+
 
 #ifdef TILE_PROFILING
 
@@ -48,7 +58,9 @@ gint tile_exist_count         = 0;
 #endif
 
 
-static void  tile_destroy (Tile *tile);
+static void  tile_destroy        (Tile *tile);
+static void  tile_validate       (Tile *tile);
+static void  tile_update_summary (Tile *tile);
 
 
 Tile *
@@ -71,6 +83,8 @@ tile_new (gint bpp)
 void
 tile_lock (Tile *tile)
 {
+  TILE_ACCESS_LOCK;
+
   /* Increment the global reference count.
    */
   tile_ref_count++;
@@ -79,6 +93,9 @@ tile_lock (Tile *tile)
    */
   tile->ref_count++;
 
+  if (G_UNLIKELY (tile_stats_active))
+    tile_stats_record_lock (tile);
+
   if (tile->ref_count == 1)
     {
       /* remove from cache, move to main store */
@@ -100,14 +117,18 @@ tile_lock (Tile *tile)
   if (! tile->valid)
     {
       /* an invalid tile should never be shared, so this should work */
-      tile_manager_validate_tile (tile->tlink->tm, tile);
+      tile_validate (tile);
     }
+
+  TILE_ACCESS_UNLOCK;
 }
 
 void
 tile_release (Tile     *tile,
               gboolean  dirty)
 {
+  TILE_ACCESS_LOCK;
+
   /* Decrement the global reference count.
    */
   tile_ref_count--;
@@ -129,6 +150,9 @@ tile_release (Tile     *tile,
           for (y = 0; y < tile->eheight; y++)
             tile->rowhint[y] = TILEROWHINT_UNKNOWN;
         }
+
+      if (tile->write_count == 0)
+        tile_update_summary (tile);
     }
 
   if (tile->ref_count == 0)
@@ -141,7 +165,6 @@ tile_release (Tile     *tile,
         {
           /* tile is truly dead */
           tile_destroy (tile);
-          return;                        /* skip terminal unlock */
         }
       else
         {
@@ -150,6 +173,8 @@ tile_release (Tile     *tile,
           tile_cache_insert (tile);
         }
     }
+
+  TILE_ACCESS_UNLOCK;
 }
 
 void
@@ -160,7 +185,7 @@ tile_alloc (Tile *tile)
 
   /* Allocate the data for the tile.
    */
-  tile->data = g_new (guchar, tile->size);
+  tile->data = tile_pool_alloc (tile->size);
 
 #ifdef TILE_PROFILING
   tile_exist_count++;
@@ -170,6 +195,20 @@ tile_alloc (Tile *tile)
 #endif
 }
 
+void
+tile_free (Tile *tile)
+{
+  if (! tile->data)
+    return;
+
+  tile_pool_free (tile->data);
+  tile->data = NULL;
+
+#ifdef TILE_PROFILING
+  tile_exist_count--;
+#endif
+}
+
 static void
 tile_destroy (Tile *tile)
 {
@@ -186,14 +225,13 @@ tile_destroy (Tile *tile)
       return;
     }
 
-  if (tile->data)
+  if (tile->mapped)
     {
-      g_free (tile->data);
-      tile->data = NULL;
-
-#ifdef TILE_PROFILING
-      tile_exist_count--;
-#endif
+      tile_mapped_release (tile);
+    }
+  else
+    {
+      tile_free (tile);
     }
 
   if (tile->rowhint)
@@ -205,6 +243,9 @@ tile_destroy (Tile *tile)
   /* must flush before deleting swap */
   tile_cache_flush (tile);
 
+  if (tile->compressed)
+    tile_compress_drop (tile);
+
   if (tile->swap_offset != -1)
     {
       /* If the tile is on disk, then delete its
@@ -253,6 +294,31 @@ tile_is_valid (Tile *tile)
   return tile->valid;
 }
 
+gboolean
+tile_is_mapped (Tile *tile)
+{
+  return tile->mapped != NULL;
+}
+
+gboolean
+tile_is_uniform (Tile   *tile,
+                 guchar *pixel)
+{
+  if (! (tile->summary & TILE_SUMMARY_UNIFORM))
+    return FALSE;
+
+  if (pixel)
+    memcpy (pixel, tile->pixel, tile->bpp);
+
+  return TRUE;
+}
+
+gboolean
+tile_is_transparent (Tile *tile)
+{
+  return (tile->summary & TILE_SUMMARY_TRANSPARENT) != 0;
+}
+
 void
 tile_attach (Tile *tile,
              void *tm,
@@ -260,10 +326,12 @@ tile_attach (Tile *tile,
 {
   TileLink *new;
 
+  TILE_ACCESS_LOCK;
+
   if ((tile->share_count > 0) && (! tile->valid))
     {
       /* trying to share invalid tiles is problematic, not to mention silly */
-      tile_manager_validate_tile (tile->tlink->tm, tile);
+      tile_validate (tile);
     }
 
   tile->share_count++;
@@ -285,6 +353,8 @@ tile_attach (Tile *tile,
   new->next     = tile->tlink;
 
   tile->tlink = new;
+
+  TILE_ACCESS_UNLOCK;
 }
 
 void
@@ -295,6 +365,8 @@ tile_detach (Tile *tile,
   TileLink **link;
   TileLink  *tmp;
 
+  TILE_ACCESS_LOCK;
+
 #ifdef TILE_DEBUG
   g_printerr ("tile_detach: %p ~> (%p,%d) r%d *%u\n",
               tile, tm, tile_num, tile->ref_count, tile->share_count);
@@ -311,6 +383,7 @@ tile_detach (Tile *tile,
   if (G_UNLIKELY (*link == NULL))
     {
       g_warning ("Tried to detach a nonattached tile -- TILE BUG!");
+      TILE_ACCESS_UNLOCK;
       return;
     }
 
@@ -327,6 +400,8 @@ tile_detach (Tile *tile,
 
   if (tile->share_count == 0 && tile->ref_count == 0)
     tile_destroy (tile);
+
+  TILE_ACCESS_UNLOCK;
 }
 
 gpointer
@@ -342,3 +417,64 @@ tile_global_refcount (void)
 {
   return tile_ref_count;
 }
+
+/*  Validates @tile with the tile access lock released, however often
+ *  the caller holds it: validate procs may construct the tile on the
+ *  pixel processor's threads, which lock other tiles meanwhile.
+ */
+static void
+tile_validate (Tile *tile)
+{
+  TileManager *tm = tile->tlink->tm;
+#ifdef ENABLE_MP
+  guint        depth;
+
+  depth = g_static_rec_mutex_unlock_full (&tile_access_mutex);
+#endif
+
+  tile_manager_validate_tile (tm, tile);
+
+#ifdef ENABLE_MP
+  g_static_rec_mutex_lock_full (&tile_access_mutex, depth);
+#endif
+}
+
+/*  Summarizes the data of the locked @tile after it was written.  Like
+ *  the row hints, the last byte of 2 and 4 bpp pixels is taken to be
+ *  alpha.  Both scans stop at the first pixel which doesn't match, so
+ *  this is cheap for all but the tiles it finds to be uniform.
+ */
+static void
+tile_update_summary (Tile *tile)
+{
+  const guchar *data = tile->data;
+  const gint    bpp  = tile->bpp;
+  const gint    size = tile->size;
+  gint          i;
+
+  tile->summary = TILE_SUMMARY_VALID;
+
+  for (i = bpp; i < size; i++)
+    {
+      if (data[i] != data[i - bpp])
+        break;
+    }
+
+  if (i >= size)
+    {
+      tile->summary |= TILE_SUMMARY_UNIFORM;
+      memcpy (tile->pixel, data, bpp);
+    }
+
+  if (bpp == 2 || bpp == 4)
+    {
+      for (i = bpp - 1; i < size; i += bpp)
+        {
+          if (data[i])
+            break;
+        }
+
+      if (i >= size)
+        tile->summary |= TILE_SUMMARY_TRANSPARENT;
+    }
+}
@@ -41,9 +41,10 @@ void        tile_lock            (Tile     *tile);
 void        tile_release         (Tile     *tile,
                                   gboolean  dirty);
 
-/* Allocate the data for the tile.
+/* Allocate and free the data for the tile, see tile-pool.c.
  */
 void        tile_alloc           (Tile     *tile);
+void        tile_free            (Tile     *tile);
 
 /* Return the size in bytes of the tiles data.
  */
@@ -55,6 +56,21 @@ gint        tile_bpp             (Tile     *tile);
 
 gboolean    tile_is_valid        (Tile     *tile);
 
+/* Whether the tile is a view into a mapped file, see
+ * tile-manager-mapped.h.
+ */
+gboolean    tile_is_mapped       (Tile     *tile);
+
+/* Whether all pixels of the tile are the same, returning the pixel
+ * in @pixel if it's not NULL, or all transparent, as of when the tile
+ * was last written.  The tile doesn't need to be locked, so swapped
+ * out tiles can be checked too.  Tiles which weren't written since
+ * they were validated count as neither.
+ */
+gboolean    tile_is_uniform      (Tile     *tile,
+                                  guchar   *pixel);
+gboolean    tile_is_transparent  (Tile     *tile);
+
 void      * tile_data_pointer    (Tile     *tile,
                                   gint      xoff,
                                   gint      yoff);
@@ -0,0 +1,966 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "gimp-composite.h"
+#include "gimp-composite-avx2.h"
+
+#ifdef COMPILE_AVX2_IS_OKAY
+
+#include <immintrin.h>
+
+
+#define AVX2_FUNC    __attribute__ ((target ("avx2")))
+#define AVX2_INLINE  static inline __attribute__ ((target ("avx2"), always_inline))
+
+
+/*  All modes work on 32 bytes at once, that is 8 RGBA8 or 16 VA8
+ *  pixels.  The color channels are computed exactly like the generic
+ *  code does, the alpha bytes are replaced with MIN (A_a, B_a)
+ *  afterwards.  A short tail goes through a buffer on the stack.
+ */
+#define COMPOSITE_AVX2(ctx, op, alpha_mask)                                  \
+  G_STMT_START                                                               \
+    {                                                                        \
+      const guchar  *A       = (ctx)->A;                                     \
+      const guchar  *B       = (ctx)->B;                                     \
+      guchar        *D       = (ctx)->D;                                     \
+      gulong         n_bytes = ((ctx)->n_pixels *                            \
+                                gimp_composite_pixel_bpp[(ctx)->pixelformat_A]); \
+      const __m256i  mask    = (alpha_mask);                                 \
+      __m256i        a;                                                      \
+      __m256i        b;                                                      \
+                                                                             \
+      for (; n_bytes >= 32; n_bytes -= 32)                                   \
+        {                                                                    \
+          a = _mm256_loadu_si256 ((const __m256i *) A);                      \
+          b = _mm256_loadu_si256 ((const __m256i *) B);                      \
+                                                                             \
+          _mm256_storeu_si256 ((__m256i *) D,                                \
+                               _mm256_blendv_epi8 (op (a, b),                \
+                                                   _mm256_min_epu8 (a, b),   \
+                                                   mask));                   \
+          A += 32;                                                           \
+          B += 32;                                                           \
+          D += 32;                                                           \
+        }                                                                    \
+                                                                             \
+      if (n_bytes)                                                           \
+        {                                                                    \
+          guchar tail[3][32] = { { 0, }, };                                  \
+                                                                             \
+          memcpy (tail[0], A, n_bytes);                                      \
+          memcpy (tail[1], B, n_bytes);                                      \
+                                                                             \
+          a = _mm256_loadu_si256 ((const __m256i *) tail[0]);                \
+          b = _mm256_loadu_si256 ((const __m256i *) tail[1]);                \
+                                                                             \
+          _mm256_storeu_si256 ((__m256i *) tail[2],                          \
+                               _mm256_blendv_epi8 (op (a, b),                \
+                                                   _mm256_min_epu8 (a, b),   \
+                                                   mask));                   \
+          memcpy (D, tail[2], n_bytes);                                      \
+        }                                                                    \
+    }                                                                        \
+  G_STMT_END
+
+#define RGBA8_ALPHA_MASK  _mm256_set1_epi32 ((gint) 0xFF000000)
+#define VA8_ALPHA_MASK    _mm256_set1_epi16 ((gshort) 0xFF00)
+
+
+/*  Apply @op, a function of two vectors of words, to the unpacked
+ *  bytes of @a and @b.  The results of @op must be in [0, 255] unless
+ *  they are meant to saturate.
+ */
+#define BYTEWISE(op, a, b)                                                   \
+  _mm256_packus_epi16 (op (_mm256_unpacklo_epi8 ((a), _mm256_setzero_si256 ()), \
+                           _mm256_unpacklo_epi8 ((b), _mm256_setzero_si256 ())), \
+                       op (_mm256_unpackhi_epi8 ((a), _mm256_setzero_si256 ()), \
+                           _mm256_unpackhi_epi8 ((b), _mm256_setzero_si256 ())))
+
+/*  Apply @op, a function of two vectors of double words, to the
+ *  unpacked words of @a and @b.
+ */
+#define WORDWISE(op, a, b)                                                   \
+  _mm256_packus_epi32 (op (_mm256_unpacklo_epi16 ((a), _mm256_setzero_si256 ()), \
+                           _mm256_unpacklo_epi16 ((b), _mm256_setzero_si256 ())), \
+                       op (_mm256_unpackhi_epi16 ((a), _mm256_setzero_si256 ()), \
+                           _mm256_unpackhi_epi16 ((b), _mm256_setzero_si256 ())))
+
+
+/*  INT_MULT() of gimp-composite-generic.c on words and double words  */
+
+AVX2_INLINE __m256i
+int_mult_16 (__m256i a,
+             __m256i b)
+{
+  __m256i t = _mm256_add_epi16 (_mm256_mullo_epi16 (a, b),
+                                _mm256_set1_epi16 (0x80));
+
+  return _mm256_srli_epi16 (_mm256_add_epi16 (_mm256_srli_epi16 (t, 8), t), 8);
+}
+
+AVX2_INLINE __m256i
+int_mult_32 (__m256i a,
+             __m256i b)
+{
+  __m256i t = _mm256_add_epi32 (_mm256_mullo_epi32 (a, b),
+                                _mm256_set1_epi32 (0x80));
+
+  return _mm256_srli_epi32 (_mm256_add_epi32 (_mm256_srli_epi32 (t, 8), t), 8);
+}
+
+/*  255 - x for bytes, and for words in [0, 255]  */
+#define INVERT_8(x)   _mm256_xor_si256 ((x), _mm256_set1_epi8 ((gchar) 0xFF))
+#define INVERT_16(x)  _mm256_xor_si256 ((x), _mm256_set1_epi16 (0xFF))
+
+
+/*  The modes, on bytes  */
+
+AVX2_INLINE __m256i
+addition_avx2 (__m256i a,
+               __m256i b)
+{
+  return _mm256_adds_epu8 (a, b);
+}
+
+AVX2_INLINE __m256i
+subtract_avx2 (__m256i a,
+               __m256i b)
+{
+  return _mm256_subs_epu8 (a, b);
+}
+
+AVX2_INLINE __m256i
+difference_avx2 (__m256i a,
+                 __m256i b)
+{
+  return _mm256_or_si256 (_mm256_subs_epu8 (a, b), _mm256_subs_epu8 (b, a));
+}
+
+AVX2_INLINE __m256i
+darken_avx2 (__m256i a,
+             __m256i b)
+{
+  return _mm256_min_epu8 (a, b);
+}
+
+AVX2_INLINE __m256i
+lighten_avx2 (__m256i a,
+              __m256i b)
+{
+  return _mm256_max_epu8 (a, b);
+}
+
+AVX2_INLINE __m256i
+multiply_avx2 (__m256i a,
+               __m256i b)
+{
+  return BYTEWISE (int_mult_16, a, b);
+}
+
+AVX2_INLINE __m256i
+screen_avx2 (__m256i a,
+             __m256i b)
+{
+  return INVERT_8 (BYTEWISE (int_mult_16, INVERT_8 (a), INVERT_8 (b)));
+}
+
+/*  src1 - src2 + 128 and src1 + src2 - 128, clamped by the packing  */
+
+AVX2_INLINE __m256i
+grain_extract_16 (__m256i a,
+                  __m256i b)
+{
+  return _mm256_add_epi16 (_mm256_sub_epi16 (a, b), _mm256_set1_epi16 (128));
+}
+
+AVX2_INLINE __m256i
+grain_extract_avx2 (__m256i a,
+                    __m256i b)
+{
+  return BYTEWISE (grain_extract_16, a, b);
+}
+
+AVX2_INLINE __m256i
+grain_merge_16 (__m256i a,
+                __m256i b)
+{
+  return _mm256_sub_epi16 (_mm256_add_epi16 (a, b), _mm256_set1_epi16 (128));
+}
+
+AVX2_INLINE __m256i
+grain_merge_avx2 (__m256i a,
+                  __m256i b)
+{
+  return BYTEWISE (grain_merge_16, a, b);
+}
+
+AVX2_INLINE __m256i
+hardlight_16 (__m256i a,
+              __m256i b)
+{
+  const __m256i b2 = _mm256_add_epi16 (b, b);
+  __m256i       lo;
+  __m256i       hi;
+
+  /*  src1 * (src2 << 1) >> 8, and 255 - ((255 - src1) *
+   *  (255 - ((src2 - 128) << 1)) >> 8); neither product overflows
+   */
+  lo = _mm256_srli_epi16 (_mm256_mullo_epi16 (a, b2), 8);
+  hi = _mm256_mullo_epi16 (INVERT_16 (a),
+                           _mm256_sub_epi16 (_mm256_set1_epi16 (511), b2));
+  hi = INVERT_16 (_mm256_srli_epi16 (hi, 8));
+
+  return _mm256_blendv_epi8 (lo, hi,
+                             _mm256_cmpgt_epi16 (b, _mm256_set1_epi16 (128)));
+}
+
+AVX2_INLINE __m256i
+hardlight_avx2 (__m256i a,
+                __m256i b)
+{
+  return BYTEWISE (hardlight_16, a, b);
+}
+
+AVX2_INLINE __m256i
+softlight_16 (__m256i a,
+              __m256i b)
+{
+  const __m256i m = int_mult_16 (a, b);
+  const __m256i s = INVERT_16 (int_mult_16 (INVERT_16 (a), INVERT_16 (b)));
+  __m256i       r;
+
+  r = _mm256_add_epi16 (int_mult_16 (INVERT_16 (a), m), int_mult_16 (a, s));
+
+  /*  the generic code truncates the sum to a byte  */
+  return _mm256_and_si256 (r, _mm256_set1_epi16 (0xFF));
+}
+
+AVX2_INLINE __m256i
+softlight_avx2 (__m256i a,
+                __m256i b)
+{
+  return BYTEWISE (softlight_16, a, b);
+}
+
+AVX2_INLINE __m256i
+overlay_32 (__m256i a,
+            __m256i b)
+{
+  const __m256i m = int_mult_32 (_mm256_add_epi32 (b, b),
+                                 _mm256_sub_epi32 (_mm256_set1_epi32 (255), a));
+  const __m256i r = int_mult_32 (a, _mm256_add_epi32 (a, m));
+
+  /*  the generic code truncates the result to a byte  */
+  return _mm256_and_si256 (r, _mm256_set1_epi32 (0xFF));
+}
+
+AVX2_INLINE __m256i
+overlay_16 (__m256i a,
+            __m256i b)
+{
+  return WORDWISE (overlay_32, a, b);
+}
+
+AVX2_INLINE __m256i
+overlay_avx2 (__m256i a,
+              __m256i b)
+{
+  return BYTEWISE (overlay_16, a, b);
+}
+
+/*  The dividing modes divide integers below 2^16 by integers in [1,
+ *  256].  Single precision represents both exactly, and the rounding
+ *  error of the quotient is smaller than its distance to the next
+ *  integer, so truncating it gives the integer division's result.
+ */
+AVX2_INLINE __m256i
+divide_int_32 (__m256i n,
+               __m256i d)
+{
+  return _mm256_cvttps_epi32 (_mm256_div_ps (_mm256_cvtepi32_ps (n),
+                                             _mm256_cvtepi32_ps (d)));
+}
+
+AVX2_INLINE __m256i
+dodge_32 (__m256i a,
+          __m256i b)
+{
+  const __m256i q = divide_int_32 (_mm256_slli_epi32 (a, 8),
+                                   _mm256_sub_epi32 (_mm256_set1_epi32 (256),
+                                                     b));
+
+  return _mm256_min_epi32 (q, _mm256_set1_epi32 (255));
+}
+
+AVX2_INLINE __m256i
+dodge_16 (__m256i a,
+          __m256i b)
+{
+  return WORDWISE (dodge_32, a, b);
+}
+
+AVX2_INLINE __m256i
+dodge_avx2 (__m256i a,
+            __m256i b)
+{
+  return BYTEWISE (dodge_16, a, b);
+}
+
+AVX2_INLINE __m256i
+divide_32 (__m256i a,
+           __m256i b)
+{
+  const __m256i q = divide_int_32 (_mm256_slli_epi32 (a, 8),
+                                   _mm256_add_epi32 (b,
+                                                     _mm256_set1_epi32 (1)));
+
+  return _mm256_min_epi32 (q, _mm256_set1_epi32 (255));
+}
+
+AVX2_INLINE __m256i
+divide_16 (__m256i a,
+           __m256i b)
+{
+  return WORDWISE (divide_32, a, b);
+}
+
+AVX2_INLINE __m256i
+divide_avx2 (__m256i a,
+             __m256i b)
+{
+  return BYTEWISE (divide_16, a, b);
+}
+
+/*  computes what the generic code looks up in burn_lut  */
+AVX2_INLINE __m256i
+burn_32 (__m256i a,
+         __m256i b)
+{
+  const __m256i n = _mm256_slli_epi32 (_mm256_sub_epi32 (_mm256_set1_epi32 (255),
+                                                         a), 8);
+  const __m256i q = divide_int_32 (n, _mm256_add_epi32 (b,
+                                                        _mm256_set1_epi32 (1)));
+
+  return _mm256_max_epi32 (_mm256_sub_epi32 (_mm256_set1_epi32 (255), q),
+                           _mm256_setzero_si256 ());
+}
+
+AVX2_INLINE __m256i
+burn_16 (__m256i a,
+         __m256i b)
+{
+  return WORDWISE (burn_32, a, b);
+}
+
+AVX2_INLINE __m256i
+burn_avx2 (__m256i a,
+           __m256i b)
+{
+  return BYTEWISE (burn_16, a, b);
+}
+
+
+/*  The HSV and HSL modes work on four pixels in each half of a vector
+ *  and repeat every step of gimp_rgb_to_hsv_int(), gimp_hsv_to_rgb_int(),
+ *  gimp_rgb_to_hsl_int() and gimp_hsl_to_rgb_int() in double precision,
+ *  in the same order, so that they round exactly like the generic code.
+ *  Branches become masks; lanes of a branch not taken may divide by
+ *  zero, their results are never selected.
+ */
+
+#define PD(x)  _mm256_set1_pd (x)
+
+#define BLEND_PD(a, b, cond)  _mm256_blendv_pd ((a), (b), (cond))
+#define EQ_PD(a, b)           _mm256_cmp_pd ((a), (b), _CMP_EQ_OQ)
+#define LT_PD(a, b)           _mm256_cmp_pd ((a), (b), _CMP_LT_OQ)
+#define GT_PD(a, b)           _mm256_cmp_pd ((a), (b), _CMP_GT_OQ)
+
+/*  ROUND() of libgimpmath  */
+AVX2_INLINE __m256d
+round_pd (__m256d x)
+{
+  return _mm256_round_pd (_mm256_add_pd (x, PD (0.5)),
+                          _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+}
+
+AVX2_INLINE void
+unpack_rgb_pd (__m128i  pixels,
+               __m256d *r,
+               __m256d *g,
+               __m256d *b)
+{
+  const __m128i mask = _mm_set1_epi32 (0xFF);
+
+  *r = _mm256_cvtepi32_pd (_mm_and_si128 (pixels, mask));
+  *g = _mm256_cvtepi32_pd (_mm_and_si128 (_mm_srli_epi32 (pixels, 8), mask));
+  *b = _mm256_cvtepi32_pd (_mm_and_si128 (_mm_srli_epi32 (pixels, 16), mask));
+}
+
+AVX2_INLINE __m128i
+pack_rgb_pd (__m256d r,
+             __m256d g,
+             __m256d b)
+{
+  return _mm_or_si128 (_mm256_cvttpd_epi32 (r),
+                       _mm_or_si128 (_mm_slli_epi32 (_mm256_cvttpd_epi32 (g), 8),
+                                     _mm_slli_epi32 (_mm256_cvttpd_epi32 (b), 16)));
+}
+
+AVX2_INLINE void
+rgb_to_hsv_pd (__m128i  pixels,
+               __m256d *hue,
+               __m256d *saturation,
+               __m256d *value)
+{
+  __m256d r, g, b;
+  __m256d v, delta, chromatic;
+  __m256d is_r, is_g;
+  __m256d h, s;
+
+  unpack_rgb_pd (pixels, &r, &g, &b);
+
+  v     = _mm256_max_pd (_mm256_max_pd (r, g), b);
+  delta = _mm256_sub_pd (v, _mm256_min_pd (_mm256_min_pd (r, g), b));
+
+  /*  s == 0.0 exactly where delta is zero  */
+  chromatic = _mm256_cmp_pd (delta, _mm256_setzero_pd (), _CMP_NEQ_OQ);
+
+  s = _mm256_div_pd (delta, v);
+
+  is_r = EQ_PD (r, v);
+  is_g = EQ_PD (g, v);
+
+  /*  60.0 * (g - b) / delta, 120 + 60.0 * (b - r) / delta or
+   *  240 + 60.0 * (r - g) / delta
+   */
+  h = BLEND_PD (BLEND_PD (_mm256_sub_pd (r, g), _mm256_sub_pd (b, r), is_g),
+                _mm256_sub_pd (g, b), is_r);
+  h = _mm256_div_pd (_mm256_mul_pd (PD (60.0), h), delta);
+  h = BLEND_PD (_mm256_add_pd (BLEND_PD (PD (240.0), PD (120.0), is_g), h),
+                h, is_r);
+  h = BLEND_PD (h, _mm256_add_pd (h, PD (360.0)),
+                LT_PD (h, _mm256_setzero_pd ()));
+
+  h = round_pd (h);
+  h = _mm256_andnot_pd (EQ_PD (h, PD (360.0)), h);
+
+  *hue        = _mm256_and_pd (h, chromatic);
+  *saturation = _mm256_and_pd (round_pd (_mm256_mul_pd (s, PD (255.0))),
+                               chromatic);
+  *value      = v;
+}
+
+/*  expects a hue below 360, as returned by rgb_to_hsv_pd()  */
+AVX2_INLINE __m128i
+hsv_to_rgb_pd (__m256d hue,
+               __m256d saturation,
+               __m256d value)
+{
+  const __m256d s = _mm256_div_pd (saturation, PD (255.0));
+  const __m256d h = _mm256_div_pd (hue, PD (60.0));
+  const __m256d i = _mm256_floor_pd (h);
+  const __m256d f = _mm256_sub_pd (h, i);
+  __m256d       v = _mm256_div_pd (value, PD (255.0));
+  __m256d       p, q, t;
+  __m256d       r, g, b;
+  __m256d       achromatic;
+
+  p = _mm256_mul_pd (v, _mm256_sub_pd (PD (1.0), s));
+  q = _mm256_mul_pd (v, _mm256_sub_pd (PD (1.0), _mm256_mul_pd (s, f)));
+  t = _mm256_mul_pd (v, _mm256_sub_pd (PD (1.0),
+                                       _mm256_mul_pd (s, _mm256_sub_pd (PD (1.0),
+                                                                        f))));
+
+  p = round_pd (_mm256_mul_pd (p, PD (255.0)));
+  q = round_pd (_mm256_mul_pd (q, PD (255.0)));
+  t = round_pd (_mm256_mul_pd (t, PD (255.0)));
+  v = round_pd (_mm256_mul_pd (v, PD (255.0)));
+
+  /*  the cases 0 to 5 of the switch  */
+  r = BLEND_PD (v, q, EQ_PD (i, PD (1.0)));
+  r = BLEND_PD (r, p, _mm256_and_pd (GT_PD (i, PD (1.0)), LT_PD (i, PD (4.0))));
+  r = BLEND_PD (r, t, EQ_PD (i, PD (4.0)));
+
+  g = BLEND_PD (v, t, EQ_PD (i, PD (0.0)));
+  g = BLEND_PD (g, q, EQ_PD (i, PD (3.0)));
+  g = BLEND_PD (g, p, GT_PD (i, PD (3.0)));
+
+  b = BLEND_PD (p, t, EQ_PD (i, PD (2.0)));
+  b = BLEND_PD (b, v, _mm256_and_pd (GT_PD (i, PD (2.0)), LT_PD (i, PD (5.0))));
+  b = BLEND_PD (b, q, EQ_PD (i, PD (5.0)));
+
+  achromatic = EQ_PD (saturation, _mm256_setzero_pd ());
+
+  return pack_rgb_pd (BLEND_PD (r, value, achromatic),
+                      BLEND_PD (g, value, achromatic),
+                      BLEND_PD (b, value, achromatic));
+}
+
+AVX2_INLINE void
+rgb_to_hsl_pd (__m128i  pixels,
+               __m256d *hue,
+               __m256d *saturation,
+               __m256d *lightness)
+{
+  __m256d r, g, b;
+  __m256d max, min, sum, delta;
+  __m256d chromatic;
+  __m256d is_r, is_g;
+  __m256d h, s, l;
+
+  unpack_rgb_pd (pixels, &r, &g, &b);
+
+  max   = _mm256_max_pd (_mm256_max_pd (r, g), b);
+  min   = _mm256_min_pd (_mm256_min_pd (r, g), b);
+  sum   = _mm256_add_pd (max, min);
+  delta = _mm256_sub_pd (max, min);
+
+  chromatic = _mm256_cmp_pd (max, min, _CMP_NEQ_OQ);
+
+  l = _mm256_div_pd (sum, PD (2.0));
+
+  s = _mm256_div_pd (_mm256_mul_pd (PD (255.0), delta),
+                     BLEND_PD (_mm256_sub_pd (PD (511.0), sum), sum,
+                               LT_PD (l, PD (128.0))));
+
+  is_r = EQ_PD (r, max);
+  is_g = EQ_PD (g, max);
+
+  /*  (g - b) / delta, 2 + (b - r) / delta or 4 + (r - g) / delta  */
+  h = BLEND_PD (BLEND_PD (_mm256_sub_pd (r, g), _mm256_sub_pd (b, r), is_g),
+                _mm256_sub_pd (g, b), is_r);
+  h = _mm256_div_pd (h, delta);
+  h = BLEND_PD (_mm256_add_pd (BLEND_PD (PD (4.0), PD (2.0), is_g), h),
+                h, is_r);
+  h = _mm256_mul_pd (h, PD (42.5));
+  h = BLEND_PD (h, _mm256_add_pd (h, PD (255.0)),
+                LT_PD (h, _mm256_setzero_pd ()));
+
+  *hue        = _mm256_and_pd (round_pd (h), chromatic);
+  *saturation = _mm256_and_pd (round_pd (s), chromatic);
+  *lightness  = round_pd (l);
+}
+
+/*  gimp_hsl_value_int()  */
+AVX2_INLINE __m256d
+hsl_value_pd (__m256d n1,
+              __m256d n2,
+              __m256d hue)
+{
+  __m256d below, t, value;
+
+  hue = BLEND_PD (hue, _mm256_add_pd (hue, PD (255.0)),
+                  LT_PD (hue, _mm256_setzero_pd ()));
+  hue = BLEND_PD (hue, _mm256_sub_pd (hue, PD (255.0)),
+                  GT_PD (hue, PD (255.0)));
+
+  below = LT_PD (hue, PD (42.5));
+
+  /*  n1 + (n2 - n1) * (hue / 42.5), or (170 - hue) / 42.5  */
+  t = BLEND_PD (_mm256_sub_pd (PD (170.0), hue), hue, below);
+  t = _mm256_div_pd (t, PD (42.5));
+  t = _mm256_add_pd (n1, _mm256_mul_pd (_mm256_sub_pd (n2, n1), t));
+
+  value = BLEND_PD (n1, t, LT_PD (hue, PD (170.0)));
+  value = BLEND_PD (value, n2, LT_PD (hue, PD (127.5)));
+  value = BLEND_PD (value, t, below);
+
+  return round_pd (_mm256_mul_pd (value, PD (255.0)));
+}
+
+AVX2_INLINE __m128i
+hsl_to_rgb_pd (__m256d hue,
+               __m256d saturation,
+               __m256d lightness)
+{
+  const __m256d h = hue;
+  const __m256d s = saturation;
+  const __m256d l = lightness;
+  __m256d       m1, m2;
+  __m256d       achromatic;
+
+  /*  (l * (255 + s)) / 65025.0 or (l + s - (l * s) / 255.0) / 255.0  */
+  m2 = BLEND_PD (_mm256_div_pd (_mm256_sub_pd (_mm256_add_pd (l, s),
+                                               _mm256_div_pd (_mm256_mul_pd (l, s),
+                                                              PD (255.0))),
+                                PD (255.0)),
+                 _mm256_div_pd (_mm256_mul_pd (l, _mm256_add_pd (PD (255.0), s)),
+                                PD (65025.0)),
+                 LT_PD (l, PD (128.0)));
+  m1 = _mm256_sub_pd (_mm256_div_pd (l, PD (127.5)), m2);
+
+  achromatic = EQ_PD (s, _mm256_setzero_pd ());
+
+  return pack_rgb_pd (BLEND_PD (hsl_value_pd (m1, m2,
+                                              _mm256_add_pd (h, PD (85.0))),
+                                l, achromatic),
+                      BLEND_PD (hsl_value_pd (m1, m2, h),
+                                l, achromatic),
+                      BLEND_PD (hsl_value_pd (m1, m2,
+                                              _mm256_sub_pd (h, PD (85.0))),
+                                l, achromatic));
+}
+
+/*  Apply @op, a function of two vectors of four pixels, to both halves
+ *  of @a and @b.
+ */
+#define PIXELWISE(op, a, b)                                                  \
+  _mm256_setr_m128i (op (_mm256_castsi256_si128 (a),                          \
+                         _mm256_castsi256_si128 (b)),                         \
+                     op (_mm256_extracti128_si256 ((a), 1),                   \
+                         _mm256_extracti128_si256 ((b), 1)))
+
+AVX2_INLINE __m128i
+hue_pd (__m128i a,
+        __m128i b)
+{
+  __m256d h1, s1, v1;
+  __m256d h2, s2, v2;
+
+  rgb_to_hsv_pd (a, &h1, &s1, &v1);
+  rgb_to_hsv_pd (b, &h2, &s2, &v2);
+
+  /*  keep the hue of A where B has no saturation (see bug #123296)  */
+  h1 = BLEND_PD (h2, h1, EQ_PD (s2, _mm256_setzero_pd ()));
+
+  return hsv_to_rgb_pd (h1, s1, v1);
+}
+
+AVX2_INLINE __m256i
+hue_avx2 (__m256i a,
+          __m256i b)
+{
+  return PIXELWISE (hue_pd, a, b);
+}
+
+AVX2_INLINE __m128i
+saturation_pd (__m128i a,
+               __m128i b)
+{
+  __m256d h1, s1, v1;
+  __m256d h2, s2, v2;
+
+  rgb_to_hsv_pd (a, &h1, &s1, &v1);
+  rgb_to_hsv_pd (b, &h2, &s2, &v2);
+
+  return hsv_to_rgb_pd (h1, s2, v1);
+}
+
+AVX2_INLINE __m256i
+saturation_avx2 (__m256i a,
+                 __m256i b)
+{
+  return PIXELWISE (saturation_pd, a, b);
+}
+
+AVX2_INLINE __m128i
+value_pd (__m128i a,
+          __m128i b)
+{
+  __m256d h1, s1, v1;
+  __m256d h2, s2, v2;
+
+  rgb_to_hsv_pd (a, &h1, &s1, &v1);
+  rgb_to_hsv_pd (b, &h2, &s2, &v2);
+
+  return hsv_to_rgb_pd (h1, s1, v2);
+}
+
+AVX2_INLINE __m256i
+value_avx2 (__m256i a,
+            __m256i b)
+{
+  return PIXELWISE (value_pd, a, b);
+}
+
+AVX2_INLINE __m128i
+color_only_pd (__m128i a,
+               __m128i b)
+{
+  __m256d h1, s1, l1;
+  __m256d h2, s2, l2;
+
+  rgb_to_hsl_pd (a, &h1, &s1, &l1);
+  rgb_to_hsl_pd (b, &h2, &s2, &l2);
+
+  return hsl_to_rgb_pd (h2, s2, l1);
+}
+
+AVX2_INLINE __m256i
+color_only_avx2 (__m256i a,
+                 __m256i b)
+{
+  return PIXELWISE (color_only_pd, a, b);
+}
+
+
+static AVX2_FUNC void
+gimp_composite_swap_avx2 (GimpCompositeContext *ctx)
+{
+  guchar *A       = ctx->A;
+  guchar *B       = ctx->B;
+  gulong  n_bytes = ctx->n_pixels * gimp_composite_pixel_bpp[ctx->pixelformat_A];
+
+  for (; n_bytes >= 32; n_bytes -= 32)
+    {
+      const __m256i a = _mm256_loadu_si256 ((const __m256i *) A);
+      const __m256i b = _mm256_loadu_si256 ((const __m256i *) B);
+
+      _mm256_storeu_si256 ((__m256i *) A, b);
+      _mm256_storeu_si256 ((__m256i *) B, a);
+
+      A += 32;
+      B += 32;
+    }
+
+  while (n_bytes--)
+    {
+      guchar tmp = *B;
+
+      *B++ = *A;
+      *A++ = tmp;
+    }
+}
+
+
+AVX2_FUNC void
+gimp_composite_addition_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, addition_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_burn_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, burn_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_color_only_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, color_only_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_darken_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, darken_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_difference_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, difference_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_divide_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, divide_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_dodge_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, dodge_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_grain_extract_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, grain_extract_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_grain_merge_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, grain_merge_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_hardlight_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, hardlight_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_hue_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, hue_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_lighten_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, lighten_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_multiply_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, multiply_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_overlay_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, overlay_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_saturation_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, saturation_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_screen_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, screen_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_softlight_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, softlight_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_subtract_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, subtract_avx2, RGBA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_value_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, value_avx2, RGBA8_ALPHA_MASK);
+}
+
+void
+gimp_composite_swap_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx)
+{
+  gimp_composite_swap_avx2 (ctx);
+}
+
+
+AVX2_FUNC void
+gimp_composite_addition_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, addition_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_burn_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, burn_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_darken_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, darken_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_difference_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, difference_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_divide_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, divide_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_dodge_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, dodge_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_grain_extract_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, grain_extract_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_grain_merge_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, grain_merge_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_hardlight_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, hardlight_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_lighten_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, lighten_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_multiply_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, multiply_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_overlay_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, overlay_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_screen_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, screen_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_softlight_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, softlight_avx2, VA8_ALPHA_MASK);
+}
+
+AVX2_FUNC void
+gimp_composite_subtract_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  COMPOSITE_AVX2 (ctx, subtract_avx2, VA8_ALPHA_MASK);
+}
+
+void
+gimp_composite_swap_va8_va8_va8_avx2 (GimpCompositeContext *ctx)
+{
+  gimp_composite_swap_avx2 (ctx);
+}
+
+#endif /* COMPILE_AVX2_IS_OKAY */
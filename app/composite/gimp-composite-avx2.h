@@ -0,0 +1,58 @@
+#ifndef gimp_composite_avx2_h
+#define gimp_composite_avx2_h
+
+extern gboolean gimp_composite_avx2_init (void);
+
+/*
+ * The function gimp_composite_*_install() is defined in the code generated by make-install.py
+ * I hate to create a .h file just for that declaration, so I do it here (for now).
+ */
+extern gboolean gimp_composite_avx2_install (void);
+
+/*  The AVX2 code uses intrinsics with function target attributes, so
+ *  it needs neither inline assembly nor extra CFLAGS.
+ */
+#if defined(HAVE_AVX2_INTRINSICS)
+#define COMPILE_AVX2_IS_OKAY (1)
+#endif /* defined(HAVE_AVX2_INTRINSICS) */
+
+#ifdef COMPILE_AVX2_IS_OKAY
+extern void gimp_composite_addition_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_burn_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_color_only_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_darken_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_difference_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_divide_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_dodge_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_grain_extract_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_grain_merge_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_hardlight_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_hue_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_lighten_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_multiply_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_overlay_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_saturation_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_screen_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_softlight_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_subtract_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_value_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_swap_rgba8_rgba8_rgba8_avx2 (GimpCompositeContext *ctx);
+
+extern void gimp_composite_addition_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_burn_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_darken_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_difference_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_divide_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_dodge_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_grain_extract_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_grain_merge_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_hardlight_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_lighten_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_multiply_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_overlay_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_screen_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_softlight_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_subtract_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+extern void gimp_composite_swap_va8_va8_va8_avx2 (GimpCompositeContext *ctx);
+#endif
+#endif
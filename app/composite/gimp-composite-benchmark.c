@@ -0,0 +1,175 @@
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "gimp-composite.h"
+#include "gimp-composite-regression.h"
+#include "gimp-composite-util.h"
+#include "gimp-composite-generic.h"
+#include "gimp-composite-3dnow.h"
+#include "gimp-composite-altivec.h"
+#include "gimp-composite-avx2.h"
+#include "gimp-composite-mmx.h"
+#include "gimp-composite-sse.h"
+#include "gimp-composite-sse2.h"
+#include "gimp-composite-vis.h"
+
+/*
+ * Reports the throughput of every backend which implements an
+ * operation for RGBA8 or VA8 pixels, in million pixels per second.
+ * Each backend is installed on its own on top of the generic code,
+ * so the numbers show what it does, not what the backends installed
+ * after it override.
+ */
+
+static const struct
+{
+  char     *name;
+  gboolean (*install) (void);
+} backends[] =
+{
+  { "generic", NULL                           },
+  { "mmx",     gimp_composite_mmx_install     },
+  { "sse",     gimp_composite_sse_install     },
+  { "sse2",    gimp_composite_sse2_install    },
+  { "3dnow",   gimp_composite_3dnow_install   },
+  { "altivec", gimp_composite_altivec_install },
+  { "vis",     gimp_composite_vis_install     },
+  { "avx2",    gimp_composite_avx2_install    }
+};
+
+static const GimpCompositeOperation operations[] =
+{
+  GIMP_COMPOSITE_MULTIPLY,
+  GIMP_COMPOSITE_SCREEN,
+  GIMP_COMPOSITE_OVERLAY,
+  GIMP_COMPOSITE_DIFFERENCE,
+  GIMP_COMPOSITE_ADDITION,
+  GIMP_COMPOSITE_SUBTRACT,
+  GIMP_COMPOSITE_DARKEN,
+  GIMP_COMPOSITE_LIGHTEN,
+  GIMP_COMPOSITE_HUE,
+  GIMP_COMPOSITE_SATURATION,
+  GIMP_COMPOSITE_COLOR_ONLY,
+  GIMP_COMPOSITE_VALUE,
+  GIMP_COMPOSITE_DIVIDE,
+  GIMP_COMPOSITE_DODGE,
+  GIMP_COMPOSITE_BURN,
+  GIMP_COMPOSITE_HARDLIGHT,
+  GIMP_COMPOSITE_SOFTLIGHT,
+  GIMP_COMPOSITE_GRAIN_EXTRACT,
+  GIMP_COMPOSITE_GRAIN_MERGE,
+  GIMP_COMPOSITE_SWAP
+};
+
+static const GimpPixelFormat formats[] =
+{
+  GIMP_PIXELFORMAT_VA8,
+  GIMP_PIXELFORMAT_RGBA8
+};
+
+static int
+gimp_composite_benchmark (int iterations, int n_pixels)
+{
+  GimpCompositeContext ctx;
+  guchar *A;
+  guchar *B;
+  guchar *D;
+  guint i, j, k;
+
+  A = (guchar *) gimp_composite_regression_random_rgba8 (n_pixels + 1);
+  B = (guchar *) gimp_composite_regression_random_rgba8 (n_pixels + 1);
+  D = (guchar *) calloc (sizeof (gimp_rgba8_t), n_pixels + 1);
+
+  for (i = 0; i < G_N_ELEMENTS (operations); i++)
+    for (j = 0; j < G_N_ELEMENTS (formats); j++)
+      {
+        const GimpCompositeOperation  op     = operations[i];
+        const GimpPixelFormat         format = formats[j];
+        void (*generic) (GimpCompositeContext *);
+        gchar *name;
+
+        gimp_composite_generic_install ();
+
+        generic = gimp_composite_function[op][format][format][format];
+
+        name = g_strdup_printf ("%s_%s",
+                                gimp_composite_mode_astext (op) +
+                                strlen ("GIMP_COMPOSITE_"),
+                                gimp_composite_pixelformat_astext (format));
+
+        for (k = 0; k < G_N_ELEMENTS (backends); k++)
+          {
+            double t;
+
+            gimp_composite_generic_install ();
+
+            if (backends[k].install)
+              {
+                if (! backends[k].install ())
+                  continue;
+
+                /*  skip the operations the backend leaves to the generic code  */
+                if (gimp_composite_function[op][format][format][format] == generic)
+                  continue;
+              }
+
+            gimp_composite_context_init (&ctx, op, format, format, format, format,
+                                         n_pixels, A, B, B, D);
+
+            t = gimp_composite_regression_time_function (iterations,
+                                                         gimp_composite_dispatch,
+                                                         &ctx);
+
+            gimp_composite_regression_throughput_report (name, backends[k].name,
+                                                         n_pixels, iterations, t);
+          }
+
+        g_free (name);
+      }
+
+  free (A);
+  free (B);
+  free (D);
+
+  return EXIT_SUCCESS;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int iterations;
+  int n_pixels;
+
+  srand (314159);
+
+  iterations = 10;
+  n_pixels = 1048593;
+
+  argv++, argc--;
+  while (argc >= 2)
+    {
+      if (argc > 1 && (strcmp (argv[0], "--iterations") == 0 || strcmp (argv[0], "-i") == 0))
+        {
+          iterations = atoi(argv[1]);
+          argc -= 2, argv++; argv++;
+        }
+      else if (argc > 1 && (strcmp (argv[0], "--n-pixels") == 0 || strcmp (argv[0], "-n") == 0))
+        {
+          n_pixels = atoi (argv[1]);
+          argc -= 2, argv++; argv++;
+        }
+      else
+        {
+          g_print ("Usage: gimp-composite-benchmark [-i|--iterations n] [-n|--n-pixels n]");
+          return EXIT_FAILURE;
+        }
+    }
+
+  return gimp_composite_benchmark (iterations, n_pixels);
+}
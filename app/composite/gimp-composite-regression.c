@@ -456,6 +456,24 @@ gimp_composite_regression_time_function (gulong iterations, GimpCompositeRegress
   return (tv_to_secs (tv_elapsed));
 }
 
+/**
+ * gimp_composite_regression_throughput_report:
+ * @name:
+ * @backend:
+ * @n_pixels:
+ * @iterations:
+ * @t:
+ *
+ * Report the number of million pixels per second which @backend
+ * composited, given it took @t seconds for @iterations runs over
+ * @n_pixels pixels.
+ **/
+void
+gimp_composite_regression_throughput_report (char *name, char *backend, gulong n_pixels, gulong iterations, double t)
+{
+  g_print ("%-32s %-8s %10.2f Mpix/s\n", name, backend, (double) n_pixels * iterations / (t * 1000000.0));
+}
+
 /**
  * gimp_composite_regression_random_rgba8:
  * @n_pixels:
@@ -124,6 +124,11 @@ extern void                  gimp_composite_regression_print_va8          (gimp_
 extern void                  gimp_composite_regression_timer_report       (char                        *name,
 									   double                       t1,
 									   double                       t2);
+extern void                  gimp_composite_regression_throughput_report  (char                        *name,
+									   char                        *backend,
+									   gulong                       n_pixels,
+									   gulong                       iterations,
+									   double                       t);
 extern gimp_rgba8_t *        gimp_composite_regression_random_rgba8       (gulong                       n_pixels);
 extern gimp_rgba8_t *        gimp_composite_regression_fixed_rgba8        (gulong                       n_pixels);
 extern GimpCompositeContext *gimp_composite_context_init                  (GimpCompositeContext        *ctx,
@@ -50,8 +50,10 @@ enum
   PROP_0,
   PROP_TEMP_PATH,
   PROP_SWAP_PATH,
+  PROP_SWAP_ASYNC,
   PROP_NUM_PROCESSORS,
   PROP_TILE_CACHE_SIZE,
+  PROP_TILE_COMPRESSION_SIZE,
 
   /* ignored, only for backward compatibility: */
   PROP_STINGY_MEMORY_USE
@@ -128,6 +130,15 @@ gimp_base_config_class_init (GimpBaseConfigClass *klass)
                                  "${gimp_dir}",
                                  GIMP_PARAM_STATIC_STRINGS |
                                  GIMP_CONFIG_PARAM_RESTART);
+  GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_SWAP_ASYNC,
+                                    "swap-async", SWAP_ASYNC_BLURB,
+#ifdef ENABLE_MP
+                                    TRUE,
+#else
+                                    FALSE,
+#endif
+                                    GIMP_PARAM_STATIC_STRINGS |
+                                    GIMP_CONFIG_PARAM_RESTART);
 
   num_processors = get_number_of_processors ();
 
@@ -159,6 +170,14 @@ gimp_base_config_class_init (GimpBaseConfigClass *klass)
                                     GIMP_PARAM_STATIC_STRINGS |
                                     GIMP_CONFIG_PARAM_CONFIRM);
 
+  /*  a quarter of the tile cache, so about an eighth of the memory  */
+  GIMP_CONFIG_INSTALL_PROP_MEMSIZE (object_class, PROP_TILE_COMPRESSION_SIZE,
+                                    "tile-compression-size",
+                                    TILE_COMPRESSION_SIZE_BLURB,
+                                    0, GIMP_MAX_MEM_PROCESS,
+                                    memory_size / 4,
+                                    GIMP_PARAM_STATIC_STRINGS);
+
   /*  only for backward compatibility:  */
   GIMP_CONFIG_INSTALL_PROP_BOOLEAN (object_class, PROP_STINGY_MEMORY_USE,
                                     "stingy-memory-use", NULL,
@@ -204,12 +223,18 @@ gimp_base_config_set_property (GObject      *object,
       g_free (base_config->swap_path);
       base_config->swap_path = g_value_dup_string (value);
       break;
+    case PROP_SWAP_ASYNC:
+      base_config->swap_async = g_value_get_boolean (value);
+      break;
     case PROP_NUM_PROCESSORS:
       base_config->num_processors = g_value_get_uint (value);
       break;
     case PROP_TILE_CACHE_SIZE:
       base_config->tile_cache_size = g_value_get_uint64 (value);
       break;
+    case PROP_TILE_COMPRESSION_SIZE:
+      base_config->tile_compression_size = g_value_get_uint64 (value);
+      break;
 
     case PROP_STINGY_MEMORY_USE:
       /* ignored */
@@ -237,12 +262,18 @@ gimp_base_config_get_property (GObject    *object,
     case PROP_SWAP_PATH:
       g_value_set_string (value, base_config->swap_path);
       break;
+    case PROP_SWAP_ASYNC:
+      g_value_set_boolean (value, base_config->swap_async);
+      break;
     case PROP_NUM_PROCESSORS:
       g_value_set_uint (value, base_config->num_processors);
       break;
     case PROP_TILE_CACHE_SIZE:
       g_value_set_uint64 (value, base_config->tile_cache_size);
       break;
+    case PROP_TILE_COMPRESSION_SIZE:
+      g_value_set_uint64 (value, base_config->tile_compression_size);
+      break;
 
     case PROP_STINGY_MEMORY_USE:
       /* ignored */
@@ -39,8 +39,10 @@ struct _GimpBaseConfig
 
   gchar    *temp_path;
   gchar    *swap_path;
+  gboolean  swap_async;
   guint     num_processors;
   guint64   tile_cache_size;
+  guint64   tile_compression_size;
 };
 
 struct _GimpBaseConfigClass
@@ -392,6 +392,12 @@ N_("Sets the swap file location. GIMP uses a tile based memory allocation " \
    "a folder that is mounted over NFS.  For these reasons, it may be " \
    "desirable to put your swap file in \"/tmp\".")
 
+#define SWAP_ASYNC_BLURB \
+N_("When enabled, tiles are written to the swap file by a background " \
+   "thread which batches adjacent tiles into large writes, and tiles " \
+   "next to the one being swapped in are read ahead.  This keeps painting " \
+   "responsive while GIMP is swapping.")
+
 #define TEAROFF_MENUS_BLURB \
 N_("When enabled, menus can be torn off.")
 
@@ -430,6 +436,12 @@ N_("When the amount of pixel data exceeds this limit, GIMP will start to " \
    "work on images that wouldn't fit into memory otherwise.  If you have a " \
    "lot of RAM, you may want to set this to a higher value.")
 
+#define TILE_COMPRESSION_SIZE_BLURB \
+N_("Tiles that have to leave the tile cache are kept compressed in " \
+   "memory, up to this amount, before they are swapped to disk.  Flat " \
+   "areas, masks and selections compress very well.  Set this to zero " \
+   "to swap tiles out directly.")
+
 #define TOOLBOX_COLOR_AREA_BLURB \
 N_("Show the current foreground and background colors in the toolbox.")
 
@@ -26,11 +26,13 @@
 
 #include "core-types.h"
 
+#include "base/pixel-processor.h"
 #include "base/pixel-region.h"
 #include "base/pixel-surround.h"
 #include "base/tile-manager.h"
 #include "base/tile.h"
 
+#include "paint-funcs/sample-weighted.h"
 #include "paint-funcs/scale-region.h"
 
 #include "gimp-transform-region.h"
@@ -41,67 +43,35 @@
 #include "gimpprogress.h"
 
 
+typedef struct
+{
+  TileManager           *orig_tiles;
+  GimpInterpolationType  interpolation;
+  gint                   dest_x1;
+  gint                   dest_y1;
+  gint                   u1, v1, u2, v2;  /* source bounding box            */
+  GimpMatrix3            m;               /* destination to source          */
+  gboolean               affine;          /* m leaves the divisor at 1      */
+  gboolean               supersample;     /* whether an affine m needs it   */
+  gint                   alpha;
+  gint                   recursion_level;
+  const guchar          *bg_color;
+  const gfloat          *lanczos;         /* Lanczos lookup table           */
+} TransformInfo;
+
+
 /*  forward function prototypes  */
 
-static void  gimp_transform_region_nearest (TileManager       *orig_tiles,
-                                            PixelRegion       *destPR,
-                                            gint               dest_x1,
-                                            gint               dest_y1,
-                                            gint               dest_x2,
-                                            gint               dest_y2,
-                                            gint               u1,
-                                            gint               v1,
-                                            gint               u2,
-                                            gint               v2,
-                                            const GimpMatrix3 *m,
-                                            gint               alpha,
-                                            const guchar      *bg_color,
-                                            GimpProgress      *progress);
-static void  gimp_transform_region_linear  (TileManager       *orig_tiles,
-                                            PixelRegion       *destPR,
-                                            gint               dest_x1,
-                                            gint               dest_y1,
-                                            gint               dest_x2,
-                                            gint               dest_y2,
-                                            gint               u1,
-                                            gint               v1,
-                                            gint               u2,
-                                            gint               v2,
-                                            const GimpMatrix3 *m,
-                                            gint               alpha,
-                                            gint               recursion_level,
-                                            const guchar      *bg_color,
-                                            GimpProgress      *progress);
-static void  gimp_transform_region_cubic   (TileManager       *orig_tiles,
-                                            PixelRegion       *destPR,
-                                            gint               dest_x1,
-                                            gint               dest_y1,
-                                            gint               dest_x2,
-                                            gint               dest_y2,
-                                            gint               u1,
-                                            gint               v1,
-                                            gint               u2,
-                                            gint               v2,
-                                            const GimpMatrix3 *m,
-                                            gint               alpha,
-                                            gint               recursion_level,
-                                            const guchar      *bg_color,
-                                            GimpProgress      *progress);
-static void  gimp_transform_region_lanczos (TileManager       *orig_tiles,
-                                            PixelRegion       *destPR,
-                                            gint               dest_x1,
-                                            gint               dest_y1,
-                                            gint               dest_x2,
-                                            gint               dest_y2,
-                                            gint               u1,
-                                            gint               v1,
-                                            gint               u2,
-                                            gint               v2,
-                                            const GimpMatrix3 *m,
-                                            gint               alpha,
-                                            gint               recursion_level,
-                                            const guchar      *bg_color,
-                                            GimpProgress      *progress);
+static void  gimp_transform_region_chunk   (TransformInfo       *info,
+                                            PixelRegion         *destPR);
+static void  gimp_transform_region_pixel   (const TransformInfo *info,
+                                            PixelSurround       *surround,
+                                            PixelSurround       *super,
+                                            gboolean             supersample,
+                                            const gdouble       *u,
+                                            const gdouble       *v,
+                                            guchar              *d,
+                                            gint                 bytes);
 
 static inline void  untransform_coords     (const GimpMatrix3 *m,
                                             const gint         x,
@@ -125,7 +95,7 @@ static inline gboolean supersample_dtest   (const gdouble u0,
                                             const gdouble u3,
                                             const gdouble v3);
 
-static void     sample_adapt      (TileManager   *tm,
+static void     sample_adapt      (PixelSurround *surround,
                                    const gdouble  xc,
                                    const gdouble  yc,
                                    const gdouble  x0,
@@ -138,7 +108,6 @@ static void     sample_adapt      (TileManager   *tm,
                                    const gdouble  y3,
                                    const gint     level,
                                    guchar        *color,
-                                   const guchar  *bg_color,
                                    gint           bpp,
                                    gint           alpha);
 
@@ -181,11 +150,14 @@ gimp_transform_region (GimpPickable          *pickable,
                        gint                   recursion_level,
                        GimpProgress          *progress)
 {
-  GimpImageType  pickable_type;
-  GimpMatrix3    m;
-  gint           u1, v1, u2, v2;       /* source bounding box */
-  gint           alpha;
-  guchar         bg_color[MAX_CHANNELS];
+  TransformInfo               info;
+  GimpImageType               pickable_type;
+  GimpMatrix3                 m;
+  gint                        u1, v1, u2, v2;  /* source bounding box */
+  gint                        alpha;
+  guchar                      bg_color[MAX_CHANNELS];
+  gfloat                     *lanczos       = NULL;
+  PixelProcessorProgressFunc  progress_func = NULL;
 
   g_return_if_fail (GIMP_IS_PICKABLE (pickable));
 
@@ -241,452 +213,266 @@ gimp_transform_region (GimpPickable          *pickable,
   if (tile_manager_bpp (orig_tiles) == 1)
     alpha = 0;
 
-  switch (interpolation_type)
-    {
-    case GIMP_INTERPOLATION_NONE:
-      gimp_transform_region_nearest (orig_tiles, destPR,
-                                     dest_x1, dest_y1, dest_x2, dest_y2,
-                                     u1, v1, u2, v2,
-                                     &m, alpha, bg_color, progress);
-      break;
-
-    case GIMP_INTERPOLATION_LINEAR:
-      gimp_transform_region_linear (orig_tiles, destPR,
-                                    dest_x1, dest_y1, dest_x2, dest_y2,
-                                    u1, v1, u2, v2,
-                                    &m, alpha, recursion_level,
-                                    bg_color, progress);
-      break;
-
-    case GIMP_INTERPOLATION_CUBIC:
-      gimp_transform_region_cubic (orig_tiles, destPR,
-                                   dest_x1, dest_y1, dest_x2, dest_y2,
-                                   u1, v1, u2, v2,
-                                   &m, alpha, recursion_level,
-                                   bg_color, progress);
-      break;
-
-    case GIMP_INTERPOLATION_LANCZOS:
-      gimp_transform_region_lanczos (orig_tiles, destPR,
-                                     dest_x1, dest_y1, dest_x2, dest_y2,
-                                     u1, v1, u2, v2,
-                                     &m, alpha, recursion_level,
-                                     bg_color, progress);
-      break;
-    }
-}
-
-static void
-gimp_transform_region_nearest (TileManager        *orig_tiles,
-                               PixelRegion        *destPR,
-                               gint                dest_x1,
-                               gint                dest_y1,
-                               gint                dest_x2,
-                               gint                dest_y2,
-                               gint                u1,
-                               gint                v1,
-                               gint                u2,
-                               gint                v2,
-                               const GimpMatrix3  *m,
-                               gint                alpha,
-                               const guchar       *bg_color,
-                               GimpProgress       *progress)
-{
-  gdouble   uinc, vinc, winc;  /* increments in source coordinates  */
-  gint      pixels;
-  gint      total;
-  gint      n;
-  gpointer  pr;
+  info.orig_tiles      = orig_tiles;
+  info.interpolation   = interpolation_type;
+  info.dest_x1         = dest_x1;
+  info.dest_y1         = dest_y1;
+  info.u1              = u1;
+  info.v1              = v1;
+  info.u2              = u2;
+  info.v2              = v2;
+  info.m               = m;
+  info.alpha           = alpha;
+  info.recursion_level = recursion_level;
+  info.bg_color        = bg_color;
+
+  /*  the divisor of an affine transform is 1 everywhere, and the quad
+   *  around every pixel has the same shape.  Look at the matrix before
+   *  it was inverted, the inverse's last row is rounded off.
+   */
+  info.affine = (matrix->coeff[2][0] == 0.0 &&
+                 matrix->coeff[2][1] == 0.0 &&
+                 matrix->coeff[2][2] == 1.0);
 
-  uinc = m->coeff[0][0];
-  vinc = m->coeff[1][0];
-  winc = m->coeff[2][0];
+  info.supersample = FALSE;
 
-  total = destPR->w * destPR->h;
+  if (info.affine && interpolation_type != GIMP_INTERPOLATION_NONE)
+    info.supersample = supersample_dtest (- m.coeff[0][0], - m.coeff[1][0],
+                                          - m.coeff[0][1], - m.coeff[1][1],
+                                          m.coeff[0][0],   m.coeff[1][0],
+                                          m.coeff[0][1],   m.coeff[1][1]);
 
-  for (pr = pixel_regions_register (1, destPR), pixels = 0, n = 0;
-       pr != NULL;
-       pr = pixel_regions_process (pr), n++)
-    {
-      guchar *dest = destPR->data;
-      gint    y;
+  if (interpolation_type == GIMP_INTERPOLATION_LANCZOS)
+    lanczos = create_lanczos_lookup ();
 
-      for (y = destPR->y; y < destPR->y + destPR->h; y++)
-        {
-          gint     x     = dest_x1 + destPR->x;
-          gint     width = destPR->w;
-          guchar  *d     = dest;
-          gdouble  tu, tv, tw;   /* undivided source coordinates and divisor */
+  info.lanczos = lanczos;
 
-          /* set up inverse transform steps */
-          tu = uinc * (x + .5) + m->coeff[0][1] * (dest_y1 + y + .5) + m->coeff[0][2];
-          tv = vinc * (x + .5) + m->coeff[1][1] * (dest_y1 + y + .5) + m->coeff[1][2];
-          tw = winc * (x + .5) + m->coeff[2][1] * (dest_y1 + y + .5) + m->coeff[2][2];
+  if (progress)
+    progress_func = (PixelProcessorProgressFunc) gimp_progress_set_value;
 
-          while (width--)
-            {
-              gdouble u, v; /* source coordinates */
-              gint    iu, iv;
+  pixel_regions_process_parallel_progress ((PixelProcessorFunc)
+                                           gimp_transform_region_chunk,
+                                           &info,
+                                           progress_func, progress,
+                                           1, destPR);
 
-              /*  normalize homogeneous coords  */
-              normalize_coords (1, &tu, &tv, &tw, &u, &v);
+  g_free (lanczos);
+}
 
-              /* EPSILON here is useful to make floating point arithmetic
-               * rounding errors consistent when the exact computation
-               * results in a 'integer and a half'
-               */
+/* EPSILON here is useful to make floating point arithmetic
+ * rounding errors consistent when the exact computation
+ * results in a 'integer and a half'
+ */
 #define EPSILON 1.e-5
-              iu = floor (u + 0.5 + EPSILON);
-              iv = floor (v + 0.5 + EPSILON);
-
-              /*  Set the destination pixels  */
-              if (iu >= u1 && iu < u2 &&
-                  iv >= v1 && iv < v2)
-                {
-                  tile_manager_read_pixel_data_1 (orig_tiles, iu - u1, iv - v1,
-                                                  d);
 
-                  d += destPR->bytes;
-                }
-              else /* not in source range */
-                {
-                  gint b;
-
-                  for (b = 0; b < destPR->bytes; b++)
-                    *d++ = bg_color[b];
-                }
-
-              tu += uinc;
-              tv += vinc;
-              tw += winc;
-            }
-
-          dest += destPR->rowstride;
-        }
-
-      if (progress)
-        {
-          pixels += destPR->w * destPR->h;
-
-          if (n % 16 == 0)
-            gimp_progress_set_value (progress,
-                                     (gdouble) pixels / (gdouble) total);
-        }
-    }
+static inline gint
+nearest_coord (gdouble u)
+{
+  return floor (u + 0.5 + EPSILON);
 }
 
+#undef EPSILON
+
 static void
-gimp_transform_region_linear (TileManager        *orig_tiles,
-                              PixelRegion        *destPR,
-                              gint                dest_x1,
-                              gint                dest_y1,
-                              gint                dest_x2,
-                              gint                dest_y2,
-                              gint                u1,
-                              gint                v1,
-                              gint                u2,
-                              gint                v2,
-                              const GimpMatrix3  *m,
-                              gint                alpha,
-                              gint                recursion_level,
-                              const guchar       *bg_color,
-                              GimpProgress       *progress)
+gimp_transform_region_chunk (TransformInfo *info,
+                             PixelRegion   *destPR)
 {
-  PixelSurround *surround;
-  gdouble        uinc, vinc, winc;  /* increments in source coordinates  */
-  gint           pixels;
-  gint           total;
-  gint           n;
-  gpointer       pr;
-
-  surround = pixel_surround_new (orig_tiles, 2, 2, PIXEL_SURROUND_BACKGROUND);
-  pixel_surround_set_bg (surround, bg_color);
+  const GimpMatrix3 *m     = &info->m;
+  const gint         bytes = destPR->bytes;
+  const gdouble      uinc  = m->coeff[0][0];
+  const gdouble      vinc  = m->coeff[1][0];
+  const gdouble      winc  = m->coeff[2][0];
+  PixelSurround     *surround;
+  PixelSurround     *super = NULL;
+  guchar            *dest  = destPR->data;
+  gint              *iu    = NULL;    /* source pixels of a row, nearest */
+  gint              *iv    = NULL;
+  gint               size;
+  gint               x, y;
+
+  /*  every chunk has its own surrounds, they share only the tile locking  */
+  switch (info->interpolation)
+    {
+    case GIMP_INTERPOLATION_NONE:    size = 1;              break;
+    case GIMP_INTERPOLATION_LINEAR:  size = 2;              break;
+    case GIMP_INTERPOLATION_CUBIC:   size = 4;              break;
+    case GIMP_INTERPOLATION_LANCZOS: size = LANCZOS_WIDTH2; break;
+    default:
+      g_assert_not_reached ();
+      return;
+    }
 
-  uinc = m->coeff[0][0];
-  vinc = m->coeff[1][0];
-  winc = m->coeff[2][0];
+  surround = pixel_surround_new (info->orig_tiles, size, size,
+                                 PIXEL_SURROUND_BACKGROUND);
+  pixel_surround_set_bg (surround, info->bg_color);
+  pixel_surround_set_parallel (surround, TRUE);
 
-  total = destPR->w * destPR->h;
+  /*  supersampling interpolates linearly  */
+  if (info->interpolation == GIMP_INTERPOLATION_NONE)
+    {
+      iu = g_new (gint, destPR->w);
+      iv = g_new (gint, destPR->w);
+    }
+  else if (info->interpolation == GIMP_INTERPOLATION_LINEAR)
+    {
+      super = surround;
+    }
+  else if (! info->affine || info->supersample)
+    {
+      super = pixel_surround_new (info->orig_tiles, 2, 2,
+                                  PIXEL_SURROUND_BACKGROUND);
+      pixel_surround_set_bg (super, info->bg_color);
+      pixel_surround_set_parallel (super, TRUE);
+    }
 
-  for (pr = pixel_regions_register (1, destPR), pixels = 0, n = 0;
-       pr != NULL;
-       pr = pixel_regions_process (pr), n++)
+  for (y = 0; y < destPR->h; y++, dest += destPR->rowstride)
     {
-      guchar *dest = destPR->data;
-      gint    y;
+      const gint  dx = info->dest_x1 + destPR->x;
+      const gint  dy = info->dest_y1 + destPR->y + y;
+      guchar     *d  = dest;
+      gdouble     u[5], v[5];          /* source coordinates, centre first */
 
-      for (y = destPR->y; y < destPR->y + destPR->h; y++)
+      if (info->affine)
         {
-          guchar  *d     = dest;
-          gint     width = destPR->w;
-          gdouble  tu[5], tv[5];   /* undivided source coordinates */
-          gdouble  tw[5];          /* divisor                      */
-
-          /* set up inverse transform steps */
-          untransform_coords (m, dest_x1 + destPR->x, dest_y1 + y, tu, tv, tw);
+          /*  step the centre only, the quad around it keeps its shape  */
+          u[0] = (uinc * (dx + .5) + m->coeff[0][1] * (dy + .5) +
+                  m->coeff[0][2] - .5 - info->u1);
+          v[0] = (vinc * (dx + .5) + m->coeff[1][1] * (dy + .5) +
+                  m->coeff[1][2] - .5 - info->v1);
 
-          while (width--)
+          for (x = 0; x < destPR->w; x++, d += bytes)
             {
-              gdouble u[5], v[5]; /* source coordinates */
-              gint    i;
-
-              /*  normalize homogeneous coords  */
-              normalize_coords (5, tu, tv, tw, u, v);
-
-              /*  Set the destination pixels  */
-              if (supersample_dtest (u[1], v[1], u[2], v[2],
-                                     u[3], v[3], u[4], v[4]))
+              if (iu)
                 {
-                  sample_adapt (orig_tiles,
-                                u[0] - u1, v[0] - v1,
-                                u[1] - u1, v[1] - v1,
-                                u[2] - u1, v[2] - v1,
-                                u[3] - u1, v[3] - v1,
-                                u[4] - u1, v[4] - v1,
-                                recursion_level,
-                                d, bg_color, destPR->bytes, alpha);
+                  iu[x] = nearest_coord (u[0]);
+                  iv[x] = nearest_coord (v[0]);
                 }
               else
                 {
-                  sample_linear (surround, u[0] - u1, v[0] - v1,
-                                 d, destPR->bytes, alpha);
+                  if (info->supersample)
+                    {
+                      u[1] = u[0] - m->coeff[0][0];
+                      v[1] = v[0] - m->coeff[1][0];
+                      u[2] = u[0] - m->coeff[0][1];
+                      v[2] = v[0] - m->coeff[1][1];
+                      u[3] = u[0] + m->coeff[0][0];
+                      v[3] = v[0] + m->coeff[1][0];
+                      u[4] = u[0] + m->coeff[0][1];
+                      v[4] = v[0] + m->coeff[1][1];
+                    }
+
+                  gimp_transform_region_pixel (info, surround, super,
+                                               info->supersample, u, v,
+                                               d, bytes);
                 }
 
-              d += destPR->bytes;
-
-              for (i = 0; i < 5; i++)
-                {
-                  tu[i] += uinc;
-                  tv[i] += vinc;
-                  tw[i] += winc;
-                }
+              u[0] += uinc;
+              v[0] += vinc;
             }
-
-          dest += destPR->rowstride;
-        }
-
-      if (progress)
-        {
-          pixels += destPR->w * destPR->h;
-
-          if (n % 16 == 0)
-            gimp_progress_set_value (progress,
-                                     (gdouble) pixels / (gdouble) total);
         }
-    }
-
-  pixel_surround_destroy (surround);
-}
-
-static void
-gimp_transform_region_cubic (TileManager        *orig_tiles,
-                             PixelRegion        *destPR,
-                             gint                dest_x1,
-                             gint                dest_y1,
-                             gint                dest_x2,
-                             gint                dest_y2,
-                             gint                u1,
-                             gint                v1,
-                             gint                u2,
-                             gint                v2,
-                             const GimpMatrix3  *m,
-                             gint                alpha,
-                             gint                recursion_level,
-                             const guchar       *bg_color,
-                             GimpProgress       *progress)
-{
-  PixelSurround *surround;
-  gdouble        uinc, vinc, winc;  /* increments in source coordinates  */
-  gint           pixels;
-  gint           total;
-  gint           n;
-  gpointer       pr;
-
-  surround = pixel_surround_new (orig_tiles, 4, 4, PIXEL_SURROUND_BACKGROUND);
-  pixel_surround_set_bg (surround, bg_color);
-
-  uinc = m->coeff[0][0];
-  vinc = m->coeff[1][0];
-  winc = m->coeff[2][0];
-
-  total = destPR->w * destPR->h;
-
-  for (pr = pixel_regions_register (1, destPR), pixels = 0, n = 0;
-       pr != NULL;
-       pr = pixel_regions_process (pr), n++)
-    {
-      guchar *dest = destPR->data;
-      gint    y;
-
-      for (y = destPR->y; y < destPR->y + destPR->h; y++)
+      else
         {
-          guchar  *d     = dest;
-          gint     width = destPR->w;
-          gdouble  tu[5], tv[5];   /* undivided source coordinates */
-          gdouble  tw[5];          /* divisor                      */
+          const gint coords = iu ? 1 : 5;
+          gdouble    tu[5], tv[5];   /* undivided source coordinates */
+          gdouble    tw[5];          /* divisor                      */
 
           /* set up inverse transform steps */
-          untransform_coords (m, dest_x1 + destPR->x, dest_y1 + y, tu, tv, tw);
+          untransform_coords (m, dx, dy, tu, tv, tw);
 
-          while (width--)
+          for (x = 0; x < destPR->w; x++, d += bytes)
             {
-              gdouble u[5], v[5]; /* source coordinates */
-              gint    i;
+              gint i;
 
               /*  normalize homogeneous coords  */
-              normalize_coords (5, tu, tv, tw, u, v);
+              normalize_coords (coords, tu, tv, tw, u, v);
 
-              if (supersample_dtest (u[1], v[1], u[2], v[2],
-                                     u[3], v[3], u[4], v[4]))
+              for (i = 0; i < coords; i++)
                 {
-                  sample_adapt (orig_tiles,
-                                u[0] - u1, v[0] - v1,
-                                u[1] - u1, v[1] - v1,
-                                u[2] - u1, v[2] - v1,
-                                u[3] - u1, v[3] - v1,
-                                u[4] - u1, v[4] - v1,
-                                recursion_level,
-                                d, bg_color, destPR->bytes, alpha);
+                  u[i] -= info->u1;
+                  v[i] -= info->v1;
+                }
+
+              if (iu)
+                {
+                  iu[x] = nearest_coord (u[0]);
+                  iv[x] = nearest_coord (v[0]);
                 }
               else
                 {
-                  sample_cubic (surround, u[0] - u1, v[0] - v1,
-                                d, destPR->bytes, alpha);
+                  gimp_transform_region_pixel (info, surround, super,
+                                               supersample_dtest (u[1], v[1],
+                                                                  u[2], v[2],
+                                                                  u[3], v[3],
+                                                                  u[4], v[4]),
+                                               u, v, d, bytes);
                 }
 
-              d += destPR->bytes;
-
-              for (i = 0; i < 5; i++)
+              for (i = 0; i < coords; i++)
                 {
                   tu[i] += uinc;
                   tv[i] += vinc;
                   tw[i] += winc;
                 }
             }
-
-          dest += destPR->rowstride;
         }
 
-      if (progress)
-        {
-          pixels += destPR->w * destPR->h;
-
-          if (n % 16 == 0)
-            gimp_progress_set_value (progress,
-                                     (gdouble) pixels / (gdouble) total);
-        }
+      /*  outside the source, the surround hands out the bg color  */
+      if (iu)
+        pixel_surround_get_pixels (surround, iu, iv, destPR->w, dest);
     }
 
+  g_free (iu);
+  g_free (iv);
+
+  if (super && super != surround)
+    pixel_surround_destroy (super);
+
   pixel_surround_destroy (surround);
 }
 
 static void
-gimp_transform_region_lanczos (TileManager       *orig_tiles,
-                               PixelRegion       *destPR,
-                               gint               dest_x1,
-                               gint               dest_y1,
-                               gint               dest_x2,
-                               gint               dest_y2,
-                               gint               u1,
-                               gint               v1,
-                               gint               u2,
-                               gint               v2,
-                               const GimpMatrix3 *m,
-                               gint               alpha,
-                               gint               recursion_level,
-                               const guchar      *bg_color,
-                               GimpProgress      *progress)
+gimp_transform_region_pixel (const TransformInfo *info,
+                             PixelSurround       *surround,
+                             PixelSurround       *super,
+                             gboolean             supersample,
+                             const gdouble       *u,
+                             const gdouble       *v,
+                             guchar              *d,
+                             gint                 bytes)
 {
-  PixelSurround *surround;
-  gfloat        *lanczos;           /* Lanczos lookup table              */
-  gdouble        uinc, vinc, winc;  /* increments in source coordinates  */
-  gint           pixels;
-  gint           total;
-  gint           n;
-  gpointer       pr;
-
-  surround = pixel_surround_new (orig_tiles,
-                                 LANCZOS_WIDTH2, LANCZOS_WIDTH2,
-                                 PIXEL_SURROUND_BACKGROUND);
-  pixel_surround_set_bg (surround, bg_color);
-
-  /* allocate and fill lanczos lookup table */
-  lanczos = create_lanczos_lookup ();
+  const gint alpha = info->alpha;
 
-  uinc = m->coeff[0][0];
-  vinc = m->coeff[1][0];
-  winc = m->coeff[2][0];
-
-  total = destPR->w * destPR->h;
-
-  for (pr = pixel_regions_register (1, destPR), pixels = 0, n = 0;
-       pr != NULL;
-       pr = pixel_regions_process (pr), n++)
+  if (supersample)
     {
-      guchar *dest = destPR->data;
-      gint    y;
-
-      for (y = destPR->y; y < destPR->y + destPR->h; y++)
-        {
-          guchar  *d     = dest;
-          gint     width = destPR->w;
-          gdouble  tu[5], tv[5];   /* undivided source coordinates */
-          gdouble  tw[5];          /* divisor                      */
-
-          /* set up inverse transform steps */
-          untransform_coords (m, dest_x1 + destPR->x, dest_y1 + y, tu, tv, tw);
-
-          while (width--)
-            {
-              gdouble u[5], v[5]; /* source coordinates */
-              gint    i;
-
-              /*  normalize homogeneous coords  */
-              normalize_coords (5, tu, tv, tw, u, v);
-
-              if (supersample_dtest (u[1], v[1], u[2], v[2],
-                                     u[3], v[3], u[4], v[4]))
-                {
-                  sample_adapt (orig_tiles,
-                                u[0] - u1, v[0] - v1,
-                                u[1] - u1, v[1] - v1,
-                                u[2] - u1, v[2] - v1,
-                                u[3] - u1, v[3] - v1,
-                                u[4] - u1, v[4] - v1,
-                                recursion_level,
-                                d, bg_color, destPR->bytes, alpha);
-                }
-              else
-                {
-                  sample_lanczos (surround, lanczos, u[0] - u1, v[0] - v1,
-                                  d, destPR->bytes, alpha);
-                }
-
-              d += destPR->bytes;
-
-              for (i = 0; i < 5; i++)
-                {
-                  tu[i] += uinc;
-                  tv[i] += vinc;
-                  tw[i] += winc;
-                }
-            }
+      sample_adapt (super,
+                    u[0], v[0],
+                    u[1], v[1],
+                    u[2], v[2],
+                    u[3], v[3],
+                    u[4], v[4],
+                    info->recursion_level,
+                    d, bytes, alpha);
+      return;
+    }
 
-          dest += destPR->rowstride;
-        }
+  switch (info->interpolation)
+    {
+    case GIMP_INTERPOLATION_LINEAR:
+      sample_linear (surround, u[0], v[0], d, bytes, alpha);
+      break;
 
-      if (progress)
-        {
-          pixels += destPR->w * destPR->h;
+    case GIMP_INTERPOLATION_CUBIC:
+      sample_cubic (surround, u[0], v[0], d, bytes, alpha);
+      break;
 
-          if (n % 16 == 0)
-            gimp_progress_set_value (progress,
-                                     (gdouble) pixels / (gdouble) total);
-        }
-   }
+    case GIMP_INTERPOLATION_LANCZOS:
+      sample_lanczos (surround, info->lanczos, u[0], v[0], d, bytes, alpha);
+      break;
 
-  g_free (lanczos);
-  pixel_surround_destroy (surround);
+    default:
+      g_assert_not_reached ();
+      break;
+    }
 }
 
 
@@ -751,10 +537,6 @@ normalize_coords (const gint     coords,
 }
 
 
-#define BILINEAR(jk, j1k, jk1, j1k1, dx, dy) \
-                ((1 - dy) * (jk  + dx * (j1k  - jk)) + \
-                      dy  * (jk1 + dx * (j1k1 - jk1)))
-
   /*  u & v are the subpixel coordinates of the point in
    *  the original selection's floating buffer.
    *  We need the two pixel coords around them:
@@ -774,7 +556,9 @@ sample_linear (PixelSurround *surround,
   const gint    iv = floor (v);
   gint          rowstride;
   gdouble       du, dv;
-  const guchar *alphachan;
+  gdouble       x_weights[2];
+  gdouble       y_weights[2];
+  gdouble       sums[MAX_CHANNELS];
   const guchar *data;
 
   /* lock the pixel surround */
@@ -784,10 +568,16 @@ sample_linear (PixelSurround *surround,
   du = u - iu;
   dv = v - iv;
 
+  x_weights[0] = 1.0 - du;
+  x_weights[1] = du;
+  y_weights[0] = 1.0 - dv;
+  y_weights[1] = dv;
+
+  sample_weighted_funcs.sum (data, rowstride, bytes, alpha,
+                             x_weights, y_weights, 2, sums);
+
   /* calculate alpha value of result pixel */
-  alphachan = &data[alpha];
-  a_val = BILINEAR (alphachan[0],         alphachan[bytes],
-                    alphachan[rowstride], alphachan[rowstride + bytes], du, dv);
+  a_val = sums[alpha];
 
   if (a_val <= 0.0)
     {
@@ -812,13 +602,7 @@ sample_linear (PixelSurround *surround,
    */
   for (i = 0; i < alpha; i++)
     {
-      gint newval =
-        ROUND ((a_recip *
-                BILINEAR (alphachan[0]                 * data[i],
-                          alphachan[bytes]             * data[bytes + i],
-                          alphachan[rowstride]         * data[rowstride + i],
-                          alphachan[rowstride + bytes] * data[rowstride + bytes + i],
-                          du, dv)));
+      gint newval = ROUND (a_recip * sums[i]);
 
       color[i] = CLAMP (newval, 0, 255);
     }
@@ -846,39 +630,29 @@ sample_linear (PixelSurround *surround,
     bilinear interpolation of a fixed point pixel
 */
 static void
-sample_bi (TileManager  *tm,
-           const gint    x,
-           const gint    y,
-           guchar       *color,
-           const guchar *bg_color,
-           const gint    bpp,
-           const gint    alpha)
+sample_bi (PixelSurround *surround,
+           const gint     x,
+           const gint     y,
+           guchar        *color,
+           const gint     bpp,
+           const gint     alpha)
 {
-  const gint xscale = (x & (FIXED_UNIT-1));
-  const gint yscale = (y & (FIXED_UNIT-1));
-  const gint x0 = x >> FIXED_SHIFT;
-  const gint y0 = y >> FIXED_SHIFT;
-  const gint x1 = x0 + 1;
-  const gint y1 = y0 + 1;
-  guchar     C[4][4];
-  gint       i;
-
-  /*  fill the color with default values, since
-   *  tile_manager_read_pixel_data_1 does nothing, when accesses are
-   *  out of bounds.
-   */
-  for (i = 0; i < 4; i++)
-    {
-      guint *src = (guint *) bg_color;
-      guint *dst = (guint *) &C[i];
+  const gint    xscale = (x & (FIXED_UNIT-1));
+  const gint    yscale = (y & (FIXED_UNIT-1));
+  const gint    x0 = x >> FIXED_SHIFT;
+  const gint    y0 = y >> FIXED_SHIFT;
+  const guchar *C[4];
+  const guchar *data;
+  gint          rowstride;
+  gint          i;
 
-      *dst = *src;
-    }
+  /*  outside the source, the surround hands out the bg color  */
+  data = pixel_surround_lock (surround, x0, y0, &rowstride);
 
-  tile_manager_read_pixel_data_1 (tm, x0, y0, C[0]);
-  tile_manager_read_pixel_data_1 (tm, x1, y0, C[2]);
-  tile_manager_read_pixel_data_1 (tm, x0, y1, C[1]);
-  tile_manager_read_pixel_data_1 (tm, x1, y1, C[3]);
+  C[0] = data;                     /* x0, y0 */
+  C[1] = data + rowstride;         /* x0, y1 */
+  C[2] = data + bpp;               /* x1, y0 */
+  C[3] = data + rowstride + bpp;   /* x1, y1 */
 
 #define lerp(v1, v2, r) \
         (((guint)(v1) * (FIXED_UNIT - (guint)(r)) + \
@@ -957,30 +731,29 @@ supersample_dtest (const gdouble x0, const gdouble y0,
     0..3 is a cycle around the quad
 */
 static void
-get_sample (TileManager  *tm,
-            const gint    xc,
-            const gint    yc,
-            const gint    x0,
-            const gint    y0,
-            const gint    x1,
-            const gint    y1,
-            const gint    x2,
-            const gint    y2,
-            const gint    x3,
-            const gint    y3,
-            gint         *cc,
-            const gint    level,
-            guint        *color,
-            const guchar *bg_color,
-            const gint    bpp,
-            const gint    alpha)
+get_sample (PixelSurround *surround,
+            const gint     xc,
+            const gint     yc,
+            const gint     x0,
+            const gint     y0,
+            const gint     x1,
+            const gint     y1,
+            const gint     x2,
+            const gint     y2,
+            const gint     x3,
+            const gint     y3,
+            gint          *cc,
+            const gint     level,
+            guint         *color,
+            const gint     bpp,
+            const gint     alpha)
 {
   if (!level || !supersample_test (x0, y0, x1, y1, x2, y2, x3, y3))
     {
       gint   i;
       guchar C[4];
 
-      sample_bi (tm, xc, yc, C, bg_color, bpp, alpha);
+      sample_bi (surround, xc, yc, C, bpp, alpha);
 
       for (i = 0; i < bpp; i++)
         color[i]+= C[i];
@@ -1014,30 +787,30 @@ get_sample (TileManager  *tm,
       bry = (y2 + yc) / 2;
       by  = (y3 + y2) / 2;
 
-      get_sample (tm,
+      get_sample (surround,
                   tlx,tly,
                   x0,y0, tx,ty, xc,yc, lx,ly,
-                  cc, level-1, color, bg_color, bpp, alpha);
+                  cc, level-1, color, bpp, alpha);
 
-      get_sample (tm,
+      get_sample (surround,
                   trx,try,
                   tx,ty, x1,y1, rx,ry, xc,yc,
-                  cc, level-1, color, bg_color, bpp, alpha);
+                  cc, level-1, color, bpp, alpha);
 
-      get_sample (tm,
+      get_sample (surround,
                   brx,bry,
                   xc,yc, rx,ry, x2,y2, bx,by,
-                  cc, level-1, color, bg_color, bpp, alpha);
+                  cc, level-1, color, bpp, alpha);
 
-      get_sample (tm,
+      get_sample (surround,
                   blx,bly,
                   lx,ly, xc,yc, bx,by, x3,y3,
-                  cc, level-1, color, bg_color, bpp, alpha);
+                  cc, level-1, color, bpp, alpha);
     }
 }
 
 static void
-sample_adapt (TileManager   *tm,
+sample_adapt (PixelSurround *surround,
               const gdouble  xc,
               const gdouble  yc,
               const gdouble  x0,
@@ -1050,7 +823,6 @@ sample_adapt (TileManager   *tm,
               const gdouble  y3,
               const gint     level,
               guchar        *color,
-              const guchar  *bg_color,
               const gint     bpp,
               const gint     alpha)
 {
@@ -1060,13 +832,13 @@ sample_adapt (TileManager   *tm,
 
     C[0] = C[1] = C[2] = C[3] = 0;
 
-    get_sample (tm,
+    get_sample (surround,
                 DOUBLE2FIXED (xc), DOUBLE2FIXED (yc),
                 DOUBLE2FIXED (x0), DOUBLE2FIXED (y0),
                 DOUBLE2FIXED (x1), DOUBLE2FIXED (y1),
                 DOUBLE2FIXED (x2), DOUBLE2FIXED (y2),
                 DOUBLE2FIXED (x3), DOUBLE2FIXED (y3),
-                &cc, level, C, bg_color, bpp, alpha);
+                &cc, level, C, bpp, alpha);
 
     if (!cc)
       cc=1;
@@ -1086,29 +858,15 @@ sample_adapt (TileManager   *tm,
       }
 }
 
-/* access interleaved pixels */
-#define CUBIC_ROW(dx, row, step) \
-  gimp_drawable_transform_cubic(dx,\
-            (row)[0], (row)[step], (row)[step+step], (row)[step+step+step])
-
-#define CUBIC_SCALED_ROW(dx, row, arow, step) \
-  gimp_drawable_transform_cubic(dx, \
-            (arow)[0]              * (row)[0], \
-            (arow)[step]           * (row)[step], \
-            (arow)[step+step]      * (row)[step+step], \
-            (arow)[step+step+step] * (row)[step+step+step])
-
-
-/*  Note: cubic function no longer clips result. */
-/*  Inlining this function makes sample_cubic() run about 10% faster. (Sven) */
-static inline gdouble
-gimp_drawable_transform_cubic (const gdouble dx,
-                               const gint    jm1,
-                               const gint    j,
-                               const gint    jp1,
-                               const gint    jp2)
+/*  The weights of the four pixels around dx, from the one before on.
+ *  Note: the cubic function does not clip its result.
+ */
+static inline void
+cubic_weights (const gdouble  dx,
+               gdouble       *weights)
 {
-  gdouble result;
+  const gdouble dx2 = dx * dx;
+  const gdouble dx3 = dx2 * dx;
 
 #if 0
   /* Equivalent to Gimp 1.1.1 and earlier - some ringing */
@@ -1122,11 +880,10 @@ gimp_drawable_transform_cubic (const gdouble dx,
 #endif
 
   /* Catmull-Rom - not bad */
-  result = ((( ( - jm1 + 3 * j - 3 * jp1 + jp2 ) * dx +
-               ( 2 * jm1 - 5 * j + 4 * jp1 - jp2 ) ) * dx +
-               ( - jm1 + jp1 ) ) * dx + (j + j) ) / 2.0;
-
-  return result;
+  weights[0] = (- dx3 + 2.0 * dx2 - dx) / 2.0;
+  weights[1] = (3.0 * dx3 - 5.0 * dx2 + 2.0) / 2.0;
+  weights[2] = (- 3.0 * dx3 + 4.0 * dx2 + dx) / 2.0;
+  weights[3] = (dx3 - dx2) / 2.0;
 }
 
 
@@ -1148,23 +905,23 @@ sample_cubic (PixelSurround *surround,
   const gint    iu = floor(u);
   const gint    iv = floor(v);
   gint          rowstride;
-  gdouble       du, dv;
+  gdouble       x_weights[4];
+  gdouble       y_weights[4];
+  gdouble       sums[MAX_CHANNELS];
   const guchar *data;
 
   /* lock the pixel surround */
   data = pixel_surround_lock (surround, iu - 1 , iv - 1, &rowstride);
 
-  /* the fractional error */
-  du = u - iu;
-  dv = v - iv;
+  /* the weights of the fractional error */
+  cubic_weights (u - iu, x_weights);
+  cubic_weights (v - iv, y_weights);
+
+  sample_weighted_funcs.sum (data, rowstride, bytes, alpha,
+                             x_weights, y_weights, 4, sums);
 
   /* calculate alpha of result */
-  a_val = gimp_drawable_transform_cubic
-    (dv,
-     CUBIC_ROW (du, data + alpha + rowstride * 0, bytes),
-     CUBIC_ROW (du, data + alpha + rowstride * 1, bytes),
-     CUBIC_ROW (du, data + alpha + rowstride * 2, bytes),
-     CUBIC_ROW (du, data + alpha + rowstride * 3, bytes));
+  a_val = sums[alpha];
 
   if (a_val <= 0.0)
     {
@@ -1189,26 +946,7 @@ sample_cubic (PixelSurround *surround,
    */
   for (i = 0; i < alpha; i++)
     {
-      gint newval =
-        ROUND ((a_recip *
-                gimp_drawable_transform_cubic
-                (dv,
-                 CUBIC_SCALED_ROW (du,
-                                   i + data + rowstride * 0,
-                                   data + alpha + rowstride * 0,
-                                   bytes),
-                 CUBIC_SCALED_ROW (du,
-                                   i + data + rowstride * 1,
-                                   data + alpha + rowstride * 1,
-                                   bytes),
-                 CUBIC_SCALED_ROW (du,
-                                   i + data + rowstride * 2,
-                                   data + alpha + rowstride * 2,
-                                   bytes),
-                 CUBIC_SCALED_ROW (du,
-                                   i + data + rowstride * 3,
-                                   data + alpha + rowstride * 3,
-                                   bytes))));
+      gint newval = ROUND (a_recip * sums[i]);
 
       color[i] = CLAMP (newval, 0, 255);
     }
@@ -1226,15 +964,15 @@ sample_lanczos (PixelSurround *surround,
   gdouble       x_kernel[LANCZOS_WIDTH2]; /* 1-D kernels of window coeffs */
   gdouble       y_kernel[LANCZOS_WIDTH2];
   gdouble       x_sum, y_sum;             /* sum of Lanczos weights       */
+  gdouble       sums[MAX_CHANNELS];
   gdouble       arecip;
   gdouble       aval;
   gint          su, sv;
   gint          b;
-  gint          i, j;
+  gint          i;
   gint          iu, iv;
   gint          rowstride;
   const guchar *data;
-  const guchar *src;
 
   iu = (gint) u;
   iv = (gint) v;
@@ -1264,16 +1002,10 @@ sample_lanczos (PixelSurround *surround,
                               iu - LANCZOS_WIDTH, iv - LANCZOS_WIDTH,
                               &rowstride);
 
-  src = data + alpha;
-  aval = 0.0;
+  sample_weighted_funcs.sum (data, rowstride, bytes, alpha,
+                             x_kernel, y_kernel, LANCZOS_WIDTH2, sums);
 
-  for (j = 0; j < LANCZOS_WIDTH2 ; j++)
-    {
-      for (i = 0; i < LANCZOS_WIDTH2 ; i++)
-        aval += y_kernel[j] * x_kernel[i] * (gdouble) src[i * bytes];
-
-      src += rowstride;
-    }
+  aval = sums[alpha];
 
   if (aval <= 0.0)
     {
@@ -1292,23 +1024,8 @@ sample_lanczos (PixelSurround *surround,
 
   for (b = 0; b < alpha; b++)
     {
-      const guchar *asrc;
-      gdouble       newval = 0.0;
-
-      src  = data + b;
-      asrc = data + alpha;
-
-      for (j = 0; j < LANCZOS_WIDTH2; j++)
-        {
-          for (i = 0; i < LANCZOS_WIDTH2; i++)
-            newval += (y_kernel[j] * x_kernel[i] *
-                       (gdouble) src[i * bytes] * (gdouble) asrc[i * bytes]);
-
-          src += rowstride;
-          asrc += rowstride;
-        }
+      gdouble newval = sums[b] * arecip;
 
-      newval *= arecip;
       color[b] = CLAMP (ROUND (newval), 0, 255);
     }
 
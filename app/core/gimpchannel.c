@@ -34,6 +34,7 @@
 #include "base/tile.h"
 #include "base/tile-manager.h"
 
+#include "paint-funcs/gaussian-blur-region.h"
 #include "paint-funcs/paint-funcs.h"
 
 #include "paint/gimppaintcore-stroke.h"
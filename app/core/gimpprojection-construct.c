@@ -19,14 +19,20 @@
 
 #include <gegl.h>
 
+#include "libgimpbase/gimpbase.h"
+
 #include "core-types.h"
 
 #include "base/pixel-region.h"
 #include "base/tile-manager.h"
+#include "base/tile.h"
+#include "base/tile-rowhints.h"
 
 #include "paint-funcs/paint-funcs.h"
 
+#include "gimpimage.h"
 #include "gimplayer.h"
+#include "gimplayermask.h"
 #include "gimppickable.h"
 #include "gimpprojectable.h"
 #include "gimpprojection.h"
@@ -35,22 +41,43 @@
 
 /*  local function prototypes  */
 
-static void   gimp_projection_construct_gegl   (GimpProjection *proj,
-                                                gint            x,
-                                                gint            y,
-                                                gint            w,
-                                                gint            h);
-static void   gimp_projection_construct_legacy (GimpProjection *proj,
-                                                gboolean        with_layers,
-                                                gint            x,
-                                                gint            y,
-                                                gint            w,
-                                                gint            h);
-static void   gimp_projection_initialize       (GimpProjection *proj,
-                                                gint            x,
-                                                gint            y,
-                                                gint            w,
-                                                gint            h);
+static void     gimp_projection_construct_gegl   (GimpProjection *proj,
+                                                  gint            x,
+                                                  gint            y,
+                                                  gint            w,
+                                                  gint            h);
+static void     gimp_projection_construct_legacy (GimpProjection *proj,
+                                                  gboolean        with_layers,
+                                                  gint            x,
+                                                  gint            y,
+                                                  gint            w,
+                                                  gint            h);
+static void     gimp_projection_initialize       (GimpProjection *proj,
+                                                  gint            x,
+                                                  gint            y,
+                                                  gint            w,
+                                                  gint            h);
+static void     gimp_projection_construct_items  (GimpProjection *proj,
+                                                  GList          *items,
+                                                  gint            x,
+                                                  gint            y,
+                                                  gint            w,
+                                                  gint            h);
+static GList  * gimp_projection_find_occluder    (GimpProjection *proj,
+                                                  GList          *items,
+                                                  gint            x,
+                                                  gint            y,
+                                                  gint            w,
+                                                  gint            h);
+static gboolean gimp_projection_is_plain         (GimpLayer      *layer);
+static gboolean gimp_projection_is_shareable     (GimpProjection *proj,
+                                                  GimpLayer      *layer);
+static gboolean gimp_projection_add_alpha        (GimpProjection *proj,
+                                                  GimpItem       *item,
+                                                  gint            x,
+                                                  gint            y,
+                                                  gint            w,
+                                                  gint            h);
 
 
 /*  public functions  */
@@ -64,55 +91,6 @@ gimp_projection_construct (GimpProjection *proj,
 {
   g_return_if_fail (GIMP_IS_PROJECTION (proj));
 
-#if 0
-  GList *layers = gimp_projectable_get_layers (proj->projectable);
-
-  if (layers && ! layers->next) /* a single layer */
-    {
-      GimpLayer    *layer    = layers->data;
-      GimpDrawable *drawable = GIMP_DRAWABLE (layer);
-      GimpItem     *item     = GIMP_ITEM (layer);
-      gint          width, height;
-      gint          off_x, off_y;
-
-      gimp_projectable_get_offset (proj->projectable, &proj_off_x, &proj_off_y);
-      gimp_projectable_get_size (proj->projectable, &width, &height);
-
-      gimp_item_get_offset (item, &off_x, &off_y);
-
-      if (gimp_drawable_has_alpha (drawable)                    &&
-          gimp_item_get_visible (item)                          &&
-          gimp_item_get_width  (item) == width                  &&
-          gimp_item_get_height (item) == height                 &&
-          ! gimp_drawable_is_indexed (layer)                    &&
-          gimp_layer_get_opacity (layer) == GIMP_OPACITY_OPAQUE &&
-          off_x == 0                                            &&
-          off_y == 0                                            &&
-          proj_offset_x == 0                                    &&
-          proj_offset_y == 0)
-        {
-          PixelRegion srcPR, destPR;
-
-          g_printerr ("cow-projection!");
-
-          pixel_region_init (&srcPR,
-                             gimp_drawable_get_tiles (layer),
-                             x, y, w,h, FALSE);
-          pixel_region_init (&destPR,
-                             gimp_pickable_get_tiles (GIMP_PICKABLE (proj)),
-                             x, y, w,h, TRUE);
-
-          copy_region (&srcPR, &destPR);
-
-          proj->construct_flag = TRUE;
-
-          gimp_projection_construct_legacy (proj, FALSE, x, y, w, h);
-
-          return;
-        }
-    }
-#endif
-
   /*  First, determine if the projection image needs to be
    *  initialized--this is the case when there are no visible
    *  layers that cover the entire canvas--either because layers
@@ -135,6 +113,148 @@ gimp_projection_construct (GimpProjection *proj,
     }
 }
 
+/**
+ * gimp_projection_share_tiles:
+ * @proj: A #GimpProjection.
+ * @x:
+ * @y:
+ * @w:
+ * @h:
+ *
+ * Maps the invalid projection tiles in the given area, which would be
+ * projected from a single opaque layer in normal mode alone, to that
+ * layer's tiles instead of constructing them.  Painting the layer
+ * copies its tiles on write, so the projection keeps showing the
+ * old contents until the painted area is invalidated again, and is
+ * shared with the new tiles then.  All other tiles are left invalid.
+ * Layers without alpha have fewer bytes per pixel than the projection,
+ * their tiles are converted when they are validated instead, see
+ * gimp_projection_add_alpha().
+ */
+void
+gimp_projection_share_tiles (GimpProjection *proj,
+                             gint            x,
+                             gint            y,
+                             gint            w,
+                             gint            h)
+{
+  TileManager *tiles;
+  GList       *layers = NULL;
+  GList       *list;
+  gint         proj_off_x;
+  gint         proj_off_y;
+  gint         tile_x, tile_y;
+
+  g_return_if_fail (GIMP_IS_PROJECTION (proj));
+
+  if (proj->use_gegl || w <= 0 || h <= 0)
+    return;
+
+  /*  visible channels are composited on top of every layer  */
+  for (list = gimp_projectable_get_channels (proj->projectable);
+       list;
+       list = g_list_next (list))
+    {
+      if (gimp_item_get_visible (GIMP_ITEM (list->data)))
+        return;
+    }
+
+  for (list = gimp_projectable_get_layers (proj->projectable);
+       list;
+       list = g_list_next (list))
+    {
+      if (gimp_item_get_visible (GIMP_ITEM (list->data)))
+        layers = g_list_prepend (layers, list->data);
+    }
+
+  for (list = layers; list; list = g_list_next (list))
+    {
+      if (gimp_projection_is_shareable (proj, list->data))
+        break;
+    }
+
+  if (! list)
+    {
+      g_list_free (layers);
+      return;
+    }
+
+  tiles = gimp_pickable_get_tiles (GIMP_PICKABLE (proj));
+
+  gimp_projectable_get_offset (proj->projectable, &proj_off_x, &proj_off_y);
+
+  for (tile_y = y - y % TILE_HEIGHT; tile_y < y + h; tile_y += TILE_HEIGHT)
+    for (tile_x = x - x % TILE_WIDTH; tile_x < x + w; tile_x += TILE_WIDTH)
+      {
+        Tile      *tile;
+        GimpLayer *layer = NULL;
+        Tile      *src;
+        gint       tile_w, tile_h;
+        gint       off_x, off_y;
+
+        /*  don't lock the tile, that would validate it  */
+        tile = tile_manager_get_tile (tiles, tile_x, tile_y, FALSE, FALSE);
+
+        if (! tile || tile_is_valid (tile))
+          continue;
+
+        tile_w = tile_ewidth (tile);
+        tile_h = tile_eheight (tile);
+
+        /*  find the only layer that intersects the tile  */
+        for (list = layers; list; list = g_list_next (list))
+          {
+            GimpItem *item = list->data;
+
+            gimp_item_get_offset (item, &off_x, &off_y);
+
+            off_x -= proj_off_x;
+            off_y -= proj_off_y;
+
+            if (gimp_rectangle_intersect (tile_x, tile_y, tile_w, tile_h,
+                                          off_x, off_y,
+                                          gimp_item_get_width  (item),
+                                          gimp_item_get_height (item),
+                                          NULL, NULL, NULL, NULL))
+              {
+                if (layer)
+                  break;
+
+                layer = list->data;
+              }
+          }
+
+        if (! layer || list || ! gimp_projection_is_shareable (proj, layer))
+          continue;
+
+        gimp_item_get_offset (GIMP_ITEM (layer), &off_x, &off_y);
+
+        off_x -= proj_off_x;
+        off_y -= proj_off_y;
+
+        /*  the layer's tile must cover exactly the projection's tile  */
+        if ((tile_x - off_x) % TILE_WIDTH  != 0 ||
+            (tile_y - off_y) % TILE_HEIGHT != 0 ||
+            tile_x < off_x                      ||
+            tile_y < off_y)
+          continue;
+
+        src = tile_manager_get_tile (gimp_drawable_get_tiles (GIMP_DRAWABLE (layer)),
+                                     tile_x - off_x, tile_y - off_y,
+                                     TRUE, FALSE);
+
+        if (! src)
+          continue;
+
+        if (tile_ewidth (src) == tile_w && tile_eheight (src) == tile_h)
+          tile_manager_map_tile (tiles, tile_x, tile_y, src);
+
+        tile_release (src, FALSE);
+      }
+
+  g_list_free (layers);
+}
+
 
 /*  private functions  */
 
@@ -177,10 +297,11 @@ gimp_projection_construct_legacy (GimpProjection *proj,
                                   gint            w,
                                   gint            h)
 {
-  GList *list;
-  GList *reverse_list = NULL;
-  gint   proj_off_x;
-  gint   proj_off_y;
+  GList    *list;
+  GList    *reverse_list   = NULL;
+  gboolean  construct_flag = proj->construct_flag;
+  gint      tile_y;
+  gint      next_y;
 
   for (list = gimp_projectable_get_channels (proj->projectable);
        list;
@@ -211,9 +332,74 @@ gimp_projection_construct_legacy (GimpProjection *proj,
         }
     }
 
+  /*  composite each run of tiles from the topmost layer that hides
+   *  all layers below it there, the other layers don't show
+   */
+  for (tile_y = y; tile_y < y + h; tile_y = next_y)
+    {
+      GList *run_items = reverse_list;
+      gint   run_x     = x;
+      gint   tile_x;
+      gint   next_x;
+
+      next_y = MIN ((tile_y / TILE_HEIGHT + 1) * TILE_HEIGHT, y + h);
+
+      for (tile_x = x; tile_x < x + w; tile_x = next_x)
+        {
+          GList *items;
+
+          next_x = MIN ((tile_x / TILE_WIDTH + 1) * TILE_WIDTH, x + w);
+
+          items = gimp_projection_find_occluder (proj, reverse_list,
+                                                 tile_x, tile_y,
+                                                 next_x - tile_x,
+                                                 next_y - tile_y);
+
+          if (tile_x > run_x && items != run_items)
+            {
+              proj->construct_flag = construct_flag;
+
+              gimp_projection_construct_items (proj, run_items,
+                                               run_x, tile_y,
+                                               tile_x - run_x,
+                                               next_y - tile_y);
+
+              run_x = tile_x;
+            }
+
+          run_items = items;
+        }
+
+      proj->construct_flag = construct_flag;
+
+      gimp_projection_construct_items (proj, run_items,
+                                       run_x, tile_y,
+                                       x + w - run_x,
+                                       next_y - tile_y);
+    }
+
+  g_list_free (reverse_list);
+}
+
+static void
+gimp_projection_construct_items (GimpProjection *proj,
+                                 GList          *items,
+                                 gint            x,
+                                 gint            y,
+                                 gint            w,
+                                 gint            h)
+{
+  GList *list;
+  gint   proj_off_x;
+  gint   proj_off_y;
+
+  if (items && ! items->next && ! proj->construct_flag &&
+      gimp_projection_add_alpha (proj, items->data, x, y, w, h))
+    return;
+
   gimp_projectable_get_offset (proj->projectable, &proj_off_x, &proj_off_y);
 
-  for (list = reverse_list; list; list = g_list_next (list))
+  for (list = items; list; list = g_list_next (list))
     {
       GimpItem    *item = list->data;
       PixelRegion  projPR;
@@ -249,8 +435,77 @@ gimp_projection_construct_legacy (GimpProjection *proj,
 
       proj->construct_flag = TRUE;  /*  something was projected  */
     }
+}
 
-  g_list_free (reverse_list);
+/*  Returns the link of the topmost layer in @items, which are ordered
+ *  bottom to top, that is opaque everywhere in the given area and hides
+ *  all items below it there, or @items if there is none.  A layer is
+ *  opaque if it has no alpha channel, or if all its tiles in the area
+ *  are, as recorded in the tiles' row hints.
+ */
+static GList *
+gimp_projection_find_occluder (GimpProjection *proj,
+                               GList          *items,
+                               gint            x,
+                               gint            y,
+                               gint            w,
+                               gint            h)
+{
+  GList *list;
+  gint   proj_off_x;
+  gint   proj_off_y;
+
+  gimp_projectable_get_offset (proj->projectable, &proj_off_x, &proj_off_y);
+
+  for (list = g_list_last (items); list; list = g_list_previous (list))
+    {
+      GimpDrawable *drawable = list->data;
+      GimpItem     *item     = list->data;
+      TileManager  *tiles;
+      gint          off_x, off_y;
+      gint          tile_x, tile_y;
+      gboolean      opaque   = TRUE;
+
+      if (! GIMP_IS_LAYER (item) || ! gimp_projection_is_plain (list->data))
+        continue;
+
+      gimp_item_get_offset (item, &off_x, &off_y);
+
+      off_x -= proj_off_x;
+      off_y -= proj_off_y;
+
+      if (off_x > x                                    ||
+          off_y > y                                    ||
+          off_x + gimp_item_get_width  (item) < x + w  ||
+          off_y + gimp_item_get_height (item) < y + h)
+        continue;
+
+      if (! gimp_drawable_has_alpha (drawable))
+        return list;
+
+      tiles = gimp_drawable_get_tiles (drawable);
+
+      /*  the layer's tiles which intersect the area  */
+      for (tile_y = y - off_y;
+           opaque && tile_y < y + h - off_y;
+           tile_y += TILE_HEIGHT - tile_y % TILE_HEIGHT)
+        for (tile_x = x - off_x;
+             opaque && tile_x < x + w - off_x;
+             tile_x += TILE_WIDTH - tile_x % TILE_WIDTH)
+          {
+            Tile *tile = tile_manager_get_tile (tiles, tile_x, tile_y,
+                                                TRUE, FALSE);
+
+            opaque = tile_is_opaque (tile);
+
+            tile_release (tile, FALSE);
+          }
+
+      if (opaque)
+        return list;
+    }
+
+  return items;
 }
 
 /**
@@ -322,3 +577,105 @@ gimp_projection_initialize (GimpProjection *proj,
       clear_region (&region);
     }
 }
+
+/*  Whether @layer hides what is below it wherever it is opaque, see
+ *  gimp_layer_project_region().
+ */
+static gboolean
+gimp_projection_is_plain (GimpLayer *layer)
+{
+  GimpDrawable  *drawable = GIMP_DRAWABLE (layer);
+  GimpLayerMask *mask     = gimp_layer_get_mask (layer);
+  gboolean       visible[MAX_CHANNELS];
+  gint           i;
+
+  if (gimp_layer_is_floating_sel (layer)                      ||
+      gimp_drawable_get_floating_sel (drawable)               ||
+      gimp_layer_get_mode (layer)    != GIMP_NORMAL_MODE      ||
+      gimp_layer_get_opacity (layer) != GIMP_OPACITY_OPAQUE)
+    return FALSE;
+
+  if (mask && (gimp_layer_mask_get_apply (mask) ||
+               gimp_layer_mask_get_show (mask)))
+    return FALSE;
+
+  gimp_image_get_visible_array (gimp_item_get_image (GIMP_ITEM (layer)),
+                                visible);
+
+  for (i = 0; i < MAX_CHANNELS; i++)
+    if (! visible[i])
+      return FALSE;
+
+  return TRUE;
+}
+
+/*  Whether @layer projected alone onto a transparent projection gives
+ *  exactly its own pixels.
+ */
+static gboolean
+gimp_projection_is_shareable (GimpProjection *proj,
+                              GimpLayer      *layer)
+{
+  GimpDrawable *drawable = GIMP_DRAWABLE (layer);
+  TileManager  *tiles    = gimp_pickable_get_tiles (GIMP_PICKABLE (proj));
+
+  return (gimp_projection_is_plain (layer)                         &&
+          gimp_drawable_has_alpha (drawable)                       &&
+          ! gimp_drawable_is_indexed (drawable)                    &&
+          gimp_drawable_bytes (drawable) == tile_manager_bpp (tiles));
+}
+
+/*  Layers without alpha can't share their tiles with the projection,
+ *  which always has alpha.  Where such a layer is the only item that
+ *  shows in the area, the projection is constructed by adding an
+ *  opaque alpha channel to the layer's pixels instead, which is what
+ *  compositing it would give, without going through the layer modes.
+ */
+static gboolean
+gimp_projection_add_alpha (GimpProjection *proj,
+                           GimpItem       *item,
+                           gint            x,
+                           gint            y,
+                           gint            w,
+                           gint            h)
+{
+  GimpDrawable *drawable;
+  PixelRegion   srcPR;
+  PixelRegion   projPR;
+  gint          proj_off_x;
+  gint          proj_off_y;
+  gint          off_x;
+  gint          off_y;
+
+  if (! GIMP_IS_LAYER (item) || ! gimp_projection_is_plain (GIMP_LAYER (item)))
+    return FALSE;
+
+  drawable = GIMP_DRAWABLE (item);
+
+  if (gimp_drawable_has_alpha (drawable) || gimp_drawable_is_indexed (drawable))
+    return FALSE;
+
+  gimp_projectable_get_offset (proj->projectable, &proj_off_x, &proj_off_y);
+  gimp_item_get_offset (item, &off_x, &off_y);
+
+  off_x -= proj_off_x;
+  off_y -= proj_off_y;
+
+  if (off_x > x                                    ||
+      off_y > y                                    ||
+      off_x + gimp_item_get_width  (item) < x + w  ||
+      off_y + gimp_item_get_height (item) < y + h)
+    return FALSE;
+
+  pixel_region_init (&srcPR, gimp_drawable_get_tiles (drawable),
+                     x - off_x, y - off_y, w, h, FALSE);
+  pixel_region_init (&projPR, gimp_pickable_get_tiles (GIMP_PICKABLE (proj)),
+                     x, y, w, h, TRUE);
+
+  add_alpha_region (&srcPR, &projPR);
+
+  proj->construct_flag = TRUE;  /*  something was projected  */
+
+  return TRUE;
+}
+
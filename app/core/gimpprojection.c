@@ -40,6 +40,10 @@
 /*  halfway between G_PRIORITY_HIGH_IDLE and G_PRIORITY_DEFAULT_IDLE  */
 #define  GIMP_PROJECTION_IDLE_PRIORITY  150
 
+/*  the upper pyramid levels are updated after the projection itself  */
+#define  GIMP_PROJECTION_PYRAMID_PRIORITY  G_PRIORITY_DEFAULT_IDLE
+#define  GIMP_PROJECTION_PYRAMID_BATCH     16
+
 
 enum
 {
@@ -80,6 +84,8 @@ static void        gimp_projection_flush_whenever        (GimpProjection  *proj,
 static void        gimp_projection_idle_render_init      (GimpProjection  *proj);
 static gboolean    gimp_projection_idle_render_callback  (gpointer         data);
 static gboolean    gimp_projection_idle_render_next_area (GimpProjection  *proj);
+static gboolean    gimp_projection_pyramid_callback      (gpointer         data);
+static void        gimp_projection_pyramid_stop          (GimpProjection  *proj);
 static void        gimp_projection_paint_area            (GimpProjection  *proj,
                                                           gboolean         now,
                                                           gint             x,
@@ -147,6 +153,7 @@ gimp_projection_init (GimpProjection *proj)
 {
   proj->projectable              = NULL;
   proj->pyramid                  = NULL;
+  proj->pyramid_update_id        = 0;
   proj->update_areas             = NULL;
   proj->idle_render.idle_id      = 0;
   proj->idle_render.update_areas = NULL;
@@ -186,6 +193,8 @@ gimp_projection_finalize (GObject *object)
   gimp_area_list_free (proj->idle_render.update_areas);
   proj->idle_render.update_areas = NULL;
 
+  gimp_projection_pyramid_stop (proj);
+
   if (proj->pyramid)
     {
       tile_pyramid_destroy (proj->pyramid);
@@ -434,6 +443,8 @@ gimp_projection_get_tiles_at_level (GimpProjection *proj,
                          "tile-manager", tiles,
                          NULL);
         }
+
+      gimp_projection_share_tiles (proj, 0, 0, width, height);
     }
 
   return tile_pyramid_get_tiles (proj->pyramid, level, is_premult);
@@ -495,6 +506,13 @@ gimp_projection_finish_draw (GimpProjection *proj)
 
       while (gimp_projection_idle_render_callback (proj));
     }
+
+  if (proj->pyramid_update_id)
+    {
+      g_source_remove (proj->pyramid_update_id);
+
+      while (gimp_projection_pyramid_callback (proj));
+    }
 }
 
 
@@ -723,6 +741,55 @@ gimp_projection_idle_render_next_area (GimpProjection *proj)
   return TRUE;
 }
 
+/*  The upper pyramid levels are not invalidated along with the
+ *  projection, the display keeps showing their old contents while
+ *  they are updated here a batch of tiles at a time, each batch
+ *  refining the area it covers.
+ */
+static gboolean
+gimp_projection_pyramid_callback (gpointer data)
+{
+  GimpProjection *proj = data;
+  gint            x, y;
+  gint            width, height;
+
+  if (tile_pyramid_update (proj->pyramid, GIMP_PROJECTION_PYRAMID_BATCH,
+                           &x, &y, &width, &height))
+    {
+      gint off_x, off_y;
+
+      gimp_projectable_get_offset (proj->projectable, &off_x, &off_y);
+
+      g_signal_emit (proj, projection_signals[UPDATE], 0,
+                     TRUE,
+                     x + off_x,
+                     y + off_y,
+                     width,
+                     height);
+    }
+
+  if (tile_pyramid_is_dirty (proj->pyramid))
+    return TRUE;
+
+  /* FINISHED */
+  proj->pyramid_update_id = 0;
+
+  /*  previews are made from the upper levels  */
+  gimp_projectable_invalidate_preview (proj->projectable);
+
+  return FALSE;
+}
+
+static void
+gimp_projection_pyramid_stop (GimpProjection *proj)
+{
+  if (proj->pyramid_update_id)
+    {
+      g_source_remove (proj->pyramid_update_id);
+      proj->pyramid_update_id = 0;
+    }
+}
+
 static void
 gimp_projection_paint_area (GimpProjection *proj,
                             gboolean        now,
@@ -766,7 +833,17 @@ gimp_projection_invalidate (GimpProjection *proj,
                             guint           h)
 {
   if (proj->pyramid)
-    tile_pyramid_invalidate_area (proj->pyramid, x, y, w, h);
+    {
+      tile_pyramid_invalidate_area (proj->pyramid, x, y, w, h);
+
+      gimp_projection_share_tiles (proj, x, y, w, h);
+
+      if (! proj->pyramid_update_id && tile_pyramid_is_dirty (proj->pyramid))
+        proj->pyramid_update_id =
+          g_idle_add_full (GIMP_PROJECTION_PYRAMID_PRIORITY,
+                           gimp_projection_pyramid_callback, proj,
+                           NULL);
+    }
 }
 
 static void
@@ -870,6 +947,8 @@ gimp_projection_projectable_changed (GimpProjectable *projectable,
   gimp_area_list_free (proj->update_areas);
   proj->update_areas = NULL;
 
+  gimp_projection_pyramid_stop (proj);
+
   if (proj->pyramid)
     {
       tile_pyramid_destroy (proj->pyramid);
@@ -55,6 +55,7 @@ struct _GimpProjection
   GimpProjectable          *projectable;
 
   TilePyramid              *pyramid;
+  guint                     pyramid_update_id;
   GeglNode                 *graph;
   GeglNode                 *sink_node;
   GeglProcessor            *processor;
@@ -55,6 +55,7 @@
 #include "widgets/gimpsamplepointeditor.h"
 #include "widgets/gimpselectioneditor.h"
 #include "widgets/gimptemplateview.h"
+#include "widgets/gimptiledashboard.h"
 #include "widgets/gimptoolbox.h"
 #include "widgets/gimptooloptionseditor.h"
 #include "widgets/gimptoolpresetfactoryview.h"
@@ -319,6 +320,15 @@ dialogs_cursor_view_new (GimpDialogFactory *factory,
   return gimp_cursor_view_new (gimp_dialog_factory_get_menu_factory (factory));
 }
 
+GtkWidget *
+dialogs_tile_dashboard_new (GimpDialogFactory *factory,
+                            GimpContext       *context,
+                            GimpUIManager     *ui_manager,
+                            gint               view_size)
+{
+  return gimp_tile_dashboard_new ();
+}
+
 
 /*****  list views  *****/
 
@@ -310,6 +310,10 @@ static const GimpDialogFactoryEntry entries[] =
             N_("Pointer"), N_("Pointer Information"), GIMP_STOCK_CURSOR,
             GIMP_HELP_POINTER_INFO_DIALOG,
             dialogs_cursor_view_new, 0, TRUE),
+  DOCKABLE ("gimp-tile-dashboard",
+            N_("Tiles"), N_("Tile System Dashboard"), GTK_STOCK_HARDDISK,
+            GIMP_HELP_TILE_DASHBOARD_DIALOG,
+            dialogs_tile_dashboard_new, 0, TRUE),
 
   /*  list & grid views  */
   LISTGRID (image, N_("Images"), NULL, GIMP_STOCK_IMAGES,
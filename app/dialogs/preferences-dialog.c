@@ -1569,9 +1569,9 @@ prefs_dialog_new (Gimp       *gimp,
                            GTK_CONTAINER (vbox), FALSE);
 
 #ifdef ENABLE_MP
-  table = prefs_table_new (5, GTK_CONTAINER (vbox2));
+  table = prefs_table_new (6, GTK_CONTAINER (vbox2));
 #else
-  table = prefs_table_new (4, GTK_CONTAINER (vbox2));
+  table = prefs_table_new (5, GTK_CONTAINER (vbox2));
 #endif /* ENABLE_MP */
 
   prefs_spin_button_add (object, "undo-levels", 1.0, 5.0, 0,
@@ -1583,14 +1583,21 @@ prefs_dialog_new (Gimp       *gimp,
   prefs_memsize_entry_add (object, "tile-cache-size",
                            _("Tile cache _size:"),
                            GTK_TABLE (table), 2, size_group);
+  prefs_memsize_entry_add (object, "tile-compression-size",
+                           _("Compressed tile ca_che size:"),
+                           GTK_TABLE (table), 3, size_group);
   prefs_memsize_entry_add (object, "max-new-image-size",
                            _("Maximum _new image size:"),
-                           GTK_TABLE (table), 3, size_group);
+                           GTK_TABLE (table), 4, size_group);
 
 #ifdef ENABLE_MP
   prefs_spin_button_add (object, "num-processors", 1.0, 4.0, 0,
                          _("Number of _processors to use:"),
-                         GTK_TABLE (table), 4, size_group);
+                         GTK_TABLE (table), 5, size_group);
+
+  prefs_check_button_add (object, "swap-async",
+                          _("Write the swap file in the _background"),
+                          GTK_BOX (vbox2));
 #endif /* ENABLE_MP */
 
   /*  Image Thumbnails  */
@@ -43,6 +43,7 @@
 #include "gimpdisplayshell-title.h"
 #include "gimpimagewindow.h"
 #include "gimpnavigationeditor.h"
+#include "gimpstatusbar.h"
 
 
 /*  local function prototypes  */
@@ -514,6 +515,8 @@ gimp_display_shell_canvas_expose_image (GimpDisplayShell *shell,
       cairo_save (cr);
       gdk_region_get_rectangles (image_region, &rects, &n_rects);
 
+      g_timer_start (shell->frame_timer);
+
       for (i = 0; i < n_rects; i++)
         gimp_display_shell_draw_image (shell, cr,
                                        rects[i].x,
@@ -521,6 +524,10 @@ gimp_display_shell_canvas_expose_image (GimpDisplayShell *shell,
                                        rects[i].width,
                                        rects[i].height);
 
+      gimp_statusbar_set_frame_time (gimp_display_shell_get_statusbar (shell),
+                                     g_timer_elapsed (shell->frame_timer,
+                                                      NULL));
+
       g_free (rects);
       cairo_restore (cr);
     }
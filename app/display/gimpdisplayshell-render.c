@@ -26,6 +26,8 @@
 
 #include "display-types.h"
 
+#include "base/box-filter.h"
+#include "base/pixel-processor.h"
 #include "base/tile-manager.h"
 #include "base/tile.h"
 
@@ -53,6 +55,13 @@
                                                100% and 200% zoom)
                                              */
 
+/*  the rows of a render buffer are rendered in parallel in at most
+ *  GIMP_DISPLAY_RENDER_MAX_BANDS bands of at least
+ *  GIMP_DISPLAY_RENDER_BAND_HEIGHT rows
+ */
+#define GIMP_DISPLAY_RENDER_MAX_BANDS    8
+#define GIMP_DISPLAY_RENDER_BAND_HEIGHT  32
+
 
 typedef struct _RenderInfo  RenderInfo;
 
@@ -91,10 +100,19 @@ struct _RenderInfo
   gint          footshift_y;
 
   gint64        dy;
+
+  guchar       *tile_buf;     /* scratch row of the band being rendered    */
 };
 
+typedef struct
+{
+  const RenderInfo *info;
+  RenderFunc        func;
+  gint              band_height;
+} RenderBands;
+
 
-static guchar tile_buf[GIMP_DISPLAY_RENDER_BUF_WIDTH * MAX_CHANNELS];
+static guchar tile_bufs[GIMP_DISPLAY_RENDER_MAX_BANDS][GIMP_DISPLAY_RENDER_BUF_WIDTH * MAX_CHANNELS];
 
 
 static void  gimp_display_shell_render_info_init (RenderInfo       *info,
@@ -107,6 +125,10 @@ static void  gimp_display_shell_render_info_init (RenderInfo       *info,
                                                   TileManager      *tiles,
                                                   gint              level,
                                                   gboolean          is_premult);
+static void  gimp_display_shell_render_bands     (RenderInfo       *info,
+                                                  RenderFunc        func);
+static void  gimp_display_shell_render_band      (RenderBands      *bands,
+                                                  gint              band);
 
 /*  Render Image functions  */
 
@@ -116,6 +138,15 @@ static void           render_image_rgb_a         (RenderInfo       *info);
 
 static const guchar * render_image_tile_fault    (RenderInfo       *info);
 
+static void           render_image_validate      (RenderInfo       *info);
+static Tile         * render_image_get_tile      (TileManager      *tiles,
+                                                  gint              x,
+                                                  gint              y,
+                                                  gboolean          wantread,
+                                                  gboolean          wantwrite);
+static void           render_image_release_tile  (Tile             *tile,
+                                                  gboolean          dirty);
+
 
 /*****************************************************************/
 /*  This function is the core of the display -- it offsets and   */
@@ -193,10 +224,10 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   switch (type)
     {
     case GIMP_RGBA_IMAGE:
-      render_image_rgb_a (&info);
+      gimp_display_shell_render_bands (&info, render_image_rgb_a);
       break;
     case GIMP_GRAYA_IMAGE:
-      render_image_gray_a (&info);
+      gimp_display_shell_render_bands (&info, render_image_gray_a);
       break;
     default:
       g_warning ("%s: unsupported projection type (%d)", G_STRFUNC, type);
@@ -240,7 +271,7 @@ gimp_display_shell_render (GimpDisplayShell *shell,
                                            shell->mask_surface,
                                            tiles, 0, FALSE);
 
-      render_image_alpha (&info);
+      gimp_display_shell_render_bands (&info, render_image_alpha);
 
       cairo_surface_mark_dirty (shell->mask_surface);
     }
@@ -279,6 +310,58 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   }
 }
 
+/*  Renders @info in horizontal bands, in parallel where the pixel
+ *  processor has threads to spare.  Each band steps through the source
+ *  rows from its own first row and uses its own scratch row.
+ */
+static void
+gimp_display_shell_render_bands (RenderInfo *info,
+                                 RenderFunc  func)
+{
+  RenderBands bands;
+  gint        n_bands;
+
+  n_bands = CLAMP (info->h / GIMP_DISPLAY_RENDER_BAND_HEIGHT,
+                   1, GIMP_DISPLAY_RENDER_MAX_BANDS);
+
+  bands.info        = info;
+  bands.func        = func;
+  bands.band_height = (info->h + n_bands - 1) / n_bands;
+
+  n_bands = (info->h + bands.band_height - 1) / bands.band_height;
+
+  render_image_validate (info);
+
+  pixel_processor_process_items ((PixelProcessorItemFunc)
+                                 gimp_display_shell_render_band,
+                                 &bands, n_bands);
+}
+
+static void
+gimp_display_shell_render_band (RenderBands *bands,
+                                gint         band)
+{
+  const RenderInfo *info   = bands->info;
+  const gint        offset = band * bands->band_height;
+  RenderInfo        band_info;
+  gint64            dy;
+
+  band_info = *info;
+
+  band_info.y        = info->y + offset;
+  band_info.h        = MIN (bands->band_height, info->h - offset);
+  band_info.dest     = info->dest + offset * info->dest_bpl;
+  band_info.tile_buf = tile_bufs[band];
+
+  /*  the same as stepping there from info->y row by row  */
+  dy = (gint64) info->y_dest_inc * band_info.y + info->y_dest_inc / 2;
+
+  band_info.src_y    = dy / info->y_src_dec;
+  band_info.dy_start = dy % info->y_src_dec;
+
+  bands->func (&band_info);
+}
+
 /*  render a GRAY tile to an A8 cairo surface  */
 static void
 render_image_alpha (RenderInfo *info)
@@ -493,155 +576,72 @@ gimp_display_shell_render_info_init (RenderInfo       *info,
     }
 }
 
-/* This version assumes that the src data is already pre-multiplied. */
-static inline void
-box_filter (const guint    left_weight,
-            const guint    center_weight,
-            const guint    right_weight,
-            const guint    top_weight,
-            const guint    middle_weight,
-            const guint    bottom_weight,
-            const guchar **src,   /* the 9 surrounding source pixels */
-            guchar        *dest,
-            const gint     bpp)
-{
-  const guint sum = ((left_weight + center_weight + right_weight) *
-                     (top_weight + middle_weight + bottom_weight));
-  gint i;
-
-  for (i = 0; i < bpp; i++)
-    {
-      dest[i] = ( left_weight   * ((src[0][i] * top_weight) +
-                                   (src[3][i] * middle_weight) +
-                                   (src[6][i] * bottom_weight))
-                + center_weight * ((src[1][i] * top_weight) +
-                                   (src[4][i] * middle_weight) +
-                                   (src[7][i] * bottom_weight))
-                + right_weight  * ((src[2][i] * top_weight) +
-                                   (src[5][i] * middle_weight) +
-                                   (src[8][i] * bottom_weight))) / sum;
-    }
-}
+/* fast paths */
+static const guchar * render_image_tile_fault_one_row  (RenderInfo *info);
+static const guchar * render_image_tile_fault_nearest  (RenderInfo *info);
 
-/* This version assumes that the src data is not pre-multipled.
- * It creates pre-multiplied output though.
+/*  Validates all source tiles that rendering @info reads, including the
+ *  neighbours of the box filter, before the bands lock them in
+ *  parallel: validating projection tiles constructs the projection,
+ *  which must not happen on the pixel processor's threads.
  */
-static inline void
-box_filter_premult (const guint    left_weight,
-                    const guint    center_weight,
-                    const guint    right_weight,
-                    const guint    top_weight,
-                    const guint    middle_weight,
-                    const guint    bottom_weight,
-                    const guchar **src,   /* the 9 surrounding source pixels */
-                    guchar        *dest,
-                    const gint     bpp)
+static void
+render_image_validate (RenderInfo *info)
 {
-  const guint sum = ((left_weight + center_weight + right_weight) *
-                     (top_weight + middle_weight + bottom_weight)) >> 4;
-
-  switch (bpp)
-    {
-      case 4:
-#define ALPHA 3
-        {
-          const guint factors[9] =
-            {
-              (src[1][ALPHA] * top_weight)    >> 4,
-              (src[4][ALPHA] * middle_weight) >> 4,
-              (src[7][ALPHA] * bottom_weight) >> 4,
-              (src[2][ALPHA] * top_weight)    >> 4,
-              (src[5][ALPHA] * middle_weight) >> 4,
-              (src[8][ALPHA] * bottom_weight) >> 4,
-              (src[0][ALPHA] * top_weight)    >> 4,
-              (src[3][ALPHA] * middle_weight) >> 4,
-              (src[6][ALPHA] * bottom_weight) >> 4
-            };
-
-          const guint a =
-            (center_weight * (factors[0] + factors[1] + factors[2]) +
-             right_weight  * (factors[3] + factors[4] + factors[5]) +
-             left_weight   * (factors[6] + factors[7] + factors[8]));
-
-          guint i;
-
-          for (i = 0; i < ALPHA; i++)
-            {
-              dest[i] =  (center_weight * (factors[0] * src[1][i] +
-                                           factors[1] * src[4][i] +
-                                           factors[2] * src[7][i]) +
-
-                          right_weight  * (factors[3] * src[2][i] +
-                                           factors[4] * src[5][i] +
-                                           factors[5] * src[8][i]) +
-
-                          left_weight   * (factors[6] * src[0][i] +
-                                           factors[7] * src[3][i] +
-                                           factors[8] * src[6][i]) + ((255 * sum) >> 1)) / (255 * sum);
-            }
-
-          dest[ALPHA] = (a + (sum >> 1)) / sum;
-        }
-#undef ALPHA
-        break;
-
-      case 2:
-#define ALPHA 1
-
-        /* NOTE: this is a copy and paste of the code above, ALPHA changes
-         *       the behavior in all needed ways.
-         */
-        {
-          const guint factors[9] =
-            {
-              (src[1][ALPHA] * top_weight)    >> 4,
-              (src[4][ALPHA] * middle_weight) >> 4,
-              (src[7][ALPHA] * bottom_weight) >> 4,
-              (src[2][ALPHA] * top_weight)    >> 4,
-              (src[5][ALPHA] * middle_weight) >> 4,
-              (src[8][ALPHA] * bottom_weight) >> 4,
-              (src[0][ALPHA] * top_weight)    >> 4,
-              (src[3][ALPHA] * middle_weight) >> 4,
-              (src[6][ALPHA] * bottom_weight) >> 4
-            };
-
-          const guint a =
-            (center_weight * (factors[0] + factors[1] + factors[2]) +
-             right_weight  * (factors[3] + factors[4] + factors[5]) +
-             left_weight   * (factors[6] + factors[7] + factors[8]));
-
-          guint i;
-
-          for (i = 0; i < ALPHA; i++)
-            {
-              dest[i] =  (center_weight * (factors[0] * src[1][i] +
-                                           factors[1] * src[4][i] +
-                                           factors[2] * src[7][i]) +
+  const gint width  = tile_manager_width  (info->src_tiles);
+  const gint height = tile_manager_height (info->src_tiles);
+  gint       x1, y1;
+  gint       x2, y2;
+  gint       x, y;
+
+  x1 = info->src_x - 1;
+  y1 = info->src_y - 1;
+  x2 = (((gint64) info->x_dest_inc * (info->x + info->w) +
+         info->x_dest_inc / 2) / info->x_src_dec) + 1;
+  y2 = (((gint64) info->y_dest_inc * (info->y + info->h) +
+         info->y_dest_inc / 2) / info->y_src_dec) + 1;
+
+  x1 = CLAMP (x1, 0, width  - 1);
+  y1 = CLAMP (y1, 0, height - 1);
+  x2 = CLAMP (x2, 0, width  - 1);
+  y2 = CLAMP (y2, 0, height - 1);
+
+  for (y = y1 - y1 % TILE_HEIGHT; y <= y2; y += TILE_HEIGHT)
+    for (x = x1 - x1 % TILE_WIDTH; x <= x2; x += TILE_WIDTH)
+      {
+        Tile *tile = tile_manager_get_tile (info->src_tiles, x, y,
+                                            TRUE, FALSE);
 
-                          right_weight  * (factors[3] * src[2][i] +
-                                           factors[4] * src[5][i] +
-                                           factors[5] * src[8][i]) +
+        if (tile)
+          tile_release (tile, FALSE);
+      }
+}
 
-                          left_weight   * (factors[6] * src[0][i] +
-                                           factors[7] * src[3][i] +
-                                           factors[8] * src[6][i]) + ((255 * sum) >> 1)) / (sum * 255);
-            }
+/*  The bands lock and release tiles in parallel.  */
+static Tile *
+render_image_get_tile (TileManager *tiles,
+                       gint         x,
+                       gint         y,
+                       gboolean     wantread,
+                       gboolean     wantwrite)
+{
+  Tile *tile;
 
-          dest[ALPHA] = (a + (sum >> 1)) / sum;
-        }
-#undef ALPHA
-        break;
+  pixel_processor_lock_tiles ();
+  tile = tile_manager_get_tile (tiles, x, y, wantread, wantwrite);
+  pixel_processor_unlock_tiles ();
 
-      default:
-        g_warning ("bpp=%i not implemented as box filter", bpp);
-        break;
-    }
+  return tile;
 }
 
-
-/* fast paths */
-static const guchar * render_image_tile_fault_one_row  (RenderInfo *info);
-static const guchar * render_image_tile_fault_nearest  (RenderInfo *info);
+static void
+render_image_release_tile (Tile     *tile,
+                           gboolean  dirty)
+{
+  pixel_processor_lock_tiles ();
+  tile_release (tile, dirty);
+  pixel_processor_unlock_tiles ();
+}
 
 /*  012 <- this is the order of the numbered source tiles / pixels.
  *  345    for the 3x3 neighbourhoods.
@@ -735,33 +735,33 @@ render_image_tile_fault (RenderInfo *info)
 
   middle_weight = info->footprint_y - top_weight - bottom_weight;
 
-  tile[4] = tile_manager_get_tile (info->src_tiles,
+  tile[4] = render_image_get_tile (info->src_tiles,
                                    info->src_x, info->src_y,
                                    TRUE, FALSE);
-  tile[7] = tile_manager_get_tile (info->src_tiles,
+  tile[7] = render_image_get_tile (info->src_tiles,
                                    info->src_x, info->src_y + 1,
                                    TRUE, FALSE);
-  tile[1] = tile_manager_get_tile (info->src_tiles,
+  tile[1] = render_image_get_tile (info->src_tiles,
                                    info->src_x, info->src_y - 1,
                                    TRUE, FALSE);
 
-  tile[5] = tile_manager_get_tile (info->src_tiles,
+  tile[5] = render_image_get_tile (info->src_tiles,
                                    info->src_x + 1, info->src_y,
                                    TRUE, FALSE);
-  tile[8] = tile_manager_get_tile (info->src_tiles,
+  tile[8] = render_image_get_tile (info->src_tiles,
                                    info->src_x + 1, info->src_y + 1,
                                    TRUE, FALSE);
-  tile[2] = tile_manager_get_tile (info->src_tiles,
+  tile[2] = render_image_get_tile (info->src_tiles,
                                    info->src_x + 1, info->src_y - 1,
                                    TRUE, FALSE);
 
-  tile[3] = tile_manager_get_tile (info->src_tiles,
+  tile[3] = render_image_get_tile (info->src_tiles,
                                    info->src_x - 1, info->src_y,
                                    TRUE, FALSE);
-  tile[6] = tile_manager_get_tile (info->src_tiles,
+  tile[6] = render_image_get_tile (info->src_tiles,
                                    info->src_x - 1, info->src_y + 1,
                                    TRUE, FALSE);
-  tile[0] = tile_manager_get_tile (info->src_tiles,
+  tile[0] = render_image_get_tile (info->src_tiles,
                                    info->src_x - 1, info->src_y - 1,
                                    TRUE, FALSE);
 
@@ -843,7 +843,7 @@ render_image_tile_fault (RenderInfo *info)
     }
 
   bpp    = tile_manager_bpp (info->src_tiles);
-  dest   = tile_buf;
+  dest   = info->tile_buf;
 
   dx     = info->dx_start;
   src_x  = info->src_x;
@@ -885,13 +885,17 @@ render_image_tile_fault (RenderInfo *info)
         }
 
       if (info->src_is_premult)
-        box_filter (left_weight, center_weight, right_weight,
-                    top_weight, middle_weight, bottom_weight,
-                    src, dest, bpp);
+        box_filter_funcs.filter (left_weight, center_weight, right_weight,
+                                 top_weight, middle_weight, bottom_weight,
+                                 src, dest, bpp);
       else
-        box_filter_premult (left_weight, center_weight, right_weight,
-                            top_weight, middle_weight, bottom_weight,
-                            src, dest, bpp);
+        box_filter_funcs.filter_premult (left_weight,
+                                         center_weight,
+                                         right_weight,
+                                         top_weight,
+                                         middle_weight,
+                                         bottom_weight,
+                                         src, dest, bpp);
 
       dest += bpp;
 
@@ -950,22 +954,22 @@ render_image_tile_fault (RenderInfo *info)
 
           if ((src_x / TILE_WIDTH) != tilex0)
             {
-              tile_release (tile[4], FALSE);
+              render_image_release_tile (tile[4], FALSE);
 
               if (tile[7])
-                tile_release (tile[7], FALSE);
+                render_image_release_tile (tile[7], FALSE);
               if (tile[1])
-                tile_release (tile[1], FALSE);
+                render_image_release_tile (tile[1], FALSE);
 
               tilex0 += 1;
 
-              tile[4] = tile_manager_get_tile (info->src_tiles,
+              tile[4] = render_image_get_tile (info->src_tiles,
                                                src_x, info->src_y,
                                                TRUE, FALSE);
-              tile[7] = tile_manager_get_tile (info->src_tiles,
+              tile[7] = render_image_get_tile (info->src_tiles,
                                                src_x, info->src_y + 1,
                                                TRUE, FALSE);
-              tile[1] = tile_manager_get_tile (info->src_tiles,
+              tile[1] = render_image_get_tile (info->src_tiles,
                                                src_x, info->src_y - 1,
                                                TRUE, FALSE);
               if (! tile[4])
@@ -997,21 +1001,21 @@ render_image_tile_fault (RenderInfo *info)
           if (((src_x + 1) / TILE_WIDTH) != tilex1)
             {
               if (tile[5])
-                tile_release (tile[5], FALSE);
+                render_image_release_tile (tile[5], FALSE);
               if (tile[8])
-                tile_release (tile[8], FALSE);
+                render_image_release_tile (tile[8], FALSE);
               if (tile[2])
-                tile_release (tile[2], FALSE);
+                render_image_release_tile (tile[2], FALSE);
 
               tilex1 += 1;
 
-              tile[5] = tile_manager_get_tile (info->src_tiles,
+              tile[5] = render_image_get_tile (info->src_tiles,
                                                src_x + 1, info->src_y,
                                                TRUE, FALSE);
-              tile[8] = tile_manager_get_tile (info->src_tiles,
+              tile[8] = render_image_get_tile (info->src_tiles,
                                                src_x + 1, info->src_y + 1,
                                                TRUE, FALSE);
-              tile[2] = tile_manager_get_tile (info->src_tiles,
+              tile[2] = render_image_get_tile (info->src_tiles,
                                                src_x + 1, info->src_y - 1,
                                                TRUE, FALSE);
 
@@ -1049,21 +1053,21 @@ render_image_tile_fault (RenderInfo *info)
           if (((src_x - 1) / TILE_WIDTH) != tilexL)
             {
               if (tile[0])
-                tile_release (tile[0], FALSE);
+                render_image_release_tile (tile[0], FALSE);
               if (tile[3])
-                tile_release (tile[3], FALSE);
+                render_image_release_tile (tile[3], FALSE);
               if (tile[6])
-                tile_release (tile[6], FALSE);
+                render_image_release_tile (tile[6], FALSE);
 
               tilexL += 1;
 
-              tile[0] = tile_manager_get_tile (info->src_tiles,
+              tile[0] = render_image_get_tile (info->src_tiles,
                                                src_x - 1, info->src_y - 1,
                                                TRUE, FALSE);
-              tile[3] = tile_manager_get_tile (info->src_tiles,
+              tile[3] = render_image_get_tile (info->src_tiles,
                                                src_x - 1, info->src_y,
                                                TRUE, FALSE);
-              tile[6] = tile_manager_get_tile (info->src_tiles,
+              tile[6] = render_image_get_tile (info->src_tiles,
                                                src_x - 1, info->src_y + 1,
                                                TRUE, FALSE);
 
@@ -1105,9 +1109,9 @@ render_image_tile_fault (RenderInfo *info)
 done:
   for (dx = 0; dx < 9; dx++)
     if (tile[dx])
-      tile_release (tile[dx], FALSE);
+      render_image_release_tile (tile[dx], FALSE);
 
-  return tile_buf;
+  return info->tile_buf;
 }
 
 static const guchar *
@@ -1159,13 +1163,13 @@ render_image_tile_fault_one_row (RenderInfo *info)
 
   middle_weight = info->footprint_y - top_weight - bottom_weight;
 
-  tile[0] = tile_manager_get_tile (info->src_tiles,
+  tile[0] = render_image_get_tile (info->src_tiles,
                                    info->src_x, info->src_y, TRUE, FALSE);
 
-  tile[1] = tile_manager_get_tile (info->src_tiles,
+  tile[1] = render_image_get_tile (info->src_tiles,
                                    info->src_x + 1, info->src_y, TRUE, FALSE);
 
-  tile[2] = tile_manager_get_tile (info->src_tiles,
+  tile[2] = render_image_get_tile (info->src_tiles,
                                    info->src_x - 1, info->src_y, TRUE, FALSE);
 
   if (tile[0] == NULL)
@@ -1224,7 +1228,7 @@ render_image_tile_fault_one_row (RenderInfo *info)
     }
 
   bpp    = tile_manager_bpp (info->src_tiles);
-  dest   = tile_buf;
+  dest   = info->tile_buf;
 
   dx     = info->dx_start;
   src_x  = info->src_x;
@@ -1258,13 +1262,17 @@ render_image_tile_fault_one_row (RenderInfo *info)
         }
 
       if (info->src_is_premult)
-        box_filter (left_weight, center_weight, right_weight,
-                    top_weight, middle_weight, bottom_weight,
-                    src, dest, bpp);
+        box_filter_funcs.filter (left_weight, center_weight, right_weight,
+                                 top_weight, middle_weight, bottom_weight,
+                                 src, dest, bpp);
       else
-        box_filter_premult (left_weight, center_weight, right_weight,
-                            top_weight, middle_weight, bottom_weight,
-                            src, dest, bpp);
+        box_filter_funcs.filter_premult (left_weight,
+                                         center_weight,
+                                         right_weight,
+                                         top_weight,
+                                         middle_weight,
+                                         bottom_weight,
+                                         src, dest, bpp);
 
       dest += bpp;
 
@@ -1323,11 +1331,11 @@ render_image_tile_fault_one_row (RenderInfo *info)
 
           if ((src_x / TILE_WIDTH) != tilex0)
             {
-              tile_release (tile[0], FALSE);
+              render_image_release_tile (tile[0], FALSE);
 
               tilex0 += 1;
 
-              tile[0] = tile_manager_get_tile (info->src_tiles,
+              tile[0] = render_image_get_tile (info->src_tiles,
                                                src_x, info->src_y, TRUE, FALSE);
               if (! tile[0])
                 goto done;
@@ -1340,11 +1348,11 @@ render_image_tile_fault_one_row (RenderInfo *info)
           if (((src_x + 1) / TILE_WIDTH) != tilex1)
             {
               if (tile[1])
-                tile_release (tile[1], FALSE);
+                render_image_release_tile (tile[1], FALSE);
 
               tilex1 += 1;
 
-              tile[1] = tile_manager_get_tile (info->src_tiles,
+              tile[1] = render_image_get_tile (info->src_tiles,
                                                src_x + 1, info->src_y,
                                                TRUE, FALSE);
 
@@ -1368,11 +1376,11 @@ render_image_tile_fault_one_row (RenderInfo *info)
           if (((src_x - 1) / TILE_WIDTH) != tilexL)
             {
               if (tile[2])
-                tile_release (tile[2], FALSE);
+                render_image_release_tile (tile[2], FALSE);
 
               tilexL += 1;
 
-              tile[2] = tile_manager_get_tile (info->src_tiles,
+              tile[2] = render_image_get_tile (info->src_tiles,
                                                src_x - 1, info->src_y,
                                                TRUE, FALSE);
 
@@ -1399,9 +1407,9 @@ render_image_tile_fault_one_row (RenderInfo *info)
 done:
   for (dx = 0; dx < 3; dx++)
     if (tile[dx])
-      tile_release (tile[dx], FALSE);
+      render_image_release_tile (tile[dx], FALSE);
 
-  return tile_buf;
+  return info->tile_buf;
 }
 
 /* function to render a horizontal line of view data */
@@ -1417,7 +1425,7 @@ render_image_tile_fault_nearest (RenderInfo *info)
   gint          src_x;
   gint64        dx;
 
-  tile = tile_manager_get_tile (info->src_tiles,
+  tile = render_image_get_tile (info->src_tiles,
                                 info->src_x, info->src_y, TRUE, FALSE);
 
   if (tile == NULL)
@@ -1434,7 +1442,7 @@ render_image_tile_fault_nearest (RenderInfo *info)
   src_x = info->src_x;
   tilex = info->src_x / TILE_WIDTH;
 
-  d     = tile_buf;
+  d     = info->tile_buf;
 
   do
     {
@@ -1500,13 +1508,13 @@ render_image_tile_fault_nearest (RenderInfo *info)
 
           if ((src_x / TILE_WIDTH) != tilex)
             {
-              tile_release (tile, FALSE);
+              render_image_release_tile (tile, FALSE);
               tilex += 1;
 
-              tile = tile_manager_get_tile (info->src_tiles,
+              tile = render_image_get_tile (info->src_tiles,
                                             src_x, info->src_y, TRUE, FALSE);
               if (! tile)
-                return tile_buf;
+                return info->tile_buf;
 
               src = tile_data_pointer (tile, src_x, info->src_y);
             }
@@ -1515,7 +1523,7 @@ render_image_tile_fault_nearest (RenderInfo *info)
   while (--width);
   done:
   if (tile)
-    tile_release (tile, FALSE);
+    render_image_release_tile (tile, FALSE);
 
-  return tile_buf;
+  return info->tile_buf;
 }
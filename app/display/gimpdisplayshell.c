@@ -318,6 +318,8 @@ gimp_display_shell_init (GimpDisplayShell *shell)
                                                       GIMP_DISPLAY_RENDER_BUF_WIDTH,
                                                       GIMP_DISPLAY_RENDER_BUF_HEIGHT);
 
+  shell->frame_timer = g_timer_new ();
+
   gimp_display_shell_items_init (shell);
 
   shell->icon_size  = 32;
@@ -886,6 +888,8 @@ gimp_display_shell_finalize (GObject *object)
 
   g_object_unref (shell->zoom);
 
+  g_timer_destroy (shell->frame_timer);
+
   if (shell->options)
     g_object_unref (shell->options);
 
@@ -119,6 +119,7 @@ struct _GimpDisplayShell
   cairo_surface_t   *render_surface;   /*  buffer for rendering the image     */
   cairo_surface_t   *mask_surface;     /*  buffer for rendering the mask      */
   cairo_pattern_t   *checkerboard;     /*  checkerboard pattern               */
+  GTimer            *frame_timer;      /*  times drawing the image            */
 
   GimpCanvasItem    *canvas_item;      /*  items drawn on the canvas          */
   GimpCanvasItem    *passe_partout;    /*  item for the highlight             */
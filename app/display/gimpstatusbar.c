@@ -116,6 +116,7 @@ static void     gimp_statusbar_shell_status_notify(GimpDisplayShell  *shell,
 static guint    gimp_statusbar_get_context_id     (GimpStatusbar     *statusbar,
                                                    const gchar       *context);
 static gboolean gimp_statusbar_temp_timeout       (GimpStatusbar     *statusbar);
+static gboolean gimp_statusbar_frame_time_timeout (GimpStatusbar     *statusbar);
 
 static void     gimp_statusbar_msg_free           (GimpStatusbarMsg  *msg);
 
@@ -222,6 +223,16 @@ gimp_statusbar_init (GimpStatusbar *statusbar)
                     G_CALLBACK (gimp_statusbar_scale_activated),
                     statusbar);
 
+  statusbar->frame_time_label = gtk_label_new (NULL);
+  gtk_label_set_width_chars (GTK_LABEL (statusbar->frame_time_label), 9);
+  gtk_misc_set_alignment (GTK_MISC (statusbar->frame_time_label), 1.0, 0.5);
+  gimp_help_set_help_data (statusbar->frame_time_label,
+                           _("Time it took to render the canvas last"),
+                           NULL);
+  gtk_box_pack_start (GTK_BOX (hbox), statusbar->frame_time_label,
+                      FALSE, FALSE, 0);
+  gtk_widget_show (statusbar->frame_time_label);
+
   /*  put the label back into the message area  */
   gtk_box_pack_start (GTK_BOX (hbox), statusbar->label, TRUE, TRUE, 1);
 
@@ -268,6 +279,12 @@ gimp_statusbar_dispose (GObject *object)
       statusbar->temp_timeout_id = 0;
     }
 
+  if (statusbar->frame_time_timeout_id)
+    {
+      g_source_remove (statusbar->frame_time_timeout_id);
+      statusbar->frame_time_timeout_id = 0;
+    }
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -1311,6 +1328,24 @@ gimp_statusbar_clear_cursor (GimpStatusbar *statusbar)
   gtk_widget_set_sensitive (statusbar->cursor_label, TRUE);
 }
 
+/*  Called on every expose, the label shows the latest frame time
+ *  twice a second at most.
+ */
+void
+gimp_statusbar_set_frame_time (GimpStatusbar *statusbar,
+                               gdouble        seconds)
+{
+  g_return_if_fail (GIMP_IS_STATUSBAR (statusbar));
+
+  statusbar->frame_time = seconds;
+
+  if (! statusbar->frame_time_timeout_id)
+    statusbar->frame_time_timeout_id =
+      g_timeout_add (500,
+                     (GSourceFunc) gimp_statusbar_frame_time_timeout,
+                     statusbar);
+}
+
 
 /*  private functions  */
 
@@ -1501,6 +1536,22 @@ gimp_statusbar_temp_timeout (GimpStatusbar *statusbar)
   return FALSE;
 }
 
+static gboolean
+gimp_statusbar_frame_time_timeout (GimpStatusbar *statusbar)
+{
+  GtkLabel *label = GTK_LABEL (statusbar->frame_time_label);
+  gchar     text[32];
+
+  g_snprintf (text, sizeof (text), "%.1f ms", statusbar->frame_time * 1000.0);
+
+  if (strcmp (text, gtk_label_get_text (label)) != 0)
+    gtk_label_set_text (label, text);
+
+  statusbar->frame_time_timeout_id = 0;
+
+  return FALSE;
+}
+
 static void
 gimp_statusbar_msg_free (GimpStatusbarMsg *msg)
 {
@@ -57,6 +57,9 @@ struct _GimpStatusbar
   GtkWidget           *cursor_label;
   GtkWidget           *unit_combo;
   GtkWidget           *scale_combo;
+  GtkWidget           *frame_time_label;
+  gdouble              frame_time;
+  guint                frame_time_timeout_id;
   GtkWidget           *label; /* same as GtkStatusbar->label */
 
   GtkWidget           *progressbar;
@@ -146,6 +149,9 @@ void        gimp_statusbar_update_cursor         (GimpStatusbar       *statusbar
                                                   gdouble              y);
 void        gimp_statusbar_clear_cursor          (GimpStatusbar       *statusbar);
 
+void        gimp_statusbar_set_frame_time        (GimpStatusbar       *statusbar,
+                                                  gdouble              seconds);
+
 
 G_END_DECLS
 
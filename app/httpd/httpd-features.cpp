@@ -28,6 +28,7 @@ extern "C" {
 #include "httpd.h"
 #include "rest-pdb.h"
 #include "rest-image-tree.h"
+#include "rest-tile-stats.h"
 #include "navigation-guide.h"
 
 ///////////////////////////////////////////////////////////////////////////
@@ -69,9 +70,11 @@ HTTPDFeature::initialize (Gimp* gimp, GimpInitStatusFunc callback)
   }));
   auto pdb_factory              = new RESTPDBFactory;
   auto image_tree_factory       = new RESTImageTreeFactory;
+  auto tile_stats_factory       = new RESTTileStatsFactory;
   rest_daemon->route("/api/v1/pdb/", pdb_factory);
   rest_daemon->route("/api/v1/pdb/{name}", pdb_factory);
   rest_daemon->route("/api/v1/images/**", image_tree_factory);
+  rest_daemon->route("/api/v1/tiles/stats", tile_stats_factory);
   rest_daemon->run();
   g_print("<HTTPDFeature::initialize\n");
 }
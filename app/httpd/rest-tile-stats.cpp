@@ -0,0 +1,180 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * rest-tile-stats
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/glib-cxx-types.hpp"
+#include "base/glib-cxx-utils.hpp"
+
+extern "C" {
+#include "config.h"
+
+#include <gegl.h>
+
+#include "core/core-types.h"
+
+#include "base/tile-cache.h"
+#include "base/tile-compress.h"
+#include "base/tile-pool.h"
+#include "base/tile-stats.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimpdrawable.h"
+#include "core/gimpitem.h"
+}
+
+#include "rest-tile-stats.h"
+
+///////////////////////////////////////////////////////////////////////
+// JSON conversion
+
+// JSON numbers are doubles anyway, and IBuilder has no 64bit integers.
+static void
+publish_stats(JSON::IBuilder& it, const TileStats& stats)
+{
+  it["locks"]      = double(stats.locks);
+  it["faults"]     = double(stats.faults);
+  it["cow_splits"] = double(stats.cow_splits);
+  it["uniform_skips"] = double(stats.uniform_skips);
+  it["bytes_skipped"] = double(stats.bytes_skipped);
+  it["swap_ins"]   = double(stats.swap_ins);
+  it["swap_outs"]  = double(stats.swap_outs);
+  it["bytes_in"]   = double(stats.bytes_in);
+  it["bytes_out"]  = double(stats.bytes_out);
+  it["swap_in_latency"] = it.array([&](auto it) {
+    for (int i = 0; i < TILE_STATS_N_BUCKETS; i ++)
+      it = double(stats.swap_in_latency[i]);
+  });
+  it["swap_out_latency"] = it.array([&](auto it) {
+    for (int i = 0; i < TILE_STATS_N_BUCKETS; i ++)
+      it = double(stats.swap_out_latency[i]);
+  });
+}
+
+///////////////////////////////////////////////////////////////////////
+// RESTTileStats
+
+void RESTTileStats::get()
+{
+  TileStats         totals;
+  TileCompressStats compressed;
+  TilePoolStats     pool;
+
+  tile_stats_get_totals(&totals);
+  tile_compress_get_stats(&compressed);
+  tile_pool_get_stats(&pool);
+
+  make_json_response(200,
+      JSON::build_object([&](auto it) {
+        it["enabled"] = bool(tile_stats_get_enabled());
+
+        // Upper bounds of the latency histogram buckets in microseconds,
+        // the last bucket is unbounded.
+        it["latency_buckets"] = it.array([&](auto it) {
+          for (int i = 0; i < TILE_STATS_N_BUCKETS - 1; i ++)
+            it = double(tile_stats_bucket_limit(i));
+          it = JSON::IBuilder::null();
+        });
+
+        it["totals"] = it.object([&](auto it) {
+          publish_stats(it, totals);
+        });
+
+        it["cache"] = it.object([&](auto it) {
+          it["size"] = double(tile_cache_get_cur_size());
+        });
+
+        it["pool"] = it.object([&](auto it) {
+          it["size"]  = double(pool.size);
+          it["used"]  = double(pool.used);
+          it["slabs"] = pool.n_slabs;
+        });
+
+        it["compressed"] = it.object([&](auto it) {
+          it["max_size"] = double(compressed.max_size);
+          it["size"]     = double(compressed.cur_size);
+          it["raw_size"] = double(compressed.raw_size);
+          it["tiles"]    = compressed.n_tiles;
+          it["hits"]     = double(compressed.hits);
+          it["misses"]   = double(compressed.misses);
+          it["rejected"] = double(compressed.rejected);
+          it["evicted"]  = double(compressed.evicted);
+        });
+
+        it["drawables"] = it.array([&](auto it) {
+          for (GList* list = gimp_get_image_iter(gimp); list; list = g_list_next(list)) {
+            GimpImage* image  = GIMP_IMAGE(list->data);
+            GList*     layers = gimp_image_get_layer_list(image);
+
+            for (GList* l = layers; l; l = g_list_next(l)) {
+              GimpDrawable* drawable = GIMP_DRAWABLE(l->data);
+              TileManager*  tiles    = gimp_drawable_get_tiles(drawable);
+              TileStats     stats;
+
+              if (!tiles)
+                continue;
+
+              tile_stats_get(tiles, &stats);
+
+              it = it.object([&](auto it) {
+                it["image"]    = gimp_image_get_ID(image);
+                it["drawable"] = gimp_item_get_ID(GIMP_ITEM(drawable));
+                it["name"]     = gimp_object_get_name(GIMP_OBJECT(drawable));
+                publish_stats(it, stats);
+              });
+            }
+
+            g_list_free(layers);
+          }
+        });
+      }));
+}
+
+
+void RESTTileStats::put()
+{
+  JSON::INode json = req_body_json();
+
+  try {
+    if (json.has("enabled"))
+      tile_stats_set_enabled(bool(json["enabled"]));
+
+    if (json.has("reset") && bool(json["reset"]))
+      tile_stats_reset();
+
+  } catch (JSON::INode::InvalidType e) {
+    make_error_response(400, "Invalid request body.");
+    return;
+  }
+
+  make_json_response(200,
+      JSON::build_object([&](auto it) {
+        it["enabled"] = bool(tile_stats_get_enabled());
+      }));
+}
+
+
+void RESTTileStats::del()
+{
+  tile_stats_reset();
+
+  make_json_response(200,
+      JSON::build_object([&](auto it) {
+        it["result"] = true;
+      }));
+}
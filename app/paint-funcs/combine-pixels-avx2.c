@@ -0,0 +1,265 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "combine-pixels.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#include <immintrin.h>
+
+
+#define AVX2_FUNC  __attribute__ ((target ("avx2")))
+
+/*  shifts by a count which is only constant after inlining  */
+#define SRL(x, n)  _mm256_srl_epi32 ((x), _mm_cvtsi32_si128 (n))
+#define SLL(x, n)  _mm256_sll_epi32 ((x), _mm_cvtsi32_si128 (n))
+
+
+/*  8 pixels at a time, one per 32 bit lane.  The colours are mixed in
+ *  single precision and the EPSILON is added in double precision,
+ *  like the C code does, so the truncated results are the same.
+ */
+
+static inline AVX2_FUNC __m256i
+int_mult_avx2 (__m256i a,
+               __m256i b)
+{
+  __m256i t = _mm256_add_epi32 (_mm256_mullo_epi32 (a, b),
+                                _mm256_set1_epi32 (0x80));
+
+  return _mm256_srli_epi32 (_mm256_add_epi32 (_mm256_srli_epi32 (t, 8), t), 8);
+}
+
+static inline AVX2_FUNC __m256i
+int_mult3_avx2 (__m256i a,
+                __m256i b,
+                __m256i c)
+{
+  __m256i t = _mm256_add_epi32 (_mm256_mullo_epi32 (_mm256_mullo_epi32 (a, b),
+                                                    c),
+                                _mm256_set1_epi32 (0x7F5B));
+
+  return _mm256_srli_epi32 (_mm256_add_epi32 (_mm256_srli_epi32 (t, 7), t), 16);
+}
+
+/*  (guchar) (c2 * ratio + c1 * compl_ratio + EPSILON)  */
+static inline AVX2_FUNC __m256i
+mix_avx2 (__m256i c1,
+          __m256i c2,
+          __m256  ratio,
+          __m256  compl_ratio)
+{
+  const __m256d epsilon = _mm256_set1_pd (0.0001);
+  __m256        f;
+  __m128i       lo;
+  __m128i       hi;
+
+  f = _mm256_add_ps (_mm256_mul_ps (_mm256_cvtepi32_ps (c2), ratio),
+                     _mm256_mul_ps (_mm256_cvtepi32_ps (c1), compl_ratio));
+
+  lo = _mm256_cvttpd_epi32 (_mm256_add_pd (_mm256_cvtps_pd (_mm256_castps256_ps128 (f)),
+                                           epsilon));
+  hi = _mm256_cvttpd_epi32 (_mm256_add_pd (_mm256_cvtps_pd (_mm256_extractf128_ps (f, 1)),
+                                           epsilon));
+
+  return _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+}
+
+/*  Combines 8 pixels, @p1 and @p2 hold one pixel per lane with the
+ *  alpha in bits 8 * @alpha, @src2_alpha holds the alpha src2 is
+ *  applied with.
+ */
+static inline AVX2_FUNC __m256i
+combine_inten_a_avx2 (__m256i        p1,
+                      __m256i        p2,
+                      __m256i        src2_alpha,
+                      const gint     alpha,
+                      const gboolean mode_affect)
+{
+  const __m256i ff = _mm256_set1_epi32 (0xff);
+  __m256i       alpha1;
+  __m256i       new_alpha;
+  __m256        ratio;
+  __m256        compl_ratio;
+  __m256i       result;
+  gint          b;
+
+  alpha1    = SRL (p1, 8 * alpha);
+  new_alpha = _mm256_add_epi32 (alpha1,
+                                int_mult_avx2 (_mm256_sub_epi32 (ff, alpha1),
+                                               src2_alpha));
+
+  /*  new_alpha is only 0 where src2_alpha is, and then ratio has to
+   *  be 0, leaving src1 alone
+   */
+  ratio = _mm256_div_ps (_mm256_cvtepi32_ps (src2_alpha),
+                         _mm256_cvtepi32_ps (_mm256_max_epi32 (new_alpha,
+                                                               _mm256_set1_epi32 (1))));
+  compl_ratio = _mm256_sub_ps (_mm256_set1_ps (1.0), ratio);
+
+  if (! mode_affect)
+    new_alpha = _mm256_blendv_epi8 (alpha1, new_alpha,
+                                    _mm256_cmpeq_epi32 (alpha1,
+                                                        _mm256_setzero_si256 ()));
+
+  result = SLL (new_alpha, 8 * alpha);
+
+  for (b = 0; b < alpha; b++)
+    {
+      __m256i c1 = _mm256_and_si256 (SRL (p1, 8 * b), ff);
+      __m256i c2 = _mm256_and_si256 (SRL (p2, 8 * b), ff);
+
+      result = _mm256_or_si256 (result,
+                                SLL (mix_avx2 (c1, c2, ratio, compl_ratio),
+                                     8 * b));
+    }
+
+  return result;
+}
+
+static inline AVX2_FUNC __m256i
+load_graya_avx2 (const guchar *src)
+{
+  return _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i *) src));
+}
+
+static inline AVX2_FUNC void
+store_graya_avx2 (guchar  *dest,
+                  __m256i  p)
+{
+  p = _mm256_permute4x64_epi64 (_mm256_packus_epi32 (p, p),
+                                _MM_SHUFFLE (3, 1, 2, 0));
+
+  _mm_storeu_si128 ((__m128i *) dest, _mm256_castsi256_si128 (p));
+}
+
+static inline AVX2_FUNC void
+combine_inten_a_inten_a_avx2 (const guchar   *src1,
+                              const guchar   *src2,
+                              guchar         *dest,
+                              const guchar   *mask,
+                              guint           opacity,
+                              guint           length,
+                              const guint     bytes,
+                              const gboolean  mode_affect)
+{
+  const gint    alpha = bytes - 1;
+  const __m256i op    = _mm256_set1_epi32 (opacity);
+  guint         n     = length / 8;
+
+  while (n--)
+    {
+      __m256i p1;
+      __m256i p2;
+      __m256i src2_alpha;
+      __m256i result;
+
+      if (bytes == 4)
+        {
+          p1 = _mm256_loadu_si256 ((const __m256i *) src1);
+          p2 = _mm256_loadu_si256 ((const __m256i *) src2);
+        }
+      else
+        {
+          p1 = load_graya_avx2 (src1);
+          p2 = load_graya_avx2 (src2);
+        }
+
+      src2_alpha = SRL (p2, 8 * alpha);
+
+      if (mask)
+        {
+          __m256i m =
+            _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) mask));
+
+          if (opacity == OPAQUE_OPACITY)
+            src2_alpha = int_mult_avx2 (src2_alpha, m);
+          else
+            src2_alpha = int_mult3_avx2 (src2_alpha, m, op);
+
+          mask += 8;
+        }
+      else if (opacity != OPAQUE_OPACITY)
+        {
+          src2_alpha = int_mult_avx2 (src2_alpha, op);
+        }
+
+      result = combine_inten_a_avx2 (p1, p2, src2_alpha, alpha, mode_affect);
+
+      if (bytes == 4)
+        _mm256_storeu_si256 ((__m256i *) dest, result);
+      else
+        store_graya_avx2 (dest, result);
+
+      src1 += 8 * bytes;
+      src2 += 8 * bytes;
+      dest += 8 * bytes;
+    }
+
+  length %= 8;
+
+  if (length)
+    {
+      CombinePixelsFunc func;
+
+      func = combine_pixels_generic_funcs.inten_a_inten_a[mode_affect][bytes - 1];
+
+      func (src1, src2, dest, mask, opacity, length);
+    }
+}
+
+
+#define COMBINE_PIXELS_AVX2_FUNC(name, bytes, mode_affect)              \
+static AVX2_FUNC void                                                   \
+name (const guchar *src1,                                               \
+      const guchar *src2,                                               \
+      guchar       *dest,                                               \
+      const guchar *mask,                                               \
+      guint         opacity,                                            \
+      guint         length)                                             \
+{                                                                       \
+  combine_inten_a_inten_a_avx2 (src1, src2, dest, mask, opacity, length, \
+                                bytes, mode_affect);                    \
+}
+
+COMBINE_PIXELS_AVX2_FUNC (combine_inten_a_inten_a_2_avx2,          2, FALSE)
+COMBINE_PIXELS_AVX2_FUNC (combine_inten_a_inten_a_4_avx2,          4, FALSE)
+COMBINE_PIXELS_AVX2_FUNC (combine_inten_a_inten_a_2_affected_avx2, 2, TRUE)
+COMBINE_PIXELS_AVX2_FUNC (combine_inten_a_inten_a_4_affected_avx2, 4, TRUE)
+
+#undef COMBINE_PIXELS_AVX2_FUNC
+
+#undef SRL
+#undef SLL
+
+
+void
+combine_pixels_avx2_install (CombinePixelsFuncs *funcs)
+{
+  funcs->inten_a_inten_a[0][1] = combine_inten_a_inten_a_2_avx2;
+  funcs->inten_a_inten_a[0][3] = combine_inten_a_inten_a_4_avx2;
+  funcs->inten_a_inten_a[1][1] = combine_inten_a_inten_a_2_affected_avx2;
+  funcs->inten_a_inten_a[1][3] = combine_inten_a_inten_a_4_affected_avx2;
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
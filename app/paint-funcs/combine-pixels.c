@@ -0,0 +1,345 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  The combining step of combine_sub_region() for the intensity
+ *  types when all channels are affected.  The generic versions do
+ *  what the combine_*_pixels() functions of paint-funcs.c do, but
+ *  are compiled once per pixel size and alpha behaviour of the layer
+ *  mode, so the per-pixel checks of the affect array and of the mode
+ *  go away.  The accelerated versions in combine-pixels-avx2.c have
+ *  to match them bit for bit; app/tests/test-combine-pixels.c checks
+ *  that.
+ *
+ *  Where src2 does not cover a pixel at all, its colour is copied
+ *  from src1.  The old functions leave it alone there, except in the
+ *  mask runs they skip, which makes no difference where src1 is the
+ *  destination, as it is for the projection.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-funcs-types.h"
+
+#include "base/accel-funcs.h"
+
+#include "combine-pixels.h"
+#include "paint-funcs-utils.h"
+
+
+#define EPSILON  0.0001
+
+
+CombinePixelsFuncs combine_pixels_funcs;
+
+
+/*  The pixel functions are inlined into the row functions below with
+ *  constant @bytes and @mode_affect.
+ */
+
+static inline void
+combine_inten_a_pixel (const guchar   *src1,
+                       const guchar   *src2,
+                       guchar         *dest,
+                       guchar          src2_alpha,
+                       const guint     bytes,
+                       const gboolean  mode_affect)
+{
+  const guint     alpha = bytes - 1;
+  register gulong tmp;
+  guchar          new_alpha;
+  guint           b;
+
+  new_alpha = src1[alpha] + INT_MULT ((255 - src1[alpha]), src2_alpha, tmp);
+
+  if (src2_alpha == 0)
+    {
+      for (b = 0; b < alpha; b++)
+        dest[b] = src1[b];
+    }
+  else if (src2_alpha == new_alpha)
+    {
+      for (b = 0; b < alpha; b++)
+        dest[b] = src2[b];
+    }
+  else
+    {
+      const gfloat ratio       = (gfloat) src2_alpha / new_alpha;
+      const gfloat compl_ratio = 1.0 - ratio;
+
+      for (b = 0; b < alpha; b++)
+        dest[b] = (guchar) (src2[b] * ratio + src1[b] * compl_ratio + EPSILON);
+    }
+
+  if (mode_affect || ! src1[alpha])
+    dest[alpha] = new_alpha;
+  else
+    dest[alpha] = src1[alpha];
+}
+
+static inline void
+combine_inten_inten (const guchar *src1,
+                     const guchar *src2,
+                     guchar       *dest,
+                     const guchar *mask,
+                     guint         opacity,
+                     guint         length,
+                     const guint   bytes)
+{
+  register gulong tmp;
+  guint           b;
+
+  if (mask)
+    {
+      while (length--)
+        {
+          const guchar new_alpha = INT_MULT (*mask, opacity, tmp);
+
+          for (b = 0; b < bytes; b++)
+            dest[b] = INT_BLEND (src2[b], src1[b], new_alpha, tmp);
+
+          mask++;
+          src1 += bytes;
+          src2 += bytes;
+          dest += bytes;
+        }
+    }
+  else
+    {
+      while (length--)
+        {
+          for (b = 0; b < bytes; b++)
+            dest[b] = INT_BLEND (src2[b], src1[b], opacity, tmp);
+
+          src1 += bytes;
+          src2 += bytes;
+          dest += bytes;
+        }
+    }
+}
+
+static inline void
+combine_inten_inten_a (const guchar *src1,
+                       const guchar *src2,
+                       guchar       *dest,
+                       const guchar *mask,
+                       guint         opacity,
+                       guint         length,
+                       const guint   bytes)
+{
+  register glong t1;
+  guint          b;
+
+  while (length--)
+    {
+      const guchar new_alpha = (mask ?
+                                INT_MULT3 (src2[bytes], *mask, opacity, t1) :
+                                INT_MULT (src2[bytes], opacity, t1));
+
+      for (b = 0; b < bytes; b++)
+        dest[b] = INT_BLEND (src2[b], src1[b], new_alpha, t1);
+
+      if (mask)
+        mask++;
+
+      src1 += bytes;
+      src2 += bytes + 1;
+      dest += bytes;
+    }
+}
+
+static inline void
+combine_inten_a_inten (const guchar   *src1,
+                       const guchar   *src2,
+                       guchar         *dest,
+                       const guchar   *mask,
+                       guint           opacity,
+                       guint           length,
+                       const guint     bytes,
+                       const gboolean  mode_affect)
+{
+  register gulong tmp;
+
+  if (mask && opacity == OPAQUE_OPACITY)
+    {
+      while (length--)
+        {
+          combine_inten_a_pixel (src1, src2, dest, *mask,
+                                 bytes, mode_affect);
+
+          mask++;
+          src1 += bytes;
+          src2 += bytes - 1;
+          dest += bytes;
+        }
+    }
+  else if (mask)
+    {
+      while (length--)
+        {
+          combine_inten_a_pixel (src1, src2, dest,
+                                 INT_MULT (*mask, opacity, tmp),
+                                 bytes, mode_affect);
+
+          mask++;
+          src1 += bytes;
+          src2 += bytes - 1;
+          dest += bytes;
+        }
+    }
+  else
+    {
+      while (length--)
+        {
+          combine_inten_a_pixel (src1, src2, dest, opacity,
+                                 bytes, mode_affect);
+
+          src1 += bytes;
+          src2 += bytes - 1;
+          dest += bytes;
+        }
+    }
+}
+
+static inline void
+combine_inten_a_inten_a (const guchar   *src1,
+                         const guchar   *src2,
+                         guchar         *dest,
+                         const guchar   *mask,
+                         guint           opacity,
+                         guint           length,
+                         const guint     bytes,
+                         const gboolean  mode_affect)
+{
+  const guint     alpha = bytes - 1;
+  register gulong tmp;
+
+  if (mask && opacity == OPAQUE_OPACITY)
+    {
+      while (length--)
+        {
+          combine_inten_a_pixel (src1, src2, dest,
+                                 INT_MULT (src2[alpha], *mask, tmp),
+                                 bytes, mode_affect);
+
+          mask++;
+          src1 += bytes;
+          src2 += bytes;
+          dest += bytes;
+        }
+    }
+  else if (mask)
+    {
+      while (length--)
+        {
+          combine_inten_a_pixel (src1, src2, dest,
+                                 INT_MULT3 (src2[alpha], *mask, opacity, tmp),
+                                 bytes, mode_affect);
+
+          mask++;
+          src1 += bytes;
+          src2 += bytes;
+          dest += bytes;
+        }
+    }
+  else if (opacity == OPAQUE_OPACITY)
+    {
+      while (length--)
+        {
+          combine_inten_a_pixel (src1, src2, dest, src2[alpha],
+                                 bytes, mode_affect);
+
+          src1 += bytes;
+          src2 += bytes;
+          dest += bytes;
+        }
+    }
+  else
+    {
+      while (length--)
+        {
+          combine_inten_a_pixel (src1, src2, dest,
+                                 INT_MULT (src2[alpha], opacity, tmp),
+                                 bytes, mode_affect);
+
+          src1 += bytes;
+          src2 += bytes;
+          dest += bytes;
+        }
+    }
+}
+
+
+/*  one row function per combination, the arguments after the common
+ *  ones are those of the inline function they call
+ */
+#define COMBINE_PIXELS_FUNC(name, func, ...)                            \
+static void                                                             \
+name (const guchar *src1,                                               \
+      const guchar *src2,                                               \
+      guchar       *dest,                                               \
+      const guchar *mask,                                               \
+      guint         opacity,                                            \
+      guint         length)                                             \
+{                                                                       \
+  func (src1, src2, dest, mask, opacity, length, __VA_ARGS__);          \
+}
+
+COMBINE_PIXELS_FUNC (combine_inten_inten_1,   combine_inten_inten,   1)
+COMBINE_PIXELS_FUNC (combine_inten_inten_3,   combine_inten_inten,   3)
+COMBINE_PIXELS_FUNC (combine_inten_inten_a_1, combine_inten_inten_a, 1)
+COMBINE_PIXELS_FUNC (combine_inten_inten_a_3, combine_inten_inten_a, 3)
+
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_2,          combine_inten_a_inten, 2, FALSE)
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_4,          combine_inten_a_inten, 4, FALSE)
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_2_affected, combine_inten_a_inten, 2, TRUE)
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_4_affected, combine_inten_a_inten, 4, TRUE)
+
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_a_2,          combine_inten_a_inten_a, 2, FALSE)
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_a_4,          combine_inten_a_inten_a, 4, FALSE)
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_a_2_affected, combine_inten_a_inten_a, 2, TRUE)
+COMBINE_PIXELS_FUNC (combine_inten_a_inten_a_4_affected, combine_inten_a_inten_a, 4, TRUE)
+
+#undef COMBINE_PIXELS_FUNC
+
+
+const CombinePixelsFuncs combine_pixels_generic_funcs =
+{
+  { combine_inten_inten_1,   NULL, combine_inten_inten_3,   NULL },
+  { combine_inten_inten_a_1, NULL, combine_inten_inten_a_3, NULL },
+  {
+    { NULL, combine_inten_a_inten_2,          NULL, combine_inten_a_inten_4          },
+    { NULL, combine_inten_a_inten_2_affected, NULL, combine_inten_a_inten_4_affected }
+  },
+  {
+    { NULL, combine_inten_a_inten_a_2,          NULL, combine_inten_a_inten_a_4          },
+    { NULL, combine_inten_a_inten_a_2_affected, NULL, combine_inten_a_inten_a_4_affected }
+  }
+};
+
+
+void
+combine_pixels_init (guint accel)
+{
+  accel_funcs_init (&combine_pixels_funcs, &combine_pixels_generic_funcs,
+                    sizeof (CombinePixelsFuncs), accel,
+                    NULL,
+                    ACCEL_AVX2 (combine_pixels_avx2_install));
+}
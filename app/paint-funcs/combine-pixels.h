@@ -0,0 +1,65 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __COMBINE_PIXELS_H__
+#define __COMBINE_PIXELS_H__
+
+
+/*  Combines @length pixels of @src2, the result of the layer mode,
+ *  with @src1 into @dest, like the combine_*_pixels() functions of
+ *  paint-funcs.c do when all channels are affected.  @mask may be
+ *  NULL.
+ */
+typedef void (* CombinePixelsFunc) (const guchar *src1,
+                                    const guchar *src2,
+                                    guchar       *dest,
+                                    const guchar *mask,
+                                    guint         opacity,
+                                    guint         length);
+
+
+typedef struct _CombinePixelsFuncs CombinePixelsFuncs;
+
+struct _CombinePixelsFuncs
+{
+  /*  by bytes - 1 of src1, 1 and 3  */
+  CombinePixelsFunc  inten_inten[4];
+  CombinePixelsFunc  inten_inten_a[4];
+
+  /*  by whether the layer mode affects alpha and by bytes - 1 of
+   *  src1, 2 and 4
+   */
+  CombinePixelsFunc  inten_a_inten[2][4];
+  CombinePixelsFunc  inten_a_inten_a[2][4];
+};
+
+
+/*  the implementations in use, see base/accel-funcs.h  */
+extern CombinePixelsFuncs combine_pixels_funcs;
+
+
+void   combine_pixels_init (guint accel);
+
+
+/*  for the combine_pixels implementations only  */
+
+extern const CombinePixelsFuncs combine_pixels_generic_funcs;
+
+void   combine_pixels_avx2_install (CombinePixelsFuncs *funcs);
+
+
+#endif  /*  __COMBINE_PIXELS_H__  */
@@ -0,0 +1,629 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  The transforms are separable.  The first phase finds the nearest
+ *  seed in every column, sweeping down and up strips of TILE_WIDTH
+ *  columns.  The second phase combines the columns along every row,
+ *  in bands of rows.  Both phases run on the pixel processor.
+ *
+ *  The mask is transformed in chunks of CHUNK_HEIGHT rows, and the
+ *  first phase carries the column distances across their edges: down
+ *  from the last row of the chunk before, and up from the first row of
+ *  the chunk after, which a sweep up the whole mask finds beforehand.
+ *
+ *  The Euclidean transform is the one of A. Meijster, J. B. T. M.
+ *  Roerdink and W. H. Hesselink, "A General Algorithm for Computing
+ *  Distance Transforms in Linear Time", 2000.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "paint-funcs-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/tile.h"
+
+#include "distance-transform.h"
+
+
+/*  rows in memory at once  */
+#define CHUNK_HEIGHT  TILE_HEIGHT
+
+/*  rows per item of the second phase  */
+#define BAND_HEIGHT   8
+
+
+typedef struct
+{
+  gint                       width;
+  gint                       height;
+  gboolean                   seed_outside;
+  gint                       limit;     /*  the largest column distance  */
+
+  DistanceTransformReadFunc  read_seeds;
+  gpointer                   data;
+
+  /*  the chunk being transformed, and its column distances  */
+  gint                       y;
+  gint                       n_rows;
+  guchar                    *seeds;
+  gint                      *columns;
+
+  /*  the down distances of the row above the chunk, and the up
+   *  distances of the row below every chunk
+   */
+  gint                      *above;
+  gint                      *below;
+
+  /*  distance_transform_dilate_chunked(), reach[d] is the largest dx
+   *  whose column of the element reaches a seed d rows away
+   */
+  const gint                *reach;
+  guchar                    *dest;
+
+  /*  distance_transform_euclidean_chunked()  */
+  gfloat                    *euclidean;
+} Transform;
+
+/*  masks in memory  */
+typedef struct
+{
+  const guchar *seeds;
+  gint          width;
+  gpointer      dest;
+} Memory;
+
+
+static void      transform_init        (Transform                 *transform,
+                                        gint                       width,
+                                        gint                       height,
+                                        gboolean                   seed_outside,
+                                        gint                       limit,
+                                        DistanceTransformReadFunc  read_seeds,
+                                        gpointer                   data);
+static gboolean  transform_next_chunk  (Transform                 *transform);
+static void      transform_free        (Transform                 *transform);
+
+static void      columns_strip         (Transform                 *transform,
+                                        gint                       strip);
+static void      dilate_band           (Transform                 *transform,
+                                        gint                       band);
+static void      euclidean_band        (Transform                 *transform,
+                                        gint                       band);
+
+static void      memory_read           (Memory                    *memory,
+                                        gint                       y,
+                                        gint                       n_rows,
+                                        guchar                    *seeds);
+static void      memory_write_mask     (Memory                    *memory,
+                                        gint                       y,
+                                        gint                       n_rows,
+                                        guchar                    *mask);
+static void      memory_write_dist     (Memory                    *memory,
+                                        gint                       y,
+                                        gint                       n_rows,
+                                        gfloat                    *dist);
+static void      memory_write_columns  (Memory                    *memory,
+                                        gint                       y,
+                                        gint                       n_rows,
+                                        gint                      *columns);
+
+
+/*  public functions  */
+
+void
+distance_transform_columns_chunked (gint                            width,
+                                    gint                            height,
+                                    gboolean                        seed_outside,
+                                    gint                            limit,
+                                    DistanceTransformReadFunc       read_seeds,
+                                    DistanceTransformWriteColsFunc  write_columns,
+                                    gpointer                        data)
+{
+  Transform transform;
+
+  g_return_if_fail (limit >= 0);
+  g_return_if_fail (read_seeds != NULL);
+  g_return_if_fail (write_columns != NULL);
+
+  if (width < 1 || height < 1)
+    return;
+
+  transform_init (&transform, width, height, seed_outside, limit,
+                  read_seeds, data);
+
+  while (transform_next_chunk (&transform))
+    write_columns (data, transform.y, transform.n_rows, transform.columns);
+
+  transform_free (&transform);
+}
+
+void
+distance_transform_dilate_chunked (gint                            width,
+                                   gint                            height,
+                                   const gint                     *heights,
+                                   gint                            radius,
+                                   gboolean                        seed_outside,
+                                   DistanceTransformReadFunc       read_seeds,
+                                   DistanceTransformWriteMaskFunc  write_mask,
+                                   gpointer                        data)
+{
+  Transform  transform;
+  gint      *reach;
+  gint       limit;
+  gint       d, dx;
+
+  g_return_if_fail (heights != NULL);
+  g_return_if_fail (radius >= 0);
+  g_return_if_fail (heights[0] >= 0 && heights[0] < G_MAXUINT16);
+  g_return_if_fail (read_seeds != NULL);
+  g_return_if_fail (write_mask != NULL);
+
+  if (width < 1 || height < 1)
+    return;
+
+  /*  seeds further than the middle column reaches don't matter  */
+  limit = heights[0] + 1;
+
+  reach = g_new (gint, limit);
+
+  for (d = 0, dx = radius; d < limit; d++)
+    {
+      while (heights[dx] < d)
+        dx--;
+
+      reach[d] = dx;
+    }
+
+  transform_init (&transform, width, height, seed_outside, limit,
+                  read_seeds, data);
+
+  transform.reach = reach;
+  transform.dest  = g_new (guchar, width * CHUNK_HEIGHT);
+
+  while (transform_next_chunk (&transform))
+    {
+      pixel_processor_process_items ((PixelProcessorItemFunc) dilate_band,
+                                     &transform,
+                                     (transform.n_rows + BAND_HEIGHT - 1) /
+                                     BAND_HEIGHT);
+
+      write_mask (data, transform.y, transform.n_rows, transform.dest);
+    }
+
+  g_free (transform.dest);
+  g_free (reach);
+
+  transform_free (&transform);
+}
+
+void
+distance_transform_euclidean_chunked (gint                            width,
+                                      gint                            height,
+                                      gboolean                        seed_outside,
+                                      DistanceTransformReadFunc       read_seeds,
+                                      DistanceTransformWriteDistFunc  write_dist,
+                                      gpointer                        data)
+{
+  Transform transform;
+
+  g_return_if_fail (read_seeds != NULL);
+  g_return_if_fail (write_dist != NULL);
+
+  if (width < 1 || height < 1)
+    return;
+
+  /*  further than any seed in the mask  */
+  transform_init (&transform, width, height, seed_outside, width + height,
+                  read_seeds, data);
+
+  transform.euclidean = g_new (gfloat, width * CHUNK_HEIGHT);
+
+  while (transform_next_chunk (&transform))
+    {
+      pixel_processor_process_items ((PixelProcessorItemFunc) euclidean_band,
+                                     &transform,
+                                     (transform.n_rows + BAND_HEIGHT - 1) /
+                                     BAND_HEIGHT);
+
+      write_dist (data, transform.y, transform.n_rows, transform.euclidean);
+    }
+
+  g_free (transform.euclidean);
+
+  transform_free (&transform);
+}
+
+void
+distance_transform_columns (const guchar *seeds,
+                            gint          width,
+                            gint          height,
+                            gboolean      seed_outside,
+                            guint16       limit,
+                            guint16      *dist)
+{
+  Memory memory = { seeds, width, dist };
+
+  g_return_if_fail (seeds != NULL);
+  g_return_if_fail (dist != NULL);
+
+  distance_transform_columns_chunked (width, height, seed_outside, limit,
+                                      (DistanceTransformReadFunc)
+                                      memory_read,
+                                      (DistanceTransformWriteColsFunc)
+                                      memory_write_columns,
+                                      &memory);
+}
+
+void
+distance_transform_dilate (const guchar *seeds,
+                           gint          width,
+                           gint          height,
+                           const gint   *heights,
+                           gint          radius,
+                           gboolean      seed_outside,
+                           guchar       *dest)
+{
+  Memory memory = { seeds, width, dest };
+
+  g_return_if_fail (seeds != NULL);
+  g_return_if_fail (dest != NULL);
+
+  distance_transform_dilate_chunked (width, height, heights, radius,
+                                     seed_outside,
+                                     (DistanceTransformReadFunc) memory_read,
+                                     (DistanceTransformWriteMaskFunc)
+                                     memory_write_mask,
+                                     &memory);
+}
+
+void
+distance_transform_euclidean (const guchar *seeds,
+                              gint          width,
+                              gint          height,
+                              gboolean      seed_outside,
+                              gfloat       *dist)
+{
+  Memory memory = { seeds, width, dist };
+
+  g_return_if_fail (seeds != NULL);
+  g_return_if_fail (dist != NULL);
+
+  distance_transform_euclidean_chunked (width, height, seed_outside,
+                                        (DistanceTransformReadFunc)
+                                        memory_read,
+                                        (DistanceTransformWriteDistFunc)
+                                        memory_write_dist,
+                                        &memory);
+}
+
+
+/*  private functions  */
+
+static void
+transform_init (Transform                 *transform,
+                gint                       width,
+                gint                       height,
+                gboolean                   seed_outside,
+                gint                       limit,
+                DistanceTransformReadFunc  read_seeds,
+                gpointer                   data)
+{
+  const gint n_chunks = (height + CHUNK_HEIGHT - 1) / CHUNK_HEIGHT;
+  const gint edge     = seed_outside ? 0 : limit;
+  gint       chunk;
+  gint       x, y;
+
+  memset (transform, 0, sizeof (Transform));
+
+  transform->width        = width;
+  transform->height       = height;
+  transform->seed_outside = seed_outside;
+  transform->limit        = limit;
+  transform->read_seeds   = read_seeds;
+  transform->data         = data;
+  transform->seeds        = g_new (guchar, width * CHUNK_HEIGHT);
+  transform->columns      = g_new (gint, width * CHUNK_HEIGHT);
+  transform->above        = g_new (gint, width);
+  transform->below        = g_new (gint, width * n_chunks);
+
+  for (x = 0; x < width; x++)
+    {
+      transform->above[x]                         = edge;
+      transform->below[(n_chunks - 1) * width + x] = edge;
+    }
+
+  /*  sweep up to the first row of every chunk but the first, which is
+   *  the row below the chunk before
+   */
+  for (chunk = n_chunks - 1; chunk > 0; chunk--)
+    {
+      const gint  y0     = chunk * CHUNK_HEIGHT;
+      const gint  n_rows = MIN (CHUNK_HEIGHT, height - y0);
+      gint       *up     = transform->below + (chunk - 1) * width;
+
+      read_seeds (data, y0, n_rows, transform->seeds);
+
+      memcpy (up, up + width, width * sizeof (gint));
+
+      for (y = n_rows - 1; y >= 0; y--)
+        {
+          const guchar *s = transform->seeds + y * width;
+
+          for (x = 0; x < width; x++)
+            up[x] = s[x] ? 0 : MIN (up[x] + 1, limit);
+        }
+    }
+}
+
+/*  Reads the next chunk and finds its column distances, returns FALSE
+ *  after the last one.
+ */
+static gboolean
+transform_next_chunk (Transform *transform)
+{
+  if (transform->y + transform->n_rows >= transform->height)
+    return FALSE;
+
+  transform->y      += transform->n_rows;
+  transform->n_rows  = MIN (CHUNK_HEIGHT, transform->height - transform->y);
+
+  transform->read_seeds (transform->data,
+                         transform->y, transform->n_rows, transform->seeds);
+
+  pixel_processor_process_items ((PixelProcessorItemFunc) columns_strip,
+                                 transform,
+                                 (transform->width + TILE_WIDTH - 1) /
+                                 TILE_WIDTH);
+
+  return TRUE;
+}
+
+static void
+transform_free (Transform *transform)
+{
+  g_free (transform->seeds);
+  g_free (transform->columns);
+  g_free (transform->above);
+  g_free (transform->below);
+}
+
+static void
+columns_strip (Transform *transform,
+               gint       strip)
+{
+  const gint  width  = transform->width;
+  const gint  n_rows = transform->n_rows;
+  const gint  limit  = transform->limit;
+  const gint  x0     = strip * TILE_WIDTH;
+  const gint  n      = MIN (TILE_WIDTH, width - x0);
+  const gint *below  = (transform->below +
+                        transform->y / CHUNK_HEIGHT * width + x0);
+  gint       *above  = transform->above + x0;
+  gint        x, y;
+
+  /*  down, from the nearest seed above  */
+  for (y = 0; y < n_rows; y++)
+    {
+      const guchar *s    = transform->seeds   + y * width + x0;
+      gint         *g    = transform->columns + y * width + x0;
+      const gint   *prev = y ? g - width : above;
+
+      for (x = 0; x < n; x++)
+        g[x] = s[x] ? 0 : MIN (prev[x] + 1, limit);
+    }
+
+  /*  on to the next chunk  */
+  memcpy (above, transform->columns + (n_rows - 1) * width + x0,
+          n * sizeof (gint));
+
+  /*  and up, from the nearest seed below  */
+  for (y = n_rows - 1; y >= 0; y--)
+    {
+      gint       *g    = transform->columns + y * width + x0;
+      const gint *next = (y < n_rows - 1) ? g + width : below;
+
+      for (x = 0; x < n; x++)
+        g[x] = MIN (g[x], next[x] + 1);
+    }
+}
+
+static void
+dilate_band (Transform *transform,
+             gint       band)
+{
+  const gint  width  = transform->width;
+  const gint  limit  = transform->limit;
+  const gint *reach  = transform->reach;
+  const gint  y_end  = MIN ((band + 1) * BAND_HEIGHT, transform->n_rows);
+  gint       *cover  = g_new (gint, width + 1);
+  gint        y;
+
+  for (y = band * BAND_HEIGHT; y < y_end; y++)
+    {
+      const gint *d    = transform->columns + y * width;
+      guchar     *dest = transform->dest    + y * width;
+      gint        count;
+      gint        x;
+
+      memset (cover, 0, (width + 1) * sizeof (gint));
+
+      /*  mark where the element around each seed starts and ends  */
+      for (x = 0; x < width; x++)
+        {
+          if (d[x] < limit)
+            {
+              const gint r = reach[d[x]];
+
+              cover[MAX (x - r, 0)]++;
+              cover[MIN (x + r + 1, width)]--;
+            }
+        }
+
+      if (transform->seed_outside)
+        {
+          cover[0]++;
+          cover[MIN (reach[0], width)]--;
+
+          cover[MAX (width - reach[0], 0)]++;
+          cover[width]--;
+        }
+
+      for (x = 0, count = 0; x < width; x++)
+        {
+          count += cover[x];
+
+          dest[x] = count ? 255 : 0;
+        }
+    }
+
+  g_free (cover);
+}
+
+/*  the squared distance from x to the nearest seed in column i  */
+#define F(x, i) ((gint64) ((x) - (i)) * ((x) - (i)) + (gint64) g[i] * g[i])
+
+/*  the last x which is at least as near to column i as to column u > i  */
+static inline gint
+separation (const gint *g,
+            gint        i,
+            gint        u)
+{
+  const gint64 num = ((gint64) u * u - (gint64) i * i +
+                      (gint64) g[u] * g[u] - (gint64) g[i] * g[i]);
+  const gint64 den = 2 * (u - i);
+
+  /*  rounded down, num can be negative  */
+  return (num >= 0) ? num / den : - ((- num + den - 1) / den);
+}
+
+static void
+euclidean_band (Transform *transform,
+                gint       band)
+{
+  const gint    width     = transform->width;
+  const gint64  infinity2 = (gint64) transform->limit * transform->limit;
+  const gint    y_end     = MIN ((band + 1) * BAND_HEIGHT, transform->n_rows);
+  gint         *s         = g_new (gint, width);
+  gint         *t         = g_new (gint, width);
+  gint          y;
+
+  for (y = band * BAND_HEIGHT; y < y_end; y++)
+    {
+      const gint *g    = transform->columns   + y * width;
+      gfloat     *dist = transform->euclidean + y * width;
+      gint        q    = 0;
+      gint        u;
+
+      /*  the columns on the lower envelope, s[q] nearest from t[q] on  */
+      s[0] = 0;
+      t[0] = 0;
+
+      for (u = 1; u < width; u++)
+        {
+          while (q >= 0 && F (t[q], s[q]) > F (t[q], u))
+            q--;
+
+          if (q < 0)
+            {
+              q = 0;
+              s[0] = u;
+            }
+          else
+            {
+              const gint w = 1 + separation (g, s[q], u);
+
+              if (w < width)
+                {
+                  q++;
+                  s[q] = u;
+                  t[q] = w;
+                }
+            }
+        }
+
+      for (u = width - 1; u >= 0; u--)
+        {
+          gint64 d = F (u, s[q]);
+
+          if (transform->seed_outside)
+            d = MIN (d, MIN ((gint64) (u + 1) * (u + 1),
+                             (gint64) (width - u) * (width - u)));
+
+          dist[u] = (d < infinity2) ? sqrt (d) : G_MAXFLOAT;
+
+          if (u == t[q])
+            q--;
+        }
+    }
+
+  g_free (s);
+  g_free (t);
+}
+
+#undef F
+
+static void
+memory_read (Memory *memory,
+             gint    y,
+             gint    n_rows,
+             guchar *seeds)
+{
+  memcpy (seeds, memory->seeds + y * memory->width, n_rows * memory->width);
+}
+
+static void
+memory_write_mask (Memory *memory,
+                   gint    y,
+                   gint    n_rows,
+                   guchar *mask)
+{
+  guchar *dest = memory->dest;
+
+  memcpy (dest + y * memory->width, mask, n_rows * memory->width);
+}
+
+static void
+memory_write_dist (Memory *memory,
+                   gint    y,
+                   gint    n_rows,
+                   gfloat *dist)
+{
+  gfloat *dest = memory->dest;
+
+  memcpy (dest + y * memory->width, dist,
+          n_rows * memory->width * sizeof (gfloat));
+}
+
+static void
+memory_write_columns (Memory *memory,
+                      gint    y,
+                      gint    n_rows,
+                      gint   *columns)
+{
+  guint16 *dest = (guint16 *) memory->dest + y * memory->width;
+  gint     i;
+
+  for (i = 0; i < n_rows * memory->width; i++)
+    dest[i] = columns[i];
+}
@@ -0,0 +1,126 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DISTANCE_TRANSFORM_H__
+#define __DISTANCE_TRANSFORM_H__
+
+
+/*  Distance transforms of masks of @width * @height pixels, computed
+ *  in parallel on the pixel processor.  The seeds are the pixels of
+ *  the mask which are not 0.  With @seed_outside, all pixels around
+ *  the mask are seeds too.
+ *
+ *  The mask is read and the result is written in chunks of up to
+ *  TILE_HEIGHT rows, from the top down, and only one chunk is kept in
+ *  memory: about 9 bytes per pixel of it, and 4 bytes per column for
+ *  every chunk of the mask.  The mask is read twice, bottom up first.
+ */
+
+
+/*  Fills @seeds with the @n_rows rows of the mask from row @y on,
+ *  @width bytes each.
+ */
+typedef void (* DistanceTransformReadFunc)      (gpointer  data,
+                                                 gint      y,
+                                                 gint      n_rows,
+                                                 guchar   *seeds);
+
+/*  Takes the result for the @n_rows rows from row @y on, @width
+ *  values each, which it may change.
+ */
+typedef void (* DistanceTransformWriteMaskFunc) (gpointer  data,
+                                                 gint      y,
+                                                 gint      n_rows,
+                                                 guchar   *mask);
+typedef void (* DistanceTransformWriteDistFunc) (gpointer  data,
+                                                 gint      y,
+                                                 gint      n_rows,
+                                                 gfloat   *dist);
+typedef void (* DistanceTransformWriteColsFunc) (gpointer  data,
+                                                 gint      y,
+                                                 gint      n_rows,
+                                                 gint     *columns);
+
+
+/*  The distance from every pixel to the nearest seed in its column,
+ *  or @limit if there is none closer.
+ */
+void   distance_transform_columns_chunked
+                                    (gint                            width,
+                                     gint                            height,
+                                     gboolean                        seed_outside,
+                                     gint                            limit,
+                                     DistanceTransformReadFunc       read_seeds,
+                                     DistanceTransformWriteColsFunc  write_columns,
+                                     gpointer                        data);
+
+/*  Sets the pixels which a structuring element centered on a seed
+ *  covers to 255, the others to 0.  The element covers the rows
+ *  -heights[dx] to heights[dx] of the columns -dx and dx, for dx from
+ *  0 to @radius, and @heights must not increase with dx.  Takes linear
+ *  time, whatever the size of the element.  A chunk of rows is
+ *  written after it was read for the second time, so @write_mask can
+ *  write to the mask @read_seeds reads.
+ */
+void   distance_transform_dilate_chunked
+                                    (gint                            width,
+                                     gint                            height,
+                                     const gint                     *heights,
+                                     gint                            radius,
+                                     gboolean                        seed_outside,
+                                     DistanceTransformReadFunc       read_seeds,
+                                     DistanceTransformWriteMaskFunc  write_mask,
+                                     gpointer                        data);
+
+/*  The exact Euclidean distance of every pixel to the nearest seed,
+ *  or G_MAXFLOAT if there is no seed at all.
+ */
+void   distance_transform_euclidean_chunked
+                                    (gint                            width,
+                                     gint                            height,
+                                     gboolean                        seed_outside,
+                                     DistanceTransformReadFunc       read_seeds,
+                                     DistanceTransformWriteDistFunc  write_dist,
+                                     gpointer                        data);
+
+
+/*  The same for masks in memory, without padding.  */
+
+void   distance_transform_columns   (const guchar *seeds,
+                                     gint          width,
+                                     gint          height,
+                                     gboolean      seed_outside,
+                                     guint16       limit,
+                                     guint16      *dist);
+
+/*  @dest can be @seeds.  */
+void   distance_transform_dilate    (const guchar *seeds,
+                                     gint          width,
+                                     gint          height,
+                                     const gint   *heights,
+                                     gint          radius,
+                                     gboolean      seed_outside,
+                                     guchar       *dest);
+
+void   distance_transform_euclidean (const guchar *seeds,
+                                     gint          width,
+                                     gint          height,
+                                     gboolean      seed_outside,
+                                     gfloat       *dist);
+
+
+#endif  /*  __DISTANCE_TRANSFORM_H__  */
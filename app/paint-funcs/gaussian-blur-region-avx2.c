@@ -0,0 +1,109 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "gaussian-blur-region.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#include <immintrin.h>
+
+
+#define AVX2_FUNC  __attribute__ ((target ("avx2")))
+
+
+#define LOAD_8(p) \
+  _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (p)))
+
+
+/*  8 signals at a time, the tails are left to the generic code  */
+
+static AVX2_FUNC void
+gaussian_blur_accumulate_avx2 (gint         *acc,
+                               const guchar *src,
+                               gint          weight,
+                               gint          n)
+{
+  const __m256i w = _mm256_set1_epi32 (weight);
+  gint          i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    {
+      __m256i a = _mm256_loadu_si256 ((const __m256i *) (acc + i));
+
+      a = _mm256_add_epi32 (a, _mm256_mullo_epi32 (LOAD_8 (src + i), w));
+
+      _mm256_storeu_si256 ((__m256i *) (acc + i), a);
+    }
+
+  if (i < n)
+    gaussian_blur_generic_funcs.accumulate (acc + i, src + i, weight, n - i);
+}
+
+static AVX2_FUNC void
+gaussian_blur_box_step_avx2 (gint         *sum,
+                             const guchar *add,
+                             const guchar *sub,
+                             guchar       *dest,
+                             gfloat        scale,
+                             gint          n)
+{
+  const __m256 s    = _mm256_set1_ps (scale);
+  const __m256 half = _mm256_set1_ps (0.5f);
+  gint         i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    {
+      __m256i sums = _mm256_loadu_si256 ((const __m256i *) (sum + i));
+      __m256i d;
+
+      d = _mm256_cvttps_epi32 (_mm256_add_ps (_mm256_mul_ps (_mm256_cvtepi32_ps (sums),
+                                                             s),
+                                              half));
+
+      /*  the results are 0 to 255, pack them to the low 8 bytes  */
+      d = _mm256_packus_epi32 (d, d);
+      d = _mm256_permute4x64_epi64 (d, _MM_SHUFFLE (3, 1, 2, 0));
+      d = _mm256_packus_epi16 (d, d);
+
+      _mm_storel_epi64 ((__m128i *) (dest + i), _mm256_castsi256_si128 (d));
+
+      sums = _mm256_add_epi32 (sums, _mm256_sub_epi32 (LOAD_8 (add + i),
+                                                       LOAD_8 (sub + i)));
+
+      _mm256_storeu_si256 ((__m256i *) (sum + i), sums);
+    }
+
+  if (i < n)
+    gaussian_blur_generic_funcs.box_step (sum + i, add + i, sub + i, dest + i,
+                                          scale, n - i);
+}
+
+
+void
+gaussian_blur_avx2_install (GaussianBlurFuncs *funcs)
+{
+  funcs->accumulate = gaussian_blur_accumulate_avx2;
+  funcs->box_step   = gaussian_blur_box_step_avx2;
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
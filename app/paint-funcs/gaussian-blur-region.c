@@ -0,0 +1,416 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  The separable gaussian blur of feathering.  Each pass cuts the
+ *  region into strips of TILE_WIDTH columns or TILE_HEIGHT rows, which
+ *  the pixel processor blurs in parallel.  A strip is blurred as a
+ *  plane of signals side by side, so the line kernels below work on
+ *  contiguous memory in both directions; the accelerated versions in
+ *  gaussian-blur-region-avx2.c have to match them bit for bit,
+ *  app/tests/test-gaussian-blur-region.c checks that.
+ *
+ *  Up to GAUSSIAN_BLUR_MAX_EXACT_LENGTH the integer kernel of
+ *  make_curve() is applied, with the same results the run-length
+ *  encoding implementation had.  Longer kernels are approximated by
+ *  three box blurs of the same variance.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "paint-funcs-types.h"
+
+#include "base/accel-funcs.h"
+#include "base/pixel-processor.h"
+#include "base/pixel-region.h"
+#include "base/tile.h"
+
+#include "gaussian-blur-region.h"
+
+
+#define LOG_1_255  -5.541263545    /*  log (1.0 / 255.0)  */
+
+#define N_BOXES    3
+
+
+typedef struct
+{
+  PixelRegion *region;
+  gboolean     vertical;
+  gint         length;        /*  of the signals  */
+
+  /*  the kernel, weights for the offsets -kernel_length to
+   *  kernel_length - 1, or NULL for the box blurs
+   */
+  const gint  *curve;
+  gint         kernel_length;
+  gint         total;
+
+  gint         box_radius[N_BOXES];
+} BlurPass;
+
+
+static void  gaussian_blur_pass        (PixelRegion  *srcR,
+                                        gdouble       radius,
+                                        gboolean      vertical);
+static void  gaussian_blur_strip       (BlurPass     *pass,
+                                        gint          strip);
+static void  gaussian_blur_lines       (const BlurPass *pass,
+                                        const guchar *src,
+                                        guchar       *dest,
+                                        gint          n);
+static void  gaussian_blur_box_lines   (const guchar *src,
+                                        guchar       *dest,
+                                        gint         *sum,
+                                        gint          length,
+                                        gint          n,
+                                        gint          radius);
+
+static void  gaussian_blur_accumulate  (gint         *acc,
+                                        const guchar *src,
+                                        gint          weight,
+                                        gint          n);
+static void  gaussian_blur_box_step    (gint         *sum,
+                                        const guchar *add,
+                                        const guchar *sub,
+                                        guchar       *dest,
+                                        gfloat        scale,
+                                        gint          n);
+
+
+const GaussianBlurFuncs gaussian_blur_generic_funcs =
+{
+  gaussian_blur_accumulate,
+  gaussian_blur_box_step
+};
+
+GaussianBlurFuncs gaussian_blur_funcs;
+
+
+/*  public functions  */
+
+void
+gaussian_blur_init (guint accel)
+{
+  accel_funcs_init (&gaussian_blur_funcs, &gaussian_blur_generic_funcs,
+                    sizeof (GaussianBlurFuncs), accel,
+                    NULL,
+                    ACCEL_AVX2 (gaussian_blur_avx2_install));
+}
+
+void
+gaussian_blur_region (PixelRegion *srcR,
+                      gdouble      radius_x,
+                      gdouble      radius_y)
+{
+  if (srcR->w == 0 || srcR->h == 0)
+    return;
+
+  if (radius_y != 0.0)
+    gaussian_blur_pass (srcR, radius_y, TRUE);
+
+  if (radius_x != 0.0)
+    gaussian_blur_pass (srcR, radius_x, FALSE);
+}
+
+
+/*  private functions  */
+
+/*
+ * The equations: g(r) = exp (- r^2 / (2 * sigma^2))
+ *                   r = sqrt (x^2 + y^2)
+ */
+
+static gint *
+make_curve (gdouble  sigma_square,
+            gint    *length)
+{
+  const gdouble sigma2 = 2 * sigma_square;
+  const gdouble l      = sqrt (-sigma2 * LOG_1_255);
+
+  gint *curve;
+  gint  i, n;
+
+  n = ceil (l) * 2;
+  if ((n % 2) == 0)
+    n += 1;
+
+  curve = g_new (gint, n);
+
+  *length = n / 2;
+  curve += *length;
+  curve[0] = 255;
+
+  for (i = 1; i <= *length; i++)
+    {
+      gint temp = (gint) (exp (- SQR (i) / sigma2) * 255);
+
+      curve[-i] = temp;
+      curve[i] = temp;
+    }
+
+  return curve;
+}
+
+/*  the radii of N_BOXES box blurs with a variance of @sigma_square  */
+static void
+make_boxes (gdouble  sigma_square,
+            gint    *radius)
+{
+  const gdouble w_ideal = sqrt (12.0 * sigma_square / N_BOXES + 1.0);
+  gint          wl      = floor (w_ideal);
+  gint          m;
+  gint          i;
+
+  if (wl % 2 == 0)
+    wl--;
+
+  m = ROUND ((12.0 * sigma_square - N_BOXES * wl * wl -
+              4 * N_BOXES * wl - 3 * N_BOXES) / (-4.0 * wl - 4.0));
+
+  for (i = 0; i < N_BOXES; i++)
+    radius[i] = ((i < m) ? wl - 1 : wl + 1) / 2;
+}
+
+static void
+gaussian_blur_pass (PixelRegion *srcR,
+                    gdouble      radius,
+                    gboolean     vertical)
+{
+  const gdouble  sigma_square = - SQR (radius) / (2 * LOG_1_255);
+  BlurPass       pass         = { 0, };
+  gint          *curve;
+  gint           i;
+
+  pass.region   = srcR;
+  pass.vertical = vertical;
+  pass.length   = vertical ? srcR->h : srcR->w;
+
+  curve = make_curve (sigma_square, &pass.kernel_length);
+
+  if (pass.kernel_length <= GAUSSIAN_BLUR_MAX_EXACT_LENGTH)
+    {
+      pass.curve = curve;
+
+      for (i = -pass.kernel_length; i < pass.kernel_length; i++)
+        pass.total += curve[i];
+    }
+  else
+    {
+      make_boxes (sigma_square, pass.box_radius);
+    }
+
+  pixel_processor_process_items ((PixelProcessorItemFunc) gaussian_blur_strip,
+                                 &pass,
+                                 (vertical ?
+                                  (srcR->w + TILE_WIDTH - 1) / TILE_WIDTH :
+                                  (srcR->h + TILE_HEIGHT - 1) / TILE_HEIGHT));
+
+  g_free (curve - pass.kernel_length);
+}
+
+static void
+gaussian_blur_strip (BlurPass *pass,
+                     gint      strip)
+{
+  PixelRegion  *region = pass->region;
+  const gint    bytes  = region->bytes;
+  const gint    alpha  = bytes - 1;
+  const gint    length = pass->length;
+  gint          x0, y0;
+  gint          n;
+  gint          width;
+  gint          height;
+  guchar       *rows;
+  guchar       *src;
+  guchar       *dest;
+  gint          y;
+
+  if (pass->vertical)
+    {
+      x0     = region->x + strip * TILE_WIDTH;
+      y0     = region->y;
+      n      = MIN (TILE_WIDTH, region->x + region->w - x0);
+      width  = n;
+      height = region->h;
+    }
+  else
+    {
+      x0     = region->x;
+      y0     = region->y + strip * TILE_HEIGHT;
+      n      = MIN (TILE_HEIGHT, region->y + region->h - y0);
+      width  = region->w;
+      height = n;
+    }
+
+  rows = g_new (guchar, width * height * bytes);
+  src  = g_new (guchar, length * n);
+  dest = g_new (guchar, length * n);
+
+  pixel_processor_lock_tiles ();
+
+  for (y = 0; y < height; y++)
+    pixel_region_get_row (region, x0, y0 + y, width,
+                          rows + y * width * bytes, 1);
+
+  pixel_processor_unlock_tiles ();
+
+  /*  the signals side by side, src[position * n + signal]  */
+  for (y = 0; y < height; y++)
+    {
+      const guchar *r = rows + y * width * bytes + alpha;
+      gint          i;
+
+      if (pass->vertical)
+        for (i = 0; i < width; i++)
+          src[y * n + i] = r[i * bytes];
+      else
+        for (i = 0; i < width; i++)
+          src[i * n + y] = r[i * bytes];
+    }
+
+  gaussian_blur_lines (pass, src, dest, n);
+
+  for (y = 0; y < height; y++)
+    {
+      guchar *r = rows + y * width * bytes + alpha;
+      gint    i;
+
+      if (pass->vertical)
+        for (i = 0; i < width; i++)
+          r[i * bytes] = dest[y * n + i];
+      else
+        for (i = 0; i < width; i++)
+          r[i * bytes] = dest[i * n + y];
+    }
+
+  pixel_processor_lock_tiles ();
+
+  for (y = 0; y < height; y++)
+    pixel_region_set_row (region, x0, y0 + y, width,
+                          rows + y * width * bytes);
+
+  pixel_processor_unlock_tiles ();
+
+  g_free (rows);
+  g_free (src);
+  g_free (dest);
+}
+
+static void
+gaussian_blur_lines (const BlurPass *pass,
+                     const guchar   *src,
+                     guchar         *dest,
+                     gint            n)
+{
+  const gint  length = pass->length;
+  gint       *acc    = g_new (gint, n);
+  gint        pos;
+  gint        i;
+
+  if (pass->curve)
+    {
+      const gint  kernel_length = pass->kernel_length;
+      const gint  total         = pass->total;
+
+      for (pos = 0; pos < length; pos++)
+        {
+          gint k;
+
+          for (i = 0; i < n; i++)
+            acc[i] = total / 2;
+
+          for (k = -kernel_length; k < kernel_length; k++)
+            gaussian_blur_funcs.accumulate (acc,
+                                            src + CLAMP (pos + k, 0, length - 1) * n,
+                                            pass->curve[k], n);
+
+          for (i = 0; i < n; i++)
+            dest[pos * n + i] = acc[i] / total;
+        }
+    }
+  else
+    {
+      guchar *tmp = g_new (guchar, length * n);
+
+      gaussian_blur_box_lines (src,  dest, acc, length, n, pass->box_radius[0]);
+      gaussian_blur_box_lines (dest, tmp,  acc, length, n, pass->box_radius[1]);
+      gaussian_blur_box_lines (tmp,  dest, acc, length, n, pass->box_radius[2]);
+
+      g_free (tmp);
+    }
+
+  g_free (acc);
+}
+
+static void
+gaussian_blur_box_lines (const guchar *src,
+                         guchar       *dest,
+                         gint         *sum,
+                         gint          length,
+                         gint          n,
+                         gint          radius)
+{
+  const gfloat scale = 1.0 / (2 * radius + 1);
+  gint         pos;
+  gint         i;
+
+  for (i = 0; i < n; i++)
+    sum[i] = 0;
+
+  for (pos = -radius; pos <= radius; pos++)
+    gaussian_blur_funcs.accumulate (sum, src + CLAMP (pos, 0, length - 1) * n,
+                                    1, n);
+
+  for (pos = 0; pos < length; pos++)
+    gaussian_blur_funcs.box_step (sum,
+                                  src + CLAMP (pos + radius + 1, 0, length - 1) * n,
+                                  src + CLAMP (pos - radius, 0, length - 1) * n,
+                                  dest + pos * n,
+                                  scale, n);
+}
+
+static void
+gaussian_blur_accumulate (gint         *acc,
+                          const guchar *src,
+                          gint          weight,
+                          gint          n)
+{
+  while (n--)
+    *acc++ += weight * *src++;
+}
+
+static void
+gaussian_blur_box_step (gint         *sum,
+                        const guchar *add,
+                        const guchar *sub,
+                        guchar       *dest,
+                        gfloat        scale,
+                        gint          n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    {
+      dest[i] = (guchar) (sum[i] * scale + 0.5f);
+      sum[i] += add[i] - sub[i];
+    }
+}
@@ -0,0 +1,78 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GAUSSIAN_BLUR_REGION_H__
+#define __GAUSSIAN_BLUR_REGION_H__
+
+
+/*  Kernels longer than this on each side are approximated by three
+ *  box blurs, whose cost doesn't depend on the radius.
+ */
+#define GAUSSIAN_BLUR_MAX_EXACT_LENGTH  32
+
+
+/*  Blurs the alpha channel of @srcR in place, in parallel on the pixel
+ *  processor.  @srcR's tiles must be valid.
+ */
+void   gaussian_blur_region (PixelRegion *srcR,
+                             gdouble      radius_x,
+                             gdouble      radius_y);
+
+
+/*  The line kernels work on @n signals side by side, one per element
+ *  of the arrays.
+ */
+
+/*  acc[i] += weight * src[i]  */
+typedef void (* GaussianBlurAccumulateFunc) (gint         *acc,
+                                             const guchar *src,
+                                             gint          weight,
+                                             gint          n);
+
+/*  dest[i] = sum[i] * scale + 0.5, then sum[i] += add[i] - sub[i]  */
+typedef void (* GaussianBlurBoxStepFunc)    (gint         *sum,
+                                             const guchar *add,
+                                             const guchar *sub,
+                                             guchar       *dest,
+                                             gfloat        scale,
+                                             gint          n);
+
+
+typedef struct _GaussianBlurFuncs GaussianBlurFuncs;
+
+struct _GaussianBlurFuncs
+{
+  GaussianBlurAccumulateFunc  accumulate;
+  GaussianBlurBoxStepFunc     box_step;
+};
+
+
+/*  the implementations in use, see base/accel-funcs.h  */
+extern GaussianBlurFuncs gaussian_blur_funcs;
+
+
+void   gaussian_blur_init (guint accel);
+
+
+/*  for the gaussian blur implementations only  */
+
+extern const GaussianBlurFuncs gaussian_blur_generic_funcs;
+
+void   gaussian_blur_avx2_install (GaussianBlurFuncs *funcs);
+
+
+#endif  /*  __GAUSSIAN_BLUR_REGION_H__  */
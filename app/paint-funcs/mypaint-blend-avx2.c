@@ -0,0 +1,308 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "mypaint-blend.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#include <immintrin.h>
+
+
+#define AVX2_FUNC  __attribute__ ((target ("avx2")))
+
+
+/*  8 pixels at a time, like mypaint-blend-sse2.c does 4: the 8 or 24
+ *  channels of 1 and 3 bytes in memory order, two pixels of 4 bytes
+ *  per register.  No FMA, the products are rounded before the sums as
+ *  in the generic code.
+ */
+
+static inline AVX2_FUNC __m256
+clamp_avx2 (__m256 v)
+{
+  return _mm256_min_ps (_mm256_max_ps (v, _mm256_setzero_ps ()),
+                        _mm256_set1_ps (1.0f));
+}
+
+static inline AVX2_FUNC __m256i
+to_data_avx2 (__m256 v)
+{
+  v = _mm256_add_ps (_mm256_mul_ps (v, _mm256_set1_ps (255.0f)),
+                     _mm256_set1_ps (0.5f));
+  v = _mm256_min_ps (_mm256_max_ps (v, _mm256_setzero_ps ()),
+                     _mm256_set1_ps (255.0f));
+
+  return _mm256_cvttps_epi32 (v);
+}
+
+static inline AVX2_FUNC __m256i
+load_8_epi32_avx2 (const guchar *src)
+{
+  return _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) src));
+}
+
+static inline AVX2_FUNC __m256
+load_8_avx2 (const guchar *src)
+{
+  return _mm256_div_ps (_mm256_cvtepi32_ps (load_8_epi32_avx2 (src)),
+                        _mm256_set1_ps (255.0f));
+}
+
+static inline AVX2_FUNC void
+store_8_avx2 (guchar  *dest,
+              __m256i  d)
+{
+  /*  the results are 0 to 255, pack them to the low 8 bytes  */
+  d = _mm256_packus_epi32 (d, d);
+  d = _mm256_permute4x64_epi64 (d, _MM_SHUFFLE (3, 1, 2, 0));
+  d = _mm256_packus_epi16 (d, d);
+
+  _mm_storel_epi64 ((__m128i *) dest, _mm256_castsi256_si128 (d));
+}
+
+/*  the dab alpha of 8 pixels  */
+static inline AVX2_FUNC __m256
+brush_alpha_avx2 (const gfloat *mask,
+                  __m256        opacity)
+{
+  return clamp_avx2 (_mm256_mul_ps (_mm256_loadu_ps (mask), opacity));
+}
+
+/*  the dab alpha of the pixels 2 * @pair and 2 * @pair + 1, for 4 bytes  */
+static inline AVX2_FUNC __m256
+pair_alpha_avx2 (__m256 brush_a,
+                 gint   pair)
+{
+  return _mm256_permutevar8x32_ps (brush_a,
+                                   _mm256_setr_epi32 (2 * pair,     2 * pair,
+                                                      2 * pair,     2 * pair,
+                                                      2 * pair + 1, 2 * pair + 1,
+                                                      2 * pair + 1, 2 * pair + 1));
+}
+
+/*  a channel of BlendMode_Normal for 1 and 3 bytes  */
+static inline AVX2_FUNC __m256i
+normal_channels_avx2 (__m256 brush_a,
+                      __m256 mixed,
+                      __m256 src)
+{
+  const __m256 inv_brush_a = clamp_avx2 (_mm256_sub_ps (_mm256_set1_ps (1.0f),
+                                                        brush_a));
+
+  return to_data_avx2 (clamp_avx2 (_mm256_add_ps (_mm256_mul_ps (brush_a, mixed),
+                                                  _mm256_mul_ps (inv_brush_a,
+                                                                 src))));
+}
+
+static AVX2_FUNC void
+mypaint_blend_normal_1_avx2 (const gfloat             *mask,
+                             const guchar             *src,
+                             guchar                   *dest,
+                             gint                      n,
+                             const MypaintBlendParams *params)
+{
+  const __m256 opacity = _mm256_set1_ps (params->opacity);
+  const __m256 mixed   = _mm256_set1_ps (params->mixed[0]);
+  gint         i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    store_8_avx2 (dest + i,
+                  normal_channels_avx2 (brush_alpha_avx2 (mask + i, opacity),
+                                        mixed,
+                                        load_8_avx2 (src + i)));
+
+  if (i < n)
+    mypaint_blend_generic_funcs.normal[0] (mask + i, src + i, dest + i,
+                                           n - i, params);
+}
+
+static AVX2_FUNC void
+mypaint_blend_normal_3_avx2 (const gfloat             *mask,
+                             const guchar             *src,
+                             guchar                   *dest,
+                             gint                      n,
+                             const MypaintBlendParams *params)
+{
+  const gfloat  *m       = params->mixed;
+  const __m256   opacity = _mm256_set1_ps (params->opacity);
+  const __m256   mixed0  = _mm256_setr_ps (m[0], m[1], m[2], m[0],
+                                           m[1], m[2], m[0], m[1]);
+  const __m256   mixed1  = _mm256_setr_ps (m[2], m[0], m[1], m[2],
+                                           m[0], m[1], m[2], m[0]);
+  const __m256   mixed2  = _mm256_setr_ps (m[1], m[2], m[0], m[1],
+                                           m[2], m[0], m[1], m[2]);
+  const __m256i  pixel0  = _mm256_setr_epi32 (0, 0, 0, 1, 1, 1, 2, 2);
+  const __m256i  pixel1  = _mm256_setr_epi32 (2, 3, 3, 3, 4, 4, 4, 5);
+  const __m256i  pixel2  = _mm256_setr_epi32 (5, 5, 6, 6, 6, 7, 7, 7);
+  gint           i;
+
+  for (i = 0; i + 8 <= n; i += 8, src += 24, dest += 24)
+    {
+      const __m256 a = brush_alpha_avx2 (mask + i, opacity);
+
+      /*  the 24 channels of the 8 pixels, with the alpha of their pixel  */
+      store_8_avx2 (dest,
+                    normal_channels_avx2 (_mm256_permutevar8x32_ps (a, pixel0),
+                                          mixed0, load_8_avx2 (src)));
+      store_8_avx2 (dest + 8,
+                    normal_channels_avx2 (_mm256_permutevar8x32_ps (a, pixel1),
+                                          mixed1, load_8_avx2 (src + 8)));
+      store_8_avx2 (dest + 16,
+                    normal_channels_avx2 (_mm256_permutevar8x32_ps (a, pixel2),
+                                          mixed2, load_8_avx2 (src + 16)));
+    }
+
+  if (i < n)
+    mypaint_blend_generic_funcs.normal[2] (mask + i, src, dest,
+                                           n - i, params);
+}
+
+/*  two pixels of BlendMode_Normal for 4 bytes  */
+static inline AVX2_FUNC __m256i
+normal_pixels_avx2 (__m256  brush_a,
+                    __m256  src,
+                    __m256  color_a,
+                    __m256  color,
+                    __m256i color_data)
+{
+  const __m256 base_a      = _mm256_shuffle_ps (src, src, _MM_SHUFFLE (3, 3, 3, 3));
+  const __m256 inv_brush_a = _mm256_sub_ps (_mm256_set1_ps (1.0f), brush_a);
+  __m256       alpha;
+  __m256       transparent;
+  __m256i      d;
+
+  alpha = clamp_avx2 (_mm256_add_ps (_mm256_mul_ps (brush_a, color_a),
+                                     _mm256_mul_ps (inv_brush_a, base_a)));
+
+  d = to_data_avx2 (clamp_avx2 (_mm256_div_ps (_mm256_add_ps (_mm256_mul_ps (_mm256_mul_ps (clamp_avx2 (inv_brush_a),
+                                                                                            base_a),
+                                                                             src),
+                                                              _mm256_mul_ps (_mm256_mul_ps (brush_a,
+                                                                                            color_a),
+                                                                             color)),
+                                               alpha)));
+
+  /*  where the result is transparent, the color is the brush color  */
+  transparent = _mm256_cmp_ps (alpha, _mm256_setzero_ps (), _CMP_EQ_OQ);
+  d = _mm256_castps_si256 (_mm256_blendv_ps (_mm256_castsi256_ps (d),
+                                             _mm256_castsi256_ps (color_data),
+                                             transparent));
+
+  return _mm256_blend_epi32 (d, to_data_avx2 (alpha), 0x88);
+}
+
+static AVX2_FUNC void
+mypaint_blend_normal_4_avx2 (const gfloat             *mask,
+                             const guchar             *src,
+                             guchar                   *dest,
+                             gint                      n,
+                             const MypaintBlendParams *params)
+{
+  const gfloat  *c          = params->color;
+  const __m256   opacity    = _mm256_set1_ps (params->opacity);
+  const __m256   color_a    = _mm256_set1_ps (params->color_a);
+  const __m256   color      = _mm256_setr_ps (c[0], c[1], c[2], 0.0f,
+                                              c[0], c[1], c[2], 0.0f);
+  const __m256i  color_data = _mm256_cvttps_epi32 (color);
+  gint           i, j;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    {
+      const __m256 a = brush_alpha_avx2 (mask + i, opacity);
+
+      for (j = 0; j < 4; j++, src += 8, dest += 8)
+        store_8_avx2 (dest,
+                      normal_pixels_avx2 (pair_alpha_avx2 (a, j),
+                                          load_8_avx2 (src),
+                                          color_a, color, color_data));
+    }
+
+  if (i < n)
+    mypaint_blend_generic_funcs.normal[3] (mask + i, src, dest,
+                                           n - i, params);
+}
+
+/*  two pixels of BlendMode_LockAlpha, the alpha lanes are left over  */
+static inline AVX2_FUNC __m256i
+lock_alpha_pixels_avx2 (__m256 brush_a,
+                        __m256 src,
+                        __m256 color)
+{
+  const __m256 alpha       = _mm256_shuffle_ps (src, src, _MM_SHUFFLE (3, 3, 3, 3));
+  const __m256 inv_brush_a = clamp_avx2 (_mm256_sub_ps (_mm256_set1_ps (1.0f),
+                                                        brush_a));
+
+  return to_data_avx2 (clamp_avx2 (_mm256_div_ps (_mm256_add_ps (_mm256_mul_ps (_mm256_mul_ps (brush_a,
+                                                                                               alpha),
+                                                                                color),
+                                                                 _mm256_mul_ps (_mm256_mul_ps (inv_brush_a,
+                                                                                               alpha),
+                                                                                src)),
+                                                  alpha)));
+}
+
+static AVX2_FUNC void
+mypaint_blend_lock_alpha_avx2 (const gfloat             *mask,
+                               const guchar             *src,
+                               guchar                   *dest,
+                               gint                      n,
+                               const MypaintBlendParams *params)
+{
+  const gfloat *c       = params->color;
+  const __m256  opacity = _mm256_set1_ps (params->opacity);
+  const __m256  color   = _mm256_setr_ps (c[0], c[1], c[2], 0.0f,
+                                          c[0], c[1], c[2], 0.0f);
+  gint          i, j;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    {
+      const __m256 a = brush_alpha_avx2 (mask + i, opacity);
+
+      for (j = 0; j < 4; j++, src += 8, dest += 8)
+        {
+          __m256i d = lock_alpha_pixels_avx2 (pair_alpha_avx2 (a, j),
+                                              load_8_avx2 (src),
+                                              color);
+
+          /*  the alpha of dest stays  */
+          store_8_avx2 (dest,
+                        _mm256_blend_epi32 (d, load_8_epi32_avx2 (dest), 0x88));
+        }
+    }
+
+  if (i < n)
+    mypaint_blend_generic_funcs.lock_alpha (mask + i, src, dest,
+                                            n - i, params);
+}
+
+
+void
+mypaint_blend_avx2_install (MypaintBlendFuncs *funcs)
+{
+  funcs->normal[0]  = mypaint_blend_normal_1_avx2;
+  funcs->normal[2]  = mypaint_blend_normal_3_avx2;
+  funcs->normal[3]  = mypaint_blend_normal_4_avx2;
+  funcs->lock_alpha = mypaint_blend_lock_alpha_avx2;
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
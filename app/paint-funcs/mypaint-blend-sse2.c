@@ -0,0 +1,334 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "mypaint-blend.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+
+#include <emmintrin.h>
+
+
+#define SSE2_FUNC  __attribute__ ((target ("sse2")))
+
+
+/*  4 pixels at a time.  For 1 and 3 bytes every channel is blended on
+ *  its own, so the 4 or 12 channels go through the lanes as they lie
+ *  in memory.  For 4 bytes a pixel fills a register, with the alpha
+ *  of the source and the dab copied to all of its lanes.  The lanes do
+ *  the single precision operations of the generic code in the same
+ *  order, max (NaN, 0) gives 0 like the conversion of NaN to a byte
+ *  does, and the rest of a run is left to the generic code.
+ */
+
+static inline SSE2_FUNC __m128
+clamp_sse2 (__m128 v)
+{
+  return _mm_min_ps (_mm_max_ps (v, _mm_setzero_ps ()), _mm_set1_ps (1.0f));
+}
+
+static inline SSE2_FUNC __m128i
+to_data_sse2 (__m128 v)
+{
+  v = _mm_add_ps (_mm_mul_ps (v, _mm_set1_ps (255.0f)), _mm_set1_ps (0.5f));
+  v = _mm_min_ps (_mm_max_ps (v, _mm_setzero_ps ()), _mm_set1_ps (255.0f));
+
+  return _mm_cvttps_epi32 (v);
+}
+
+static inline SSE2_FUNC __m128
+from_epi32_sse2 (__m128i v)
+{
+  return _mm_div_ps (_mm_cvtepi32_ps (v), _mm_set1_ps (255.0f));
+}
+
+static inline SSE2_FUNC __m128
+load_4_sse2 (const guchar *src)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  gint32        v;
+
+  memcpy (&v, src, 4);
+
+  return from_epi32_sse2 (_mm_unpacklo_epi16 (_mm_unpacklo_epi8 (_mm_cvtsi32_si128 (v),
+                                                                 zero),
+                                              zero));
+}
+
+/*  the dab alpha of 4 pixels  */
+static inline SSE2_FUNC __m128
+brush_alpha_sse2 (const gfloat *mask,
+                  __m128        opacity)
+{
+  return clamp_sse2 (_mm_mul_ps (_mm_loadu_ps (mask), opacity));
+}
+
+/*  a channel of BlendMode_Normal for 1 and 3 bytes  */
+static inline SSE2_FUNC __m128i
+normal_channels_sse2 (__m128 brush_a,
+                      __m128 mixed,
+                      __m128 src)
+{
+  const __m128 inv_brush_a = clamp_sse2 (_mm_sub_ps (_mm_set1_ps (1.0f),
+                                                     brush_a));
+
+  return to_data_sse2 (clamp_sse2 (_mm_add_ps (_mm_mul_ps (brush_a, mixed),
+                                               _mm_mul_ps (inv_brush_a, src))));
+}
+
+static SSE2_FUNC void
+mypaint_blend_normal_1_sse2 (const gfloat             *mask,
+                             const guchar             *src,
+                             guchar                   *dest,
+                             gint                      n,
+                             const MypaintBlendParams *params)
+{
+  const __m128 opacity = _mm_set1_ps (params->opacity);
+  const __m128 mixed   = _mm_set1_ps (params->mixed[0]);
+  gint         i;
+
+  for (i = 0; i + 4 <= n; i += 4)
+    {
+      __m128i d = normal_channels_sse2 (brush_alpha_sse2 (mask + i, opacity),
+                                        mixed,
+                                        load_4_sse2 (src + i));
+      gint32  v;
+
+      d = _mm_packs_epi32 (d, d);
+      v = _mm_cvtsi128_si32 (_mm_packus_epi16 (d, d));
+
+      memcpy (dest + i, &v, 4);
+    }
+
+  if (i < n)
+    mypaint_blend_generic_funcs.normal[0] (mask + i, src + i, dest + i,
+                                           n - i, params);
+}
+
+static SSE2_FUNC void
+mypaint_blend_normal_3_sse2 (const gfloat             *mask,
+                             const guchar             *src,
+                             guchar                   *dest,
+                             gint                      n,
+                             const MypaintBlendParams *params)
+{
+  const gfloat *m       = params->mixed;
+  const __m128  opacity = _mm_set1_ps (params->opacity);
+  const __m128  mixed0  = _mm_setr_ps (m[0], m[1], m[2], m[0]);
+  const __m128  mixed1  = _mm_setr_ps (m[1], m[2], m[0], m[1]);
+  const __m128  mixed2  = _mm_setr_ps (m[2], m[0], m[1], m[2]);
+  gint          i;
+
+  for (i = 0; i + 4 <= n; i += 4, src += 12, dest += 12)
+    {
+      const __m128 a = brush_alpha_sse2 (mask + i, opacity);
+      __m128i      d0, d1, d2;
+      gint32       v;
+
+      /*  the 12 channels of the 4 pixels, with the alpha of their pixel  */
+      d0 = normal_channels_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (1, 0, 0, 0)),
+                                 mixed0, load_4_sse2 (src));
+      d1 = normal_channels_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (2, 2, 1, 1)),
+                                 mixed1, load_4_sse2 (src + 4));
+      d2 = normal_channels_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (3, 3, 3, 2)),
+                                 mixed2, load_4_sse2 (src + 8));
+
+      d0 = _mm_packus_epi16 (_mm_packs_epi32 (d0, d1),
+                             _mm_packs_epi32 (d2, d2));
+
+      _mm_storel_epi64 ((__m128i *) dest, d0);
+      v = _mm_cvtsi128_si32 (_mm_srli_si128 (d0, 8));
+      memcpy (dest + 8, &v, 4);
+    }
+
+  if (i < n)
+    mypaint_blend_generic_funcs.normal[2] (mask + i, src, dest,
+                                           n - i, params);
+}
+
+/*  one pixel of BlendMode_Normal for 4 bytes  */
+static inline SSE2_FUNC __m128i
+normal_pixel_sse2 (__m128  brush_a,
+                   __m128  src,
+                   __m128  color_a,
+                   __m128  color,
+                   __m128i color_data,
+                   __m128i alpha_mask)
+{
+  const __m128 one         = _mm_set1_ps (1.0f);
+  const __m128 base_a      = _mm_shuffle_ps (src, src, _MM_SHUFFLE (3, 3, 3, 3));
+  const __m128 inv_brush_a = _mm_sub_ps (one, brush_a);
+  __m128       alpha;
+  __m128i      transparent;
+  __m128i      d;
+
+  alpha = clamp_sse2 (_mm_add_ps (_mm_mul_ps (brush_a, color_a),
+                                  _mm_mul_ps (inv_brush_a, base_a)));
+
+  d = to_data_sse2 (clamp_sse2 (_mm_div_ps (_mm_add_ps (_mm_mul_ps (_mm_mul_ps (clamp_sse2 (inv_brush_a),
+                                                                                base_a),
+                                                                    src),
+                                                        _mm_mul_ps (_mm_mul_ps (brush_a,
+                                                                                color_a),
+                                                                    color)),
+                                            alpha)));
+
+  /*  where the result is transparent, the color is the brush color  */
+  transparent = _mm_castps_si128 (_mm_cmpeq_ps (alpha, _mm_setzero_ps ()));
+  d = _mm_or_si128 (_mm_and_si128 (transparent, color_data),
+                    _mm_andnot_si128 (transparent, d));
+
+  return _mm_or_si128 (_mm_andnot_si128 (alpha_mask, d),
+                       _mm_and_si128 (alpha_mask, to_data_sse2 (alpha)));
+}
+
+static SSE2_FUNC void
+mypaint_blend_normal_4_sse2 (const gfloat             *mask,
+                             const guchar             *src,
+                             guchar                   *dest,
+                             gint                      n,
+                             const MypaintBlendParams *params)
+{
+  const gfloat  *c          = params->color;
+  const __m128i  zero       = _mm_setzero_si128 ();
+  const __m128   opacity    = _mm_set1_ps (params->opacity);
+  const __m128   color_a    = _mm_set1_ps (params->color_a);
+  const __m128   color      = _mm_setr_ps (c[0], c[1], c[2], 0.0f);
+  const __m128i  color_data = _mm_cvttps_epi32 (color);
+  const __m128i  alpha_mask = _mm_setr_epi32 (0, 0, 0, -1);
+  gint           i;
+
+  for (i = 0; i + 4 <= n; i += 4, src += 16, dest += 16)
+    {
+      const __m128  a  = brush_alpha_sse2 (mask + i, opacity);
+      const __m128i s  = _mm_loadu_si128 ((const __m128i *) src);
+      const __m128i lo = _mm_unpacklo_epi8 (s, zero);
+      const __m128i hi = _mm_unpackhi_epi8 (s, zero);
+      __m128i       d0, d1, d2, d3;
+
+      d0 = normal_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (0, 0, 0, 0)),
+                              from_epi32_sse2 (_mm_unpacklo_epi16 (lo, zero)),
+                              color_a, color, color_data, alpha_mask);
+      d1 = normal_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (1, 1, 1, 1)),
+                              from_epi32_sse2 (_mm_unpackhi_epi16 (lo, zero)),
+                              color_a, color, color_data, alpha_mask);
+      d2 = normal_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (2, 2, 2, 2)),
+                              from_epi32_sse2 (_mm_unpacklo_epi16 (hi, zero)),
+                              color_a, color, color_data, alpha_mask);
+      d3 = normal_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (3, 3, 3, 3)),
+                              from_epi32_sse2 (_mm_unpackhi_epi16 (hi, zero)),
+                              color_a, color, color_data, alpha_mask);
+
+      _mm_storeu_si128 ((__m128i *) dest,
+                        _mm_packus_epi16 (_mm_packs_epi32 (d0, d1),
+                                          _mm_packs_epi32 (d2, d3)));
+    }
+
+  if (i < n)
+    mypaint_blend_generic_funcs.normal[3] (mask + i, src, dest,
+                                           n - i, params);
+}
+
+/*  one pixel of BlendMode_LockAlpha, the alpha lane is left over  */
+static inline SSE2_FUNC __m128i
+lock_alpha_pixel_sse2 (__m128 brush_a,
+                       __m128 src,
+                       __m128 color)
+{
+  const __m128 alpha       = _mm_shuffle_ps (src, src, _MM_SHUFFLE (3, 3, 3, 3));
+  const __m128 inv_brush_a = clamp_sse2 (_mm_sub_ps (_mm_set1_ps (1.0f),
+                                                     brush_a));
+
+  return to_data_sse2 (clamp_sse2 (_mm_div_ps (_mm_add_ps (_mm_mul_ps (_mm_mul_ps (brush_a,
+                                                                                   alpha),
+                                                                       color),
+                                                           _mm_mul_ps (_mm_mul_ps (inv_brush_a,
+                                                                                   alpha),
+                                                                       src)),
+                                               alpha)));
+}
+
+static SSE2_FUNC void
+mypaint_blend_lock_alpha_sse2 (const gfloat             *mask,
+                               const guchar             *src,
+                               guchar                   *dest,
+                               gint                      n,
+                               const MypaintBlendParams *params)
+{
+  const gfloat  *c          = params->color;
+  const __m128i  zero       = _mm_setzero_si128 ();
+  const __m128   opacity    = _mm_set1_ps (params->opacity);
+  const __m128   color      = _mm_setr_ps (c[0], c[1], c[2], 0.0f);
+  const __m128i  alpha_mask = _mm_set1_epi32 ((gint32) 0xff000000);
+  gint           i;
+
+  for (i = 0; i + 4 <= n; i += 4, src += 16, dest += 16)
+    {
+      const __m128  a  = brush_alpha_sse2 (mask + i, opacity);
+      const __m128i s  = _mm_loadu_si128 ((const __m128i *) src);
+      const __m128i lo = _mm_unpacklo_epi8 (s, zero);
+      const __m128i hi = _mm_unpackhi_epi8 (s, zero);
+      __m128i       d0, d1, d2, d3;
+      __m128i       d;
+
+      d0 = lock_alpha_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (0, 0, 0, 0)),
+                                  from_epi32_sse2 (_mm_unpacklo_epi16 (lo, zero)),
+                                  color);
+      d1 = lock_alpha_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (1, 1, 1, 1)),
+                                  from_epi32_sse2 (_mm_unpackhi_epi16 (lo, zero)),
+                                  color);
+      d2 = lock_alpha_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (2, 2, 2, 2)),
+                                  from_epi32_sse2 (_mm_unpacklo_epi16 (hi, zero)),
+                                  color);
+      d3 = lock_alpha_pixel_sse2 (_mm_shuffle_ps (a, a, _MM_SHUFFLE (3, 3, 3, 3)),
+                                  from_epi32_sse2 (_mm_unpackhi_epi16 (hi, zero)),
+                                  color);
+
+      d = _mm_packus_epi16 (_mm_packs_epi32 (d0, d1),
+                            _mm_packs_epi32 (d2, d3));
+
+      /*  the alpha of dest stays  */
+      d = _mm_or_si128 (_mm_andnot_si128 (alpha_mask, d),
+                        _mm_and_si128 (alpha_mask,
+                                       _mm_loadu_si128 ((const __m128i *) dest)));
+
+      _mm_storeu_si128 ((__m128i *) dest, d);
+    }
+
+  if (i < n)
+    mypaint_blend_generic_funcs.lock_alpha (mask + i, src, dest,
+                                            n - i, params);
+}
+
+
+void
+mypaint_blend_sse2_install (MypaintBlendFuncs *funcs)
+{
+  funcs->normal[0]  = mypaint_blend_normal_1_sse2;
+  funcs->normal[2]  = mypaint_blend_normal_3_sse2;
+  funcs->normal[3]  = mypaint_blend_normal_4_sse2;
+  funcs->lock_alpha = mypaint_blend_lock_alpha_sse2;
+}
+
+#endif /* HAVE_SSE2_INTRINSICS */
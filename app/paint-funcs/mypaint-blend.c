@@ -0,0 +1,216 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  The blend modes of the MyPaint brush, one run of the dab mask at a
+ *  time.  The generic versions do the single precision arithmetic of
+ *  the REAL_CALC templates in mypaint-brushmodes.hpp in the same order,
+ *  so they give the same bytes; the accelerated versions in
+ *  mypaint-blend-sse2.c and mypaint-blend-avx2.c do that on 4 and 8
+ *  pixels at once.  app/tests/test-mypaint-blend.cpp checks all of
+ *  them against the templates.
+ *
+ *  Normal is Normal_and_Eraser with a color_a of 1.0: multiplying by
+ *  1.0 and adding 0.0 leave the values alone, so one function serves
+ *  both.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-funcs-types.h"
+
+#include "base/accel-funcs.h"
+
+#include "mypaint-blend.h"
+
+
+MypaintBlendFuncs mypaint_blend_funcs;
+
+
+/*  eval() and r2d() of base/pixel.hpp  */
+
+static inline gfloat
+clamp_real (gfloat value)
+{
+  return (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f : value;
+}
+
+static inline guchar
+real_to_data (gfloat value)
+{
+  value = 255.0f * value + 0.5f;
+
+  return (guchar) ((value < 0.0f) ? 0.0f : (value > 255.0f) ? 255.0f : value);
+}
+
+
+static inline void
+mypaint_blend_normal (const gfloat             *mask,
+                      const guchar             *src,
+                      guchar                   *dest,
+                      gint                      n,
+                      const MypaintBlendParams *params,
+                      const gint                bytes)
+{
+  const gfloat opacity = params->opacity;
+  gint         i, c;
+
+  for (i = 0; i < n; i++, src += bytes, dest += bytes)
+    {
+      const gfloat brush_a     = clamp_real (mask[i] * opacity);
+      const gfloat inv_brush_a = clamp_real (1.0f - brush_a);
+
+      for (c = 0; c < bytes; c++)
+        dest[c] = real_to_data (clamp_real (brush_a * params->mixed[c] +
+                                            inv_brush_a *
+                                            ((gfloat) src[c] / 255.0f)));
+    }
+}
+
+static void
+mypaint_blend_normal_1 (const gfloat             *mask,
+                        const guchar             *src,
+                        guchar                   *dest,
+                        gint                      n,
+                        const MypaintBlendParams *params)
+{
+  mypaint_blend_normal (mask, src, dest, n, params, 1);
+}
+
+static void
+mypaint_blend_normal_3 (const gfloat             *mask,
+                        const guchar             *src,
+                        guchar                   *dest,
+                        gint                      n,
+                        const MypaintBlendParams *params)
+{
+  mypaint_blend_normal (mask, src, dest, n, params, 3);
+}
+
+static void
+mypaint_blend_normal_4 (const gfloat             *mask,
+                        const guchar             *src,
+                        guchar                   *dest,
+                        gint                      n,
+                        const MypaintBlendParams *params)
+{
+  const gfloat opacity = params->opacity;
+  const gfloat color_a = params->color_a;
+  gint         i, c;
+
+  for (i = 0; i < n; i++, src += 4, dest += 4)
+    {
+      const gfloat brush_a = clamp_real (mask[i] * opacity);
+      const gfloat base_a  = (gfloat) src[3] / 255.0f;
+      const gfloat alpha   = clamp_real (brush_a * color_a +
+                                         (1.0f - brush_a) * base_a);
+
+      dest[3] = real_to_data (alpha);
+
+      if (alpha)
+        {
+          const gfloat inv_brush_a = clamp_real (1.0f - brush_a);
+
+          for (c = 0; c < 3; c++)
+            dest[c] = real_to_data (clamp_real ((inv_brush_a * base_a *
+                                                 ((gfloat) src[c] / 255.0f) +
+                                                 brush_a * color_a *
+                                                 params->color[c]) /
+                                                alpha));
+        }
+      else
+        {
+          for (c = 0; c < 3; c++)
+            dest[c] = params->color[c];
+        }
+    }
+}
+
+static void
+mypaint_blend_lock_alpha (const gfloat             *mask,
+                          const guchar             *src,
+                          guchar                   *dest,
+                          gint                      n,
+                          const MypaintBlendParams *params)
+{
+  const gfloat opacity = params->opacity;
+  gint         i, c;
+
+  for (i = 0; i < n; i++, src += 4, dest += 4)
+    {
+      const gfloat brush_a     = clamp_real (mask[i] * opacity);
+      const gfloat inv_brush_a = clamp_real (1.0f - brush_a);
+      const gfloat alpha       = (gfloat) src[3] / 255.0f;
+
+      /*  a transparent pixel gives 0 / 0, which comes out as 0  */
+      for (c = 0; c < 3; c++)
+        dest[c] = real_to_data (clamp_real ((brush_a * alpha *
+                                             params->color[c] +
+                                             inv_brush_a * alpha *
+                                             ((gfloat) src[c] / 255.0f)) /
+                                            alpha));
+    }
+}
+
+
+const MypaintBlendFuncs mypaint_blend_generic_funcs =
+{
+  {
+    mypaint_blend_normal_1,
+    NULL,
+    mypaint_blend_normal_3,
+    mypaint_blend_normal_4
+  },
+  mypaint_blend_lock_alpha
+};
+
+
+void
+mypaint_blend_init (guint accel)
+{
+  accel_funcs_init (&mypaint_blend_funcs, &mypaint_blend_generic_funcs,
+                    sizeof (MypaintBlendFuncs), accel,
+                    ACCEL_SSE2 (mypaint_blend_sse2_install),
+                    ACCEL_AVX2 (mypaint_blend_avx2_install));
+}
+
+void
+mypaint_blend_params_init (MypaintBlendParams *params,
+                           gfloat              opacity,
+                           gfloat              color_a,
+                           const gfloat       *color,
+                           const gfloat       *background)
+{
+  gint c;
+
+  params->opacity = opacity;
+  params->color_a = color_a;
+
+  for (c = 0; c < 3; c++)
+    {
+      params->color[c] = color[c];
+
+      if (background)
+        params->mixed[c] = ((1.0f - color_a) * background[c] +
+                            color_a * color[c]);
+      else
+        params->mixed[c] = color[c];
+    }
+}
@@ -0,0 +1,86 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MYPAINT_BLEND_H__
+#define __MYPAINT_BLEND_H__
+
+
+/*  The blend modes of mypaint-brushmodes.hpp for one run of the run
+ *  length encoded dab mask: @n pixels of @src are blended into @dest,
+ *  @mask holds the intensity of the dab at each of them.  The results
+ *  are those of the templates, which compute in single precision.
+ */
+
+typedef struct _MypaintBlendParams MypaintBlendParams;
+
+struct _MypaintBlendParams
+{
+  gfloat opacity;
+  gfloat color_a;
+
+  /*  the brush color, for 4 bytes  */
+  gfloat color[3];
+
+  /*  for 1 and 3 bytes:  (1 - color_a) * background + color_a * color  */
+  gfloat mixed[3];
+};
+
+
+typedef void (* MypaintBlendFunc) (const gfloat             *mask,
+                                   const guchar             *src,
+                                   guchar                   *dest,
+                                   gint                      n,
+                                   const MypaintBlendParams *params);
+
+
+typedef struct _MypaintBlendFuncs MypaintBlendFuncs;
+
+struct _MypaintBlendFuncs
+{
+  /*  BlendMode_Normal and BlendMode_Normal_and_Eraser, by bytes - 1,
+   *  for 1, 3 and 4 bytes
+   */
+  MypaintBlendFunc  normal[4];
+
+  /*  BlendMode_LockAlpha, for 4 bytes  */
+  MypaintBlendFunc  lock_alpha;
+};
+
+
+/*  the implementations in use, see base/accel-funcs.h  */
+extern MypaintBlendFuncs mypaint_blend_funcs;
+
+
+void   mypaint_blend_init        (guint               accel);
+
+/*  @background may be NULL for BlendMode_Normal, @color_a is 1.0 then  */
+void   mypaint_blend_params_init (MypaintBlendParams *params,
+                                  gfloat              opacity,
+                                  gfloat              color_a,
+                                  const gfloat       *color,
+                                  const gfloat       *background);
+
+
+/*  for the mypaint_blend implementations only  */
+
+extern const MypaintBlendFuncs mypaint_blend_generic_funcs;
+
+void   mypaint_blend_sse2_install (MypaintBlendFuncs *funcs);
+void   mypaint_blend_avx2_install (MypaintBlendFuncs *funcs);
+
+
+#endif  /*  __MYPAINT_BLEND_H__  */
@@ -13,6 +13,10 @@
 #define REAL_CALC
 #include "base/pixel.hpp"
 
+extern "C" {
+#include "paint-funcs/mypaint-blend.h"
+}
+
 struct BrushPixelIteratorForRunLength {
   Pixel::real*   mask;
   gint*          offsets;
@@ -220,19 +224,25 @@ struct BrushPixelIteratorForPlainData : ParentClass {
 // resultAlpha = topAlpha + (1.0 - topAlpha) * bottomAlpha
 // resultColor = topColor + (1.0 - topAlpha) * bottomColor
 //
-template<typename Iter>
-void draw_dab_pixels_BlendMode_Normal (Iter iter,
-                                       Pixel::real   opacity) 
+template<typename Iter, typename Traits = PixelTraitsReal>
+void draw_dab_pixels_BlendMode_Normal (Iter          iter,
+                                       Pixel::real   opacity,
+                                       Traits        = Traits())
 {
+  typedef typename Traits::value_t value_t;
+  const value_t one = Traits::one();
+  const value_t opa = Traits::pix(opacity);
+
   switch (iter.src_bytes) {
   case 1:
     while (1) {
       for (; !iter.is_row_end(); iter.next_pixel()) {
         if (iter.should_skipped())
           continue;
-        pixel_t opa_a = pix( eval( pix(iter.get_brush_alpha()) * pix(opacity) ) ); // topAlpha
-        pixel_t opa_b = pix( eval (pix(1.0f) - opa_a ) ); // bottomAlpha
-        iter.dest[0] = r2d(eval( opa_a*pix(iter.get_brush_color()[0]) + opa_b*pix(iter.src[0]) ));
+        value_t opa_a = Traits::clamp(Traits::mul(Traits::pix(iter.get_brush_alpha()), opa)); // topAlpha
+        value_t opa_b = Traits::clamp(one - opa_a); // bottomAlpha
+        iter.dest[0] = Traits::to_data(Traits::clamp(Traits::mul(opa_a, Traits::pix(iter.get_brush_color()[0])) +
+                                                     Traits::mul(opa_b, Traits::pix(iter.src[0]))));
       }
       if (iter.is_data_end()) break;
       iter.next_row();
@@ -243,15 +253,18 @@ void draw_dab_pixels_BlendMode_Normal (Iter iter,
       for (; !iter.is_row_end(); iter.next_pixel()) {
         if (iter.should_skipped())
           continue;
-        pixel_t opa_a = pix( eval( pix(iter.get_brush_alpha()) * pix(opacity) ) ); // topAlpha
-        pixel_t opa_b = pix( eval (pix(1.0f) - opa_a ) ); // bottomAlpha
-	result_t internal[3];
-	internal[0] = eval( opa_a*pix(iter.get_brush_color()[0]) + opa_b*pix(iter.src[0]) );
-	internal[1] = eval( opa_a*pix(iter.get_brush_color()[1]) + opa_b*pix(iter.src[1]) );
-	internal[2] = eval( opa_a*pix(iter.get_brush_color()[2]) + opa_b*pix(iter.src[2]) );
-        iter.dest[0] = r2d(internal[0]);
-        iter.dest[1] = r2d(internal[1]);
-        iter.dest[2] = r2d(internal[2]);
+        value_t opa_a = Traits::clamp(Traits::mul(Traits::pix(iter.get_brush_alpha()), opa)); // topAlpha
+        value_t opa_b = Traits::clamp(one - opa_a); // bottomAlpha
+        value_t internal[3];
+        internal[0] = Traits::clamp(Traits::mul(opa_a, Traits::pix(iter.get_brush_color()[0])) +
+                                    Traits::mul(opa_b, Traits::pix(iter.src[0])));
+        internal[1] = Traits::clamp(Traits::mul(opa_a, Traits::pix(iter.get_brush_color()[1])) +
+                                    Traits::mul(opa_b, Traits::pix(iter.src[1])));
+        internal[2] = Traits::clamp(Traits::mul(opa_a, Traits::pix(iter.get_brush_color()[2])) +
+                                    Traits::mul(opa_b, Traits::pix(iter.src[2])));
+        iter.dest[0] = Traits::to_data(internal[0]);
+        iter.dest[1] = Traits::to_data(internal[1]);
+        iter.dest[2] = Traits::to_data(internal[2]);
       }
       if (iter.is_data_end()) break;
       iter.next_row();
@@ -263,25 +276,20 @@ void draw_dab_pixels_BlendMode_Normal (Iter iter,
         if (iter.should_skipped())
           continue;
 
-        pixel_t brush_a = pix( eval( pix(iter.get_brush_alpha()) * pix(opacity) ) );
-        pixel_t base_a  = pix(iter.src[3]);
-	result_t alpha  = eval( brush_a + (pix(1.0f) - brush_a) * base_a );
-        iter.dest[3] = r2d(alpha);
+        value_t brush_a = Traits::clamp(Traits::mul(Traits::pix(iter.get_brush_alpha()), opa));
+        value_t base_a  = Traits::pix(iter.src[3]);
+        value_t alpha   = Traits::clamp(brush_a + Traits::mul(one - brush_a, base_a));
+        iter.dest[3] = Traits::to_data(alpha);
         if (alpha) {
-          pixel_t dest_a = pix(alpha);
-	  result_t internal[3];
-	  internal[0] = eval( (brush_a * pix(iter.get_brush_color()[0]) + 
-                              (pix(1.0f) - brush_a) * base_a * pix(iter.src[0])) 
-                              / dest_a );
-	  internal[1] = eval( (brush_a * pix(iter.get_brush_color()[1]) + 
-                              (pix(1.0f) - brush_a) * base_a * pix(iter.src[1])) 
-                              / dest_a );
-	  internal[2] = eval( (brush_a * pix(iter.get_brush_color()[2]) + 
-                              (pix(1.0f) - brush_a) * base_a * pix(iter.src[2])) 
-                              / dest_a );
-          iter.dest[0] = r2d(internal[0]);
-          iter.dest[1] = r2d(internal[1]);
-          iter.dest[2] = r2d(internal[2]);
+          value_t internal[3];
+          for (int c = 0; c < 3; c++)
+            internal[c] = Traits::clamp(Traits::div(Traits::mul(brush_a, Traits::pix(iter.get_brush_color()[c])) +
+                                                    Traits::mul(Traits::mul(one - brush_a, base_a),
+                                                                Traits::pix(iter.src[c])),
+                                                    alpha));
+          iter.dest[0] = Traits::to_data(internal[0]);
+          iter.dest[1] = Traits::to_data(internal[1]);
+          iter.dest[2] = Traits::to_data(internal[2]);
         } else {
           iter.dest[0] = iter.get_brush_color()[0];
           iter.dest[1] = iter.get_brush_color()[1];
@@ -304,18 +312,23 @@ void draw_dab_pixels_BlendMode_Normal (Iter iter,
 // and color_r/g/b will be ignored. This function can also do normal
 // blending (color_a=1.0).
 //
-template<typename Iter>
+template<typename Iter, typename Traits = PixelTraitsReal>
 void draw_dab_pixels_BlendMode_Normal_and_Eraser (Iter iter,
                                                   Pixel::real   color_a,
                                                   Pixel::real   opacity,
                                                   Pixel::real   background_r = 1.0f,
                                                   Pixel::real   background_g = 1.0f,
-                                                  Pixel::real   background_b = 1.0f) {
+                                                  Pixel::real   background_b = 1.0f,
+                                                  Traits        = Traits()) {
 //  g_print("BlendMode_Normal_and_Eraser(color_a=%d)\n", color_a);
-  Pixel::real bg_color[3];
-  bg_color[0] = background_r;
-  bg_color[1] = background_g;
-  bg_color[2] = background_b;
+  typedef typename Traits::value_t value_t;
+  const value_t one = Traits::one();
+  const value_t opa = Traits::pix(opacity);
+  const value_t ca  = Traits::pix(color_a);
+  value_t bg_color[3];
+  bg_color[0] = Traits::pix(background_r);
+  bg_color[1] = Traits::pix(background_g);
+  bg_color[2] = Traits::pix(background_b);
 
   switch (iter.src_bytes) {
   case 1:
@@ -325,12 +338,13 @@ void draw_dab_pixels_BlendMode_Normal_and_Eraser (Iter iter,
         if (iter.should_skipped())
           continue;
 
-        pixel_t brush_a     = pix( eval( pix(iter.get_brush_alpha()) * pix(opacity) ) ); // topAlpha
-        pixel_t inv_brush_a = pix( eval (f2p(1.0) - brush_a ) ); // bottomAlpha
+        value_t brush_a     = Traits::clamp(Traits::mul(Traits::pix(iter.get_brush_alpha()), opa)); // topAlpha
+        value_t inv_brush_a = Traits::clamp(one - brush_a); // bottomAlpha
 
-        iter.dest[0] = r2d(eval( brush_a*((pix(1.0f) - pix(color_a))*pix(bg_color[0]) 
-                                          + pix(color_a)*pix(iter.get_brush_color()[0])) 
-                                 + inv_brush_a*pix(iter.src[0]) ));
+        iter.dest[0] = Traits::to_data(Traits::clamp(Traits::mul(brush_a,
+                                                                 Traits::mul(one - ca, bg_color[0]) +
+                                                                 Traits::mul(ca, Traits::pix(iter.get_brush_color()[0]))) +
+                                                     Traits::mul(inv_brush_a, Traits::pix(iter.src[0]))));
       }
       if (iter.is_data_end()) break;
       iter.next_row();
@@ -343,23 +357,19 @@ void draw_dab_pixels_BlendMode_Normal_and_Eraser (Iter iter,
         if (iter.should_skipped())
           continue;
 
-        pixel_t brush_a     = pix( eval( pix(iter.get_brush_alpha()) * pix(opacity) ) ); // topAlpha
-        pixel_t inv_brush_a = pix( eval (f2p(1.0) - brush_a ) ); // bottomAlpha
-	result_t internal[3];
+        value_t brush_a     = Traits::clamp(Traits::mul(Traits::pix(iter.get_brush_alpha()), opa)); // topAlpha
+        value_t inv_brush_a = Traits::clamp(one - brush_a); // bottomAlpha
+        value_t internal[3];
+
+        for (int c = 0; c < 3; c++)
+          internal[c] = Traits::clamp(Traits::mul(brush_a,
+                                                  Traits::mul(one - ca, bg_color[c]) +
+                                                  Traits::mul(ca, Traits::pix(iter.get_brush_color()[c]))) +
+                                      Traits::mul(inv_brush_a, Traits::pix(iter.src[c])));
 
-	internal[0] = eval( brush_a*((pix(1.0f) - pix(color_a))*pix(bg_color[0]) 
-                            + pix(color_a)*pix(iter.get_brush_color()[0])) 
-                            + inv_brush_a*pix(iter.src[0]) );
-	internal[1] = eval( brush_a*((pix(1.0f) - pix(color_a))*pix(bg_color[1]) 
-                            + pix(color_a)*pix(iter.get_brush_color()[1])) 
-                            + inv_brush_a*pix(iter.src[1]) );
-	internal[2] = eval( brush_a*((pix(1.0f) - pix(color_a))*pix(bg_color[2]) 
-                            + pix(color_a)*pix(iter.get_brush_color()[2])) 
-                            + inv_brush_a*pix(iter.src[2]) );
-
-        iter.dest[0] = r2d(internal[0]);
-        iter.dest[1] = r2d(internal[1]);
-        iter.dest[2] = r2d(internal[2]);
+        iter.dest[0] = Traits::to_data(internal[0]);
+        iter.dest[1] = Traits::to_data(internal[1]);
+        iter.dest[2] = Traits::to_data(internal[2]);
       }
       if (iter.is_data_end()) break;
       iter.next_row();
@@ -372,23 +382,25 @@ void draw_dab_pixels_BlendMode_Normal_and_Eraser (Iter iter,
         if (iter.should_skipped())
           continue;
 
-        pixel_t brush_a = pix( eval( pix(iter.get_brush_alpha()) * pix(opacity) ) );
-        pixel_t base_a  = pix(iter.src[3]);
-	      result_t alpha = eval( brush_a * pix(color_a) + (pix(1.0f) - brush_a) * base_a );
-        iter.dest[3] = r2d(alpha);
+        value_t brush_a = Traits::clamp(Traits::mul(Traits::pix(iter.get_brush_alpha()), opa));
+        value_t base_a  = Traits::pix(iter.src[3]);
+        value_t alpha   = Traits::clamp(Traits::mul(brush_a, ca) + Traits::mul(one - brush_a, base_a));
+        iter.dest[3] = Traits::to_data(alpha);
         
         if (alpha) {
-          pixel_t inv_brush_a = pix( eval(pix(1.0f) - brush_a));
-          pixel_t dest_a = pix(alpha);
-	  result_t internal[3];
-
-	  internal[0] = eval( (inv_brush_a*base_a*pix(iter.src[0]) + brush_a*pix(color_a)*pix(iter.get_brush_color()[0])) / dest_a );
-	  internal[1] = eval( (inv_brush_a*base_a*pix(iter.src[1]) + brush_a*pix(color_a)*pix(iter.get_brush_color()[1])) / dest_a );
-	  internal[2] = eval( (inv_brush_a*base_a*pix(iter.src[2]) + brush_a*pix(color_a)*pix(iter.get_brush_color()[2])) / dest_a );
-
-          iter.dest[0] = r2d(internal[0]);
-          iter.dest[1] = r2d(internal[1]);
-          iter.dest[2] = r2d(internal[2]);
+          value_t inv_brush_a = Traits::clamp(one - brush_a);
+          value_t internal[3];
+
+          for (int c = 0; c < 3; c++)
+            internal[c] = Traits::clamp(Traits::div(Traits::mul(Traits::mul(inv_brush_a, base_a),
+                                                                Traits::pix(iter.src[c])) +
+                                                    Traits::mul(Traits::mul(brush_a, ca),
+                                                                Traits::pix(iter.get_brush_color()[c])),
+                                                    alpha));
+
+          iter.dest[0] = Traits::to_data(internal[0]);
+          iter.dest[1] = Traits::to_data(internal[1]);
+          iter.dest[2] = Traits::to_data(internal[2]);
         } else {
           iter.dest[0] = iter.get_brush_color()[0];
           iter.dest[1] = iter.get_brush_color()[1];
@@ -406,14 +418,19 @@ void draw_dab_pixels_BlendMode_Normal_and_Eraser (Iter iter,
 
 // This is BlendMode_Normal with locked alpha channel.
 //
-template<typename Iter>
+template<typename Iter, typename Traits = PixelTraitsReal>
 void draw_dab_pixels_BlendMode_LockAlpha (Iter          iter,
-                                          Pixel::real   opacity)
+                                          Pixel::real   opacity,
+                                          Traits        traits = Traits())
 {
+  typedef typename Traits::value_t value_t;
+  const value_t one = Traits::one();
+  const value_t opa = Traits::pix(opacity);
+
   switch (iter.src_bytes) {
   case 1:
   case 3:
-    draw_dab_pixels_BlendMode_Normal(iter, opacity);
+    draw_dab_pixels_BlendMode_Normal(iter, opacity, traits);
     break;
   case 4:
 
@@ -423,20 +440,22 @@ void draw_dab_pixels_BlendMode_LockAlpha (Iter          iter,
         if (iter.should_skipped())
           continue;
 
-        pixel_t brush_a = pix( eval( pix(iter.get_brush_alpha()) * pix(opacity) ) ); // topAlpha
-        pixel_t inv_brush_a = pix( eval( f2p(1.0) - brush_a) ); // bottomAlpha
-        pixel_t alpha = pix( iter.src[3] );
-        pixel_t dest_a = pix( iter.src[3] );
-        pixel_t base_a = dest_a;
-	result_t internal[3];
-	
-	internal[0] = eval( (brush_a*alpha*pix(iter.get_brush_color()[0]) + inv_brush_a*base_a*pix(iter.src[0])) / dest_a);
-	internal[1] = eval( (brush_a*alpha*pix(iter.get_brush_color()[1]) + inv_brush_a*base_a*pix(iter.src[1])) / dest_a);
-	internal[2] = eval( (brush_a*alpha*pix(iter.get_brush_color()[2]) + inv_brush_a*base_a*pix(iter.src[2])) / dest_a);
+        value_t brush_a     = Traits::clamp(Traits::mul(Traits::pix(iter.get_brush_alpha()), opa)); // topAlpha
+        value_t inv_brush_a = Traits::clamp(one - brush_a); // bottomAlpha
+        value_t alpha       = Traits::pix(iter.src[3]);
+        value_t internal[3];
+
+        // a transparent pixel stays as it is: 0 / 0 is 0 in the end
+        for (int c = 0; c < 3; c++)
+          internal[c] = Traits::clamp(Traits::div(Traits::mul(Traits::mul(brush_a, alpha),
+                                                              Traits::pix(iter.get_brush_color()[c])) +
+                                                  Traits::mul(Traits::mul(inv_brush_a, alpha),
+                                                              Traits::pix(iter.src[c])),
+                                                  alpha));
         
-        iter.dest[0] = r2d(internal[0]);
-        iter.dest[1] = r2d(internal[1]);
-        iter.dest[2] = r2d(internal[2]);
+        iter.dest[0] = Traits::to_data(internal[0]);
+        iter.dest[1] = Traits::to_data(internal[1]);
+        iter.dest[2] = Traits::to_data(internal[2]);
       }
       if (iter.is_data_end()) break;
       iter.next_row();
@@ -448,6 +467,94 @@ void draw_dab_pixels_BlendMode_LockAlpha (Iter          iter,
 };
 
 
+// The run length encoded dabs of the MyPaint brushes go through the
+// functions of mypaint-blend.c a run at a time, which blend several
+// pixels at once where the CPU allows it.  This is the single precision
+// path, the templates above remain its reference and serve where
+// source and destination differ in their bytes.
+//
+inline void
+draw_dab_runs (BrushPixelIteratorForRunLength& iter,
+               MypaintBlendFunc                func,
+               const MypaintBlendParams*       params)
+{
+  while (1) {
+    gint n = 0;
+    while (iter.mask[n])
+      n++;
+    if (n) {
+      func(iter.mask, iter.src, iter.dest, n, params);
+      iter.mask += n;
+      iter.src  += n * iter.src_bytes;
+      iter.dest += n * iter.dest_bytes;
+    }
+    if (iter.is_data_end()) break;
+    iter.next_row();
+  }
+}
+
+inline void
+draw_dab_pixels_BlendMode_Normal (BrushPixelIteratorForRunLength iter,
+                                  Pixel::real                    opacity,
+                                  PixelTraitsReal                = PixelTraitsReal())
+{
+  MypaintBlendParams params;
+
+  if (iter.src_bytes != iter.dest_bytes ||
+      !mypaint_blend_funcs.normal[iter.src_bytes - 1]) {
+    draw_dab_pixels_BlendMode_Normal<BrushPixelIteratorForRunLength>(iter, opacity);
+    return;
+  }
+
+  mypaint_blend_params_init(&params, opacity, 1.0f, iter.colors, NULL);
+  draw_dab_runs(iter, mypaint_blend_funcs.normal[iter.src_bytes - 1], &params);
+}
+
+inline void
+draw_dab_pixels_BlendMode_Normal_and_Eraser (BrushPixelIteratorForRunLength iter,
+                                             Pixel::real   color_a,
+                                             Pixel::real   opacity,
+                                             Pixel::real   background_r = 1.0f,
+                                             Pixel::real   background_g = 1.0f,
+                                             Pixel::real   background_b = 1.0f,
+                                             PixelTraitsReal = PixelTraitsReal())
+{
+  Pixel::real        bg_color[3] = { background_r, background_g, background_b };
+  MypaintBlendParams params;
+
+  if (iter.src_bytes != iter.dest_bytes ||
+      !mypaint_blend_funcs.normal[iter.src_bytes - 1]) {
+    draw_dab_pixels_BlendMode_Normal_and_Eraser<BrushPixelIteratorForRunLength>(iter, color_a, opacity,
+                                                                                 background_r,
+                                                                                 background_g,
+                                                                                 background_b);
+    return;
+  }
+
+  mypaint_blend_params_init(&params, opacity, color_a, iter.colors, bg_color);
+  draw_dab_runs(iter, mypaint_blend_funcs.normal[iter.src_bytes - 1], &params);
+}
+
+inline void
+draw_dab_pixels_BlendMode_LockAlpha (BrushPixelIteratorForRunLength iter,
+                                     Pixel::real                    opacity,
+                                     PixelTraitsReal                = PixelTraitsReal())
+{
+  MypaintBlendParams params;
+
+  if (iter.src_bytes != 4 || iter.dest_bytes != 4) {
+    if (iter.src_bytes == 4)
+      draw_dab_pixels_BlendMode_LockAlpha<BrushPixelIteratorForRunLength>(iter, opacity);
+    else
+      draw_dab_pixels_BlendMode_Normal(iter, opacity);
+    return;
+  }
+
+  mypaint_blend_params_init(&params, opacity, 1.0f, iter.colors, NULL);
+  draw_dab_runs(iter, mypaint_blend_funcs.lock_alpha, &params);
+}
+
+
 // Sum up the color/alpha components inside the masked region.
 // Called by get_color().
 //
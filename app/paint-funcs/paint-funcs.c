@@ -32,10 +32,13 @@
 #include "base/temp-buf.h"
 #include "base/tile-manager.h"
 #include "base/tile-rowhints.h"
+#include "base/tile-stats.h"
 #include "base/tile.h"
 
 #include "composite/gimp-composite.h"
 
+#include "combine-pixels.h"
+#include "distance-transform.h"
 #include "paint-funcs.h"
 #include "paint-funcs-utils.h"
 #include "paint-funcs-generic.h"
@@ -43,8 +46,6 @@
 
 #define EPSILON       0.0001
 
-#define LOG_1_255     -5.541263545    /*  log (1.0 / 255.0)  */
-
 
 /*  Layer modes information  */
 typedef struct _LayerMode LayerMode;
@@ -100,8 +101,6 @@ static const guchar  no_mask = OPAQUE_OPACITY;
 
 /*  Local function prototypes  */
 
-static gint *   make_curve               (gdouble         sigma_square,
-                                          gint           *length);
 static gdouble  cubic                    (gdouble         dx,
                                           gint            jm1,
                                           gint            j,
@@ -122,82 +121,6 @@ static void     apply_layer_mode_replace (const guchar   *src1,
 static inline void rotate_pointers       (guchar        **p,
                                           guint32         n);
 
-/*
- * The equations: g(r) = exp (- r^2 / (2 * sigma^2))
- *                   r = sqrt (x^2 + y^2)
- */
-
-static gint *
-make_curve (gdouble  sigma_square,
-            gint    *length)
-{
-  const gdouble sigma2 = 2 * sigma_square;
-  const gdouble l      = sqrt (-sigma2 * LOG_1_255);
-
-  gint *curve;
-  gint  i, n;
-
-  n = ceil (l) * 2;
-  if ((n % 2) == 0)
-    n += 1;
-
-  curve = g_new (gint, n);
-
-  *length = n / 2;
-  curve += *length;
-  curve[0] = 255;
-
-  for (i = 1; i <= *length; i++)
-    {
-      gint temp = (gint) (exp (- SQR (i) / sigma2) * 255);
-
-      curve[-i] = temp;
-      curve[i] = temp;
-    }
-
-  return curve;
-}
-
-
-static inline void
-run_length_encode (const guchar *src,
-                   guint        *dest,
-                   guint         w,
-                   guint         bytes)
-{
-  guint  start;
-  guint  i;
-  guint  j;
-  guchar last;
-
-  last = *src;
-  src += bytes;
-  start = 0;
-
-  for (i = 1; i < w; i++)
-    {
-      if (*src != last)
-        {
-          for (j = start; j < i; j++)
-            {
-              *dest++ = (i - j);
-              *dest++ = last;
-            }
-
-          start = i;
-          last = *src;
-        }
-
-      src += bytes;
-    }
-
-  for (j = start; j < i; j++)
-    {
-      *dest++ = (i - j);
-      *dest++ = last;
-    }
-}
-
 /* Note: cubic function no longer clips result */
 static inline gdouble
 cubic (gdouble dx,
@@ -2163,62 +2086,67 @@ extract_from_region (PixelRegion       *src,
 }
 
 
-void
-convolve_region (PixelRegion         *srcR,
-                 PixelRegion         *destR,
-                 const gfloat        *matrix,
-                 gint                 size,
-                 gdouble              divisor,
-                 GimpConvolutionType  mode,
-                 gboolean             alpha_weighting)
-{
-  /*  Convolve the src image using the convolution matrix, writing to dest  */
-  /*  Convolve is not tile-enabled--use accordingly  */
-  const guchar *src       = srcR->data;
-  guchar       *dest      = destR->data;
-  const gint    bytes     = srcR->bytes;
-  const gint    a_byte    = bytes - 1;
-  const gint    rowstride = srcR->rowstride;
-  const gint    margin    = size / 2;
-  const gint    x1        = srcR->x;
-  const gint    y1        = srcR->y;
-  const gint    x2        = srcR->x + srcR->w - 1;
-  const gint    y2        = srcR->y + srcR->h - 1;
-  gint          x, y;
-  gint          offset;
+/*  Rows of the destination per item of the pixel processor  */
+#define CONVOLVE_BAND_HEIGHT  16
 
-  /*  If the mode is NEGATIVE_CONVOL, the offset should be 128  */
-  if (mode == GIMP_NEGATIVE_CONVOL)
-    {
-      offset = 128;
-      mode = GIMP_NORMAL_CONVOL;
-    }
-  else
-    {
-      offset = 0;
-    }
+typedef struct
+{
+  PixelRegion         *destR;
+  const gfloat        *matrix;
+  gint                 size;
+  gdouble              divisor;
+  GimpConvolutionType  mode;
+  gint                 offset;
+  gboolean             alpha_weighting;
+
+  /*  the clamped source rows and byte offsets of the source columns,
+   *  indexed from -margin to the height and width plus margin
+   */
+  const guchar       **rows;
+  const gint          *cols;
+} ConvolveInfo;
 
-  for (y = 0; y < destR->h; y++)
+static void
+convolve_band (const ConvolveInfo *info,
+               gint                band)
+{
+  const PixelRegion  *destR   = info->destR;
+  const guchar      **rows    = info->rows;
+  const gint         *cols    = info->cols;
+  const gint          bytes   = destR->bytes;
+  const gint          a_byte  = bytes - 1;
+  const gint          margin  = info->size / 2;
+  const gdouble       divisor = info->divisor;
+  const gint          offset  = info->offset;
+  const gint          y_end   = MIN ((band + 1) * CONVOLVE_BAND_HEIGHT,
+                                     destR->h);
+  guchar             *dest;
+  gint                x, y;
+
+  y    = band * CONVOLVE_BAND_HEIGHT;
+  dest = destR->data + y * destR->rowstride;
+
+  for (; y < y_end; y++)
     {
       guchar *d = dest;
 
-      if (alpha_weighting)
+      if (info->alpha_weighting)
         {
           for (x = 0; x < destR->w; x++)
             {
-              const gfloat *m                = matrix;
+              const gfloat *m                = info->matrix;
               gdouble       total[4]         = { 0.0, 0.0, 0.0, 0.0 };
               gdouble       weighted_divisor = 0.0;
               gint          i, j, b;
 
               for (j = y - margin; j <= y + margin; j++)
                 {
+                  const guchar *row = rows[j];
+
                   for (i = x - margin; i <= x + margin; i++, m++)
                     {
-                      gint          xx = CLAMP (i, x1, x2);
-                      gint          yy = CLAMP (j, y1, y2);
-                      const guchar *s  = src + yy * rowstride + xx * bytes;
-                      const guchar  a  = s[a_byte];
+                      const guchar *s = row + cols[i];
+                      const guchar  a = s[a_byte];
 
                       if (a)
                         {
@@ -2246,7 +2174,7 @@ convolve_region (PixelRegion         *srcR,
                 {
                   total[b] += offset;
 
-                  if (mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
+                  if (info->mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
                     total[b] = - total[b];
 
                   if (total[b] < 0.0)
@@ -2260,17 +2188,17 @@ convolve_region (PixelRegion         *srcR,
         {
           for (x = 0; x < destR->w; x++)
             {
-              const gfloat *m        = matrix;
+              const gfloat *m        = info->matrix;
               gdouble       total[4] = { 0.0, 0.0, 0.0, 0.0 };
               gint          i, j, b;
 
               for (j = y - margin; j <= y + margin; j++)
                 {
+                  const guchar *row = rows[j];
+
                   for (i = x - margin; i <= x + margin; i++, m++)
                     {
-                      gint          xx = CLAMP (i, x1, x2);
-                      gint          yy = CLAMP (j, y1, y2);
-                      const guchar *s  = src + yy * rowstride + xx * bytes;
+                      const guchar *s = row + cols[i];
 
                       for (b = 0; b < bytes; b++)
                         total[b] += *m * s[b];
@@ -2281,7 +2209,7 @@ convolve_region (PixelRegion         *srcR,
                 {
                   total[b] = total[b] / divisor + offset;
 
-                  if (mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
+                  if (info->mode != GIMP_NORMAL_CONVOL && total[b] < 0.0)
                     total[b] = - total[b];
 
                   if (total[b] < 0.0)
@@ -2296,6 +2224,70 @@ convolve_region (PixelRegion         *srcR,
     }
 }
 
+void
+convolve_region (PixelRegion         *srcR,
+                 PixelRegion         *destR,
+                 const gfloat        *matrix,
+                 gint                 size,
+                 gdouble              divisor,
+                 GimpConvolutionType  mode,
+                 gboolean             alpha_weighting)
+{
+  /*  Convolve the src image using the convolution matrix, writing to dest  */
+  /*  Convolve is not tile-enabled--use accordingly  */
+  const guchar  *src       = srcR->data;
+  const gint     bytes     = srcR->bytes;
+  const gint     rowstride = srcR->rowstride;
+  const gint     margin    = size / 2;
+  const gint     x1        = srcR->x;
+  const gint     y1        = srcR->y;
+  const gint     x2        = srcR->x + srcR->w - 1;
+  const gint     y2        = srcR->y + srcR->h - 1;
+  ConvolveInfo   info;
+  const guchar **rows;
+  gint          *cols;
+  gint           i;
+
+  info.destR           = destR;
+  info.matrix          = matrix;
+  info.size            = size;
+  info.divisor         = divisor;
+  info.mode            = mode;
+  info.alpha_weighting = alpha_weighting;
+
+  /*  If the mode is NEGATIVE_CONVOL, the offset should be 128  */
+  if (mode == GIMP_NEGATIVE_CONVOL)
+    {
+      info.offset = 128;
+      info.mode   = GIMP_NORMAL_CONVOL;
+    }
+  else
+    {
+      info.offset = 0;
+    }
+
+  /*  clamp the taps to the source once, not for every pixel  */
+  rows = g_new (const guchar *, destR->h + 2 * margin);
+  cols = g_new (gint, destR->w + 2 * margin);
+
+  for (i = 0; i < destR->h + 2 * margin; i++)
+    rows[i] = src + CLAMP (i - margin, y1, y2) * rowstride;
+
+  for (i = 0; i < destR->w + 2 * margin; i++)
+    cols[i] = CLAMP (i - margin, x1, x2) * bytes;
+
+  info.rows = rows + margin;
+  info.cols = cols + margin;
+
+  pixel_processor_process_items ((PixelProcessorItemFunc) convolve_band,
+                                 &info,
+                                 (destR->h + CONVOLVE_BAND_HEIGHT - 1) /
+                                 CONVOLVE_BAND_HEIGHT);
+
+  g_free (rows);
+  g_free (cols);
+}
+
 
 /* Convert from separated alpha to premultiplied alpha. Only works on
    non-tiled regions! */
@@ -2378,177 +2370,6 @@ separate_alpha_region (PixelRegion *srcR)
     }
 }
 
-void
-gaussian_blur_region (PixelRegion *srcR,
-                      gdouble      radius_x,
-                      gdouble      radius_y)
-{
-  glong   width, height;
-  guint   bytes;
-  guchar *src, *sp;
-  guchar *dest, *dp;
-  guchar *data;
-  guint  *buf, *b;
-  gint    pixels;
-  gint    total;
-  gint    i, row, col;
-  gint    start, end;
-  gint   *curve;
-  gint   *sum;
-  gint    val;
-  gint    length;
-  gint    alpha;
-  gint    initial_p;
-  gint    initial_m;
-
-  if (radius_x == 0.0 && radius_y == 0.0)
-    return;
-
-  /*  allocate the result buffer  */
-  length = MAX (srcR->w, srcR->h) * srcR->bytes;
-  data = g_new (guchar, length * 2);
-  src = data;
-  dest = data + length;
-
-  width = srcR->w;
-  height = srcR->h;
-  bytes = srcR->bytes;
-  alpha = bytes - 1;
-
-  buf = g_new (guint, MAX (width, height) * 2);
-
-  if (radius_y != 0.0)
-    {
-      curve = make_curve (- SQR (radius_y) / (2 * LOG_1_255), &length);
-
-      sum = g_new (gint, 2 * length + 1);
-      sum[0] = 0;
-
-      for (i = 1; i <= length * 2; i++)
-        sum[i] = curve[i - length - 1] + sum[i - 1];
-
-      sum += length;
-
-      total = sum[length] - sum[-length];
-
-      for (col = 0; col < width; col++)
-        {
-          pixel_region_get_col (srcR, col + srcR->x, srcR->y, height, src, 1);
-          sp = src + alpha;
-
-          initial_p = sp[0];
-          initial_m = sp[(height - 1) * bytes];
-
-          /*  Determine a run-length encoded version of the column  */
-          run_length_encode (sp, buf, height, bytes);
-
-          for (row = 0; row < height; row++)
-            {
-              start = (row < length) ? -row : -length;
-              end = (height <= (row + length)) ? (height - row - 1) : length;
-
-              val = total / 2;
-              i = start;
-              b = buf + (row + i) * 2;
-
-              if (start != -length)
-                val += initial_p * (sum[start] - sum[-length]);
-
-              while (i < end)
-                {
-                  pixels = b[0];
-                  i += pixels;
-                  if (i > end)
-                    i = end;
-                  val += b[1] * (sum[i] - sum[start]);
-                  b += (pixels * 2);
-                  start = i;
-                }
-
-              if (end != length)
-                val += initial_m * (sum[length] - sum[end]);
-
-              sp[row * bytes] = val / total;
-            }
-
-          pixel_region_set_col (srcR, col + srcR->x, srcR->y, height, src);
-        }
-
-      g_free (sum - length);
-      g_free (curve - length);
-    }
-
-  if (radius_x != 0.0)
-    {
-      curve = make_curve (- SQR (radius_x) / (2 * LOG_1_255), &length);
-
-      sum = g_new (gint, 2 * length + 1);
-      sum[0] = 0;
-
-      for (i = 1; i <= length * 2; i++)
-        sum[i] = curve[i - length - 1] + sum[i - 1];
-
-      sum += length;
-
-      total = sum[length] - sum[-length];
-
-      for (row = 0; row < height; row++)
-        {
-          pixel_region_get_row (srcR, srcR->x, row + srcR->y, width, src, 1);
-          sp = src + alpha;
-          dp = dest + alpha;
-
-          initial_p = sp[0];
-          initial_m = sp[(width - 1) * bytes];
-
-          /*  Determine a run-length encoded version of the row  */
-          run_length_encode (sp, buf, width, bytes);
-
-          for (col = 0; col < width; col++)
-            {
-              start = (col < length) ? -col : -length;
-              end = (width <= (col + length)) ? (width - col - 1) : length;
-
-              val = total / 2;
-              i = start;
-              b = buf + (col + i) * 2;
-
-              if (start != -length)
-                val += initial_p * (sum[start] - sum[-length]);
-
-              while (i < end)
-                {
-                  pixels = b[0];
-
-                  i += pixels;
-
-                  if (i > end)
-                    i = end;
-
-                  val += b[1] * (sum[i] - sum[start]);
-                  b += (pixels * 2);
-                  start = i;
-                }
-
-              if (end != length)
-                val += initial_m * (sum[length] - sum[end]);
-
-              val = val / total;
-
-              dp[col * bytes] = val;
-            }
-
-          pixel_region_set_row (srcR, srcR->x, row + srcR->y, width, dest);
-        }
-
-      g_free (sum - length);
-      g_free (curve - length);
-    }
-
-  g_free (data);
-  g_free (buf);
-}
-
 static inline void
 rotate_pointers (guchar  **p,
                  guint32   n)
@@ -2565,149 +2386,111 @@ rotate_pointers (guchar  **p,
 }
 
 
-gfloat
-shapeburst_region (PixelRegion      *srcPR,
-                   PixelRegion      *distPR,
-                   GimpProgressFunc  progress_callback,
-                   gpointer          progress_data)
+typedef struct
 {
-  Tile   *tile;
-  guchar *tile_data;
-  gfloat  max_iterations = 0.0;
-  gfloat *distp_cur;
-  gfloat *distp_prev;
-  gfloat *memory;
-  gfloat *tmp;
-  gfloat  min_prev;
-  gfloat  float_tmp;
-  gint    min;
-  gint    min_left;
-  gint    length;
-  gint    i, j, k;
-  gint    fraction;
-  gint    prev_frac;
-  gint    x, y;
-  gint    end;
-  gint    boundary;
-  gint    inc;
-  gint    src          = 0;
-  gint    max_progress = srcPR->w * srcPR->h;
-  gint    progress     = 0;
-
-  length = distPR->w + 1;
-  memory = g_new (gfloat, length * 2);
-
-  distp_prev = memory;
-  for (i = 0; i < length; i++)
-    distp_prev[i] = 0.0;
-
-  distp_prev += 1;
-  distp_cur = distp_prev + length;
-
-  for (i = 0; i < srcPR->h; i++)
-    {
-      /*  set the current dist row to 0's  */
-      memset (distp_cur - 1, 0, sizeof (gfloat) * (length - 1));
-
-      for (j = 0; j < srcPR->w; j++)
-        {
-          min_prev = MIN (distp_cur[j-1], distp_prev[j]);
-          min_left = MIN ((srcPR->w - j - 1), (srcPR->h - i - 1));
-          min = (gint) MIN (min_left, min_prev);
-          fraction = 255;
-
-          /*  This might need to be changed to 0
-              instead of k = (min) ? (min - 1) : 0  */
-
-          for (k = (min) ? (min - 1) : 0; k <= min; k++)
-            {
-              x = j;
-              y = i + k;
-              end = y - k;
-
-              while (y >= end)
-                {
-                  gint width;
-
-                  tile = tile_manager_get_tile (srcPR->tiles,
-                                                x, y, TRUE, FALSE);
-
-                  tile_data = tile_data_pointer (tile, x, y);
-                  width = tile_ewidth (tile);
-
-                  boundary = MIN (y % TILE_HEIGHT,
-                                  width - (x % TILE_WIDTH) - 1);
-                  boundary = MIN (boundary, y - end) + 1;
+  PixelRegion      *srcPR;
+  PixelRegion      *distPR;
+  guchar           *mask;
+  gfloat            max;
+  GimpProgressFunc  progress_callback;
+  gpointer          progress_data;
+} ShapeburstInfo;
 
-                  inc = 1 - width;
-
-                  while (boundary--)
-                    {
-                      src = *tile_data;
-
-                      if (src == 0)
-                        {
-                          min = k;
-                          y = -1;
-                          break;
-                        }
-
-                      if (src < fraction)
-                        fraction = src;
+static void
+shapeburst_read (ShapeburstInfo *info,
+                 gint            y,
+                 gint            n_rows,
+                 guchar         *seeds)
+{
+  PixelRegion *srcPR = info->srcPR;
+  gint         i;
 
-                      x++;
-                      y--;
-                      tile_data += inc;
-                    }
+  for (i = 0; i < n_rows; i++)
+    pixel_region_get_row (srcPR, srcPR->x, srcPR->y + y + i, srcPR->w,
+                          seeds + i * srcPR->w, 1);
 
-                  tile_release (tile, FALSE);
-                }
-            }
+  /*  the unselected pixels are the seeds  */
+  for (i = 0; i < n_rows * srcPR->w; i++)
+    seeds[i] = (seeds[i] == 0);
+}
 
-          if (src != 0)
-            {
-              /*  If min_left != min_prev use the previous fraction
-               *   if it is less than the one found
-               */
-              if (min_left != min)
-                {
-                  prev_frac = (int) (255 * (min_prev - min));
+static void
+shapeburst_write (ShapeburstInfo *info,
+                  gint            y,
+                  gint            n_rows,
+                  gfloat         *dist)
+{
+  PixelRegion *srcPR  = info->srcPR;
+  PixelRegion *distPR = info->distPR;
+  gint         i;
 
-                  if (prev_frac == 255)
-                    prev_frac = 0;
+  for (i = 0; i < n_rows; i++)
+    {
+      const guchar *m = info->mask;
+      gfloat       *d = dist + i * srcPR->w;
+      gint          x;
 
-                  fraction = MIN (fraction, prev_frac);
-                }
+      pixel_region_get_row (srcPR, srcPR->x, srcPR->y + y + i, srcPR->w,
+                            info->mask, 1);
 
-              min++;
-            }
-
-          float_tmp = distp_cur[j] = min + fraction / 256.0;
+      for (x = 0; x < srcPR->w; x++)
+        {
+          if (m[x])
+            d[x] += m[x] / 255.0 - 1.0;
+          else
+            d[x] = 0.0;
 
-          if (float_tmp > max_iterations)
-            max_iterations = float_tmp;
+          if (d[x] > info->max)
+            info->max = d[x];
         }
 
       /*  set the dist row  */
       pixel_region_set_row (distPR,
-                            distPR->x, distPR->y + i, distPR->w,
-                            (guchar *) distp_cur);
+                            distPR->x, distPR->y + y + i, distPR->w,
+                            (guchar *) d);
+    }
 
-      /*  swap pointers around  */
-      tmp = distp_prev;
-      distp_prev = distp_cur;
-      distp_cur = tmp;
+  if (info->progress_callback)
+    (* info->progress_callback) (0, srcPR->h, y + n_rows,
+                                 info->progress_data);
+}
 
-      if (progress_callback)
-        {
-          progress += srcPR->h;
-          (* progress_callback) (0, max_progress, progress, progress_data);
-        }
-    }
+/*  The distance of every selected pixel of @srcPR to the nearest
+ *  unselected one, where the pixels around @srcPR count as unselected.
+ *  The pixels next to the edge of the selection get their opacity as
+ *  fraction.  Returns the largest distance.  @srcPR is read a chunk
+ *  of rows at a time, see distance-transform.h, so this needs about
+ *  9 bytes per pixel of a TILE_HEIGHT rows high stripe of it, and 4
+ *  bytes per column and TILE_HEIGHT rows.
+ */
+gfloat
+shapeburst_region (PixelRegion      *srcPR,
+                   PixelRegion      *distPR,
+                   GimpProgressFunc  progress_callback,
+                   gpointer          progress_data)
+{
+  ShapeburstInfo info;
+
+  if (srcPR->w < 1 || srcPR->h < 1)
+    return 0.0;
 
-  g_free (memory);
+  info.srcPR             = srcPR;
+  info.distPR            = distPR;
+  info.mask              = g_new (guchar, srcPR->w);
+  info.max               = 0.0;
+  info.progress_callback = progress_callback;
+  info.progress_data     = progress_data;
 
-  return max_iterations;
+  distance_transform_euclidean_chunked (srcPR->w, srcPR->h, TRUE,
+                                        (DistanceTransformReadFunc)
+                                        shapeburst_read,
+                                        (DistanceTransformWriteDistFunc)
+                                        shapeburst_write,
+                                        &info);
+
+  g_free (info.mask);
+
+  return info.max;
 }
 
 static void
@@ -2733,6 +2516,112 @@ compute_border (gint16  *circ,
   }
 }
 
+typedef struct
+{
+  PixelRegion *region;
+  gboolean     shrink;
+} MorphInfo;
+
+static void
+morph_read (MorphInfo *info,
+            gint       y,
+            gint       n_rows,
+            guchar    *seeds)
+{
+  PixelRegion *region = info->region;
+  gint         i;
+
+  for (i = 0; i < n_rows; i++)
+    pixel_region_get_row (region, region->x, region->y + y + i, region->w,
+                          seeds + i * region->w, 1);
+
+  /*  shrinking grows the unselected pixels  */
+  if (info->shrink)
+    for (i = 0; i < n_rows * region->w; i++)
+      seeds[i] = 255 - seeds[i];
+}
+
+static void
+morph_write (MorphInfo *info,
+             gint       y,
+             gint       n_rows,
+             guchar    *mask)
+{
+  PixelRegion *region = info->region;
+  gint         i;
+
+  if (info->shrink)
+    for (i = 0; i < n_rows * region->w; i++)
+      mask[i] = 255 - mask[i];
+
+  for (i = 0; i < n_rows; i++)
+    pixel_region_set_row (region, region->x, region->y + y + i, region->w,
+                          mask + i * region->w);
+}
+
+/*  Grows @region by the ellipse of compute_border(), or with @shrink
+ *  shrinks it, in linear time if all its pixels are 0 or 255.  Returns
+ *  FALSE and leaves @region alone if it has other values.  Like
+ *  shapeburst_region(), this keeps only a stripe of @region in memory.
+ */
+static gboolean
+morph_binary_region (PixelRegion *region,
+                     gint16       xradius,
+                     gint16       yradius,
+                     gboolean     shrink,
+                     gboolean     edge_lock)
+{
+  PixelRegion  checkPR = *region;
+  MorphInfo    info;
+  gint16      *circ;
+  gint        *heights;
+  gpointer     pr;
+  gint         x;
+
+  /*  iterating moves the region  */
+  checkPR.dirty = FALSE;
+
+  for (pr = pixel_regions_register (1, &checkPR);
+       pr != NULL;
+       pr = pixel_regions_process (pr))
+    {
+      const guchar *data = checkPR.data;
+      gint          y;
+
+      for (y = 0; y < checkPR.h; y++, data += checkPR.rowstride)
+        for (x = 0; x < checkPR.w; x++)
+          if (data[x] != 0 && data[x] != 255)
+            {
+              pixel_regions_process_stop (pr);
+              return FALSE;
+            }
+    }
+
+  circ = g_new (gint16, 2 * xradius + 1);
+  compute_border (circ, xradius, yradius);
+
+  heights = g_new (gint, xradius + 1);
+
+  for (x = 0; x <= xradius; x++)
+    heights[x] = circ[xradius + x];
+
+  info.region = region;
+  info.shrink = shrink;
+
+  /*  without edge_lock, the pixels around the region are unselected  */
+  distance_transform_dilate_chunked (region->w, region->h, heights, xradius,
+                                     shrink && ! edge_lock,
+                                     (DistanceTransformReadFunc) morph_read,
+                                     (DistanceTransformWriteMaskFunc)
+                                     morph_write,
+                                     &info);
+
+  g_free (heights);
+  g_free (circ);
+
+  return TRUE;
+}
+
 void
 fatten_region (PixelRegion *region,
                gint16       xradius,
@@ -2755,6 +2644,9 @@ fatten_region (PixelRegion *region,
   if (xradius <= 0 || yradius <= 0)
     return;
 
+  if (morph_binary_region (region, xradius, yradius, FALSE, FALSE))
+    return;
+
   max = g_new (guchar *, region->w + 2 * xradius);
   buf = g_new (guchar *, yradius + 1);
 
@@ -2772,7 +2664,7 @@ fatten_region (PixelRegion *region,
       else
         max[i] = &buffer[(yradius + 1) * (region->w + xradius - 1)];
 
-      for (j = 0; j < xradius + 1; j++)
+      for (j = 0; j < yradius + 1; j++)
         max[i][j] = 0;
     }
 
@@ -2795,6 +2687,9 @@ fatten_region (PixelRegion *region,
     pixel_region_get_row (region,
                           region->x, region->y + i, region->w, buf[i + 1], 1);
 
+  for (; i < yradius; i++) /* below an image shorter than yradius */
+    memset (buf[i + 1], 0, region->w);
+
   for (x = 0; x < region->w; x++) /* set up max for top of image */
     {
       max[x][0] = 0;         /* buf[0][x] is always 0 */
@@ -2911,6 +2806,9 @@ thin_region (PixelRegion *region,
   if (xradius <= 0 || yradius <= 0)
     return;
 
+  if (morph_binary_region (region, xradius, yradius, TRUE, edge_lock))
+    return;
+
   max = g_new (guchar *, region->w + 2 * xradius);
   buf = g_new (guchar *, yradius + 1);
 
@@ -2967,6 +2865,15 @@ thin_region (PixelRegion *region,
   for (i = 0; i < yradius && i < region->h; i++) /* load top of image */
     pixel_region_get_row (region,
                           region->x, region->y + i, region->w, buf[i + 1], 1);
+
+  for (; i < yradius; i++) /* below an image shorter than yradius */
+    {
+      if (edge_lock)
+        memcpy (buf[i + 1], buf[i], region->w);
+      else
+        memset (buf[i + 1], 0, region->w);
+    }
+
   if (edge_lock)
     memcpy (buf[0], buf[1], region->w);
   else
@@ -3345,142 +3252,324 @@ compute_transition (guchar    *transition,
     }
 }
 
-void
-border_region (PixelRegion *src,
-               gint16       xradius,
-               gint16       yradius,
-               gboolean     feather,
-               gboolean     edge_lock)
+typedef struct
 {
-  /*
-     This function has no bugs, but if you imagine some you can
-     blame them on jaycox@gimp.org
-  */
+  PixelRegion   *src;
+  gboolean       edge_lock;
 
-  register gint32 i, j, x, y;
-
-  /* A cache used in the algorithm as it works its way down. `buf[1]' is the
-     current row. Thus, at algorithm initialization, `buf[0]' represents the
-     row 'above' the first row of the region. */
-  guchar  *buf[3];
+  /*  a chunk of rows with the rows above and below it, and the last
+   *  row of the chunk read before, as it was before it was written
+   */
+  guchar        *rows;
+  guchar        *last;
+  gint           last_y;
+
+  /*  the feathered border of a chunk, see border_feather_band()  */
+  const guchar  *density;
+  const gdouble *ykeys;
+  gdouble        xkey;
+  gint           xradius;
+  gint           yradius;
+  const gint    *columns;
+  gint           n_rows;
+  guchar        *dest;
+} BorderInfo;
+
+#define BORDER_BAND_HEIGHT  16
+
+/*  Reads the transitions of a chunk of rows of the region, with the
+ *  rows above and below the region selected with edge_lock and
+ *  unselected otherwise.
+ */
+static void
+border_read (BorderInfo *info,
+             gint        y,
+             gint        n_rows,
+             guchar     *seeds)
+{
+  PixelRegion *src   = info->src;
+  const gint   width = src->w;
+  guchar      *rows  = info->rows;
+  guchar      *below = rows + (n_rows + 1) * width;
+  gint         i;
+
+  /*  the row above was written with the chunk before  */
+  if (y == 0)
+    memset (rows, info->edge_lock ? 255 : 0, width);
+  else if (y - 1 == info->last_y)
+    memcpy (rows, info->last, width);
+  else
+    pixel_region_get_row (src, src->x, src->y + y - 1, width, rows, 1);
 
-  /* The resulting selection is calculated row by row, and this buffer holds the
-     output for each individual row, on each iteration. */
-  guchar  *out;
+  for (i = 0; i < n_rows; i++)
+    pixel_region_get_row (src, src->x, src->y + y + i, width,
+                          rows + (i + 1) * width, 1);
 
-  /* Keeps track of transitional pixels (pixels that are selected and have
-     unselected neighbouring pixels). */
-  guchar **transition;
+  /*  a region of a single row is the row below itself  */
+  if (y + n_rows < src->h)
+    pixel_region_get_row (src, src->x, src->y + y + n_rows, width, below, 1);
+  else if (src->h == 1)
+    memcpy (below, rows + width, width);
+  else
+    memset (below, info->edge_lock ? 255 : 0, width);
 
-  /* TODO: Figure out role clearly in algorithm. */
-  gint16  *max;
+  memcpy (info->last, rows + n_rows * width, width);
+  info->last_y = y + n_rows - 1;
 
-  /* TODO: Figure out role clearly in algorithm. */
-  guchar **density;
+  for (i = 0; i < n_rows; i++)
+    {
+      guchar *buf[3];
 
-  gint16   last_index;
+      buf[0] = rows + i * width;
+      buf[1] = buf[0] + width;
+      buf[2] = buf[1] + width;
 
-  if (xradius < 0 || yradius < 0)
-    {
-      g_warning ("border_region: negative radius specified.");
-      return;
+      compute_transition (seeds + i * width, buf, width, info->edge_lock);
     }
+}
 
-  /* A border without a width is no border at all; return an empty region. */
-  if (xradius == 0 || yradius == 0)
-    {
-      guchar color[] = "\0\0\0\0";
+static void
+border_write (BorderInfo *info,
+              gint        y,
+              gint        n_rows,
+              guchar     *mask)
+{
+  PixelRegion *src = info->src;
+  gint         i;
 
-      color_region (src, color);
-      return;
-    }
+  for (i = 0; i < n_rows; i++)
+    pixel_region_set_row (src, src->x, src->y + y + i, src->w,
+                          mask + i * src->w);
+}
 
-  /* optimize this case specifically */
-  if (xradius == 1 && yradius == 1)
+/*  The key of the nearest transition in column i at x, which is
+ *  ((dx - 0.5) / xradius)^2 + ((dy - 0.5) / yradius)^2 with the 0.5
+ *  left away for a distance of 0, times (2 * xradius * yradius)^2.
+ *  The density falls as the key grows, so the nearest transition by
+ *  the key has the largest density.  The keys are exact in doubles
+ *  for radii up to a few thousand pixels.
+ */
+static inline gdouble
+border_key (const BorderInfo *info,
+            const gint       *g,
+            gint              x,
+            gint              i)
+{
+  const gint dx = ABS (x - i);
+
+  return (dx ? info->xkey * SQR (2.0 * dx - 1.0) : 0.0) + info->ykeys[g[i]];
+}
+
+/*  The last x from @x on which is at least as near to column i as to
+ *  column u > i by the key, given that @x is.
+ */
+static gint
+border_separation (const BorderInfo *info,
+                   const gint       *g,
+                   gint              i,
+                   gint              u,
+                   gint              x)
+{
+  const gint width = info->src->w;
+  gint       end;
+  gint       step;
+
+  /*  step past it in growing steps, then bisect  */
+  for (step = 1; ; step *= 2)
     {
-      guchar *transition;
-      guchar *source[3];
+      end = x + step;
 
-      for (i = 0; i < 3; i++)
-        source[i] = g_new (guchar, src->w);
+      if (end >= width ||
+          border_key (info, g, end, i) > border_key (info, g, end, u))
+        break;
 
-      transition = g_new (guchar, src->w);
+      x = end;
+    }
 
-      /* With `edge_lock', initialize row above image as selected, otherwise,
-         initialize as unselected. */
-      memset (source[0], edge_lock ? 255 : 0, src->w);
+  end = MIN (end, width);
 
-      pixel_region_get_row (src, src->x, src->y + 0, src->w, source[1], 1);
+  while (end - x > 1)
+    {
+      const gint mid = (x + end) / 2;
 
-      if (src->h > 1)
-        pixel_region_get_row (src, src->x, src->y + 1, src->w, source[2], 1);
+      if (border_key (info, g, mid, i) > border_key (info, g, mid, u))
+        end = mid;
       else
-        memcpy (source[2], source[1], src->w);
+        x = mid;
+    }
 
-      compute_transition (transition, source, src->w, edge_lock);
-      pixel_region_set_row (src, src->x, src->y , src->w, transition);
+  return x;
+}
 
-      for (y = 1; y < src->h; y++)
+/*  Every pixel gets the density of the transition nearest to it by the
+ *  key, from the nearest transition in every column.  The keys of the
+ *  columns are translates of the same convex function, so like in
+ *  euclidean_band() of distance-transform.c, a lower envelope of the
+ *  columns finds the nearest one in linear time, whatever the radius.
+ *  Columns without a transition within yradius rows are left out.
+ */
+static void
+border_feather_band (BorderInfo *info,
+                     gint        band)
+{
+  const gint  width   = info->src->w;
+  const gint  yradius = info->yradius;
+  const gint  stride  = yradius + 2;
+  const gint  y_end   = MIN ((band + 1) * BORDER_BAND_HEIGHT, info->n_rows);
+  gint       *s       = g_new (gint, width);
+  gint       *t       = g_new (gint, width);
+  gint        y;
+
+  for (y = band * BORDER_BAND_HEIGHT; y < y_end; y++)
+    {
+      const gint *g   = info->columns + y * width;
+      guchar     *out = info->dest    + y * width;
+      gint        q   = -1;
+      gint        u;
+
+      /*  the columns on the lower envelope, s[q] nearest from t[q] on  */
+      for (u = 0; u < width; u++)
         {
-          rotate_pointers (source, 3);
+          if (g[u] > yradius)
+            continue;
 
-          if (y + 1 < src->h)
+          while (q >= 0 &&
+                 border_key (info, g, t[q], s[q]) >
+                 border_key (info, g, t[q], u))
+            q--;
+
+          if (q < 0)
             {
-              pixel_region_get_row (src, src->x, src->y + y + 1, src->w,
-                                    source[2], 1);
+              q = 0;
+              s[0] = u;
+              t[0] = 0;
             }
           else
             {
-              /* Depending on `edge_lock', set the row below the image as either
-                 selected or non-selected. */
-              memset(source[2], edge_lock ? 255 : 0, src->w);
+              const gint w = 1 + border_separation (info, g, s[q], u, t[q]);
+
+              if (w < width)
+                {
+                  q++;
+                  s[q] = u;
+                  t[q] = w;
+                }
             }
+        }
 
-          compute_transition (transition, source, src->w, edge_lock);
-          pixel_region_set_row (src, src->x, src->y + y, src->w, transition);
+      if (q < 0)
+        {
+          memset (out, 0, width);
+          continue;
         }
 
-      for (i = 0; i < 3; i++)
-        g_free (source[i]);
+      for (u = width - 1; u >= 0; u--)
+        {
+          const gint dx = ABS (u - s[q]);
 
-      g_free (transition);
+          out[u] = (dx <= info->xradius) ?
+                   info->density[dx * stride + g[s[q]]] : 0;
 
-      /* Finnished handling the radius = 1 special case, return here. */
-      return;
+          if (u == t[q])
+            q--;
+        }
     }
 
-  max = g_new (gint16, src->w + 2 * xradius);
+  g_free (s);
+  g_free (t);
+}
 
-  for (i = 0; i < (src->w + 2 * xradius); i++)
-    max[i] = yradius + 2;
+static void
+border_feather (BorderInfo *info,
+                gint        y,
+                gint        n_rows,
+                gint       *columns)
+{
+  info->columns = columns;
+  info->n_rows  = n_rows;
 
-  max += xradius;
+  pixel_processor_process_items ((PixelProcessorItemFunc)
+                                 border_feather_band,
+                                 info,
+                                 (n_rows + BORDER_BAND_HEIGHT - 1) /
+                                 BORDER_BAND_HEIGHT);
 
-  for (i = 0; i < 3; i++)
-    buf[i] = g_new (guchar, src->w);
+  border_write (info, y, n_rows, info->dest);
+}
 
-  transition = g_new (guchar *, yradius + 1);
+/*  Like shapeburst_region(), this reads the transitions of @src and
+ *  writes the border a chunk of rows at a time, so it needs only a
+ *  TILE_HEIGHT rows high stripe of @src in memory.
+ */
+void
+border_region (PixelRegion *src,
+               gint16       xradius,
+               gint16       yradius,
+               gboolean     feather,
+               gboolean     edge_lock)
+{
+  /*
+     This function has no bugs, but if you imagine some you can
+     blame them on jaycox@gimp.org
+  */
 
-  for (i = 0; i < yradius + 1; i++)
+  BorderInfo  info;
+
+  /* The density of the border at the offsets (x, y), for x from 0 to
+     xradius and y from 0 to yradius + 1, at density[x * (yradius + 2) + y].
+     Row yradius + 1 is 0, for the pixels which are further away. */
+  guchar     *density;
+
+  gint        x, y;
+
+  if (xradius < 0 || yradius < 0)
     {
-      transition[i] = g_new (guchar, src->w + 2 * xradius);
-      memset(transition[i], 0, src->w + 2 * xradius);
-      transition[i] += xradius;
+      g_warning ("border_region: negative radius specified.");
+      return;
     }
 
-  out = g_new (guchar, src->w);
+  /* A border without a width is no border at all; return an empty region. */
+  if (xradius == 0 || yradius == 0)
+    {
+      guchar color[] = "\0\0\0\0";
 
-  density = g_new (guchar *, 2 * xradius + 1);
-  density += xradius;
+      color_region (src, color);
+      return;
+    }
 
-   /* allocate density[][] */
-  for (x = 0; x < (xradius + 1); x++)
+  if (src->w < 1 || src->h < 1)
+    return;
+
+  memset (&info, 0, sizeof (BorderInfo));
+
+  info.src       = src;
+  info.edge_lock = edge_lock;
+  info.rows      = g_new (guchar, src->w * (TILE_HEIGHT + 2));
+  info.last      = g_new (guchar, src->w);
+  info.last_y    = -1;
+
+  /* optimize this case specifically */
+  if (xradius == 1 && yradius == 1)
     {
-      density[ x]  = g_new (guchar, 2 * yradius + 1);
-      density[ x] += yradius;
-      density[-x]  = density[x];
+      /*  the border is the transitions, each covering just itself  */
+      const gint height = 0;
+
+      distance_transform_dilate_chunked (src->w, src->h, &height, 0, FALSE,
+                                         (DistanceTransformReadFunc)
+                                         border_read,
+                                         (DistanceTransformWriteMaskFunc)
+                                         border_write,
+                                         &info);
+
+      g_free (info.rows);
+      g_free (info.last);
+
+      /* Finnished handling the radius = 1 special case, return here. */
+      return;
     }
 
+  density = g_new0 (guchar, (xradius + 1) * (yradius + 2));
+
   /* compute density[][] */
   for (x = 0; x < (xradius + 1); x++)
     {
@@ -3489,8 +3578,6 @@ border_region (PixelRegion *src,
 
       if (x > 0)
         tmpx = x - 0.5;
-      else if (x < 0)
-        tmpx = x + 0.5;
       else
         tmpx = 0.0;
 
@@ -3498,8 +3585,6 @@ border_region (PixelRegion *src,
         {
           if (y > 0)
             tmpy = y - 0.5;
-          else if (y < 0)
-            tmpy = y + 0.5;
           else
             tmpy = 0.0;
 
@@ -3518,191 +3603,62 @@ border_region (PixelRegion *src,
               a = 0;
             }
 
-          density[ x][ y] = a;
-          density[ x][-y] = a;
-          density[-x][ y] = a;
-          density[-x][-y] = a;
+          density[x * (yradius + 2) + y] = a;
         }
     }
 
-  /* Since the algorithm considerers `buf[0]' to be 'over' the row currently
-     calculated, we must start with `buf[0]' as non-selected if there is no
-     `edge_lock. If there is an 'edge_lock', initialize the first row to
-     'selected'. Refer to bug #350009. */
-  memset (buf[0], edge_lock ? 255 : 0, src->w);
-  pixel_region_get_row (src, src->x, src->y + 0, src->w, buf[1], 1);
-
-  if (src->h > 1)
-    pixel_region_get_row (src, src->x, src->y + 1, src->w, buf[2], 1);
-  else
-    memcpy (buf[2], buf[1], src->w);
-
-  compute_transition (transition[1], buf, src->w, edge_lock);
-
-   /* set up top of image */
-  for (y = 1; y < yradius && y + 1 < src->h; y++)
+  if (feather)
     {
-      rotate_pointers (buf, 3);
-      pixel_region_get_row (src, src->x, src->y + y + 1, src->w, buf[2], 1);
-      compute_transition (transition[y + 1], buf, src->w, edge_lock);
+      gdouble *ykeys = g_new (gdouble, yradius + 1);
+
+      for (y = 0; y < yradius + 1; y++)
+        ykeys[y] = y ? SQR (2.0 * y - 1.0) * SQR ((gdouble) xradius) : 0.0;
+
+      info.density = density;
+      info.ykeys   = ykeys;
+      info.xkey    = SQR ((gdouble) yradius);
+      info.xradius = xradius;
+      info.yradius = yradius;
+      info.dest    = g_new (guchar, src->w * TILE_HEIGHT);
+
+      distance_transform_columns_chunked (src->w, src->h, FALSE, yradius + 1,
+                                          (DistanceTransformReadFunc)
+                                          border_read,
+                                          (DistanceTransformWriteColsFunc)
+                                          border_feather,
+                                          &info);
+
+      g_free (info.dest);
+      g_free (ykeys);
     }
-
-  /* set up max[] for top of image */
-  for (x = 0; x < src->w; x++)
-    {
-      max[x] = -(yradius + 7);
-
-      for (j = 1; j < yradius + 1; j++)
-        if (transition[j][x])
-          {
-            max[x] = j;
-            break;
-          }
-    }
-
-  /* main calculation loop */
-  for (y = 0; y < src->h; y++)
+  else
     {
-      rotate_pointers (buf, 3);
-      rotate_pointers (transition, yradius + 1);
+      /*  the border is the ellipse around the transitions  */
+      gint *heights = g_new (gint, xradius + 1);
 
-      if (y < src->h - (yradius + 1))
-        {
-          pixel_region_get_row (src, src->x, src->y + y + yradius + 1, src->w,
-                                buf[2], 1);
-          compute_transition (transition[yradius], buf, src->w, edge_lock);
-        }
-      else
+      for (x = 0; x < xradius + 1; x++)
         {
-          if (edge_lock)
-            {
-              memcpy (transition[yradius], transition[yradius - 1], src->w);
-            }
-          else
-            {
-              /* No edge lock, set everything 'below canvas' as seen from the
-                 algorithm as unselected. */
-              memset (buf[2], 0, src->w);
-              compute_transition (transition[yradius], buf, src->w, edge_lock);
-            }
-        }
-
-       /* update max array */
-      for (x = 0; x < src->w; x++)
-        {
-          if (max[x] < 1)
-            {
-              if (max[x] <= -yradius)
-                {
-                  if (transition[yradius][x])
-                    max[x] = yradius;
-                  else
-                    max[x]--;
-                }
-              else
-                {
-                  if (transition[-max[x]][x])
-                    max[x] = -max[x];
-                  else if (transition[-max[x] + 1][x])
-                    max[x] = -max[x] + 1;
-                  else
-                    max[x]--;
-                }
-            }
-          else
-            {
-              max[x]--;
-            }
-
-          if (max[x] < -yradius - 1)
-            max[x] = -yradius - 1;
-        }
-
-      last_index = 1;
-
-       /* render scan line */
-      for (x = 0 ; x < src->w; x++)
-        {
-          guchar last_max;
-
-          last_index--;
-
-          if (last_index >= 0)
-            {
-              last_max = 0;
-
-              for (i = xradius; i >= 0; i--)
-                if (max[x + i] <= yradius && max[x + i] >= -yradius &&
-                    density[i][max[x+i]] > last_max)
-                  {
-                    last_max = density[i][max[x + i]];
-                    last_index = i;
-                  }
-
-              out[x] = last_max;
-            }
-          else
-            {
-              last_max = 0;
-
-              for (i = xradius; i >= -xradius; i--)
-                if (max[x + i] <= yradius && max[x + i] >= -yradius &&
-                    density[i][max[x + i]] > last_max)
-                  {
-                    last_max = density[i][max[x + i]];
-                    last_index = i;
-                  }
-
-              out[x] = last_max;
-            }
-
-          if (last_max == 0)
-            {
-              for (i = x + 1; i < src->w; i++)
-                {
-                  if (max[i] >= -yradius)
-                    break;
-                }
-
-              if (i - x > xradius)
-                {
-                  for (; x < i - xradius; x++)
-                    out[x] = 0;
-
-                  x--;
-                }
+          for (y = yradius; y > 0; y--)
+            if (density[x * (yradius + 2) + y])
+              break;
 
-              last_index = xradius;
-            }
+          heights[x] = y;
         }
 
-      pixel_region_set_row (src, src->x, src->y + y, src->w, out);
-    }
-
-  g_free (out);
-
-  for (i = 0; i < 3; i++)
-    g_free (buf[i]);
-
-  max -= xradius;
-  g_free (max);
+      distance_transform_dilate_chunked (src->w, src->h, heights, xradius,
+                                         FALSE,
+                                         (DistanceTransformReadFunc)
+                                         border_read,
+                                         (DistanceTransformWriteMaskFunc)
+                                         border_write,
+                                         &info);
 
-  for (i = 0; i < yradius + 1; i++)
-    {
-      transition[i] -= xradius;
-      g_free (transition[i]);
-    }
-
-  g_free (transition);
-
-  for (i = 0; i < xradius + 1 ; i++)
-    {
-      density[i] -= yradius;
-      g_free (density[i]);
+      g_free (heights);
     }
 
-  density -= xradius;
   g_free (density);
+  g_free (info.rows);
+  g_free (info.last);
 }
 
 void
@@ -4118,7 +4074,9 @@ combine_sub_region (struct combine_regions_struct *st,
   guchar               *buf;
   gboolean              opacity_quickskip_possible;
   gboolean              transparency_quickskip_possible;
+  gboolean              all_affected;
   TileRowHint           hint;
+  guchar                pixel[MAX_CHANNELS];
 
   opacity    = st->opacity;
   mode       = st->mode;
@@ -4143,6 +4101,46 @@ combine_sub_region (struct combine_regions_struct *st,
   transparency_quickskip_possible = (st->transparency_quickskip_possible &&
                                      src2->tiles);
 
+  /*  a transparent tile leaves everything as it is, and an opaque
+   *  uniform one in normal mode covers everything with its pixel
+   */
+  if (transparency_quickskip_possible &&
+      tile_is_transparent (src2->curtile))
+    {
+      if (G_UNLIKELY (tile_stats_active))
+        tile_stats_record_uniform_skip (src2->curtile);
+
+      return;
+    }
+
+  if (opacity_quickskip_possible              &&
+      type == COMBINE_INTEN_A_INTEN_A         &&
+      mode == GIMP_NORMAL_MODE                &&
+      tile_is_uniform (src2->curtile, pixel) &&
+      pixel[src2->bytes - 1] == OPAQUE_OPACITY)
+    {
+      d = dest->data;
+
+      for (h = 0; h < dest->h; h++)
+        {
+          guchar *p = d;
+          guint   w;
+
+          for (w = 0; w < dest->w; w++)
+            {
+              memcpy (p, pixel, dest->bytes);
+              p += dest->bytes;
+            }
+
+          d += dest->rowstride;
+        }
+
+      if (G_UNLIKELY (tile_stats_active))
+        tile_stats_record_uniform_skip (src2->curtile);
+
+      return;
+    }
+
   s1 = src1->data;
   s2 = src2->data;
   d = dest->data;
@@ -4173,6 +4171,14 @@ combine_sub_region (struct combine_regions_struct *st,
       m       = NULL;
     }
 
+  /*  the combine_pixels_funcs are specialised for all channels being
+   *  affected, which they usually are
+   */
+  all_affected = (affect != NULL);
+
+  for (h = 0; all_affected && h < src1->bytes; h++)
+    all_affected = affect[h];
+
   for (h = 0; h < src1->h; h++)
     {
       hint = TILEROWHINT_UNDEFINED;
@@ -4324,20 +4330,43 @@ combine_sub_region (struct combine_regions_struct *st,
             {
               memcpy (d, s, dest->w * dest->bytes);
             }
+          else if (all_affected)
+            {
+              CombinePixelsFunc func =
+                combine_pixels_funcs.inten_inten[src1->bytes - 1];
+
+              func (s1, s, d, m, opacity, src1->w);
+            }
           else
             combine_inten_and_inten_pixels (s1, s, d, m, opacity,
                                             affect, src1->w, src1->bytes);
           break;
 
         case COMBINE_INTEN_INTEN_A:
-          combine_inten_and_inten_a_pixels (s1, s, d, m, opacity,
-                                            affect, src1->w, src1->bytes);
+          if (all_affected)
+            {
+              CombinePixelsFunc func =
+                combine_pixels_funcs.inten_inten_a[src1->bytes - 1];
+
+              func (s1, s, d, m, opacity, src1->w);
+            }
+          else
+            combine_inten_and_inten_a_pixels (s1, s, d, m, opacity,
+                                              affect, src1->w, src1->bytes);
           break;
 
         case COMBINE_INTEN_A_INTEN:
-          combine_inten_a_and_inten_pixels (s1, s, d, m, opacity,
-                                            affect, mode_affect, src1->w,
-                                            src1->bytes);
+          if (all_affected)
+            {
+              CombinePixelsFunc func =
+                combine_pixels_funcs.inten_a_inten[mode_affect ? 1 : 0][src1->bytes - 1];
+
+              func (s1, s, d, m, opacity, src1->w);
+            }
+          else
+            combine_inten_a_and_inten_pixels (s1, s, d, m, opacity,
+                                              affect, mode_affect, src1->w,
+                                              src1->bytes);
           break;
 
         case COMBINE_INTEN_A_INTEN_A:
@@ -4346,6 +4375,13 @@ combine_sub_region (struct combine_regions_struct *st,
             {
               memcpy (d, s, dest->w * dest->bytes);
             }
+          else if (all_affected)
+            {
+              CombinePixelsFunc func =
+                combine_pixels_funcs.inten_a_inten_a[mode_affect ? 1 : 0][src1->bytes - 1];
+
+              func (s1, s, d, m, opacity, src1->w);
+            }
           else
             combine_inten_a_and_inten_a_pixels (s1, s, d, m, opacity,
                                                 affect, mode_affect,
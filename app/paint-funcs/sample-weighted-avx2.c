@@ -0,0 +1,118 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "sample-weighted.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#include <immintrin.h>
+
+
+#define AVX2_FUNC  __attribute__ ((target ("avx2")))
+
+
+/*  RGBA in one register, gray with alpha in half of one, with 1.0 in
+ *  the alpha lane like the SSE2 version.  Other formats are left to
+ *  the generic code.
+ */
+
+static AVX2_FUNC void
+sample_weighted_sum_avx2 (const guchar  *data,
+                          gint           rowstride,
+                          gint           bytes,
+                          gint           alpha,
+                          const gdouble *x_weights,
+                          const gdouble *y_weights,
+                          gint           taps,
+                          gdouble       *sums)
+{
+  gint i, j;
+
+  if (bytes == 4 && alpha == 3)
+    {
+      const __m256d one = _mm256_set1_pd (1.0);
+      __m256d       sum = _mm256_setzero_pd ();
+
+      for (j = 0; j < taps; j++, data += rowstride)
+        {
+          const guchar *s   = data;
+          __m256d       row = _mm256_setzero_pd ();
+
+          for (i = 0; i < taps; i++, s += 4)
+            {
+              const __m256d a = _mm256_set1_pd (x_weights[i] * s[3]);
+              gint32        pixel;
+              __m256d       p;
+
+              memcpy (&pixel, s, 4);
+
+              p = _mm256_cvtepi32_pd (_mm_cvtepu8_epi32 (_mm_cvtsi32_si128 (pixel)));
+              p = _mm256_blend_pd (p, one, 0x8);
+
+              row = _mm256_add_pd (row, _mm256_mul_pd (a, p));
+            }
+
+          sum = _mm256_add_pd (sum,
+                               _mm256_mul_pd (_mm256_set1_pd (y_weights[j]),
+                                              row));
+        }
+
+      _mm256_storeu_pd (sums, sum);
+    }
+  else if (bytes == 2 && alpha == 1)
+    {
+      __m128d sum = _mm_setzero_pd ();
+
+      for (j = 0; j < taps; j++, data += rowstride)
+        {
+          const guchar *s   = data;
+          __m128d       row = _mm_setzero_pd ();
+
+          for (i = 0; i < taps; i++, s += 2)
+            {
+              const __m128d a = _mm_set1_pd (x_weights[i] * s[1]);
+
+              row = _mm_add_pd (row, _mm_mul_pd (a, _mm_set_pd (1.0, s[0])));
+            }
+
+          sum = _mm_add_pd (sum, _mm_mul_pd (_mm_set1_pd (y_weights[j]), row));
+        }
+
+      _mm_storeu_pd (sums, sum);
+    }
+  else
+    {
+      sample_weighted_generic_funcs.sum (data, rowstride, bytes, alpha,
+                                         x_weights, y_weights, taps, sums);
+    }
+}
+
+void
+sample_weighted_avx2_install (SampleWeightedFuncs *funcs)
+{
+  funcs->sum = sample_weighted_sum_avx2;
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
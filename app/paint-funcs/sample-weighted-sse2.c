@@ -0,0 +1,127 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "sample-weighted.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+
+#include <emmintrin.h>
+
+
+#define SSE2_FUNC  __attribute__ ((target ("sse2")))
+
+
+/*  Gray with alpha in one register, RGBA in two, the alpha lane of a
+ *  pixel is 1.0, so weighting it by x_weights[i] * alpha adds the
+ *  same to the alpha sum as to the premultiplied colors.  Other
+ *  formats are left to the generic code.
+ */
+
+static SSE2_FUNC void
+sample_weighted_sum_sse2 (const guchar  *data,
+                          gint           rowstride,
+                          gint           bytes,
+                          gint           alpha,
+                          const gdouble *x_weights,
+                          const gdouble *y_weights,
+                          gint           taps,
+                          gdouble       *sums)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128d one  = _mm_set1_pd (1.0);
+  __m128d       sum0 = _mm_setzero_pd ();
+  __m128d       sum1 = _mm_setzero_pd ();
+  gint          i, j;
+
+  if (bytes == 4 && alpha == 3)
+    {
+      for (j = 0; j < taps; j++, data += rowstride)
+        {
+          const guchar  *s    = data;
+          const __m128d  w    = _mm_set1_pd (y_weights[j]);
+          __m128d        row0 = _mm_setzero_pd ();
+          __m128d        row1 = _mm_setzero_pd ();
+
+          for (i = 0; i < taps; i++, s += 4)
+            {
+              const __m128d a = _mm_set1_pd (x_weights[i] * s[3]);
+              gint32        pixel;
+              __m128i       p;
+
+              memcpy (&pixel, s, 4);
+
+              p = _mm_unpacklo_epi16 (_mm_unpacklo_epi8 (_mm_cvtsi32_si128 (pixel),
+                                                         zero),
+                                      zero);
+
+              row0 = _mm_add_pd (row0, _mm_mul_pd (a, _mm_cvtepi32_pd (p)));
+              row1 = _mm_add_pd (row1,
+                                 _mm_mul_pd (a,
+                                             _mm_unpacklo_pd (_mm_cvtepi32_pd (_mm_srli_si128 (p, 8)),
+                                                              one)));
+            }
+
+          sum0 = _mm_add_pd (sum0, _mm_mul_pd (w, row0));
+          sum1 = _mm_add_pd (sum1, _mm_mul_pd (w, row1));
+        }
+
+      _mm_storeu_pd (sums,     sum0);
+      _mm_storeu_pd (sums + 2, sum1);
+    }
+  else if (bytes == 2 && alpha == 1)
+    {
+      for (j = 0; j < taps; j++, data += rowstride)
+        {
+          const guchar *s   = data;
+          __m128d       row = _mm_setzero_pd ();
+
+          for (i = 0; i < taps; i++, s += 2)
+            {
+              const __m128d a = _mm_set1_pd (x_weights[i] * s[1]);
+
+              row = _mm_add_pd (row, _mm_mul_pd (a, _mm_set_pd (1.0, s[0])));
+            }
+
+          sum0 = _mm_add_pd (sum0, _mm_mul_pd (_mm_set1_pd (y_weights[j]),
+                                               row));
+        }
+
+      _mm_storeu_pd (sums, sum0);
+    }
+  else
+    {
+      sample_weighted_generic_funcs.sum (data, rowstride, bytes, alpha,
+                                         x_weights, y_weights, taps, sums);
+    }
+}
+
+
+void
+sample_weighted_sse2_install (SampleWeightedFuncs *funcs)
+{
+  funcs->sum = sample_weighted_sum_sse2;
+}
+
+#endif /* HAVE_SSE2_INTRINSICS */
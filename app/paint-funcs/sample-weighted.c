@@ -0,0 +1,103 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  The footprint sum of the linear, cubic and lanczos samplers of
+ *  gimp-transform-region.c, computed once per destination pixel.  The
+ *  accelerated versions in sample-weighted-sse2.c and
+ *  sample-weighted-avx2.c sum the channels of a pixel side by side and
+ *  have to match the generic one bit for bit;
+ *  app/tests/test-sample-weighted.c checks that.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "base/accel-funcs.h"
+
+#include "sample-weighted.h"
+
+
+static void  sample_weighted_sum (const guchar  *data,
+                                  gint           rowstride,
+                                  gint           bytes,
+                                  gint           alpha,
+                                  const gdouble *x_weights,
+                                  const gdouble *y_weights,
+                                  gint           taps,
+                                  gdouble       *sums);
+
+
+const SampleWeightedFuncs sample_weighted_generic_funcs =
+{
+  sample_weighted_sum
+};
+
+SampleWeightedFuncs sample_weighted_funcs;
+
+
+/*  public functions  */
+
+void
+sample_weighted_init (guint accel)
+{
+  accel_funcs_init (&sample_weighted_funcs, &sample_weighted_generic_funcs,
+                    sizeof (SampleWeightedFuncs), accel,
+                    ACCEL_SSE2 (sample_weighted_sse2_install),
+                    ACCEL_AVX2 (sample_weighted_avx2_install));
+}
+
+
+/*  private functions  */
+
+static void
+sample_weighted_sum (const guchar  *data,
+                     gint           rowstride,
+                     gint           bytes,
+                     gint           alpha,
+                     const gdouble *x_weights,
+                     const gdouble *y_weights,
+                     gint           taps,
+                     gdouble       *sums)
+{
+  gint b, i, j;
+
+  for (b = 0; b <= alpha; b++)
+    sums[b] = 0.0;
+
+  for (j = 0; j < taps; j++, data += rowstride)
+    {
+      const guchar *s = data;
+      gdouble       row[MAX_CHANNELS] = { 0.0, };
+
+      for (i = 0; i < taps; i++, s += bytes)
+        {
+          const gdouble a = x_weights[i] * s[alpha];
+
+          /*  never entered for alpha == 0  */
+          for (b = 0; b < alpha; b++)
+            row[b] += a * s[b];
+
+          row[alpha] += a;
+        }
+
+      for (b = 0; b <= alpha; b++)
+        sums[b] += y_weights[j] * row[b];
+    }
+}
@@ -0,0 +1,61 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SAMPLE_WEIGHTED_H__
+#define __SAMPLE_WEIGHTED_H__
+
+
+/*  The weighted sums of the color channels, premultiplied by alpha,
+ *  and of alpha itself over the @taps x @taps pixels at @data, with
+ *  the weights of the columns and rows.  @alpha is the alpha channel,
+ *  0 for single channel data, which is summed as alpha.  Every row is
+ *  summed on its own first, then weighted into @sums.
+ */
+typedef void (* SampleWeightedFunc) (const guchar  *data,
+                                     gint           rowstride,
+                                     gint           bytes,
+                                     gint           alpha,
+                                     const gdouble *x_weights,
+                                     const gdouble *y_weights,
+                                     gint           taps,
+                                     gdouble       *sums);
+
+
+typedef struct _SampleWeightedFuncs SampleWeightedFuncs;
+
+struct _SampleWeightedFuncs
+{
+  SampleWeightedFunc  sum;
+};
+
+
+/*  the implementations in use, see base/accel-funcs.h  */
+extern SampleWeightedFuncs sample_weighted_funcs;
+
+
+void   sample_weighted_init (guint accel);
+
+
+/*  for the weighted sample implementations only  */
+
+extern const SampleWeightedFuncs sample_weighted_generic_funcs;
+
+void   sample_weighted_sse2_install (SampleWeightedFuncs *funcs);
+void   sample_weighted_avx2_install (SampleWeightedFuncs *funcs);
+
+
+#endif  /*  __SAMPLE_WEIGHTED_H__  */
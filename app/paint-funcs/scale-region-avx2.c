@@ -0,0 +1,231 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "scale-region.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#include <immintrin.h>
+
+
+#define AVX2_FUNC  __attribute__ ((target ("avx2")))
+
+
+/*  Rounds four sums to 32 bit integers, like CLAMP() to 0 to 255 of
+ *  RINT(), floor (x + 0.5), does.  Clamping first doesn't change the
+ *  result, and makes x + 0.5 positive, so truncating it is floor().
+ */
+#define ROUND_4(v) \
+  _mm256_cvttpd_epi32 (_mm256_add_pd (_mm256_min_pd (_mm256_max_pd ((v), \
+                                                                    _mm256_setzero_pd ()), \
+                                                     _mm256_set1_pd (255.0)), \
+                                      _mm256_set1_pd (0.5)))
+
+
+/*  4 destination columns at a time, the tails are left to the generic
+ *  code
+ */
+
+static AVX2_FUNC void
+scale_filter_avx2 (const gdouble *plane,
+                   const gint    *index,
+                   const gdouble *weights,
+                   gint           taps,
+                   gdouble       *out,
+                   gint           n)
+{
+  const __m128i columns = _mm_setr_epi32 (0, taps, 2 * taps, 3 * taps);
+  gint          i;
+
+  for (i = 0; i + 4 <= n; i += 4)
+    {
+      const __m128i  pixels = _mm_loadu_si128 ((const __m128i *) (index + i));
+      const gdouble *w      = weights + i * taps;
+      __m256d        sum    = _mm256_setzero_pd ();
+      gint           k;
+
+      for (k = 0; k < taps; k++)
+        sum = _mm256_add_pd (sum,
+                             _mm256_mul_pd (_mm256_i32gather_pd (w + k,
+                                                                 columns, 8),
+                                            _mm256_i32gather_pd (plane + k,
+                                                                 pixels, 8)));
+
+      _mm256_storeu_pd (out + i, sum);
+    }
+
+  if (i < n)
+    scale_region_generic_funcs.filter (plane, index + i, weights + i * taps,
+                                       taps, out + i, n - i);
+}
+
+static AVX2_FUNC void
+scale_accumulate_avx2 (gdouble       *sums,
+                       const gdouble *row,
+                       gdouble        weight,
+                       gint           n)
+{
+  const __m256d w = _mm256_set1_pd (weight);
+  gint          i;
+
+  for (i = 0; i + 8 <= n; i += 8)
+    {
+      __m256d s0 = _mm256_loadu_pd (sums + i);
+      __m256d s1 = _mm256_loadu_pd (sums + i + 4);
+
+      s0 = _mm256_add_pd (s0, _mm256_mul_pd (w, _mm256_loadu_pd (row + i)));
+      s1 = _mm256_add_pd (s1, _mm256_mul_pd (w, _mm256_loadu_pd (row + i + 4)));
+
+      _mm256_storeu_pd (sums + i,     s0);
+      _mm256_storeu_pd (sums + i + 4, s1);
+    }
+
+  if (i < n)
+    scale_region_generic_funcs.accumulate (sums + i, row + i, weight, n - i);
+}
+
+static AVX2_FUNC void
+scale_store_avx2 (const gdouble *sums,
+                  gint           stride,
+                  gint           bytes,
+                  gint           width,
+                  guchar        *dest)
+{
+  const gint alpha = (bytes == 2 || bytes == 4) ? bytes - 1 : bytes;
+  gint       x     = 0;
+
+  if (bytes == 1)
+    {
+      for (; x + 16 <= width; x += 16)
+        {
+          const __m128i d0 = _mm_packs_epi32 (ROUND_4 (_mm256_loadu_pd (sums + x)),
+                                              ROUND_4 (_mm256_loadu_pd (sums + x + 4)));
+          const __m128i d1 = _mm_packs_epi32 (ROUND_4 (_mm256_loadu_pd (sums + x + 8)),
+                                              ROUND_4 (_mm256_loadu_pd (sums + x + 12)));
+
+          _mm_storeu_si128 ((__m128i *) (dest + x), _mm_packus_epi16 (d0, d1));
+        }
+    }
+  else
+    {
+      for (; x + 4 <= width; x += 4)
+        {
+          __m128i c[4];
+          __m128i t0, t1, t2, t3;
+          __m128i d;
+          gint    b;
+
+          if (alpha < bytes)
+            {
+              const __m256d a    = _mm256_loadu_pd (sums + alpha * stride + x);
+              const __m256d mask = _mm256_cmp_pd (a, _mm256_setzero_pd (),
+                                                  _CMP_GT_OQ);
+
+              /*  the colors of transparent pixels are 0, masking the
+               *  quotients also drops those of the divisions by 0
+               */
+              for (b = 0; b < alpha; b++)
+                {
+                  const __m256d q =
+                    _mm256_div_pd (_mm256_loadu_pd (sums + b * stride + x), a);
+
+                  c[b] = ROUND_4 (_mm256_and_pd (q, mask));
+                }
+
+              c[alpha] = ROUND_4 (a);
+            }
+          else
+            {
+              for (b = 0; b < bytes; b++)
+                c[b] = ROUND_4 (_mm256_loadu_pd (sums + b * stride + x));
+            }
+
+          /*  interleave the channels  */
+          switch (bytes)
+            {
+            case 2:
+              d = _mm_packs_epi32 (_mm_unpacklo_epi32 (c[0], c[1]),
+                                   _mm_unpackhi_epi32 (c[0], c[1]));
+
+              _mm_storel_epi64 ((__m128i *) (dest + x * 2),
+                                _mm_packus_epi16 (d, d));
+              break;
+
+            case 3:
+              c[3] = _mm_setzero_si128 ();
+              /*  fall through  */
+
+            case 4:
+              t0 = _mm_unpacklo_epi32 (c[0], c[1]);
+              t1 = _mm_unpacklo_epi32 (c[2], c[3]);
+              t2 = _mm_unpackhi_epi32 (c[0], c[1]);
+              t3 = _mm_unpackhi_epi32 (c[2], c[3]);
+
+              t0 = _mm_packs_epi32 (_mm_unpacklo_epi64 (t0, t1),
+                                    _mm_unpackhi_epi64 (t0, t1));
+              t2 = _mm_packs_epi32 (_mm_unpacklo_epi64 (t2, t3),
+                                    _mm_unpackhi_epi64 (t2, t3));
+              d  = _mm_packus_epi16 (t0, t2);
+
+              if (bytes == 4)
+                {
+                  _mm_storeu_si128 ((__m128i *) (dest + x * 4), d);
+                }
+              else
+                {
+                  gint32 last;
+
+                  /*  drop the fourth bytes, the 12 left are stored as
+                   *  8 and 4
+                   */
+                  d = _mm_shuffle_epi8 (d, _mm_setr_epi8 (0, 1, 2, 4, 5, 6,
+                                                          8, 9, 10, 12, 13, 14,
+                                                          -1, -1, -1, -1));
+
+                  last = _mm_cvtsi128_si32 (_mm_srli_si128 (d, 8));
+
+                  _mm_storel_epi64 ((__m128i *) (dest + x * 3), d);
+                  memcpy (dest + x * 3 + 8, &last, 4);
+                }
+              break;
+            }
+        }
+    }
+
+  if (x < width)
+    scale_region_generic_funcs.store (sums + x, stride, bytes, width - x,
+                                      dest + x * bytes);
+}
+
+
+void
+scale_region_avx2_install (ScaleRegionFuncs *funcs)
+{
+  funcs->filter     = scale_filter_avx2;
+  funcs->accumulate = scale_accumulate_avx2;
+  funcs->store      = scale_store_avx2;
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
@@ -0,0 +1,205 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "paint-funcs-types.h"
+
+#include "scale-region.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+
+#include <emmintrin.h>
+
+
+#define SSE2_FUNC  __attribute__ ((target ("sse2")))
+
+
+/*  Rounds two sums to 32 bit integers in the low half, like CLAMP()
+ *  to 0 to 255 of RINT(), floor (x + 0.5), does.  Clamping first
+ *  doesn't change the result, and makes x + 0.5 positive, so
+ *  truncating it is floor().
+ */
+#define ROUND_2(v) \
+  _mm_cvttpd_epi32 (_mm_add_pd (_mm_min_pd (_mm_max_pd ((v), \
+                                                        _mm_setzero_pd ()), \
+                                            _mm_set1_pd (255.0)), \
+                                _mm_set1_pd (0.5)))
+
+/*  four sums from @p on  */
+#define ROUND_4(p) \
+  _mm_unpacklo_epi64 (ROUND_2 (_mm_loadu_pd (p)), \
+                      ROUND_2 (_mm_loadu_pd ((p) + 2)))
+
+
+/*  2 destination columns at a time, the tails are left to the generic
+ *  code
+ */
+
+static SSE2_FUNC void
+scale_filter_sse2 (const gdouble *plane,
+                   const gint    *index,
+                   const gdouble *weights,
+                   gint           taps,
+                   gdouble       *out,
+                   gint           n)
+{
+  gint i;
+
+  for (i = 0; i + 2 <= n; i += 2)
+    {
+      const gdouble *p0  = plane + index[i];
+      const gdouble *p1  = plane + index[i + 1];
+      const gdouble *w0  = weights + i * taps;
+      const gdouble *w1  = w0 + taps;
+      __m128d        sum = _mm_setzero_pd ();
+      gint           k;
+
+      for (k = 0; k < taps; k++)
+        {
+          const __m128d w = _mm_loadh_pd (_mm_load_sd (w0 + k), w1 + k);
+          const __m128d p = _mm_loadh_pd (_mm_load_sd (p0 + k), p1 + k);
+
+          sum = _mm_add_pd (sum, _mm_mul_pd (w, p));
+        }
+
+      _mm_storeu_pd (out + i, sum);
+    }
+
+  if (i < n)
+    scale_region_generic_funcs.filter (plane, index + i, weights + i * taps,
+                                       taps, out + i, n - i);
+}
+
+static SSE2_FUNC void
+scale_accumulate_sse2 (gdouble       *sums,
+                       const gdouble *row,
+                       gdouble        weight,
+                       gint           n)
+{
+  const __m128d w = _mm_set1_pd (weight);
+  gint          i;
+
+  for (i = 0; i + 4 <= n; i += 4)
+    {
+      __m128d s0 = _mm_loadu_pd (sums + i);
+      __m128d s1 = _mm_loadu_pd (sums + i + 2);
+
+      s0 = _mm_add_pd (s0, _mm_mul_pd (w, _mm_loadu_pd (row + i)));
+      s1 = _mm_add_pd (s1, _mm_mul_pd (w, _mm_loadu_pd (row + i + 2)));
+
+      _mm_storeu_pd (sums + i,     s0);
+      _mm_storeu_pd (sums + i + 2, s1);
+    }
+
+  if (i < n)
+    scale_region_generic_funcs.accumulate (sums + i, row + i, weight, n - i);
+}
+
+/*  1, 2 and 4 bytes, RGB is left to the generic code  */
+
+static SSE2_FUNC void
+scale_store_sse2 (const gdouble *sums,
+                  gint           stride,
+                  gint           bytes,
+                  gint           width,
+                  guchar        *dest)
+{
+  gint x = 0;
+
+  if (bytes == 1)
+    {
+      for (; x + 8 <= width; x += 8)
+        {
+          const __m128i d = _mm_packs_epi32 (ROUND_4 (sums + x),
+                                             ROUND_4 (sums + x + 4));
+
+          _mm_storel_epi64 ((__m128i *) (dest + x), _mm_packus_epi16 (d, d));
+        }
+    }
+  else if (bytes == 2 || bytes == 4)
+    {
+      const gint alpha = bytes - 1;
+
+      for (; x + 4 <= width; x += 4)
+        {
+          const gdouble *a       = sums + alpha * stride + x;
+          const __m128d  a_lo    = _mm_loadu_pd (a);
+          const __m128d  a_hi    = _mm_loadu_pd (a + 2);
+          const __m128d  mask_lo = _mm_cmpgt_pd (a_lo, _mm_setzero_pd ());
+          const __m128d  mask_hi = _mm_cmpgt_pd (a_hi, _mm_setzero_pd ());
+          __m128i        c[4];
+          gint           b;
+
+          /*  the colors of transparent pixels are 0, masking the
+           *  quotients also drops those of the divisions by 0
+           */
+          for (b = 0; b < alpha; b++)
+            {
+              const gdouble *s  = sums + b * stride + x;
+              const __m128d  lo = _mm_div_pd (_mm_loadu_pd (s), a_lo);
+              const __m128d  hi = _mm_div_pd (_mm_loadu_pd (s + 2), a_hi);
+
+              c[b] = _mm_unpacklo_epi64 (ROUND_2 (_mm_and_pd (lo, mask_lo)),
+                                         ROUND_2 (_mm_and_pd (hi, mask_hi)));
+            }
+
+          c[alpha] = ROUND_4 (a);
+
+          /*  interleave the channels  */
+          if (bytes == 2)
+            {
+              const __m128i d = _mm_packs_epi32 (_mm_unpacklo_epi32 (c[0], c[1]),
+                                                 _mm_unpackhi_epi32 (c[0], c[1]));
+
+              _mm_storel_epi64 ((__m128i *) (dest + x * 2),
+                                _mm_packus_epi16 (d, d));
+            }
+          else
+            {
+              __m128i t0 = _mm_unpacklo_epi32 (c[0], c[1]);
+              __m128i t1 = _mm_unpacklo_epi32 (c[2], c[3]);
+              __m128i t2 = _mm_unpackhi_epi32 (c[0], c[1]);
+              __m128i t3 = _mm_unpackhi_epi32 (c[2], c[3]);
+
+              t0 = _mm_packs_epi32 (_mm_unpacklo_epi64 (t0, t1),
+                                    _mm_unpackhi_epi64 (t0, t1));
+              t2 = _mm_packs_epi32 (_mm_unpacklo_epi64 (t2, t3),
+                                    _mm_unpackhi_epi64 (t2, t3));
+
+              _mm_storeu_si128 ((__m128i *) (dest + x * 4),
+                                _mm_packus_epi16 (t0, t2));
+            }
+        }
+    }
+
+  if (x < width)
+    scale_region_generic_funcs.store (sums + x, stride, bytes, width - x,
+                                      dest + x * bytes);
+}
+
+void
+scale_region_sse2_install (ScaleRegionFuncs *funcs)
+{
+  funcs->filter     = scale_filter_sse2;
+  funcs->accumulate = scale_accumulate_sse2;
+  funcs->store      = scale_store_sse2;
+}
+
+#endif /* HAVE_SSE2_INTRINSICS */
@@ -15,6 +15,21 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/*  Every step of the scaling, the decimation ones included, runs on
+ *  the pixel processor one destination tile at a time.  A tile reads
+ *  the source pixels it needs into a buffer first, with the edges
+ *  smeared, so the threads only share the tile locking.
+ *
+ *  Interpolation is separable: the source rows are filtered
+ *  horizontally into a ring of rows, which are then combined
+ *  vertically.  The source columns and rows of every destination
+ *  column and row, and their weights, are computed once per step.
+ *  The row kernels are called through scale_region_funcs, the
+ *  accelerated ones in scale-region-sse2.c and scale-region-avx2.c
+ *  have to match them bit for bit, app/tests/test-scale-region.c
+ *  checks that.
+ */
+
 #include "config.h"
 
 #include <string.h>
@@ -25,10 +40,11 @@
 
 #include "paint-funcs-types.h"
 
+#include "base/accel-funcs.h"
+#include "base/pixel-processor.h"
+#include "base/pixel-region.h"
 #include "base/tile.h"
 #include "base/tile-manager.h"
-#include "base/pixel-region.h"
-#include "base/pixel-surround.h"
 
 #include "paint-funcs.h"
 #include "scale-region.h"
@@ -39,6 +55,40 @@
 #define NUM_TILES(w,h) ((((w) + (TILE_WIDTH - 1)) / TILE_WIDTH) *  \
                         (((h) + (TILE_HEIGHT - 1)) / TILE_HEIGHT))
 
+/*  the widest kernel, lanczos3  */
+#define MAX_TAPS  6
+
+
+typedef struct
+{
+  TileManager           *src;
+  gint                   bytes;
+
+  /*  decimate(), averages factor_x * factor_y source pixels  */
+  gint                   factor_x;
+  gint                   factor_y;
+
+  /*  scale(), destination column x is made of the taps source columns
+   *  from x_index[x] on, weighted by x_weights[x * taps] and on, and
+   *  the same for the rows
+   */
+  GimpInterpolationType  interpolation;
+  gint                   taps;
+  gint                  *x_index;
+  gdouble               *x_weights;
+  gint                  *y_index;
+  gdouble               *y_weights;
+} ScaleInfo;
+
+typedef struct
+{
+  GimpProgressFunc  callback;
+  gpointer          data;
+  gint              progress;      /*  tiles of the finished steps  */
+  gint              max_progress;
+  gint              step;          /*  tiles of the running step    */
+} ScaleProgress;
+
 
 static void           scale_determine_levels   (PixelRegion           *srcPR,
                                                 PixelRegion           *dstPR,
@@ -59,77 +109,60 @@ static void           scale_region_tile        (PixelRegion           *srcPR,
 static void           scale                    (TileManager           *srcTM,
                                                 TileManager           *dstTM,
                                                 GimpInterpolationType  interpolation,
-                                                GimpProgressFunc       progress_callback,
-                                                gpointer               progress_data,
-                                                gint                  *progress,
-                                                gint                   max_progress,
+                                                ScaleProgress         *progress,
                                                 const gdouble          scalex,
                                                 const gdouble          scaley);
-static void           decimate_xy              (TileManager           *srcTM,
-                                                TileManager           *dstTM,
-                                                GimpInterpolationType  interpolation,
-                                                GimpProgressFunc       progress_callback,
-                                                gpointer               progress_data,
-                                                gint                  *progress,
-                                                gint                   max_progress);
-static void           decimate_x               (TileManager           *srcTM,
+static void           decimate                 (TileManager           *srcTM,
                                                 TileManager           *dstTM,
-                                                GimpInterpolationType  interpolation,
-                                                GimpProgressFunc       progress_callback,
-                                                gpointer               progress_data,
-                                                gint                  *progress,
-                                                gint                   max_progress);
-static void           decimate_y               (TileManager           *srcTM,
+                                                gint                   factor_x,
+                                                gint                   factor_y,
+                                                ScaleProgress         *progress);
+static void           scale_run                (ScaleInfo             *info,
                                                 TileManager           *dstTM,
-                                                GimpInterpolationType  interpolation,
-                                                GimpProgressFunc       progress_callback,
-                                                gpointer               progress_data,
-                                                gint                  *progress,
-                                                gint                   max_progress);
-static void           decimate_average_xy      (PixelSurround *surround,
-                                                const gint     x0,
-                                                const gint     y0,
-                                                const gint     bytes,
-                                                guchar        *pixel);
-static void           decimate_average_y       (PixelSurround *surround,
-                                                const gint     x0,
-                                                const gint     y0,
-                                                const gint     bytes,
-                                                guchar        *pixel);
-static void           decimate_average_x       (PixelSurround *surround,
-                                                const gint     x0,
-                                                const gint     y0,
-                                                const gint     bytes,
-                                                guchar        *pixel);
-static void           interpolate_nearest      (TileManager   *srcTM,
-                                                const gint     x0,
-                                                const gint     y0,
-                                                const gdouble  xfrac,
-                                                const gdouble  yfrac,
-                                                guchar        *pixel);
-static void           interpolate_bilinear     (PixelSurround *surround,
-                                                const gint     x0,
-                                                const gint     y0,
-                                                const gdouble  xfrac,
-                                                const gdouble  yfrac,
-                                                const gint     bytes,
-                                                guchar        *pixel);
-static void           interpolate_cubic        (PixelSurround *surround,
-                                                const gint     x0,
-                                                const gint     y0,
-                                                const gdouble  xfrac,
-                                                const gdouble  yfrac,
-                                                const gint     bytes,
-                                                guchar        *pixel);
+                                                PixelProcessorFunc     func,
+                                                ScaleProgress         *progress);
+static void           scale_progress           (ScaleProgress         *progress,
+                                                gdouble                fraction);
+static guchar *       scale_read_source        (TileManager           *srcTM,
+                                                gint                   x,
+                                                gint                   y,
+                                                gint                   width,
+                                                gint                   height);
+static void           scale_compute_weights    (GimpInterpolationType  interpolation,
+                                                gint                   taps,
+                                                const gfloat          *kernel_lookup,
+                                                gdouble                scale,
+                                                gint                   n,
+                                                gint                  *index,
+                                                gdouble               *weights);
+static void           scale_tile               (ScaleInfo             *info,
+                                                PixelRegion           *destPR);
+static void           scale_filter_row         (ScaleInfo             *info,
+                                                const guchar          *src,
+                                                gint                   src_x,
+                                                gint                   src_width,
+                                                gint                   x,
+                                                gint                   width,
+                                                gdouble               *planes,
+                                                gdouble               *row);
+static void           scale_filter             (const gdouble         *plane,
+                                                const gint            *index,
+                                                const gdouble         *weights,
+                                                gint                   taps,
+                                                gdouble               *out,
+                                                gint                   n);
+static void           scale_accumulate         (gdouble               *sums,
+                                                const gdouble         *row,
+                                                gdouble                weight,
+                                                gint                   n);
+static void           scale_store_row          (const gdouble         *sums,
+                                                gint                   stride,
+                                                gint                   bytes,
+                                                gint                   width,
+                                                guchar                *dest);
+static void           decimate_tile            (ScaleInfo             *info,
+                                                PixelRegion           *destPR);
 static gfloat *       create_lanczos3_lookup   (void);
-static void           interpolate_lanczos3     (PixelSurround *surround,
-                                                const gint     x0,
-                                                const gint     y0,
-                                                const gdouble  xfrac,
-                                                const gdouble  yfrac,
-                                                const gint     bytes,
-                                                guchar        *pixel,
-                                                const gfloat  *kernel_lookup);
 static void           interpolate_bilinear_pr  (PixelRegion   *srcPR,
                                                 const gint     x0,
                                                 const gint     y0,
@@ -138,11 +171,6 @@ static void           interpolate_bilinear_pr  (PixelRegion   *srcPR,
                                                 const gdouble  xfrac,
                                                 const gdouble  yfrac,
                                                 guchar        *pixel);
-static inline gdouble cubic_spline_fit         (const gdouble  dx,
-                                                const gdouble  x1,
-                                                const gdouble  y1,
-                                                const gdouble  x2,
-                                                const gdouble  y2);
 static inline gdouble weighted_sum             (const gdouble  dx,
                                                 const gdouble  dy,
                                                 const gint     s00,
@@ -150,20 +178,26 @@ static inline gdouble weighted_sum             (const gdouble  dx,
                                                 const gint     s01,
                                                 const gint     s11);
 static inline gdouble sinc                     (const gdouble  x);
-static inline gdouble lanczos3_mul_alpha       (const guchar  *pixels,
-                                                const gdouble *x_kernel,
-                                                const gdouble *y_kernel,
-                                                const gint     stride,
-                                                const gint     bytes,
-                                                const gint     byte);
-static inline gdouble lanczos3_mul             (const guchar  *pixels,
-                                                const gdouble *x_kernel,
-                                                const gdouble *y_kernel,
-                                                const gint     stride,
-                                                const gint     bytes,
-                                                const gint     byte);
 
 
+const ScaleRegionFuncs scale_region_generic_funcs =
+{
+  scale_filter,
+  scale_accumulate,
+  scale_store_row
+};
+
+ScaleRegionFuncs scale_region_funcs;
+
+
+void
+scale_region_init (guint accel)
+{
+  accel_funcs_init (&scale_region_funcs, &scale_region_generic_funcs,
+                    sizeof (ScaleRegionFuncs), accel,
+                    ACCEL_SSE2 (scale_region_sse2_install),
+                    ACCEL_AVX2 (scale_region_avx2_install));
+}
 
 void
 scale_region (PixelRegion           *srcPR,
@@ -280,18 +314,18 @@ scale_region_tile (PixelRegion           *srcPR,
                    GimpProgressFunc       progress_callback,
                    gpointer               progress_data)
 {
-  TileManager *tmpTM        = NULL;
-  TileManager *srcTM        = srcPR->tiles;
-  TileManager *dstTM        = dstPR->tiles;
-  gint         width        = srcPR->w;
-  gint         height       = srcPR->h;
-  gint         bytes        = srcPR->bytes;
-  gint         max_progress = 0;
-  gint         progress     = 0;
-  gint         levelx       = 0;
-  gint         levely       = 0;
-  gdouble      scalex       = (gdouble) width / dstPR->w;
-  gdouble      scaley       = (gdouble) height / dstPR->h;
+  TileManager   *tmpTM    = NULL;
+  TileManager   *srcTM    = srcPR->tiles;
+  TileManager   *dstTM    = dstPR->tiles;
+  ScaleProgress  progress = { progress_callback, progress_data, 0, };
+  ScaleProgress *p        = progress_callback ? &progress : NULL;
+  gint           width    = srcPR->w;
+  gint           height   = srcPR->h;
+  gint           bytes    = srcPR->bytes;
+  gint           levelx   = 0;
+  gint           levely   = 0;
+  gdouble        scalex   = (gdouble) width / dstPR->w;
+  gdouble        scaley   = (gdouble) height / dstPR->h;
 
   /* determine scaling levels */
   if (interpolation != GIMP_INTERPOLATION_NONE)
@@ -299,13 +333,12 @@ scale_region_tile (PixelRegion           *srcPR,
       scale_determine_levels (srcPR, dstPR, &levelx, &levely);
     }
 
-  max_progress = scale_determine_progress (srcPR, dstPR, levelx, levely);
+  progress.max_progress = scale_determine_progress (srcPR, dstPR,
+                                                    levelx, levely);
 
   if (levelx == 0 && levely == 0)
     {
-      scale (srcTM, dstTM, interpolation,
-             progress_callback, progress_data, &progress, max_progress,
-             scalex, scaley);
+      scale (srcTM, dstTM, interpolation, p, scalex, scaley);
     }
 
   while (levelx > 0 && levely > 0)
@@ -316,8 +349,7 @@ scale_region_tile (PixelRegion           *srcPR,
       scaley *= .5;
 
       tmpTM = tile_manager_new (width, height, bytes);
-      decimate_xy (srcTM, tmpTM, interpolation,
-                   progress_callback, progress_data, &progress, max_progress);
+      decimate (srcTM, tmpTM, 2, 2, p);
 
       if (srcTM != srcPR->tiles)
         tile_manager_unref (srcTM);
@@ -333,8 +365,7 @@ scale_region_tile (PixelRegion           *srcPR,
       scalex *= .5;
 
       tmpTM = tile_manager_new (width, height, bytes);
-      decimate_x (srcTM, tmpTM, interpolation,
-                  progress_callback, progress_data, &progress, max_progress);
+      decimate (srcTM, tmpTM, 2, 1, p);
 
       if (srcTM != srcPR->tiles)
         tile_manager_unref (srcTM);
@@ -349,8 +380,7 @@ scale_region_tile (PixelRegion           *srcPR,
       scaley *= .5;
 
       tmpTM = tile_manager_new (width, height, bytes);
-      decimate_y (srcTM, tmpTM, interpolation,
-                  progress_callback, progress_data, &progress, max_progress);
+      decimate (srcTM, tmpTM, 1, 2, p);
 
       if (srcTM != srcPR->tiles)
         tile_manager_unref (srcTM);
@@ -361,330 +391,17 @@ scale_region_tile (PixelRegion           *srcPR,
 
   if (tmpTM != NULL)
     {
-      scale (tmpTM, dstTM, interpolation,
-             progress_callback, progress_data, &progress, max_progress,
-             scalex, scaley);
+      scale (tmpTM, dstTM, interpolation, p, scalex, scaley);
       tile_manager_unref (tmpTM);
     }
 
   if (progress_callback)
-    progress_callback (0, max_progress, max_progress, progress_data);
+    progress_callback (0, progress.max_progress, progress.max_progress,
+                       progress_data);
 
   return;
 }
 
-static void
-scale (TileManager           *srcTM,
-       TileManager           *dstTM,
-       GimpInterpolationType  interpolation,
-       GimpProgressFunc       progress_callback,
-       gpointer               progress_data,
-       gint                  *progress,
-       gint                   max_progress,
-       const gdouble          scalex,
-       const gdouble          scaley)
-{
-  PixelRegion     region;
-  PixelSurround  *surround   = NULL;
-  const guint     src_width  = tile_manager_width  (srcTM);
-  const guint     src_height = tile_manager_height (srcTM);
-  const guint     bytes      = tile_manager_bpp    (dstTM);
-  const guint     dst_width  = tile_manager_width  (dstTM);
-  const guint     dst_height = tile_manager_height (dstTM);
-  gpointer        pr;
-  gfloat         *kernel_lookup = NULL;
-
-  GIMP_LOG (SCALE, "scale: %dx%d -> %dx%d",
-            src_width, src_height, dst_width, dst_height);
-
-  /* fall back if not enough pixels available */
-  if (interpolation != GIMP_INTERPOLATION_NONE)
-    {
-      if (src_width < 2 || src_height < 2 ||
-          dst_width < 2 || dst_height < 2)
-        {
-          interpolation = GIMP_INTERPOLATION_NONE;
-        }
-      else if (src_width < 3 || src_height < 3 ||
-               dst_width < 3 || dst_height < 3)
-        {
-          interpolation = GIMP_INTERPOLATION_LINEAR;
-        }
-    }
-
-  switch (interpolation)
-    {
-    case GIMP_INTERPOLATION_NONE:
-      break;
-
-    case GIMP_INTERPOLATION_LINEAR:
-      surround = pixel_surround_new (srcTM, 2, 2, PIXEL_SURROUND_SMEAR);
-      break;
-
-    case GIMP_INTERPOLATION_CUBIC:
-      surround = pixel_surround_new (srcTM, 4, 4, PIXEL_SURROUND_SMEAR);
-      break;
-
-    case GIMP_INTERPOLATION_LANCZOS:
-      surround = pixel_surround_new (srcTM, 6, 6, PIXEL_SURROUND_SMEAR);
-      kernel_lookup = create_lanczos3_lookup ();
-      break;
-    }
-
-  pixel_region_init (&region, dstTM, 0, 0, dst_width, dst_height, TRUE);
-
-  for (pr = pixel_regions_register (1, &region);
-       pr != NULL;
-       pr = pixel_regions_process (pr))
-    {
-      const gint  x1  = region.x + region.w;
-      const gint  y1  = region.y + region.h;
-      guchar     *row = region.data;
-      gint        y;
-
-      for (y = region.y; y < y1; y++)
-        {
-          guchar  *pixel = row;
-          gdouble  yfrac = (y + 0.5) * scaley - 0.5;
-          gint     sy    = floor (yfrac);
-          gint     x;
-
-          yfrac = yfrac - sy;
-
-          for (x = region.x; x < x1; x++)
-            {
-              gdouble xfrac = (x + 0.5) * scalex - 0.5;
-              gint    sx    = floor (xfrac);
-
-              xfrac = xfrac - sx;
-
-              switch (interpolation)
-                {
-                case GIMP_INTERPOLATION_NONE:
-                  interpolate_nearest (srcTM, sx, sy, xfrac, yfrac, pixel);
-                  break;
-
-                case GIMP_INTERPOLATION_LINEAR:
-                  interpolate_bilinear (surround,
-                                        sx, sy, xfrac, yfrac, bytes, pixel);
-                  break;
-
-                case GIMP_INTERPOLATION_CUBIC:
-                  interpolate_cubic (surround,
-                                     sx, sy, xfrac, yfrac, bytes, pixel);
-                  break;
-
-                case GIMP_INTERPOLATION_LANCZOS:
-                  interpolate_lanczos3 (surround,
-                                        sx, sy, xfrac, yfrac, bytes, pixel,
-                                        kernel_lookup);
-                  break;
-                }
-
-              pixel += region.bytes;
-            }
-
-          row += region.rowstride;
-        }
-
-      if (progress_callback)
-        {
-          (*progress)++;
-
-          if (*progress % 8 == 0)
-            progress_callback (0, max_progress, *progress, progress_data);
-        }
-    }
-
-  if (kernel_lookup)
-    g_free (kernel_lookup);
-
-  if (surround)
-    pixel_surround_destroy (surround);
-}
-
-static void
-decimate_xy (TileManager           *srcTM,
-             TileManager           *dstTM,
-             GimpInterpolationType  interpolation,
-             GimpProgressFunc       progress_callback,
-             gpointer               progress_data,
-             gint                  *progress,
-             gint                   max_progress)
-{
-  PixelRegion     region;
-  PixelSurround  *surround   = NULL;
-  const guint     bytes      = tile_manager_bpp    (dstTM);
-  const guint     dst_width  = tile_manager_width  (dstTM);
-  const guint     dst_height = tile_manager_height (dstTM);
-  gpointer        pr;
-
-  GIMP_LOG (SCALE, "decimate_xy: %dx%d -> %dx%d\n",
-            tile_manager_width (srcTM), tile_manager_height (srcTM),
-            dst_width, dst_height);
-
-  surround = pixel_surround_new (srcTM, 2, 2, PIXEL_SURROUND_SMEAR);
-
-  pixel_region_init (&region, dstTM, 0, 0, dst_width, dst_height, TRUE);
-
-  for (pr = pixel_regions_register (1, &region);
-       pr != NULL;
-       pr = pixel_regions_process (pr))
-    {
-      const gint  x1  = region.x + region.w;
-      const gint  y1  = region.y + region.h;
-      guchar     *row = region.data;
-      gint        y;
-
-      for (y = region.y; y < y1; y++)
-        {
-          const gint  sy    = y * 2;
-          guchar     *pixel = row;
-          gint        x;
-
-          for (x = region.x; x < x1; x++)
-            {
-              decimate_average_xy (surround, x * 2, sy, bytes, pixel);
-
-              pixel += region.bytes;
-            }
-
-          row += region.rowstride;
-        }
-
-      if (progress_callback)
-        {
-          (*progress)++;
-
-          if (*progress % 16 == 0)
-            progress_callback (0, max_progress, *progress, progress_data);
-        }
-    }
-
-  pixel_surround_destroy (surround);
-}
-
-static void
-decimate_x (TileManager           *srcTM,
-            TileManager           *dstTM,
-            GimpInterpolationType  interpolation,
-            GimpProgressFunc       progress_callback,
-            gpointer               progress_data,
-            gint                  *progress,
-            gint                   max_progress)
-{
-  PixelRegion     region;
-  PixelSurround  *surround   = NULL;
-  const guint     bytes      = tile_manager_bpp    (dstTM);
-  const guint     dst_width  = tile_manager_width  (dstTM);
-  const guint     dst_height = tile_manager_height (dstTM);
-  gpointer        pr;
-
-  GIMP_LOG (SCALE, "decimate_x: %dx%d -> %dx%d\n",
-            tile_manager_width (srcTM), tile_manager_height (srcTM),
-            dst_width, dst_height);
-
-  surround = pixel_surround_new (srcTM, 2, 1, PIXEL_SURROUND_SMEAR);
-
-  pixel_region_init (&region, dstTM, 0, 0, dst_width, dst_height, TRUE);
-
-  for (pr = pixel_regions_register (1, &region);
-       pr != NULL;
-       pr = pixel_regions_process (pr))
-    {
-      const gint  x1  = region.x + region.w;
-      const gint  y1  = region.y + region.h;
-      guchar     *row = region.data;
-      gint        y;
-
-      for (y = region.y; y < y1; y++)
-        {
-          guchar *pixel = row;
-          gint    x;
-
-          for (x = region.x; x < x1; x++)
-            {
-              decimate_average_x (surround, x * 2, y, bytes, pixel);
-
-              pixel += region.bytes;
-            }
-
-          row += region.rowstride;
-        }
-
-      if (progress_callback)
-        {
-          (*progress)++;
-
-          if (*progress % 32 == 0)
-            progress_callback (0, max_progress, *progress, progress_data);
-        }
-    }
-
-  pixel_surround_destroy (surround);
-}
-
-static void
-decimate_y (TileManager           *srcTM,
-            TileManager           *dstTM,
-            GimpInterpolationType  interpolation,
-            GimpProgressFunc       progress_callback,
-            gpointer               progress_data,
-            gint                  *progress,
-            gint                   max_progress)
-{
-  PixelRegion     region;
-  PixelSurround  *surround   = NULL;
-  const guint     bytes      = tile_manager_bpp    (dstTM);
-  const guint     dst_width  = tile_manager_width  (dstTM);
-  const guint     dst_height = tile_manager_height (dstTM);
-  gpointer        pr;
-
-  GIMP_LOG (SCALE, "decimate_y: %dx%d -> %dx%d\n",
-            tile_manager_width (srcTM), tile_manager_height (srcTM),
-            dst_width, dst_height);
-
-  surround = pixel_surround_new (srcTM, 1, 2, PIXEL_SURROUND_SMEAR);
-
-  pixel_region_init (&region, dstTM, 0, 0, dst_width, dst_height, TRUE);
-
-  for (pr = pixel_regions_register (1, &region);
-       pr != NULL;
-       pr = pixel_regions_process (pr))
-    {
-      const gint  x1  = region.x + region.w;
-      const gint  y1  = region.y + region.h;
-      guchar     *row = region.data;
-      gint        y;
-
-      for (y = region.y; y < y1; y++)
-        {
-          const gint  sy    = y * 2;
-          guchar     *pixel = row;
-          gint        x;
-
-          for (x = region.x; x < x1; x++)
-            {
-              decimate_average_y (surround, x, sy, bytes, pixel);
-
-              pixel += region.bytes;
-            }
-
-          row += region.rowstride;
-        }
-
-      if (progress_callback)
-        {
-          (*progress)++;
-
-          if (*progress % 32 == 0)
-            progress_callback (0, max_progress, *progress, progress_data);
-        }
-    }
-
-  pixel_surround_destroy (surround);
-}
-
 static void inline
 pixel_average4 (const guchar *p1,
                 const guchar *p2,
@@ -844,503 +561,600 @@ pixel_average2 (const guchar *p1,
 }
 
 static void
-decimate_average_xy (PixelSurround *surround,
-                     const gint     x0,
-                     const gint     y0,
-                     const gint     bytes,
-                     guchar        *pixel)
+scale (TileManager           *srcTM,
+       TileManager           *dstTM,
+       GimpInterpolationType  interpolation,
+       ScaleProgress         *progress,
+       const gdouble          scalex,
+       const gdouble          scaley)
 {
-  gint          stride;
-  const guchar *src = pixel_surround_lock (surround, x0, y0, &stride);
+  ScaleInfo       info          = { 0, };
+  const guint     src_width     = tile_manager_width  (srcTM);
+  const guint     src_height    = tile_manager_height (srcTM);
+  const guint     dst_width     = tile_manager_width  (dstTM);
+  const guint     dst_height    = tile_manager_height (dstTM);
+  gfloat         *kernel_lookup = NULL;
+
+  GIMP_LOG (SCALE, "scale: %dx%d -> %dx%d",
+            src_width, src_height, dst_width, dst_height);
+
+  /* fall back if not enough pixels available */
+  if (interpolation != GIMP_INTERPOLATION_NONE)
+    {
+      if (src_width < 2 || src_height < 2 ||
+          dst_width < 2 || dst_height < 2)
+        {
+          interpolation = GIMP_INTERPOLATION_NONE;
+        }
+      else if (src_width < 3 || src_height < 3 ||
+               dst_width < 3 || dst_height < 3)
+        {
+          interpolation = GIMP_INTERPOLATION_LINEAR;
+        }
+    }
+
+  switch (interpolation)
+    {
+    case GIMP_INTERPOLATION_NONE:
+      info.taps = 1;
+      break;
+
+    case GIMP_INTERPOLATION_LINEAR:
+      info.taps = 2;
+      break;
+
+    case GIMP_INTERPOLATION_CUBIC:
+      info.taps = 4;
+      break;
+
+    case GIMP_INTERPOLATION_LANCZOS:
+      info.taps = 6;
+      kernel_lookup = create_lanczos3_lookup ();
+      break;
+    }
+
+  info.src           = srcTM;
+  info.bytes         = tile_manager_bpp (dstTM);
+  info.interpolation = interpolation;
+  info.x_index       = g_new (gint,    dst_width);
+  info.x_weights     = g_new (gdouble, dst_width * info.taps);
+  info.y_index       = g_new (gint,    dst_height);
+  info.y_weights     = g_new (gdouble, dst_height * info.taps);
 
-  pixel_average4 (src, src + bytes, src + stride, src + stride + bytes,
-                  pixel, bytes);
+  scale_compute_weights (interpolation, info.taps, kernel_lookup,
+                         scalex, dst_width, info.x_index, info.x_weights);
+  scale_compute_weights (interpolation, info.taps, kernel_lookup,
+                         scaley, dst_height, info.y_index, info.y_weights);
+
+  scale_run (&info, dstTM, (PixelProcessorFunc) scale_tile, progress);
+
+  g_free (info.x_index);
+  g_free (info.x_weights);
+  g_free (info.y_index);
+  g_free (info.y_weights);
+
+  if (kernel_lookup)
+    g_free (kernel_lookup);
 }
 
 static void
-decimate_average_x (PixelSurround *surround,
-                    const gint     x0,
-                    const gint     y0,
-                    const gint     bytes,
-                    guchar        *pixel)
+decimate (TileManager   *srcTM,
+          TileManager   *dstTM,
+          gint           factor_x,
+          gint           factor_y,
+          ScaleProgress *progress)
 {
-  gint          stride;
-  const guchar *src = pixel_surround_lock (surround, x0, y0, &stride);
+  ScaleInfo info = { 0, };
+
+  GIMP_LOG (SCALE, "decimate: %dx%d -> %dx%d\n",
+            tile_manager_width (srcTM), tile_manager_height (srcTM),
+            tile_manager_width (dstTM), tile_manager_height (dstTM));
+
+  info.src      = srcTM;
+  info.bytes    = tile_manager_bpp (dstTM);
+  info.factor_x = factor_x;
+  info.factor_y = factor_y;
 
-  pixel_average2 (src, src + bytes, pixel, bytes);
+  scale_run (&info, dstTM, (PixelProcessorFunc) decimate_tile, progress);
 }
 
+/*  Runs @func on all tiles of @dstTM, and counts them as one step of
+ *  the progress.
+ */
 static void
-decimate_average_y (PixelSurround *surround,
-                    const gint     x0,
-                    const gint     y0,
-                    const gint     bytes,
-                    guchar        *pixel)
+scale_run (ScaleInfo          *info,
+           TileManager        *dstTM,
+           PixelProcessorFunc  func,
+           ScaleProgress      *progress)
 {
-  gint          stride;
-  const guchar *src = pixel_surround_lock (surround, x0, y0, &stride);
+  PixelRegion region;
+  const gint  width  = tile_manager_width  (dstTM);
+  const gint  height = tile_manager_height (dstTM);
 
-  pixel_average2 (src, src + stride, pixel, bytes);
-}
+  pixel_region_init (&region, dstTM, 0, 0, width, height, TRUE);
 
-static inline gdouble
-sinc (const gdouble x)
-{
-  gdouble y = x * G_PI;
+  if (progress)
+    {
+      progress->step = NUM_TILES (width, height);
 
-  if (ABS (x) < LANCZOS_MIN)
-    return 1.0;
+      pixel_regions_process_parallel_progress (func, info,
+                                               (PixelProcessorProgressFunc)
+                                               scale_progress,
+                                               progress,
+                                               1, &region);
 
-  return sin (y) / y;
+      progress->progress += progress->step;
+      progress->step      = 0;
+    }
+  else
+    {
+      pixel_regions_process_parallel (func, info, 1, &region);
+    }
 }
 
-/*
- * allocate and fill lookup table of Lanczos windowed sinc function
- * use gfloat since errors due to granularity of array far exceed
- * data precision
- */
-gfloat *
-create_lanczos_lookup (void)
+static void
+scale_progress (ScaleProgress *progress,
+                gdouble        fraction)
 {
-  const gdouble dx = LANCZOS_WIDTH / (gdouble) (LANCZOS_SAMPLES - 1);
-
-  gfloat  *lookup = g_new (gfloat, LANCZOS_SAMPLES);
-  gdouble  x      = 0.0;
-  gint     i;
-
-  for (i = 0; i < LANCZOS_SAMPLES; i++)
-    {
-      lookup[i] = ((ABS (x) < LANCZOS_WIDTH) ?
-                   (sinc (x) * sinc (x / LANCZOS_WIDTH)) : 0.0);
-      x += dx;
-    }
-
-  return lookup;
+  progress->callback (0, progress->max_progress,
+                      progress->progress + fraction * progress->step,
+                      progress->data);
 }
 
-static gfloat *
-create_lanczos3_lookup (void)
+/*  Returns the @width x @height pixels of @srcTM at @x, @y, the ones
+ *  outside of it smeared from its edges.
+ */
+static guchar *
+scale_read_source (TileManager *srcTM,
+                   gint         x,
+                   gint         y,
+                   gint         width,
+                   gint         height)
 {
-  const gdouble dx = 3.0 / (gdouble) (LANCZOS_SAMPLES - 1);
+  const gint  bytes  = tile_manager_bpp (srcTM);
+  const gint  stride = width * bytes;
+  const gint  max_x  = tile_manager_width  (srcTM) - 1;
+  const gint  max_y  = tile_manager_height (srcTM) - 1;
+  const gint  x1     = CLAMP (x,              0, max_x);
+  const gint  x2     = CLAMP (x + width - 1,  0, max_x);
+  const gint  y1     = CLAMP (y,              0, max_y);
+  const gint  y2     = CLAMP (y + height - 1, 0, max_y);
+  guchar     *buffer = g_new (guchar, height * stride);
+  gint        row;
+
+  pixel_processor_lock_tiles ();
+
+  tile_manager_read_pixel_data (srcTM, x1, y1, x2, y2,
+                                buffer + (y1 - y) * stride + (x1 - x) * bytes,
+                                stride);
+
+  pixel_processor_unlock_tiles ();
+
+  for (row = y1 - y; row <= y2 - y; row++)
+    {
+      guchar *first = buffer + row * stride + (x1 - x) * bytes;
+      guchar *last  = buffer + row * stride + (x2 - x) * bytes;
+      guchar *d;
 
-  gfloat  *lookup = g_new (gfloat, LANCZOS_SAMPLES);
-  gdouble  x      = 0.0;
-  gint     i;
+      for (d = buffer + row * stride; d < first; d += bytes)
+        memcpy (d, first, bytes);
 
-  for (i = 0; i < LANCZOS_SAMPLES; i++)
-    {
-      lookup[i] = ((ABS (x) < 3.0) ?
-                   (sinc (x) * sinc (x / 3.0)) : 0.0);
-      x += dx;
+      for (d = last + bytes; d < buffer + (row + 1) * stride; d += bytes)
+        memcpy (d, last, bytes);
     }
 
-  return lookup;
-}
+  for (row = 0; row < y1 - y; row++)
+    memcpy (buffer + row * stride, buffer + (y1 - y) * stride, stride);
 
-static void
-interpolate_nearest (TileManager   *srcTM,
-                     const gint     x0,
-                     const gint     y0,
-                     const gdouble  xfrac,
-                     const gdouble  yfrac,
-                     guchar        *pixel)
-{
-  const gint w = tile_manager_width (srcTM) - 1;
-  const gint h = tile_manager_height (srcTM) - 1;
-  const gint x = (xfrac <= 0.5) ? x0 : x0 + 1;
-  const gint y = (yfrac <= 0.5) ? y0 : y0 + 1;
+  for (row = y2 - y + 1; row < height; row++)
+    memcpy (buffer + row * stride, buffer + (y2 - y) * stride, stride);
 
-  tile_manager_read_pixel_data_1 (srcTM, CLAMP (x, 0, w), CLAMP (y, 0, h),
-                                  pixel);
-}
-
-static inline gdouble
-weighted_sum (const gdouble dx,
-              const gdouble dy,
-              const gint    s00,
-              const gint    s10,
-              const gint    s01,
-              const gint    s11)
-{
-  return ((1 - dy) *
-          ((1 - dx) * s00 + dx * s10) + dy * ((1 - dx) * s01 + dx * s11));
+  return buffer;
 }
 
+/*  The source pixels and weights of @n destination columns or rows,
+ *  @scale source pixels apart.  Nearest neighbor only needs the index.
+ */
 static void
-interpolate_bilinear (PixelSurround *surround,
-                      const gint     x0,
-                      const gint     y0,
-                      const gdouble  xfrac,
-                      const gdouble  yfrac,
-                      const gint     bytes,
-                      guchar        *pixel)
+scale_compute_weights (GimpInterpolationType  interpolation,
+                       gint                   taps,
+                       const gfloat          *kernel_lookup,
+                       gdouble                scale,
+                       gint                   n,
+                       gint                  *index,
+                       gdouble               *weights)
 {
-  gint          stride;
-  const guchar *src = pixel_surround_lock (surround, x0, y0, &stride);
-  const guchar *p1  = src;
-  const guchar *p2  = p1 + bytes;
-  const guchar *p3  = src + stride;
-  const guchar *p4  = p3 + bytes;
-  gdouble       sum;
-  gdouble       alphasum;
-  gint          b;
+  gint i;
 
-  switch (bytes)
+  for (i = 0; i < n; i++)
     {
-    case 1:
-      sum = RINT (weighted_sum (xfrac, yfrac, p1[0], p2[0], p3[0], p4[0]));
+      gdouble  frac = (i + 0.5) * scale - 0.5;
+      gint     s    = floor (frac);
+      gdouble *w    = weights + i * taps;
 
-      pixel[0] = CLAMP (sum, 0, 255);
-      break;
+      frac = frac - s;
 
-    case 2:
-      alphasum = weighted_sum (xfrac, yfrac, p1[1], p2[1], p3[1], p4[1]);
-      if (alphasum > 0)
+      switch (interpolation)
         {
-          sum = weighted_sum (xfrac, yfrac,
-                              p1[0] * p1[1], p2[0] * p2[1],
-                              p3[0] * p3[1], p4[0] * p4[1]);
-          sum = RINT (sum / alphasum);
-          alphasum = RINT (alphasum);
+        case GIMP_INTERPOLATION_NONE:
+          index[i] = (frac <= 0.5) ? s : s + 1;
+          break;
 
-          pixel[0] = CLAMP (sum, 0, 255);
-          pixel[1] = CLAMP (alphasum, 0, 255);
-        }
-      else
-        {
-          pixel[0] = pixel[1] = 0;
-        }
-      break;
+        case GIMP_INTERPOLATION_LINEAR:
+          index[i] = s;
 
-    case 3:
-      for (b = 0; b < 3; b++)
-        {
-          sum = RINT (weighted_sum (xfrac, yfrac, p1[b], p2[b], p3[b], p4[b]));
+          w[0] = 1.0 - frac;
+          w[1] = frac;
+          break;
 
-          pixel[b] = CLAMP (sum, 0, 255);
+        case GIMP_INTERPOLATION_CUBIC:
+          /*  the Catmull-Rom spline through the four pixels  */
+          index[i] = s - 1;
+
+          w[0] = ((-frac + 2.0) * frac - 1.0) * frac / 2.0;
+          w[1] = ((3.0 * frac - 5.0) * frac * frac + 2.0) / 2.0;
+          w[2] = ((-3.0 * frac + 4.0) * frac + 1.0) * frac / 2.0;
+          w[3] = (frac - 1.0) * frac * frac / 2.0;
+          break;
+
+        case GIMP_INTERPOLATION_LANCZOS:
+          {
+            const gint shift = (gint) (frac * LANCZOS_SPP + 0.5);
+            gdouble    sum   = 0.0;
+            gint       k;
+
+            index[i] = s - 2;
+
+            for (k = 3; k >= -2; k--)
+              sum += w[2 + k] = kernel_lookup[ABS (shift - k * LANCZOS_SPP)];
+
+            /* normalise the kernel */
+            for (k = 0; k < 6; k++)
+              w[k] /= sum;
+          }
+          break;
         }
-      break;
+    }
+}
 
-    case 4:
-      alphasum = weighted_sum (xfrac, yfrac, p1[3], p2[3], p3[3], p4[3]);
-      if (alphasum > 0)
+static void
+scale_tile (ScaleInfo   *info,
+            PixelRegion *destPR)
+{
+  const gint  bytes      = info->bytes;
+  const gint  taps       = info->taps;
+  const gint  width      = destPR->w;
+  const gint  height     = destPR->h;
+  const gint  src_x      = info->x_index[destPR->x];
+  const gint  src_y      = info->y_index[destPR->y];
+  const gint  src_width  = info->x_index[destPR->x + width - 1] + taps - src_x;
+  const gint  src_height = info->y_index[destPR->y + height - 1] + taps - src_y;
+  const gint  stride     = src_width * bytes;
+  guchar     *dest       = destPR->data;
+  guchar     *src;
+  gint        y;
+
+  src = scale_read_source (info->src, src_x, src_y, src_width, src_height);
+
+  if (info->interpolation == GIMP_INTERPOLATION_NONE)
+    {
+      for (y = 0; y < height; y++)
         {
-          for (b = 0; b < 3; b++)
+          const gint    r = info->y_index[destPR->y + y] - src_y;
+          const guchar *s = src + r * stride;
+          guchar       *d = dest;
+          gint          x;
+
+          for (x = destPR->x; x < destPR->x + width; x++)
             {
-              sum = weighted_sum (xfrac, yfrac,
-                                  p1[b] * p1[3], p2[b] * p2[3],
-                                  p3[b] * p3[3], p4[b] * p4[3]);
-              sum = RINT (sum / alphasum);
+              memcpy (d, s + (info->x_index[x] - src_x) * bytes, bytes);
 
-              pixel[b] = CLAMP (sum, 0, 255);
+              d += destPR->bytes;
             }
 
-          alphasum = RINT (alphasum);
-          pixel[3] = CLAMP (alphasum, 0, 255);
+          dest += destPR->rowstride;
         }
-      else
+    }
+  else
+    {
+      const gint  n      = bytes * width;
+      gdouble    *planes = g_new (gdouble, src_width * bytes);
+      gdouble    *rows   = g_new (gdouble, taps * n);
+      gdouble    *sums   = g_new (gdouble, n);
+      gint        ring[MAX_TAPS];
+      gint        j;
+
+      /*  ring[j] is the source row filtered into rows + j * n, which
+       *  holds source row r at j = r % taps, the taps rows one
+       *  destination row needs are all in there
+       */
+      for (j = 0; j < taps; j++)
+        ring[j] = -1;
+
+      for (y = 0; y < height; y++)
         {
-          pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+          const gint     r0      = info->y_index[destPR->y + y] - src_y;
+          const gdouble *weights = info->y_weights + (destPR->y + y) * taps;
+          gint           k;
+
+          for (j = 0; j < taps; j++)
+            {
+              const gint r = r0 + j;
+
+              if (ring[r % taps] != r)
+                {
+                  scale_filter_row (info, src + r * stride, src_x, src_width,
+                                    destPR->x, width,
+                                    planes, rows + (r % taps) * n);
+                  ring[r % taps] = r;
+                }
+            }
+
+          for (k = 0; k < n; k++)
+            sums[k] = 0.0;
+
+          for (j = 0; j < taps; j++)
+            scale_region_funcs.accumulate (sums,
+                                           rows + ((r0 + j) % taps) * n,
+                                           weights[j], n);
+
+          scale_region_funcs.store (sums, width, bytes, width, dest);
+
+          dest += destPR->rowstride;
         }
-      break;
-    }
-}
 
-/* Catmull-Rom spline - not bad
-  * basic intro http://www.mvps.org/directx/articles/catmull/
-  * This formula will calculate an interpolated point between pt1 and pt2
-  * dx=0 returns pt1; dx=1 returns pt2
-  */
+      g_free (planes);
+      g_free (rows);
+      g_free (sums);
+    }
 
-static inline gdouble
-cubic_spline_fit (const gdouble  dx,
-                  const gdouble  pt0,
-                  const gdouble  pt1,
-                  const gdouble  pt2,
-                  const gdouble  pt3)
-{
-  return (gdouble) ((( ( -pt0 + 3 * pt1 - 3 * pt2 + pt3 ) *   dx +
-                       ( 2 * pt0 - 5 * pt1 + 4 * pt2 - pt3 ) ) * dx +
-                     ( -pt0 + pt2 ) ) * dx + (pt1 + pt1) ) / 2.0;
+  g_free (src);
 }
 
+/*  Filters the source row @src, which starts at column @src_x, for the
+ *  destination columns @x to @x + @width - 1.  The result has a plane
+ *  of @width values per channel, the colors premultiplied for formats
+ *  with alpha.
+ */
 static void
-interpolate_cubic (PixelSurround *surround,
-                   const gint     x0,
-                   const gint     y0,
-                   const gdouble  xfrac,
-                   const gdouble  yfrac,
-                   const gint     bytes,
-                   guchar        *pixel)
+scale_filter_row (ScaleInfo    *info,
+                  const guchar *src,
+                  gint          src_x,
+                  gint          src_width,
+                  gint          x,
+                  gint          width,
+                  gdouble      *planes,
+                  gdouble      *row)
 {
-  gint          stride;
-  const guchar *src = pixel_surround_lock (surround, x0 - 1, y0 - 1, &stride);
-  const guchar *s0  = src;
-  const guchar *s1  = s0 + stride;
-  const guchar *s2  = s1 + stride;
-  const guchar *s3  = s2 + stride;
-  gint          b;
-  gdouble       p0, p1, p2, p3;
-  gdouble       sum, alphasum;
+  const gint bytes = info->bytes;
+  const gint taps  = info->taps;
+  gint       b, i;
 
-  switch (bytes)
+  if (bytes == 2 || bytes == 4)
     {
-    case 1:
-      p0 = cubic_spline_fit (xfrac, s0[0], s0[1], s0[2], s0[3]);
-      p1 = cubic_spline_fit (xfrac, s1[0], s1[1], s1[2], s1[3]);
-      p2 = cubic_spline_fit (xfrac, s2[0], s2[1], s2[2], s2[3]);
-      p3 = cubic_spline_fit (xfrac, s3[0], s3[1], s3[2], s3[3]);
-
-      sum = RINT (cubic_spline_fit (yfrac, p0, p1, p2, p3));
-
-      pixel[0]= CLAMP (sum, 0, 255);
-      break;
+      const gint alpha = bytes - 1;
 
-    case 2:
-      p0 = cubic_spline_fit (xfrac, s0[1], s0[3], s0[5], s0[7]);
-      p1 = cubic_spline_fit (xfrac, s1[1], s1[3], s1[5], s1[7]);
-      p2 = cubic_spline_fit (xfrac, s2[1], s2[3], s2[5], s2[7]);
-      p3 = cubic_spline_fit (xfrac, s3[1], s3[3], s3[5], s3[7]);
-
-      alphasum = cubic_spline_fit (yfrac, p0, p1, p2, p3);
-
-      if (alphasum > 0)
+      for (i = 0; i < src_width; i++, src += bytes)
         {
-          p0 = cubic_spline_fit (xfrac,
-                                 s0[0] * s0[1], s0[2] * s0[3],
-                                 s0[4] * s0[5], s0[6] * s0[7]);
-          p1 = cubic_spline_fit (xfrac,
-                                 s1[0] * s1[1], s1[2] * s1[3],
-                                 s1[4] * s1[5], s1[6] * s1[7]);
-          p2 = cubic_spline_fit (xfrac,
-                                 s2[0] * s2[1], s2[2] * s2[3],
-                                 s2[4] * s2[5], s2[6] * s2[7]);
-          p3 = cubic_spline_fit (xfrac,
-                                 s3[0] * s3[1], s3[2] * s3[3],
-                                 s3[4] * s3[5], s3[6] * s3[7]);
-
-          sum = cubic_spline_fit (yfrac, p0, p1, p2, p3);
-          sum = RINT (sum / alphasum);
-          pixel[0] = CLAMP (sum, 0, 255);
+          for (b = 0; b < alpha; b++)
+            planes[b * src_width + i] = src[b] * src[alpha];
 
-          alphasum = RINT (alphasum);
-          pixel[1] = CLAMP (alphasum, 0, 255);
+          planes[alpha * src_width + i] = src[alpha];
         }
-      else
+    }
+  else
+    {
+      for (i = 0; i < src_width; i++, src += bytes)
         {
-          pixel[0] = pixel[1] = 0;
+          for (b = 0; b < bytes; b++)
+            planes[b * src_width + i] = src[b];
         }
-      break;
+    }
 
-    case 3:
-      for (b = 0; b < 3; b++)
-        {
-          p0 = cubic_spline_fit (xfrac, s0[b], s0[3 + b], s0[6 + b], s0[9 + b]);
-          p1 = cubic_spline_fit (xfrac, s1[b], s1[3 + b], s1[6 + b], s1[9 + b]);
-          p2 = cubic_spline_fit (xfrac, s2[b], s2[3 + b], s2[6 + b], s2[9 + b]);
-          p3 = cubic_spline_fit (xfrac, s3[b], s3[3 + b], s3[6 + b], s3[9 + b]);
+  for (b = 0; b < bytes; b++)
+    scale_region_funcs.filter (planes + b * src_width - src_x,
+                               info->x_index + x,
+                               info->x_weights + x * taps,
+                               taps, row + b * width, width);
+}
 
-          sum = RINT (cubic_spline_fit (yfrac, p0, p1, p2, p3));
+static void
+scale_filter (const gdouble *plane,
+              const gint    *index,
+              const gdouble *weights,
+              gint           taps,
+              gdouble       *out,
+              gint           n)
+{
+  gint i;
 
-          pixel[b] = CLAMP (sum, 0, 255);
-        }
-      break;
+  for (i = 0; i < n; i++)
+    {
+      const gdouble *p   = plane + index[i];
+      const gdouble *w   = weights + i * taps;
+      gdouble        sum = 0.0;
+      gint           k;
 
-    case 4:
-      p0 = cubic_spline_fit (xfrac, s0[3], s0[7], s0[11], s0[15]);
-      p1 = cubic_spline_fit (xfrac, s1[3], s1[7], s1[11], s1[15]);
-      p2 = cubic_spline_fit (xfrac, s2[3], s2[7], s2[11], s2[15]);
-      p3 = cubic_spline_fit (xfrac, s3[3], s3[7], s3[11], s3[15]);
+      for (k = 0; k < taps; k++)
+        sum += w[k] * p[k];
 
-      alphasum = cubic_spline_fit (yfrac, p0, p1, p2, p3);
+      out[i] = sum;
+    }
+}
 
-      if (alphasum > 0)
+static void
+scale_accumulate (gdouble       *sums,
+                  const gdouble *row,
+                  gdouble        weight,
+                  gint           n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    sums[i] += weight * row[i];
+}
+
+static void
+scale_store_row (const gdouble *sums,
+                 gint           stride,
+                 gint           bytes,
+                 gint           width,
+                 guchar        *dest)
+{
+  gint b, x;
+
+  if (bytes == 2 || bytes == 4)
+    {
+      const gint alpha = bytes - 1;
+
+      for (x = 0; x < width; x++, dest += bytes)
         {
-          for (b = 0; b < 3; b++)
+          gdouble alphasum = sums[alpha * stride + x];
+
+          if (alphasum > 0)
             {
-              p0 = cubic_spline_fit (xfrac,
-                                     s0[0 + b] * s0[ 3], s0[ 4 + b] * s0[7],
-                                     s0[8 + b] * s0[11], s0[12 + b] * s0[15]);
-              p1 = cubic_spline_fit (xfrac,
-                                     s1[0 + b] * s1[ 3], s1[ 4 + b] * s1[7],
-                                     s1[8 + b] * s1[11], s1[12 + b] * s1[15]);
-              p2 = cubic_spline_fit (xfrac,
-                                     s2[0 + b] * s2[ 3], s2[ 4 + b] * s2[7],
-                                     s2[8 + b] * s2[11], s2[12 + b] * s2[15]);
-              p3 = cubic_spline_fit (xfrac,
-                                     s3[0 + b] * s3[ 3], s3[ 4 + b] * s3[7],
-                                     s3[8 + b] * s3[11], s3[12 + b] * s3[15]);
-
-              sum = cubic_spline_fit (yfrac, p0, p1, p2, p3);
-              sum = RINT (sum / alphasum);
+              for (b = 0; b < alpha; b++)
+                {
+                  const gdouble sum = RINT (sums[b * stride + x] / alphasum);
 
-              pixel[b] = CLAMP (sum, 0, 255);
-            }
+                  dest[b] = CLAMP (sum, 0, 255);
+                }
 
-          alphasum = RINT (alphasum);
-          pixel[3] = CLAMP (alphasum, 0, 255);
+              alphasum = RINT (alphasum);
+              dest[alpha] = CLAMP (alphasum, 0, 255);
+            }
+          else
+            {
+              for (b = 0; b < bytes; b++)
+                dest[b] = 0;
+            }
         }
-      else
+    }
+  else
+    {
+      for (x = 0; x < width; x++, dest += bytes)
         {
-          pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+          for (b = 0; b < bytes; b++)
+            {
+              const gdouble sum = RINT (sums[b * stride + x]);
+
+              dest[b] = CLAMP (sum, 0, 255);
+            }
         }
-      break;
     }
 }
 
-static gdouble inline
-lanczos3_mul_alpha (const guchar  *pixels,
-                    const gdouble *x_kernel,
-                    const gdouble *y_kernel,
-                    const gint     stride,
-                    const gint     bytes,
-                    const gint     byte)
+static void
+decimate_tile (ScaleInfo   *info,
+               PixelRegion *destPR)
 {
-  const guchar *row   = pixels;
-  const guchar  alpha = bytes - 1;
-  gdouble       sum   = 0.0;
-  gint          x, y;
-
-  for (y = 0; y < 6; y++, row += stride)
+  const gint    bytes    = info->bytes;
+  const gint    factor_x = info->factor_x;
+  const gint    factor_y = info->factor_y;
+  const gint    stride   = destPR->w * factor_x * bytes;
+  guchar       *src      = scale_read_source (info->src,
+                                              destPR->x * factor_x,
+                                              destPR->y * factor_y,
+                                              destPR->w * factor_x,
+                                              destPR->h * factor_y);
+  guchar       *dest     = destPR->data;
+  gint          y;
+
+  for (y = 0; y < destPR->h; y++)
     {
-      const guchar *p      = row;
-      gdouble       tmpsum = 0.0;
+      const guchar *s = src + y * factor_y * stride;
+      guchar       *d = dest;
+      gint          x;
 
-      for (x = 0; x < 6; x++, p += bytes)
+      for (x = 0; x < destPR->w; x++)
         {
-          tmpsum += x_kernel[x] * p[byte] * p[alpha];
+          if (factor_x == 2 && factor_y == 2)
+            pixel_average4 (s, s + bytes, s + stride, s + stride + bytes,
+                            d, bytes);
+          else if (factor_x == 2)
+            pixel_average2 (s, s + bytes, d, bytes);
+          else
+            pixel_average2 (s, s + stride, d, bytes);
+
+          s += factor_x * bytes;
+          d += destPR->bytes;
         }
 
-      tmpsum *= y_kernel[y];
-      sum    += tmpsum;
+      dest += destPR->rowstride;
     }
 
-  return sum;
+  g_free (src);
 }
 
-static gdouble inline
-lanczos3_mul (const guchar  *pixels,
-              const gdouble *x_kernel,
-              const gdouble *y_kernel,
-              const gint     stride,
-              const gint     bytes,
-              const gint     byte)
-{
-  const guchar *row = pixels;
-  gdouble       sum = 0.0;
-  gint          x, y;
-
-  for (y = 0; y < 6; y++, row += stride)
-    {
-      const guchar *p = row;
-      gdouble       tmpsum = 0.0;
 
-      for (x = 0; x < 6; x++, p += bytes)
-        {
-          tmpsum += x_kernel[x] * p[byte];
-        }
+static inline gdouble
+sinc (const gdouble x)
+{
+  gdouble y = x * G_PI;
 
-      tmpsum *= y_kernel[y];
-      sum    += tmpsum;
-    }
+  if (ABS (x) < LANCZOS_MIN)
+    return 1.0;
 
-  return sum;
+  return sin (y) / y;
 }
 
-static void
-interpolate_lanczos3 (PixelSurround *surround,
-                      const gint     x0,
-                      const gint     y0,
-                      const gdouble  xfrac,
-                      const gdouble  yfrac,
-                      const gint     bytes,
-                      guchar        *pixel,
-                      const gfloat  *kernel_lookup)
+/*
+ * allocate and fill lookup table of Lanczos windowed sinc function
+ * use gfloat since errors due to granularity of array far exceed
+ * data precision
+ */
+gfloat *
+create_lanczos_lookup (void)
 {
-  gint          stride;
-  const guchar *src = pixel_surround_lock (surround, x0 - 2, y0 - 2, &stride);
-  const gint    x_shift    = (gint) (xfrac * LANCZOS_SPP + 0.5);
-  const gint    y_shift    = (gint) (yfrac * LANCZOS_SPP + 0.5);
-  gint          b, i;
-  gdouble       kx_sum, ky_sum;
-  gdouble       x_kernel[6];
-  gdouble       y_kernel[6];
-  gdouble       sum, alphasum;
-
-  kx_sum  = ky_sum = 0.0;
-
-  for (i = 3; i >= -2; i--)
-    {
-      gint pos = i * LANCZOS_SPP;
+  const gdouble dx = LANCZOS_WIDTH / (gdouble) (LANCZOS_SAMPLES - 1);
 
-      kx_sum += x_kernel[2 + i] = kernel_lookup[ABS (x_shift - pos)];
-      ky_sum += y_kernel[2 + i] = kernel_lookup[ABS (y_shift - pos)];
-    }
+  gfloat  *lookup = g_new (gfloat, LANCZOS_SAMPLES);
+  gdouble  x      = 0.0;
+  gint     i;
 
-  /* normalise the kernel arrays */
-  for (i = -2; i <= 3; i++)
+  for (i = 0; i < LANCZOS_SAMPLES; i++)
     {
-      x_kernel[2 + i] /= kx_sum;
-      y_kernel[2 + i] /= ky_sum;
+      lookup[i] = ((ABS (x) < LANCZOS_WIDTH) ?
+                   (sinc (x) * sinc (x / LANCZOS_WIDTH)) : 0.0);
+      x += dx;
     }
 
-  switch (bytes)
-    {
-    case 1:
-      sum = RINT (lanczos3_mul (src, x_kernel, y_kernel, stride, 1, 0));
-
-      pixel[0] = CLAMP (sum, 0, 255);
-      break;
-
-    case 2:
-      alphasum  = lanczos3_mul (src, x_kernel, y_kernel, stride, 2, 1);
-      if (alphasum > 0)
-        {
-          sum = lanczos3_mul_alpha (src, x_kernel, y_kernel, stride, 2, 0);
-          sum = RINT (sum / alphasum);
-          pixel[0] = CLAMP (sum, 0, 255);
+  return lookup;
+}
 
-          alphasum = RINT (alphasum);
-          pixel[1] = CLAMP (alphasum, 0, 255);
-        }
-      else
-        {
-          pixel[0] = pixel[1] = 0;
-        }
-      break;
+static gfloat *
+create_lanczos3_lookup (void)
+{
+  const gdouble dx = 3.0 / (gdouble) (LANCZOS_SAMPLES - 1);
 
-    case 3:
-      for (b = 0; b < 3; b++)
-        {
-          sum = RINT (lanczos3_mul (src, x_kernel, y_kernel, stride, 3, b));
+  gfloat  *lookup = g_new (gfloat, LANCZOS_SAMPLES);
+  gdouble  x      = 0.0;
+  gint     i;
 
-          pixel[b] = CLAMP (sum, 0, 255);
-        }
-      break;
+  for (i = 0; i < LANCZOS_SAMPLES; i++)
+    {
+      lookup[i] = ((ABS (x) < 3.0) ?
+                   (sinc (x) * sinc (x / 3.0)) : 0.0);
+      x += dx;
+    }
 
-    case 4:
-      alphasum = lanczos3_mul (src, x_kernel, y_kernel, stride, 4, 3);
-      if (alphasum > 0)
-        {
-          for (b = 0; b < 3; b++)
-            {
-              sum = lanczos3_mul_alpha (src, x_kernel, y_kernel, stride, 4, b);
-              sum = RINT (sum / alphasum);
+  return lookup;
+}
 
-              pixel[b] = CLAMP (sum, 0, 255);
-            }
 
-          alphasum = RINT (alphasum);
-          pixel[3] = CLAMP (alphasum, 0, 255);
-        }
-      else
-        {
-          pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
-        }
-      break;
-    }
+static inline gdouble
+weighted_sum (const gdouble dx,
+              const gdouble dy,
+              const gint    s00,
+              const gint    s10,
+              const gint    s01,
+              const gint    s11)
+{
+  return ((1 - dy) *
+          ((1 - dx) * s00 + dx * s10) + dy * ((1 - dx) * s01 + dx * s11));
 }
 
+
 static void
 scale_region_buffer (PixelRegion *srcPR,
                      PixelRegion *dstPR)
@@ -35,6 +35,61 @@ void     scale_region          (PixelRegion           *srcPR,
 gfloat * create_lanczos_lookup (void);
 
 
+/*  The row kernels of the interpolating steps, on planes of @n
+ *  doubles, one per destination column of a channel.
+ */
+
+/*  out[i] = the sum of weights[i * taps + k] * plane[index[i] + k]
+ *  over the @taps values of k, added up in the order of k
+ */
+typedef void (* ScaleFilterFunc)     (const gdouble *plane,
+                                      const gint    *index,
+                                      const gdouble *weights,
+                                      gint           taps,
+                                      gdouble       *out,
+                                      gint           n);
+
+/*  sums[i] += weight * row[i]  */
+typedef void (* ScaleAccumulateFunc) (gdouble       *sums,
+                                      const gdouble *row,
+                                      gdouble        weight,
+                                      gint           n);
+
+/*  Rounds the @bytes planes of @width sums, @stride doubles apart, to
+ *  the pixels of @dest, dividing the colors by alpha for 2 and 4 bytes.
+ */
+typedef void (* ScaleStoreFunc)      (const gdouble *sums,
+                                      gint           stride,
+                                      gint           bytes,
+                                      gint           width,
+                                      guchar        *dest);
+
+
+typedef struct _ScaleRegionFuncs ScaleRegionFuncs;
+
+struct _ScaleRegionFuncs
+{
+  ScaleFilterFunc      filter;
+  ScaleAccumulateFunc  accumulate;
+  ScaleStoreFunc       store;
+};
+
+
+/*  the implementations in use, see base/accel-funcs.h  */
+extern ScaleRegionFuncs scale_region_funcs;
+
+
+void     scale_region_init     (guint accel);
+
+
+/*  for the scale region implementations only  */
+
+extern const ScaleRegionFuncs scale_region_generic_funcs;
+
+void     scale_region_sse2_install (ScaleRegionFuncs *funcs);
+void     scale_region_avx2_install (ScaleRegionFuncs *funcs);
+
+
 #endif  /*  __SCALE_REGION_H__  */
 
 /*
@@ -178,7 +178,14 @@ public:
     return true;
   }
 
+  // Called before a prepared dab is queued: whatever it points to must
+  // stay as it is until the dab is drawn.
+  void keep_brush_data() {}
 
+
+  // Traits is one of the pixel traits of base/pixel.hpp, the precision
+  // the blend modes compute in.
+  template<typename Traits>
   void
   draw_dab(PixelIter& iter) 
   {
@@ -186,23 +193,27 @@ public:
     if (normal) {
       if (color_a == 1.0) {
         draw_dab_pixels_BlendMode_Normal(iter, 
-                                         normal * opaque);
+                                         normal * opaque,
+                                         Traits());
       } else {
         // normal case for brushes that use smudging (eg. watercolor)
         draw_dab_pixels_BlendMode_Normal_and_Eraser(iter,
                                                     color_a,
                                                     normal * opaque, 
-                                                    bg_color[0], bg_color[1], bg_color[2]);
+                                                    bg_color[0], bg_color[1], bg_color[2],
+                                                    Traits());
       }
     }
 
     if (lock_alpha) {
       draw_dab_pixels_BlendMode_LockAlpha(iter,
-                                          lock_alpha * opaque);
+                                          lock_alpha * opaque,
+                                          Traits());
     }
   }
   
 
+  template<typename Traits>
   void
   copy_stroke(PixelRegion* src1PR, PixelRegion* destPR, 
               PixelRegion* brushPR, PixelRegion* maskPR,
@@ -215,7 +226,8 @@ public:
     
     // normal case for brushes that use smudging (eg. watercolor)
     draw_dab_pixels_BlendMode_Normal_and_Eraser(iter, 1.0, stroke_opacity, 
-                                                bg_color[0], bg_color[1], bg_color[2]);
+                                                bg_color[0], bg_color[1], bg_color[2],
+                                                Traits());
   }
 
   ColorAccumulator* get_accumulator() {
@@ -414,6 +426,7 @@ public:
     *offsets  = 0;
   }
 
+  template<typename Traits>
   void 
   draw_dab(PixelRegion* src1PR, 
            PixelRegion* destPR,
@@ -444,15 +457,16 @@ public:
                   src1PR->bytes, 
                   destPR->bytes);
     
-    Parent::draw_dab(iter);
+    Parent::template draw_dab<Traits>(iter);
   }
 
+  template<typename Traits>
   void
   copy_stroke(PixelRegion* src1PR, PixelRegion* destPR, 
               PixelRegion* brushPR, PixelRegion* maskPR,
               PixelRegion* texturePR) 
   {
-    Parent::copy_stroke(src1PR, destPR, brushPR, maskPR, texturePR);
+    Parent::template copy_stroke<Traits>(src1PR, destPR, brushPR, maskPR, texturePR);
   }
 
   void
@@ -491,6 +505,7 @@ class GimpBrushFeature :
   GimpCoords* last_coords;
   GimpCoords* current_coords;
   const TempBuf* dab_mask;
+  TempBuf* kept_dab_mask;
   float radius;
   
 public:
@@ -498,12 +513,22 @@ public:
   typedef GeneralBrushFeature<iterator> Parent;
   GimpBrushFeature(GimpCoords* current_coords,
                                  GimpCoords* last_coords)
-    : dab_mask(NULL)
+    : dab_mask(NULL), kept_dab_mask(NULL)
   {
     this->current_coords = current_coords;
     this->last_coords    = last_coords;
   };
   ~GimpBrushFeature() {
+    if (kept_dab_mask)
+      temp_buf_free(kept_dab_mask);
+  }
+
+  // the brush cache may drop the mask on the next transformation
+  void keep_brush_data() {
+    if (dab_mask && !kept_dab_mask) {
+      kept_dab_mask = temp_buf_copy((TempBuf*)dab_mask, NULL);
+      dab_mask      = kept_dab_mask;
+    }
   }
 
   const TempBuf* get_brush_data()
@@ -614,6 +639,7 @@ public:
   }
 
 
+  template<typename Traits>
   void 
   draw_dab(PixelRegion* srcPR, 
            PixelRegion* destPR,
@@ -638,15 +664,16 @@ public:
                   srcPR->rowstride, destPR->rowstride,
                   1, srcPR->bytes, destPR->bytes);
 
-    Parent::draw_dab(iter);        
+    Parent::template draw_dab<Traits>(iter);
   }
 
+  template<typename Traits>
   void
   copy_stroke(PixelRegion* src1PR, PixelRegion* destPR, 
               PixelRegion* brushPR, PixelRegion* maskPR,
               PixelRegion* texturePR) 
   {
-    Parent::copy_stroke(src1PR, destPR, brushPR, maskPR, texturePR);
+    Parent::template copy_stroke<Traits>(src1PR, destPR, brushPR, maskPR, texturePR);
   }
 
   void
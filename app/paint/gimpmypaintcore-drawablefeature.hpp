@@ -3,23 +3,23 @@
 ////////////////////////////////////////////////////////////////////////////////
 class GeneralDrawableFeature {
 protected:
+  /*  The get_*_region() functions initialize the caller's @result and
+   *  return it, or return NULL if there is no such buffer.
+   */
   PixelRegion*
-  get_tiles_region(TileManager* tiles,
+  get_tiles_region(PixelRegion* result, TileManager* tiles,
                    gint x, gint y, gint w, gint h, bool writable) {
-    PixelRegion* result = NULL; 
-    if (tiles) {
-      result = g_new(PixelRegion, 1);
-      pixel_region_init (result, tiles, x, y, w, h, writable? TRUE: FALSE);
-    }
+    if (! tiles)
+      return NULL;
+    pixel_region_init (result, tiles, x, y, w, h, writable? TRUE: FALSE);
     return result;
   }
   PixelRegion*
-  get_temp_buf_region(TempBuf* temp_buf, gint x, gint y, gint w, gint h) {
-    PixelRegion* result = NULL; 
-    if (temp_buf) {
-      result = g_new(PixelRegion, 1);
-      pixel_region_init_temp_buf(result, temp_buf, x, y, w, h); 
-    }
+  get_temp_buf_region(PixelRegion* result, TempBuf* temp_buf,
+                      gint x, gint y, gint w, gint h) {
+    if (! temp_buf)
+      return NULL;
+    pixel_region_init_temp_buf(result, temp_buf, x, y, w, h); 
     return result;
   }
 public:  
@@ -31,7 +31,8 @@ public:
   gint get_drawable_width() { return 0; }
   gint get_drawable_height() { return 0; }
   PixelRegion* 
-  get_drawable_region(gint x, gint y, gint w, gint h, bool writable) {
+  get_drawable_region(PixelRegion* result,
+                      gint x, gint y, gint w, gint h, bool writable) {
     return NULL;
   };
 
@@ -39,17 +40,20 @@ public:
   gint get_mask_width() { return 0; }
   gint get_mask_height() { return 0; }  
   PixelRegion* 
-  get_mask_region(gint x, gint y, gint w, gint h, bool writable) {
+  get_mask_region(PixelRegion* result,
+                  gint x, gint y, gint w, gint h, bool writable) {
     return NULL;
   };
 
   void start_undo_group() {};
   void stop_undo_group() {};
+  void cancel_undo_group() {};
   void validate_undo_tiles(gint x, gint y, gint w, gint h) {};
   gint get_undo_width() { return 0; }
   gint get_undo_height() { return 0; }  
   PixelRegion* 
-  get_undo_region(gint x, gint y, gint w, gint h, bool writable) {
+  get_undo_region(PixelRegion* result,
+                  gint x, gint y, gint w, gint h, bool writable) {
     return NULL;
   };
   
@@ -59,7 +63,8 @@ public:
   gint get_floating_stroke_height() { return 0; }  
   void validate_floating_stroke_tiles(gint x, gint y, gint w, gint h) {};
   PixelRegion* 
-  get_floating_stroke_region(gint x, gint y, gint w, gint h, bool writable) {
+  get_floating_stroke_region(PixelRegion* result,
+                             gint x, gint y, gint w, gint h, bool writable) {
     return NULL;
   };
 };
@@ -153,9 +158,10 @@ public:
   }
   
   PixelRegion* 
-  get_drawable_region(gint x, gint y, gint w, gint h, bool writable) {
+  get_drawable_region(PixelRegion* result,
+                      gint x, gint y, gint w, gint h, bool writable) {
     TileManager* tiles = gimp_drawable_get_tiles(drawable);
-    return get_tiles_region(tiles, x, y, w, h, writable);
+    return get_tiles_region(result, tiles, x, y, w, h, writable);
   };
 
   bool has_mask_item() {
@@ -171,12 +177,13 @@ public:
   }
   
   PixelRegion* 
-  get_mask_region(gint x, gint y, gint w, gint h, bool writable) {
+  get_mask_region(PixelRegion* result,
+                  gint x, gint y, gint w, gint h, bool writable) {
     TileManager *tiles = NULL;
     if (mask_item)
       tiles = gimp_drawable_get_tiles(GIMP_DRAWABLE(mask));
 
-    return get_tiles_region(tiles, x, y, w, h, writable);
+    return get_tiles_region(result, tiles, x, y, w, h, writable);
   };
   
   void start_undo_group() {
@@ -228,6 +235,38 @@ public:
 
     return;
   };
+
+  void cancel_undo_group() {
+    g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+    /*  Put back the tiles the stroke has touched  */
+    if (undo_tiles && x2 > x1 && y2 > y1) {
+      TileManager* tiles = gimp_drawable_get_tiles (drawable);
+      gint i, j;
+
+      for (i = y1; i < y2; i += (TILE_HEIGHT - (i % TILE_HEIGHT))) {
+        for (j = x1; j < x2; j += (TILE_WIDTH - (j % TILE_WIDTH))) {
+          Tile *src_tile = tile_manager_get_tile (undo_tiles, j, i,
+                                                  FALSE, FALSE);
+
+          if (tile_is_valid (src_tile)) {
+            src_tile = tile_manager_get_tile (undo_tiles, j, i, TRUE, FALSE);
+            tile_manager_map_tile (tiles, j, i, src_tile);
+            tile_release (src_tile, FALSE);
+          }
+        }
+      }
+
+      gimp_drawable_update (drawable, x1, y1, x2 - x1, y2 - y1);
+    }
+
+    if (undo_tiles) {
+      tile_manager_unref (undo_tiles);
+      undo_tiles = NULL;
+    }
+
+    gimp_viewable_preview_thaw (GIMP_VIEWABLE (drawable));
+  };
   
   void validate_undo_tiles(gint x, gint y, gint w, gint h) {
     gint i, j;
@@ -268,8 +307,9 @@ public:
   }
   
   PixelRegion* 
-  get_undo_region(gint x, gint y, gint w, gint h, bool writable) {
-    return get_tiles_region(undo_tiles, x, y, w, h, writable);
+  get_undo_region(PixelRegion* result,
+                  gint x, gint y, gint w, gint h, bool writable) {
+    return get_tiles_region(result, undo_tiles, x, y, w, h, writable);
   };
 
   
@@ -326,8 +366,9 @@ public:
   }
   
   PixelRegion* 
-  get_floating_stroke_region(gint x, gint y, gint w, gint h, bool writable) {
-    return get_tiles_region(floating_stroke_tiles, x, y, w, h, writable);
+  get_floating_stroke_region(PixelRegion* result,
+                             gint x, gint y, gint w, gint h, bool writable) {
+    return get_tiles_region(result, floating_stroke_tiles, x, y, w, h, writable);
   };
 };
 
@@ -365,8 +406,9 @@ public:
   }
   
   PixelRegion* 
-  get_drawable_region(gint x, gint y, gint w, gint h, bool writable) {
-    return get_temp_buf_region(drawable, x, y, w, h);
+  get_drawable_region(PixelRegion* result,
+                      gint x, gint y, gint w, gint h, bool writable) {
+    return get_temp_buf_region(result, drawable, x, y, w, h);
   };
   
   void start_undo_group() {
@@ -381,6 +423,12 @@ public:
     temp_buf_free(undo);
     undo = NULL;
   };
+
+  void cancel_undo_group() {
+    if (drawable && undo)
+      temp_buf_copy(undo, drawable);
+    stop_undo_group();
+  };
   
   void validate_undo_tiles(gint x, gint y, gint w, gint h) { };
 
@@ -393,8 +441,9 @@ public:
   }
   
   PixelRegion* 
-  get_undo_region(gint x, gint y, gint w, gint h, bool writable) {
-    return get_temp_buf_region(undo, x, y, w, h);
+  get_undo_region(PixelRegion* result,
+                  gint x, gint y, gint w, gint h, bool writable) {
+    return get_temp_buf_region(result, undo, x, y, w, h);
   };
 
   
@@ -421,8 +470,9 @@ public:
   }
   
   PixelRegion* 
-  get_floating_stroke_region(gint x, gint y, gint w, gint h, bool writable) {
-    return get_temp_buf_region(floating, x, y, w, h);
+  get_floating_stroke_region(PixelRegion* result,
+                             gint x, gint y, gint w, gint h, bool writable) {
+    return get_temp_buf_region(result, floating, x, y, w, h);
   };
 };
 
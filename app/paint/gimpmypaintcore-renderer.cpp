@@ -0,0 +1,211 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+extern "C" {
+#include "config.h"
+
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "paint-types.h"
+};
+
+#include "gimpmypaintcore-renderer.hpp"
+
+/*  The ring is lock free: the main thread only writes the head and the
+ *  render thread only the tail, each after the event it concerns.  The
+ *  mutex is taken only to sleep and to wake a sleeping thread: the
+ *  atomic flags are set before the counters are checked again, so a
+ *  wakeup isn't lost.
+ */
+
+GimpMypaintCoreRenderer::GimpMypaintCoreRenderer(UpdateFunc func,
+                                                 gpointer   data)
+  : head(0), tail(0), thread(NULL), sleeping(0), waiting(0), quit(0),
+    discarding(0), split(0), update_func(func), update_data(data),
+    update_idle_id(0)
+{
+  g_mutex_init (&mutex);
+  g_cond_init (&pushed);
+  g_cond_init (&drawn);
+  g_mutex_init (&render_mutex);
+
+  thread = g_thread_new ("mypaint-renderer", thread_func, this);
+}
+
+GimpMypaintCoreRenderer::~GimpMypaintCoreRenderer()
+{
+  g_atomic_int_set (&quit, 1);
+
+  g_mutex_lock (&mutex);
+  g_cond_signal (&pushed);
+  g_mutex_unlock (&mutex);
+
+  g_thread_join (thread);
+
+  /*  the render thread is gone, nobody else touches the id  */
+  if (update_idle_id)
+    g_source_remove (update_idle_id);
+
+  g_mutex_clear (&render_mutex);
+  g_cond_clear (&drawn);
+  g_cond_clear (&pushed);
+  g_mutex_clear (&mutex);
+}
+
+void
+GimpMypaintCoreRenderer::push(Brush* brush, GimpMypaintSurface* surface,
+                              gdouble dtime, const GimpCoords* coords)
+{
+  gint n = g_atomic_int_get (&head);
+
+  wait_drawn (RING_SIZE - 1);
+
+  Event& event = ring[n % RING_SIZE];
+
+  event.brush   = brush;
+  event.surface = surface;
+  event.dtime   = dtime;
+  event.coords  = *coords;
+
+  g_atomic_int_set (&head, n + 1);
+
+  if (g_atomic_int_get (&sleeping)) {
+    g_mutex_lock (&mutex);
+    g_cond_signal (&pushed);
+    g_mutex_unlock (&mutex);
+  }
+}
+
+void
+GimpMypaintCoreRenderer::sync()
+{
+  wait_drawn (0);
+}
+
+void
+GimpMypaintCoreRenderer::discard()
+{
+  g_atomic_int_set (&discarding, 1);
+  wait_drawn (0);
+  g_atomic_int_set (&discarding, 0);
+}
+
+bool
+GimpMypaintCoreRenderer::take_split()
+{
+  return g_atomic_int_compare_and_exchange (&split, 1, 0);
+}
+
+/*  waits until at most @n_pending events are left to draw  */
+void
+GimpMypaintCoreRenderer::wait_drawn(gint n_pending)
+{
+  if (g_atomic_int_get (&head) - g_atomic_int_get (&tail) <= n_pending)
+    return;
+
+  g_mutex_lock (&mutex);
+
+  g_atomic_int_set (&waiting, 1);
+
+  while (g_atomic_int_get (&head) - g_atomic_int_get (&tail) > n_pending)
+    g_cond_wait (&drawn, &mutex);
+
+  g_atomic_int_set (&waiting, 0);
+
+  g_mutex_unlock (&mutex);
+}
+
+gpointer
+GimpMypaintCoreRenderer::thread_func(gpointer data)
+{
+  static_cast<GimpMypaintCoreRenderer*>(data)->run();
+
+  return NULL;
+}
+
+void
+GimpMypaintCoreRenderer::run()
+{
+  while (! g_atomic_int_get (&quit)) {
+    gint n = g_atomic_int_get (&tail);
+
+    if (n == g_atomic_int_get (&head)) {
+      g_mutex_lock (&mutex);
+
+      g_atomic_int_set (&sleeping, 1);
+
+      while (n == g_atomic_int_get (&head) && ! g_atomic_int_get (&quit))
+        g_cond_wait (&pushed, &mutex);
+
+      g_atomic_int_set (&sleeping, 0);
+
+      g_mutex_unlock (&mutex);
+      continue;
+    }
+
+    Event& event = ring[n % RING_SIZE];
+
+    if (! g_atomic_int_get (&discarding)) {
+      bool finished;
+
+      lock();
+
+      event.surface->set_coords(&event.coords);
+      finished = event.brush->stroke_to(event.surface,
+                                        event.coords.x, event.coords.y,
+                                        event.coords.pressure,
+                                        event.coords.xtilt,
+                                        event.coords.ytilt,
+                                        event.dtime);
+      event.surface->flush_dabs();
+
+      if (finished)
+        g_atomic_int_set (&split, 1);
+
+      if (! update_idle_id)
+        update_idle_id = g_idle_add (update_idle, this);
+
+      unlock();
+    }
+
+    g_atomic_int_set (&tail, n + 1);
+
+    if (g_atomic_int_get (&waiting)) {
+      g_mutex_lock (&mutex);
+      g_cond_signal (&drawn);
+      g_mutex_unlock (&mutex);
+    }
+  }
+}
+
+gboolean
+GimpMypaintCoreRenderer::update_idle(gpointer data)
+{
+  GimpMypaintCoreRenderer* renderer =
+    static_cast<GimpMypaintCoreRenderer*>(data);
+
+  renderer->lock();
+  renderer->update_idle_id = 0;
+  renderer->unlock();
+
+  renderer->update_func(renderer->update_data);
+
+  return FALSE;
+}
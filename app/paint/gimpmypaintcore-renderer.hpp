@@ -0,0 +1,113 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_MYPAINT_CORE_RENDERER_HPP__
+#define __GIMP_MYPAINT_CORE_RENDERER_HPP__
+
+extern "C++" {
+#include "gimpmypaintcore-surface.hpp"
+#include "mypaintbrush-brush.hpp"
+
+// Runs the brush of GimpMypaintCore in a thread of its own, so that
+// the motion events of the tool only have to be queued.
+//
+// The main thread push()es the events into a ring that only it
+// writes to and only the render thread reads from.  The render thread
+// runs Brush::stroke_to() and flushes the dabs of each event, holding
+// the render lock; the surface must have deferred updates.  Then it
+// schedules the update function in the main thread, which passes the
+// painted regions on to the drawable and flushes the projection with
+// the render lock held, so that they see whole events.
+//
+// The render thread locks tiles of the drawable and of the stroke's
+// undo while the main thread locks the same tiles, or projection tiles
+// shared with them, for the display, the projection, color picking,
+// histograms and previews.  That is safe because the tile layer
+// serializes all locking, releasing, sharing and copying on write of
+// tiles with its tile access lock, see tile-private.h; the render lock
+// plays no part in it.  Only the pixels aren't locked: a reader other
+// than the update function may see an event partly drawn, and gets
+// the rest with the update that follows.
+//
+// Everything else the brush and the surface are used for, starting
+// and ending strokes with their undo groups, happens in the main
+// thread after sync() has waited for the queued events.
+class GimpMypaintCoreRenderer
+{
+public:
+  typedef void (*UpdateFunc) (gpointer data);
+
+private:
+  struct Event {
+    Brush*              brush;
+    GimpMypaintSurface* surface;
+    gdouble             dtime;
+    GimpCoords          coords;
+  };
+
+  enum { RING_SIZE = 1024 };
+
+  Event       ring[RING_SIZE];
+  gint        head;        // written by the main thread only
+  gint        tail;        // written by the render thread only
+
+  GThread*    thread;
+  GMutex      mutex;       // for the waits below
+  GCond       pushed;      // the render thread waits for events
+  GCond       drawn;       // the main thread waits for them to be drawn
+  gint        sleeping;    // the render thread waits for pushed
+  gint        waiting;     // the main thread waits for drawn
+  gint        quit;
+  gint        discarding;  // events are dropped instead of drawn
+  gint        split;       // the brush has finished a stroke
+
+  GMutex      render_mutex;
+
+  UpdateFunc  update_func;
+  gpointer    update_data;
+  guint       update_idle_id;
+
+  static gpointer thread_func(gpointer data);
+  static gboolean update_idle(gpointer data);
+
+  void        run();
+  void        wait_drawn(gint n_pending);
+
+public:
+  GimpMypaintCoreRenderer(UpdateFunc func, gpointer data);
+  ~GimpMypaintCoreRenderer();
+
+  // Queues an event, waiting only if the ring is full.
+  void push(Brush* brush, GimpMypaintSurface* surface,
+            gdouble dtime, const GimpCoords* coords);
+
+  // Waits until the render thread has drawn the queued events.
+  void sync();
+
+  // Drops the queued events which aren't drawn yet.
+  void discard();
+
+  // Whether Brush::stroke_to() has finished a stroke since the last
+  // call, GimpMypaintCore splits the stroke then.
+  bool take_split();
+
+  void lock()   { g_mutex_lock (&render_mutex); }
+  void unlock() { g_mutex_unlock (&render_mutex); }
+};
+
+}; // extern C++
+#endif  /*  __GIMP_MYPAINT_CORE_RENDERER_HPP__  */
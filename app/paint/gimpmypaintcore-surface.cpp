@@ -65,6 +65,14 @@ extern "C" {
 #include "paint/gimpmypaintcore-brushfeature.hpp"
 #include "paint/gimpmypaintcore-drawablefeature.hpp"
 
+#include <map>
+#include <vector>
+
+/*  flush the dab queue at the latest after this many dabs, a GIMP
+ *  brush dab keeps a copy of its mask until then
+ */
+#define MAX_QUEUED_DABS 256
+
 ////////////////////////////////////////////////////////////////////////////////
 template<typename BrushFeature>
 struct ParallelProcessor {
@@ -91,19 +99,9 @@ template<typename BrushFeature>
 struct Processors {
 private:
   typedef ParallelProcessor<BrushFeature> P;
-  typedef typename P::template Member<PixelRegion*,PixelRegion*,PixelRegion*,PixelRegion*,PixelRegion*> M5;
   typedef typename P::template Member<PixelRegion*,PixelRegion*,PixelRegion*,PixelRegion*> M4;
-  typedef typename M5::Signature M5S;
   typedef typename M4::Signature M4S;
 public:
-  static typename M5::
-    template Processor<reinterpret_cast<M5S>(&BrushFeature::draw_dab)> 
-    draw_dab;
-
-  static typename M5::
-    template Processor<reinterpret_cast<M5S>(&BrushFeature::copy_stroke)> 
-    copy_stroke;
-
   static typename M4::
     template Processor<reinterpret_cast<M4S>(&BrushFeature::get_color)> 
     get_color;
@@ -122,9 +120,17 @@ private:
   GimpCoords    current_coords;
   bool          floating_stroke;
   float         stroke_opacity;
+  GimpMypaintPrecision precision;
+  bool          deferred_updates;
   
   gint          session;          /*  reference counter of atomic scope   */
 
+  /*  the regions flush_dabs() has painted, with deferred updates  */
+  struct DirtyRect {
+    gint x, y, width, height;
+  };
+  std::vector<DirtyRect> dirty_rects;
+
   void      validate_undo_tiles       (gint              x,
                                        gint              y,
                                        gint              w,
@@ -137,6 +143,7 @@ private:
 
   void start_undo_group();
   void stop_undo_group();
+  void cancel_undo_group();
   
   void start_floating_stroke();
   void stop_floating_stroke();
@@ -205,82 +212,241 @@ private:
     return true;
   };
 
-  void configure_pixel_regions(PixelRegion** src1PR, 
-                               PixelRegion** destPR, 
-                               PixelRegion** brushPR, 
-                               PixelRegion** maskPR, 
-                               PixelRegion** texturePR,
-                               Boundary     b,
+  /*  The regions a dab is drawn with, on the stack of whoever draws it  */
+  struct DabRegions {
+    PixelRegion  src1, dest, brush, mask, texture;
+    PixelRegion *src1PR, *destPR, *brushPR, *maskPR, *texturePR;
+  };
+
+  /*  Sets up the regions of the dab with boundary @b, for the part of
+   *  it at x, y with size w, h.
+   */
+  void configure_pixel_regions(DabRegions&    r,
+                               const Boundary& b,
+                               gint x, gint y, gint w, gint h,
                                bool src_use_floating,
                                bool dest_use_floating,
-                               TempBuf*     dab_mask)
+                               const TempBuf* dab_mask)
   {
-    if (src1PR) {
-      if (src_use_floating)
-        *src1PR = drawable_feature.
-          get_floating_stroke_region(b.rx1, b.ry1, b.width, b.height, false);
-      else
-        *src1PR = drawable_feature.
-          get_drawable_region(b.rx1, b.ry1, b.width, b.height, false);
+    if (src_use_floating)
+      r.src1PR = drawable_feature.
+        get_floating_stroke_region(&r.src1, x, y, w, h, false);
+    else
+      r.src1PR = drawable_feature.
+        get_drawable_region(&r.src1, x, y, w, h, false);
+
+    if (dest_use_floating)
+      r.destPR = drawable_feature.
+        get_floating_stroke_region(&r.dest, x, y, w, h, true);
+    else
+      r.destPR = drawable_feature.
+        get_drawable_region(&r.dest, x, y, w, h, true);
+
+    r.brushPR = NULL;
+    if (dab_mask) {
+      r.brushPR = &r.brush;
+      pixel_region_init_temp_buf(r.brushPR, (TempBuf*)dab_mask,
+                                 MAX(x - b.original_x1, 0), 
+                                 MAX(y - b.original_y1, 0), 
+                                 w, h);
     }
-    
-    if (destPR) {
-      if (dest_use_floating)
-        *destPR = drawable_feature.
-          get_floating_stroke_region(b.rx1, b.ry1, b.width, b.height, true);
-      else
-        *destPR = drawable_feature.
-          get_drawable_region(b.rx1, b.ry1, b.width, b.height, true);
+
+    r.maskPR = drawable_feature.
+      get_mask_region(&r.mask, x + b.offset_x, y + b.offset_y, w, h, false);
+
+    r.texturePR = NULL;
+    if (texture) {
+      TempBuf* pattern = gimp_pattern_get_mask (texture);
+      r.texturePR = &r.texture;
+      pixel_region_init_temp_buf(r.texturePR, pattern,
+                                 x % pattern->width,
+                                 y % pattern->height,
+                                 pattern->width, pattern->height);
+      pixel_region_set_closed_loop(r.texturePR, TRUE);
     }
-    
-    if (brushPR && dab_mask) {
-      *brushPR = g_new(PixelRegion, 1);
-      pixel_region_init_temp_buf(*brushPR, dab_mask, 
-                                 MAX(b.rx1 - b.original_x1, 0), 
-                                 MAX(b.ry1 - b.original_y1, 0), 
-                                 b.width, b.height);
+  };
+
+  /*  A dab waiting in the queue: its brush feature, prepared when the
+   *  dab was queued, and its boundary on the drawable.
+   */
+  class Dab {
+  public:
+    Boundary b;
+
+    virtual ~Dab() {}
+    virtual const TempBuf* get_brush_data() = 0;
+    virtual void draw(DabRegions& r, GimpMypaintPrecision precision) = 0;
+    virtual void copy_stroke(PixelRegion* src1PR, PixelRegion* destPR,
+                             PixelRegion* brushPR,
+                             GimpMypaintPrecision precision) = 0;
+  };
+
+  template<class BrushFeature>
+  class DabImpl : public Dab {
+  public:
+    BrushFeature brush_impl;
+
+    template<typename... Args>
+    DabImpl(Args... args) : brush_impl(args...) {}
+
+    const TempBuf* get_brush_data() {
+      return brush_impl.get_brush_data();
     }
 
-    if (maskPR)
-      *maskPR = drawable_feature.
-        get_mask_region(b.rx1 + b.offset_x, b.ry1 + b.offset_y,
-                        b.width, b.height, false);
-
-    if (texturePR && texture) {
-      *texturePR = g_new(PixelRegion, 1);
-      TempBuf* pattern = NULL;
-      pattern = gimp_pattern_get_mask (texture);
-      pixel_region_init_temp_buf(*texturePR, pattern,
-                                 b.rx1 % pattern->width,
-                                 b.ry1 % pattern->height,
-                                 pattern->width, pattern->height);
-      pixel_region_set_closed_loop(*texturePR, TRUE);
+    void draw(DabRegions& r, GimpMypaintPrecision precision) {
+      switch (precision) {
+      case GIMP_MYPAINT_PRECISION_8_BIT:
+        brush_impl.template draw_dab<PixelTraits8>(r.src1PR, r.destPR, r.brushPR,
+                                                   r.maskPR, r.texturePR);
+        break;
+      case GIMP_MYPAINT_PRECISION_15_BIT:
+        brush_impl.template draw_dab<PixelTraits15>(r.src1PR, r.destPR, r.brushPR,
+                                                    r.maskPR, r.texturePR);
+        break;
+      default:
+        brush_impl.template draw_dab<PixelTraitsReal>(r.src1PR, r.destPR, r.brushPR,
+                                                      r.maskPR, r.texturePR);
+        break;
+      }
     }
+
+    void copy_stroke(PixelRegion* src1PR, PixelRegion* destPR,
+                     PixelRegion* brushPR, GimpMypaintPrecision precision) {
+      switch (precision) {
+      case GIMP_MYPAINT_PRECISION_8_BIT:
+        brush_impl.template copy_stroke<PixelTraits8>(src1PR, destPR, brushPR,
+                                                      NULL, NULL);
+        break;
+      case GIMP_MYPAINT_PRECISION_15_BIT:
+        brush_impl.template copy_stroke<PixelTraits15>(src1PR, destPR, brushPR,
+                                                       NULL, NULL);
+        break;
+      default:
+        brush_impl.template copy_stroke<PixelTraitsReal>(src1PR, destPR, brushPR,
+                                                         NULL, NULL);
+        break;
+      }
+    }
+  };
+
+  /*  The dabs of a flush which touch one tile of the drawable, in the
+   *  order they were queued, and the part of the tile they cover.
+   */
+  struct DabTile {
+    gint              x, y, width, height;
+    gint              x1, y1, x2, y2;
+    std::vector<Dab*> dabs;
   };
 
+  struct FlushData {
+    GimpMypaintSurfaceImpl* surface;
+    std::vector<DabTile*>   tiles;
+  };
+
+  std::vector<Dab*> dabs;         /*  queued since the last flush         */
+
+  static void flush_tile_func (FlushData* data, gint item) {
+    data->surface->flush_tile(data->tiles[item]);
+  }
+
+  /*  Runs @func over the regions in @r the way pixel_regions_process()
+   *  does, from a thread of the pixel processor.
+   */
+  template<typename Func>
+  void process_regions(DabRegions& r, gint n_regions, Func func) {
+    PixelRegionIterator* pr;
+
+    pixel_processor_lock_tiles();
+    if (n_regions == 3)
+      pr = pixel_regions_register(3, r.src1PR, r.destPR, r.brushPR);
+    else
+      pr = pixel_regions_register(5, r.src1PR, r.destPR, r.brushPR,
+                                  r.maskPR, r.texturePR);
+
+    while (pr) {
+      pixel_processor_unlock_tiles();
+      func();
+      pixel_processor_lock_tiles();
+      pr = pixel_regions_process(pr);
+    }
+    pixel_processor_unlock_tiles();
+  }
+
+  void flush_tile(DabTile* tile) {
+    Dab* last = NULL;
+
+    for (typename std::vector<Dab*>::iterator i = tile->dabs.begin();
+         i != tile->dabs.end(); i++) {
+      Dab*            dab = *i;
+      const Boundary& b   = dab->b;
+      gint x1 = MAX(b.rx1, tile->x);
+      gint y1 = MAX(b.ry1, tile->y);
+      gint x2 = MIN(b.rx2, tile->x + tile->width - 1);
+      gint y2 = MIN(b.ry2, tile->y + tile->height - 1);
+      DabRegions r;
+
+      configure_pixel_regions(r, b, x1, y1, x2 - x1 + 1, y2 - y1 + 1,
+                              floating_stroke, floating_stroke,
+                              dab->get_brush_data());
+      process_regions(r, 5, [&] { dab->draw(r, precision); });
+
+      tile->x1 = MIN(tile->x1, x1);
+      tile->y1 = MIN(tile->y1, y1);
+      tile->x2 = MAX(tile->x2, x2);
+      tile->y2 = MAX(tile->y2, y2);
+      last = dab;
+    }
+
+    if (floating_stroke && last) {
+      /* Copy floating stroke buffer into drawable buffer, once for
+       * all of the dabs: it only depends on the undo and floating
+       * stroke pixels, and skips the ones the stroke didn't touch.
+       */
+      gint       w = tile->x2 - tile->x1 + 1;
+      gint       h = tile->y2 - tile->y1 + 1;
+      DabRegions r;
+
+      r.src1PR  = drawable_feature.
+        get_undo_region(&r.src1, tile->x1, tile->y1, w, h, false);
+      r.destPR  = drawable_feature.
+        get_drawable_region(&r.dest, tile->x1, tile->y1, w, h, true);
+      r.brushPR = drawable_feature.
+        get_floating_stroke_region(&r.brush, tile->x1, tile->y1, w, h, false);
+
+      process_regions(r, 3, [&] {
+          last->copy_stroke(r.src1PR, r.destPR, r.brushPR, precision);
+        });
+    }
+  }
+
   template<class BrushFeature>
-  bool draw_dab_impl (BrushFeature& brush_impl,
-                      float x, float y, float radius, 
-                      float color_r, float color_g, float color_b,
-                      float opaque, float hardness,
-                      float color_a,
-                      float aspect_ratio, float angle,
-                      float lock_alpha,float colorize,
-                      float texture_grain = 0.0, float texture_contrast = 1.0)
+  bool queue_dab (DabImpl<BrushFeature>* dab,
+                  float x, float y, float radius, 
+                  float color_r, float color_g, float color_b,
+                  float opaque, float hardness,
+                  float color_a,
+                  float aspect_ratio, float angle,
+                  float lock_alpha,float colorize,
+                  float texture_grain = 0.0, float texture_contrast = 1.0)
   {
-    PixelRegion     *src1PR, *destPR, *brushPR, *maskPR, *texturePR;
-    src1PR = destPR = brushPR = maskPR = texturePR = NULL;
+    BrushFeature& brush_impl = dab->brush_impl;
 
-    drawable_feature.refresh();
+    // with deferred updates, begin_session() has done it in the main thread
+    if (! deferred_updates)
+      drawable_feature.refresh();
     
     opaque     = CLAMP(opaque, 0.0, 1.0);
     hardness   = CLAMP(hardness, 0.0, 1.0);
     lock_alpha = CLAMP(lock_alpha, 0.0, 1.0);
     colorize   = CLAMP(colorize, 0.0, 1.0);
 
-    if (radius < 0.1)    return false; // don't bother with dabs smaller than 0.1 pixel
-    if (hardness == 0.0) return false; // infintly small center point, fully transparent outside
-    if (opaque == 0.0)   return false;
+    // don't bother with dabs smaller than 0.1 pixel,
+    // infintly small center points (fully transparent outside)
+    // or transparent ones
+    if (radius < 0.1 || hardness == 0.0 || opaque == 0.0) {
+      delete dab;
+      return false;
+    }
 
     if (aspect_ratio<1.0) aspect_ratio=1.0;
 
@@ -300,13 +466,14 @@ private:
                                   normal, opaque, lock_alpha,
                                   fg_color, color_a, bg_color, stroke_opacity,
                                   texture_grain, texture_contrast,
-                                  (void*)brushmark))
+                                  (void*)brushmark) ||
+        !adjust_boundary(dab->b, &brush_impl,
+                         (TempBuf*)brush_impl.get_brush_data())) {
+      delete dab;
       return false;
-    TempBuf* dab_mask = (TempBuf*)brush_impl.get_brush_data();
+    }
 
-    Boundary b;
-    if (!adjust_boundary(b, &brush_impl, dab_mask))
-      return false;
+    Boundary& b = dab->b;
 
     /*  set undo blocks  */
     start_undo_group();
@@ -314,39 +481,12 @@ private:
 
     if (floating_stroke)
       validate_floating_stroke_tiles(b.rx1, b.ry1, b.width, b.height);
-    configure_pixel_regions(&src1PR, &destPR, &brushPR, &maskPR, &texturePR,
-                            b, floating_stroke, floating_stroke,
-                            dab_mask);
-    
-    Processors<BrushFeature>::draw_dab(&brush_impl,
-                                       src1PR, destPR, 
-                                       brushPR, maskPR, texturePR);
-
-    if (floating_stroke) {
-      /* Copy floating stroke buffer into drawable buffer */
-      if (src1PR) g_free(src1PR);
-      src1PR = drawable_feature.
-        get_undo_region(b.rx1, b.ry1, b.width, b.height, false);
-
-      if (destPR) g_free(destPR);
-      destPR = drawable_feature.
-        get_drawable_region(b.rx1, b.ry1, b.width, b.height, true);
-
-      if (brushPR) g_free(brushPR);
-      brushPR = drawable_feature.
-        get_floating_stroke_region(b.rx1, b.ry1, b.width, b.height, false);
-
-      Processors<BrushFeature>::copy_stroke(&brush_impl,
-                                            src1PR, destPR, brushPR,
-                                            (PixelRegion*)NULL, (PixelRegion*)NULL);
-    }
 
-    drawable_feature.update_drawable(b.rx1, b.ry1, b.width, b.height);
-    if (src1PR) g_free(src1PR);
-    if (destPR) g_free(destPR);
-    if (brushPR) g_free(brushPR);
-    if (maskPR) g_free(maskPR);
-    if (texturePR) g_free(texturePR);
+    brush_impl.keep_brush_data();
+    dabs.push_back(dab);
+
+    if (dabs.size() >= MAX_QUEUED_DABS)
+      flush_dabs();
 
     return true;
   }
@@ -368,9 +508,8 @@ private:
     if (hardness == 0.0)  return; // infintly small center point, fully transparent outside
     if (aspect_ratio<1.0) aspect_ratio=1.0;
 
-    drawable_feature.refresh();
-    PixelRegion     *src1PR, *brushPR, *maskPR, *texturePR;
-    src1PR = brushPR = maskPR = texturePR = NULL;
+    if (! deferred_updates)
+      drawable_feature.refresh();
     
     /*  get the layer offsets  */
     Pixel::real fg_color[] = {0.0, 0.0, 0.0, 1.0};
@@ -389,28 +528,30 @@ private:
     if (!adjust_boundary(b, &brush_impl, dab_mask))
       return;
 
-    configure_pixel_regions(&src1PR, NULL, &brushPR, &maskPR, &texturePR,
-                            b, false, false, dab_mask);
+    DabRegions r;
+    configure_pixel_regions(r, b, b.rx1, b.ry1, b.width, b.height,
+                            false, false, dab_mask);
     
     // first, we calculate the mask (opacity for each pixel)
     Processors<BrushFeature>::get_color(&brush_impl,
-                                     src1PR, brushPR, maskPR, texturePR); 
+                                     r.src1PR, r.brushPR, r.maskPR, r.texturePR); 
     brush_impl.get_accumulator()->summarize(color_r, color_g, color_b, color_a);
-
-    if (src1PR) g_free(src1PR);
-    if (brushPR) g_free(brushPR);
-    if (maskPR) g_free(maskPR);
-    if (texturePR) g_free(texturePR);
   }
 public:
   GimpMypaintSurfaceImpl(typename DrawableFeature::Drawable d) 
     : session(0), drawable_feature(d), brushmark(NULL), 
-      floating_stroke(false), stroke_opacity(1.0), texture(NULL)
+      floating_stroke(false), stroke_opacity(1.0),
+      precision(GIMP_MYPAINT_PRECISION_FLOAT), deferred_updates(false),
+      texture(NULL)
   {
   }
 
   virtual ~GimpMypaintSurfaceImpl()
   {
+    for (typename std::vector<Dab*>::iterator i = dabs.begin();
+         i != dabs.end(); i++)
+      delete *i;
+
     if (brushmark)
       g_object_unref(G_OBJECT(brushmark));
 
@@ -477,6 +618,29 @@ public:
     stroke_opacity = (float)CLAMP(value, 0.0, 1.0);
   }
 
+  void set_precision(GimpMypaintPrecision value) {
+    // the queued dabs are drawn in the precision they were queued with
+    flush_dabs();
+    precision = value;
+  }
+
+  GimpMypaintPrecision get_precision() {
+    return precision;
+  }
+
+  void set_deferred_updates(bool value) {
+    deferred_updates = value;
+    if (! deferred_updates)
+      update_drawable();
+  }
+
+  void update_drawable() {
+    for (typename std::vector<DirtyRect>::iterator i = dirty_rects.begin();
+         i != dirty_rects.end(); i++)
+      drawable_feature.update_drawable(i->x, i->y, i->width, i->height);
+    dirty_rects.clear();
+  }
+
   virtual void set_coords(const GimpCoords* coords) { current_coords = *coords; }
   virtual bool draw_dab (float x, float y, float radius, 
                          float color_r, float color_g, float color_b,
@@ -495,6 +659,8 @@ public:
 
   virtual void begin_session();
   virtual void end_session();
+  virtual void cancel_session();
+  virtual void flush_dabs();
 };
 
 
@@ -509,17 +675,18 @@ draw_dab (float x, float y, float radius,
           float texture_grain, float texture_contrast)
 {
   if (brushmark) {
-    GimpBrushFeature brush_impl(&current_coords, &last_coords);
-    return draw_dab_impl(brush_impl,
-                          x, y, radius, color_r, color_g, color_b, opaque,
-                          hardness, color_a, aspect_ratio, angle, lock_alpha,
-                          colorize, texture_grain, texture_contrast);
+    DabImpl<GimpBrushFeature>* dab =
+      new DabImpl<GimpBrushFeature>(&current_coords, &last_coords);
+    return queue_dab(dab,
+                     x, y, radius, color_r, color_g, color_b, opaque,
+                     hardness, color_a, aspect_ratio, angle, lock_alpha,
+                     colorize, texture_grain, texture_contrast);
   } else {
-    MypaintBrushFeature brush_impl;
-    return draw_dab_impl(brush_impl,
-                          x, y, radius, color_r, color_g, color_b, opaque,
-                          hardness, color_a, aspect_ratio, angle, lock_alpha,
-                          colorize, texture_grain, texture_contrast);
+    DabImpl<MypaintBrushFeature>* dab = new DabImpl<MypaintBrushFeature>();
+    return queue_dab(dab,
+                     x, y, radius, color_r, color_g, color_b, opaque,
+                     hardness, color_a, aspect_ratio, angle, lock_alpha,
+                     colorize, texture_grain, texture_contrast);
   }
 }
 
@@ -530,6 +697,9 @@ get_color (float x, float y, float radius,
            float hardness, float aspect_ratio, float angle, 
            float texture_grain, float texture_contrast)
 {
+  // smudging picks up what the queued dabs paint
+  flush_dabs();
+
   if (brushmark) {
     GimpBrushFeature brush_impl(&current_coords, &last_coords);
     return get_color_impl(brush_impl,
@@ -551,11 +721,20 @@ GimpMypaintSurfaceImpl<DrawableFeature>::begin_session()
   session = 0;
   if (floating_stroke)
     start_floating_stroke();
+
+  // the render thread only paints, the undo group is started here
+  if (deferred_updates) {
+    drawable_feature.refresh();
+    start_undo_group();
+  }
 }
 
 template<class DrawableFeature> void 
 GimpMypaintSurfaceImpl<DrawableFeature>::end_session()
 {
+  flush_dabs();
+  update_drawable();
+
   if (session <= 0)
     return;
     
@@ -565,6 +744,94 @@ GimpMypaintSurfaceImpl<DrawableFeature>::end_session()
   session = 0;
 }
 
+/*  Drops the queued dabs and puts back the pixels the session has
+ *  painted, without an undo step.
+ */
+template<class DrawableFeature> void 
+GimpMypaintSurfaceImpl<DrawableFeature>::cancel_session()
+{
+  for (typename std::vector<Dab*>::iterator i = dabs.begin();
+       i != dabs.end(); i++)
+    delete *i;
+  dabs.clear();
+
+  /*  the undo extents grow with the updates  */
+  update_drawable();
+
+  if (session <= 0)
+    return;
+
+  cancel_undo_group();
+  if (floating_stroke)
+    stop_floating_stroke();
+  session = 0;
+}
+
+/*  Draws the queued dabs in one pass of the pixel processor, with one
+ *  item per tile of the drawable they touch.  The tiles don't share
+ *  any pixel, the threads only share the tile locking.
+ */
+template<class DrawableFeature> void
+GimpMypaintSurfaceImpl<DrawableFeature>::flush_dabs()
+{
+  if (dabs.empty())
+    return;
+
+  gint                    n_cols = ((drawable_feature.get_drawable_width() +
+                                     TILE_WIDTH - 1) / TILE_WIDTH);
+  std::map<gint, DabTile> tiles;
+  FlushData               data;
+
+  for (typename std::vector<Dab*>::iterator i = dabs.begin();
+       i != dabs.end(); i++) {
+    const Boundary& b = (*i)->b;
+
+    for (gint row = b.ry1 / TILE_HEIGHT; row <= b.ry2 / TILE_HEIGHT; row++)
+      for (gint col = b.rx1 / TILE_WIDTH; col <= b.rx2 / TILE_WIDTH; col++) {
+        DabTile& tile = tiles[row * n_cols + col];
+
+        if (tile.dabs.empty()) {
+          tile.x      = col * TILE_WIDTH;
+          tile.y      = row * TILE_HEIGHT;
+          tile.width  = TILE_WIDTH;
+          tile.height = TILE_HEIGHT;
+          tile.x1     = G_MAXINT;
+          tile.y1     = G_MAXINT;
+          tile.x2     = -1;
+          tile.y2     = -1;
+        }
+        tile.dabs.push_back(*i);
+      }
+  }
+
+  data.surface = this;
+  for (typename std::map<gint, DabTile>::iterator i = tiles.begin();
+       i != tiles.end(); i++)
+    data.tiles.push_back(&i->second);
+
+  pixel_processor_process_items((PixelProcessorItemFunc) flush_tile_func,
+                                &data, data.tiles.size());
+
+  for (typename std::vector<DabTile*>::iterator i = data.tiles.begin();
+       i != data.tiles.end(); i++) {
+    DabTile* tile = *i;
+
+    DirtyRect rect = { tile->x1, tile->y1,
+                       tile->x2 - tile->x1 + 1, tile->y2 - tile->y1 + 1 };
+
+    if (deferred_updates)
+      dirty_rects.push_back(rect);
+    else
+      drawable_feature.update_drawable(rect.x, rect.y,
+                                       rect.width, rect.height);
+  }
+
+  for (typename std::vector<Dab*>::iterator i = dabs.begin();
+       i != dabs.end(); i++)
+    delete *i;
+  dabs.clear();
+}
+
 template<class DrawableFeature> void 
 GimpMypaintSurfaceImpl<DrawableFeature>::start_undo_group()
 {
@@ -583,6 +850,12 @@ GimpMypaintSurfaceImpl<DrawableFeature>::stop_undo_group()
   drawable_feature.stop_undo_group();
 }
 
+template<class DrawableFeature> void 
+GimpMypaintSurfaceImpl<DrawableFeature>::cancel_undo_group()
+{
+  drawable_feature.cancel_undo_group();
+}
+
 template<class DrawableFeature> void 
 GimpMypaintSurfaceImpl<DrawableFeature>::start_floating_stroke()
 {
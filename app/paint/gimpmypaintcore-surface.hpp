@@ -45,9 +45,27 @@ public:
   virtual void set_floating_stroke(bool value) = 0;
   virtual bool get_floating_stroke() = 0;
   virtual void set_stroke_opacity(double value) = 0;
+  virtual void set_precision(GimpMypaintPrecision value) = 0;
+  virtual GimpMypaintPrecision get_precision() = 0;
   virtual void set_coords(const GimpCoords* coords) = 0;
   virtual void set_texture(GimpPattern* texture) = 0;
   virtual GimpPattern* get_texture() = 0;
+
+  // draw_dab() only queues the dabs, they are drawn by the next call
+  // to flush_dabs(), get_color() or end_session()
+  virtual void flush_dabs() = 0;
+
+  // With deferred updates the dabs may be drawn in another thread:
+  // flush_dabs() only collects the regions it has painted, and
+  // update_drawable() passes them on to the drawable.  begin_session()
+  // starts the undo group then.  Both must be called in the main
+  // thread, while nobody draws.
+  virtual void set_deferred_updates(bool value) = 0;
+  virtual void update_drawable() = 0;
+
+  // Ends the session like end_session(), but puts back the pixels
+  // it has painted instead of pushing an undo step.
+  virtual void cancel_session() = 0;
 };
 
 GimpMypaintSurface* GimpMypaintSurface_new(GimpDrawable* drawable);
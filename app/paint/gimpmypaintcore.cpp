@@ -70,6 +70,10 @@ GimpMypaintCore::GimpMypaintCore()
   brush   = NULL;
   stroke  = NULL;
   option_changed_handler = NULL;
+
+  renderer    = NULL;
+  update_func = NULL;
+  update_data = NULL;
 }
 
 
@@ -77,6 +81,88 @@ GimpMypaintCore::~GimpMypaintCore ()
 {
   g_print("GimpMypaintCore(%p)::destructor\n", this);
   cleanup ();
+
+  if (renderer)
+    delete renderer;
+}
+
+void GimpMypaintCore::set_render_thread (bool value,
+                                         void (*func) (gpointer data),
+                                         gpointer data)
+{
+  if (value != (renderer != NULL)) {
+    split_stroke();
+
+    if (value)
+      renderer = new GimpMypaintCoreRenderer(renderer_update, this);
+    else {
+      delete renderer;
+      renderer = NULL;
+    }
+  }
+
+  update_func = func;
+  update_data = data;
+}
+
+void GimpMypaintCore::sync_renderer()
+{
+  if (renderer)
+    renderer->sync();
+}
+
+/*  Called in the main thread when the render thread has drawn some
+ *  events.  The render lock keeps it from painting while the drawable
+ *  and the projection are updated, so they are updated with whole
+ *  events.
+ */
+void GimpMypaintCore::renderer_update (gpointer data)
+{
+  GimpMypaintCore* core = static_cast<GimpMypaintCore*>(data);
+
+  core->renderer->lock();
+  if (core->surface)
+    core->surface->update_drawable();
+  if (core->update_func)
+    core->update_func (core->update_data);
+  core->renderer->unlock();
+
+  // push the undo step of a finished stroke without waiting for the
+  // next event
+  if (core->renderer->take_split())
+    core->split_stroke();
+}
+
+void GimpMypaintCore::sync()
+{
+  if (!renderer)
+    return;
+
+  renderer->sync();
+  if (surface)
+    surface->update_drawable();
+  if (renderer->take_split())
+    split_stroke();
+}
+
+void GimpMypaintCore::cancel()
+{
+  if (renderer)
+    renderer->discard();
+
+  if (stroke) {
+    stroke->stop();
+    surface->cancel_session();
+    delete stroke;
+    stroke = NULL;
+
+    if (renderer)
+      renderer->take_split();
+  }
+
+  // don't continue from the cancelled stroke
+  if (brush)
+    brush->reset();
 }
 
 void GimpMypaintCore::cleanup()
@@ -110,6 +196,10 @@ void GimpMypaintCore::stroke_to (GimpDrawable* drawable,
 {
   g_return_if_fail (drawable);
   bool split = false;
+
+  // a stroke the render thread has finished ends before this event
+  if (renderer && renderer->take_split())
+    split_stroke();
   
   if (options != this->options) {
     if (this->options && option_changed_handler) {
@@ -129,6 +219,7 @@ void GimpMypaintCore::stroke_to (GimpDrawable* drawable,
     g_print("MypaintCore(%p)::create new surface...\n", this);
     surface = GimpMypaintSurface_new(drawable);
   } else if (!surface->is_surface_for(drawable)) {
+    sync_renderer();
     surface->end_session();
     g_print("MypaintCore(%p)::delete surface...\n", this);
     delete surface;
@@ -181,6 +272,15 @@ void GimpMypaintCore::stroke_to (GimpDrawable* drawable,
     gdouble stroke_opacity;
     g_object_get(G_OBJECT(options), "stroke_opacity", &stroke_opacity, NULL);
     surface->set_stroke_opacity(stroke_opacity);
+    GimpMypaintPrecision precision;
+    g_object_get(G_OBJECT(options), "precision", &precision, NULL);
+    surface->set_precision(precision);
+
+    Stroke::SurfaceSettings surface_settings;
+    surface->get_bg_color(&surface_settings.bg_color);
+    surface_settings.stroke_opacity  = stroke_opacity;
+    surface_settings.floating_stroke = floating_stroke;
+    stroke->set_surface_settings(&surface_settings);
     
     if (GIMP_IS_LAYER (drawable)) {
       gboolean lock_alpha = gimp_layer_get_lock_alpha (GIMP_LAYER (drawable));
@@ -190,17 +290,24 @@ void GimpMypaintCore::stroke_to (GimpDrawable* drawable,
       else
         brush->set_base_value(BRUSH_LOCK_ALPHA, 0.0);
     }
+    surface->set_deferred_updates(renderer != NULL);
     surface->begin_session();
   }
   
-  surface->set_coords(coords);
-  
   stroke->record(dtime, coords);
 
+  if (renderer) {
+    renderer->push(brush, surface, dtime, coords);
+    return;
+  }
+
+  surface->set_coords(coords);
+
   /// from Layer#stroke_to
   split = brush->stroke_to(surface, coords->x, coords->y, 
                            coords->pressure, 
                            coords->xtilt, coords->ytilt, dtime);
+  surface->flush_dabs();
   
   if (split)
     split_stroke();
@@ -211,11 +318,34 @@ void GimpMypaintCore::split_stroke()
 //  g_print("splitting stroke...\n");
   if (!stroke)
     return;
-    
+
+  sync_renderer();
+  if (renderer)
+    renderer->take_split();
+
   stroke->stop();
   surface->end_session();
   // push stroke to undo stack.
 
+  // GIMP_MYPAINT_STROKE_LOG names a directory to write each stroke to,
+  // for app/tests/benchmark-mypaint-replay.  The numbers start over in
+  // every session, so the logs of the last one are overwritten.
+  const gchar* log_dir = g_getenv ("GIMP_MYPAINT_STROKE_LOG");
+  if (log_dir && ! stroke->get_records().empty()) {
+    gchar*  basename = g_strdup_printf ("mypaint-stroke-%05d.log",
+                                        stroke->get_serial_number());
+    gchar*  filename = g_build_filename (log_dir, basename, NULL);
+    GError* error    = NULL;
+
+    if (! stroke->save(filename, &error)) {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+    }
+
+    g_free (filename);
+    g_free (basename);
+  }
+
   delete stroke;  
   stroke = NULL;
   /*
@@ -252,6 +382,7 @@ void GimpMypaintCore::update_resource(GimpMypaintOptions* options)
 
 void GimpMypaintCore::reset_brush()
 {
+  sync_renderer();
   if (brush) {
     brush->reset();
   }
@@ -285,9 +416,20 @@ void GimpMypaintCore::option_changed(GObject* target, GParamSpec *pspec)
 }
 
 
-#if 0
 /*  public functions  */
 
+void
+gimp_mypaint_core_cancel (GimpMypaintCore *core,
+                          GimpDrawable    *drawable)
+{
+  g_return_if_fail (core != NULL);
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  core->cancel ();
+}
+
+#if 0
+
 void
 gimp_mypaint_core_paint (GimpMypaintCore    *core,
                        GimpDrawable     *drawable,
@@ -329,50 +471,6 @@ gimp_mypaint_core_paint (GimpMypaintCore    *core,
 #endif
 
 #if 0
-void
-gimp_mypaint_core_cancel (GimpMypaintCore *core,
-                        GimpDrawable  *drawable)
-{
-  gint x, y;
-  gint width, height;
-
-  g_return_if_fail (GIMP_IS_MYPAINT_CORE (core));
-  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
-  g_return_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)));
-
-  /*  Determine if any part of the image has been altered--
-   *  if nothing has, then just return...
-   */
-  if ((core->x2 == core->x1) || (core->y2 == core->y1))
-    return;
-
-  if (gimp_rectangle_intersect (core->x1, core->y1,
-                                core->x2 - core->x1,
-                                core->y2 - core->y1,
-                                0, 0,
-                                gimp_item_get_width  (GIMP_ITEM (drawable)),
-                                gimp_item_get_height (GIMP_ITEM (drawable)),
-                                &x, &y, &width, &height))
-    {
-      gimp_mypaint_core_copy_valid_tiles (core->undo_tiles,
-                                        gimp_drawable_get_tiles (drawable),
-                                        x, y, width, height);
-    }
-
-  tile_manager_unref (core->undo_tiles);
-  core->undo_tiles = NULL;
-
-  if (core->saved_proj_tiles)
-    {
-      tile_manager_unref (core->saved_proj_tiles);
-      core->saved_proj_tiles = NULL;
-    }
-
-  gimp_drawable_update (drawable, x, y, width, height);
-
-  gimp_viewable_preview_thaw (GIMP_VIEWABLE (drawable));
-}
-
 void
 gimp_mypaint_core_interpolate (GimpMypaintCore    *core,
                              GimpDrawable     *drawable,
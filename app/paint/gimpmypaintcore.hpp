@@ -26,6 +26,7 @@ extern "C" {
 
 extern "C++" {
 #include "gimpmypaintcore-surface.hpp"
+#include "gimpmypaintcore-renderer.hpp"
 #include "mypaintbrush-brush.hpp"
 #include "mypaintbrush-stroke.hpp"
 #include "base/delegators.hpp"
@@ -41,11 +42,36 @@ class GimpMypaintCore
   GimpMypaintOptions*     options;
 
   Delegators::Connection* option_changed_handler;
+
+  // draws the strokes in a thread of its own, or NULL
+  GimpMypaintCoreRenderer* renderer;
+  void       (*update_func) (gpointer data);
+  gpointer     update_data;
+
+  static void renderer_update (gpointer data);
+  void sync_renderer();
   
   public:
   GimpMypaintCore();
   ~GimpMypaintCore();
   void cleanup();
+
+  // With a render thread stroke_to() only queues the events.  @func
+  // is called in the main thread when their dabs have been drawn, to
+  // flush the projection.
+  void set_render_thread (bool value,
+                          void (*func) (gpointer data) = NULL,
+                          gpointer data = NULL);
+  bool has_render_thread () { return renderer != NULL; }
+
+  // The surface of the last stroke, or NULL before the first one.
+  GimpMypaintSurface* get_surface () { return surface; }
+
+  // Waits until the queued events are drawn and ends the stroke if
+  // the brush has finished it.
+  void sync();
+  void cancel();
+
   virtual void stroke_to (GimpDrawable* drawable, 
                             gdouble dtime, 
                             const GimpCoords* coords,
@@ -59,6 +85,9 @@ class GimpMypaintCore
   
 };
 
+void      gimp_mypaint_core_cancel                    (GimpMypaintCore    *core,
+                                                     GimpDrawable       *drawable);
+
 void      gimp_mypaint_core_round_line                (GimpMypaintCore    *core,
                                                      GimpMypaintOptions *options,
                                                      gboolean          constrain_15_degrees);
@@ -61,12 +61,14 @@ extern "C" {
 #define DEFAULT_BRUSH_ANGLE            0.0
 
 #define DEFAULT_BRUSH_MODE             GIMP_MYPAINT_NORMAL
+#define DEFAULT_PRECISION              GIMP_MYPAINT_PRECISION_FLOAT
 
 enum
 {
   PROP_0 = BRUSH_SETTINGS_COUNT,
 
   PROP_BRUSH_MODE,
+  PROP_PRECISION,
 
   PROP_BRUSH_VIEW_TYPE,
   PROP_BRUSH_VIEW_SIZE,
@@ -145,6 +147,12 @@ gimp_mypaint_options_class_init (GimpMypaintOptionsClass *klass)
                                  DEFAULT_BRUSH_MODE,
                                  GParamFlags(GIMP_PARAM_STATIC_STRINGS));
 
+  GIMP_CONFIG_INSTALL_PROP_ENUM (object_class, PROP_PRECISION,
+                                 "precision", _("The arithmetic of the blend modes, fixed point is faster"),
+                                 GIMP_TYPE_MYPAINT_PRECISION,
+                                 DEFAULT_PRECISION,
+                                 GParamFlags(GIMP_PARAM_STATIC_STRINGS));
+
   GIMP_CONFIG_INSTALL_PROP_ENUM (object_class, PROP_BRUSH_VIEW_TYPE,
                                  "brush-view-type", NULL,
                                  GIMP_TYPE_VIEW_TYPE,
@@ -165,6 +173,7 @@ gimp_mypaint_options_init (GimpMypaintOptions *options)
 {
   options->brush_mode      = DEFAULT_BRUSH_MODE;
   options->brush           = NULL;
+  options->precision       = DEFAULT_PRECISION;
   g_signal_connect(G_OBJECT(options),  
     gimp_context_type_to_signal_name (GIMP_TYPE_MYPAINT_BRUSH),
     G_CALLBACK(gimp_mypaint_options_mypaint_brush_changed),
@@ -261,6 +270,10 @@ gimp_mypaint_options_set_property (GObject      *object,
       options->brush_mode = (GimpMypaintBrushMode)(g_value_get_enum (value));
       break;
 
+    case PROP_PRECISION:
+      options->precision = (GimpMypaintPrecision)(g_value_get_enum (value));
+      break;
+
     case PROP_BRUSH_VIEW_TYPE:
       options->brush_view_type = (GimpViewType)(g_value_get_enum (value));
       break;
@@ -314,6 +327,10 @@ gimp_mypaint_options_get_property (GObject    *object,
       g_value_set_enum (value, options->brush_mode);
       break;
 
+    case PROP_PRECISION:
+      g_value_set_enum (value, options->precision);
+      break;
+
     case PROP_BRUSH_VIEW_TYPE:
       g_value_set_enum (value, options->brush_view_type);
       break;
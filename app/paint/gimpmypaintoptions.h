@@ -54,6 +54,8 @@ struct _GimpMypaintOptions
   GimpMypaintBrushMode      brush_mode;
   GimpMypaintBrush         *brush;
 
+  GimpMypaintPrecision      precision;
+
   GimpViewType              brush_view_type;
   GimpViewSize              brush_view_size;
 };
@@ -215,6 +215,32 @@ public:
     *(settings[id]) = *src;
   }
 
+  float get_base_value (int id) {
+    assert (id >= 0 && id < BRUSH_SETTINGS_COUNT);
+    return settings[id]->base_value;
+  }
+
+  int get_mapping_n (int id, int input) {
+    assert (id >= 0 && id < BRUSH_SETTINGS_COUNT);
+    return settings[id]->get_n (input);
+  }
+
+  void get_mapping_point (int id, int input, int index, float *x, float *y) {
+    assert (id >= 0 && id < BRUSH_SETTINGS_COUNT);
+    settings[id]->get_point (input, index, x, y);
+  }
+
+  // whether the next stroke_to() starts over from its position
+  bool get_reset_requested ()
+  {
+    return reset_requested;
+  }
+
+  void set_reset_requested (bool value)
+  {
+    reset_requested = value;
+  }
+
   float get_state (int i)
   {
     assert (i >= 0 && i < STATE_COUNT);
@@ -4,6 +4,8 @@ extern "C" {
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gegl.h>
 
 #include "libgimpbase/gimpbase.h"
@@ -13,6 +15,7 @@ extern "C" {
 #include "paint-types.h"
 
 #include "core/gimp.h"
+#include "core/gimpdata.h"
 #include "core/gimpimage.h"
 #include "core/gimpdynamics.h"
 #include "core/gimpdynamicsoutput.h"
@@ -32,9 +35,16 @@ extern "C" {
 
 gint Stroke::_serial_number = 0;
 
-Stroke::Stroke() : brush(NULL), finished(FALSE)
+Stroke::Stroke() : brush(NULL), total_painting_time(0), finished(FALSE)
 {
   serial_number = ++_serial_number;
+
+  memset (start_states, 0, sizeof (start_states));
+  start_reset_requested = false;
+
+  gimp_rgba_set (&surface_settings.bg_color, 1.0, 1.0, 1.0, 1.0);
+  surface_settings.stroke_opacity  = 1.0;
+  surface_settings.floating_stroke = FALSE;
 }
 
 
@@ -46,9 +56,12 @@ void
 Stroke::start(Brush* brush)
 {
   g_assert (!finished);
-  
-  //TODO: record brush state and setting here.
-  
+
+  // the settings are recorded by save(), changing them splits the stroke
+  for (int i = 0; i < STATE_COUNT; i++)
+    start_states[i] = brush->get_state(i);
+  start_reset_requested = brush->get_reset_requested();
+
   brush->new_stroke();
   coords.clear();
   this->brush = brush;
@@ -104,3 +117,290 @@ Stroke::copy_using_different_brush(Surface* surface, Brush* b)
   }
 
 }
+
+void
+Stroke::set_surface_settings(const SurfaceSettings* settings)
+{
+  surface_settings = *settings;
+}
+
+
+/*  stroke logs  */
+
+static void
+log_put_uint8 (GByteArray *log,
+               guint8      value)
+{
+  g_byte_array_append (log, &value, 1);
+}
+
+static void
+log_put_uint32 (GByteArray *log,
+                guint32     value)
+{
+  value = GUINT32_TO_LE (value);
+  g_byte_array_append (log, (const guint8 *) &value, 4);
+}
+
+static void
+log_put_float (GByteArray *log,
+               gfloat      value)
+{
+  union { gfloat f; guint32 i; } u;
+
+  u.f = value;
+  log_put_uint32 (log, u.i);
+}
+
+static void
+log_put_double (GByteArray *log,
+                gdouble     value)
+{
+  union { gdouble d; guint64 i; } u;
+
+  u.d = value;
+  u.i = GUINT64_TO_LE (u.i);
+  g_byte_array_append (log, (const guint8 *) &u.i, 8);
+}
+
+typedef struct
+{
+  const guchar *data;
+  gsize         left;
+  gboolean      truncated;
+} LogReader;
+
+static gboolean
+log_get (LogReader *reader,
+         gpointer   dest,
+         gsize      size)
+{
+  if (reader->left < size)
+    {
+      reader->truncated = TRUE;
+      memset (dest, 0, size);
+      return FALSE;
+    }
+
+  memcpy (dest, reader->data, size);
+  reader->data += size;
+  reader->left -= size;
+
+  return TRUE;
+}
+
+static guint8
+log_get_uint8 (LogReader *reader)
+{
+  guint8 value;
+
+  log_get (reader, &value, 1);
+
+  return value;
+}
+
+static guint32
+log_get_uint32 (LogReader *reader)
+{
+  guint32 value;
+
+  log_get (reader, &value, 4);
+
+  return GUINT32_FROM_LE (value);
+}
+
+static gfloat
+log_get_float (LogReader *reader)
+{
+  union { gfloat f; guint32 i; } u;
+
+  u.i = log_get_uint32 (reader);
+
+  return u.f;
+}
+
+static gdouble
+log_get_double (LogReader *reader)
+{
+  union { gdouble d; guint64 i; } u;
+
+  log_get (reader, &u.i, 8);
+  u.i = GUINT64_FROM_LE (u.i);
+
+  return u.d;
+}
+
+bool
+Stroke::save(const gchar* filename, GError** error)
+{
+  g_return_val_if_fail (brush != NULL, false);
+
+  GByteArray* log = g_byte_array_new ();
+
+  g_byte_array_append (log, (const guint8 *) "GMSL", 4);
+  log_put_uint32 (log, STROKE_LOG_VERSION);
+  log_put_uint32 (log, BRUSH_SETTINGS_COUNT);
+  log_put_uint32 (log, INPUT_COUNT);
+
+  log_put_float (log, surface_settings.bg_color.r);
+  log_put_float (log, surface_settings.bg_color.g);
+  log_put_float (log, surface_settings.bg_color.b);
+  log_put_float (log, surface_settings.stroke_opacity);
+  log_put_uint32 (log, surface_settings.floating_stroke ? 1 : 0);
+
+  for (int id = 0; id < BRUSH_SETTINGS_COUNT; id++) {
+    log_put_float (log, brush->get_base_value(id));
+
+    for (int input = 0; input < INPUT_COUNT; input++) {
+      int n = brush->get_mapping_n(id, input);
+
+      log_put_uint8 (log, n);
+      for (int i = 0; i < n; i++) {
+        float x, y;
+
+        brush->get_mapping_point(id, input, i, &x, &y);
+        log_put_float (log, x);
+        log_put_float (log, y);
+      }
+    }
+  }
+
+  log_put_uint32 (log, STATE_COUNT);
+  for (int i = 0; i < STATE_COUNT; i++)
+    log_put_float (log, start_states[i]);
+  log_put_uint32 (log, start_reset_requested ? 1 : 0);
+
+  log_put_uint32 (log, coords.size());
+  for (std::vector<StrokeRecord>::iterator i = coords.begin(); i != coords.end(); i ++) {
+    log_put_double (log, i->dtime);
+    log_put_double (log, i->coords.x);
+    log_put_double (log, i->coords.y);
+    log_put_float (log, i->coords.pressure);
+    log_put_float (log, i->coords.xtilt);
+    log_put_float (log, i->coords.ytilt);
+  }
+
+  gboolean success = g_file_set_contents (filename,
+                                          (const gchar *) log->data, log->len,
+                                          error);
+  g_byte_array_free (log, TRUE);
+
+  return success;
+}
+
+Stroke*
+Stroke::load(const gchar* filename, Brush* brush, GError** error)
+{
+  gchar*    data;
+  gsize     length;
+  LogReader reader;
+  gchar     magic[4];
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (brush != NULL, NULL);
+
+  if (! g_file_get_contents (filename, &data, &length, error))
+    return NULL;
+
+  reader.data      = (const guchar *) data;
+  reader.left      = length;
+  reader.truncated = FALSE;
+
+  log_get (&reader, magic, 4);
+
+  if (memcmp (magic, "GMSL", 4) ||
+      log_get_uint32 (&reader) != STROKE_LOG_VERSION ||
+      log_get_uint32 (&reader) != BRUSH_SETTINGS_COUNT ||
+      log_get_uint32 (&reader) != INPUT_COUNT)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   "'%s' is not a stroke log of this version of GIMP",
+                   gimp_filename_to_utf8 (filename));
+      g_free (data);
+      return NULL;
+    }
+
+  SurfaceSettings surface_settings;
+
+  surface_settings.bg_color.r = log_get_float (&reader);
+  surface_settings.bg_color.g = log_get_float (&reader);
+  surface_settings.bg_color.b = log_get_float (&reader);
+  surface_settings.bg_color.a = 1.0;
+  surface_settings.stroke_opacity  = log_get_float (&reader);
+  surface_settings.floating_stroke = log_get_uint32 (&reader) != 0;
+
+  bool valid = true;
+
+  for (int id = 0; valid && id < BRUSH_SETTINGS_COUNT; id++) {
+    brush->set_base_value(id, log_get_float (&reader));
+
+    for (int input = 0; valid && input < INPUT_COUNT; input++) {
+      guint8 n = log_get_uint8 (&reader);
+
+      // what Mapping::set_n() and set_point() assert
+      if (n == 1 || n > 8) {
+        valid = false;
+        break;
+      }
+
+      brush->set_mapping_n(id, input, n);
+      for (int i = 0; i < n; i++) {
+        float x = log_get_float (&reader);
+        float y = log_get_float (&reader);
+
+        if (i > 0) {
+          float last_x, last_y;
+
+          brush->get_mapping_point(id, input, i - 1, &last_x, &last_y);
+          if (! (x >= last_x)) {
+            valid = false;
+            break;
+          }
+        }
+        brush->set_mapping_point(id, input, i, x, y);
+      }
+    }
+  }
+
+  if (valid && log_get_uint32 (&reader) != STATE_COUNT)
+    valid = false;
+
+  for (int i = 0; valid && i < STATE_COUNT; i++)
+    brush->set_state(i, log_get_float (&reader));
+  brush->set_reset_requested(log_get_uint32 (&reader) != 0);
+
+  guint32 n_records = log_get_uint32 (&reader);
+
+  // 3 doubles and 3 floats each
+  if (! valid || reader.truncated || reader.left != (gsize) n_records * 36)
+    {
+      g_set_error (error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+                   "Stroke log '%s' is corrupt",
+                   gimp_filename_to_utf8 (filename));
+      g_free (data);
+      return NULL;
+    }
+
+  Stroke* stroke = new Stroke();
+
+  stroke->start(brush);
+  stroke->set_surface_settings(&surface_settings);
+
+  for (guint32 i = 0; i < n_records; i++) {
+    GimpCoords coords = { 0, };
+    gdouble    dtime;
+
+    dtime           = log_get_double (&reader);
+    coords.x        = log_get_double (&reader);
+    coords.y        = log_get_double (&reader);
+    coords.pressure = log_get_float (&reader);
+    coords.xtilt    = log_get_float (&reader);
+    coords.ytilt    = log_get_float (&reader);
+
+    stroke->record(dtime, &coords);
+  }
+
+  g_free (data);
+
+  return stroke;
+}
@@ -5,12 +5,39 @@
 #include "mypaintbrush-surface.hpp"
 #include <vector>
 
+// A stroke can be written to a stroke log and replayed from it outside
+// of GIMP, see app/tests/benchmark-mypaint-replay.cpp.  The log is
+// little endian:
+//
+//   "GMSL", guint32 version, guint32 settings count, guint32 inputs count
+//   float bg color r, g, b, float stroke opacity, guint32 floating stroke
+//   for each setting:
+//     float base value, for each input: guint8 n, n times float x, y
+//   guint32 states count, the float states, guint32 reset requested
+//   guint32 records count
+//   for each record:
+//     double dtime, double x, y, float pressure, xtilt, ytilt
+//
+// The states are those of the brush when the stroke started; they
+// seed its random numbers too, so a replay draws the same dabs.
+
+#define STROKE_LOG_VERSION 1
+
 class Stroke {
+public:
   struct StrokeRecord {
     gdouble dtime;
     GimpCoords coords;
   };
 
+  // what the surface needs to draw the stroke like the core did
+  struct SurfaceSettings {
+    GimpRGB  bg_color;
+    gdouble  stroke_opacity;
+    gboolean floating_stroke;
+  };
+
+private:
   static gint _serial_number;
 
   Brush*                 brush;
@@ -19,17 +46,33 @@ class Stroke {
   gint                   serial_number;
   std::vector<StrokeRecord> coords;
 
+  float                  start_states[STATE_COUNT];
+  bool                   start_reset_requested;
+  SurfaceSettings        surface_settings;
+
 public:
   Stroke();
   ~Stroke();
 
   void start(Brush* brush);
-  void record(gdouble dtime, 
+  void record(gdouble dtime,
               const GimpCoords* coord);
   void stop();
   bool is_empty();
   void render(Surface* surface);
   void copy_using_different_brush(Surface* surface, Brush* b);
+
+  gint get_serial_number() { return serial_number; }
+  const std::vector<StrokeRecord>& get_records() { return coords; }
+
+  void set_surface_settings(const SurfaceSettings* settings);
+  const SurfaceSettings* get_surface_settings() { return &surface_settings; }
+
+  bool save(const gchar* filename, GError** error);
+
+  // Sets up @brush as it was when the logged stroke started and
+  // returns the stroke, started with it, or NULL and sets @error.
+  static Stroke* load(const gchar* filename, Brush* brush, GError** error);
 };
 
 #endif /* __MYPAINT_BRUSH_STROKE_HPP__ */
@@ -159,6 +159,37 @@ gimp_ink_blob_type_get_type (void)
   return type;
 }
 
+GType
+gimp_mypaint_precision_get_type (void)
+{
+  static const GEnumValue values[] =
+  {
+    { GIMP_MYPAINT_PRECISION_FLOAT, "GIMP_MYPAINT_PRECISION_FLOAT", "float" },
+    { GIMP_MYPAINT_PRECISION_8_BIT, "GIMP_MYPAINT_PRECISION_8_BIT", "8-bit" },
+    { GIMP_MYPAINT_PRECISION_15_BIT, "GIMP_MYPAINT_PRECISION_15_BIT", "15-bit" },
+    { 0, NULL, NULL }
+  };
+
+  static const GimpEnumDesc descs[] =
+  {
+    { GIMP_MYPAINT_PRECISION_FLOAT, NC_("mypaint-precision", "Floating point"), NULL },
+    { GIMP_MYPAINT_PRECISION_8_BIT, NC_("mypaint-precision", "8 bit"), NULL },
+    { GIMP_MYPAINT_PRECISION_15_BIT, NC_("mypaint-precision", "15 bit"), NULL },
+    { 0, NULL, NULL }
+  };
+
+  static GType type = 0;
+
+  if (G_UNLIKELY (! type))
+    {
+      type = g_enum_register_static ("GimpMypaintPrecision", values);
+      gimp_type_set_translation_context (type, "mypaint-precision");
+      gimp_enum_set_value_descriptions (type, descs);
+    }
+
+  return type;
+}
+
 
 /* Generated data ends here */
 
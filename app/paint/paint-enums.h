@@ -94,6 +94,19 @@ typedef enum
 } GimpInkBlobType;
 
 
+#define GIMP_TYPE_MYPAINT_PRECISION (gimp_mypaint_precision_get_type ())
+
+GType gimp_mypaint_precision_get_type (void) G_GNUC_CONST;
+
+/*  the arithmetic of the MyPaint blend modes, see base/pixel.hpp  */
+typedef enum  /*< pdb-skip >*/
+{
+  GIMP_MYPAINT_PRECISION_FLOAT,   /*< desc="Floating point" >*/
+  GIMP_MYPAINT_PRECISION_8_BIT,   /*< desc="8 bit"          >*/
+  GIMP_MYPAINT_PRECISION_15_BIT   /*< desc="15 bit"         >*/
+} GimpMypaintPrecision;
+
+
 /*
  * non-registered enums; register them if needed
  */
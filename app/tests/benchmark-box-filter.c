@@ -0,0 +1,195 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-box-filter.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Times the generic box filters against the accelerated ones the
+ *  CPU supports, reporting like the gimp-composite regression tests:
+ *  the generic time, the accelerated time and the speedup, marked
+ *  with a '*' where the accelerated version is slower.
+ */
+
+#include <stdlib.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "base/base-types.h"
+
+#include "base/box-filter.h"
+#include "base/tile.h"
+
+
+#define ROW_WIDTH  (TILE_WIDTH / 2)
+
+
+static gint iterations = 200000;
+
+static const GOptionEntry entries[] =
+{
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+    "Number of rows or pixels per function (default: 200000)", "N" },
+  { NULL }
+};
+
+
+static gdouble
+time_halve (BoxFilterHalveFunc  func,
+            const guchar       *src0,
+            const guchar       *src1,
+            guchar             *dest)
+{
+  GTimer  *timer = g_timer_new ();
+  gdouble  elapsed;
+  gint     i;
+
+  for (i = 0; i < iterations; i++)
+    func (src0, src1, dest, ROW_WIDTH);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return elapsed;
+}
+
+static gdouble
+time_filter (BoxFilterFunc   func,
+             const guchar  **src,
+             guchar         *dest,
+             gint            bpp)
+{
+  GTimer  *timer = g_timer_new ();
+  gdouble  elapsed;
+  gint     i;
+
+  /*  vary the weights like the renderer does across a row  */
+  for (i = 0; i < iterations; i++)
+    func (128 - (i & 127), 256, i & 127,
+          64, 256, 64,
+          src, dest, bpp);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return elapsed;
+}
+
+static void
+report (const gchar *name,
+        gdouble      t1,
+        gdouble      t2)
+{
+  g_print ("%-32s %10.4f %10.4f %10.4f%c\n",
+           name, t1, t2, t1 / t2, t1 / t2 > 1.0 ? ' ' : '*');
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError         *error = NULL;
+  const guint     support = gimp_cpu_accel_get_support ();
+  BoxFilterFuncs  accel;
+  guchar         *src0;
+  guchar         *src1;
+  guchar         *dest;
+  guchar          pixels[9][4];
+  const guchar   *src[9];
+  gint            bpp;
+  gint            i;
+
+  g_type_init ();
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  box_filter_init (support);
+  accel = box_filter_funcs;
+
+  g_print ("%d iterations, SSE2 %s, AVX2 %s\n\n", iterations,
+           (support & GIMP_CPU_ACCEL_X86_SSE2) ? "yes" : "no",
+           (support & GIMP_CPU_ACCEL_X86_AVX2) ? "yes" : "no");
+  g_print ("%-32s %10s %10s %10s\n",
+           "function", "generic", "accel", "speedup");
+
+  src0 = g_new (guchar, ROW_WIDTH * 2 * 4);
+  src1 = g_new (guchar, ROW_WIDTH * 2 * 4);
+  dest = g_new (guchar, ROW_WIDTH * 4);
+
+  for (i = 0; i < ROW_WIDTH * 2 * 4; i++)
+    {
+      src0[i] = g_random_int_range (0, 256);
+      src1[i] = g_random_int_range (0, 256);
+    }
+
+  for (i = 0; i < 9; i++)
+    {
+      gint c;
+
+      for (c = 0; c < 4; c++)
+        pixels[i][c] = g_random_int_range (0, 256);
+
+      src[i] = pixels[i];
+    }
+
+  for (bpp = 1; bpp <= 4; bpp++)
+    {
+      gchar name[32];
+
+      g_snprintf (name, sizeof (name), "halve, %d bpp", bpp);
+      report (name,
+              time_halve (box_filter_generic_funcs.halve[bpp - 1],
+                          src0, src1, dest),
+              time_halve (accel.halve[bpp - 1], src0, src1, dest));
+
+      g_snprintf (name, sizeof (name), "halve_premult, %d bpp", bpp);
+      report (name,
+              time_halve (box_filter_generic_funcs.halve_premult[bpp - 1],
+                          src0, src1, dest),
+              time_halve (accel.halve_premult[bpp - 1], src0, src1, dest));
+
+      g_snprintf (name, sizeof (name), "filter, %d bpp", bpp);
+      report (name,
+              time_filter (box_filter_generic_funcs.filter, src, dest, bpp),
+              time_filter (accel.filter, src, dest, bpp));
+
+      if (bpp == 2 || bpp == 4)
+        {
+          g_snprintf (name, sizeof (name), "filter_premult, %d bpp", bpp);
+          report (name,
+                  time_filter (box_filter_generic_funcs.filter_premult,
+                               src, dest, bpp),
+                  time_filter (accel.filter_premult, src, dest, bpp));
+        }
+    }
+
+  g_free (src0);
+  g_free (src1);
+  g_free (dest);
+
+  return EXIT_SUCCESS;
+}
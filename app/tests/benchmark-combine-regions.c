@@ -0,0 +1,220 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-combine-regions.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Times combine_regions() for every layer mode the projection uses,
+ *  combining a GRAYA or RGBA layer onto a projection with alpha, once
+ *  with the generic code only and once with the gimp-composite and
+ *  combine_pixels code the CPU supports.  Reports million pixels per
+ *  second and the speedup, marked with a '*' where the accelerated
+ *  code is slower.
+ */
+
+#include <stdlib.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "base/base-types.h"
+
+#include "base/pixel-region.h"
+
+#include "composite/gimp-composite.h"
+
+#include "paint-funcs/combine-pixels.h"
+#include "paint-funcs/paint-funcs.h"
+
+
+#define N_MODES  (GIMP_GRAIN_MERGE_MODE + 1)
+
+
+static gint size       = 1024;
+static gint opacity    = 255;
+static gint iterations = 10;
+
+static const GOptionEntry entries[] =
+{
+  { "size", 's', 0, G_OPTION_ARG_INT, &size,
+    "Width and height of the regions (default: 1024)", "PIXELS" },
+  { "opacity", 'o', 0, G_OPTION_ARG_INT, &opacity,
+    "Opacity of the layer (default: 255)", "OPACITY" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+    "Number of passes per mode (default: 10)", "N" },
+  { NULL }
+};
+
+static const gboolean affect[MAX_CHANNELS] = { TRUE, TRUE, TRUE, TRUE };
+
+
+/*  Random pixels, with runs of transparent and opaque alpha like
+ *  layers have around and inside their content.
+ */
+static guchar *
+random_data (gint bytes)
+{
+  guchar *data = g_new (guchar, size * size * bytes);
+  gint    i;
+
+  for (i = 0; i < size * size * bytes; i++)
+    data[i] = g_random_int_range (0, 256);
+
+  for (i = bytes - 1; i < size * size * bytes; i += bytes)
+    {
+      switch ((i / bytes / 64) % 3)
+        {
+        case 0: data[i] = 0;   break;
+        case 1: data[i] = 255; break;
+        }
+    }
+
+  return data;
+}
+
+/*  returns million pixels per second  */
+static gdouble
+time_combine (GimpLayerModeEffects  mode,
+              gint                  bytes,
+              const guchar         *src1,
+              const guchar         *src2,
+              guchar               *dest)
+{
+  GTimer  *timer = g_timer_new ();
+  gdouble  elapsed;
+  gint     i;
+
+  for (i = 0; i < iterations; i++)
+    {
+      PixelRegion src1PR;
+      PixelRegion src2PR;
+      PixelRegion destPR;
+
+      pixel_region_init_data (&src1PR, (guchar *) src1, bytes, size * bytes,
+                              0, 0, size, size);
+      pixel_region_init_data (&src2PR, (guchar *) src2, bytes, size * bytes,
+                              0, 0, size, size);
+      pixel_region_init_data (&destPR, dest, bytes, size * bytes,
+                              0, 0, size, size);
+
+      combine_regions (&src1PR, &src2PR, &destPR, NULL, NULL,
+                       opacity, mode, affect, COMBINE_INTEN_A_INTEN_A);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return (gdouble) size * size * iterations / elapsed / 1e6;
+}
+
+static void
+time_modes (gint          bytes,
+            const guchar *src1,
+            const guchar *src2,
+            guchar       *dest,
+            gdouble      *mpix)
+{
+  GimpLayerModeEffects mode;
+
+  for (mode = GIMP_NORMAL_MODE; mode < N_MODES; mode++)
+    mpix[mode] = time_combine (mode, bytes, src1, src2, dest);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError         *error = NULL;
+  const guint     support = gimp_cpu_accel_get_support ();
+  guchar         *src1[2];
+  guchar         *src2[2];
+  guchar         *dest[2];
+  gdouble         generic[2][N_MODES];
+  gdouble         accel[2][N_MODES];
+  gint            i;
+
+  g_type_init ();
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  g_print ("%dx%d pixels, opacity %d, %d iterations, AVX2 %s\n\n",
+           size, size, opacity, iterations,
+           (support & GIMP_CPU_ACCEL_X86_AVX2) ? "yes" : "no");
+  g_print ("%-24s %10s %10s %10s\n",
+           "mode", "generic", "accel", "speedup");
+
+  for (i = 0; i < 2; i++)
+    {
+      src1[i] = random_data (2 * (i + 1));
+      src2[i] = random_data (2 * (i + 1));
+      dest[i] = g_new (guchar, size * size * 2 * (i + 1));
+    }
+
+  /*  the accelerated pass goes first, turning the gimp-composite
+   *  extensions off can't be undone
+   */
+  gimp_composite_init (FALSE, TRUE);
+  combine_pixels_init (support);
+
+  for (i = 0; i < 2; i++)
+    time_modes (2 * (i + 1), src1[i], src2[i], dest[i], accel[i]);
+
+  gimp_composite_init (FALSE, FALSE);
+  combine_pixels_init (0);
+
+  for (i = 0; i < 2; i++)
+    time_modes (2 * (i + 1), src1[i], src2[i], dest[i], generic[i]);
+
+  for (i = 0; i < 2; i++)
+    {
+      gint mode;
+
+      for (mode = GIMP_NORMAL_MODE; mode < N_MODES; mode++)
+        {
+          const gchar *nick;
+          gchar       *name;
+
+          gimp_enum_get_value (GIMP_TYPE_LAYER_MODE_EFFECTS, mode,
+                               NULL, &nick, NULL, NULL);
+
+          name = g_strdup_printf ("%s, %s", nick, i ? "RGBA" : "GRAYA");
+
+          g_print ("%-24s %10.2f %10.2f %10.4f%c\n",
+                   name, generic[i][mode], accel[i][mode],
+                   accel[i][mode] / generic[i][mode],
+                   accel[i][mode] >= generic[i][mode] ? ' ' : '*');
+
+          g_free (name);
+        }
+
+      g_free (src1[i]);
+      g_free (src2[i]);
+      g_free (dest[i]);
+    }
+
+  return EXIT_SUCCESS;
+}
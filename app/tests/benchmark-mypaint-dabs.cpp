@@ -0,0 +1,235 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-mypaint-dabs.cpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Measures how many dabs per second the MyPaint surface draws, for a
+ *  few dab sizes, on a temp buf like the brush previews use.  The dabs
+ *  are flushed every --per-event dabs, the way a motion event flushes
+ *  them; --per-event 1 gives one pass of the pixel processor per dab,
+ *  which is what every dab used to cost.  The results of one thread
+ *  and several threads are compared, they must be the same.
+ *  --precision picks the pixel traits the brush modes compute with.
+ */
+
+extern "C" {
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpcolor/gimpcolor.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "paint/paint-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/temp-buf.h"
+}
+
+#include "paint/gimpmypaintcore-surface.hpp"
+
+
+static gint   size           = 2000;
+static gint   threads        = 4;
+static gint   n_dabs         = 20000;
+static gint   per_event      = 64;
+static gchar *precision_name = NULL;
+
+static GimpMypaintPrecision precision = GIMP_MYPAINT_PRECISION_FLOAT;
+
+static const GOptionEntry entries[] =
+{
+  { "size", 's', 0, G_OPTION_ARG_INT, &size,
+    "Width and height of the canvas (default: 2000)", "PIXELS" },
+  { "threads", 't', 0, G_OPTION_ARG_INT, &threads,
+    "Number of threads to compare with one (default: 4)", "N" },
+  { "dabs", 'd', 0, G_OPTION_ARG_INT, &n_dabs,
+    "Number of dabs per stroke (default: 20000)", "N" },
+  { "per-event", 'e', 0, G_OPTION_ARG_INT, &per_event,
+    "Number of dabs per motion event (default: 64)", "N" },
+  { "precision", 'p', 0, G_OPTION_ARG_STRING, &precision_name,
+    "Precision of the brush modes: float, 8 or 15 (default: float)", "P" },
+  { NULL }
+};
+
+static const gfloat radii[] = { 2.0, 8.0, 32.0, 96.0 };
+
+
+/*  a stroke wandering over the canvas, the dabs half a radius apart  */
+static gfloat *
+make_stroke (gfloat radius)
+{
+  gfloat  *dabs  = g_new (gfloat, 2 * n_dabs);
+  gdouble  x     = size / 2;
+  gdouble  y     = size / 2;
+  gdouble  angle = 0.0;
+  gint     i;
+
+  for (i = 0; i < n_dabs; i++)
+    {
+      angle += g_random_double_range (-0.2, 0.2);
+      x     += cos (angle) * radius / 2;
+      y     += sin (angle) * radius / 2;
+
+      if (x < 0 || x >= size)
+        {
+          angle = G_PI - angle;
+          x     = CLAMP (x, 0, size - 1);
+        }
+      if (y < 0 || y >= size)
+        {
+          angle = -angle;
+          y     = CLAMP (y, 0, size - 1);
+        }
+
+      dabs[2 * i]     = x;
+      dabs[2 * i + 1] = y;
+    }
+
+  return dabs;
+}
+
+static gdouble
+time_stroke (TempBuf      *buf,
+             const gfloat *dabs,
+             gfloat        radius,
+             gint          events,
+             gint          n_threads)
+{
+  GimpMypaintSurface *surface = GimpMypaintSurface_TempBuf_new (buf);
+  GimpRGB             white   = { 1.0, 1.0, 1.0, 1.0 };
+  GimpCoords          coords  = { 0, };
+  GTimer             *timer;
+  gdouble             elapsed;
+  gint                i;
+
+  memset (temp_buf_get_data (buf), 255, buf->width * buf->height * buf->bytes);
+
+  pixel_processor_set_num_threads (n_threads);
+
+  surface->set_precision (precision);
+  surface->set_bg_color (&white);
+  surface->set_coords (&coords);
+  surface->begin_session ();
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_dabs; i++)
+    {
+      gfloat t = (gfloat) i / n_dabs;
+
+      surface->draw_dab (dabs[2 * i], dabs[2 * i + 1], radius,
+                         t, 0.5, 1.0 - t,
+                         0.5, 0.7);
+
+      if ((i + 1) % events == 0)
+        surface->flush_dabs ();
+    }
+
+  surface->end_session ();
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  delete surface;
+
+  return elapsed;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError         *error = NULL;
+  guchar          color[4] = { 255, 255, 255, 255 };
+  gint            i;
+
+  g_thread_init (NULL);
+  g_type_init ();
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  if (precision_name)
+    {
+      if (! strcmp (precision_name, "8"))
+        precision = GIMP_MYPAINT_PRECISION_8_BIT;
+      else if (! strcmp (precision_name, "15"))
+        precision = GIMP_MYPAINT_PRECISION_15_BIT;
+      else if (strcmp (precision_name, "float"))
+        {
+          g_printerr ("unknown precision '%s'\n", precision_name);
+          return EXIT_FAILURE;
+        }
+    }
+
+  threads   = CLAMP (threads, 1, GIMP_MAX_NUM_THREADS);
+  n_dabs    = MAX (n_dabs, 1);
+  per_event = MAX (per_event, 1);
+
+  pixel_processor_init (1);
+
+  g_print ("%dx%d RGBA canvas, %d dabs, %d dabs per event, %s precision\n\n",
+           size, size, n_dabs, per_event,
+           precision_name ? precision_name : "float");
+  g_print ("%6s %12s %12s %12s %12s %8s\n",
+           "radius", "1 thread", "dabs/s", "threads", "dabs/s", "result");
+
+  for (i = 0; i < G_N_ELEMENTS (radii); i++)
+    {
+      TempBuf *single_buf = temp_buf_new (size, size, 4, 0, 0, color);
+      TempBuf *multi_buf  = temp_buf_new (size, size, 4, 0, 0, color);
+      gfloat  *dabs       = make_stroke (radii[i]);
+      gdouble  single;
+      gdouble  multi;
+      gboolean same;
+
+      single = time_stroke (single_buf, dabs, radii[i], per_event, 1);
+      multi  = time_stroke (multi_buf,  dabs, radii[i], per_event, threads);
+
+      same = ! memcmp (temp_buf_get_data (single_buf),
+                       temp_buf_get_data (multi_buf),
+                       size * size * 4);
+
+      g_print ("%6.0f %12.3f %12.0f %12.3f %12.0f %8s\n",
+               radii[i],
+               single, n_dabs / single,
+               multi,  n_dabs / multi,
+               same ? "same" : "DIFFERS");
+
+      g_free (dabs);
+      temp_buf_free (single_buf);
+      temp_buf_free (multi_buf);
+    }
+
+  pixel_processor_exit ();
+
+  return EXIT_SUCCESS;
+}
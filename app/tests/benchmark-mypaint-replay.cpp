@@ -0,0 +1,358 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-mypaint-replay.cpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Replays stroke logs onto a temp buf the way GimpMypaintCore paints
+ *  them, one motion event at a time.  GIMP writes a log of each stroke
+ *  to the directory named by GIMP_MYPAINT_STROKE_LOG, so
+ *
+ *    benchmark-mypaint-replay $GIMP_MYPAINT_STROKE_LOG/mypaint-stroke-*.log
+ *
+ *  paints a session again.  The time of each motion event is split
+ *  into the brush, which computes the dabs and queues them, and the
+ *  flush, which draws them; ending the session of a stroke draws what
+ *  is left.  The fastest of --runs runs is reported, together with a
+ *  checksum of the canvas to spot changes in the painting.
+ */
+
+extern "C" {
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpcolor/gimpcolor.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "paint/paint-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/temp-buf.h"
+}
+
+#include "paint/gimpmypaintcore-surface.hpp"
+#include "paint/mypaintbrush-stroke.hpp"
+
+
+/*  room for the dabs around the coords of the strokes  */
+#define MARGIN 128
+
+static gint   threads        = 4;
+static gint   runs           = 3;
+static gchar *precision_name = NULL;
+
+static GimpMypaintPrecision precision = GIMP_MYPAINT_PRECISION_FLOAT;
+
+static const GOptionEntry entries[] =
+{
+  { "threads", 't', 0, G_OPTION_ARG_INT, &threads,
+    "Number of threads of the pixel processor (default: 4)", "N" },
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &runs,
+    "Number of runs, the fastest one is reported (default: 3)", "N" },
+  { "precision", 'p', 0, G_OPTION_ARG_STRING, &precision_name,
+    "Precision of the brush modes: float, 8 or 15 (default: float)", "P" },
+  { NULL }
+};
+
+
+/*  counts the dabs the brush draws onto the surface  */
+class CountingSurface : public Surface
+{
+  Surface *surface;
+
+public:
+  gint     n_dabs;
+
+  CountingSurface (Surface *surface) : surface (surface), n_dabs (0) {}
+
+  bool draw_dab (float x, float y,
+                 float radius,
+                 float color_r, float color_g, float color_b,
+                 float opaque, float hardness,
+                 float alpha_eraser,
+                 float aspect_ratio, float angle,
+                 float lock_alpha, float colorize,
+                 float texture_grain, float texture_contrast)
+  {
+    n_dabs++;
+
+    return surface->draw_dab (x, y, radius, color_r, color_g, color_b,
+                              opaque, hardness, alpha_eraser,
+                              aspect_ratio, angle, lock_alpha, colorize,
+                              texture_grain, texture_contrast);
+  }
+
+  void get_color (float x, float y,
+                  float radius,
+                  float *color_r, float *color_g, float *color_b,
+                  float *color_a,
+                  float hardness, float aspect_ratio, float angle,
+                  float texture_grain, float texture_contrast)
+  {
+    surface->get_color (x, y, radius, color_r, color_g, color_b, color_a,
+                        hardness, aspect_ratio, angle,
+                        texture_grain, texture_contrast);
+  }
+
+  void begin_session () { surface->begin_session (); }
+  void end_session   () { surface->end_session (); }
+};
+
+typedef struct
+{
+  gint    n_events;
+  gint    n_dabs;
+  gdouble brush;      /*  seconds in Brush::stroke_to()               */
+  gdouble flush;      /*  seconds in flush_dabs() after each event    */
+  gdouble end;        /*  seconds in end_session() after each stroke  */
+  gdouble max_event;  /*  the slowest motion event                    */
+} ReplayTimes;
+
+
+static Stroke *
+load_stroke (const gchar *filename,
+             Brush       *brush)
+{
+  GError *error  = NULL;
+  Stroke *stroke = Stroke::load (filename, brush, &error);
+
+  if (! stroke)
+    {
+      g_printerr ("%s\n", error->message);
+      g_clear_error (&error);
+    }
+
+  return stroke;
+}
+
+static gboolean
+replay (TempBuf      *buf,
+        gchar       **filenames,
+        ReplayTimes  *times)
+{
+  GimpMypaintSurface *surface = GimpMypaintSurface_TempBuf_new (buf);
+  CountingSurface     counter (surface);
+  GTimer             *timer   = g_timer_new ();
+  gint                i;
+
+  memset (temp_buf_get_data (buf), 255, buf->width * buf->height * buf->bytes);
+  memset (times, 0, sizeof (ReplayTimes));
+
+  surface->set_precision (precision);
+
+  for (i = 0; filenames[i]; i++)
+    {
+      Brush  brush;
+      Stroke *stroke = load_stroke (filenames[i], &brush);
+
+      if (! stroke)
+        {
+          delete surface;
+          g_timer_destroy (timer);
+          return FALSE;
+        }
+
+      const Stroke::SurfaceSettings *settings =
+        stroke->get_surface_settings ();
+      GimpRGB bg_color = settings->bg_color;
+
+      surface->set_bg_color (&bg_color);
+      surface->set_floating_stroke (settings->floating_stroke);
+      surface->set_stroke_opacity (settings->stroke_opacity);
+      surface->begin_session ();
+
+      const std::vector<Stroke::StrokeRecord> &records = stroke->get_records ();
+
+      for (std::vector<Stroke::StrokeRecord>::const_iterator record = records.begin ();
+           record != records.end ();
+           record++)
+        {
+          gdouble brush_time;
+          gdouble flush_time;
+
+          surface->set_coords (&record->coords);
+
+          g_timer_start (timer);
+          brush.stroke_to (&counter,
+                           record->coords.x, record->coords.y,
+                           record->coords.pressure,
+                           record->coords.xtilt, record->coords.ytilt,
+                           record->dtime);
+          brush_time = g_timer_elapsed (timer, NULL);
+
+          g_timer_start (timer);
+          surface->flush_dabs ();
+          flush_time = g_timer_elapsed (timer, NULL);
+
+          times->brush     += brush_time;
+          times->flush     += flush_time;
+          times->max_event  = MAX (times->max_event, brush_time + flush_time);
+        }
+
+      g_timer_start (timer);
+      surface->end_session ();
+      times->end += g_timer_elapsed (timer, NULL);
+
+      times->n_events += records.size ();
+
+      delete stroke;
+    }
+
+  times->n_dabs = counter.n_dabs;
+
+  g_timer_destroy (timer);
+  delete surface;
+
+  return TRUE;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError         *error = NULL;
+  guchar          color[4] = { 255, 255, 255, 255 };
+  gchar         **filenames;
+  gdouble         width  = 1;
+  gdouble         height = 1;
+  TempBuf        *buf;
+  ReplayTimes     best;
+  gchar          *checksum;
+  gint            i;
+
+  g_thread_init (NULL);
+  g_type_init ();
+
+  context = g_option_context_new ("LOG...");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  if (argc < 2)
+    {
+      g_printerr ("No stroke logs to replay\n");
+      return EXIT_FAILURE;
+    }
+
+  if (precision_name)
+    {
+      if (! strcmp (precision_name, "8"))
+        precision = GIMP_MYPAINT_PRECISION_8_BIT;
+      else if (! strcmp (precision_name, "15"))
+        precision = GIMP_MYPAINT_PRECISION_15_BIT;
+      else if (strcmp (precision_name, "float"))
+        {
+          g_printerr ("unknown precision '%s'\n", precision_name);
+          return EXIT_FAILURE;
+        }
+    }
+
+  threads = CLAMP (threads, 1, GIMP_MAX_NUM_THREADS);
+  runs    = MAX (runs, 1);
+
+  filenames = argv + 1;
+
+  /*  a canvas that holds all the strokes  */
+  for (i = 0; filenames[i]; i++)
+    {
+      Brush   brush;
+      Stroke *stroke = load_stroke (filenames[i], &brush);
+
+      if (! stroke)
+        return EXIT_FAILURE;
+
+      const std::vector<Stroke::StrokeRecord> &records = stroke->get_records ();
+
+      for (std::vector<Stroke::StrokeRecord>::const_iterator record = records.begin ();
+           record != records.end ();
+           record++)
+        {
+          width  = MAX (width,  record->coords.x);
+          height = MAX (height, record->coords.y);
+        }
+
+      delete stroke;
+    }
+
+  width  = MIN (ceil (width)  + MARGIN, GIMP_MAX_IMAGE_SIZE);
+  height = MIN (ceil (height) + MARGIN, GIMP_MAX_IMAGE_SIZE);
+
+  pixel_processor_init (threads);
+
+  buf = temp_buf_new (width, height, 4, 0, 0, color);
+
+  for (i = 0; i < runs; i++)
+    {
+      ReplayTimes times;
+
+      if (! replay (buf, filenames, &times))
+        return EXIT_FAILURE;
+
+      if (i == 0 ||
+          times.brush + times.flush + times.end <
+          best.brush + best.flush + best.end)
+        {
+          best = times;
+        }
+    }
+
+  checksum = g_compute_checksum_for_data (G_CHECKSUM_MD5,
+                                          temp_buf_get_data (buf),
+                                          buf->width * buf->height * 4);
+
+  {
+    gdouble total = best.brush + best.flush + best.end;
+
+    g_print ("%d stroke logs, %d motion events, %d dabs on a %dx%d canvas\n",
+             argc - 1, best.n_events, best.n_dabs, buf->width, buf->height);
+    g_print ("%d threads, %s precision, fastest of %d runs\n\n",
+             threads, precision_name ? precision_name : "float", runs);
+
+    g_print ("%-18s %10.3f s\n",  "total", total);
+    g_print ("%-18s %10.0f\n",    "dabs/s", best.n_dabs / total);
+    g_print ("%-18s %10.3f ms\n", "ms per event",
+             1000.0 * (best.brush + best.flush) / MAX (best.n_events, 1));
+    g_print ("%-18s %10.3f ms\n\n", "slowest event", 1000.0 * best.max_event);
+
+    g_print ("%-18s %10.3f s %5.1f%%\n", "brush",
+             best.brush, 100.0 * best.brush / total);
+    g_print ("%-18s %10.3f s %5.1f%%\n", "flush",
+             best.flush, 100.0 * best.flush / total);
+    g_print ("%-18s %10.3f s %5.1f%%\n\n", "end of stroke",
+             best.end, 100.0 * best.end / total);
+
+    g_print ("canvas checksum %s\n", checksum);
+  }
+
+  g_free (checksum);
+  temp_buf_free (buf);
+
+  pixel_processor_exit ();
+
+  return EXIT_SUCCESS;
+}
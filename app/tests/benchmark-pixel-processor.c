@@ -0,0 +1,171 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-pixel-processor.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Measures how pixel_regions_process_parallel() scales with the
+ *  number of threads.  The per-tile work is deliberately trivial, so
+ *  the timings are dominated by tile locking, the tile cache and the
+ *  scheduling overhead of the pixel processor.
+ */
+
+#include <stdlib.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/pixel-region.h"
+#include "base/tile-cache.h"
+#include "base/tile-manager.h"
+#include "base/tile-swap.h"
+
+
+static gint    size       = 20000;
+static gint    bpp        = 1;
+static gint    max_thread = GIMP_MAX_NUM_THREADS;
+static gint    iterations = 3;
+
+static const GOptionEntry entries[] =
+{
+  { "size", 's', 0, G_OPTION_ARG_INT, &size,
+    "Width and height of the test image (default: 20000)", "PIXELS" },
+  { "bpp", 'b', 0, G_OPTION_ARG_INT, &bpp,
+    "Bytes per pixel of the test image (default: 1)", "BPP" },
+  { "threads", 't', 0, G_OPTION_ARG_INT, &max_thread,
+    "Maximum number of threads to test", "N" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+    "Number of passes per thread count (default: 3)", "N" },
+  { NULL }
+};
+
+
+static void
+benchmark_invert (gpointer     data,
+                  PixelRegion *srcPR,
+                  PixelRegion *destPR)
+{
+  const guchar *src  = srcPR->data;
+  guchar       *dest = destPR->data;
+  gint          h    = srcPR->h;
+
+  while (h--)
+    {
+      const guchar *s = src;
+      guchar       *d = dest;
+      gint          n = srcPR->w * srcPR->bytes;
+
+      while (n--)
+        *d++ = 255 - *s++;
+
+      src  += srcPR->rowstride;
+      dest += destPR->rowstride;
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError         *error = NULL;
+  TileManager    *src;
+  TileManager    *dest;
+  PixelRegion     srcPR;
+  PixelRegion     destPR;
+  GTimer         *timer;
+  gdouble         base_time = 0.0;
+  gint            threads;
+
+  g_thread_init (NULL);
+  g_type_init ();
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  max_thread = CLAMP (max_thread, 1, GIMP_MAX_NUM_THREADS);
+  bpp        = CLAMP (bpp, 1, 4);
+
+  /*  keep everything in memory, we are not measuring the swap file  */
+  tile_cache_init (G_MAXUINT64);
+  tile_swap_init (g_get_tmp_dir ());
+
+  src  = tile_manager_new (size, size, bpp);
+  dest = tile_manager_new (size, size, bpp);
+
+  /*  fault in all tiles once so the first run isn't penalized  */
+  pixel_processor_init (1);
+  pixel_region_init (&srcPR,  src,  0, 0, size, size, FALSE);
+  pixel_region_init (&destPR, dest, 0, 0, size, size, TRUE);
+  pixel_regions_process_parallel ((PixelProcessorFunc) benchmark_invert,
+                                  NULL, 2, &srcPR, &destPR);
+
+  g_print ("%d x %d pixels, %d bpp, %d iterations\n\n",
+           size, size, bpp, iterations);
+  g_print ("threads   seconds   Mpixels/s   speedup\n");
+
+  timer = g_timer_new ();
+
+  for (threads = 1; threads <= max_thread; threads++)
+    {
+      gdouble elapsed;
+      gint    i;
+
+      pixel_processor_set_num_threads (threads);
+
+      g_timer_start (timer);
+
+      for (i = 0; i < iterations; i++)
+        {
+          pixel_region_init (&srcPR,  src,  0, 0, size, size, FALSE);
+          pixel_region_init (&destPR, dest, 0, 0, size, size, TRUE);
+
+          pixel_regions_process_parallel ((PixelProcessorFunc) benchmark_invert,
+                                          NULL, 2, &srcPR, &destPR);
+        }
+
+      elapsed = g_timer_elapsed (timer, NULL) / iterations;
+
+      if (threads == 1)
+        base_time = elapsed;
+
+      g_print ("%7d   %7.3f   %9.1f   %7.2f\n",
+               threads, elapsed,
+               (gdouble) size * size / elapsed / 1e6,
+               base_time / elapsed);
+    }
+
+  g_timer_destroy (timer);
+
+  tile_manager_unref (src);
+  tile_manager_unref (dest);
+
+  pixel_processor_exit ();
+  tile_cache_exit ();
+  tile_swap_exit ();
+
+  return EXIT_SUCCESS;
+}
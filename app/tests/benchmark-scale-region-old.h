@@ -0,0 +1,32 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-scale-region-old.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BENCHMARK_SCALE_REGION_OLD_H__
+#define __BENCHMARK_SCALE_REGION_OLD_H__
+
+
+/*  scale_region() before it ran on the pixel processor  */
+void   scale_region_old (PixelRegion           *srcPR,
+                         PixelRegion           *dstPR,
+                         GimpInterpolationType  interpolation,
+                         GimpProgressFunc       progress_callback,
+                         gpointer               progress_data);
+
+
+#endif /* __BENCHMARK_SCALE_REGION_OLD_H__ */
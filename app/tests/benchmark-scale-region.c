@@ -0,0 +1,247 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * benchmark-scale-region.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Times scale_region() on an RGBA image for every interpolation, up
+ *  and down, against scale_region_old(), the code it replaced, and
+ *  checks its result against the old one.  scale_region() runs with
+ *  the generic row kernels on one thread, with the accelerated ones
+ *  the CPU supports on one thread and on several.  Reports the times,
+ *  the speedup of the last over the old code, the largest difference
+ *  and the number of channels off by more than the tolerance; the
+ *  colors of transparent pixels are not compared.  The factors below
+ *  0.5 include the decimation steps.
+ */
+
+#include <stdlib.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "base/base-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/pixel-region.h"
+#include "base/tile-cache.h"
+#include "base/tile-manager.h"
+#include "base/tile-swap.h"
+
+#include "paint-funcs/scale-region.h"
+
+#include "benchmark-scale-region-old.h"
+
+
+#define BYTES  4
+#define ALPHA  3
+
+
+static gint size       = 1000;
+static gint threads    = 4;
+static gint iterations = 3;
+static gint tolerance  = 1;
+
+static const GOptionEntry entries[] =
+{
+  { "size", 's', 0, G_OPTION_ARG_INT, &size,
+    "Width and height of the source image (default: 1000)", "PIXELS" },
+  { "threads", 't', 0, G_OPTION_ARG_INT, &threads,
+    "Number of threads to compare with one (default: 4)", "N" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+    "Number of passes per scale (default: 3)", "N" },
+  { "tolerance", 'T', 0, G_OPTION_ARG_INT, &tolerance,
+    "Largest difference to the old code accepted (default: 1)", "N" },
+  { NULL }
+};
+
+static const gdouble factors[] = { 1.7, 0.75, 0.4, 0.3, 0.15 };
+
+
+typedef void (* ScaleFunc) (PixelRegion           *srcPR,
+                            PixelRegion           *destPR,
+                            GimpInterpolationType  interpolation,
+                            GimpProgressFunc       progress_callback,
+                            gpointer               progress_data);
+
+
+static gdouble
+time_scale (ScaleFunc              func,
+            TileManager           *src,
+            TileManager           *dest,
+            GimpInterpolationType  interpolation,
+            guint                  accel,
+            gint                   n_threads)
+{
+  GTimer  *timer;
+  gdouble  elapsed;
+  gint     i;
+
+  scale_region_init (accel);
+  pixel_processor_set_num_threads (n_threads);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < iterations; i++)
+    {
+      PixelRegion srcPR;
+      PixelRegion destPR;
+
+      pixel_region_init (&srcPR, src, 0, 0, size, size, FALSE);
+      pixel_region_init (&destPR, dest,
+                         0, 0,
+                         tile_manager_width (dest), tile_manager_height (dest),
+                         TRUE);
+
+      func (&srcPR, &destPR, interpolation, NULL, NULL);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL) / iterations;
+  g_timer_destroy (timer);
+
+  return elapsed;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  const guint            support = gimp_cpu_accel_get_support ();
+  GOptionContext        *context;
+  GError                *error   = NULL;
+  TileManager           *src;
+  guchar                *data;
+  GimpInterpolationType  interpolation;
+  gint                   i;
+
+  g_thread_init (NULL);
+  g_type_init ();
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (! g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  g_option_context_free (context);
+
+  threads = CLAMP (threads, 1, GIMP_MAX_NUM_THREADS);
+
+  /*  keep everything in memory, we are not measuring the swap file  */
+  tile_cache_init (G_MAXUINT64);
+  tile_swap_init (g_get_tmp_dir ());
+  pixel_processor_init (1);
+
+  /*  random pixels, with runs of transparent and opaque alpha  */
+  data = g_new (guchar, size * size * BYTES);
+
+  for (i = 0; i < size * size * BYTES; i++)
+    data[i] = g_random_int_range (0, 256);
+
+  for (i = ALPHA; i < size * size * BYTES; i += BYTES)
+    {
+      switch ((i / BYTES / 16) % 3)
+        {
+        case 0: data[i] = 0;   break;
+        case 1: data[i] = 255; break;
+        }
+    }
+
+  src = tile_manager_new (size, size, BYTES);
+  tile_manager_write_pixel_data (src, 0, 0, size - 1, size - 1,
+                                 data, size * BYTES);
+
+  g_print ("%dx%d RGBA pixels, %d iterations, tolerance %d\n\n",
+           size, size, iterations, tolerance);
+  g_print ("%-8s %6s %9s %9s %9s %9s %8s %5s %9s\n",
+           "interp", "scale", "old", "generic", "accel", "threads",
+           "speedup", "max", "off");
+
+  for (interpolation = GIMP_INTERPOLATION_NONE;
+       interpolation <= GIMP_INTERPOLATION_LANCZOS;
+       interpolation++)
+    {
+      for (i = 0; i < G_N_ELEMENTS (factors); i++)
+        {
+          const gint   width    = MAX (1, size * factors[i]);
+          const gint   height   = MAX (1, size * factors[i]);
+          const gint   n        = width * height * BYTES;
+          TileManager *dest     = tile_manager_new (width, height, BYTES);
+          guchar      *result   = g_new (guchar, n);
+          guchar      *expected = g_new (guchar, n);
+          gdouble      old;
+          gdouble      generic;
+          gdouble      accel;
+          gdouble      multi;
+          gint         max_diff = 0;
+          gint         off      = 0;
+          const gchar *nick;
+          gint         k;
+
+          old = time_scale (scale_region_old, src, dest, interpolation,
+                            0, 1);
+          tile_manager_read_pixel_data (dest, 0, 0, width - 1, height - 1,
+                                        expected, width * BYTES);
+
+          generic = time_scale (scale_region, src, dest, interpolation,
+                                0, 1);
+          accel   = time_scale (scale_region, src, dest, interpolation,
+                                support, 1);
+          multi   = time_scale (scale_region, src, dest, interpolation,
+                                support, threads);
+          tile_manager_read_pixel_data (dest, 0, 0, width - 1, height - 1,
+                                        result, width * BYTES);
+
+          for (k = 0; k < n; k++)
+            {
+              const gint pixel = k - k % BYTES;
+              gint       diff  = ABS (result[k] - expected[k]);
+
+              if (! result[pixel + ALPHA] && ! expected[pixel + ALPHA])
+                continue;
+
+              max_diff = MAX (max_diff, diff);
+
+              if (diff > tolerance)
+                off++;
+            }
+
+          gimp_enum_get_value (GIMP_TYPE_INTERPOLATION_TYPE, interpolation,
+                               NULL, &nick, NULL, NULL);
+
+          g_print ("%-8s %6.2f %9.3f %9.3f %9.3f %9.3f %8.2f %5d %9d%s\n",
+                   nick, factors[i], old, generic, accel, multi, old / multi,
+                   max_diff, off, off ? " *" : "");
+
+          g_free (result);
+          g_free (expected);
+          tile_manager_unref (dest);
+        }
+    }
+
+  g_free (data);
+  tile_manager_unref (src);
+
+  pixel_processor_exit ();
+  tile_cache_exit ();
+  tile_swap_exit ();
+
+  return EXIT_SUCCESS;
+}
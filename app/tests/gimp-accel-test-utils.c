@@ -0,0 +1,59 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "gimp-accel-test-utils.h"
+
+
+static const struct
+{
+  const gchar *name;
+  guint        accel;
+}
+levels[] =
+{
+  { "generic", 0 },
+  { "sse2",    GIMP_CPU_ACCEL_X86_SSE2 },
+  { "avx2",    GIMP_CPU_ACCEL_X86_SSE2 | GIMP_CPU_ACCEL_X86_AVX2 }
+};
+
+
+gboolean
+gimp_test_utils_get_accel (gint          n,
+                           const gchar **name,
+                           guint        *accel)
+{
+  const guint support = gimp_cpu_accel_get_support ();
+
+  g_return_val_if_fail (n >= 0, FALSE);
+  g_return_val_if_fail (name != NULL, FALSE);
+  g_return_val_if_fail (accel != NULL, FALSE);
+
+  if (n >= G_N_ELEMENTS (levels) ||
+      (levels[n].accel & support) != levels[n].accel)
+    return FALSE;
+
+  *name  = levels[n].name;
+  *accel = levels[n].accel;
+
+  return TRUE;
+}
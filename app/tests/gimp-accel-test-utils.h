@@ -0,0 +1,32 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_ACCEL_TEST_UTILS_H__
+#define __GIMP_ACCEL_TEST_UTILS_H__
+
+
+/*  The levels of CPU acceleration to pass to the foo_init() functions
+ *  of base/accel-funcs.h, to compare their implementations:  "generic",
+ *  "sse2" and "avx2", each including the ones before.  Returns FALSE
+ *  from the first level the CPU doesn't support on.
+ */
+gboolean   gimp_test_utils_get_accel (gint          n,
+                                      const gchar **name,
+                                      guint        *accel);
+
+
+#endif /* __GIMP_ACCEL_TEST_UTILS_H__ */
@@ -0,0 +1,239 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-box-filter.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks that the accelerated box filters the CPU supports compute
+ *  exactly what the generic ones do.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "base/base-types.h"
+
+#include "base/box-filter.h"
+
+#include "gimp-accel-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/box-filter/" #function, function);
+
+/*  odd, so the accelerated versions have to handle a tail  */
+#define MAX_WIDTH     67
+#define N_ROWS        2000
+#define N_PIXELS      200000
+
+
+/*  Random data, with the alpha channel of every pixel of a row
+ *  transparent, opaque or random, to hit the special cases of the
+ *  pre-multiplying filters.
+ */
+static void
+fill_row (GRand  *rand,
+          guchar *row,
+          gint    n_pixels,
+          gint    bpp)
+{
+  const gint mode = g_rand_int_range (rand, 0, 4);
+  gint       i;
+
+  for (i = 0; i < n_pixels * bpp; i++)
+    {
+      row[i] = g_rand_int_range (rand, 0, 256);
+
+      if (i % bpp == bpp - 1)
+        {
+          switch (mode)
+            {
+            case 1: row[i] = 0;   break;
+            case 2: row[i] = 255; break;
+            case 3: row[i] = g_rand_boolean (rand) ? 0 : 255; break;
+            }
+        }
+    }
+}
+
+static gboolean
+compare_halve (BoxFilterHalveFunc  expected_func,
+               BoxFilterHalveFunc  func,
+               const guchar       *src0,
+               const guchar       *src1,
+               gint                width,
+               gint                bpp)
+{
+  guchar expected[MAX_WIDTH * 4 + 1];
+  guchar actual[MAX_WIDTH * 4 + 1];
+
+  /*  the byte after the row must not be touched  */
+  memset (expected, 0x55, sizeof (expected));
+  memset (actual,   0x55, sizeof (actual));
+
+  expected_func (src0, src1, expected, width);
+  func          (src0, src1, actual,   width);
+
+  return memcmp (expected, actual, width * bpp + 1) == 0;
+}
+
+/**
+ * halve:
+ *
+ * Rows of every width and bpp are averaged alike by all halving
+ * functions, with and without pre-multiplying.
+ **/
+static void
+halve (void)
+{
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (1);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      BoxFilterFuncs funcs;
+      gint           row;
+
+      box_filter_init (accel);
+      funcs = box_filter_funcs;
+
+      for (row = 0; row < N_ROWS; row++)
+        {
+          const gint bpp   = g_rand_int_range (rand, 1, 5);
+          const gint width = g_rand_int_range (rand, 0, MAX_WIDTH + 1);
+          guchar     src0[MAX_WIDTH * 2 * 4];
+          guchar     src1[MAX_WIDTH * 2 * 4];
+
+          fill_row (rand, src0, width * 2, bpp);
+          fill_row (rand, src1, width * 2, bpp);
+
+          if (! compare_halve (box_filter_generic_funcs.halve[bpp - 1],
+                               funcs.halve[bpp - 1],
+                               src0, src1, width, bpp))
+            g_error ("%s: halve, bpp %d, width %d", name, bpp, width);
+
+          if (! compare_halve (box_filter_generic_funcs.halve_premult[bpp - 1],
+                               funcs.halve_premult[bpp - 1],
+                               src0, src1, width, bpp))
+            g_error ("%s: halve_premult, bpp %d, width %d", name, bpp, width);
+        }
+    }
+
+  box_filter_init (support);
+  g_rand_free (rand);
+}
+
+/**
+ * filter:
+ *
+ * Single pixels are filtered alike from random neighbourhoods, with
+ * weights in the footprint range of the display renderer.
+ **/
+static void
+filter (void)
+{
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (2);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      BoxFilterFuncs funcs;
+      gint           n;
+
+      box_filter_init (accel);
+      funcs = box_filter_funcs;
+
+      for (n = 0; n < N_PIXELS; n++)
+        {
+          const gint    bpp         = g_rand_int_range (rand, 1, 5);
+          const guint   footprint_x = g_rand_int_range (rand, 256, 513);
+          const guint   footprint_y = g_rand_int_range (rand, 256, 513);
+          const guint   left        = g_rand_int_range (rand, 0, footprint_x / 2 + 1);
+          const guint   right       = g_rand_int_range (rand, 0, footprint_x / 2 + 1);
+          const guint   top         = g_rand_int_range (rand, 0, footprint_y / 2 + 1);
+          const guint   bottom      = g_rand_int_range (rand, 0, footprint_y / 2 + 1);
+          const guint   center      = footprint_x - left - right;
+          const guint   middle      = footprint_y - top - bottom;
+          guchar        pixels[9][4];
+          const guchar *src[9];
+          guchar        expected[4];
+          guchar        actual[4];
+          gint          k;
+
+          for (k = 0; k < 9; k++)
+            {
+              fill_row (rand, pixels[k], 1, bpp);
+              src[k] = pixels[k];
+            }
+
+          memset (expected, 0x55, sizeof (expected));
+          memset (actual,   0x55, sizeof (actual));
+
+          box_filter_generic_funcs.filter (left, center, right,
+                                           top, middle, bottom,
+                                           src, expected, bpp);
+          funcs.filter (left, center, right,
+                        top, middle, bottom,
+                        src, actual, bpp);
+
+          if (memcmp (expected, actual, sizeof (expected)))
+            g_error ("%s: filter, bpp %d", name, bpp);
+
+          if (bpp != 2 && bpp != 4)
+            continue;
+
+          memset (expected, 0x55, sizeof (expected));
+          memset (actual,   0x55, sizeof (actual));
+
+          box_filter_generic_funcs.filter_premult (left, center, right,
+                                                   top, middle, bottom,
+                                                   src, expected, bpp);
+          funcs.filter_premult (left, center, right,
+                                top, middle, bottom,
+                                src, actual, bpp);
+
+          if (memcmp (expected, actual, sizeof (expected)))
+            g_error ("%s: filter_premult, bpp %d", name, bpp);
+        }
+    }
+
+  box_filter_init (support);
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (halve);
+  ADD_TEST (filter);
+
+  return g_test_run ();
+}
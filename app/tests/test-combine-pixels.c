@@ -0,0 +1,321 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-combine-pixels.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks that the specialised combine functions compute what the
+ *  combine_*_pixels() functions do when all channels are affected,
+ *  and that the accelerated ones the CPU supports compute exactly
+ *  what the generic ones do.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-funcs/paint-funcs-types.h"
+
+#include "paint-funcs/combine-pixels.h"
+#include "paint-funcs/paint-funcs.h"
+
+#include "gimp-accel-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/combine-pixels/" #function, function);
+
+/*  odd, so the accelerated versions have to handle a tail  */
+#define MAX_WIDTH     67
+#define N_ROWS        20000
+
+
+typedef enum
+{
+  INTEN_INTEN,
+  INTEN_INTEN_A,
+  INTEN_A_INTEN,
+  INTEN_A_INTEN_A
+} CombineType;
+
+static const gboolean affect[MAX_CHANNELS] = { TRUE, TRUE, TRUE, TRUE };
+
+
+/*  Random data, with the alpha channel of every pixel of a row
+ *  transparent, opaque or random, to hit the special cases.
+ */
+static void
+fill_row (GRand  *rand,
+          guchar *row,
+          gint    n_pixels,
+          gint    bytes,
+          gint    alpha)
+{
+  const gint mode = g_rand_int_range (rand, 0, 4);
+  gint       i;
+
+  for (i = 0; i < n_pixels * bytes; i++)
+    {
+      row[i] = g_rand_int_range (rand, 0, 256);
+
+      if (i % bytes == alpha)
+        {
+          switch (mode)
+            {
+            case 1: row[i] = 0;   break;
+            case 2: row[i] = 255; break;
+            case 3: row[i] = g_rand_boolean (rand) ? 0 : 255; break;
+            }
+        }
+    }
+}
+
+static CombinePixelsFunc
+get_func (const CombinePixelsFuncs *funcs,
+          CombineType               type,
+          gint                      bytes,
+          gboolean                  mode_affect)
+{
+  switch (type)
+    {
+    case INTEN_INTEN:     return funcs->inten_inten[bytes - 1];
+    case INTEN_INTEN_A:   return funcs->inten_inten_a[bytes - 1];
+    case INTEN_A_INTEN:   return funcs->inten_a_inten[mode_affect][bytes - 1];
+    case INTEN_A_INTEN_A: return funcs->inten_a_inten_a[mode_affect][bytes - 1];
+    }
+
+  return NULL;
+}
+
+/*  the old functions, in place like the projection uses them  */
+static void
+combine_legacy (CombineType   type,
+                const guchar *src1,
+                const guchar *src2,
+                guchar       *dest,
+                const guchar *mask,
+                guint         opacity,
+                gboolean      mode_affect,
+                gint          width,
+                gint          bytes)
+{
+  memcpy (dest, src1, width * bytes);
+
+  switch (type)
+    {
+    case INTEN_INTEN:
+      combine_inten_and_inten_pixels (src1, src2, dest, mask, opacity,
+                                      affect, width, bytes);
+      break;
+
+    case INTEN_INTEN_A:
+      combine_inten_and_inten_a_pixels (src1, src2, dest, mask, opacity,
+                                        affect, width, bytes);
+      break;
+
+    case INTEN_A_INTEN:
+      combine_inten_a_and_inten_pixels (src1, src2, dest, mask, opacity,
+                                        affect, mode_affect, width, bytes);
+      break;
+
+    case INTEN_A_INTEN_A:
+      combine_inten_a_and_inten_a_pixels (src1, src2, dest, mask, opacity,
+                                          affect, mode_affect, width, bytes);
+      break;
+    }
+}
+
+typedef struct
+{
+  CombineType   type;
+  gint          bytes;
+  gint          src2_bytes;
+  gboolean      mode_affect;
+  guint         opacity;
+  gint          width;
+  guchar        src1[MAX_WIDTH * 4];
+  guchar        src2[MAX_WIDTH * 4];
+  guchar        mask[MAX_WIDTH + sizeof (gint)];
+  const guchar *m;
+} Row;
+
+/*  a random row of a random combination, sometimes masked, with the
+ *  mask misaligned and partly empty to hit the skipping of the old
+ *  functions
+ */
+static void
+random_row (GRand *rand,
+            Row   *row)
+{
+  row->type        = g_rand_int_range (rand, INTEN_INTEN, INTEN_A_INTEN_A + 1);
+  row->mode_affect = g_rand_boolean (rand);
+  row->opacity     = (g_rand_boolean (rand) ?
+                      OPAQUE_OPACITY : g_rand_int_range (rand, 0, 256));
+  row->width       = g_rand_int_range (rand, 0, MAX_WIDTH + 1);
+
+  switch (row->type)
+    {
+    case INTEN_INTEN:
+      row->bytes      = g_rand_boolean (rand) ? 1 : 3;
+      row->src2_bytes = row->bytes;
+      break;
+
+    case INTEN_INTEN_A:
+      row->bytes      = g_rand_boolean (rand) ? 1 : 3;
+      row->src2_bytes = row->bytes + 1;
+      break;
+
+    case INTEN_A_INTEN:
+      row->bytes      = g_rand_boolean (rand) ? 2 : 4;
+      row->src2_bytes = row->bytes - 1;
+      break;
+
+    case INTEN_A_INTEN_A:
+      row->bytes      = g_rand_boolean (rand) ? 2 : 4;
+      row->src2_bytes = row->bytes;
+      break;
+    }
+
+  fill_row (rand, row->src1, row->width, row->bytes, row->bytes - 1);
+  fill_row (rand, row->src2, row->width, row->src2_bytes,
+            row->type == INTEN_INTEN_A ? row->bytes : row->bytes - 1);
+  fill_row (rand, row->mask, MAX_WIDTH + sizeof (gint), 1, 0);
+
+  if (g_rand_boolean (rand))
+    {
+      gint start = g_rand_int_range (rand, 0, MAX_WIDTH);
+      gint end   = g_rand_int_range (rand, start, MAX_WIDTH + 1);
+
+      memset (row->mask + start, 0, end - start);
+    }
+
+  row->m = (g_rand_boolean (rand) ?
+            row->mask + g_rand_int_range (rand, 0, sizeof (gint)) : NULL);
+}
+
+/**
+ * generic:
+ *
+ * The specialised generic functions compute what the old ones do.
+ **/
+static void
+generic (void)
+{
+  GRand *rand = g_rand_new_with_seed (1);
+  gint   n;
+
+  for (n = 0; n < N_ROWS; n++)
+    {
+      Row               row;
+      CombinePixelsFunc func;
+      guchar            expected[MAX_WIDTH * 4 + 1];
+      guchar            actual[MAX_WIDTH * 4 + 1];
+
+      random_row (rand, &row);
+
+      func = get_func (&combine_pixels_generic_funcs,
+                       row.type, row.bytes, row.mode_affect);
+
+      /*  the byte after the row must not be touched  */
+      memset (expected, 0x55, sizeof (expected));
+      memset (actual,   0x55, sizeof (actual));
+
+      combine_legacy (row.type, row.src1, row.src2, expected, row.m,
+                      row.opacity, row.mode_affect, row.width, row.bytes);
+
+      memcpy (actual, row.src1, row.width * row.bytes);
+      func (row.src1, row.src2, actual, row.m, row.opacity, row.width);
+
+      if (memcmp (expected, actual, row.width * row.bytes + 1))
+        g_error ("generic: type %d, bytes %d, opacity %d, width %d",
+                 row.type, row.bytes, row.opacity, row.width);
+    }
+
+  g_rand_free (rand);
+}
+
+/**
+ * accelerated:
+ *
+ * The accelerated functions compute what the generic ones do, also
+ * where dest is not src1.
+ **/
+static void
+accelerated (void)
+{
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (2);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      CombinePixelsFuncs funcs;
+      gint               n;
+
+      combine_pixels_init (accel);
+      funcs = combine_pixels_funcs;
+
+      for (n = 0; n < N_ROWS; n++)
+        {
+          Row               row;
+          CombinePixelsFunc expected_func;
+          CombinePixelsFunc func;
+          guchar            expected[MAX_WIDTH * 4 + 1];
+          guchar            actual[MAX_WIDTH * 4 + 1];
+
+          random_row (rand, &row);
+
+          expected_func = get_func (&combine_pixels_generic_funcs,
+                                    row.type, row.bytes, row.mode_affect);
+          func          = get_func (&funcs,
+                                    row.type, row.bytes, row.mode_affect);
+
+          memset (expected, 0x55, sizeof (expected));
+          memset (actual,   0x55, sizeof (actual));
+
+          expected_func (row.src1, row.src2, expected,
+                         row.m, row.opacity, row.width);
+          func          (row.src1, row.src2, actual,
+                         row.m, row.opacity, row.width);
+
+          if (memcmp (expected, actual, row.width * row.bytes + 1))
+            g_error ("%s: type %d, bytes %d, opacity %d, width %d",
+                     name, row.type, row.bytes, row.opacity, row.width);
+        }
+    }
+
+  combine_pixels_init (support);
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (generic);
+  ADD_TEST (accelerated);
+
+  return g_test_run ();
+}
@@ -0,0 +1,594 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-distance-transform.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks the distance transforms against searching all seeds, and
+ *  the mask morphology built on them against searching the pixels
+ *  around every pixel like the scans it replaced did.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "paint-funcs/paint-funcs-types.h"
+
+#include "base/pixel-region.h"
+
+#include "paint-funcs/distance-transform.h"
+#include "paint-funcs/paint-funcs.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/distance-transform/" #function, function);
+
+/*  wider than a tile, so there are several strips of columns  */
+#define MAX_SIZE      90
+/*  taller than several tiles, so there are several chunks of rows  */
+#define TALL_SIZE     300
+#define TALL_WIDTH    8
+#define MAX_RADIUS    12
+#define N_MASKS       200
+/*  around the regions, which the morphology must leave alone  */
+#define MARGIN        3
+
+
+/*  Seeds with a random density, from none at all to all pixels  */
+static guchar *
+random_seeds (GRand *rand,
+              gint   width,
+              gint   height)
+{
+  guchar     *seeds   = g_new (guchar, width * height);
+  const gint  density = g_rand_int_range (rand, 0, 41);
+  gint        i;
+
+  for (i = 0; i < width * height; i++)
+    seeds[i] = g_rand_int_range (rand, 0, 40) < density;
+
+  return seeds;
+}
+
+/*  Mostly square masks, and some narrow ones which are tall enough
+ *  to be transformed in chunks.
+ */
+static void
+random_size (GRand *rand,
+             gint  *width,
+             gint  *height)
+{
+  if (g_rand_int_range (rand, 0, 4))
+    {
+      *width  = g_rand_int_range (rand, 1, MAX_SIZE);
+      *height = g_rand_int_range (rand, 1, MAX_SIZE);
+    }
+  else
+    {
+      *width  = g_rand_int_range (rand, 1, TALL_WIDTH);
+      *height = g_rand_int_range (rand, MAX_SIZE, TALL_SIZE);
+    }
+}
+
+static gboolean
+is_seed (const guchar *seeds,
+         gint          width,
+         gint          height,
+         gboolean      seed_outside,
+         gint          x,
+         gint          y)
+{
+  if (x < 0 || x >= width || y < 0 || y >= height)
+    return seed_outside;
+
+  return seeds[y * width + x] != 0;
+}
+
+/**
+ * euclidean:
+ *
+ * The distances are those to the nearest seed, with and without the
+ * seeds around the mask.
+ **/
+static void
+euclidean (void)
+{
+  GRand *rand = g_rand_new_with_seed (1);
+  gint   n;
+
+  for (n = 0; n < N_MASKS; n++)
+    {
+      gint            width;
+      gint            height;
+      gboolean        seed_outside;
+      guchar         *seeds;
+      gfloat         *dist;
+      gint            x, y;
+
+      random_size (rand, &width, &height);
+
+      seed_outside = g_rand_boolean (rand);
+      seeds        = random_seeds (rand, width, height);
+      dist         = g_new (gfloat, width * height);
+
+      distance_transform_euclidean (seeds, width, height, seed_outside, dist);
+
+      for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+          {
+            gint   nearest = -1;
+            gfloat expected;
+            gint   i, j;
+
+            for (j = -1; j <= height; j++)
+              for (i = -1; i <= width; i++)
+                if (is_seed (seeds, width, height, seed_outside, i, j))
+                  {
+                    gint d = SQR (i - x) + SQR (j - y);
+
+                    if (nearest < 0 || d < nearest)
+                      nearest = d;
+                  }
+
+            expected = (nearest < 0) ? G_MAXFLOAT : sqrt (nearest);
+
+            if (dist[y * width + x] != expected)
+              g_error ("%dx%d, pixel %d,%d: %g instead of %g",
+                       width, height, x, y, dist[y * width + x], expected);
+          }
+
+      g_free (seeds);
+      g_free (dist);
+    }
+
+  g_rand_free (rand);
+}
+
+/**
+ * dilate:
+ *
+ * Exactly the pixels within the element around a seed are covered,
+ * for random elements.
+ **/
+static void
+dilate (void)
+{
+  GRand *rand = g_rand_new_with_seed (2);
+  gint   n;
+
+  for (n = 0; n < N_MASKS; n++)
+    {
+      gint            width;
+      gint            height;
+      gint            radius;
+      gboolean        seed_outside;
+      guchar         *seeds;
+      guchar         *dest;
+      gint            heights[MAX_RADIUS];
+      gint            x, y;
+
+      random_size (rand, &width, &height);
+
+      radius       = g_rand_int_range (rand, 0, MAX_RADIUS);
+      seed_outside = g_rand_boolean (rand);
+      seeds        = random_seeds (rand, width, height);
+      dest         = g_new (guchar, width * height);
+
+      /*  not increasing away from the middle column  */
+      heights[0] = g_rand_int_range (rand, 0, MAX_RADIUS);
+
+      for (x = 1; x <= radius; x++)
+        heights[x] = g_rand_int_range (rand, 0, heights[x - 1] + 1);
+
+      distance_transform_dilate (seeds, width, height, heights, radius,
+                                 seed_outside, dest);
+
+      for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+          {
+            gboolean covered = FALSE;
+            gint     i, j;
+
+            for (i = -radius; i <= radius && ! covered; i++)
+              for (j = -heights[ABS (i)]; j <= heights[ABS (i)]; j++)
+                if (is_seed (seeds, width, height, seed_outside, x + i, y + j))
+                  {
+                    covered = TRUE;
+                    break;
+                  }
+
+            if (dest[y * width + x] != (covered ? 255 : 0))
+              g_error ("%dx%d, radius %d, pixel %d,%d",
+                       width, height, radius, x, y);
+          }
+
+      g_free (seeds);
+      g_free (dest);
+    }
+
+  g_rand_free (rand);
+}
+
+/*  Binary masks of blobs and noise, some with other values, which
+ *  fatten_region() and thin_region() don't take linear time for, in
+ *  the middle of a buffer of MARGIN pixels more all around.
+ */
+static guchar *
+random_mask (GRand       *rand,
+             gint         width,
+             gint         height,
+             gboolean     binary,
+             PixelRegion *region)
+{
+  const gint  stride = width + 2 * MARGIN;
+  guchar     *buffer = g_new (guchar, stride * (height + 2 * MARGIN));
+  guchar     *mask   = buffer + MARGIN * stride + MARGIN;
+  const gint  noise  = g_rand_int_range (rand, 0, 4);
+  gint        n_blobs;
+  gint        x, y;
+
+  memset (buffer, 77, stride * (height + 2 * MARGIN));
+
+  for (y = 0; y < height; y++)
+    memset (mask + y * stride, g_rand_boolean (rand) ? 255 : 0, width);
+
+  for (n_blobs = g_rand_int_range (rand, 1, 6); n_blobs > 0; n_blobs--)
+    {
+      const gint   cx     = g_rand_int_range (rand, 0, width);
+      const gint   cy     = g_rand_int_range (rand, 0, height);
+      const gint   radius = g_rand_int_range (rand, 1, 20);
+      const guchar value  = g_rand_boolean (rand) ? 255 : 0;
+
+      for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+          if (SQR (x - cx) + SQR (y - cy) < SQR (radius))
+            mask[y * stride + x] = value;
+    }
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        guchar *p = mask + y * stride + x;
+
+        if (noise && g_rand_int_range (rand, 0, 8 * noise) == 0)
+          *p = 255 - *p;
+
+        if (! binary && g_rand_int_range (rand, 0, 7) == 0)
+          *p = g_rand_int_range (rand, 0, 256);
+      }
+
+  pixel_region_init_data (region, mask, 1, stride, 0, 0, width, height);
+
+  return buffer;
+}
+
+static void
+check_margin (const guchar *buffer,
+              gint          width,
+              gint          height)
+{
+  const gint stride = width + 2 * MARGIN;
+  gint       x, y;
+
+  for (y = 0; y < height + 2 * MARGIN; y++)
+    for (x = 0; x < stride; x++)
+      if (x < MARGIN || x >= width + MARGIN ||
+          y < MARGIN || y >= height + MARGIN)
+        g_assert_cmpint (buffer[y * stride + x], ==, 77);
+}
+
+/*  The rows -heights[dx] to heights[dx] of the ellipse of the mask
+ *  morphology, for dx from 0 to @xradius.
+ */
+static void
+ellipse_heights (gint  xradius,
+                 gint  yradius,
+                 gint *heights)
+{
+  gint dx;
+
+  for (dx = 0; dx <= xradius; dx++)
+    {
+      const gdouble tmp = dx ? dx - 0.5 : 0.0;
+
+      heights[dx] = RINT (yradius / (gdouble) xradius *
+                          sqrt (SQR (xradius) - SQR (tmp)));
+    }
+}
+
+/*  The largest value, or with @thin the smallest, of the pixels of
+ *  @src in the ellipse around every pixel.  Without @edge_lock, the
+ *  pixels around the mask are 0 when thinning.
+ */
+static void
+morph_reference (const PixelRegion *src,
+                 gint               xradius,
+                 gint               yradius,
+                 gboolean           thin,
+                 gboolean           edge_lock,
+                 guchar            *dest)
+{
+  gint heights[MAX_RADIUS];
+  gint x, y;
+
+  ellipse_heights (xradius, yradius, heights);
+
+  for (y = 0; y < src->h; y++)
+    for (x = 0; x < src->w; x++)
+      {
+        gint value = thin ? 255 : 0;
+        gint i, j;
+
+        for (i = -xradius; i <= xradius; i++)
+          for (j = -heights[ABS (i)]; j <= heights[ABS (i)]; j++)
+            {
+              gint v;
+
+              if (x + i < 0 || x + i >= src->w || y + j < 0 || y + j >= src->h)
+                {
+                  if (! thin || edge_lock)
+                    continue;
+
+                  v = 0;
+                }
+              else
+                {
+                  v = src->data[(y + j) * src->rowstride + x + i];
+                }
+
+              value = thin ? MIN (value, v) : MAX (value, v);
+            }
+
+        dest[y * src->w + x] = value;
+      }
+}
+
+static void
+check_region (const PixelRegion *region,
+              const guchar      *expected,
+              const gchar       *what,
+              gint               xradius,
+              gint               yradius,
+              gboolean           flag)
+{
+  gint x, y;
+
+  for (y = 0; y < region->h; y++)
+    for (x = 0; x < region->w; x++)
+      if (region->data[y * region->rowstride + x] != expected[y * region->w + x])
+        g_error ("%s %dx%d, radius %dx%d, %d: pixel %d,%d is %d instead of %d",
+                 what, region->w, region->h, xradius, yradius, flag, x, y,
+                 region->data[y * region->rowstride + x],
+                 expected[y * region->w + x]);
+}
+
+static void
+morph (gboolean thin)
+{
+  GRand *rand = g_rand_new_with_seed (thin ? 4 : 3);
+  gint   n;
+
+  for (n = 0; n < N_MASKS; n++)
+    {
+      PixelRegion  region;
+      gint         width;
+      gint         height;
+      gint         xradius   = g_rand_int_range (rand, 1, MAX_RADIUS);
+      gint         yradius   = g_rand_int_range (rand, 1, MAX_RADIUS);
+      gboolean     edge_lock = g_rand_boolean (rand);
+      guchar      *buffer;
+      guchar      *expected;
+
+      random_size (rand, &width, &height);
+
+      buffer   = random_mask (rand, width, height, n % 4 != 0, &region);
+      expected = g_new (guchar, width * height);
+
+      morph_reference (&region, xradius, yradius, thin, edge_lock, expected);
+
+      if (thin)
+        thin_region (&region, xradius, yradius, edge_lock);
+      else
+        fatten_region (&region, xradius, yradius);
+
+      check_region (&region, expected, thin ? "thin" : "fatten",
+                    xradius, yradius, edge_lock);
+      check_margin (buffer, width, height);
+
+      g_free (buffer);
+      g_free (expected);
+    }
+
+  g_rand_free (rand);
+}
+
+/**
+ * fatten:
+ *
+ * Every pixel gets the largest value in the ellipse around it, for
+ * binary masks, which take the distance transform, and others.
+ **/
+static void
+fatten (void)
+{
+  morph (FALSE);
+}
+
+/**
+ * thin:
+ *
+ * Every pixel gets the smallest value in the ellipse around it, with
+ * and without the pixels around the mask counting as unselected.
+ **/
+static void
+thin (void)
+{
+  morph (TRUE);
+}
+
+/*  Whether (x, y) counts as selected for the border, where a mask of
+ *  a single column has selected columns on both sides and one of a
+ *  single row is its own row below.
+ */
+static gboolean
+border_selected (const PixelRegion *src,
+                 gboolean           edge_lock,
+                 gint               x,
+                 gint               y)
+{
+  if (y < 0)
+    return edge_lock;
+
+  if (y >= src->h)
+    {
+      if (src->h > 1)
+        return edge_lock;
+
+      y = 0;
+    }
+
+  if (x < 0 || x >= src->w)
+    return (src->w == 1) || edge_lock;
+
+  return src->data[y * src->rowstride + x] >= 128;
+}
+
+/*  The largest density of the border around the selected pixels next
+ *  to unselected ones.
+ */
+static void
+border_reference (const PixelRegion *src,
+                  gint               xradius,
+                  gint               yradius,
+                  gboolean           feather,
+                  gboolean           edge_lock,
+                  guchar            *dest)
+{
+  guchar *transitions = g_new0 (guchar, src->w * src->h);
+  gint    x, y;
+
+  for (y = 0; y < src->h; y++)
+    for (x = 0; x < src->w; x++)
+      if (border_selected (src, edge_lock, x, y))
+        {
+          gint i, j;
+
+          for (j = -1; j <= 1; j++)
+            for (i = -1; i <= 1; i++)
+              if (! border_selected (src, edge_lock, x + i, y + j))
+                transitions[y * src->w + x] = 255;
+        }
+
+  for (y = 0; y < src->h; y++)
+    for (x = 0; x < src->w; x++)
+      {
+        guchar value = 0;
+        gint   i, j;
+
+        for (j = MAX (-yradius, -y); j <= MIN (yradius, src->h - 1 - y); j++)
+          for (i = MAX (-xradius, -x); i <= MIN (xradius, src->w - 1 - x); i++)
+            if (transitions[(y + j) * src->w + x + i])
+              {
+                const gdouble tx   = i ? ABS (i) - 0.5 : 0.0;
+                const gdouble ty   = j ? ABS (j) - 0.5 : 0.0;
+                const gdouble dist = (SQR (ty) / SQR (yradius) +
+                                      SQR (tx) / SQR (xradius));
+                guchar        a    = 0;
+
+                if (dist < 1.0)
+                  a = feather ? 255 * (1.0 - sqrt (dist)) : 255;
+
+                value = MAX (value, a);
+              }
+
+        if (xradius == 1 && yradius == 1)
+          value = transitions[y * src->w + x];
+
+        dest[y * src->w + x] = value;
+      }
+
+  g_free (transitions);
+}
+
+/**
+ * border:
+ *
+ * Every pixel gets the largest density of the border around the
+ * transitions near it, feathered or not, with and without edge lock.
+ **/
+static void
+border (void)
+{
+  GRand *rand = g_rand_new_with_seed (5);
+  gint   n;
+
+  for (n = 0; n < N_MASKS; n++)
+    {
+      PixelRegion  region;
+      gint         width;
+      gint         height;
+      gint         xradius   = g_rand_int_range (rand, 1, MAX_RADIUS);
+      gint         yradius   = g_rand_int_range (rand, 1, MAX_RADIUS);
+      gboolean     feather   = g_rand_boolean (rand);
+      gboolean     edge_lock = g_rand_boolean (rand);
+      guchar      *buffer;
+      guchar      *expected;
+
+      /*  and the special case  */
+      if (n % 8 == 0)
+        xradius = yradius = 1;
+
+      random_size (rand, &width, &height);
+
+      buffer   = random_mask (rand, width, height, n % 2, &region);
+      expected = g_new (guchar, width * height);
+
+      border_reference (&region, xradius, yradius, feather, edge_lock,
+                        expected);
+
+      border_region (&region, xradius, yradius, feather, edge_lock);
+
+      check_region (&region, expected, feather ? "feather" : "border",
+                    xradius, yradius, edge_lock);
+      check_margin (buffer, width, height);
+
+      g_free (buffer);
+      g_free (expected);
+    }
+
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (euclidean);
+  ADD_TEST (dilate);
+  ADD_TEST (fatten);
+  ADD_TEST (thin);
+  ADD_TEST (border);
+
+  return g_test_run ();
+}
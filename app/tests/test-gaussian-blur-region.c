@@ -0,0 +1,208 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-gaussian-blur-region.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks that the accelerated line kernels of the gaussian blur the
+ *  CPU supports compute exactly what the generic ones do, and that
+ *  blurring leaves what it must not change alone.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-funcs/paint-funcs-types.h"
+
+#include "base/pixel-region.h"
+
+#include "paint-funcs/gaussian-blur-region.h"
+
+#include "gimp-accel-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/gaussian-blur-region/" #function, function);
+
+/*  odd, so the accelerated versions have to handle a tail  */
+#define MAX_SIGNALS   67
+#define N_LINES       20000
+
+/*  larger than a tile, so the region is cut into several strips  */
+#define REGION_WIDTH  150
+#define REGION_HEIGHT 90
+
+
+static void
+fill_line (GRand  *rand,
+           guchar *line,
+           gint    n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    line[i] = g_rand_int_range (rand, 0, 256);
+}
+
+/**
+ * accelerated:
+ *
+ * The accelerated kernels accumulate and step the box sums alike, with
+ * the sums in the ranges the blur passes produce.
+ **/
+static void
+accelerated (void)
+{
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (1);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      GaussianBlurFuncs funcs;
+      gint              line;
+
+      gaussian_blur_init (accel);
+      funcs = gaussian_blur_funcs;
+
+      for (line = 0; line < N_LINES; line++)
+        {
+          const gint   n      = g_rand_int_range (rand, 0, MAX_SIGNALS + 1);
+          const gint   radius = g_rand_int_range (rand, 0, 100);
+          const gfloat scale  = 1.0 / (2 * radius + 1);
+          guchar       src[MAX_SIGNALS];
+          guchar       add[MAX_SIGNALS];
+          gint         expected_acc[MAX_SIGNALS + 1];
+          gint         actual_acc[MAX_SIGNALS + 1];
+          guchar       expected[MAX_SIGNALS + 1];
+          guchar       actual[MAX_SIGNALS + 1];
+          gint         k;
+
+          fill_line (rand, src, n);
+          fill_line (rand, add, n);
+
+          /*  the element after the signals must not be touched  */
+          for (k = 0; k < MAX_SIGNALS + 1; k++)
+            expected_acc[k] = g_rand_int_range (rand, 0, 1 << 20);
+
+          memcpy (actual_acc, expected_acc, sizeof (actual_acc));
+
+          k = g_rand_int_range (rand, 0, 256);
+
+          gaussian_blur_generic_funcs.accumulate (expected_acc, src, k, n);
+          funcs.accumulate                       (actual_acc,   src, k, n);
+
+          if (memcmp (expected_acc, actual_acc, sizeof (actual_acc)))
+            g_error ("%s: accumulate, n %d", name, n);
+
+          /*  sums of a box over the line  */
+          for (k = 0; k < MAX_SIGNALS + 1; k++)
+            expected_acc[k] = g_rand_int_range (rand, 0,
+                                                (2 * radius + 1) * 255 + 1);
+
+          memcpy (actual_acc, expected_acc, sizeof (actual_acc));
+
+          memset (expected, 0x55, sizeof (expected));
+          memset (actual,   0x55, sizeof (actual));
+
+          gaussian_blur_generic_funcs.box_step (expected_acc, add, src,
+                                                expected, scale, n);
+          funcs.box_step                       (actual_acc,   add, src,
+                                                actual,   scale, n);
+
+          if (memcmp (expected_acc, actual_acc, sizeof (actual_acc)) ||
+              memcmp (expected, actual, sizeof (actual)))
+            g_error ("%s: box_step, n %d, radius %d", name, n, radius);
+        }
+    }
+
+  gaussian_blur_init (support);
+  g_rand_free (rand);
+}
+
+/**
+ * uniform:
+ *
+ * A uniform alpha channel stays uniform with the exact kernels and the
+ * box blurs, and the other channels are not touched.
+ **/
+static void
+uniform (void)
+{
+  static const gdouble radii[] = { 0.0, 1.0, 2.5, 30.0, 33.0, 200.0 };
+
+  GRand *rand = g_rand_new_with_seed (2);
+  gint   bytes;
+
+  for (bytes = 1; bytes <= 4; bytes++)
+    {
+      const gint  size     = REGION_WIDTH * REGION_HEIGHT * bytes;
+      guchar     *data     = g_new (guchar, size);
+      guchar     *expected = g_new (guchar, size);
+      gint        i;
+
+      for (i = 0; i < G_N_ELEMENTS (radii) * G_N_ELEMENTS (radii); i++)
+        {
+          const gdouble radius_x = radii[i % G_N_ELEMENTS (radii)];
+          const gdouble radius_y = radii[i / G_N_ELEMENTS (radii)];
+          const guchar  value    = g_rand_int_range (rand, 0, 256);
+          PixelRegion   region;
+          gint          k;
+
+          fill_line (rand, expected, size);
+
+          for (k = bytes - 1; k < size; k += bytes)
+            expected[k] = value;
+
+          memcpy (data, expected, size);
+
+          pixel_region_init_data (&region, data, bytes, REGION_WIDTH * bytes,
+                                  0, 0, REGION_WIDTH, REGION_HEIGHT);
+
+          gaussian_blur_region (&region, radius_x, radius_y);
+
+          if (memcmp (expected, data, size))
+            g_error ("bytes %d, radius %g x %g", bytes, radius_x, radius_y);
+        }
+
+      g_free (data);
+      g_free (expected);
+    }
+
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  gaussian_blur_init (gimp_cpu_accel_get_support ());
+
+  ADD_TEST (accelerated);
+  ADD_TEST (uniform);
+
+  return g_test_run ();
+}
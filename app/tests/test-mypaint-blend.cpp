@@ -0,0 +1,442 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks that the blend functions of mypaint-blend.c, the generic
+ *  ones and the accelerated ones the CPU supports, draw run length
+ *  encoded dabs like the templates of mypaint-brushmodes.hpp do.  They
+ *  are exact with the default compiler flags; a build which lets the
+ *  compiler fuse multiplies and adds may round some channels the other
+ *  way, so one step is tolerated.  The fixed point pixel traits are
+ *  checked against single precision as well.
+ */
+
+extern "C" {
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-funcs/paint-funcs-types.h"
+
+#include "gimp-accel-test-utils.h"
+}
+
+#include "paint-funcs/mypaint-brushmodes.hpp"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/mypaint-blend/" #function, function);
+
+/*  a tile, with runs long and short enough for all the tails  */
+#define WIDTH     64
+#define HEIGHT    64
+#define N_DABS    300
+#define TOLERANCE 1
+
+
+typedef enum
+{
+  NORMAL,
+  NORMAL_AND_ERASER,
+  LOCK_ALPHA
+} Mode;
+
+static const gchar *mode_names[] = { "normal", "normal-and-eraser", "lock-alpha" };
+
+
+typedef struct
+{
+  gfloat  mask[2 * WIDTH * HEIGHT + 1];
+  gint    offsets[WIDTH * HEIGHT + 1];
+  gfloat  colors[4];
+  gfloat  bg_color[3];
+  gfloat  color_a;
+  gfloat  opacity;
+} Dab;
+
+
+/*  a random dab encoded like fill_brushmark_buffer() does: runs of
+ *  pixels the dab covers, separated by the number of pixels skipped
+ */
+static void
+make_dab (GRand *rand,
+          Dab   *dab)
+{
+  gfloat *mask    = dab->mask;
+  gint   *offsets = dab->offsets;
+  gint    skip    = 0;
+  gint    run     = 0;
+  gint    i;
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+      if (run == 0)
+        run = g_rand_int_range (rand, -20, 40);
+
+      if (run < 0)
+        {
+          skip++;
+          run++;
+        }
+      else
+        {
+          if (skip)
+            {
+              *mask++    = 0;
+              *offsets++ = skip;
+              skip = 0;
+            }
+
+          switch (g_rand_int_range (rand, 0, 4))
+            {
+            case 0:
+              *mask++ = 1.0f;
+              break;
+
+            default:
+              *mask++ = g_rand_double_range (rand, 1.0 / 65535, 1.0);
+              break;
+            }
+
+          run--;
+        }
+    }
+
+  *mask    = 0;
+  *offsets = 0;
+
+  for (i = 0; i < 3; i++)
+    {
+      dab->colors[i]   = g_rand_double (rand);
+      dab->bg_color[i] = g_rand_double (rand);
+    }
+
+  dab->colors[3] = 1.0f;
+
+  switch (g_rand_int_range (rand, 0, 3))
+    {
+    case 0:  dab->color_a = 0.0f;                 break;
+    case 1:  dab->color_a = 1.0f;                 break;
+    default: dab->color_a = g_rand_double (rand); break;
+    }
+
+  /*  more than 1.0 too, the dab alpha is clamped  */
+  dab->opacity = g_rand_double_range (rand, 0.0, 1.2);
+}
+
+/*  random pixels, with runs of transparent and opaque alpha  */
+static void
+fill_pixels (GRand  *rand,
+             guchar *data,
+             gint    bytes)
+{
+  gint i;
+
+  for (i = 0; i < WIDTH * HEIGHT * bytes; i++)
+    data[i] = g_rand_int_range (rand, 0, 256);
+
+  if (bytes == 4)
+    {
+      for (i = 3; i < WIDTH * HEIGHT * bytes; i += bytes)
+        {
+          switch ((i / bytes / 7) % 3)
+            {
+            case 0: data[i] = 0;   break;
+            case 1: data[i] = 255; break;
+            }
+        }
+    }
+}
+
+static void
+draw (const Dab    *dab,
+      Mode          mode,
+      const guchar *src,
+      guchar       *dest,
+      gint          bytes,
+      gboolean      reference)
+{
+  BrushPixelIteratorForRunLength iter ((Pixel::real *) dab->mask,
+                                       (gint *) dab->offsets,
+                                       (Pixel::real *) dab->colors,
+                                       (Pixel::data_t *) src, dest,
+                                       bytes, bytes);
+
+  switch (mode)
+    {
+    case NORMAL:
+      if (reference)
+        draw_dab_pixels_BlendMode_Normal<BrushPixelIteratorForRunLength> (iter, dab->opacity);
+      else
+        draw_dab_pixels_BlendMode_Normal (iter, dab->opacity);
+      break;
+
+    case NORMAL_AND_ERASER:
+      if (reference)
+        draw_dab_pixels_BlendMode_Normal_and_Eraser<BrushPixelIteratorForRunLength> (iter,
+                                                                                     dab->color_a,
+                                                                                     dab->opacity,
+                                                                                     dab->bg_color[0],
+                                                                                     dab->bg_color[1],
+                                                                                     dab->bg_color[2]);
+      else
+        draw_dab_pixels_BlendMode_Normal_and_Eraser (iter,
+                                                     dab->color_a,
+                                                     dab->opacity,
+                                                     dab->bg_color[0],
+                                                     dab->bg_color[1],
+                                                     dab->bg_color[2]);
+      break;
+
+    case LOCK_ALPHA:
+      if (reference)
+        draw_dab_pixels_BlendMode_LockAlpha<BrushPixelIteratorForRunLength> (iter, dab->opacity);
+      else
+        draw_dab_pixels_BlendMode_LockAlpha (iter, dab->opacity);
+      break;
+    }
+}
+
+template<typename Traits>
+static void
+draw_fixed_point (const Dab    *dab,
+                  Mode          mode,
+                  const guchar *src,
+                  guchar       *dest,
+                  gint          bytes)
+{
+  BrushPixelIteratorForRunLength iter ((Pixel::real *) dab->mask,
+                                       (gint *) dab->offsets,
+                                       (Pixel::real *) dab->colors,
+                                       (Pixel::data_t *) src, dest,
+                                       bytes, bytes);
+
+  switch (mode)
+    {
+    case NORMAL:
+      draw_dab_pixels_BlendMode_Normal (iter, dab->opacity, Traits ());
+      break;
+
+    case NORMAL_AND_ERASER:
+      draw_dab_pixels_BlendMode_Normal_and_Eraser (iter,
+                                                   dab->color_a,
+                                                   dab->opacity,
+                                                   dab->bg_color[0],
+                                                   dab->bg_color[1],
+                                                   dab->bg_color[2],
+                                                   Traits ());
+      break;
+
+    case LOCK_ALPHA:
+      draw_dab_pixels_BlendMode_LockAlpha (iter, dab->opacity, Traits ());
+      break;
+    }
+}
+
+/**
+ * templates:
+ *
+ * Every implementation blends random dabs into random pixels of 1, 3
+ * and 4 bytes like the templates, and leaves the pixels the dab skips
+ * and, for LockAlpha, the alpha of the destination alone.
+ **/
+static void
+templates (void)
+{
+  static const gint all_bytes[] = { 1, 3, 4 };
+
+  const guint  support  = gimp_cpu_accel_get_support ();
+  GRand       *rand     = g_rand_new_with_seed (1);
+  Dab         *dab      = g_new (Dab, 1);
+  guchar      *src      = g_new (guchar, WIDTH * HEIGHT * 4);
+  guchar      *dest     = g_new (guchar, WIDTH * HEIGHT * 4);
+  guchar      *expected = g_new (guchar, WIDTH * HEIGHT * 4);
+  guchar      *actual   = g_new (guchar, WIDTH * HEIGHT * 4);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      gint n;
+
+      mypaint_blend_init (accel);
+
+      for (n = 0; n < N_DABS; n++)
+        {
+          const gint bytes = all_bytes[n % G_N_ELEMENTS (all_bytes)];
+          const Mode mode  = (Mode) g_rand_int_range (rand, NORMAL, LOCK_ALPHA + 1);
+          gint       k;
+
+          make_dab (rand, dab);
+          fill_pixels (rand, src,  bytes);
+          fill_pixels (rand, dest, bytes);
+
+          memcpy (expected, dest, WIDTH * HEIGHT * bytes);
+          memcpy (actual,   dest, WIDTH * HEIGHT * bytes);
+
+          draw (dab, mode, src, expected, bytes, TRUE);
+          draw (dab, mode, src, actual,   bytes, FALSE);
+
+          for (k = 0; k < WIDTH * HEIGHT * bytes; k++)
+            {
+              if (ABS (expected[k] - actual[k]) > TOLERANCE)
+                g_error ("%s: %s, bytes %d, pixel %d channel %d: %d, not %d",
+                         name, mode_names[mode], bytes,
+                         k / bytes, k % bytes, actual[k], expected[k]);
+            }
+        }
+    }
+
+  mypaint_blend_init (support);
+
+  g_free (dab);
+  g_free (src);
+  g_free (dest);
+  g_free (expected);
+  g_free (actual);
+  g_rand_free (rand);
+}
+
+/**
+ * in_place:
+ *
+ * The surface blends with the destination as the source, the
+ * accelerated functions must read a pixel before they write it.
+ **/
+static void
+in_place (void)
+{
+  GRand  *rand     = g_rand_new_with_seed (2);
+  Dab    *dab      = g_new (Dab, 1);
+  guchar *expected = g_new (guchar, WIDTH * HEIGHT * 4);
+  guchar *actual   = g_new (guchar, WIDTH * HEIGHT * 4);
+  gint    n;
+
+  for (n = 0; n < N_DABS; n++)
+    {
+      const Mode mode = (Mode) (n % (LOCK_ALPHA + 1));
+      gint       k;
+
+      make_dab (rand, dab);
+      fill_pixels (rand, expected, 4);
+
+      memcpy (actual, expected, WIDTH * HEIGHT * 4);
+
+      draw (dab, mode, expected, expected, 4, TRUE);
+      draw (dab, mode, actual,   actual,   4, FALSE);
+
+      for (k = 0; k < WIDTH * HEIGHT * 4; k++)
+        {
+          if (ABS (expected[k] - actual[k]) > TOLERANCE)
+            g_error ("%s, pixel %d channel %d: %d, not %d",
+                     mode_names[mode], k / 4, k % 4, actual[k], expected[k]);
+        }
+    }
+
+  g_free (dab);
+  g_free (expected);
+  g_free (actual);
+  g_rand_free (rand);
+}
+
+/**
+ * fixed_point:
+ *
+ * The 15 bit fixed point kernels stay within one step of single
+ * precision, the 8 bit ones within two without alpha.  The colors of
+ * nearly transparent pixels are divided by their alpha and are left
+ * out.
+ **/
+static void
+fixed_point (void)
+{
+  static const gint all_bytes[] = { 1, 3, 4 };
+
+  GRand  *rand     = g_rand_new_with_seed (3);
+  Dab    *dab      = g_new (Dab, 1);
+  guchar *src      = g_new (guchar, WIDTH * HEIGHT * 4);
+  guchar *expected = g_new (guchar, WIDTH * HEIGHT * 4);
+  guchar *actual   = g_new (guchar, WIDTH * HEIGHT * 4);
+  gint    n;
+
+  for (n = 0; n < N_DABS; n++)
+    {
+      const gint bytes = all_bytes[n % G_N_ELEMENTS (all_bytes)];
+      const Mode mode  = (Mode) g_rand_int_range (rand, NORMAL, LOCK_ALPHA + 1);
+      gint       k;
+
+      make_dab (rand, dab);
+      fill_pixels (rand, src, bytes);
+
+      memcpy (expected, src, WIDTH * HEIGHT * bytes);
+      draw (dab, mode, src, expected, bytes, TRUE);
+
+      memcpy (actual, src, WIDTH * HEIGHT * bytes);
+      draw_fixed_point<PixelTraits15> (dab, mode, src, actual, bytes);
+
+      for (k = 0; k < WIDTH * HEIGHT * bytes; k++)
+        {
+          if (bytes == 4 && k % 4 != 3 && expected[k - k % 4 + 3] < 32)
+            continue;
+
+          if (ABS (expected[k] - actual[k]) > 1)
+            g_error ("15 bit: %s, bytes %d, pixel %d channel %d: %d, not %d",
+                     mode_names[mode], bytes,
+                     k / bytes, k % bytes, actual[k], expected[k]);
+        }
+
+      if (bytes == 4)
+        continue;
+
+      memcpy (actual, src, WIDTH * HEIGHT * bytes);
+      draw_fixed_point<PixelTraits8> (dab, mode, src, actual, bytes);
+
+      for (k = 0; k < WIDTH * HEIGHT * bytes; k++)
+        {
+          if (ABS (expected[k] - actual[k]) > 2)
+            g_error ("8 bit: %s, bytes %d, pixel %d channel %d: %d, not %d",
+                     mode_names[mode], bytes,
+                     k / bytes, k % bytes, actual[k], expected[k]);
+        }
+    }
+
+  g_free (dab);
+  g_free (src);
+  g_free (expected);
+  g_free (actual);
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  mypaint_blend_init (gimp_cpu_accel_get_support ());
+
+  ADD_TEST (templates);
+  ADD_TEST (in_place);
+  ADD_TEST (fixed_point);
+
+  return g_test_run ();
+}
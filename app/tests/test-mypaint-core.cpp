@@ -0,0 +1,199 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks that GimpMypaintCore passes the tool options on to the
+ *  surface when a stroke starts.
+ */
+
+extern "C" {
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "widgets/widgets-types.h"
+#include "paint/paint-types.h"
+
+#include "core/gimp.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+
+#include "paint/gimpmypaintoptions.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+}
+
+#include "paint/gimpmypaintcore.hpp"
+
+
+#define GIMP_TEST_IMAGE_SIZE 100
+
+#define ADD_IMAGE_TEST(function) \
+  g_test_add ("/gimp-mypaint-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_image_setup, \
+              function, \
+              gimp_test_image_teardown);
+
+
+typedef struct
+{
+  GimpImage          *image;
+  GimpLayer          *layer;
+  GimpMypaintOptions *options;
+} GimpTestFixture;
+
+
+static void gimp_test_image_setup    (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+static void gimp_test_image_teardown (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+
+
+/**
+ * gimp_test_image_setup:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture setup for an image with a single layer, and the
+ * options of a MyPaint brush tool.
+ **/
+static void
+gimp_test_image_setup (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+
+  fixture->image = gimp_image_new (gimp,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_RGB);
+
+  fixture->layer = gimp_layer_new (fixture->image,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_RGBA_IMAGE,
+                                   "Test Layer",
+                                   1.0,
+                                   GIMP_NORMAL_MODE);
+
+  gimp_image_add_layer (fixture->image,
+                        fixture->layer,
+                        GIMP_IMAGE_ACTIVE_PARENT,
+                        0,
+                        FALSE);
+
+  fixture->options =
+    GIMP_MYPAINT_OPTIONS (g_object_new (GIMP_TYPE_MYPAINT_OPTIONS,
+                                        "gimp", gimp,
+                                        "name", "Test",
+                                        NULL));
+}
+
+/**
+ * gimp_test_image_teardown:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture teardown for a single image.
+ **/
+static void
+gimp_test_image_teardown (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  g_object_unref (fixture->options);
+  g_object_unref (fixture->image);
+}
+
+/**
+ * precision:
+ * @fixture:
+ * @data:
+ *
+ * The "precision" option reaches the surface when a stroke starts,
+ * and changing it splits the stroke, so the next one is drawn with
+ * the new precision.
+ **/
+static void
+precision (GimpTestFixture *fixture,
+           gconstpointer    data)
+{
+  GimpDrawable    *drawable = GIMP_DRAWABLE (fixture->layer);
+  GimpCoords       coords   = { 0, };
+  GimpMypaintCore *core     = new GimpMypaintCore ();
+
+  coords.x        = GIMP_TEST_IMAGE_SIZE / 2;
+  coords.y        = GIMP_TEST_IMAGE_SIZE / 2;
+  coords.pressure = 1.0;
+
+  g_assert_cmpint (fixture->options->precision,
+                   ==, GIMP_MYPAINT_PRECISION_FLOAT);
+
+  g_object_set (fixture->options,
+                "precision", GIMP_MYPAINT_PRECISION_15_BIT,
+                NULL);
+
+  core->stroke_to (drawable, 0.0, &coords, fixture->options);
+  g_assert (core->get_surface () != NULL);
+  g_assert_cmpint (core->get_surface ()->get_precision (),
+                   ==, GIMP_MYPAINT_PRECISION_15_BIT);
+
+  g_object_set (fixture->options,
+                "precision", GIMP_MYPAINT_PRECISION_8_BIT,
+                NULL);
+
+  coords.x += 10;
+  core->stroke_to (drawable, 0.1, &coords, fixture->options);
+  g_assert_cmpint (core->get_surface ()->get_precision (),
+                   ==, GIMP_MYPAINT_PRECISION_8_BIT);
+
+  delete core;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_thread_init (NULL);
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_IMAGE_TEST (precision);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
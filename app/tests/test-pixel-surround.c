@@ -0,0 +1,387 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-pixel-surround.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/pixel-region.h"
+#include "base/pixel-surround.h"
+#include "base/tile.h"
+#include "base/tile-cache.h"
+#include "base/tile-manager.h"
+#include "base/tile-swap.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/pixel-surround/" #function, function);
+
+/*  three tiles across and two down, the last ones cut off  */
+#define WIDTH     (2 * TILE_WIDTH + 21)
+#define HEIGHT    (TILE_HEIGHT + 13)
+#define BPP       3
+
+#define N_RANDOM  5000
+
+
+/*  the sizes the transform tools use, and one which isn't square  */
+static const struct
+{
+  gint width;
+  gint height;
+}
+sizes[] =
+{
+  { 1, 1 },
+  { 2, 2 },
+  { 4, 4 },
+  { 7, 7 },
+  { 5, 2 }
+};
+
+static const guchar bg_color[BPP] = { 11, 22, 33 };
+
+
+static TileManager *
+create_tiles (guchar *pixels)
+{
+  TileManager *tiles = tile_manager_new (WIDTH, HEIGHT, BPP);
+  GRand       *rand  = g_rand_new_with_seed (WIDTH * HEIGHT);
+  gint         i;
+
+  for (i = 0; i < WIDTH * HEIGHT * BPP; i++)
+    pixels[i] = g_rand_int_range (rand, 0, 256);
+
+  tile_manager_write_pixel_data (tiles, 0, 0, WIDTH - 1, HEIGHT - 1,
+                                 pixels, WIDTH * BPP);
+
+  /*  and compare with what reading the tiles gives  */
+  tile_manager_read_pixel_data (tiles, 0, 0, WIDTH - 1, HEIGHT - 1,
+                                pixels, WIDTH * BPP);
+
+  g_rand_free (rand);
+
+  return tiles;
+}
+
+/*  Outside the tile manager, smearing repeats the nearest pixel on its
+ *  edge, the background mode has the background color.
+ */
+static const guchar *
+expected_pixel (const guchar      *pixels,
+                PixelSurroundMode  mode,
+                gint               x,
+                gint               y)
+{
+  if (mode == PIXEL_SURROUND_SMEAR)
+    {
+      x = CLAMP (x, 0, WIDTH - 1);
+      y = CLAMP (y, 0, HEIGHT - 1);
+    }
+  else if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+    {
+      return bg_color;
+    }
+
+  return pixels + (y * WIDTH + x) * BPP;
+}
+
+static void
+check_area (PixelSurround     *surround,
+            const guchar      *pixels,
+            PixelSurroundMode  mode,
+            gint               x,
+            gint               y,
+            gint               width,
+            gint               height)
+{
+  const guchar *data;
+  gint          rowstride;
+  gint          i, j;
+
+  data = pixel_surround_lock (surround, x, y, &rowstride);
+
+  for (j = 0; j < height; j++)
+    for (i = 0; i < width; i++)
+      {
+        const guchar *expected = expected_pixel (pixels, mode, x + i, y + j);
+
+        if (memcmp (data + j * rowstride + i * BPP, expected, BPP))
+          g_error ("mode %d, %dx%d area at %d,%d: pixel %d,%d is wrong",
+                   mode, width, height, x, y, i, j);
+      }
+}
+
+/*  Every area which overlaps the tile manager, or is next to it, row
+ *  by row and releasing the tiles at the end of every row; then areas
+ *  in random order, which lock and evict tiles all over.
+ */
+static void
+check_mode (PixelSurroundMode mode)
+{
+  guchar      *pixels = g_new (guchar, WIDTH * HEIGHT * BPP);
+  TileManager *tiles  = create_tiles (pixels);
+  GRand       *rand   = g_rand_new_with_seed (mode);
+  gint         n;
+
+  for (n = 0; n < G_N_ELEMENTS (sizes); n++)
+    {
+      const gint     width    = sizes[n].width;
+      const gint     height   = sizes[n].height;
+      PixelSurround *surround = pixel_surround_new (tiles, width, height,
+                                                    mode);
+      gint           x, y, i;
+
+      pixel_surround_set_bg (surround, bg_color);
+
+      for (y = - height - 1; y <= HEIGHT + 1; y++)
+        {
+          for (x = - width - 1; x <= WIDTH + 1; x++)
+            check_area (surround, pixels, mode, x, y, width, height);
+
+          pixel_surround_release (surround);
+          g_assert_cmpint (tile_global_refcount (), ==, 0);
+        }
+
+      for (i = 0; i < N_RANDOM; i++)
+        check_area (surround, pixels, mode,
+                    g_rand_int_range (rand, - width - 1, WIDTH + 2),
+                    g_rand_int_range (rand, - height - 1, HEIGHT + 2),
+                    width, height);
+
+      g_assert_cmpint (tile_global_refcount (), >, 0);
+
+      pixel_surround_destroy (surround);
+      g_assert_cmpint (tile_global_refcount (), ==, 0);
+    }
+
+  g_rand_free (rand);
+  tile_manager_unref (tiles);
+  g_free (pixels);
+}
+
+/**
+ * lock_background:
+ *
+ * Areas across tile edges and the borders of the tile manager have
+ * the pixels of the tiles, and the background color outside, and
+ * releasing them leaves no tile locked.
+ **/
+static void
+lock_background (void)
+{
+  check_mode (PIXEL_SURROUND_BACKGROUND);
+}
+
+/**
+ * lock_smear:
+ *
+ * Areas across tile edges and the borders of the tile manager have
+ * the pixels of the tiles, and the nearest pixel on the border
+ * outside, and releasing them leaves no tile locked.
+ **/
+static void
+lock_smear (void)
+{
+  check_mode (PIXEL_SURROUND_SMEAR);
+}
+
+/**
+ * get_pixels:
+ *
+ * Pixels fetched one by one are the ones locking them gives.
+ **/
+static void
+get_pixels (void)
+{
+  static const PixelSurroundMode modes[] =
+  {
+    PIXEL_SURROUND_SMEAR,
+    PIXEL_SURROUND_BACKGROUND
+  };
+
+  guchar      *pixels = g_new (guchar, WIDTH * HEIGHT * BPP);
+  TileManager *tiles  = create_tiles (pixels);
+  GRand       *rand   = g_rand_new_with_seed (N_RANDOM);
+  gint         x[N_RANDOM];
+  gint         y[N_RANDOM];
+  guchar       dest[N_RANDOM * BPP];
+  gint         i, n;
+
+  /*  runs along rows, with jumps in between  */
+  for (i = 0; i < N_RANDOM; i++)
+    {
+      if (i % 50 == 0)
+        {
+          x[i] = g_rand_int_range (rand, -3, WIDTH + 3);
+          y[i] = g_rand_int_range (rand, -3, HEIGHT + 3);
+        }
+      else
+        {
+          x[i] = x[i - 1] + g_rand_int_range (rand, 0, 4);
+          y[i] = y[i - 1];
+        }
+    }
+
+  for (n = 0; n < G_N_ELEMENTS (modes); n++)
+    {
+      PixelSurround *surround = pixel_surround_new (tiles, 1, 1, modes[n]);
+
+      pixel_surround_set_bg (surround, bg_color);
+
+      pixel_surround_get_pixels (surround, x, y, N_RANDOM, dest);
+
+      for (i = 0; i < N_RANDOM; i++)
+        if (memcmp (dest + i * BPP,
+                    expected_pixel (pixels, modes[n], x[i], y[i]), BPP))
+          g_error ("mode %d: pixel %d,%d is wrong", modes[n], x[i], y[i]);
+
+      pixel_surround_release (surround);
+      g_assert_cmpint (tile_global_refcount (), ==, 0);
+
+      pixel_surround_destroy (surround);
+    }
+
+  g_rand_free (rand);
+  tile_manager_unref (tiles);
+  g_free (pixels);
+}
+
+typedef struct
+{
+  TileManager *tiles;
+} ParallelInfo;
+
+/*  every pixel is the xor of the 3x3 area around it  */
+static void
+xor_area (ParallelInfo *info,
+          PixelRegion  *destPR)
+{
+  PixelSurround *surround = pixel_surround_new (info->tiles, 3, 3,
+                                                PIXEL_SURROUND_SMEAR);
+  guchar        *dest     = destPR->data;
+  gint           x, y;
+
+  pixel_surround_set_parallel (surround, TRUE);
+
+  for (y = 0; y < destPR->h; y++, dest += destPR->rowstride)
+    for (x = 0; x < destPR->w; x++)
+      {
+        const guchar *data;
+        gint          rowstride;
+        gint          i, j, b;
+
+        data = pixel_surround_lock (surround,
+                                    destPR->x + x - 1, destPR->y + y - 1,
+                                    &rowstride);
+
+        for (b = 0; b < BPP; b++)
+          {
+            guchar value = 0;
+
+            for (j = 0; j < 3; j++)
+              for (i = 0; i < 3; i++)
+                value ^= data[j * rowstride + i * BPP + b];
+
+            dest[x * BPP + b] = value;
+          }
+      }
+
+  pixel_surround_destroy (surround);
+}
+
+/**
+ * lock_parallel:
+ *
+ * Surrounds of their own on the threads of the pixel processor read
+ * the same tiles, and leave none locked.
+ **/
+static void
+lock_parallel (void)
+{
+  guchar       *pixels = g_new (guchar, WIDTH * HEIGHT * BPP);
+  guchar       *result = g_new (guchar, WIDTH * HEIGHT * BPP);
+  TileManager  *tiles  = create_tiles (pixels);
+  TileManager  *dest   = tile_manager_new (WIDTH, HEIGHT, BPP);
+  ParallelInfo  info   = { tiles };
+  PixelRegion   destPR;
+  gint          x, y, b;
+
+  pixel_region_init (&destPR, dest, 0, 0, WIDTH, HEIGHT, TRUE);
+
+  pixel_regions_process_parallel ((PixelProcessorFunc) xor_area, &info,
+                                  1, &destPR);
+
+  g_assert_cmpint (tile_global_refcount (), ==, 0);
+
+  tile_manager_read_pixel_data (dest, 0, 0, WIDTH - 1, HEIGHT - 1,
+                                result, WIDTH * BPP);
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      for (b = 0; b < BPP; b++)
+        {
+          guchar value = 0;
+          gint   i, j;
+
+          for (j = -1; j <= 1; j++)
+            for (i = -1; i <= 1; i++)
+              value ^= expected_pixel (pixels, PIXEL_SURROUND_SMEAR,
+                                       x + i, y + j)[b];
+
+          g_assert_cmpint (result[(y * WIDTH + x) * BPP + b], ==, value);
+        }
+
+  tile_manager_unref (dest);
+  tile_manager_unref (tiles);
+  g_free (result);
+  g_free (pixels);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result;
+
+  g_thread_init (NULL);
+  g_type_init ();
+  tile_cache_init (G_MAXUINT32);
+  tile_swap_init (g_get_tmp_dir ());
+  pixel_processor_init (4);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (lock_background);
+  ADD_TEST (lock_smear);
+  ADD_TEST (get_pixels);
+  ADD_TEST (lock_parallel);
+
+  result = g_test_run ();
+
+  pixel_processor_exit ();
+  tile_cache_exit ();
+  tile_swap_exit ();
+
+  return result;
+}
@@ -0,0 +1,215 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-projection.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "widgets/widgets-types.h"
+
+#include "base/tile-manager.h"
+
+#include "core/gimp.h"
+#include "core/gimpdrawable.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+#include "core/gimppickable.h"
+#include "core/gimpprojection.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define WIDTH   150
+#define HEIGHT  130
+
+#define LAYER_X       70
+#define LAYER_Y       60
+#define LAYER_WIDTH   40
+#define LAYER_HEIGHT  30
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-projection/" #function, gimp, function);
+
+
+static const guchar blue[4] = { 0, 0, 255, 255 };
+
+
+/*  Creates an image with a background layer without alpha, filled
+ *  with a pattern.
+ */
+static GimpImage *
+create_image (Gimp *gimp)
+{
+  GimpImage   *image;
+  GimpLayer   *layer;
+  TileManager *tiles;
+  gint         x, y;
+
+  image = gimp_image_new (gimp, WIDTH, HEIGHT, GIMP_RGB);
+  layer = gimp_layer_new (image, WIDTH, HEIGHT, GIMP_RGB_IMAGE,
+                          "Background",
+                          GIMP_OPACITY_OPAQUE, GIMP_NORMAL_MODE);
+
+  tiles = gimp_drawable_get_tiles (GIMP_DRAWABLE (layer));
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        guchar pixel[3] = { x, y, x ^ y };
+
+        tile_manager_write_pixel_data_1 (tiles, x, y, pixel);
+      }
+
+  gimp_image_add_layer (image, layer, NULL, 0, FALSE /*push_undo*/);
+
+  return image;
+}
+
+/*  Asserts the projection shows the background, and blue in the given
+ *  rectangle.
+ */
+static void
+assert_projection (GimpImage *image,
+                   gint       blue_x,
+                   gint       blue_y,
+                   gint       blue_width,
+                   gint       blue_height)
+{
+  GimpProjection *projection = gimp_image_get_projection (image);
+  TileManager    *tiles;
+  gint            x, y;
+
+  gimp_projection_flush_now (projection);
+
+  tiles = gimp_pickable_get_tiles (GIMP_PICKABLE (projection));
+
+  g_assert_cmpint (tile_manager_bpp (tiles), ==, 4);
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        guchar pixel[4];
+
+        tile_manager_read_pixel_data_1 (tiles, x, y, pixel);
+
+        if (x >= blue_x && x < blue_x + blue_width &&
+            y >= blue_y && y < blue_y + blue_height)
+          {
+            g_assert_cmpint (pixel[0], ==, blue[0]);
+            g_assert_cmpint (pixel[1], ==, blue[1]);
+            g_assert_cmpint (pixel[2], ==, blue[2]);
+          }
+        else
+          {
+            g_assert_cmpint (pixel[0], ==, (guchar) x);
+            g_assert_cmpint (pixel[1], ==, (guchar) y);
+            g_assert_cmpint (pixel[2], ==, (guchar) (x ^ y));
+          }
+
+        g_assert_cmpint (pixel[3], ==, 255);
+      }
+}
+
+/**
+ * no_alpha_background:
+ * @data:
+ *
+ * A background layer without alpha projects to its own pixels, with
+ * an opaque alpha channel added.
+ **/
+static void
+no_alpha_background (gconstpointer data)
+{
+  Gimp      *gimp  = GIMP (data);
+  GimpImage *image = create_image (gimp);
+
+  assert_projection (image, 0, 0, 0, 0);
+
+  g_object_unref (image);
+}
+
+/**
+ * no_alpha_background_covered:
+ * @data:
+ *
+ * Where a layer with alpha covers part of a background layer without
+ * alpha, the projection is composited there, and shows the background
+ * elsewhere.
+ **/
+static void
+no_alpha_background_covered (gconstpointer data)
+{
+  Gimp        *gimp  = GIMP (data);
+  GimpImage   *image = create_image (gimp);
+  GimpLayer   *layer;
+  TileManager *tiles;
+  gint         x, y;
+
+  layer = gimp_layer_new (image, LAYER_WIDTH, LAYER_HEIGHT, GIMP_RGBA_IMAGE,
+                          "Blue",
+                          GIMP_OPACITY_OPAQUE, GIMP_NORMAL_MODE);
+
+  tiles = gimp_drawable_get_tiles (GIMP_DRAWABLE (layer));
+
+  for (y = 0; y < LAYER_HEIGHT; y++)
+    for (x = 0; x < LAYER_WIDTH; x++)
+      tile_manager_write_pixel_data_1 (tiles, x, y, blue);
+
+  gimp_item_set_offset (GIMP_ITEM (layer), LAYER_X, LAYER_Y);
+  gimp_image_add_layer (image, layer, NULL, 0, FALSE /*push_undo*/);
+
+  assert_projection (image, LAYER_X, LAYER_Y, LAYER_WIDTH, LAYER_HEIGHT);
+
+  g_object_unref (image);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_thread_init (NULL);
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_TEST (no_alpha_background);
+  ADD_TEST (no_alpha_background_covered);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,141 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-sample-weighted.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks that the accelerated footprint sums of the transform
+ *  samplers the CPU supports compute exactly what the generic one
+ *  does.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-funcs/paint-funcs-types.h"
+
+#include "paint-funcs/sample-weighted.h"
+
+#include "gimp-accel-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/sample-weighted/" #function, function);
+
+/*  the footprints of linear, cubic and lanczos  */
+#define MAX_TAPS      7
+#define N_FOOTPRINTS  100000
+
+
+/**
+ * sum:
+ *
+ * The accelerated sums of random footprints of every format and size
+ * are those of the generic one, with weights which go negative like
+ * those of cubic and lanczos, and alpha transparent, opaque or random.
+ **/
+static void
+sum (void)
+{
+  static const gint taps_of[] = { 2, 4, MAX_TAPS };
+
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (1);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      SampleWeightedFuncs funcs;
+      gint                n;
+
+      sample_weighted_init (accel);
+      funcs = sample_weighted_funcs;
+
+      for (n = 0; n < N_FOOTPRINTS; n++)
+        {
+          const gint bytes     = g_rand_int_range (rand, 1, 5);
+          const gint alpha     = bytes - 1;
+          const gint taps      = taps_of[g_rand_int_range (rand, 0, 3)];
+          const gint rowstride = taps * bytes + g_rand_int_range (rand, 0, 4);
+          const gint mode      = g_rand_int_range (rand, 0, 4);
+          guchar     data[MAX_TAPS * (MAX_TAPS * 4 + 3)];
+          gdouble    x_weights[MAX_TAPS];
+          gdouble    y_weights[MAX_TAPS];
+          gdouble    expected[MAX_CHANNELS + 1];
+          gdouble    actual[MAX_CHANNELS + 1];
+          gint       k;
+
+          for (k = 0; k < taps * rowstride; k++)
+            {
+              data[k] = g_rand_int_range (rand, 0, 256);
+
+              if (alpha && k % rowstride < taps * bytes &&
+                  k % rowstride % bytes == alpha)
+                {
+                  switch (mode)
+                    {
+                    case 1: data[k] = 0;   break;
+                    case 2: data[k] = 255; break;
+                    }
+                }
+            }
+
+          for (k = 0; k < taps; k++)
+            {
+              x_weights[k] = g_rand_double_range (rand, -0.2, 1.2);
+              y_weights[k] = g_rand_double_range (rand, -0.2, 1.2);
+            }
+
+          /*  the sums after alpha must not be touched  */
+          for (k = 0; k < MAX_CHANNELS + 1; k++)
+            expected[k] = actual[k] = -k;
+
+          sample_weighted_generic_funcs.sum (data, rowstride, bytes, alpha,
+                                             x_weights, y_weights, taps,
+                                             expected);
+          funcs.sum                         (data, rowstride, bytes, alpha,
+                                             x_weights, y_weights, taps,
+                                             actual);
+
+          if (memcmp (expected, actual, sizeof (actual)))
+            g_error ("%s: bytes %d, taps %d", name, bytes, taps);
+        }
+    }
+
+  sample_weighted_init (support);
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  sample_weighted_init (gimp_cpu_accel_get_support ());
+
+  ADD_TEST (sum);
+
+  return g_test_run ();
+}
@@ -0,0 +1,373 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-scale-region.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*  Checks that the accelerated row kernels of scale_region() the CPU
+ *  supports compute exactly what the generic ones do, on their own and
+ *  scaling whole regions.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "paint-funcs/paint-funcs-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/pixel-region.h"
+#include "base/tile-cache.h"
+#include "base/tile-manager.h"
+#include "base/tile-swap.h"
+
+#include "paint-funcs/scale-region.h"
+
+#include "gimp-accel-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/scale-region/" #function, function);
+
+/*  odd, so the accelerated versions have to handle a tail  */
+#define MAX_WIDTH     67
+#define MAX_TAPS      6
+#define N_ROWS        20000
+
+/*  larger than a tile, so the destination has partial tiles  */
+#define REGION_SIZE   150
+
+
+/*  Sums in the range of the premultiplied planes, some of them
+ *  rounding ties, or 0 or negative, the way the negative lobes of the
+ *  cubic and lanczos kernels make them.
+ */
+static gdouble
+random_sum (GRand *rand)
+{
+  switch (g_rand_int_range (rand, 0, 6))
+    {
+    case 0:  return 0.0;
+    case 1:  return g_rand_int_range (rand, -300, 300) + 0.5;
+    case 2:  return g_rand_double_range (rand, -1000.0, 0.0);
+    case 3:  return g_rand_double_range (rand, 0.0, 1e-6);
+    default: return g_rand_double_range (rand, -1000.0, 255.0 * 255.0 * 1.2);
+    }
+}
+
+/**
+ * filter:
+ *
+ * The accelerated kernels filter rows alike, for every number of taps,
+ * with indices and weights like those of scale_compute_weights().
+ **/
+static void
+filter (void)
+{
+  static const gint taps_of[] = { 2, 4, 6 };
+
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (1);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      ScaleRegionFuncs funcs;
+      gint             row;
+
+      scale_region_init (accel);
+      funcs = scale_region_funcs;
+
+      for (row = 0; row < N_ROWS; row++)
+        {
+          const gint taps   = taps_of[g_rand_int_range (rand, 0, 3)];
+          const gint n      = g_rand_int_range (rand, 0, MAX_WIDTH + 1);
+          gdouble    plane[MAX_WIDTH * 3 + MAX_TAPS];
+          gint       index[MAX_WIDTH];
+          gdouble    weights[MAX_WIDTH * MAX_TAPS];
+          gdouble    expected[MAX_WIDTH + 1];
+          gdouble    actual[MAX_WIDTH + 1];
+          gint       k;
+
+          for (k = 0; k < G_N_ELEMENTS (plane); k++)
+            plane[k] = g_rand_int_range (rand, 0, 256 * 256);
+
+          for (k = 0; k < n; k++)
+            index[k] = g_rand_int_range (rand, 0, MAX_WIDTH * 3 + 1);
+
+          for (k = 0; k < n * taps; k++)
+            weights[k] = g_rand_double_range (rand, -0.5, 1.5);
+
+          /*  the element after the row must not be touched  */
+          for (k = 0; k < MAX_WIDTH + 1; k++)
+            expected[k] = actual[k] = k;
+
+          scale_region_generic_funcs.filter (plane, index, weights, taps,
+                                             expected, n);
+          funcs.filter                       (plane, index, weights, taps,
+                                             actual,   n);
+
+          if (memcmp (expected, actual, sizeof (actual)))
+            g_error ("%s: filter, taps %d, n %d", name, taps, n);
+        }
+    }
+
+  scale_region_init (support);
+  g_rand_free (rand);
+}
+
+/**
+ * accumulate:
+ *
+ * The accelerated kernels add weighted rows to the sums alike.
+ **/
+static void
+accumulate (void)
+{
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (2);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      ScaleRegionFuncs funcs;
+      gint             row;
+
+      scale_region_init (accel);
+      funcs = scale_region_funcs;
+
+      for (row = 0; row < N_ROWS; row++)
+        {
+          const gint    n      = g_rand_int_range (rand, 0, MAX_WIDTH * 4 + 1);
+          const gdouble weight = g_rand_double_range (rand, -0.5, 1.5);
+          gdouble       values[MAX_WIDTH * 4];
+          gdouble       expected[MAX_WIDTH * 4 + 1];
+          gdouble       actual[MAX_WIDTH * 4 + 1];
+          gint          k;
+
+          for (k = 0; k < n; k++)
+            values[k] = random_sum (rand);
+
+          for (k = 0; k < MAX_WIDTH * 4 + 1; k++)
+            expected[k] = actual[k] = random_sum (rand);
+
+          scale_region_generic_funcs.accumulate (expected, values, weight, n);
+          funcs.accumulate                       (actual,   values, weight, n);
+
+          if (memcmp (expected, actual, sizeof (actual)))
+            g_error ("%s: accumulate, n %d", name, n);
+        }
+    }
+
+  scale_region_init (support);
+  g_rand_free (rand);
+}
+
+/**
+ * store:
+ *
+ * The accelerated kernels round, clamp and un-premultiply the sums to
+ * the same pixels, for every number of bytes.
+ **/
+static void
+store (void)
+{
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (3);
+  const gchar *name;
+  guint        accel;
+  gint         i;
+
+  for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+    {
+      ScaleRegionFuncs funcs;
+      gint             row;
+
+      scale_region_init (accel);
+      funcs = scale_region_funcs;
+
+      for (row = 0; row < N_ROWS; row++)
+        {
+          const gint bytes  = g_rand_int_range (rand, 1, 5);
+          const gint width  = g_rand_int_range (rand, 0, MAX_WIDTH + 1);
+          const gint stride = width + g_rand_int_range (rand, 0, 3);
+          gdouble    sums[(MAX_WIDTH + 2) * 4];
+          guchar     expected[MAX_WIDTH * 4 + 1];
+          guchar     actual[MAX_WIDTH * 4 + 1];
+          gint       k;
+
+          for (k = 0; k < stride * bytes; k++)
+            sums[k] = random_sum (rand);
+
+          /*  colors of 0 to 255 times alpha, and beyond  */
+          if (bytes == 2 || bytes == 4)
+            {
+              const gdouble *alpha = sums + (bytes - 1) * stride;
+
+              for (k = 0; k < (bytes - 1) * stride; k++)
+                if (g_rand_boolean (rand))
+                  sums[k] = (alpha[k % stride] *
+                             g_rand_double_range (rand, -10.0, 265.0));
+            }
+
+          /*  the byte after the row must not be touched  */
+          memset (expected, 0x55, sizeof (expected));
+          memset (actual,   0x55, sizeof (actual));
+
+          scale_region_generic_funcs.store (sums, stride, bytes, width,
+                                            expected);
+          funcs.store                       (sums, stride, bytes, width,
+                                            actual);
+
+          if (memcmp (expected, actual, width * bytes + 1))
+            g_error ("%s: store, bytes %d, width %d", name, bytes, width);
+        }
+    }
+
+  scale_region_init (support);
+  g_rand_free (rand);
+}
+
+/**
+ * region:
+ *
+ * Scaling a region up and down with every interpolation, the decimation
+ * steps included, gives the same pixels with all kernels.
+ **/
+static void
+region (void)
+{
+  static const gint sizes[] = { 257, 131, 71, 40, 1 };
+
+  const guint  support = gimp_cpu_accel_get_support ();
+  GRand       *rand    = g_rand_new_with_seed (4);
+  gint         bytes;
+
+  for (bytes = 1; bytes <= 4; bytes++)
+    {
+      const gint             size  = REGION_SIZE * REGION_SIZE * bytes;
+      guchar                *data  = g_new (guchar, size);
+      TileManager           *src   = tile_manager_new (REGION_SIZE,
+                                                       REGION_SIZE, bytes);
+      GimpInterpolationType  interpolation;
+      gint                   k;
+
+      for (k = 0; k < size; k++)
+        data[k] = g_rand_int_range (rand, 0, 256);
+
+      /*  runs of transparent and opaque pixels  */
+      if (bytes == 2 || bytes == 4)
+        for (k = bytes - 1; k < size; k += bytes)
+          switch ((k / bytes / 8) % 3)
+            {
+            case 0: data[k] = 0;   break;
+            case 1: data[k] = 255; break;
+            }
+
+      tile_manager_write_pixel_data (src, 0, 0,
+                                     REGION_SIZE - 1, REGION_SIZE - 1,
+                                     data, REGION_SIZE * bytes);
+
+      for (interpolation = GIMP_INTERPOLATION_LINEAR;
+           interpolation <= GIMP_INTERPOLATION_LANCZOS;
+           interpolation++)
+        {
+          for (k = 0; k < G_N_ELEMENTS (sizes) * G_N_ELEMENTS (sizes); k++)
+            {
+              const gint   width    = sizes[k % G_N_ELEMENTS (sizes)];
+              const gint   height   = sizes[k / G_N_ELEMENTS (sizes)];
+              const gint   n        = width * height * bytes;
+              guchar      *expected = g_new (guchar, n);
+              guchar      *actual   = g_new (guchar, n);
+              const gchar *name;
+              guint        accel;
+              gint         i;
+
+              for (i = 0; gimp_test_utils_get_accel (i, &name, &accel); i++)
+                {
+                  TileManager *dest = tile_manager_new (width, height, bytes);
+                  PixelRegion  srcPR;
+                  PixelRegion  destPR;
+
+                  scale_region_init (accel);
+
+                  pixel_region_init (&srcPR, src,
+                                     0, 0, REGION_SIZE, REGION_SIZE, FALSE);
+                  pixel_region_init (&destPR, dest,
+                                     0, 0, width, height, TRUE);
+
+                  scale_region (&srcPR, &destPR, interpolation, NULL, NULL);
+
+                  tile_manager_read_pixel_data (dest,
+                                                0, 0, width - 1, height - 1,
+                                                i ? actual : expected,
+                                                width * bytes);
+                  tile_manager_unref (dest);
+
+                  if (i && memcmp (expected, actual, n))
+                    g_error ("%s: bytes %d, interpolation %d, %dx%d",
+                             name, bytes, interpolation, width, height);
+                }
+
+              g_free (expected);
+              g_free (actual);
+            }
+        }
+
+      tile_manager_unref (src);
+      g_free (data);
+    }
+
+  scale_region_init (support);
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result;
+
+  g_thread_init (NULL);
+  g_type_init ();
+  tile_cache_init (G_MAXUINT32);
+  tile_swap_init (g_get_tmp_dir ());
+  pixel_processor_init (2);
+  g_test_init (&argc, &argv, NULL);
+
+  scale_region_init (gimp_cpu_accel_get_support ());
+
+  ADD_TEST (filter);
+  ADD_TEST (accumulate);
+  ADD_TEST (store);
+  ADD_TEST (region);
+
+  result = g_test_run ();
+
+  pixel_processor_exit ();
+  tile_cache_exit ();
+  tile_swap_exit ();
+
+  return result;
+}
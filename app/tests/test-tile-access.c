@@ -0,0 +1,268 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-tile-access.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "base/pixel-processor.h"
+#include "base/pixel-region.h"
+#include "base/tile.h"
+#include "base/tile-cache.h"
+#include "base/tile-manager.h"
+#include "base/tile-swap.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/tile-access/" #function, function);
+
+#define N_COLS    8
+#define N_ROWS    4
+#define N_TILES   (N_COLS * N_ROWS)
+#define WIDTH     (N_COLS * TILE_WIDTH)
+#define HEIGHT    (N_ROWS * TILE_HEIGHT)
+#define BPP       4
+
+#define N_WRITES  20000
+
+
+typedef struct
+{
+  TileManager *tiles;
+  gint         first;
+  gint         counts[N_TILES];
+} Writer;
+
+
+/*  Counts the writes to every other tile in the tile's first pixel  */
+static gpointer
+write_tiles (Writer *writer)
+{
+  GRand *rand = g_rand_new_with_seed (writer->first);
+  gint   i;
+
+  for (i = 0; i < N_WRITES; i++)
+    {
+      gint     n     = writer->first + 2 * g_rand_int_range (rand, 0,
+                                                             N_TILES / 2);
+      Tile    *tile  = tile_manager_get (writer->tiles, n, TRUE, TRUE);
+      guint32 *count = tile_data_pointer (tile, 0, 0);
+
+      (*count)++;
+
+      tile_release (tile, TRUE);
+
+      writer->counts[n]++;
+    }
+
+  g_rand_free (rand);
+
+  return NULL;
+}
+
+/**
+ * lock_threads:
+ *
+ * Two threads write tiles of a tile manager which the main thread
+ * keeps sharing with copies and reading pixels from.  No write gets
+ * lost to copying the tiles on write, and no tile is left locked.
+ **/
+static void
+lock_threads (void)
+{
+  TileManager *tiles = tile_manager_new (WIDTH, HEIGHT, BPP);
+  Writer       writers[2];
+  GRand       *rand  = g_rand_new_with_seed (N_WRITES);
+  gint         i, n;
+
+  for (i = 0; i < G_N_ELEMENTS (writers); i++)
+    {
+      memset (&writers[i], 0, sizeof (Writer));
+
+      writers[i].tiles = tiles;
+      writers[i].first = i;
+    }
+
+#ifdef ENABLE_MP
+  {
+    GThread *threads[G_N_ELEMENTS (writers)];
+
+    for (i = 0; i < G_N_ELEMENTS (writers); i++)
+      threads[i] = g_thread_create ((GThreadFunc) write_tiles, &writers[i],
+                                    TRUE, NULL);
+
+    for (n = 0; n < N_WRITES / 10; n++)
+      {
+        TileManager *copy = tile_manager_duplicate (tiles);
+        guchar       pixel[BPP];
+
+        tile_manager_read_pixel_data_1 (tiles,
+                                        g_rand_int_range (rand, 0, WIDTH),
+                                        g_rand_int_range (rand, 0, HEIGHT),
+                                        pixel);
+
+        tile_manager_unref (copy);
+      }
+
+    for (i = 0; i < G_N_ELEMENTS (writers); i++)
+      g_thread_join (threads[i]);
+  }
+#else
+  for (i = 0; i < G_N_ELEMENTS (writers); i++)
+    write_tiles (&writers[i]);
+#endif
+
+  for (n = 0; n < N_TILES; n++)
+    {
+      Tile    *tile  = tile_manager_get (tiles, n, TRUE, FALSE);
+      guint32 *count = tile_data_pointer (tile, 0, 0);
+
+      g_assert_cmpint (*count, ==, writers[n % 2].counts[n]);
+
+      tile_release (tile, FALSE);
+    }
+
+  g_rand_free (rand);
+  tile_manager_unref (tiles);
+
+  g_assert_cmpint (tile_global_refcount (), ==, 0);
+}
+
+static void
+copy_rows (gpointer     data,
+           PixelRegion *srcPR,
+           PixelRegion *destPR)
+{
+  const guchar *src  = srcPR->data;
+  guchar       *dest = destPR->data;
+  gint          y;
+
+  for (y = 0; y < srcPR->h; y++)
+    {
+      memcpy (dest, src, srcPR->w * srcPR->bytes);
+
+      src  += srcPR->rowstride;
+      dest += destPR->rowstride;
+    }
+}
+
+/*  Constructs the tile from the source tile manager, off by half a tile
+ *  so that the pixel processor's threads lock four of its tiles.
+ */
+static void
+validate_tile (TileManager *tm,
+               Tile        *tile,
+               TileManager *src)
+{
+  PixelRegion srcPR;
+  PixelRegion destPR;
+  gint        x, y;
+
+  tile_manager_get_tile_coordinates (tm, tile, &x, &y);
+
+  pixel_region_init (&srcPR, src,
+                     x + TILE_WIDTH / 2, y + TILE_HEIGHT / 2,
+                     tile_ewidth (tile), tile_eheight (tile), FALSE);
+  pixel_region_init_data (&destPR, tile_data_pointer (tile, 0, 0),
+                          tile_bpp (tile),
+                          tile_ewidth (tile) * tile_bpp (tile),
+                          0, 0, tile_ewidth (tile), tile_eheight (tile));
+
+  pixel_regions_process_parallel ((PixelProcessorFunc) copy_rows, NULL,
+                                  2, &srcPR, &destPR);
+}
+
+/**
+ * validate_parallel:
+ *
+ * A validate proc may lock other tiles on the pixel processor's
+ * threads, also when the tile is validated from within the tile
+ * manager, which holds the tile access lock then.
+ **/
+static void
+validate_parallel (void)
+{
+  TileManager *src   = tile_manager_new (WIDTH + TILE_WIDTH,
+                                         HEIGHT + TILE_HEIGHT, BPP);
+  TileManager *tiles = tile_manager_new (WIDTH, HEIGHT, BPP);
+  guchar      *data  = g_new (guchar, (WIDTH + TILE_WIDTH) *
+                                      (HEIGHT + TILE_HEIGHT) * BPP);
+  gint         i, x, y;
+
+  for (i = 0; i < (WIDTH + TILE_WIDTH) * (HEIGHT + TILE_HEIGHT) * BPP; i++)
+    data[i] = i * 7 + i / 251;
+
+  tile_manager_write_pixel_data (src,
+                                 0, 0, WIDTH + TILE_WIDTH - 1,
+                                 HEIGHT + TILE_HEIGHT - 1,
+                                 data, (WIDTH + TILE_WIDTH) * BPP);
+
+  tile_manager_set_validate_proc (tiles,
+                                  (TileValidateProc) validate_tile, src);
+
+  for (y = 0; y < HEIGHT; y += 13)
+    for (x = 0; x < WIDTH; x += 11)
+      {
+        const guchar *expected = (data +
+                                  ((y + TILE_HEIGHT / 2) *
+                                   (WIDTH + TILE_WIDTH) +
+                                   x + TILE_WIDTH / 2) * BPP);
+        guchar        pixel[BPP];
+
+        tile_manager_read_pixel_data_1 (tiles, x, y, pixel);
+
+        g_assert (memcmp (pixel, expected, BPP) == 0);
+      }
+
+  tile_manager_unref (tiles);
+  tile_manager_unref (src);
+
+  g_assert_cmpint (tile_global_refcount (), ==, 0);
+
+  g_free (data);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result;
+
+  g_thread_init (NULL);
+  g_type_init ();
+  tile_cache_init (G_MAXUINT32);
+  tile_swap_init (g_get_tmp_dir ());
+  pixel_processor_init (4);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (lock_threads);
+  ADD_TEST (validate_parallel);
+
+  result = g_test_run ();
+
+  pixel_processor_exit ();
+  tile_cache_exit ();
+  tile_swap_exit ();
+
+  return result;
+}
@@ -0,0 +1,307 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-tile-compress.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "base/tile.h"
+#include "base/tile-cache.h"
+#include "base/tile-compress.h"
+#include "base/tile-manager.h"
+#include "base/tile-swap.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/tile-compress/" #function, function);
+
+/*  the encoded size of a tile of write_stripes()  */
+#define STRIPES_SIZE  (4 * 2 * TILE_HEIGHT)
+
+
+typedef void (* FillFunc) (guchar *data,
+                           gint    n_pixels,
+                           gint    bpp);
+
+
+/*  full tiles and edge tiles  */
+static const struct
+{
+  gint width;
+  gint height;
+}
+tile_sizes[] =
+{
+  { TILE_WIDTH,     TILE_HEIGHT     },
+  { TILE_WIDTH - 1, TILE_HEIGHT     },
+  { TILE_WIDTH,     1               },
+  { 1,              TILE_HEIGHT     },
+  { 17,             5               },
+  { 1,              1               }
+};
+
+
+static void
+fill_uniform (guchar *data,
+              gint    n_pixels,
+              gint    bpp)
+{
+  gint i;
+
+  for (i = 0; i < n_pixels * bpp; i++)
+    data[i] = 0x40 + i % bpp;
+}
+
+static void
+fill_random (guchar *data,
+             gint    n_pixels,
+             gint    bpp)
+{
+  GRand *rand = g_rand_new_with_seed (n_pixels * bpp);
+  gint   i;
+
+  for (i = 0; i < n_pixels * bpp; i++)
+    data[i] = g_rand_int_range (rand, 0, 256);
+
+  g_rand_free (rand);
+}
+
+/*  Literals of 128 values, the shortest that need a 16 bit count,
+ *  each ended by a run of 3: the worst case of the encoding.
+ */
+static void
+fill_worst_case (guchar *data,
+                 gint    n_pixels,
+                 gint    bpp)
+{
+  gint i, c;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      gint k = i % 131;
+
+      for (c = 0; c < bpp; c++)
+        data[i * bpp + c] = k < 128 ? ((k & 1) ? 0x55 : 0xaa) : 0x33;
+    }
+}
+
+static void
+round_trip (FillFunc fill)
+{
+  gint i, bpp;
+
+  for (i = 0; i < G_N_ELEMENTS (tile_sizes); i++)
+    for (bpp = 1; bpp <= 4; bpp++)
+      {
+        const gint  n_pixels = tile_sizes[i].width * tile_sizes[i].height;
+        const gint  max_size = TILE_COMPRESS_MAX_SIZE (n_pixels, bpp);
+        guchar     *data     = g_malloc (n_pixels * bpp);
+        guchar     *encoded  = g_malloc (max_size + 1);
+        guchar     *decoded  = g_malloc (n_pixels * bpp);
+        gint        size;
+
+        fill (data, n_pixels, bpp);
+
+        /*  catch writes past the bound  */
+        encoded[max_size] = 0xee;
+
+        size = tile_compress_encode (data, n_pixels, bpp, encoded);
+        g_assert_cmpint (size, >, 0);
+        g_assert_cmpint (size, <=, max_size);
+        g_assert_cmpint (encoded[max_size], ==, 0xee);
+
+        tile_compress_decode (encoded, n_pixels, bpp, decoded);
+        g_assert (memcmp (data, decoded, n_pixels * bpp) == 0);
+
+        g_free (decoded);
+        g_free (encoded);
+        g_free (data);
+      }
+}
+
+/**
+ * round_trip_uniform:
+ *
+ * Uniform tiles decode to what was encoded, in a few bytes per
+ * channel.
+ **/
+static void
+round_trip_uniform (void)
+{
+  guchar data[TILE_WIDTH * TILE_HEIGHT * 4];
+  guchar encoded[TILE_COMPRESS_MAX_SIZE (TILE_WIDTH * TILE_HEIGHT, 4)];
+
+  round_trip (fill_uniform);
+
+  fill_uniform (data, TILE_WIDTH * TILE_HEIGHT, 4);
+  g_assert_cmpint (tile_compress_encode (data, TILE_WIDTH * TILE_HEIGHT, 4,
+                                         encoded), ==, 4 * 4);
+}
+
+/**
+ * round_trip_random:
+ *
+ * Random tiles decode to what was encoded.
+ **/
+static void
+round_trip_random (void)
+{
+  round_trip (fill_random);
+}
+
+/**
+ * round_trip_worst_case:
+ *
+ * The worst case decodes to what was encoded, within the bound.
+ **/
+static void
+round_trip_worst_case (void)
+{
+  round_trip (fill_worst_case);
+}
+
+/*  Rows of a different value each, runs which compress to 2 bytes per
+ *  row and channel.
+ */
+static void
+write_stripes (TileManager *tm,
+               gint         col)
+{
+  guchar data[TILE_WIDTH * TILE_HEIGHT * 4];
+  gint   y;
+
+  for (y = 0; y < TILE_HEIGHT; y++)
+    memset (data + y * TILE_WIDTH * 4, col * TILE_HEIGHT + y, TILE_WIDTH * 4);
+
+  tile_manager_write_pixel_data (tm,
+                                 col * TILE_WIDTH, 0,
+                                 col * TILE_WIDTH + TILE_WIDTH - 1,
+                                 TILE_HEIGHT - 1,
+                                 data, TILE_WIDTH * 4);
+}
+
+static void
+check_stripes (TileManager *tm,
+               gint         col)
+{
+  guchar data[TILE_WIDTH * TILE_HEIGHT * 4];
+  gint   i;
+
+  tile_manager_read_pixel_data (tm,
+                                col * TILE_WIDTH, 0,
+                                col * TILE_WIDTH + TILE_WIDTH - 1,
+                                TILE_HEIGHT - 1,
+                                data, TILE_WIDTH * 4);
+
+  for (i = 0; i < TILE_WIDTH * TILE_HEIGHT * 4; i++)
+    g_assert_cmpint (data[i], ==,
+                     (guchar) (col * TILE_HEIGHT + i / (TILE_WIDTH * 4)));
+}
+
+/**
+ * eviction_to_swap:
+ *
+ * With room in the cache for one tile, every tile released pushes
+ * the one before it into the compressed tier.  When the tier is full
+ * its least recently stored tile goes on to the swap file; tiles are
+ * read back from either one unchanged.
+ **/
+static void
+eviction_to_swap (void)
+{
+  TileManager       *tm = tile_manager_new (8 * TILE_WIDTH, TILE_HEIGHT, 4);
+  TileCompressStats  stats;
+  gint               i;
+
+  tile_cache_set_size (TILE_WIDTH * TILE_HEIGHT * 4);
+  tile_compress_set_size (4 * STRIPES_SIZE);
+
+  for (i = 0; i < 8; i++)
+    write_stripes (tm, i);
+
+  /*  tile 7 is in the cache, 3 to 6 in the tier, 0 to 2 swapped out  */
+  tile_compress_get_stats (&stats);
+  g_assert_cmpint (stats.n_tiles,  ==, 4);
+  g_assert_cmpint (stats.cur_size, ==, 4 * STRIPES_SIZE);
+  g_assert_cmpint (stats.raw_size, ==, 4 * TILE_WIDTH * TILE_HEIGHT * 4);
+  g_assert_cmpint (stats.evicted,  ==, 3);
+  g_assert_cmpint (stats.hits,     ==, 0);
+  g_assert_cmpint (stats.misses,   ==, 0);
+
+  /*  caching tile 6 pushes 7 into the tier, which has room again  */
+  check_stripes (tm, 6);
+
+  tile_compress_get_stats (&stats);
+  g_assert_cmpint (stats.hits,    ==, 1);
+  g_assert_cmpint (stats.evicted, ==, 3);
+
+  /*  caching tile 0 pushes 6 into the tier and 3 out of it  */
+  check_stripes (tm, 0);
+
+  tile_compress_get_stats (&stats);
+  g_assert_cmpint (stats.misses,  ==, 1);
+  g_assert_cmpint (stats.evicted, ==, 4);
+
+  check_stripes (tm, 3);
+
+  tile_compress_get_stats (&stats);
+  g_assert_cmpint (stats.misses,  ==, 2);
+
+  for (i = 0; i < 8; i++)
+    check_stripes (tm, i);
+
+  tile_manager_unref (tm);
+
+  tile_compress_get_stats (&stats);
+  g_assert_cmpint (stats.n_tiles,  ==, 0);
+  g_assert_cmpint (stats.cur_size, ==, 0);
+
+  tile_compress_set_size (0);
+  tile_cache_set_size (G_MAXUINT32);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result;
+
+  g_type_init ();
+  tile_cache_init (G_MAXUINT32);
+  tile_compress_init (0);
+  tile_swap_init (g_get_tmp_dir ());
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (round_trip_uniform);
+  ADD_TEST (round_trip_random);
+  ADD_TEST (round_trip_worst_case);
+  ADD_TEST (eviction_to_swap);
+
+  result = g_test_run ();
+
+  tile_cache_exit ();
+  tile_compress_exit ();
+  tile_swap_exit ();
+
+  return result;
+}
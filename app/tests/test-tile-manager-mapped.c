@@ -0,0 +1,207 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-tile-manager-mapped.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib-object.h>
+#include <glib/gstdio.h>
+
+#include "base/base-types.h"
+
+#include "base/tile-cache.h"
+#include "base/tile-manager.h"
+#include "base/tile-manager-mapped.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/tile-manager-mapped/" #function, function);
+
+/*  not a multiple of the tile size, so there are edge tiles  */
+#define WIDTH   150
+#define HEIGHT  100
+#define BPP     3
+
+
+static guchar *
+create_pixels (void)
+{
+  guchar *pixels = g_new (guchar, WIDTH * HEIGHT * BPP);
+  gint    i;
+
+  for (i = 0; i < WIDTH * HEIGHT * BPP; i++)
+    pixels[i] = (i * 7 + i / 251) & 0xff;
+
+  return pixels;
+}
+
+static gchar *
+create_tile_file (const guchar *pixels)
+{
+  TileManager *tm;
+  GError      *error = NULL;
+  gchar       *filename;
+  gint         fd;
+
+  fd = g_file_open_tmp ("gimp-test-tiles-XXXXXX", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  tm = tile_manager_new (WIDTH, HEIGHT, BPP);
+  tile_manager_write_pixel_data (tm, 0, 0, WIDTH - 1, HEIGHT - 1,
+                                 pixels, WIDTH * BPP);
+
+  tile_manager_save_mapped (tm, filename, &error);
+  g_assert_no_error (error);
+
+  tile_manager_unref (tm);
+
+  return filename;
+}
+
+/**
+ * read_back:
+ *
+ * A mapped tile manager reads back what was saved.
+ **/
+static void
+read_back (void)
+{
+  guchar      *pixels   = create_pixels ();
+  gchar       *filename = create_tile_file (pixels);
+  guchar      *actual   = g_new0 (guchar, WIDTH * HEIGHT * BPP);
+  TileManager *tm;
+  GError      *error = NULL;
+
+  tm = tile_manager_new_mapped (filename, 0, WIDTH, HEIGHT, BPP, &error);
+  g_assert_no_error (error);
+
+  tile_manager_read_pixel_data (tm, 0, 0, WIDTH - 1, HEIGHT - 1,
+                                actual, WIDTH * BPP);
+  g_assert (memcmp (pixels, actual, WIDTH * HEIGHT * BPP) == 0);
+
+  tile_manager_unref (tm);
+
+  g_unlink (filename);
+  g_free (filename);
+  g_free (actual);
+  g_free (pixels);
+}
+
+/**
+ * copy_on_write:
+ *
+ * Writing to a mapped tile manager, or to a duplicate of it, changes
+ * neither the file nor the other tile manager.
+ **/
+static void
+copy_on_write (void)
+{
+  const guchar  white[BPP] = { 255, 255, 255 };
+  guchar       *pixels     = create_pixels ();
+  gchar        *filename   = create_tile_file (pixels);
+  TileManager  *tm;
+  TileManager  *copy;
+  GError       *error      = NULL;
+  guchar       *contents   = g_new0 (guchar, WIDTH * HEIGHT * BPP);
+  guchar        actual[BPP];
+
+  tm = tile_manager_new_mapped (filename, 0, WIDTH, HEIGHT, BPP, &error);
+  g_assert_no_error (error);
+
+  copy = tile_manager_duplicate (tm);
+
+  tile_manager_write_pixel_data_1 (tm, 10, 10, white);
+  tile_manager_write_pixel_data_1 (copy, WIDTH - 1, HEIGHT - 1, white);
+
+  tile_manager_read_pixel_data_1 (tm, 10, 10, actual);
+  g_assert (memcmp (actual, white, BPP) == 0);
+
+  tile_manager_read_pixel_data_1 (copy, 10, 10, actual);
+  g_assert (memcmp (actual, pixels + (10 * WIDTH + 10) * BPP, BPP) == 0);
+
+  tile_manager_read_pixel_data_1 (tm, WIDTH - 1, HEIGHT - 1, actual);
+  g_assert (memcmp (actual, pixels + (WIDTH * HEIGHT - 1) * BPP, BPP) == 0);
+
+  /*  the copy keeps the mapping alive  */
+  tile_manager_unref (tm);
+
+  tile_manager_read_pixel_data_1 (copy, 0, 0, actual);
+  g_assert (memcmp (actual, pixels, BPP) == 0);
+
+  tile_manager_unref (copy);
+
+  /*  the file is unchanged  */
+  tm = tile_manager_new_mapped (filename, 0, WIDTH, HEIGHT, BPP, &error);
+  g_assert_no_error (error);
+
+  tile_manager_read_pixel_data (tm, 0, 0, WIDTH - 1, HEIGHT - 1,
+                                contents, WIDTH * BPP);
+  g_assert (memcmp (pixels, contents, WIDTH * HEIGHT * BPP) == 0);
+
+  tile_manager_unref (tm);
+
+  g_unlink (filename);
+  g_free (filename);
+  g_free (contents);
+  g_free (pixels);
+}
+
+/**
+ * short_file:
+ *
+ * A file too short for the image is rejected.
+ **/
+static void
+short_file (void)
+{
+  guchar      *pixels   = create_pixels ();
+  gchar       *filename = create_tile_file (pixels);
+  TileManager *tm;
+  GError      *error = NULL;
+
+  tm = tile_manager_new_mapped (filename, 1, WIDTH, HEIGHT, BPP, &error);
+  g_assert (tm == NULL);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED);
+
+  g_clear_error (&error);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (pixels);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_type_init ();
+  tile_cache_init (G_MAXUINT32);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (read_back);
+  ADD_TEST (copy_on_write);
+  ADD_TEST (short_file);
+
+  return g_test_run ();
+}
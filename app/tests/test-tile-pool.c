@@ -0,0 +1,131 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-tile-pool.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "base/tile.h"
+#include "base/tile-pool.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/tile-pool/" #function, function);
+
+/*  a multiple of half a thread's magazine, so that a new thread's
+ *  magazine is empty again after allocating them
+ */
+#define N_BLOCKS  96
+
+
+typedef struct
+{
+  gint     size;
+  guint64  used;
+} Blocks;
+
+
+/*  Allocates and frees N_BLOCKS blocks of @blocks->size, in a thread
+ *  of its own which starts with empty magazines.
+ */
+static gpointer
+alloc_blocks (Blocks *blocks)
+{
+  TilePoolStats before;
+  TilePoolStats after;
+  gpointer      data[N_BLOCKS];
+  gint          n;
+
+  tile_pool_get_stats (&before);
+
+  for (n = 0; n < N_BLOCKS; n++)
+    {
+      data[n] = tile_pool_alloc (blocks->size);
+
+      g_assert_cmpint ((gsize) data[n] % 16, ==, 0);
+
+      memset (data[n], n, blocks->size);
+    }
+
+  tile_pool_get_stats (&after);
+
+  blocks->used = after.used - before.used;
+
+  for (n = 0; n < N_BLOCKS; n++)
+    {
+      g_assert_cmpint (((guchar *) data[n])[blocks->size - 1], ==, n);
+
+      tile_pool_free (data[n]);
+    }
+
+  return NULL;
+}
+
+/**
+ * block_sizes:
+ *
+ * Full tiles take exactly their size from the pool, edge tiles less
+ * than 1 KiB more than theirs, and the blocks are aligned.
+ **/
+static void
+block_sizes (void)
+{
+  gint size;
+
+  for (size = 1; size <= TILE_WIDTH * TILE_HEIGHT * 4; size += 61)
+    {
+      TilePoolStats before;
+      TilePoolStats after;
+      Blocks        edge = { size, };
+      Blocks        full = { TILE_WIDTH * TILE_HEIGHT * (size % 4 + 1), };
+
+      tile_pool_get_stats (&before);
+
+      g_thread_join (g_thread_create ((GThreadFunc) alloc_blocks, &edge,
+                                      TRUE, NULL));
+      g_thread_join (g_thread_create ((GThreadFunc) alloc_blocks, &full,
+                                      TRUE, NULL));
+
+      tile_pool_get_stats (&after);
+
+      g_assert_cmpint (edge.used, >=, N_BLOCKS * edge.size);
+      g_assert_cmpint (edge.used, <,  N_BLOCKS * MAX (edge.size + 1024, 512));
+      g_assert_cmpint (full.used, ==, N_BLOCKS * full.size);
+
+      /*  the threads' magazines went back to the pool  */
+      g_assert_cmpint (after.used, ==, before.used);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_thread_init (NULL);
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (block_sizes);
+
+  return g_test_run ();
+}
@@ -0,0 +1,232 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-tile-summary.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib-object.h>
+
+#include "base/base-types.h"
+
+#include "base/tile.h"
+#include "base/tile-cache.h"
+#include "base/tile-manager.h"
+#include "base/tile-stats.h"
+#include "base/tile-swap.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_func ("/tile-summary/" #function, function);
+
+#define TILE_SIZE  (TILE_WIDTH * TILE_HEIGHT * 4)
+
+
+static const guchar opaque[4] = { 10, 20, 30, 255 };
+
+
+static void
+fill_uniform (guchar       *data,
+              const guchar *pixel)
+{
+  gint i;
+
+  for (i = 0; i < TILE_SIZE; i += 4)
+    memcpy (data + i, pixel, 4);
+}
+
+static void
+fill_pattern (guchar *data)
+{
+  gint i;
+
+  for (i = 0; i < TILE_SIZE; i++)
+    data[i] = (i * 7 + i / 251) & 0xff;
+}
+
+static void
+write_tile (TileManager  *tm,
+            gint          col,
+            const guchar *data)
+{
+  tile_manager_write_pixel_data (tm,
+                                 col * TILE_WIDTH, 0,
+                                 col * TILE_WIDTH + TILE_WIDTH - 1,
+                                 TILE_HEIGHT - 1,
+                                 data, TILE_WIDTH * 4);
+}
+
+static void
+check_tile (TileManager  *tm,
+            gint          col,
+            const guchar *expected)
+{
+  guchar data[TILE_SIZE];
+
+  tile_manager_read_pixel_data (tm,
+                                col * TILE_WIDTH, 0,
+                                col * TILE_WIDTH + TILE_WIDTH - 1,
+                                TILE_HEIGHT - 1,
+                                data, TILE_WIDTH * 4);
+
+  g_assert (memcmp (data, expected, TILE_SIZE) == 0);
+}
+
+/**
+ * uniform_dropped_by_zorch:
+ *
+ * A uniform tile pushed out of the cache is dropped instead of
+ * swapped out, and is filled in again from its pixel.  Other tiles
+ * still go to the swap file.
+ **/
+static void
+uniform_dropped_by_zorch (void)
+{
+  TileManager *tm = tile_manager_new (2 * TILE_WIDTH, TILE_HEIGHT, 4);
+  guchar       uniform[TILE_SIZE];
+  guchar       pattern[TILE_SIZE];
+  guchar       pixel[4];
+  TileStats    stats;
+  Tile        *tile;
+
+  fill_uniform (uniform, opaque);
+  fill_pattern (pattern);
+
+  tile_cache_set_size (TILE_SIZE);
+  tile_stats_reset ();
+
+  /*  caching tile 1 pushes tile 0 out  */
+  write_tile (tm, 0, uniform);
+  write_tile (tm, 1, pattern);
+
+  tile_stats_get_totals (&stats);
+  g_assert_cmpint (stats.uniform_skips, ==, 1);
+  g_assert_cmpint (stats.bytes_skipped, ==, TILE_SIZE);
+  g_assert_cmpint (stats.swap_outs,     ==, 0);
+
+  /*  caching tile 0 pushes tile 1 out, to the swap file  */
+  check_tile (tm, 0, uniform);
+
+  tile_stats_get_totals (&stats);
+  g_assert_cmpint (stats.swap_ins,  ==, 0);
+  g_assert_cmpint (stats.swap_outs, ==, 1);
+
+  tile = tile_manager_get_tile (tm, 0, 0, TRUE, FALSE);
+  g_assert (tile_is_uniform (tile, pixel));
+  g_assert (memcmp (pixel, opaque, 4) == 0);
+  tile_release (tile, FALSE);
+
+  check_tile (tm, 1, pattern);
+
+  tile_stats_get_totals (&stats);
+  g_assert_cmpint (stats.swap_ins,      ==, 1);
+  g_assert_cmpint (stats.uniform_skips, ==, 2);
+
+  check_tile (tm, 0, uniform);
+
+  tile_manager_unref (tm);
+
+  tile_cache_set_size (G_MAXUINT32);
+}
+
+/**
+ * summary_after_dirty_write:
+ *
+ * Releasing a tile written to updates its summary, releasing one
+ * only read from doesn't need to.
+ **/
+static void
+summary_after_dirty_write (void)
+{
+  static const guchar transparent[4] = { 0, 0, 0, 0 };
+
+  TileManager *tm = tile_manager_new (TILE_WIDTH, TILE_HEIGHT, 4);
+  guchar       uniform[TILE_SIZE];
+  guchar       pixel[4];
+  Tile        *tile;
+  guchar      *data;
+
+  /*  new tiles are validated to transparent  */
+  tile = tile_manager_get_tile (tm, 0, 0, TRUE, FALSE);
+  g_assert (tile_is_uniform (tile, pixel));
+  g_assert (memcmp (pixel, transparent, 4) == 0);
+  g_assert (tile_is_transparent (tile));
+  tile_release (tile, FALSE);
+
+  fill_uniform (uniform, opaque);
+  write_tile (tm, 0, uniform);
+
+  tile = tile_manager_get_tile (tm, 0, 0, TRUE, TRUE);
+  g_assert (tile_is_uniform (tile, pixel));
+  g_assert (memcmp (pixel, opaque, 4) == 0);
+  g_assert (! tile_is_transparent (tile));
+
+  data = tile_data_pointer (tile, 5, 7);
+  data[0]++;
+  tile_release (tile, TRUE);
+
+  tile = tile_manager_get_tile (tm, 0, 0, TRUE, TRUE);
+  g_assert (! tile_is_uniform (tile, NULL));
+
+  /*  transparent, but not uniform  */
+  data = tile_data_pointer (tile, 0, 0);
+  memset (data, 0, TILE_SIZE);
+  data[0] = 1;
+  tile_release (tile, TRUE);
+
+  tile = tile_manager_get_tile (tm, 0, 0, TRUE, TRUE);
+  g_assert (! tile_is_uniform (tile, NULL));
+  g_assert (tile_is_transparent (tile));
+
+  data = tile_data_pointer (tile, 0, 0);
+  fill_uniform (data, opaque);
+  tile_release (tile, TRUE);
+
+  tile = tile_manager_get_tile (tm, 0, 0, TRUE, FALSE);
+  g_assert (tile_is_uniform (tile, pixel));
+  g_assert (memcmp (pixel, opaque, 4) == 0);
+  tile_release (tile, FALSE);
+
+  tile_manager_unref (tm);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  gint result;
+
+  g_type_init ();
+  tile_cache_init (G_MAXUINT32);
+  tile_swap_init (g_get_tmp_dir ());
+  tile_stats_init ();
+  tile_stats_set_enabled (TRUE);
+  g_test_init (&argc, &argv, NULL);
+
+  ADD_TEST (uniform_dropped_by_zorch);
+  ADD_TEST (summary_after_dirty_write);
+
+  result = g_test_run ();
+
+  tile_stats_exit ();
+  tile_cache_exit ();
+  tile_swap_exit ();
+
+  return result;
+}
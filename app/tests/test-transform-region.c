@@ -0,0 +1,772 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * test-transform-region.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
+
+#include "core/core-types.h"
+
+#include "base/pixel-region.h"
+#include "base/tile-manager.h"
+#include "base/tile.h"
+
+#include "paint-funcs/scale-region.h"
+
+#include "core/gimp.h"
+#include "core/gimp-transform-region.h"
+#include "core/gimpcontext.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-transform-region/" #function, gimp, function);
+
+/*  several tiles, and neither is a multiple of the tile size  */
+#define SRC_WIDTH        150
+#define SRC_HEIGHT       130
+#define SRC_X            -7
+#define SRC_Y            11
+#define DEST_WIDTH       170
+#define DEST_HEIGHT      140
+
+#define BPP              4
+#define RECURSION_LEVEL  3
+
+
+/*  The transform as it was done before it ran in parallel: pixel by
+ *  pixel, each row of a destination tile stepped from its first pixel,
+ *  reading the source from memory.
+ */
+typedef struct
+{
+  const guchar          *src;
+  gint                   u1, v1, u2, v2;
+  const GimpMatrix3     *m;
+  GimpInterpolationType  interpolation;
+  const guchar          *bg_color;
+  const gfloat          *lanczos;
+} Reference;
+
+
+static const guchar *
+reference_pixel (const Reference *ref,
+                 gint             x,
+                 gint             y)
+{
+  if (x < 0 || x >= ref->u2 - ref->u1 || y < 0 || y >= ref->v2 - ref->v1)
+    return ref->bg_color;
+
+  return ref->src + (y * (ref->u2 - ref->u1) + x) * BPP;
+}
+
+static void
+reference_nearest (const Reference *ref,
+                   gdouble          u,
+                   gdouble          v,
+                   guchar          *color)
+{
+  const gint iu = floor (u + 0.5 + 1.e-5);
+  const gint iv = floor (v + 0.5 + 1.e-5);
+
+  if (iu >= ref->u1 && iu < ref->u2 && iv >= ref->v1 && iv < ref->v2)
+    memcpy (color, reference_pixel (ref, iu - ref->u1, iv - ref->v1), BPP);
+  else
+    memcpy (color, ref->bg_color, BPP);
+}
+
+#define BILINEAR(jk, j1k, jk1, j1k1, dx, dy) \
+                ((1 - dy) * (jk  + dx * (j1k  - jk)) + \
+                      dy  * (jk1 + dx * (j1k1 - jk1)))
+
+static void
+reference_linear (const Reference *ref,
+                  gdouble          u,
+                  gdouble          v,
+                  guchar          *color)
+{
+  const gint    iu = floor (u);
+  const gint    iv = floor (v);
+  const gdouble du = u - iu;
+  const gdouble dv = v - iv;
+  const guchar *p[4];
+  gdouble       a_val, a_recip;
+  gint          i;
+
+  p[0] = reference_pixel (ref, iu,     iv);
+  p[1] = reference_pixel (ref, iu + 1, iv);
+  p[2] = reference_pixel (ref, iu,     iv + 1);
+  p[3] = reference_pixel (ref, iu + 1, iv + 1);
+
+  a_val = BILINEAR (p[0][ALPHA], p[1][ALPHA], p[2][ALPHA], p[3][ALPHA],
+                    du, dv);
+
+  if (a_val <= 0.0)
+    {
+      a_recip = 0.0;
+      color[ALPHA] = 0;
+    }
+  else if (a_val >= 255.0)
+    {
+      a_recip = 1.0 / a_val;
+      color[ALPHA] = 255;
+    }
+  else
+    {
+      a_recip = 1.0 / a_val;
+      color[ALPHA] = RINT (a_val);
+    }
+
+  for (i = 0; i < ALPHA; i++)
+    {
+      gint newval = ROUND (a_recip *
+                           BILINEAR (p[0][ALPHA] * p[0][i],
+                                     p[1][ALPHA] * p[1][i],
+                                     p[2][ALPHA] * p[2][i],
+                                     p[3][ALPHA] * p[3][i],
+                                     du, dv));
+
+      color[i] = CLAMP (newval, 0, 255);
+    }
+}
+
+#undef BILINEAR
+
+/*  Catmull-Rom, of integers: the rows were truncated  */
+static gdouble
+reference_cubic_1d (gdouble dx,
+                    gint    jm1,
+                    gint    j,
+                    gint    jp1,
+                    gint    jp2)
+{
+  return ((( ( - jm1 + 3 * j - 3 * jp1 + jp2 ) * dx +
+             ( 2 * jm1 - 5 * j + 4 * jp1 - jp2 ) ) * dx +
+             ( - jm1 + jp1 ) ) * dx + (j + j) ) / 2.0;
+}
+
+static void
+reference_cubic (const Reference *ref,
+                 gdouble          u,
+                 gdouble          v,
+                 guchar          *color)
+{
+  const gint    iu = floor (u);
+  const gint    iv = floor (v);
+  const gdouble du = u - iu;
+  const gdouble dv = v - iv;
+  const guchar *p[4][4];
+  gdouble       rows[4];
+  gdouble       a_val, a_recip;
+  gint          i, j, b;
+
+  for (j = 0; j < 4; j++)
+    for (i = 0; i < 4; i++)
+      p[j][i] = reference_pixel (ref, iu - 1 + i, iv - 1 + j);
+
+  for (j = 0; j < 4; j++)
+    rows[j] = reference_cubic_1d (du,
+                                  p[j][0][ALPHA], p[j][1][ALPHA],
+                                  p[j][2][ALPHA], p[j][3][ALPHA]);
+
+  a_val = reference_cubic_1d (dv, rows[0], rows[1], rows[2], rows[3]);
+
+  if (a_val <= 0.0)
+    {
+      a_recip = 0.0;
+      color[ALPHA] = 0;
+    }
+  else if (a_val > 255.0)
+    {
+      a_recip = 1.0 / a_val;
+      color[ALPHA] = 255;
+    }
+  else
+    {
+      a_recip = 1.0 / a_val;
+      color[ALPHA] = RINT (a_val);
+    }
+
+  for (b = 0; b < ALPHA; b++)
+    {
+      gint newval;
+
+      for (j = 0; j < 4; j++)
+        rows[j] = reference_cubic_1d (du,
+                                      p[j][0][ALPHA] * p[j][0][b],
+                                      p[j][1][ALPHA] * p[j][1][b],
+                                      p[j][2][ALPHA] * p[j][2][b],
+                                      p[j][3][ALPHA] * p[j][3][b]);
+
+      newval = ROUND (a_recip * reference_cubic_1d (dv,
+                                                    rows[0], rows[1],
+                                                    rows[2], rows[3]));
+
+      color[b] = CLAMP (newval, 0, 255);
+    }
+}
+
+static void
+reference_lanczos (const Reference *ref,
+                   gdouble          u,
+                   gdouble          v,
+                   guchar          *color)
+{
+  const gint iu = (gint) u;
+  const gint iv = (gint) v;
+  const gint su = (gint) ((u - iu) * LANCZOS_SPP);
+  const gint sv = (gint) ((v - iv) * LANCZOS_SPP);
+  gdouble    x_kernel[LANCZOS_WIDTH2];
+  gdouble    y_kernel[LANCZOS_WIDTH2];
+  gdouble    x_sum, y_sum;
+  gdouble    aval, arecip;
+  gint       i, j, b;
+
+  for (x_sum = y_sum = 0.0, i = LANCZOS_WIDTH; i >= -LANCZOS_WIDTH; i--)
+    {
+      gint pos = i * LANCZOS_SPP;
+
+      x_sum += x_kernel[LANCZOS_WIDTH + i] = ref->lanczos[ABS (su - pos)];
+      y_sum += y_kernel[LANCZOS_WIDTH + i] = ref->lanczos[ABS (sv - pos)];
+    }
+
+  for (i = 0; i < LANCZOS_WIDTH2; i++)
+    {
+      x_kernel[i] /= x_sum;
+      y_kernel[i] /= y_sum;
+    }
+
+  aval = 0.0;
+
+  for (j = 0; j < LANCZOS_WIDTH2; j++)
+    for (i = 0; i < LANCZOS_WIDTH2; i++)
+      aval += (y_kernel[j] * x_kernel[i] *
+               (gdouble) reference_pixel (ref,
+                                          iu - LANCZOS_WIDTH + i,
+                                          iv - LANCZOS_WIDTH + j)[ALPHA]);
+
+  if (aval <= 0.0)
+    {
+      arecip = 0.0;
+      aval   = 0;
+    }
+  else if (aval > 255.0)
+    {
+      arecip = 1.0 / aval;
+      aval   = 255;
+    }
+  else
+    {
+      arecip = 1.0 / aval;
+    }
+
+  for (b = 0; b < ALPHA; b++)
+    {
+      gdouble newval = 0.0;
+
+      for (j = 0; j < LANCZOS_WIDTH2; j++)
+        for (i = 0; i < LANCZOS_WIDTH2; i++)
+          {
+            const guchar *p = reference_pixel (ref,
+                                               iu - LANCZOS_WIDTH + i,
+                                               iv - LANCZOS_WIDTH + j);
+
+            newval += (y_kernel[j] * x_kernel[i] *
+                       (gdouble) p[b] * (gdouble) p[ALPHA]);
+          }
+
+      newval *= arecip;
+      color[b] = CLAMP (ROUND (newval), 0, 255);
+    }
+
+  color[ALPHA] = RINT (aval);
+}
+
+/*  supersampling, in fixed point with 10 bits of fraction  */
+#define FIXED_SHIFT  10
+#define FIXED_UNIT   (1 << FIXED_SHIFT)
+
+static void
+reference_sample_bi (const Reference *ref,
+                     gint             x,
+                     gint             y,
+                     guchar          *color)
+{
+  const gint    xscale = (x & (FIXED_UNIT - 1));
+  const gint    yscale = (y & (FIXED_UNIT - 1));
+  const gint    x0     = x >> FIXED_SHIFT;
+  const gint    y0     = y >> FIXED_SHIFT;
+  const guchar *C[4];
+  gint          i;
+
+  C[0] = reference_pixel (ref, x0,     y0);
+  C[2] = reference_pixel (ref, x0 + 1, y0);
+  C[1] = reference_pixel (ref, x0,     y0 + 1);
+  C[3] = reference_pixel (ref, x0 + 1, y0 + 1);
+
+#define lerp(v1, v2, r) \
+        (((guint)(v1) * (FIXED_UNIT - (guint)(r)) + \
+          (guint)(v2) * (guint)(r)) >> FIXED_SHIFT)
+
+  color[ALPHA] = lerp (lerp (C[0][ALPHA], C[1][ALPHA], yscale),
+                       lerp (C[2][ALPHA], C[3][ALPHA], yscale), xscale);
+
+  for (i = 0; i < ALPHA; i++)
+    {
+      if (color[ALPHA])
+        color[i] = lerp (lerp (C[0][i] * C[0][ALPHA] / 255,
+                               C[1][i] * C[1][ALPHA] / 255, yscale),
+                         lerp (C[2][i] * C[2][ALPHA] / 255,
+                               C[3][i] * C[3][ALPHA] / 255, yscale), xscale);
+      else
+        color[i] = 0;
+    }
+
+#undef lerp
+}
+
+static gboolean
+reference_supersample_test (gint x0, gint y0,
+                            gint x1, gint y1,
+                            gint x2, gint y2,
+                            gint x3, gint y3)
+{
+  return (abs (x0 - x1) > FIXED_UNIT || abs (x1 - x2) > FIXED_UNIT ||
+          abs (x2 - x3) > FIXED_UNIT || abs (x3 - x0) > FIXED_UNIT ||
+          abs (y0 - y1) > FIXED_UNIT || abs (y1 - y2) > FIXED_UNIT ||
+          abs (y2 - y3) > FIXED_UNIT || abs (y3 - y0) > FIXED_UNIT);
+}
+
+static void
+reference_get_sample (const Reference *ref,
+                      gint xc, gint yc,
+                      gint x0, gint y0,
+                      gint x1, gint y1,
+                      gint x2, gint y2,
+                      gint x3, gint y3,
+                      gint            *cc,
+                      gint             level,
+                      guint           *color)
+{
+  if (! level ||
+      ! reference_supersample_test (x0, y0, x1, y1, x2, y2, x3, y3))
+    {
+      guchar C[BPP];
+      gint   i;
+
+      reference_sample_bi (ref, xc, yc, C);
+
+      for (i = 0; i < BPP; i++)
+        color[i] += C[i];
+
+      (*cc)++;
+    }
+  else
+    {
+      const gint tx  = (x0 + x1) / 2, ty  = (y0 + y1) / 2;
+      const gint tlx = (x0 + xc) / 2, tly = (y0 + yc) / 2;
+      const gint trx = (x1 + xc) / 2, try = (y1 + yc) / 2;
+      const gint lx  = (x0 + x3) / 2, ly  = (y0 + y3) / 2;
+      const gint rx  = (x1 + x2) / 2, ry  = (y1 + y2) / 2;
+      const gint blx = (x3 + xc) / 2, bly = (y3 + yc) / 2;
+      const gint brx = (x2 + xc) / 2, bry = (y2 + yc) / 2;
+      const gint bx  = (x3 + x2) / 2, by  = (y3 + y2) / 2;
+
+      reference_get_sample (ref, tlx, tly, x0, y0, tx, ty, xc, yc, lx, ly,
+                            cc, level - 1, color);
+      reference_get_sample (ref, trx, try, tx, ty, x1, y1, rx, ry, xc, yc,
+                            cc, level - 1, color);
+      reference_get_sample (ref, brx, bry, xc, yc, rx, ry, x2, y2, bx, by,
+                            cc, level - 1, color);
+      reference_get_sample (ref, blx, bly, lx, ly, xc, yc, bx, by, x3, y3,
+                            cc, level - 1, color);
+    }
+}
+
+static void
+reference_adapt (const Reference *ref,
+                 const gdouble   *u,
+                 const gdouble   *v,
+                 guchar          *color)
+{
+  guint C[BPP] = { 0, };
+  gint  cc     = 0;
+  gint  i;
+
+#define FIXED(i, c) ((gint) (((c)[i] - ((c) == u ? ref->u1 : ref->v1)) * \
+                             FIXED_UNIT))
+
+  reference_get_sample (ref,
+                        FIXED (0, u), FIXED (0, v),
+                        FIXED (1, u), FIXED (1, v),
+                        FIXED (2, u), FIXED (2, v),
+                        FIXED (3, u), FIXED (3, v),
+                        FIXED (4, u), FIXED (4, v),
+                        &cc, RECURSION_LEVEL, C);
+
+#undef FIXED
+
+  if (! cc)
+    cc = 1;
+
+  color[ALPHA] = C[ALPHA] / cc;
+
+  for (i = 0; i < ALPHA; i++)
+    {
+      if (color[ALPHA])
+        color[i] = ((C[i] / cc) * 255) / color[ALPHA];
+      else
+        color[i] = 0;
+    }
+}
+
+static gboolean
+reference_supersample_dtest (const gdouble *u,
+                             const gdouble *v)
+{
+  return (fabs (u[1] - u[2]) > G_SQRT2 || fabs (u[2] - u[3]) > G_SQRT2 ||
+          fabs (u[3] - u[4]) > G_SQRT2 || fabs (u[4] - u[1]) > G_SQRT2 ||
+          fabs (v[1] - v[2]) > G_SQRT2 || fabs (v[2] - v[3]) > G_SQRT2 ||
+          fabs (v[3] - v[4]) > G_SQRT2 || fabs (v[4] - v[1]) > G_SQRT2);
+}
+
+static void
+reference_transform (const Reference *ref,
+                     gint             dest_x1,
+                     gint             dest_y1,
+                     guchar          *dest)
+{
+  const GimpMatrix3 *m = ref->m;
+  gint               x0, y;
+
+  for (y = 0; y < DEST_HEIGHT; y++)
+    for (x0 = 0; x0 < DEST_WIDTH; x0 += TILE_WIDTH)
+      {
+        /*  the pixel, and the centers of the four around it  */
+        static const gint dx[5] = { 0, -1,  0, 1, 0 };
+        static const gint dy[5] = { 0,  0, -1, 0, 1 };
+        gdouble           tu[5], tv[5], tw[5];
+        gint              x, i;
+
+        for (i = 0; i < 5; i++)
+          {
+            const gdouble cx = dest_x1 + x0 + dx[i] + 0.5;
+            const gdouble cy = dest_y1 + y  + dy[i] + 0.5;
+
+            tu[i] = m->coeff[0][0] * cx + m->coeff[0][1] * cy + m->coeff[0][2];
+            tv[i] = m->coeff[1][0] * cx + m->coeff[1][1] * cy + m->coeff[1][2];
+            tw[i] = m->coeff[2][0] * cx + m->coeff[2][1] * cy + m->coeff[2][2];
+          }
+
+        for (x = x0; x < MIN (x0 + TILE_WIDTH, DEST_WIDTH); x++)
+          {
+            guchar  *d = dest + (y * DEST_WIDTH + x) * BPP;
+            gdouble  u[5], v[5];
+
+            for (i = 0; i < 5; i++)
+              {
+                u[i] = tu[i] / tw[i] - 0.5;
+                v[i] = tv[i] / tw[i] - 0.5;
+              }
+
+            if (ref->interpolation == GIMP_INTERPOLATION_NONE)
+              reference_nearest (ref, u[0], v[0], d);
+            else if (reference_supersample_dtest (u, v))
+              reference_adapt (ref, u, v, d);
+            else if (ref->interpolation == GIMP_INTERPOLATION_LINEAR)
+              reference_linear (ref, u[0] - ref->u1, v[0] - ref->v1, d);
+            else if (ref->interpolation == GIMP_INTERPOLATION_CUBIC)
+              reference_cubic (ref, u[0] - ref->u1, v[0] - ref->v1, d);
+            else
+              reference_lanczos (ref, u[0] - ref->u1, v[0] - ref->v1, d);
+
+            for (i = 0; i < 5; i++)
+              {
+                tu[i] += m->coeff[0][0];
+                tv[i] += m->coeff[1][0];
+                tw[i] += m->coeff[2][0];
+              }
+          }
+      }
+}
+
+/*  Opaque, transparent and random alpha in stripes, random colors  */
+static TileManager *
+create_source (guchar *pixels)
+{
+  TileManager *tiles = tile_manager_new (SRC_WIDTH, SRC_HEIGHT, BPP);
+  GRand       *rand  = g_rand_new_with_seed (SRC_WIDTH * SRC_HEIGHT);
+  gint         i;
+
+  for (i = 0; i < SRC_WIDTH * SRC_HEIGHT * BPP; i++)
+    pixels[i] = g_rand_int_range (rand, 0, 256);
+
+  for (i = 0; i < SRC_WIDTH * SRC_HEIGHT; i++)
+    {
+      switch ((i % SRC_WIDTH) / 16 % 3)
+        {
+        case 0: pixels[i * BPP + ALPHA] = 255; break;
+        case 1: pixels[i * BPP + ALPHA] = 0;   break;
+        }
+    }
+
+  tile_manager_write_pixel_data (tiles, 0, 0, SRC_WIDTH - 1, SRC_HEIGHT - 1,
+                                 pixels, SRC_WIDTH * BPP);
+
+  g_rand_free (rand);
+
+  return tiles;
+}
+
+/*  Cubic used to truncate the sum of every row of the footprint to an
+ *  integer.  That moved alpha by less than 1.25, the largest sum of the
+ *  magnitudes of the Catmull-Rom weights, and so the colors, which are
+ *  divided by it, by up to 1.25 * 256 / alpha.  Where alpha is about 1
+ *  nothing is left of the colors to compare.
+ */
+static gint
+cubic_tolerance (gint channel,
+                 gint alpha)
+{
+  if (channel == ALPHA)
+    return 2;
+
+  return 1 + (gint) ceil (1.25 * 256 / MAX (alpha - 1.25, 0.01));
+}
+
+static void
+compare_with_reference (Gimp              *gimp,
+                        const GimpMatrix3 *matrix,
+                        gint               dest_x1,
+                        gint               dest_y1)
+{
+  static const GimpInterpolationType interpolations[] =
+  {
+    GIMP_INTERPOLATION_NONE,
+    GIMP_INTERPOLATION_LINEAR,
+    GIMP_INTERPOLATION_CUBIC,
+    GIMP_INTERPOLATION_LANCZOS
+  };
+
+  GimpImage   *image;
+  GimpLayer   *layer;
+  GimpContext *context;
+  TileManager *src_tiles;
+  guchar      *src      = g_new (guchar, SRC_WIDTH * SRC_HEIGHT * BPP);
+  guchar      *expected = g_new (guchar, DEST_WIDTH * DEST_HEIGHT * BPP);
+  guchar      *result   = g_new (guchar, DEST_WIDTH * DEST_HEIGHT * BPP);
+  guchar       bg_color[MAX_CHANNELS];
+  GimpMatrix3  m        = *matrix;
+  Reference    ref;
+  gint         n;
+
+  image   = gimp_image_new (gimp, SRC_WIDTH, SRC_HEIGHT, GIMP_RGB);
+  layer   = gimp_layer_new (image, SRC_WIDTH, SRC_HEIGHT, GIMP_RGBA_IMAGE,
+                            "Test Layer", 1.0, GIMP_NORMAL_MODE);
+  context = gimp_context_new (gimp, "Test", NULL /*template*/);
+
+  gimp_image_add_layer (image, layer, GIMP_IMAGE_ACTIVE_PARENT, 0, FALSE);
+
+  gimp_image_get_background (image, context, GIMP_RGBA_IMAGE, bg_color);
+  bg_color[ALPHA] = TRANSPARENT_OPACITY;
+
+  src_tiles = create_source (src);
+
+  gimp_matrix3_invert (&m);
+
+  ref.src      = src;
+  ref.u1       = SRC_X;
+  ref.v1       = SRC_Y;
+  ref.u2       = SRC_X + SRC_WIDTH;
+  ref.v2       = SRC_Y + SRC_HEIGHT;
+  ref.m        = &m;
+  ref.bg_color = bg_color;
+  ref.lanczos  = create_lanczos_lookup ();
+
+  for (n = 0; n < G_N_ELEMENTS (interpolations); n++)
+    {
+      TileManager *dest_tiles = tile_manager_new (DEST_WIDTH, DEST_HEIGHT,
+                                                  BPP);
+      PixelRegion  destPR;
+      gint         i;
+
+      ref.interpolation = interpolations[n];
+
+      reference_transform (&ref, dest_x1, dest_y1, expected);
+
+      pixel_region_init (&destPR, dest_tiles,
+                         0, 0, DEST_WIDTH, DEST_HEIGHT, TRUE);
+
+      gimp_transform_region (GIMP_PICKABLE (layer), context,
+                             src_tiles, SRC_X, SRC_Y,
+                             &destPR,
+                             dest_x1, dest_y1,
+                             dest_x1 + DEST_WIDTH, dest_y1 + DEST_HEIGHT,
+                             matrix, interpolations[n],
+                             RECURSION_LEVEL, NULL);
+
+      tile_manager_read_pixel_data (dest_tiles,
+                                    0, 0, DEST_WIDTH - 1, DEST_HEIGHT - 1,
+                                    result, DEST_WIDTH * BPP);
+
+      for (i = 0; i < DEST_WIDTH * DEST_HEIGHT * BPP; i++)
+        {
+          const gint channel = i % BPP;
+          gint       tolerance = 0;
+
+          if (interpolations[n] == GIMP_INTERPOLATION_CUBIC)
+            tolerance = cubic_tolerance (channel,
+                                         result[i - channel + ALPHA]);
+
+          if (ABS (result[i] - expected[i]) > tolerance)
+            g_error ("interpolation %d, pixel %d,%d, channel %d: "
+                     "%d instead of %d",
+                     interpolations[n],
+                     i / BPP % DEST_WIDTH, i / BPP / DEST_WIDTH, channel,
+                     result[i], expected[i]);
+        }
+
+      tile_manager_unref (dest_tiles);
+    }
+
+  g_free ((gpointer) ref.lanczos);
+  tile_manager_unref (src_tiles);
+  g_free (result);
+  g_free (expected);
+  g_free (src);
+
+  g_object_unref (context);
+  g_object_unref (image);
+}
+
+/**
+ * affine:
+ *
+ * A rotation which enlarges: every pixel is interpolated.
+ **/
+static void
+affine (gconstpointer data)
+{
+  GimpMatrix3 matrix;
+
+  gimp_matrix3_identity (&matrix);
+  gimp_matrix3_translate (&matrix, - SRC_WIDTH / 2.0, - SRC_HEIGHT / 2.0);
+  gimp_matrix3_rotate (&matrix, 0.3);
+  gimp_matrix3_scale (&matrix, 1.4, 1.2);
+
+  compare_with_reference (GIMP (data), &matrix,
+                          - DEST_WIDTH / 2, - DEST_HEIGHT / 2);
+}
+
+/**
+ * affine_supersample:
+ *
+ * A rotation which shrinks: every pixel is supersampled.
+ **/
+static void
+affine_supersample (gconstpointer data)
+{
+  GimpMatrix3 matrix;
+
+  gimp_matrix3_identity (&matrix);
+  gimp_matrix3_rotate (&matrix, -0.7);
+  gimp_matrix3_scale (&matrix, 0.3, 0.4);
+
+  compare_with_reference (GIMP (data), &matrix, -30, -20);
+}
+
+/**
+ * perspective:
+ *
+ * A perspective which is close to the identity, and shrinks the far
+ * corner of the source enough to supersample it there.
+ **/
+static void
+perspective (gconstpointer data)
+{
+  GimpMatrix3 matrix;
+
+  gimp_matrix3_identity (&matrix);
+  gimp_matrix3_rotate (&matrix, 0.1);
+  matrix.coeff[2][0] = 0.0015;
+  matrix.coeff[2][1] = -0.001;
+
+  compare_with_reference (GIMP (data), &matrix, -10, 5);
+}
+
+/**
+ * perspective_supersample:
+ *
+ * A perspective which shrinks all of the source: every pixel is
+ * supersampled.
+ **/
+static void
+perspective_supersample (gconstpointer data)
+{
+  GimpMatrix3 matrix;
+
+  gimp_matrix3_identity (&matrix);
+  gimp_matrix3_scale (&matrix, 0.8, 0.8);
+  matrix.coeff[2][0] = 0.006;
+  matrix.coeff[2][1] = 0.004;
+
+  compare_with_reference (GIMP (data), &matrix, -5, 10);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_thread_init (NULL);
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  gimp = gimp_init_for_testing ();
+
+  ADD_TEST (affine);
+  ADD_TEST (affine_supersample);
+  ADD_TEST (perspective);
+  ADD_TEST (perspective_supersample);
+
+  result = g_test_run ();
+
+  gimp_test_utils_set_gimp2_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
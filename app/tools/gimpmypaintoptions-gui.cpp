@@ -387,6 +387,7 @@ MypaintOptionsGUIPrivate::create ()
   GtkWidget          *frame;
   GtkWidget          *table;
   GtkWidget          *menu;
+  GtkWidget          *combo;
   GtkWidget          *scale;
   GtkWidget          *label;
   GtkWidget          *button;
@@ -404,6 +405,16 @@ MypaintOptionsGUIPrivate::create ()
   gtk_box_pack_start (GTK_BOX (vbox), table, FALSE, FALSE, 0);
   gtk_widget_show (table);
 
+  /*  the precision of the blend modes  */
+  combo = gimp_prop_enum_combo_box_new (config, "precision", 0, 0);
+  g_object_set (combo, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+  gimp_table_attach_aligned (GTK_TABLE (table),
+                             gimp_tool_options_table_increment_get_col (&inc),
+                             gimp_tool_options_table_increment_get_row (&inc),
+                             _("Precision:"), 0.0, 0.5,
+                             combo, 2, FALSE);
+  gimp_tool_options_table_increment_next (&inc);
+
   /*  the opacity scale  */
   scale = gimp_prop_opacity_spin_scale_new (config, "opaque",
                                             _("Opacity"));
@@ -101,6 +101,8 @@ static void   gimp_mypaint_tool_oper_update    (GimpTool              *tool,
 
 static void   gimp_mypaint_tool_draw           (GimpDrawTool          *draw_tool);
 
+static void   gimp_mypaint_tool_flush          (gpointer               data);
+
 static void   gimp_mypaint_tool_hard_notify    (GimpMypaintOptions      *options,
                                               const GParamSpec      *pspec,
                                               GimpTool              *tool);
@@ -178,6 +180,10 @@ gimp_mypaint_tool_constructed (GObject *object)
 
   paint_tool->core = core = new GimpMypaintCore();
   g_object_set_cxx_object(object, "paint-core", core);
+
+#ifdef ENABLE_MP
+  core->set_render_thread(true, gimp_mypaint_tool_flush, tool);
+#endif
 /*
   g_signal_connect_object (options, "notify::hard",
                            G_CALLBACK (gimp_mypaint_tool_hard_notify),
@@ -337,6 +343,7 @@ gimp_mypaint_tool_button_release (GimpTool              *tool,
                                 GimpDisplay           *display)
 {
   GimpMypaintTool    *paint_tool    = GIMP_MYPAINT_TOOL (tool);
+  GimpMypaintCore    *core = reinterpret_cast<GimpMypaintCore*>(paint_tool->core);
   GimpDisplayShell *shell         = gimp_display_get_shell (display);
   GimpImage        *image         = gimp_display_get_image (display);
 
@@ -350,8 +357,20 @@ gimp_mypaint_tool_button_release (GimpTool              *tool,
 
   gimp_draw_tool_pause (GIMP_DRAW_TOOL (tool));
 
-  /*  Let the specific painting function finish up  */
-  gimp_mypaint_tool_motion_internal (tool, coords, time, state, display, coords->pressure > 0.0 || (state & GDK_BUTTON1_MASK));
+  if (release_type == GIMP_BUTTON_RELEASE_CANCEL)
+    {
+      gimp_mypaint_core_cancel (core, gimp_image_get_active_drawable (image));
+    }
+  else
+    {
+      /*  Let the specific painting function finish up  */
+      gimp_mypaint_tool_motion_internal (tool, coords, time, state, display, coords->pressure > 0.0 || (state & GDK_BUTTON1_MASK));
+    }
+
+  /*  the render thread may still be drawing, wait for it so that the
+   *  undo step of a finished stroke is there before the image is flushed
+   */
+  core->sync();
 
   /*  resume the current selection  */
   gimp_display_shell_selection_resume (shell);
@@ -485,9 +504,14 @@ gimp_mypaint_tool_motion_internal (GimpTool         *tool,
 
   core->stroke_to(drawable, dtime, &curr_coords, paint_options);
 
-  gimp_projection_finish_draw (gimp_image_get_projection (image)); 
-  gimp_projection_flush (gimp_image_get_projection (image));
-  gimp_display_flush_now (display);
+  /*  with a render thread, gimp_mypaint_tool_flush() is called when
+   *  the event is drawn
+   */
+  if (! core->has_render_thread()) {
+    gimp_projection_finish_draw (gimp_image_get_projection (image)); 
+    gimp_projection_flush (gimp_image_get_projection (image));
+    gimp_display_flush_now (display);
+  }
   paint_tool->last_flush_time = time;
 
   gimp_draw_tool_resume (GIMP_DRAW_TOOL (tool));
@@ -791,6 +815,29 @@ gimp_mypaint_tool_draw (GimpDrawTool *draw_tool)
   GIMP_DRAW_TOOL_CLASS (parent_class)->draw (draw_tool);
 }
 
+/*  called in the main thread when the render thread of the core has
+ *  drawn some events, with the render lock held
+ */
+static void
+gimp_mypaint_tool_flush (gpointer data)
+{
+  GimpTool  *tool = GIMP_TOOL (data);
+  GimpImage *image;
+
+  if (! tool->display)
+    return;
+
+  image = gimp_display_get_image (tool->display);
+
+  gimp_draw_tool_pause (GIMP_DRAW_TOOL (tool));
+
+  gimp_projection_finish_draw (gimp_image_get_projection (image));
+  gimp_projection_flush_now (gimp_image_get_projection (image));
+  gimp_display_flush_now (tool->display);
+
+  gimp_draw_tool_resume (GIMP_DRAW_TOOL (tool));
+}
+
 static void
 gimp_mypaint_tool_hard_notify (GimpMypaintOptions *options,
                              const GParamSpec *pspec,
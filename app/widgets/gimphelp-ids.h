@@ -436,6 +436,8 @@
 #define GIMP_HELP_ERRORS_SAVE                     "gimp-errors-save"
 #define GIMP_HELP_ERRORS_SELECT_ALL               "gimp-errors-select-all"
 
+#define GIMP_HELP_TILE_DASHBOARD_DIALOG           "gimp-tile-dashboard-dialog"
+
 #define GIMP_HELP_PREFS_DIALOG                    "gimp-prefs-dialog"
 #define GIMP_HELP_PREFS_NEW_IMAGE                 "gimp-prefs-new-image"
 #define GIMP_HELP_PREFS_DEFAULT_GRID              "gimp-prefs-default-grid"
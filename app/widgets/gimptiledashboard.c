@@ -0,0 +1,416 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimptiledashboard.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpwidgets/gimpwidgets.h"
+
+#include "widgets-types.h"
+
+#include "base/tile-cache.h"
+#include "base/tile-compress.h"
+#include "base/tile-pool.h"
+#include "base/tile-stats.h"
+
+#include "gimptiledashboard.h"
+
+#include "gimp-intl.h"
+
+
+#define UPDATE_INTERVAL 1  /*  seconds  */
+
+
+static void        gimp_tile_dashboard_map            (GtkWidget         *widget);
+static void        gimp_tile_dashboard_unmap          (GtkWidget         *widget);
+
+static void        gimp_tile_dashboard_record_toggled (GtkToggleButton   *button,
+                                                       GimpTileDashboard *dashboard);
+static void        gimp_tile_dashboard_reset_clicked  (GtkWidget         *widget,
+                                                       GimpTileDashboard *dashboard);
+static gboolean    gimp_tile_dashboard_update         (GimpTileDashboard *dashboard);
+
+static GtkWidget * gimp_tile_dashboard_add_label      (GtkTable          *table,
+                                                       gint               row,
+                                                       const gchar       *text);
+static void        gimp_tile_dashboard_set_count      (GtkWidget         *label,
+                                                       guint64            count,
+                                                       guint64            bytes);
+static void        gimp_tile_dashboard_set_latency    (GtkWidget         *label,
+                                                       const guint64     *histogram);
+
+
+G_DEFINE_TYPE (GimpTileDashboard, gimp_tile_dashboard, GIMP_TYPE_EDITOR)
+
+#define parent_class gimp_tile_dashboard_parent_class
+
+
+static void
+gimp_tile_dashboard_class_init (GimpTileDashboardClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  widget_class->map   = gimp_tile_dashboard_map;
+  widget_class->unmap = gimp_tile_dashboard_unmap;
+}
+
+static void
+gimp_tile_dashboard_init (GimpTileDashboard *dashboard)
+{
+  GtkWidget *vbox;
+  GtkWidget *frame;
+  GtkWidget *table;
+  gint       content_spacing;
+
+  gtk_widget_style_get (GTK_WIDGET (dashboard),
+                        "content-spacing", &content_spacing,
+                        NULL);
+
+  vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, content_spacing);
+  gtk_box_pack_start (GTK_BOX (dashboard), vbox, FALSE, FALSE, 0);
+  gtk_widget_show (vbox);
+
+  dashboard->record_button =
+    gtk_check_button_new_with_mnemonic (_("_Record tile statistics"));
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (dashboard->record_button),
+                                tile_stats_get_enabled ());
+  gtk_box_pack_start (GTK_BOX (vbox), dashboard->record_button,
+                      FALSE, FALSE, 0);
+  gtk_widget_show (dashboard->record_button);
+
+  g_signal_connect (dashboard->record_button, "toggled",
+                    G_CALLBACK (gimp_tile_dashboard_record_toggled),
+                    dashboard);
+
+
+  /* Memory */
+
+  frame = gimp_frame_new (_("Memory"));
+  gtk_box_pack_start (GTK_BOX (vbox), frame, FALSE, FALSE, 0);
+  gtk_widget_show (frame);
+
+  table = gtk_table_new (4, 2, FALSE);
+  gtk_table_set_col_spacings (GTK_TABLE (table), 6);
+  gtk_table_set_row_spacings (GTK_TABLE (table), 2);
+  gtk_container_add (GTK_CONTAINER (frame), table);
+  gtk_widget_show (table);
+
+  dashboard->cache_size_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 0, _("Tile cache:"));
+  dashboard->pool_size_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 1, _("Tile pool:"));
+  dashboard->compressed_size_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 2, _("Compressed:"));
+  dashboard->compressed_hits_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 3, _("Hit rate:"));
+
+
+  /* Tiles */
+
+  frame = gimp_frame_new (_("Tiles"));
+  gtk_box_pack_start (GTK_BOX (vbox), frame, FALSE, FALSE, 0);
+  gtk_widget_show (frame);
+
+  table = gtk_table_new (6, 2, FALSE);
+  gtk_table_set_col_spacings (GTK_TABLE (table), 6);
+  gtk_table_set_row_spacings (GTK_TABLE (table), 2);
+  gtk_container_add (GTK_CONTAINER (frame), table);
+  gtk_widget_show (table);
+
+  dashboard->locks_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 0, _("Locks:"));
+  dashboard->faults_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 1, _("Faults:"));
+  dashboard->cow_splits_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 2, _("Copied on write:"));
+  dashboard->uniform_skips_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 3, _("Uniform skipped:"));
+  dashboard->swap_ins_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 4, _("Swapped in:"));
+  dashboard->swap_outs_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 5, _("Swapped out:"));
+
+
+  /* Latency */
+
+  frame = gimp_frame_new (_("Swap Latency"));
+  gtk_box_pack_start (GTK_BOX (vbox), frame, FALSE, FALSE, 0);
+  gtk_widget_show (frame);
+
+  table = gtk_table_new (2, 2, FALSE);
+  gtk_table_set_col_spacings (GTK_TABLE (table), 6);
+  gtk_table_set_row_spacings (GTK_TABLE (table), 2);
+  gtk_container_add (GTK_CONTAINER (frame), table);
+  gtk_widget_show (table);
+
+  dashboard->swap_in_latency_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 0, _("In:"));
+  dashboard->swap_out_latency_label =
+    gimp_tile_dashboard_add_label (GTK_TABLE (table), 1, _("Out:"));
+
+
+  dashboard->reset_button =
+    gimp_editor_add_button (GIMP_EDITOR (dashboard),
+                            GTK_STOCK_CLEAR,
+                            _("Reset the tile statistics"),
+                            NULL,
+                            G_CALLBACK (gimp_tile_dashboard_reset_clicked),
+                            NULL,
+                            dashboard);
+
+  dashboard->timeout_id = 0;
+}
+
+static void
+gimp_tile_dashboard_map (GtkWidget *widget)
+{
+  GimpTileDashboard *dashboard = GIMP_TILE_DASHBOARD (widget);
+
+  GTK_WIDGET_CLASS (parent_class)->map (widget);
+
+  gimp_tile_dashboard_update (dashboard);
+
+  if (! dashboard->timeout_id)
+    dashboard->timeout_id =
+      g_timeout_add_seconds (UPDATE_INTERVAL,
+                             (GSourceFunc) gimp_tile_dashboard_update,
+                             dashboard);
+}
+
+static void
+gimp_tile_dashboard_unmap (GtkWidget *widget)
+{
+  GimpTileDashboard *dashboard = GIMP_TILE_DASHBOARD (widget);
+
+  if (dashboard->timeout_id)
+    {
+      g_source_remove (dashboard->timeout_id);
+      dashboard->timeout_id = 0;
+    }
+
+  GTK_WIDGET_CLASS (parent_class)->unmap (widget);
+}
+
+
+/*  public functions  */
+
+GtkWidget *
+gimp_tile_dashboard_new (void)
+{
+  return g_object_new (GIMP_TYPE_TILE_DASHBOARD, NULL);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_tile_dashboard_record_toggled (GtkToggleButton   *button,
+                                    GimpTileDashboard *dashboard)
+{
+  tile_stats_set_enabled (gtk_toggle_button_get_active (button));
+
+  gimp_tile_dashboard_update (dashboard);
+}
+
+static void
+gimp_tile_dashboard_reset_clicked (GtkWidget         *widget,
+                                   GimpTileDashboard *dashboard)
+{
+  tile_stats_reset ();
+
+  gimp_tile_dashboard_update (dashboard);
+}
+
+static gboolean
+gimp_tile_dashboard_update (GimpTileDashboard *dashboard)
+{
+  TileStats          stats;
+  TileCompressStats  compressed;
+  TilePoolStats      pool;
+  gchar             *size;
+  gchar             *raw_size;
+  gchar             *text;
+
+  /*  the statistics may have been switched on or off elsewhere,
+   *  e.g. through the REST interface
+   */
+  g_signal_handlers_block_by_func (dashboard->record_button,
+                                   gimp_tile_dashboard_record_toggled,
+                                   dashboard);
+  gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (dashboard->record_button),
+                                tile_stats_get_enabled ());
+  g_signal_handlers_unblock_by_func (dashboard->record_button,
+                                     gimp_tile_dashboard_record_toggled,
+                                     dashboard);
+
+  tile_stats_get_totals (&stats);
+  tile_compress_get_stats (&compressed);
+  tile_pool_get_stats (&pool);
+
+  size = gimp_memsize_to_string (tile_cache_get_cur_size ());
+  gtk_label_set_text (GTK_LABEL (dashboard->cache_size_label), size);
+  g_free (size);
+
+  size     = gimp_memsize_to_string (pool.used);
+  raw_size = gimp_memsize_to_string (pool.size);
+  /* Translators: "<memory in use> of <memory allocated>" */
+  text = g_strdup_printf (_("%s of %s"), size, raw_size);
+  gtk_label_set_text (GTK_LABEL (dashboard->pool_size_label), text);
+  g_free (text);
+  g_free (raw_size);
+  g_free (size);
+
+  size     = gimp_memsize_to_string (compressed.cur_size);
+  raw_size = gimp_memsize_to_string (compressed.raw_size);
+  /* Translators: "<compressed size> of <uncompressed size>" */
+  text = g_strdup_printf (_("%s of %s"), size, raw_size);
+  gtk_label_set_text (GTK_LABEL (dashboard->compressed_size_label), text);
+  g_free (text);
+  g_free (raw_size);
+  g_free (size);
+
+  if (compressed.hits + compressed.misses > 0)
+    {
+      text = g_strdup_printf ("%.1f%%",
+                              100.0 * compressed.hits /
+                              (compressed.hits + compressed.misses));
+      gtk_label_set_text (GTK_LABEL (dashboard->compressed_hits_label), text);
+      g_free (text);
+    }
+  else
+    {
+      gtk_label_set_text (GTK_LABEL (dashboard->compressed_hits_label),
+                          _("n/a"));
+    }
+
+  gimp_tile_dashboard_set_count (dashboard->locks_label,      stats.locks, 0);
+  gimp_tile_dashboard_set_count (dashboard->faults_label,     stats.faults, 0);
+  gimp_tile_dashboard_set_count (dashboard->cow_splits_label,
+                                 stats.cow_splits, 0);
+  gimp_tile_dashboard_set_count (dashboard->uniform_skips_label,
+                                 stats.uniform_skips, stats.bytes_skipped);
+  gimp_tile_dashboard_set_count (dashboard->swap_ins_label,
+                                 stats.swap_ins, stats.bytes_in);
+  gimp_tile_dashboard_set_count (dashboard->swap_outs_label,
+                                 stats.swap_outs, stats.bytes_out);
+
+  gimp_tile_dashboard_set_latency (dashboard->swap_in_latency_label,
+                                   stats.swap_in_latency);
+  gimp_tile_dashboard_set_latency (dashboard->swap_out_latency_label,
+                                   stats.swap_out_latency);
+
+  return TRUE;
+}
+
+static GtkWidget *
+gimp_tile_dashboard_add_label (GtkTable    *table,
+                               gint         row,
+                               const gchar *text)
+{
+  GtkWidget *label = gtk_label_new (_("n/a"));
+
+  gtk_misc_set_alignment (GTK_MISC (label), 1.0, 0.5);
+  gimp_table_attach_aligned (table, 0, row,
+                             text, 0.0, 0.5,
+                             label, 1, FALSE);
+
+  return label;
+}
+
+static void
+gimp_tile_dashboard_set_count (GtkWidget *label,
+                               guint64    count,
+                               guint64    bytes)
+{
+  gchar *text;
+
+  if (bytes > 0)
+    {
+      gchar *size = gimp_memsize_to_string (bytes);
+
+      text = g_strdup_printf ("%" G_GUINT64_FORMAT " (%s)", count, size);
+      g_free (size);
+    }
+  else
+    {
+      text = g_strdup_printf ("%" G_GUINT64_FORMAT, count);
+    }
+
+  gtk_label_set_text (GTK_LABEL (label), text);
+  g_free (text);
+}
+
+/*  Shows the buckets which contain the median and the 99th percentile
+ *  of @histogram.
+ */
+static void
+gimp_tile_dashboard_set_latency (GtkWidget     *label,
+                                 const guint64 *histogram)
+{
+  const gdouble  percentiles[] = { 0.5, 0.99 };
+  gchar         *limits[G_N_ELEMENTS (percentiles)];
+  gchar         *text;
+  guint64        total = 0;
+  gint           i;
+
+  for (i = 0; i < TILE_STATS_N_BUCKETS; i++)
+    total += histogram[i];
+
+  if (total == 0)
+    {
+      gtk_label_set_text (GTK_LABEL (label), _("n/a"));
+      return;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (percentiles); i++)
+    {
+      guint64 count = 0;
+      gint    bucket;
+      gint64  limit;
+
+      for (bucket = 0; bucket < TILE_STATS_N_BUCKETS - 1; bucket++)
+        {
+          count += histogram[bucket];
+
+          if (count >= percentiles[i] * total)
+            break;
+        }
+
+      limit = tile_stats_bucket_limit (bucket);
+
+      if (limit < 0)
+        limits[i] = g_strdup_printf (_("≥ %d ms"),
+                                     (gint) (tile_stats_bucket_limit (bucket - 1) / 1000));
+      else if (limit < 1000)
+        limits[i] = g_strdup_printf (_("< %d µs"), (gint) limit);
+      else
+        limits[i] = g_strdup_printf (_("< %d ms"), (gint) (limit / 1000));
+    }
+
+  /* Translators: latency percentiles, e.g. "50%: < 64 µs, 99%: < 4 ms" */
+  text = g_strdup_printf (_("50%%: %s, 99%%: %s"), limits[0], limits[1]);
+  gtk_label_set_text (GTK_LABEL (label), text);
+  g_free (text);
+
+  for (i = 0; i < G_N_ELEMENTS (percentiles); i++)
+    g_free (limits[i]);
+}
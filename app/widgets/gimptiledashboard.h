@@ -0,0 +1,73 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimptiledashboard.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_TILE_DASHBOARD_H__
+#define __GIMP_TILE_DASHBOARD_H__
+
+
+#include "gimpeditor.h"
+
+
+#define GIMP_TYPE_TILE_DASHBOARD            (gimp_tile_dashboard_get_type ())
+#define GIMP_TILE_DASHBOARD(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_TILE_DASHBOARD, GimpTileDashboard))
+#define GIMP_TILE_DASHBOARD_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GIMP_TYPE_TILE_DASHBOARD, GimpTileDashboardClass))
+#define GIMP_IS_TILE_DASHBOARD(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_TILE_DASHBOARD))
+#define GIMP_IS_TILE_DASHBOARD_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GIMP_TYPE_TILE_DASHBOARD))
+#define GIMP_TILE_DASHBOARD_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GIMP_TYPE_TILE_DASHBOARD, GimpTileDashboardClass))
+
+
+typedef struct _GimpTileDashboardClass GimpTileDashboardClass;
+
+struct _GimpTileDashboard
+{
+  GimpEditor  parent_instance;
+
+  guint       timeout_id;
+
+  GtkWidget  *record_button;
+  GtkWidget  *reset_button;
+
+  GtkWidget  *cache_size_label;
+  GtkWidget  *pool_size_label;
+  GtkWidget  *compressed_size_label;
+  GtkWidget  *compressed_hits_label;
+
+  GtkWidget  *locks_label;
+  GtkWidget  *faults_label;
+  GtkWidget  *cow_splits_label;
+  GtkWidget  *uniform_skips_label;
+  GtkWidget  *swap_ins_label;
+  GtkWidget  *swap_outs_label;
+
+  GtkWidget  *swap_in_latency_label;
+  GtkWidget  *swap_out_latency_label;
+};
+
+struct _GimpTileDashboardClass
+{
+  GimpEditorClass  parent_class;
+};
+
+
+GType       gimp_tile_dashboard_get_type (void) G_GNUC_CONST;
+
+GtkWidget * gimp_tile_dashboard_new      (void);
+
+
+#endif  /*  __GIMP_TILE_DASHBOARD_H__  */
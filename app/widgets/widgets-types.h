@@ -56,6 +56,7 @@ typedef struct _GimpColorEditor              GimpColorEditor;
 typedef struct _GimpDeviceStatus             GimpDeviceStatus;
 typedef struct _GimpEditor                   GimpEditor;
 typedef struct _GimpErrorConsole             GimpErrorConsole;
+typedef struct _GimpTileDashboard            GimpTileDashboard;
 typedef struct _GimpToolOptionsEditor        GimpToolOptionsEditor;
 
 /*  GimpDataEditor widgets  */
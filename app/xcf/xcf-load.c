@@ -30,6 +30,7 @@
 
 #include "base/tile.h"
 #include "base/tile-manager.h"
+#include "base/tile-manager-mapped.h"
 #include "base/tile-manager-private.h"
 
 #include "config/gimpcoreconfig.h"
@@ -199,6 +200,12 @@ xcf_load_image (Gimp     *gimp,
   if (! xcf_load_image_props (info, image))
     goto hard_error;
 
+  /* saving keeps uncompressed files uncompressed, so that their tiles
+   * are mapped again when they are loaded, see xcf_save_invoker()
+   */
+  GIMP_IMAGE_GET_PRIVATE (image)->xcf_uncompressed =
+    (info->compression == COMPRESS_NONE);
+
   /* check for a GimpGrid parasite */
   parasite = gimp_image_parasite_find (GIMP_IMAGE (image),
                                        gimp_grid_parasite_name ());
@@ -1875,6 +1882,29 @@ xcf_load_level (XcfInfo     *info,
           return FALSE;
         }
 
+      /* uncompressed tiles are used right from the mapped file,
+       *  their pages are only read when the tile is used
+       */
+      if (info->compression == COMPRESS_NONE && info->mapped)
+        {
+          if (! tile_manager_map_file (tiles, i, info->mapped, offset))
+            {
+              gimp_message (info->gimp, G_OBJECT (info->progress),
+                            GIMP_MESSAGE_ERROR,
+                            "tile data beyond the end of the file: %u",
+                            offset);
+              return FALSE;
+            }
+
+          previous = NULL;
+
+          if (! xcf_seek_pos (info, saved_pos, NULL))
+            return FALSE;
+
+          info->cp += xcf_read_int32 (info->fp, &offset, 1);
+          continue;
+        }
+
       /* get the tile from the tile manager */
       tile = tile_manager_get (tiles, i, TRUE, TRUE);
 
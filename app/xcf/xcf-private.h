@@ -213,6 +213,8 @@ typedef enum
 * @swap_num:              unused (TODO: use or remove)
 * @ref_count:             unused (TODO: use or remove)
 * @compression:           file compression (see @XcfCompressionType)
+* @mapped:                the XCF file mapped for loading uncompressed
+*                         tiles without reading them, or %NULL
 * @file_version:          file format version (see xcf_save_choose_format())
 *
 * XCF file information structure.
@@ -235,6 +237,7 @@ struct _XcfInfo
   gint                swap_num;
   gint               *ref_count;
   XcfCompressionType  compression;
+  GMappedFile        *mapped;
   gint                file_version;
 };
 
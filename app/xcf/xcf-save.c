@@ -31,6 +31,7 @@
 #include "base/tile.h"
 #include "base/tile-manager.h"
 #include "base/tile-manager-private.h"
+#include "base/tile-stats.h"
 
 #include "core/gimp.h"
 #include "core/gimpcontainer.h"
@@ -1751,6 +1752,26 @@ xcf_save_tile (XcfInfo  *info,
                GError  **error)
 {
   GError *tmp_error = NULL;
+  guchar  pixel[MAX_CHANNELS];
+
+  /*  uniform tiles are written from their pixel, without locking them  */
+  if (tile_is_uniform (tile, pixel))
+    {
+      guchar row[TILE_WIDTH * MAX_CHANNELS];
+      gint   bpp = tile_bpp (tile);
+      gint   x, y;
+
+      for (x = 0; x < tile_ewidth (tile); x++)
+        memcpy (row + x * bpp, pixel, bpp);
+
+      for (y = 0; y < tile_eheight (tile); y++)
+        xcf_write_int8_check_error (info, row, tile_ewidth (tile) * bpp);
+
+      if (G_UNLIKELY (tile_stats_active))
+        tile_stats_record_uniform_skip (tile);
+
+      return TRUE;
+    }
 
   tile_lock (tile);
   xcf_write_int8_check_error (info, tile_data_pointer (tile, 0, 0),
@@ -1770,6 +1791,39 @@ xcf_save_tile_rle (XcfInfo  *info,
   gint    len       = 0;
   gint    bpp;
   gint    i, j;
+  guchar  pixel[MAX_CHANNELS];
+
+  /*  a uniform tile is a single run per channel, which is what the
+   *  encoder below would produce for it, as a tile has less than
+   *  32768 pixels
+   */
+  if (tile_is_uniform (tile, pixel))
+    {
+      gint length = tile_ewidth (tile) * tile_eheight (tile);
+
+      for (i = 0; i < tile_bpp (tile); i++)
+        {
+          if (length >= 128)
+            {
+              rlebuf[len++] = 127;
+              rlebuf[len++] = (length >> 8);
+              rlebuf[len++] = length & 0x00FF;
+              rlebuf[len++] = pixel[i];
+            }
+          else
+            {
+              rlebuf[len++] = length - 1;
+              rlebuf[len++] = pixel[i];
+            }
+        }
+
+      xcf_write_int8_check_error (info, rlebuf, len);
+
+      if (G_UNLIKELY (tile_stats_active))
+        tile_stats_record_uniform_skip (tile);
+
+      return TRUE;
+    }
 
   tile_lock (tile);
 
@@ -21,6 +21,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <gegl.h>
 #include <glib/gstdio.h>
 
@@ -30,6 +37,7 @@
 
 #include "core/gimp.h"
 #include "core/gimpimage.h"
+#include "core/gimpimage-private.h"
 #include "core/gimpparamspecs.h"
 #include "core/gimpprogress.h"
 
@@ -70,6 +78,8 @@ static GValueArray * xcf_save_invoker (GimpProcedure      *procedure,
                                        GimpProgress       *progress,
                                        const GValueArray  *args,
                                        GError            **error);
+static FILE        * xcf_save_open    (const gchar        *filename,
+                                       gchar             **tmpname);
 
 
 static GimpXcfLoaderFunc * const xcf_loaders[] =
@@ -296,6 +306,16 @@ xcf_load_invoker (GimpProcedure      *procedure,
       info.ref_count             = NULL;
       info.compression           = COMPRESS_NONE;
 
+#ifndef G_OS_WIN32
+      /*  uncompressed tiles become views into the mapped file, see
+       *  xcf_load_level(); the tiles are read if it can't be mapped.
+       *  Not on Windows, where a mapped file can't be replaced.
+       */
+      info.mapped = g_mapped_file_new (filename, FALSE, NULL);
+#else
+      info.mapped = NULL;
+#endif
+
       if (progress)
         {
           gchar *name = g_filename_display_name (filename);
@@ -349,6 +369,9 @@ xcf_load_invoker (GimpProcedure      *procedure,
 
       fclose (info.fp);
 
+      if (info.mapped)
+        g_mapped_file_unref (info.mapped);
+
       if (progress)
         gimp_progress_end (progress);
     }
@@ -384,6 +407,7 @@ xcf_save_invoker (GimpProcedure      *procedure,
   GValueArray *return_vals;
   GimpImage   *image;
   const gchar *filename;
+  gchar       *tmpname;
   gboolean     success = FALSE;
 
   gimp_set_busy (gimp);
@@ -391,7 +415,7 @@ xcf_save_invoker (GimpProcedure      *procedure,
   image    = gimp_value_get_image (&args->values[1], gimp);
   filename = g_value_get_string (&args->values[3]);
 
-  info.fp = g_fopen (filename, "wb");
+  info.fp = xcf_save_open (filename, &tmpname);
 
   if (info.fp)
     {
@@ -406,7 +430,12 @@ xcf_save_invoker (GimpProcedure      *procedure,
       info.floating_sel_offset   = 0;
       info.swap_num              = 0;
       info.ref_count             = NULL;
-      info.compression           = COMPRESS_RLE;
+      info.mapped                = NULL;
+
+      if (GIMP_IMAGE_GET_PRIVATE (image)->xcf_uncompressed)
+        info.compression = COMPRESS_NONE;
+      else
+        info.compression = COMPRESS_RLE;
 
       if (progress)
         {
@@ -442,6 +471,26 @@ xcf_save_invoker (GimpProcedure      *procedure,
           fclose (info.fp);
         }
 
+      if (tmpname)
+        {
+          if (success && g_rename (tmpname, filename) == -1)
+            {
+              int save_errno = errno;
+
+              g_set_error (error, G_FILE_ERROR,
+                           g_file_error_from_errno (save_errno),
+                           _("Error saving XCF file: %s"),
+                           g_strerror (save_errno));
+
+              success = FALSE;
+            }
+
+          if (! success)
+            g_unlink (tmpname);
+
+          g_free (tmpname);
+        }
+
       if (progress)
         gimp_progress_end (progress);
     }
@@ -461,3 +510,52 @@ xcf_save_invoker (GimpProcedure      *procedure,
 
   return return_vals;
 }
+
+/*  The tiles of an image loaded from an uncompressed XCF file are views
+ *  into the file, which must not be truncated while they are around.
+ *  So an existing file is replaced by writing a new file next to it and
+ *  renaming it over the old one, see xcf_save_invoker().  Falls back to
+ *  writing the file in place, for links, special files, or if no file
+ *  can be created in its directory.
+ */
+static FILE *
+xcf_save_open (const gchar  *filename,
+               gchar       **tmpname)
+{
+#ifndef G_OS_WIN32
+  struct stat st;
+
+  if (g_lstat (filename, &st) == 0 &&
+      S_ISREG (st.st_mode)         &&
+      st.st_nlink == 1)
+    {
+      gchar *name = g_strconcat (filename, ".XXXXXX", NULL);
+      gint   fd   = g_mkstemp (name);
+
+      if (fd != -1)
+        {
+          FILE *fp;
+
+          fchmod (fd, st.st_mode & 07777);
+
+          fp = fdopen (fd, "wb");
+
+          if (fp)
+            {
+              *tmpname = name;
+
+              return fp;
+            }
+
+          close (fd);
+          g_unlink (name);
+        }
+
+      g_free (name);
+    }
+#endif
+
+  *tmpname = NULL;
+
+  return g_fopen (filename, "wb");
+}
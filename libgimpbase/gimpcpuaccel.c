@@ -123,7 +123,15 @@ enum
 
 enum
 {
-  ARCH_X86_INTEL_FEATURE_PNI      = 1 << 0
+  ARCH_X86_INTEL_FEATURE_PNI      = 1 << 0,
+  ARCH_X86_INTEL_FEATURE_OSXSAVE  = 1 << 27,
+  ARCH_X86_INTEL_FEATURE_AVX      = 1 << 28
+};
+
+/*  cpuid leaf 7, ebx  */
+enum
+{
+  ARCH_X86_INTEL_FEATURE_AVX2     = 1 << 5
 };
 
 #if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
@@ -146,6 +154,29 @@ enum
            : "0" (op))
 #endif
 
+/*  cpuid with a sub-leaf, for leaf 7  */
+#if !defined(ARCH_X86_64) && (defined(PIC) || defined(__PIC__))
+#define cpuid_count(op,count,eax,ebx,ecx,edx)  \
+  __asm__ ("movl %%ebx, %%esi\n\t"             \
+           "cpuid\n\t"                         \
+           "xchgl %%ebx,%%esi"                 \
+           : "=a" (eax),                       \
+             "=S" (ebx),                       \
+             "=c" (ecx),                       \
+             "=d" (edx)                        \
+           : "0" (op),                         \
+             "2" (count))
+#else
+#define cpuid_count(op,count,eax,ebx,ecx,edx)  \
+  __asm__ ("cpuid"                             \
+           : "=a" (eax),                       \
+             "=b" (ebx),                       \
+             "=c" (ecx),                       \
+             "=d" (edx)                        \
+           : "0" (op),                         \
+             "2" (count))
+#endif
+
 
 static X86Vendor
 arch_get_vendor (void)
@@ -245,6 +276,31 @@ arch_accel_intel (void)
 
     if (ecx & ARCH_X86_INTEL_FEATURE_PNI)
       caps |= GIMP_CPU_ACCEL_X86_SSE3;
+
+    /*  AVX2 also needs the OS to save the upper halves of the ymm
+     *  registers, which it says in XCR0
+     */
+    if ((ecx & ARCH_X86_INTEL_FEATURE_OSXSAVE) &&
+        (ecx & ARCH_X86_INTEL_FEATURE_AVX))
+      {
+        guint32 max_leaf;
+        guint32 xcr0;
+
+        cpuid (0, max_leaf, ebx, ecx, edx);
+
+        /*  xgetbv, spelled out for old assemblers  */
+        __asm__ (".byte 0x0f, 0x01, 0xd0"
+                 : "=a" (xcr0), "=d" (edx)
+                 : "c" (0));
+
+        if (max_leaf >= 7 && (xcr0 & 0x6) == 0x6)
+          {
+            cpuid_count (7, 0, eax, ebx, ecx, edx);
+
+            if (ebx & ARCH_X86_INTEL_FEATURE_AVX2)
+              caps |= GIMP_CPU_ACCEL_X86_AVX2;
+          }
+      }
 #endif /* USE_SSE */
   }
 #endif /* USE_MMX */
@@ -410,7 +466,9 @@ arch_accel (void)
 
 #ifdef USE_SSE
   if ((caps & GIMP_CPU_ACCEL_X86_SSE) && !arch_accel_sse_os_support ())
-    caps &= ~(GIMP_CPU_ACCEL_X86_SSE | GIMP_CPU_ACCEL_X86_SSE2);
+    caps &= ~(GIMP_CPU_ACCEL_X86_SSE  |
+              GIMP_CPU_ACCEL_X86_SSE2 |
+              GIMP_CPU_ACCEL_X86_AVX2);
 #endif
 
   return caps;